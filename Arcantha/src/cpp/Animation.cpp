@@ -0,0 +1,431 @@
+#include "Animation.h" // Includes the AnimationSystem class definition.
+
+#include <algorithm> // Required for std::sort, std::min and std::max.
+#include <chrono> // Required for timing updates.
+#include <cmath> // Required for std::cos, std::sin, std::fmod, std::ceil and std::round.
+
+#include "JobSystem.h" // Includes the JobSystem characters are evaluated on.
+#include "Simd.h" // Includes the SSE capability switch for skinning.
+#include "Log.h" // Includes the Logger for error output.
+
+const int AnimationSystem::PARAMETERS;
+const float AnimationSystem::SAMPLE_RATE = 30.0f;
+const size_t AnimationSystem::BATCH_SIZE;
+
+static const float PI = 3.14159265f;
+
+/**
+ * @brief Gets the milliseconds elapsed since a time point.
+ * @param since The start.
+ * @return Elapsed milliseconds.
+ */
+static double elapsedMs( std::chrono::steady_clock::time_point since ) {
+	return std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - since ).count();
+}
+
+/**
+ * @brief Builds the transform of a pose.
+ * @param pose The pose.
+ * @return Columns: the rotated and scaled X axis, Y axis and the translation.
+ */
+static glm::mat3x2 toTransform( const BonePose& pose ) {
+	const float c = std::cos( pose.rotation ) * pose.scale, s = std::sin( pose.rotation ) * pose.scale;
+	return glm::mat3x2( glm::vec2( c, s ), glm::vec2( -s, c ), glm::vec2( pose.x, pose.y ) );
+}
+
+/**
+ * @brief Composes two affine transforms.
+ * @param a The outer transform.
+ * @param b The inner transform.
+ * @return a applied after b.
+ */
+static glm::mat3x2 compose( const glm::mat3x2& a, const glm::mat3x2& b ) {
+	return glm::mat3x2( a[ 0 ] * b[ 0 ].x + a[ 1 ] * b[ 0 ].y, a[ 0 ] * b[ 1 ].x + a[ 1 ] * b[ 1 ].y, a[ 0 ] * b[ 2 ].x + a[ 1 ] * b[ 2 ].y + a[ 2 ] );
+}
+
+/**
+ * @brief Inverts an affine transform.
+ * @param m The transform; must not be singular.
+ * @return The inverse.
+ */
+static glm::mat3x2 invert( const glm::mat3x2& m ) {
+	const float inverseDet = 1.0f / ( m[ 0 ].x * m[ 1 ].y - m[ 1 ].x * m[ 0 ].y );
+	const glm::vec2 x = glm::vec2( m[ 1 ].y, -m[ 0 ].y ) * inverseDet;
+	const glm::vec2 y = glm::vec2( -m[ 1 ].x, m[ 0 ].x ) * inverseDet;
+	return glm::mat3x2( x, y, -( x * m[ 2 ].x + y * m[ 2 ].y ) );
+}
+
+/**
+ * @brief Gets a pose channel.
+ * @param pose The pose.
+ * @param channel The channel.
+ * @return A reference to it.
+ */
+static float& channelOf( BonePose& pose, AnimChannel channel ) {
+	switch ( channel ) {
+	case AnimChannel::X: return pose.x;
+	case AnimChannel::Y: return pose.y;
+	case AnimChannel::Rotation: return pose.rotation;
+	default: return pose.scale;
+	}
+}
+
+int AnimationSystem::addSkeleton( const std::vector<int16_t>& parents, const std::vector<BonePose>& bind ) {
+	if ( parents.empty() || parents.size() != bind.size() || parents.size() > 256 ) {
+		LOG_ERROR( "A skeleton needs 1 to 256 bones with a bind pose each." );
+		return -1;
+	}
+	Skeleton skeleton;
+	skeleton.parents = parents;
+	skeleton.bind = bind;
+	std::vector<glm::mat3x2> world( parents.size() );
+	for ( size_t bone = 0; bone < parents.size(); bone++ ) {
+		if ( parents[ bone ] >= static_cast< int16_t >( bone ) ) {
+			LOG_ERROR( "Bone {} comes before its parent.", bone );
+			return -1;
+		}
+		const glm::mat3x2 local = toTransform( bind[ bone ] );
+		world[ bone ] = parents[ bone ] < 0 ? local : compose( world[ parents[ bone ] ], local );
+		skeleton.inverseBind.push_back( invert( world[ bone ] ) );
+	}
+	skeletons.push_back( std::move( skeleton ) );
+	return static_cast< int >( skeletons.size() - 1 );
+}
+
+int AnimationSystem::addClip( int skeleton, const AnimClipDesc& desc ) {
+	const Skeleton& target = skeletons[ skeleton ];
+	for ( const AnimKey& key : desc.keys ) {
+		if ( key.bone >= target.parents.size() ) {
+			LOG_ERROR( "Clip {} animates missing bone {}.", desc.name, key.bone );
+			return -1;
+		}
+	}
+
+	Clip clip;
+	clip.name = desc.name;
+	clip.skeleton = skeleton;
+	clip.duration = std::max( desc.duration, 1.0f / SAMPLE_RATE );
+	clip.loop = desc.loop;
+	clip.frames = static_cast< uint32_t >( std::ceil( clip.duration * SAMPLE_RATE ) ) + 1;
+	clip.flipbook = desc.flipbook;
+
+	std::vector<AnimKey> keys = desc.keys;
+	std::sort( keys.begin(), keys.end(), []( const AnimKey& a, const AnimKey& b ) {
+		if ( a.bone != b.bone ) return a.bone < b.bone;
+		if ( a.channel != b.channel ) return a.channel < b.channel;
+		return a.time < b.time;
+	} );
+
+	// Each channel is resampled at SAMPLE_RATE with linear interpolation between its keys, then quantized over its range.
+	std::vector<float> values( clip.frames );
+	for ( size_t first = 0; first < keys.size(); ) {
+		size_t last = first;
+		while ( last < keys.size() && keys[ last ].bone == keys[ first ].bone && keys[ last ].channel == keys[ first ].channel ) last++;
+
+		size_t key = first;
+		float low = 1e30f, high = -1e30f;
+		for ( uint32_t f = 0; f < clip.frames; f++ ) {
+			const float time = clip.duration * f / ( clip.frames - 1 );
+			while ( key + 1 < last && keys[ key + 1 ].time <= time ) key++;
+			float value = keys[ key ].value;
+			if ( key + 1 < last && time > keys[ key ].time ) {
+				const float span = keys[ key + 1 ].time - keys[ key ].time;
+				value += ( keys[ key + 1 ].value - value ) * ( span > 0.0f ? ( time - keys[ key ].time ) / span : 0.0f );
+			}
+			values[ f ] = value;
+			low = std::min( low, value );
+			high = std::max( high, value );
+		}
+
+		BonePose bind = target.bind[ keys[ first ].bone ];
+		const bool atBind = high - low < 1e-6f && std::abs( low - channelOf( bind, keys[ first ].channel ) ) < 1e-6f;
+		if ( !atBind ) {
+			Track track;
+			track.bone = keys[ first ].bone;
+			track.channel = keys[ first ].channel;
+			track.base = low;
+			track.step = ( high - low ) / 65535.0f;
+			track.first = static_cast< uint32_t >( clip.samples.size() );
+			for ( float value : values ) {
+				clip.samples.push_back( static_cast< uint16_t >( track.step > 0.0f ? std::round( ( value - low ) / track.step ) : 0.0f ) );
+			}
+			clip.tracks.push_back( track );
+		}
+		first = last;
+	}
+
+	clips.push_back( std::move( clip ) );
+	return static_cast< int >( clips.size() - 1 );
+}
+
+int AnimationSystem::addMesh( int skeleton, const std::vector<AnimVertex>& vertices ) {
+	const size_t bones = skeletons[ skeleton ].parents.size();
+	Mesh mesh;
+	mesh.skeleton = skeleton;
+	mesh.count = static_cast< uint32_t >( vertices.size() );
+	const size_t padded = ( vertices.size() + 3 ) / 4 * 4;
+	mesh.x.assign( padded, 0.0f );
+	mesh.y.assign( padded, 0.0f );
+	mesh.weight.assign( padded, 1.0f );
+	mesh.bone0.assign( padded, 0 );
+	mesh.bone1.assign( padded, 0 );
+	for ( size_t i = 0; i < vertices.size(); i++ ) {
+		const AnimVertex& vertex = vertices[ i ];
+		if ( vertex.bone0 >= bones || vertex.bone1 >= bones ) {
+			LOG_ERROR( "Mesh vertex {} is bound to a missing bone.", i );
+			return -1;
+		}
+		mesh.x[ i ] = vertex.x;
+		mesh.y[ i ] = vertex.y;
+		mesh.weight[ i ] = vertex.weight;
+		mesh.bone0[ i ] = vertex.bone0;
+		mesh.bone1[ i ] = vertex.bone1;
+	}
+	// Padding repeats the last vertex's bones, so a partly filled run still takes the shared-bone path.
+	for ( size_t i = vertices.size(); i < padded && i > 0; i++ ) {
+		mesh.bone0[ i ] = mesh.bone0[ i - 1 ];
+		mesh.bone1[ i ] = mesh.bone1[ i - 1 ];
+	}
+	meshes.push_back( std::move( mesh ) );
+	return static_cast< int >( meshes.size() - 1 );
+}
+
+int AnimationSystem::addStateMachine( const std::vector<AnimStateDesc>& states, const std::vector<AnimTransitionDesc>& transitions ) {
+	if ( states.empty() ) {
+		LOG_ERROR( "A state machine needs at least one state." );
+		return -1;
+	}
+	StateMachine machine;
+	machine.skeleton = -1;
+	for ( const AnimStateDesc& state : states ) {
+		if ( state.clip >= clips.size() || ( machine.skeleton >= 0 && clips[ state.clip ].skeleton != machine.skeleton ) ) {
+			LOG_ERROR( "A state plays a missing clip or one of another skeleton." );
+			return -1;
+		}
+		machine.skeleton = clips[ state.clip ].skeleton;
+	}
+	for ( const AnimTransitionDesc& transition : transitions ) {
+		if ( transition.from >= states.size() || transition.to >= states.size() || transition.parameter >= PARAMETERS ) {
+			LOG_ERROR( "A transition names a missing state or parameter." );
+			return -1;
+		}
+	}
+	machine.states = states;
+	machine.transitions = transitions;
+	std::stable_sort( machine.transitions.begin(), machine.transitions.end(),
+		[]( const AnimTransitionDesc& a, const AnimTransitionDesc& b ) { return a.from < b.from; } );
+	machine.firstTransition.assign( states.size() + 1, 0 );
+	for ( const AnimTransitionDesc& transition : machine.transitions ) machine.firstTransition[ transition.from + 1 ]++;
+	for ( size_t state = 0; state < states.size(); state++ ) machine.firstTransition[ state + 1 ] += machine.firstTransition[ state ];
+
+	machines.push_back( std::move( machine ) );
+	return static_cast< int >( machines.size() - 1 );
+}
+
+uint32_t AnimationSystem::addCharacter( int machine, int mesh, glm::vec2 position ) {
+	Character character;
+	character.position = position;
+	character.phase = static_cast< uint8_t >( characters.size() & 15 );
+	characters.push_back( std::move( character ) );
+	setMachine( static_cast< uint32_t >( characters.size() - 1 ), machine, mesh );
+	return static_cast< uint32_t >( characters.size() - 1 );
+}
+
+void AnimationSystem::setMachine( uint32_t index, int machine, int mesh ) {
+	Character& character = characters[ index ];
+	character.machine = machine;
+	character.mesh = mesh;
+	character.state = character.fromState = 0;
+	character.time = character.fromTime = 0.0f;
+	character.blend = 1.0f;
+	character.blendDuration = 0.0f;
+	character.bones.assign( skeletons[ machines[ machine ].skeleton ].parents.size(), glm::mat3x2( 1.0f ) );
+	character.skinned.assign( mesh >= 0 ? meshes[ mesh ].x.size() : 0, glm::vec2( 0.0f ) );
+	std::vector<BonePose> scratch;
+	evaluatePose( character, scratch );
+}
+
+bool AnimationSystem::advance( Character& character, float dt ) const {
+	const StateMachine& machine = machines[ character.machine ];
+	auto step = [ this, &machine ]( uint16_t state, float& time, float dt ) {
+		const Clip& clip = clips[ machine.states[ state ].clip ];
+		time += dt * machine.states[ state ].speed;
+		if ( clip.loop ) time = std::fmod( time, clip.duration );
+		else if ( time >= clip.duration ) {
+			time = clip.duration;
+			return true;
+		}
+		return false;
+	};
+
+	const bool finished = step( character.state, character.time, dt );
+	if ( character.blend < 1.0f ) {
+		step( character.fromState, character.fromTime, dt );
+		character.blend = std::min( character.blend + dt / character.blendDuration, 1.0f );
+	}
+
+	bool changed = false;
+	for ( uint32_t t = machine.firstTransition[ character.state ]; t < machine.firstTransition[ character.state + 1 ]; t++ ) {
+		const AnimTransitionDesc& transition = machine.transitions[ t ];
+		const float value = character.parameters[ transition.parameter ];
+		const bool taken = transition.condition == AnimCondition::Finished ? finished :
+			transition.condition == AnimCondition::Greater ? value > transition.threshold : value < transition.threshold;
+		if ( !taken ) continue;
+		character.fromState = character.state;
+		character.fromTime = character.time;
+		character.state = transition.to;
+		character.time = 0.0f;
+		character.blendDuration = transition.blend;
+		character.blend = transition.blend > 0.0f ? 0.0f : 1.0f;
+		changed = true;
+		break;
+	}
+
+	const Clip& clip = clips[ machine.states[ character.state ].clip ];
+	if ( !clip.flipbook.empty() ) {
+		const size_t frame = static_cast< size_t >( character.time / clip.duration * clip.flipbook.size() );
+		character.spriteFrame = clip.flipbook[ std::min( frame, clip.flipbook.size() - 1 ) ];
+	}
+	else character.spriteFrame = 0;
+	return changed;
+}
+
+void AnimationSystem::sample( const Clip& clip, float time, BonePose* pose ) const {
+	const float position = std::min( std::max( time / clip.duration, 0.0f ), 1.0f ) * ( clip.frames - 1 );
+	const uint32_t frame0 = std::min( static_cast< uint32_t >( position ), clip.frames - 1 );
+	const uint32_t frame1 = std::min( frame0 + 1, clip.frames - 1 );
+	const float alpha = position - static_cast< float >( frame0 );
+	const uint16_t* samples = clip.samples.data();
+	for ( const Track& track : clip.tracks ) {
+		const float a = samples[ track.first + frame0 ], b = samples[ track.first + frame1 ];
+		channelOf( pose[ track.bone ], track.channel ) = track.base + track.step * ( a + ( b - a ) * alpha );
+	}
+}
+
+void AnimationSystem::evaluatePose( Character& character, std::vector<BonePose>& scratch ) const {
+	const StateMachine& machine = machines[ character.machine ];
+	const Skeleton& skeleton = skeletons[ machine.skeleton ];
+	const size_t bones = skeleton.parents.size();
+	scratch.assign( skeleton.bind.begin(), skeleton.bind.end() );
+	sample( clips[ machine.states[ character.state ].clip ], character.time, scratch.data() );
+
+	if ( character.blend < 1.0f ) {
+		// Crossfade from the previous state's pose; rotations take the short way around.
+		scratch.insert( scratch.end(), skeleton.bind.begin(), skeleton.bind.end() );
+		BonePose* current = scratch.data();
+		BonePose* from = scratch.data() + bones;
+		sample( clips[ machine.states[ character.fromState ].clip ], character.fromTime, from );
+		const float w = character.blend;
+		for ( size_t bone = 0; bone < bones; bone++ ) {
+			BonePose& to = current[ bone ];
+			const BonePose& old = from[ bone ];
+			float turn = std::fmod( to.rotation - old.rotation + PI, 2.0f * PI );
+			if ( turn < 0.0f ) turn += 2.0f * PI;
+			to.rotation = old.rotation + ( turn - PI ) * w;
+			to.x = old.x + ( to.x - old.x ) * w;
+			to.y = old.y + ( to.y - old.y ) * w;
+			to.scale = old.scale + ( to.scale - old.scale ) * w;
+		}
+	}
+
+	for ( size_t bone = 0; bone < bones; bone++ ) {
+		const glm::mat3x2 local = toTransform( scratch[ bone ] );
+		const int16_t parent = skeleton.parents[ bone ];
+		character.bones[ bone ] = parent < 0 ? local : compose( character.bones[ parent ], local );
+	}
+}
+
+void AnimationSystem::skin( Character& character, std::vector<glm::mat3x2>& palette ) const {
+	const Mesh& mesh = meshes[ character.mesh ];
+	const Skeleton& skeleton = skeletons[ mesh.skeleton ];
+	palette.resize( character.bones.size() );
+	for ( size_t bone = 0; bone < character.bones.size(); bone++ ) palette[ bone ] = compose( character.bones[ bone ], skeleton.inverseBind[ bone ] );
+
+	const float* m = &palette[ 0 ][ 0 ][ 0 ]; // Six floats per bone: X axis, Y axis, translation.
+	float* out = &character.skinned[ 0 ][ 0 ];
+	const uint32_t count = static_cast< uint32_t >( mesh.x.size() );
+#if ARCANTHA_SIMD_SSE
+	for ( uint32_t i = 0; i < count; i += 4 ) {
+		const uint8_t* b0 = mesh.bone0.data() + i;
+		const uint8_t* b1 = mesh.bone1.data() + i;
+		__m128 first[ 6 ], second[ 6 ];
+		if ( b0[ 0 ] == b0[ 1 ] && b0[ 0 ] == b0[ 2 ] && b0[ 0 ] == b0[ 3 ] && b1[ 0 ] == b1[ 1 ] && b1[ 0 ] == b1[ 2 ] && b1[ 0 ] == b1[ 3 ] ) {
+			for ( int e = 0; e < 6; e++ ) {
+				first[ e ] = _mm_set1_ps( m[ b0[ 0 ] * 6 + e ] );
+				second[ e ] = _mm_set1_ps( m[ b1[ 0 ] * 6 + e ] );
+			}
+		}
+		else {
+			for ( int e = 0; e < 6; e++ ) {
+				first[ e ] = _mm_set_ps( m[ b0[ 3 ] * 6 + e ], m[ b0[ 2 ] * 6 + e ], m[ b0[ 1 ] * 6 + e ], m[ b0[ 0 ] * 6 + e ] );
+				second[ e ] = _mm_set_ps( m[ b1[ 3 ] * 6 + e ], m[ b1[ 2 ] * 6 + e ], m[ b1[ 1 ] * 6 + e ], m[ b1[ 0 ] * 6 + e ] );
+			}
+		}
+		const __m128 x = _mm_loadu_ps( mesh.x.data() + i ), y = _mm_loadu_ps( mesh.y.data() + i );
+		const __m128 w = _mm_loadu_ps( mesh.weight.data() + i ), rest = _mm_sub_ps( _mm_set1_ps( 1.0f ), w );
+		const __m128 x0 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( first[ 0 ], x ), _mm_mul_ps( first[ 2 ], y ) ), first[ 4 ] );
+		const __m128 y0 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( first[ 1 ], x ), _mm_mul_ps( first[ 3 ], y ) ), first[ 5 ] );
+		const __m128 x1 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( second[ 0 ], x ), _mm_mul_ps( second[ 2 ], y ) ), second[ 4 ] );
+		const __m128 y1 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( second[ 1 ], x ), _mm_mul_ps( second[ 3 ], y ) ), second[ 5 ] );
+		const __m128 px = _mm_add_ps( _mm_mul_ps( x0, w ), _mm_mul_ps( x1, rest ) );
+		const __m128 py = _mm_add_ps( _mm_mul_ps( y0, w ), _mm_mul_ps( y1, rest ) );
+		_mm_storeu_ps( out + 2 * i, _mm_unpacklo_ps( px, py ) );
+		_mm_storeu_ps( out + 2 * i + 4, _mm_unpackhi_ps( px, py ) );
+	}
+#else
+	for ( uint32_t i = 0; i < count; i++ ) {
+		const float* first = m + mesh.bone0[ i ] * 6;
+		const float* second = m + mesh.bone1[ i ] * 6;
+		const float x = mesh.x[ i ], y = mesh.y[ i ], w = mesh.weight[ i ], rest = 1.0f - w;
+		out[ 2 * i ] = ( first[ 0 ] * x + first[ 2 ] * y + first[ 4 ] ) * w + ( second[ 0 ] * x + second[ 2 ] * y + second[ 4 ] ) * rest;
+		out[ 2 * i + 1 ] = ( first[ 1 ] * x + first[ 3 ] * y + first[ 5 ] ) * w + ( second[ 1 ] * x + second[ 3 ] * y + second[ 5 ] ) * rest;
+	}
+#endif
+}
+
+void AnimationSystem::update( float dt, glm::vec2 focus ) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	stats = AnimStats();
+	stats.characters = getCharacterCount();
+	for ( const Clip& clip : clips ) stats.trackBytes += static_cast< uint32_t >( clip.samples.size() * sizeof( uint16_t ) );
+
+	// LOD is chosen serially, as AiSystem does; everything else runs in the batches.
+	const float nearSq = lodSettings.nearRadius * lodSettings.nearRadius;
+	const float farSq = lodSettings.farRadius * lodSettings.farRadius;
+	for ( Character& character : characters ) {
+		AnimLod lod = AnimLod::Near;
+		if ( lodSettings.enabled ) {
+			const glm::vec2 delta = character.position - focus;
+			const float distanceSq = delta.x * delta.x + delta.y * delta.y;
+			const bool visible = std::abs( delta.x ) <= lodSettings.viewHalfSize.x && std::abs( delta.y ) <= lodSettings.viewHalfSize.y;
+			if ( !visible && distanceSq > nearSq ) lod = distanceSq > farSq ? AnimLod::Dormant : AnimLod::Far;
+		}
+		character.lod = static_cast< uint8_t >( lod );
+		stats.lodCounts[ lod == AnimLod::Near ? 0 : lod == AnimLod::Far ? 1 : 2 ]++;
+	}
+
+	batchCounts.assign( ( characters.size() + BATCH_SIZE - 1 ) / BATCH_SIZE * 3, 0 );
+	JobSystem::getInstance().parallelFor( characters.size(), BATCH_SIZE, [ this, dt ]( size_t begin, size_t end ) {
+		std::vector<BonePose> scratch;
+		std::vector<glm::mat3x2> palette;
+		uint32_t* counts = batchCounts.data() + begin / BATCH_SIZE * 3;
+		for ( size_t i = begin; i < end; i++ ) {
+			Character& character = characters[ i ];
+			if ( advance( character, dt ) ) counts[ 2 ]++;
+			if ( ( frame + character.phase ) % character.lod != 0 ) continue;
+			evaluatePose( character, scratch );
+			counts[ 0 ]++;
+			if ( character.lod == static_cast< uint8_t >( AnimLod::Near ) && character.mesh >= 0 ) {
+				skin( character, palette );
+				counts[ 1 ]++;
+			}
+		}
+	} );
+	for ( size_t batch = 0; batch < batchCounts.size(); batch += 3 ) {
+		stats.posed += batchCounts[ batch ];
+		stats.skinned += batchCounts[ batch + 1 ];
+		stats.transitions += batchCounts[ batch + 2 ];
+	}
+	frame++;
+	stats.updateMs = elapsedMs( start );
+}
@@ -1,5 +1,10 @@
 #include "Application.h" // Includes the Application class definition.
+#include "AudioEngine.h" // Includes the AudioEngine class definition for music and ambience streaming.
+#include "EventBus.h" // Includes the EventBus class definition for gameplay event delivery.
+#include "Log.h" // Includes the Logger, started first and stopped last.
 #include "Input.h" // Includes the InputManager class definition for input handling.
+#include "JobSystem.h" // Includes the JobSystem that runs worker startup tasks.
+#include "Telemetry.h" // Includes the Telemetry recorder for frame timings and hitch captures.
 #include "Window.h" // Includes the Window class definition for window management.
 #include <string> // Standard library for string operations.
 #include <iostream> // Standard library for console output (e.g., std::cout).
@@ -22,9 +27,36 @@ void Application::run() {
 }
 
 void Application::init() {
-	mainWindow.init();
+	Logger::getInstance().init();
+	JobSystem::getInstance().init();
 
-	InputManager::getInstance().init( mainWindow.getGLFWwindow() );
+	Telemetry& telemetry = Telemetry::getInstance();
+	telemetry.init();
+	telemetryInput = telemetry.registerSubsystem( "input", TelemetryPhase::Simulation );
+	telemetrySimulation = telemetry.registerSubsystem( "simulation", TelemetryPhase::Simulation );
+	telemetryAudio = telemetry.registerSubsystem( "audio", TelemetryPhase::Simulation );
+	telemetryRender = telemetry.registerSubsystem( "render", TelemetryPhase::Render );
+	telemetryEvents = telemetry.registerCounter( "events" );
+	telemetryVoices = telemetry.registerCounter( "voices" );
+
+	// The window and everything touching its GL context stay on this thread; the rest overlaps them on workers.
+	startup.add( "window", StartupThread::Main, [ this ]() {
+		mainWindow.init();
+		return true;
+	} );
+	startup.add( "input", StartupThread::Main, [ this ]() {
+		InputManager::getInstance().init( mainWindow.getGLFWwindow() );
+		return true;
+	}, { "window" } );
+	// Audio is optional; without a device the game simply runs silent.
+	startup.add( "audio", StartupThread::Worker, []() { return AudioEngine::getInstance().init(); } );
+	startup.add( "voices", StartupThread::Worker, [ this ]() { return voices.init(); }, { "audio" } );
+	startup.run();
+
+	if ( !startup.succeeded( "window" ) || !startup.succeeded( "input" ) ) {
+		LOG_FATAL( "Failure to start the window and input." );
+		exit( -1 );
+	}
 }
 
 void Application::loop() {
@@ -32,11 +64,25 @@ void Application::loop() {
 	double frameBegin = glfwGetTime();
 	double frameEnd;
 
+	EventBus& events = EventBus::getInstance();
+	Telemetry& telemetry = Telemetry::getInstance();
+	telemetry.beginFrame(); // Startup is not part of the first frame.
 	while ( !mainWindow.shouldClose() ) {
-		glfwPollEvents();
+		{
+			TelemetryScope scope( telemetryInput );
+			glfwPollEvents();
+			events.deliver( EventPhase::Input );
+		}
 
 		update( dt );
-		InputManager::getInstance().update();
+		{
+			TelemetryScope scope( telemetryInput );
+			InputManager::getInstance().update();
+		}
+		events.endFrame();
+		telemetry.setCounter( telemetryEvents, events.getStats().posted );
+		telemetry.setCounter( telemetryVoices, static_cast< uint64_t >( voices.getStats().live ) );
+		telemetry.endFrame();
 
 		frameEnd = glfwGetTime();
 		dt = frameEnd - frameBegin;
@@ -45,13 +91,35 @@ void Application::loop() {
 }
 
 void Application::shutdown() {
+	voices.shutdown();
+	AudioEngine::getInstance().shutdown();
 	mainWindow.shutdown();
+	JobSystem::getInstance().shutdown();
 
 	glfwTerminate();
+	Telemetry::getInstance().shutdown();
+	Logger::getInstance().shutdown();
 };
 
 void Application::update( double dt ) {
 	if ( dt <= 0 ) return;
 
-	mainWindow.update();
+	// Nothing simulates between these phases yet; gameplay systems slot in here.
+	EventBus& events = EventBus::getInstance();
+	{
+		TelemetryScope scope( telemetrySimulation );
+		events.deliver( EventPhase::Simulation );
+		events.deliver( EventPhase::PostPhysics );
+	}
+	{
+		TelemetryScope scope( telemetryAudio );
+		voices.update( static_cast< float >( dt ) );
+	}
+	{
+		TelemetryScope scope( telemetryRender );
+		events.deliver( EventPhase::Presentation );
+		mainWindow.update();
+	}
+
+	if ( startup.markFirstFrame() ) startup.logTrace();
 }
\ No newline at end of file
@@ -0,0 +1,379 @@
+#include <algorithm> // Required for std::min and std::max.
+#include <chrono> // Required for the audio thread's frame timing.
+#include <cmath> // Required for std::abs.
+#include <cstring> // Required for std::memcmp and std::memcpy.
+
+#include <AL/alext.h> // Includes the AL_EXT_float32 buffer formats.
+
+#include "AudioEngine.h" // Includes the AudioEngine class definition.
+#include "Log.h" // Includes the Logger for error output.
+
+AudioEngine AudioEngine::instance; // Definition and initialization of the static singleton instance.
+
+static uint16_t readU16( const uint8_t* p ) {
+	return static_cast< uint16_t >( p[ 0 ] | ( p[ 1 ] << 8 ) );
+}
+
+static uint32_t readU32( const uint8_t* p ) {
+	return static_cast< uint32_t >( p[ 0 ] ) | ( static_cast< uint32_t >( p[ 1 ] ) << 8 ) |
+		( static_cast< uint32_t >( p[ 2 ] ) << 16 ) | ( static_cast< uint32_t >( p[ 3 ] ) << 24 );
+}
+
+bool parseWav( const uint8_t* data, size_t size, WavData& out ) {
+	if ( size < 12 || std::memcmp( data, "RIFF", 4 ) || std::memcmp( data + 8, "WAVE", 4 ) ) return false;
+
+	int formatTag = 0, channels = 0, sampleRate = 0, blockAlign = 0, bits = 0;
+	const uint8_t* samples = nullptr;
+	size_t sampleBytes = 0;
+
+	size_t pos = 12;
+	while ( pos + 8 <= size ) {
+		const uint8_t* id = data + pos;
+		size_t chunkSize = readU32( data + pos + 4 );
+		const size_t body = pos + 8;
+		if ( chunkSize > size - body ) chunkSize = size - body; // Tolerate truncated files.
+
+		if ( !std::memcmp( id, "fmt ", 4 ) && chunkSize >= 16 ) {
+			formatTag = readU16( data + body );
+			channels = readU16( data + body + 2 );
+			sampleRate = static_cast< int >( readU32( data + body + 4 ) );
+			blockAlign = readU16( data + body + 12 );
+			bits = readU16( data + body + 14 );
+			if ( formatTag == 0xFFFE && chunkSize >= 26 ) formatTag = readU16( data + body + 24 ); // WAVE_FORMAT_EXTENSIBLE sub-format.
+		}
+		else if ( !std::memcmp( id, "data", 4 ) ) {
+			samples = data + body;
+			sampleBytes = chunkSize;
+		}
+		pos = body + chunkSize + ( chunkSize & 1 ); // Chunks are padded to an even size.
+	}
+
+	if ( !samples || channels < 1 || channels > 2 || sampleRate <= 0 || blockAlign != channels * bits / 8 ) return false;
+
+	ALenum format = AL_NONE;
+	if ( formatTag == 1 && bits == 8 ) format = channels == 1 ? AL_FORMAT_MONO8 : AL_FORMAT_STEREO8;
+	else if ( formatTag == 1 && bits == 16 ) format = channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+	else if ( formatTag == 3 && bits == 32 ) format = channels == 1 ? AL_FORMAT_MONO_FLOAT32 : AL_FORMAT_STEREO_FLOAT32;
+	if ( format == AL_NONE ) return false;
+
+	out.samples = samples;
+	out.bytes = sampleBytes - sampleBytes % blockAlign;
+	out.format = format;
+	out.sampleRate = sampleRate;
+	out.channels = channels;
+	out.bytesPerFrame = blockAlign;
+	return true;
+}
+
+AudioEngine& AudioEngine::getInstance() {
+	return instance;
+}
+
+AudioEngine::~AudioEngine() {
+	shutdown();
+}
+
+bool AudioEngine::init( const char* deviceName ) {
+	if ( running ) return true;
+
+	device = alcOpenDevice( deviceName );
+	if ( !device ) {
+		LOG_ERROR( "Failure to open OpenAL device." );
+		return false;
+	}
+
+	context = alcCreateContext( device, nullptr );
+	if ( !context || !alcMakeContextCurrent( context ) ) {
+		LOG_ERROR( "Failure to create OpenAL context." );
+		if ( context ) alcDestroyContext( context );
+		alcCloseDevice( device );
+		context = nullptr;
+		device = nullptr;
+		return false;
+	}
+
+	// Every source and buffer the streams will ever use is created up front.
+	for ( Stream& stream : streams ) {
+		alGenSources( 1, &stream.source );
+		alGenBuffers( BUFFERS_PER_STREAM, stream.buffers );
+		alSourcei( stream.source, AL_SOURCE_RELATIVE, AL_TRUE ); // Streams are not positional.
+		alSource3f( stream.source, AL_POSITION, 0.0f, 0.0f, 0.0f );
+		stream.scratch.resize( BUFFER_BYTES );
+	}
+	if ( alGetError() != AL_NO_ERROR ) LOG_ERROR( "OpenAL error while creating stream sources." );
+
+	running = true;
+	thread = std::thread( &AudioEngine::threadLoop, this );
+	return true;
+}
+
+void AudioEngine::shutdown() {
+	if ( !running ) return;
+
+	running = false;
+	thread.join();
+
+	Command ignored;
+	while ( commands.pop( ignored ) ) {}
+
+	for ( Stream& stream : streams ) {
+		alDeleteSources( 1, &stream.source );
+		alDeleteBuffers( BUFFERS_PER_STREAM, stream.buffers );
+		stream.source = 0;
+	}
+
+	alcMakeContextCurrent( nullptr );
+	alcDestroyContext( context );
+	alcCloseDevice( device );
+	context = nullptr;
+	device = nullptr;
+}
+
+StreamHandle AudioEngine::playStream( const std::string& path, float gain, bool loop, float fadeInSeconds ) {
+	if ( !running ) return 0;
+	if ( path.size() >= MAX_PATH_LENGTH ) {
+		LOG_ERROR( "Audio path too long: {}", path );
+		return 0;
+	}
+
+	StreamHandle handle = nextHandle.fetch_add( 1, std::memory_order_relaxed );
+	if ( handle == 0 ) handle = nextHandle.fetch_add( 1, std::memory_order_relaxed ); // Skip 0 on wrap-around.
+
+	Command command{ CommandType::Play, handle, gain, fadeInSeconds, loop, {} };
+	std::memcpy( command.path, path.c_str(), path.size() + 1 );
+	return send( command ) ? handle : 0;
+}
+
+void AudioEngine::stopStream( StreamHandle handle, float fadeOutSeconds ) {
+	send( { CommandType::Stop, handle, 0.0f, fadeOutSeconds, false, {} } );
+}
+
+void AudioEngine::setStreamGain( StreamHandle handle, float gain, float fadeSeconds ) {
+	send( { CommandType::SetGain, handle, gain, fadeSeconds, false, {} } );
+}
+
+StreamHandle AudioEngine::playMusic( const std::string& path, float crossfadeSeconds, float gain ) {
+	if ( !running ) return 0;
+	if ( path.size() >= MAX_PATH_LENGTH ) {
+		LOG_ERROR( "Audio path too long: {}", path );
+		return 0;
+	}
+
+	StreamHandle handle = nextHandle.fetch_add( 1, std::memory_order_relaxed );
+	if ( handle == 0 ) handle = nextHandle.fetch_add( 1, std::memory_order_relaxed );
+
+	Command command{ CommandType::PlayMusic, handle, gain, crossfadeSeconds, true, {} };
+	std::memcpy( command.path, path.c_str(), path.size() + 1 );
+	return send( command ) ? handle : 0;
+}
+
+void AudioEngine::stopMusic( float fadeOutSeconds ) {
+	send( { CommandType::StopMusic, 0, 0.0f, fadeOutSeconds, false, {} } );
+}
+
+void AudioEngine::setMasterGain( float gain ) {
+	send( { CommandType::SetMasterGain, 0, gain, 0.0f, false, {} } );
+}
+
+bool AudioEngine::send( const Command& command ) {
+	if ( !running ) return false;
+	if ( commands.push( command ) ) return true;
+
+	droppedCommands++;
+	return false;
+}
+
+void AudioEngine::threadLoop() {
+	auto last = std::chrono::steady_clock::now();
+
+	while ( running.load( std::memory_order_acquire ) ) {
+		Command command;
+		while ( commands.pop( command ) ) process( command );
+
+		auto now = std::chrono::steady_clock::now();
+		float dt = std::chrono::duration<float>( now - last ).count();
+		last = now;
+
+		int active = 0;
+		for ( Stream& stream : streams ) {
+			update( stream, dt );
+			if ( stream.handle ) active++;
+		}
+		activeStreams.store( active, std::memory_order_relaxed );
+
+		std::this_thread::sleep_for( std::chrono::milliseconds( UPDATE_MS ) );
+	}
+
+	for ( Stream& stream : streams ) {
+		if ( stream.handle ) release( stream );
+	}
+	activeStreams.store( 0, std::memory_order_relaxed );
+}
+
+void AudioEngine::process( const Command& command ) {
+	switch ( command.type ) {
+	case CommandType::Play:
+		start( command );
+		break;
+	case CommandType::PlayMusic:
+		if ( Stream* previous = find( musicHandle ) ) {
+			previous->stopping = true;
+			fadeTo( *previous, 0.0f, command.fadeSeconds );
+		}
+		musicHandle = start( command ) ? command.handle : 0;
+		break;
+	case CommandType::Stop:
+	case CommandType::StopMusic:
+		if ( Stream* stream = find( command.type == CommandType::Stop ? command.handle : musicHandle ) ) {
+			stream->stopping = true;
+			fadeTo( *stream, 0.0f, command.fadeSeconds );
+		}
+		if ( command.type == CommandType::StopMusic || command.handle == musicHandle ) musicHandle = 0;
+		break;
+	case CommandType::SetGain:
+		if ( Stream* stream = find( command.handle ) ) {
+			if ( !stream->stopping ) fadeTo( *stream, command.gain, command.fadeSeconds );
+		}
+		break;
+	case CommandType::SetMasterGain:
+		masterGain = command.gain;
+		break;
+	}
+}
+
+AudioEngine::Stream* AudioEngine::start( const Command& command ) {
+	Stream* stream = nullptr;
+	for ( Stream& candidate : streams ) {
+		if ( !candidate.handle ) {
+			stream = &candidate;
+			break;
+		}
+	}
+	if ( !stream ) {
+		LOG_WARN( "No free audio stream for {}", command.path );
+		return nullptr;
+	}
+
+	if ( !stream->file.open( command.path ) || !parseWav( stream->file.data(), stream->file.size(), stream->wav ) ) {
+		LOG_ERROR( "Failure to stream audio file {}", command.path );
+		stream->file.close();
+		return nullptr;
+	}
+	stream->file.adviseSequential();
+
+	stream->handle = command.handle;
+	stream->cursor = 0;
+	stream->released = 0;
+	stream->loop = command.loop;
+	stream->stopping = false;
+	stream->ended = false;
+	stream->gain = command.fadeSeconds > 0.0f ? 0.0f : command.gain;
+	fadeTo( *stream, command.gain, command.fadeSeconds );
+
+	int queued = 0;
+	while ( queued < BUFFERS_PER_STREAM && fill( *stream, stream->buffers[ queued ] ) ) queued++;
+	alSourceQueueBuffers( stream->source, queued, stream->buffers );
+	alSourcef( stream->source, AL_GAIN, stream->gain * masterGain );
+	alSourcePlay( stream->source );
+	return stream;
+}
+
+void AudioEngine::update( Stream& stream, float dt ) {
+	if ( !stream.handle ) return;
+
+	// Refill every buffer the source has finished with and put it back at the end of the queue.
+	ALint processed = 0;
+	alGetSourcei( stream.source, AL_BUFFERS_PROCESSED, &processed );
+	while ( processed-- > 0 ) {
+		ALuint buffer;
+		alSourceUnqueueBuffers( stream.source, 1, &buffer );
+		if ( fill( stream, buffer ) ) alSourceQueueBuffers( stream.source, 1, &buffer );
+	}
+
+	// OpenAL copied everything before the cursor, so those pages can leave memory.
+	if ( stream.cursor > stream.released ) {
+		const size_t dataOffset = static_cast< size_t >( stream.wav.samples - stream.file.data() );
+		stream.file.release( dataOffset + stream.released, stream.cursor - stream.released );
+		stream.released = stream.cursor;
+	}
+
+	if ( stream.gain != stream.targetGain ) {
+		const float step = stream.fadeRate * dt;
+		if ( stream.gain < stream.targetGain ) stream.gain = std::min( stream.gain + step, stream.targetGain );
+		else stream.gain = std::max( stream.gain - step, stream.targetGain );
+	}
+	if ( stream.stopping && stream.gain <= 0.0f ) {
+		release( stream );
+		return;
+	}
+	alSourcef( stream.source, AL_GAIN, stream.gain * masterGain );
+
+	ALint state = AL_STOPPED, queued = 0;
+	alGetSourcei( stream.source, AL_SOURCE_STATE, &state );
+	alGetSourcei( stream.source, AL_BUFFERS_QUEUED, &queued );
+	if ( state != AL_PLAYING ) {
+		if ( queued > 0 ) alSourcePlay( stream.source ); // Ran dry before the refill; resume.
+		else release( stream ); // Played to the end.
+	}
+}
+
+bool AudioEngine::fill( Stream& stream, ALuint buffer ) {
+	if ( stream.ended ) return false;
+
+	const WavData& wav = stream.wav;
+	const size_t chunk = BUFFER_BYTES - BUFFER_BYTES % wav.bytesPerFrame;
+	const size_t remaining = wav.bytes - stream.cursor;
+
+	// Contiguous data is handed to OpenAL straight from the mapping.
+	if ( remaining >= chunk || ( !stream.loop && remaining > 0 ) ) {
+		const size_t size = std::min( chunk, remaining );
+		alBufferData( buffer, wav.format, wav.samples + stream.cursor, static_cast< ALsizei >( size ), wav.sampleRate );
+		stream.cursor += size;
+		return true;
+	}
+	if ( !stream.loop || wav.bytes == 0 ) {
+		stream.ended = true;
+		return false;
+	}
+
+	// A looping stream wraps around the end of the file inside this buffer.
+	size_t filled = 0;
+	while ( filled < chunk ) {
+		if ( stream.cursor == wav.bytes ) {
+			stream.cursor = 0;
+			stream.released = 0;
+		}
+		const size_t size = std::min( chunk - filled, wav.bytes - stream.cursor );
+		std::memcpy( stream.scratch.data() + filled, wav.samples + stream.cursor, size );
+		filled += size;
+		stream.cursor += size;
+	}
+	alBufferData( buffer, wav.format, stream.scratch.data(), static_cast< ALsizei >( filled ), wav.sampleRate );
+	return true;
+}
+
+void AudioEngine::release( Stream& stream ) {
+	alSourceStop( stream.source );
+	alSourcei( stream.source, AL_BUFFER, 0 ); // Unqueues every buffer.
+	stream.file.close();
+	stream.handle = 0;
+}
+
+AudioEngine::Stream* AudioEngine::find( StreamHandle handle ) {
+	if ( !handle ) return nullptr;
+	for ( Stream& stream : streams ) {
+		if ( stream.handle == handle ) return &stream;
+	}
+	return nullptr;
+}
+
+void AudioEngine::fadeTo( Stream& stream, float target, float seconds ) {
+	stream.targetGain = target;
+	if ( seconds <= 0.0f ) {
+		stream.gain = target;
+		stream.fadeRate = 0.0f;
+	}
+	else {
+		stream.fadeRate = std::abs( target - stream.gain ) / seconds;
+	}
+}
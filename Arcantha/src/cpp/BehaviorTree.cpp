@@ -0,0 +1,171 @@
+#include <cmath> // Required for std::abs.
+#include <utility> // Required for std::move.
+
+#include "BehaviorTree.h" // Includes the BehaviorTree and AiSystem class definitions.
+#include "JobSystem.h" // Includes the JobSystem that evaluates batches in parallel.
+
+const size_t AiSystem::BATCH_SIZE;
+
+uint16_t Blackboard::addKey() {
+	columns.emplace_back( agentCount, 0.0f );
+	return static_cast< uint16_t >( columns.size() - 1 );
+}
+
+uint32_t Blackboard::addAgent() {
+	for ( std::vector<float>& column : columns ) column.push_back( 0.0f );
+	return agentCount++;
+}
+
+void BehaviorTree::open( BtNodeType type ) {
+	BtNode node{};
+	node.type = type;
+	openNodes.push_back( static_cast< uint16_t >( nodes.size() ) );
+	nodes.push_back( node );
+}
+
+void BehaviorTree::end() {
+	if ( openNodes.empty() ) return;
+	nodes[ openNodes.back() ].end = static_cast< uint16_t >( nodes.size() );
+	openNodes.pop_back();
+}
+
+void BehaviorTree::condition( uint16_t key, BtCompare compare, float value ) {
+	BtNode node{};
+	node.type = BtNodeType::Condition;
+	node.compare = compare;
+	node.key = key;
+	node.value = value;
+	node.end = static_cast< uint16_t >( nodes.size() + 1 );
+	nodes.push_back( node );
+}
+
+void BehaviorTree::action( uint16_t action ) {
+	BtNode node{};
+	node.type = BtNodeType::Action;
+	node.action = action;
+	node.end = static_cast< uint16_t >( nodes.size() + 1 );
+	nodes.push_back( node );
+}
+
+BtStatus BehaviorTree::evaluate( Blackboard& blackboard, uint32_t agent, const AiTickContext& context, const std::vector<AiAction>& actions, uint32_t& visits ) const {
+	return evaluateNode( 0, blackboard, agent, context, actions, visits );
+}
+
+BtStatus BehaviorTree::evaluateNode( uint16_t index, Blackboard& blackboard, uint32_t agent, const AiTickContext& context, const std::vector<AiAction>& actions, uint32_t& visits ) const {
+	const BtNode& node = nodes[ index ];
+	visits++;
+
+	switch ( node.type ) {
+	case BtNodeType::Selector:
+		for ( uint16_t child = index + 1; child < node.end; child = nodes[ child ].end ) {
+			const BtStatus status = evaluateNode( child, blackboard, agent, context, actions, visits );
+			if ( status != BtStatus::Failure ) return status;
+		}
+		return BtStatus::Failure;
+
+	case BtNodeType::Sequence:
+		for ( uint16_t child = index + 1; child < node.end; child = nodes[ child ].end ) {
+			const BtStatus status = evaluateNode( child, blackboard, agent, context, actions, visits );
+			if ( status != BtStatus::Success ) return status;
+		}
+		return BtStatus::Success;
+
+	case BtNodeType::Inverter: {
+		if ( index + 1 >= node.end ) return BtStatus::Failure;
+		const BtStatus status = evaluateNode( index + 1, blackboard, agent, context, actions, visits );
+		if ( status == BtStatus::Running ) return status;
+		return status == BtStatus::Success ? BtStatus::Failure : BtStatus::Success;
+	}
+
+	case BtNodeType::Condition: {
+		const float value = blackboard.at( node.key, agent );
+		const bool pass = node.compare == BtCompare::Less ? value < node.value : value > node.value;
+		return pass ? BtStatus::Success : BtStatus::Failure;
+	}
+
+	default:
+		return actions[ node.action ]( blackboard, agent, context );
+	}
+}
+
+uint16_t AiSystem::addAction( AiAction action ) {
+	actions.push_back( action );
+	return static_cast< uint16_t >( actions.size() - 1 );
+}
+
+int AiSystem::addGroup( const BehaviorTree& tree, const Blackboard& blackboard, uint16_t positionX, uint16_t positionY ) {
+	if ( !tree.isComplete() ) return -1;
+
+	Group group;
+	group.tree = tree;
+	group.blackboard = blackboard;
+	group.positionX = positionX;
+	group.positionY = positionY;
+	for ( uint32_t agent = 0; agent < blackboard.getAgentCount(); agent++ ) {
+		group.lod.push_back( static_cast< uint8_t >( AiLod::Near ) );
+		group.phase.push_back( static_cast< uint8_t >( agent & 15 ) );
+		group.pendingDt.push_back( 0.0f );
+		group.status.push_back( BtStatus::Failure );
+	}
+	groups.push_back( std::move( group ) );
+	return static_cast< int >( groups.size() - 1 );
+}
+
+uint32_t AiSystem::addAgent( int group ) {
+	Group& target = groups[ group ];
+	const uint32_t agent = target.blackboard.addAgent();
+	target.lod.push_back( static_cast< uint8_t >( AiLod::Near ) );
+	target.phase.push_back( static_cast< uint8_t >( agent & 15 ) );
+	target.pendingDt.push_back( 0.0f );
+	target.status.push_back( BtStatus::Failure );
+	return agent;
+}
+
+void AiSystem::schedule( Group& group, float dt, glm::vec2 focus ) {
+	const std::vector<float>& xs = group.blackboard.column( group.positionX );
+	const std::vector<float>& ys = group.blackboard.column( group.positionY );
+	const float nearSq = lodSettings.nearRadius * lodSettings.nearRadius;
+	const float farSq = lodSettings.farRadius * lodSettings.farRadius;
+
+	group.due.clear();
+	for ( uint32_t agent = 0; agent < group.blackboard.getAgentCount(); agent++ ) {
+		AiLod lod = AiLod::Near;
+		if ( lodSettings.enabled ) {
+			const glm::vec2 delta( xs[ agent ] - focus.x, ys[ agent ] - focus.y );
+			const float distanceSq = delta.x * delta.x + delta.y * delta.y;
+			const bool visible = std::abs( delta.x ) <= lodSettings.viewHalfSize.x && std::abs( delta.y ) <= lodSettings.viewHalfSize.y;
+			if ( !visible && distanceSq > nearSq ) lod = distanceSq > farSq ? AiLod::Dormant : AiLod::Far;
+		}
+		group.lod[ agent ] = static_cast< uint8_t >( lod );
+		stats.lodCounts[ lod == AiLod::Near ? 0 : lod == AiLod::Far ? 1 : 2 ]++;
+
+		group.pendingDt[ agent ] += dt;
+		if ( ( frame + group.phase[ agent ] ) % static_cast< uint8_t >( lod ) == 0 ) group.due.push_back( agent );
+	}
+}
+
+void AiSystem::update( float dt, glm::vec2 focus ) {
+	stats = AiStats();
+
+	for ( Group& group : groups ) {
+		schedule( group, dt, focus );
+		stats.agents += group.blackboard.getAgentCount();
+		stats.evaluated += static_cast< uint32_t >( group.due.size() );
+
+		// Batches are contiguous runs of due agents; each writes only its own rows and visit counter.
+		group.batchVisits.assign( ( group.due.size() + BATCH_SIZE - 1 ) / BATCH_SIZE, 0 );
+		JobSystem::getInstance().parallelFor( group.due.size(), BATCH_SIZE, [ this, &group, focus ]( size_t begin, size_t end ) {
+			AiTickContext context{ frame, 0.0f, focus };
+			uint32_t visits = 0;
+			for ( size_t i = begin; i < end; i++ ) {
+				const uint32_t agent = group.due[ i ];
+				context.dt = group.pendingDt[ agent ];
+				group.status[ agent ] = group.tree.evaluate( group.blackboard, agent, context, actions, visits );
+				group.pendingDt[ agent ] = 0.0f;
+			}
+			group.batchVisits[ begin / BATCH_SIZE ] = visits;
+		} );
+		for ( uint32_t visits : group.batchVisits ) stats.nodeVisits += visits;
+	}
+	frame++;
+}
@@ -0,0 +1,370 @@
+#include <algorithm> // Required for std::sort, std::unique, std::find and std::max.
+
+#include "CombatCollision.h" // Includes the CombatCollision class definition.
+#include "Simd.h" // Includes the SIMD capability macros and intrinsics.
+
+static const float FAR_AWAY = 1e30f; // Coordinate of the pad boxes, which never overlap anything.
+
+const uint16_t FrameDataTable::INVALID;
+
+uint16_t FrameDataTable::add( const AttackData& attack ) {
+	attacks.push_back( attack );
+	return static_cast< uint16_t >( attacks.size() - 1 );
+}
+
+uint16_t FrameDataTable::find( const std::string& name ) const {
+	for ( size_t i = 0; i < attacks.size(); i++ ) {
+		if ( attacks[ i ].name == name ) return static_cast< uint16_t >( i );
+	}
+	return INVALID;
+}
+
+FrameDataTable FrameDataTable::createDefault() {
+	FrameDataTable table;
+
+	// Quick jab: short reach, no pierce, stopped by any guard.
+	AttackData light;
+	light.name = "light";
+	light.totalFrames = 18;
+	light.damage = 6.0f;
+	light.priority = 1;
+	light.hitStop = 4;
+	light.hitStun = 12;
+	light.blockStun = 8;
+	light.parryStun = 30;
+	light.boxes = { { 5, 7, BoxKind::Hit, glm::vec2( 0.9f, 0.1f ), glm::vec2( 0.5f, 0.25f ) } };
+	table.add( light );
+
+	// Overhead swing: slow, wins clashes and breaks shields.
+	AttackData heavy;
+	heavy.name = "heavy";
+	heavy.totalFrames = 34;
+	heavy.damage = 18.0f;
+	heavy.priority = 3;
+	heavy.pierce = 2;
+	heavy.hitStop = 9;
+	heavy.hitStun = 24;
+	heavy.blockStun = 16;
+	heavy.parryStun = 40;
+	heavy.boxes = { { 12, 16, BoxKind::Hit, glm::vec2( 1.0f, 0.2f ), glm::vec2( 0.7f, 0.45f ) } };
+	table.add( heavy );
+
+	// Spear thrust: long and thin, outranges everything but a raised shield stops it.
+	AttackData spear;
+	spear.name = "spear";
+	spear.totalFrames = 28;
+	spear.damage = 12.0f;
+	spear.priority = 2;
+	spear.pierce = 1;
+	spear.hitStop = 6;
+	spear.hitStun = 18;
+	spear.blockStun = 10;
+	spear.parryStun = 36;
+	spear.boxes = { { 9, 12, BoxKind::Hit, glm::vec2( 1.6f, 0.1f ), glm::vec2( 1.0f, 0.15f ) } };
+	table.add( spear );
+
+	// Raised shield: a guard box in front for the whole move.
+	AttackData shield;
+	shield.name = "shield";
+	shield.totalFrames = 40;
+	shield.guardLevel = 2;
+	shield.boxes = { { 2, 39, BoxKind::Guard, glm::vec2( 0.5f, 0.0f ), glm::vec2( 0.25f, 0.9f ) } };
+	table.add( shield );
+
+	// Parry: a short window that turns any hit back on the attacker.
+	AttackData parry;
+	parry.name = "parry";
+	parry.totalFrames = 24;
+	parry.boxes = { { 2, 7, BoxKind::Parry, glm::vec2( 0.5f, 0.0f ), glm::vec2( 0.35f, 0.9f ) } };
+	table.add( parry );
+
+	return table;
+}
+
+void CombatBoxes::clear() {
+	minX.clear();
+	minY.clear();
+	maxX.clear();
+	maxY.clear();
+	owner.clear();
+	team.clear();
+	kind.clear();
+}
+
+void CombatBoxes::push( float x0, float y0, float x1, float y1, uint32_t boxOwner, uint8_t boxTeam, BoxKind boxKind ) {
+	minX.push_back( x0 );
+	minY.push_back( y0 );
+	maxX.push_back( x1 );
+	maxY.push_back( y1 );
+	owner.push_back( boxOwner );
+	team.push_back( boxTeam );
+	kind.push_back( boxKind );
+}
+
+/**
+ * @brief Reports every box from start on whose minX is at most x1 and whose Y range overlaps [y0, y1].
+ *
+ * Boxes are sorted on minX and padded with 4 boxes at FAR_AWAY, so the scan
+ * stops at the first group of four containing a box that starts past x1 and
+ * never reads past the padding. The SSE path tests four boxes per iteration.
+ */
+template < typename Report >
+static void scanOverlaps( const CombatBoxes& boxes, size_t start, float x1, float y0, float y1, Report&& report ) {
+	const float* minX = boxes.minX.data();
+	const float* minY = boxes.minY.data();
+	const float* maxY = boxes.maxY.data();
+
+#if ARCANTHA_SIMD_SSE
+	const __m128 right = _mm_set1_ps( x1 ), bottom = _mm_set1_ps( y0 ), top = _mm_set1_ps( y1 );
+	for ( size_t j = start;; j += 4 ) {
+		const __m128 inRange = _mm_cmple_ps( _mm_loadu_ps( minX + j ), right );
+		const int rangeMask = _mm_movemask_ps( inRange );
+		if ( !rangeMask ) return;
+
+		const __m128 overlapY = _mm_and_ps( _mm_cmple_ps( _mm_loadu_ps( minY + j ), top ), _mm_cmpge_ps( _mm_loadu_ps( maxY + j ), bottom ) );
+		int mask = _mm_movemask_ps( _mm_and_ps( inRange, overlapY ) );
+		for ( int lane = 0; lane < 4; lane++ ) {
+			if ( mask & ( 1 << lane ) ) report( j + lane );
+		}
+		if ( rangeMask != 0xF ) return; // Sorted, so the boxes after a miss (and the padding) are out of range too.
+	}
+#else
+	for ( size_t j = start; minX[ j ] <= x1; j++ ) {
+		if ( minY[ j ] <= y1 && maxY[ j ] >= y0 ) report( j );
+	}
+#endif
+}
+
+CombatCollision::CombatCollision( const FrameDataTable& table ) :
+	table( table ) {}
+
+uint32_t CombatCollision::addCombatant( glm::vec2 position, glm::vec2 hurtHalfSize, uint8_t combatantTeam, float startHealth ) {
+	positionX.push_back( position.x );
+	positionY.push_back( position.y );
+	hurtHalfX.push_back( hurtHalfSize.x );
+	hurtHalfY.push_back( hurtHalfSize.y );
+	team.push_back( combatantTeam );
+	facingLeft.push_back( 0 );
+	health.push_back( startHealth );
+	attack.push_back( FrameDataTable::INVALID );
+	frame.push_back( 0 );
+	hitStop.push_back( 0 );
+	stun.push_back( 0 );
+	victims.emplace_back();
+	cancel.push_back( 0 );
+	return static_cast< uint32_t >( positionX.size() - 1 );
+}
+
+void CombatCollision::setPosition( uint32_t id, glm::vec2 position, bool left ) {
+	positionX[ id ] = position.x;
+	positionY[ id ] = position.y;
+	facingLeft[ id ] = left ? 1 : 0;
+}
+
+bool CombatCollision::startAttack( uint32_t id, uint16_t attackId ) {
+	if ( !isIdle( id ) || attackId >= table.size() ) return false;
+
+	attack[ id ] = attackId;
+	frame[ id ] = 0xFFFF; // Wraps to frame 0 on the next tick.
+	victims[ id ].clear();
+	return true;
+}
+
+bool CombatCollision::isIdle( uint32_t id ) const {
+	return health[ id ] > 0.0f && attack[ id ] == FrameDataTable::INVALID && stun[ id ] == 0 && hitStop[ id ] == 0;
+}
+
+void CombatCollision::tick() {
+	stats = CombatStats();
+	advance();
+	gatherBoxes();
+	sweep();
+	resolve();
+}
+
+void CombatCollision::advance() {
+	for ( size_t i = 0; i < positionX.size(); i++ ) {
+		// Hit-stop freezes everything, including the attack's frame counter.
+		if ( hitStop[ i ] > 0 ) {
+			hitStop[ i ]--;
+			continue;
+		}
+		if ( stun[ i ] > 0 ) stun[ i ]--;
+		if ( attack[ i ] == FrameDataTable::INVALID ) continue;
+
+		frame[ i ]++;
+		if ( frame[ i ] >= table.get( attack[ i ] ).totalFrames ) attack[ i ] = FrameDataTable::INVALID;
+	}
+}
+
+void CombatCollision::gatherBoxes() {
+	unsorted.clear();
+	CombatBoxes& hits = targetBoxes; // Reused as scratch for the hit boxes until they are sorted.
+	hits.clear();
+
+	for ( size_t i = 0; i < positionX.size(); i++ ) {
+		if ( health[ i ] <= 0.0f ) continue;
+		const uint32_t id = static_cast< uint32_t >( i );
+		const float x = positionX[ i ], y = positionY[ i ];
+		unsorted.push( x - hurtHalfX[ i ], y - hurtHalfY[ i ], x + hurtHalfX[ i ], y + hurtHalfY[ i ], id, team[ i ], BoxKind::Hurt );
+
+		if ( attack[ i ] == FrameDataTable::INVALID ) continue;
+		const float facing = facingLeft[ i ] ? -1.0f : 1.0f;
+		for ( const FrameBox& box : table.get( attack[ i ] ).boxes ) {
+			if ( frame[ i ] < box.firstFrame || frame[ i ] > box.lastFrame ) continue;
+			const float cx = x + box.offset.x * facing, cy = y + box.offset.y;
+			const float x0 = cx - box.halfSize.x, y0 = cy - box.halfSize.y, x1 = cx + box.halfSize.x, y1 = cy + box.halfSize.y;
+			unsorted.push( x0, y0, x1, y1, id, team[ i ], box.kind );
+			if ( box.kind == BoxKind::Hit ) hits.push( x0, y0, x1, y1, id, team[ i ], box.kind );
+		}
+	}
+
+	sortBoxes( hits, hitBoxes );
+	sortBoxes( unsorted, targetBoxes );
+	stats.hitBoxes = hitBoxes.size();
+	stats.targetBoxes = targetBoxes.size();
+}
+
+void CombatCollision::sortBoxes( const CombatBoxes& source, CombatBoxes& destination ) {
+	order.resize( source.size() );
+	for ( size_t i = 0; i < order.size(); i++ ) order[ i ] = static_cast< uint32_t >( i );
+	// Ties are broken by gather order, so the sorted arrays (and everything after) are deterministic.
+	std::sort( order.begin(), order.end(), [ &source ]( uint32_t a, uint32_t b ) {
+		return source.minX[ a ] < source.minX[ b ] || ( source.minX[ a ] == source.minX[ b ] && a < b );
+	} );
+
+	destination.clear();
+	for ( uint32_t i : order ) {
+		destination.push( source.minX[ i ], source.minY[ i ], source.maxX[ i ], source.maxY[ i ], source.owner[ i ], source.team[ i ], source.kind[ i ] );
+	}
+	for ( int pad = 0; pad < 4; pad++ ) {
+		destination.minX.push_back( FAR_AWAY );
+		destination.minY.push_back( FAR_AWAY );
+		destination.maxX.push_back( FAR_AWAY );
+		destination.maxY.push_back( FAR_AWAY );
+	}
+}
+
+void CombatCollision::sweep() {
+	contacts.clear();
+	const size_t hitCount = hitBoxes.size(), targetCount = targetBoxes.size();
+
+	// Every overlapping pair is found exactly once: either the target starts inside the hit
+	// box's X range (first pass), or the hit box starts strictly inside the target's (second).
+	size_t first = 0;
+	for ( size_t h = 0; h < hitCount; h++ ) {
+		while ( first < targetCount && targetBoxes.minX[ first ] < hitBoxes.minX[ h ] ) first++;
+		scanOverlaps( targetBoxes, first, hitBoxes.maxX[ h ], hitBoxes.minY[ h ], hitBoxes.maxY[ h ], [ & ]( size_t t ) {
+			addContact( static_cast< uint32_t >( h ), static_cast< uint32_t >( t ) );
+		} );
+	}
+
+	first = 0;
+	for ( size_t t = 0; t < targetCount; t++ ) {
+		while ( first < hitCount && hitBoxes.minX[ first ] <= targetBoxes.minX[ t ] ) first++;
+		scanOverlaps( hitBoxes, first, targetBoxes.maxX[ t ], targetBoxes.minY[ t ], targetBoxes.maxY[ t ], [ & ]( size_t h ) {
+			addContact( static_cast< uint32_t >( h ), static_cast< uint32_t >( t ) );
+		} );
+	}
+}
+
+void CombatCollision::addContact( uint32_t hit, uint32_t target ) {
+	const uint32_t attacker = hitBoxes.owner[ hit ], defender = targetBoxes.owner[ target ];
+	if ( attacker == defender ) return;
+	stats.candidatePairs++;
+	if ( hitBoxes.team[ hit ] == targetBoxes.team[ target ] ) return;
+	contacts.push_back( { attacker, defender, targetBoxes.kind[ target ] } );
+}
+
+// Lower rank wins when an attacker touches several boxes of the same defender.
+static int contactRank( BoxKind kind ) {
+	switch ( kind ) {
+	case BoxKind::Parry: return 0;
+	case BoxKind::Guard: return 1;
+	case BoxKind::Hit: return 2;
+	default: return 3;
+	}
+}
+
+void CombatCollision::resolve() {
+	events.clear();
+	stats.contacts = contacts.size();
+	if ( contacts.empty() ) return;
+
+	// One contact per attacker and defender: the best ranked box wins.
+	std::sort( contacts.begin(), contacts.end(), []( const Contact& a, const Contact& b ) {
+		if ( a.attacker != b.attacker ) return a.attacker < b.attacker;
+		if ( a.defender != b.defender ) return a.defender < b.defender;
+		return contactRank( a.kind ) < contactRank( b.kind );
+	} );
+	contacts.erase( std::unique( contacts.begin(), contacts.end(), []( const Contact& a, const Contact& b ) {
+		return a.attacker == b.attacker && a.defender == b.defender;
+	} ), contacts.end() );
+
+	// Decisions only read state from before this pass; cancellations are applied after it.
+	std::fill( cancel.begin(), cancel.end(), 0 );
+	auto freeze = [ this ]( uint32_t id, uint16_t frames ) { hitStop[ id ] = std::max( hitStop[ id ], frames ); };
+	auto addStun = [ this ]( uint32_t id, uint16_t frames ) { stun[ id ] = std::max( stun[ id ], frames ); };
+
+	for ( const Contact& contact : contacts ) {
+		const uint32_t a = contact.attacker, d = contact.defender;
+		std::vector<uint32_t>& hitAlready = victims[ a ];
+		if ( std::find( hitAlready.begin(), hitAlready.end(), d ) != hitAlready.end() ) continue;
+		const AttackData& data = table.get( attack[ a ] );
+
+		switch ( contact.kind ) {
+		case BoxKind::Parry:
+			events.push_back( { CombatEventType::Parried, a, d, attack[ a ], 0.0f } );
+			cancel[ a ] = 1;
+			addStun( a, data.parryStun );
+			freeze( a, data.hitStop );
+			freeze( d, data.hitStop );
+			break;
+
+		case BoxKind::Guard:
+			if ( data.pierce >= table.get( attack[ d ] ).guardLevel ) {
+				events.push_back( { CombatEventType::GuardBreak, a, d, attack[ a ], data.damage } );
+				health[ d ] -= data.damage;
+				cancel[ d ] = 1;
+				addStun( d, data.hitStun );
+			}
+			else {
+				events.push_back( { CombatEventType::Blocked, a, d, attack[ a ], 0.0f } );
+				addStun( d, data.blockStun );
+			}
+			freeze( a, data.hitStop );
+			freeze( d, data.hitStop );
+			break;
+
+		case BoxKind::Hit: {
+			// Both hit boxes see each other; the pair is handled once, from the lower id.
+			if ( a > d ) continue;
+			const AttackData& other = table.get( attack[ d ] );
+			const bool aWins = data.priority > other.priority, dWins = other.priority > data.priority;
+			events.push_back( { CombatEventType::Clash, dWins ? d : a, dWins ? a : d, dWins ? attack[ d ] : attack[ a ], 0.0f } );
+			if ( !aWins ) cancel[ a ] = 1;
+			if ( !dWins ) cancel[ d ] = 1;
+			const uint16_t recoil = static_cast< uint16_t >( std::max( data.hitStop, other.hitStop ) / 2 );
+			freeze( a, recoil );
+			freeze( d, recoil );
+			victims[ d ].push_back( a );
+			break;
+		}
+
+		default:
+			events.push_back( { CombatEventType::Hit, a, d, attack[ a ], data.damage } );
+			health[ d ] -= data.damage;
+			cancel[ d ] = 1;
+			addStun( d, data.hitStun );
+			freeze( a, data.hitStop );
+			freeze( d, data.hitStop );
+			break;
+		}
+		hitAlready.push_back( d );
+	}
+
+	for ( size_t i = 0; i < cancel.size(); i++ ) {
+		if ( cancel[ i ] || health[ i ] <= 0.0f ) attack[ i ] = FrameDataTable::INVALID;
+	}
+	stats.events = events.size();
+}
@@ -0,0 +1,422 @@
+#include "DebugDraw.h" // Includes the DebugDraw class definition and the ARCANTHA_DEBUG_DRAW switch.
+#include "JobSystem.h" // Includes JobSystem::getThreadIndex to pick the calling thread's buffers.
+#include "Log.h" // Includes the Logger for error output.
+
+#if ARCANTHA_DEBUG_DRAW
+
+#include <algorithm> // Required for std::min, std::max and std::find.
+#include <cmath> // Required for std::cos and std::sin.
+#include <cstddef> // Required for offsetof.
+
+#include <glad/glad.h> // Includes GLAD for OpenGL function loading.
+#include <glm/gtc/matrix_transform.hpp> // Includes GLM for glm::ortho.
+
+DebugDraw DebugDraw::instance;
+
+static thread_local void* threadBuffer = nullptr; // The calling thread's ThreadBuffer, once looked up.
+
+static const char* DEBUG_VERTEX_SHADER = R"(#version 330 core
+layout( location = 0 ) in vec2 aPosition;
+layout( location = 1 ) in vec4 aColor;
+uniform mat4 uProjection;
+out vec4 vColor;
+void main() {
+	vColor = aColor;
+	gl_Position = uProjection * vec4( aPosition, 0.0, 1.0 );
+}
+)";
+
+static const char* DEBUG_FRAGMENT_SHADER = R"(#version 330 core
+in vec4 vColor;
+out vec4 fragColor;
+void main() {
+	fragColor = vColor;
+}
+)";
+
+/**
+ * @brief Converts a Box2D color to RGBA8.
+ * @param color The color, components in [0, 1].
+ * @return RGBA8, red in the lowest byte.
+ */
+static uint32_t packColor( const b2Color& color ) {
+	auto channel = []( float value ) { return static_cast< uint32_t >( std::min( std::max( value, 0.0f ), 1.0f ) * 255.0f + 0.5f ); };
+	return channel( color.r ) | channel( color.g ) << 8 | channel( color.b ) << 16 | channel( color.a ) << 24;
+}
+
+/**
+ * @brief Halves a color's alpha, for fills under an outline.
+ * @param color RGBA8.
+ * @return The color with half the alpha.
+ */
+static uint32_t fillColor( uint32_t color ) {
+	return ( color & 0x00FFFFFFu ) | ( ( color >> 25 ) << 24 );
+}
+
+/**
+ * @brief Compiles one shader stage.
+ * @param type GL_VERTEX_SHADER or GL_FRAGMENT_SHADER.
+ * @param source GLSL source.
+ * @return The shader, or 0 on failure.
+ */
+static GLuint compileShader( GLenum type, const char* source ) {
+	GLuint shader = glCreateShader( type );
+	glShaderSource( shader, 1, &source, nullptr );
+	glCompileShader( shader );
+	GLint ok = 0;
+	glGetShaderiv( shader, GL_COMPILE_STATUS, &ok );
+	if ( !ok ) {
+		char log[ 512 ];
+		glGetShaderInfoLog( shader, sizeof( log ), nullptr, log );
+		LOG_ERROR( "Debug draw shader failed to compile: {}", log );
+		glDeleteShader( shader );
+		return 0;
+	}
+	return shader;
+}
+
+DebugDraw::DebugDraw() {
+	SetFlags( e_shapeBit );
+}
+
+DebugDraw& DebugDraw::getInstance() {
+	return instance;
+}
+
+bool DebugDraw::initGL() {
+	if ( glReady ) return true;
+	GLuint vertexShader = compileShader( GL_VERTEX_SHADER, DEBUG_VERTEX_SHADER );
+	GLuint fragmentShader = compileShader( GL_FRAGMENT_SHADER, DEBUG_FRAGMENT_SHADER );
+	if ( !vertexShader || !fragmentShader ) {
+		if ( vertexShader ) glDeleteShader( vertexShader );
+		if ( fragmentShader ) glDeleteShader( fragmentShader );
+		return false;
+	}
+	program = glCreateProgram();
+	glAttachShader( program, vertexShader );
+	glAttachShader( program, fragmentShader );
+	glLinkProgram( program );
+	glDeleteShader( vertexShader );
+	glDeleteShader( fragmentShader );
+	GLint linked = 0;
+	glGetProgramiv( program, GL_LINK_STATUS, &linked );
+	if ( !linked ) {
+		LOG_ERROR( "Debug draw shader failed to link." );
+		glDeleteProgram( program );
+		program = 0;
+		return false;
+	}
+	projectionLocation = glGetUniformLocation( program, "uProjection" );
+
+	glGenVertexArrays( 1, &vao );
+	glGenBuffers( 1, &vbo );
+	glBindVertexArray( vao );
+	glBindBuffer( GL_ARRAY_BUFFER, vbo );
+	glEnableVertexAttribArray( 0 );
+	glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, sizeof( Vertex ), reinterpret_cast< void* >( offsetof( Vertex, x ) ) );
+	glEnableVertexAttribArray( 1 );
+	glVertexAttribPointer( 1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof( Vertex ), reinterpret_cast< void* >( offsetof( Vertex, color ) ) );
+	glBindVertexArray( 0 );
+
+	if ( hasFont && !textRenderer.initGL() ) hasFont = false;
+	glReady = true;
+	return true;
+}
+
+void DebugDraw::shutdownGL() {
+	if ( !glReady ) return;
+	textRenderer.shutdownGL();
+	glDeleteBuffers( 1, &vbo );
+	glDeleteVertexArrays( 1, &vao );
+	glDeleteProgram( program );
+	program = vao = vbo = 0;
+	projectionLocation = -1;
+	glReady = false;
+}
+
+bool DebugDraw::loadFont( const std::string& path ) {
+	hasFont = textRenderer.loadFont( path );
+	if ( hasFont && glReady ) hasFont = textRenderer.initGL();
+	return hasFont;
+}
+
+void DebugDraw::setCamera( const b2Vec2& min, const b2Vec2& max, float pixelsPerMeter ) {
+	camera.lowerBound = min;
+	camera.upperBound = max;
+	this->pixelsPerMeter = std::max( pixelsPerMeter, 0.001f );
+}
+
+DebugDraw::ThreadBuffer& DebugDraw::getBuffer() {
+	if ( !threadBuffer ) {
+		// Keyed by thread index, so the workers of a restarted JobSystem reuse the slots of the ones they replace.
+		const size_t index = static_cast< size_t >( JobSystem::getThreadIndex() );
+		std::lock_guard<std::mutex> lock( buffersMutex );
+		if ( buffers.size() <= index ) buffers.resize( index + 1 );
+		if ( !buffers[ index ] ) buffers[ index ].reset( new ThreadBuffer() );
+		threadBuffer = buffers[ index ].get();
+	}
+	return *static_cast< ThreadBuffer* >( threadBuffer );
+}
+
+bool DebugDraw::isVisible( const b2Vec2& lower, const b2Vec2& upper, ThreadBuffer& buffer ) const {
+	if ( !culling ) return true;
+	if ( upper.x < camera.lowerBound.x || lower.x > camera.upperBound.x || upper.y < camera.lowerBound.y || lower.y > camera.upperBound.y ) {
+		buffer.culled++;
+		return false;
+	}
+	return true;
+}
+
+void DebugDraw::line( const b2Vec2& a, const b2Vec2& b, uint32_t color ) {
+	ThreadBuffer& buffer = getBuffer();
+	if ( !isVisible( b2Min( a, b ), b2Max( a, b ), buffer ) ) return;
+	buffer.lines.push_back( { a.x, a.y, color } );
+	buffer.lines.push_back( { b.x, b.y, color } );
+}
+
+void DebugDraw::aabb( const b2AABB& box, uint32_t color ) {
+	ThreadBuffer& buffer = getBuffer();
+	if ( !isVisible( box.lowerBound, box.upperBound, buffer ) ) return;
+	const b2Vec2 corners[ 4 ] = { box.lowerBound, b2Vec2( box.upperBound.x, box.lowerBound.y ), box.upperBound, b2Vec2( box.lowerBound.x, box.upperBound.y ) };
+	appendPolygon( corners, 4, color, false, buffer );
+}
+
+void DebugDraw::circle( const b2Vec2& center, float radius, uint32_t color ) {
+	ThreadBuffer& buffer = getBuffer();
+	const b2Vec2 extent( radius, radius );
+	if ( !isVisible( center - extent, center + extent, buffer ) ) return;
+	appendCircle( center, radius, color, false, buffer );
+}
+
+void DebugDraw::text( const std::string& label, const b2Vec2& position, float pixels, uint32_t color ) {
+	if ( !hasFont ) return;
+	ThreadBuffer& buffer = getBuffer();
+	if ( !isVisible( position, position, buffer ) ) return;
+	buffer.labels.push_back( { label, position, pixels, color } );
+}
+
+void DebugDraw::appendPolygon( const b2Vec2* vertices, int count, uint32_t color, bool solid, ThreadBuffer& buffer ) {
+	if ( solid ) {
+		const uint32_t fill = fillColor( color );
+		for ( int i = 1; i + 1 < count; i++ ) {
+			buffer.triangles.push_back( { vertices[ 0 ].x, vertices[ 0 ].y, fill } );
+			buffer.triangles.push_back( { vertices[ i ].x, vertices[ i ].y, fill } );
+			buffer.triangles.push_back( { vertices[ i + 1 ].x, vertices[ i + 1 ].y, fill } );
+		}
+	}
+	for ( int i = 0; i < count; i++ ) {
+		const b2Vec2& a = vertices[ i ];
+		const b2Vec2& b = vertices[ i + 1 < count ? i + 1 : 0 ];
+		buffer.lines.push_back( { a.x, a.y, color } );
+		buffer.lines.push_back( { b.x, b.y, color } );
+	}
+}
+
+void DebugDraw::appendCircle( const b2Vec2& center, float radius, uint32_t color, bool solid, ThreadBuffer& buffer ) {
+	// Roughly one segment per two pixels of radius, so distant small circles stay cheap.
+	const int segments = std::min( std::max( static_cast< int >( radius * pixelsPerMeter * 0.5f ), 6 ), 32 );
+	b2Vec2 points[ 32 ];
+	const float step = 2.0f * b2_pi / segments;
+	for ( int i = 0; i < segments; i++ ) points[ i ] = center + radius * b2Vec2( std::cos( step * i ), std::sin( step * i ) );
+	appendPolygon( points, segments, color, solid, buffer );
+}
+
+void DebugDraw::appendFixture( const b2Fixture& fixture, uint32_t color, ThreadBuffer& buffer ) {
+	const b2Transform& xf = fixture.GetBody()->GetTransform();
+	const b2Shape* shape = fixture.GetShape();
+	switch ( shape->GetType() ) {
+	case b2Shape::e_circle: {
+		const b2CircleShape* circleShape = static_cast< const b2CircleShape* >( shape );
+		const b2Vec2 center = b2Mul( xf, circleShape->m_p );
+		appendCircle( center, circleShape->m_radius, color, true, buffer );
+		const b2Vec2 axis = b2Mul( xf.q, b2Vec2( 1.0f, 0.0f ) );
+		line( center, center + circleShape->m_radius * axis, color );
+		break;
+	}
+	case b2Shape::e_polygon: {
+		const b2PolygonShape* polygon = static_cast< const b2PolygonShape* >( shape );
+		b2Vec2 vertices[ b2_maxPolygonVertices ];
+		for ( int32 i = 0; i < polygon->m_count; i++ ) vertices[ i ] = b2Mul( xf, polygon->m_vertices[ i ] );
+		appendPolygon( vertices, polygon->m_count, color, true, buffer );
+		break;
+	}
+	case b2Shape::e_edge: {
+		const b2EdgeShape* edge = static_cast< const b2EdgeShape* >( shape );
+		line( b2Mul( xf, edge->m_vertex1 ), b2Mul( xf, edge->m_vertex2 ), color );
+		break;
+	}
+	case b2Shape::e_chain: {
+		const b2ChainShape* chain = static_cast< const b2ChainShape* >( shape );
+		for ( int32 i = 0; i + 1 < chain->m_count; i++ ) line( b2Mul( xf, chain->m_vertices[ i ] ), b2Mul( xf, chain->m_vertices[ i + 1 ] ), color );
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+void DebugDraw::drawWorld( const b2World& world, uint32_t flags ) {
+	ThreadBuffer& buffer = getBuffer();
+	auto bodyColor = []( const b2Body& body ) {
+		if ( !body.IsEnabled() ) return packColor( b2Color( 0.5f, 0.5f, 0.3f ) );
+		if ( body.GetType() == b2_staticBody ) return packColor( b2Color( 0.5f, 0.9f, 0.5f ) );
+		if ( body.GetType() == b2_kinematicBody ) return packColor( b2Color( 0.5f, 0.5f, 0.9f ) );
+		if ( !body.IsAwake() ) return packColor( b2Color( 0.6f, 0.6f, 0.6f ) );
+		return packColor( b2Color( 0.9f, 0.7f, 0.7f ) );
+	};
+	const uint32_t aabbColor = packColor( b2Color( 0.9f, 0.3f, 0.9f ) );
+
+	auto drawFixture = [ this, &buffer, &bodyColor, flags, aabbColor ]( const b2Fixture& fixture ) {
+		if ( flags & e_shapeBit ) appendFixture( fixture, bodyColor( *fixture.GetBody() ), buffer );
+		if ( flags & e_aabbBit ) {
+			for ( int32 child = 0; child < fixture.GetShape()->GetChildCount(); child++ ) aabb( fixture.GetAABB( child ), aabbColor );
+		}
+	};
+
+	if ( !culling ) {
+		for ( const b2Body* body = world.GetBodyList(); body; body = body->GetNext() ) {
+			for ( const b2Fixture* fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext() ) drawFixture( *fixture );
+		}
+		return;
+	}
+
+	// The broadphase reports each proxy in view; a chain has one per edge, so those are drawn once.
+	struct Query : b2QueryCallback
+	{
+		std::vector<const b2Fixture*> fixtures;
+		bool ReportFixture( b2Fixture* fixture ) override {
+			if ( fixture->GetShape()->GetChildCount() > 1 && std::find( fixtures.begin(), fixtures.end(), fixture ) != fixtures.end() ) return true;
+			fixtures.push_back( fixture );
+			return true;
+		}
+	};
+	thread_local Query query;
+	query.fixtures.clear();
+	world.QueryAABB( &query, camera );
+	for ( const b2Fixture* fixture : query.fixtures ) drawFixture( *fixture );
+}
+
+void DebugDraw::flush() {
+	stats = DebugDrawStats();
+	size_t lineVertices = 0, triangleVertices = 0;
+	for ( const std::unique_ptr<ThreadBuffer>& buffer : buffers ) {
+		if ( !buffer ) continue;
+		lineVertices += buffer->lines.size();
+		triangleVertices += buffer->triangles.size();
+		stats.texts += static_cast< uint32_t >( buffer->labels.size() );
+		stats.culled += buffer->culled;
+		if ( !buffer->lines.empty() || !buffer->triangles.empty() || !buffer->labels.empty() ) stats.threads++;
+	}
+	stats.lines = static_cast< uint32_t >( lineVertices / 2 );
+	stats.triangles = static_cast< uint32_t >( triangleVertices / 3 );
+	stats.batches = ( lineVertices > 0 ) + ( triangleVertices > 0 ) + ( stats.texts > 0 );
+
+	const glm::mat4 projection = glm::ortho( camera.lowerBound.x, camera.upperBound.x, camera.lowerBound.y, camera.upperBound.y );
+	if ( glReady && ( lineVertices || triangleVertices ) ) {
+		// Triangles first, then lines, each thread's array copied straight into one buffer.
+		glBindVertexArray( vao );
+		glBindBuffer( GL_ARRAY_BUFFER, vbo );
+		glBufferData( GL_ARRAY_BUFFER, static_cast< GLsizeiptr >( ( lineVertices + triangleVertices ) * sizeof( Vertex ) ), nullptr, GL_STREAM_DRAW );
+		size_t offset = 0;
+		for ( int pass = 0; pass < 2; pass++ ) {
+			for ( const std::unique_ptr<ThreadBuffer>& buffer : buffers ) {
+				if ( !buffer ) continue;
+				const std::vector<Vertex>& vertices = pass == 0 ? buffer->triangles : buffer->lines;
+				if ( vertices.empty() ) continue;
+				glBufferSubData( GL_ARRAY_BUFFER, static_cast< GLintptr >( offset * sizeof( Vertex ) ),
+					static_cast< GLsizeiptr >( vertices.size() * sizeof( Vertex ) ), vertices.data() );
+				offset += vertices.size();
+			}
+		}
+		glUseProgram( program );
+		glUniformMatrix4fv( projectionLocation, 1, GL_FALSE, &projection[ 0 ][ 0 ] );
+		glEnable( GL_BLEND );
+		glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+		if ( triangleVertices ) {
+			glDrawArrays( GL_TRIANGLES, 0, static_cast< GLsizei >( triangleVertices ) );
+			stats.drawCalls++;
+		}
+		if ( lineVertices ) {
+			glDrawArrays( GL_LINES, static_cast< GLint >( triangleVertices ), static_cast< GLsizei >( lineVertices ) );
+			stats.drawCalls++;
+		}
+		glBindVertexArray( 0 );
+	}
+	if ( hasFont && stats.texts ) {
+		for ( const std::unique_ptr<ThreadBuffer>& buffer : buffers ) {
+		if ( !buffer ) continue;
+			for ( const Label& label : buffer->labels ) {
+				textRenderer.drawText( label.text, glm::vec2( label.position.x, label.position.y ), label.pixels / pixelsPerMeter, label.color );
+			}
+		}
+		textRenderer.render( projection ); // Discards the labels without GL.
+		stats.drawCalls += textRenderer.getStats().drawCalls;
+	}
+
+	for ( const std::unique_ptr<ThreadBuffer>& buffer : buffers ) {
+		if ( !buffer ) continue;
+		buffer->lines.clear();
+		buffer->triangles.clear();
+		buffer->labels.clear();
+		buffer->culled = 0;
+	}
+}
+
+void DebugDraw::DrawPolygon( const b2Vec2* vertices, int32 vertexCount, const b2Color& color ) {
+	ThreadBuffer& buffer = getBuffer();
+	b2AABB bounds = { vertices[ 0 ], vertices[ 0 ] };
+	for ( int32 i = 1; i < vertexCount; i++ ) {
+		bounds.lowerBound = b2Min( bounds.lowerBound, vertices[ i ] );
+		bounds.upperBound = b2Max( bounds.upperBound, vertices[ i ] );
+	}
+	if ( !isVisible( bounds.lowerBound, bounds.upperBound, buffer ) ) return;
+	appendPolygon( vertices, vertexCount, packColor( color ), false, buffer );
+}
+
+void DebugDraw::DrawSolidPolygon( const b2Vec2* vertices, int32 vertexCount, const b2Color& color ) {
+	ThreadBuffer& buffer = getBuffer();
+	b2AABB bounds = { vertices[ 0 ], vertices[ 0 ] };
+	for ( int32 i = 1; i < vertexCount; i++ ) {
+		bounds.lowerBound = b2Min( bounds.lowerBound, vertices[ i ] );
+		bounds.upperBound = b2Max( bounds.upperBound, vertices[ i ] );
+	}
+	if ( !isVisible( bounds.lowerBound, bounds.upperBound, buffer ) ) return;
+	appendPolygon( vertices, vertexCount, packColor( color ), true, buffer );
+}
+
+void DebugDraw::DrawCircle( const b2Vec2& center, float radius, const b2Color& color ) {
+	circle( center, radius, packColor( color ) );
+}
+
+void DebugDraw::DrawSolidCircle( const b2Vec2& center, float radius, const b2Vec2& axis, const b2Color& color ) {
+	ThreadBuffer& buffer = getBuffer();
+	const b2Vec2 extent( radius, radius );
+	if ( !isVisible( center - extent, center + extent, buffer ) ) return;
+	const uint32_t packed = packColor( color );
+	appendCircle( center, radius, packed, true, buffer );
+	buffer.lines.push_back( { center.x, center.y, packed } );
+	buffer.lines.push_back( { center.x + radius * axis.x, center.y + radius * axis.y, packed } );
+}
+
+void DebugDraw::DrawSegment( const b2Vec2& p1, const b2Vec2& p2, const b2Color& color ) {
+	line( p1, p2, packColor( color ) );
+}
+
+void DebugDraw::DrawTransform( const b2Transform& xf ) {
+	const float length = 0.4f;
+	line( xf.p, xf.p + length * xf.q.GetXAxis(), 0xFF0000FFu );
+	line( xf.p, xf.p + length * xf.q.GetYAxis(), 0xFF00FF00u );
+}
+
+void DebugDraw::DrawPoint( const b2Vec2& p, float size, const b2Color& color ) {
+	ThreadBuffer& buffer = getBuffer();
+	const float half = 0.5f * size / pixelsPerMeter; // Box2D passes the size in pixels.
+	const b2Vec2 extent( half, half );
+	if ( !isVisible( p - extent, p + extent, buffer ) ) return;
+	const uint32_t packed = packColor( color );
+	const Vertex corners[ 4 ] = { { p.x - half, p.y - half, packed }, { p.x + half, p.y - half, packed }, { p.x + half, p.y + half, packed },
+		{ p.x - half, p.y + half, packed } };
+	for ( int i : { 0, 1, 2, 2, 3, 0 } ) buffer.triangles.push_back( corners[ i ] );
+}
+
+#endif
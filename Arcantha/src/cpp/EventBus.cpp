@@ -0,0 +1,137 @@
+#include <algorithm> // Required for std::min and std::upper_bound.
+#include <atomic> // Required for the type index counter.
+#include <chrono> // Required for timing subscribers.
+
+#include "EventBus.h" // Includes the EventBus class definition.
+#include "JobSystem.h" // Includes JobSystem::getThreadIndex to order the thread buffers.
+#include "Log.h" // Includes the Logger for unregistered event types.
+
+EventBus EventBus::instance;
+
+static thread_local void* threadBuffer = nullptr; // The calling thread's ThreadBuffer, once registered.
+
+EventBus& EventBus::getInstance() {
+	return instance;
+}
+
+uint32_t EventBus::nextTypeIndex() {
+	static std::atomic<uint32_t> next{ 0 };
+	return next.fetch_add( 1 );
+}
+
+void EventBus::logUnregistered( const char* action, const char* typeName ) {
+	LOG_ERROR( "{} an unregistered event type {}; call registerType first. Reported once per type.", action, typeName );
+}
+
+EventBus::ThreadBuffer& EventBus::getBuffer() {
+	if ( !threadBuffer ) {
+		std::unique_ptr<ThreadBuffer> buffer( new ThreadBuffer() );
+		buffer->threadIndex = JobSystem::getThreadIndex();
+		threadBuffer = buffer.get();
+		std::lock_guard<std::mutex> lock( buffersMutex );
+		const auto position = std::upper_bound( buffers.begin(), buffers.end(), buffer->threadIndex,
+			[]( int index, const std::unique_ptr<ThreadBuffer>& other ) { return index < other->threadIndex; } );
+		buffers.insert( position, std::move( buffer ) );
+	}
+	return *static_cast< ThreadBuffer* >( threadBuffer );
+}
+
+bool EventBus::unsubscribe( SubscriberID id ) {
+	for ( std::vector<Subscriber>* list : { &subscribers, &added } ) {
+		for ( Subscriber& subscriber : *list ) {
+			if ( subscriber.id != id || !subscriber.active ) continue;
+			subscriber.active = false; // Removed after the current delivery, if any.
+			frameStats[ subscriber.type ].subscribers--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void EventBus::collect() {
+	for ( const std::unique_ptr<ThreadBuffer>& buffer : buffers ) {
+		for ( size_t type = 0; type < buffer->queues.size(); type++ ) {
+			QueueBase* queue = buffer->queues[ type ].get();
+			if ( !queue || queue->size() == 0 ) continue;
+			frameStats[ type ].posted += queue->size();
+			queue->moveTo( *channels[ type ].batch );
+		}
+	}
+}
+
+void EventBus::deliver( EventPhase phase ) {
+	auto begin = std::chrono::steady_clock::now();
+	collect();
+
+	// Subscribers may post, subscribe and unsubscribe: posts go to the thread buffers, which were just emptied,
+	// new subscribers wait in added, and removed ones are only flagged, so the list and batches stay put.
+	delivering = true;
+	for ( size_t i = 0; i < subscribers.size(); i++ ) {
+		Subscriber& subscriber = subscribers[ i ];
+		if ( !subscriber.active || subscriber.phase != phase ) continue;
+		const QueueBase& batch = *channels[ subscriber.type ].batch;
+		const size_t first = subscriber.cursor, count = batch.size() - first;
+		if ( count == 0 ) continue;
+		subscriber.cursor = batch.size();
+
+		auto callBegin = std::chrono::steady_clock::now();
+		subscriber.call( batch, first );
+		EventTypeStats& typeFrame = frameStats[ subscriber.type ];
+		typeFrame.deliverMs += std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - callBegin ).count();
+		typeFrame.delivered += count;
+		typeFrame.calls++;
+	}
+	delivering = false;
+
+	subscribers.erase( std::remove_if( subscribers.begin(), subscribers.end(), []( const Subscriber& s ) { return !s.active; } ), subscribers.end() );
+	for ( Subscriber& subscriber : added ) {
+		if ( subscriber.active ) subscribers.push_back( std::move( subscriber ) );
+	}
+	added.clear();
+
+	frameTotals.deliverMs += std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - begin ).count();
+}
+
+void EventBus::endFrame() {
+	// Keep only the events some subscriber has not been handed yet.
+	for ( size_t type = 0; type < channels.size(); type++ ) {
+		if ( !channels[ type ].batch ) continue;
+		size_t seen = channels[ type ].batch->size();
+		for ( const Subscriber& subscriber : subscribers ) {
+			if ( subscriber.type == type ) seen = std::min( seen, subscriber.cursor );
+		}
+		channels[ type ].batch->discard( seen );
+		for ( Subscriber& subscriber : subscribers ) {
+			if ( subscriber.type == type ) subscriber.cursor -= seen;
+		}
+	}
+
+	stats = EventBusStats();
+	stats.deliverMs = frameTotals.deliverMs;
+	stats.threads = static_cast< uint32_t >( buffers.size() );
+	for ( size_t type = 0; type < frameStats.size(); type++ ) {
+		EventTypeStats& frame = frameStats[ type ];
+		frame.totalPosted += frame.posted;
+		stats.posted += frame.posted;
+		stats.delivered += frame.delivered;
+		stats.calls += frame.calls;
+		typeStats[ type ] = frame;
+		frame.posted = 0;
+		frame.delivered = 0;
+		frame.calls = 0;
+		frame.deliverMs = 0.0;
+	}
+	frameTotals = EventBusStats();
+}
+
+void EventBus::clear() {
+	for ( const std::unique_ptr<ThreadBuffer>& buffer : buffers ) {
+		for ( const std::unique_ptr<QueueBase>& queue : buffer->queues ) {
+			if ( queue ) queue->clear();
+		}
+	}
+	for ( Channel& channel : channels ) {
+		if ( channel.batch ) channel.batch->clear();
+	}
+	for ( Subscriber& subscriber : subscribers ) subscriber.cursor = 0;
+}
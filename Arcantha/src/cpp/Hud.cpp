@@ -0,0 +1,457 @@
+#include <algorithm> // Required for std::min and std::max.
+#include <chrono> // Required for the CPU timing.
+#include <cmath> // Required for std::lround.
+#include <cstddef> // Required for offsetof.
+#include <utility> // Required for std::move.
+
+#include <glad/glad.h> // Includes GLAD for OpenGL function loading.
+#include <glm/gtc/matrix_transform.hpp> // Includes GLM for glm::ortho.
+
+#include "Hud.h" // Includes the Hud class definition.
+#include "Log.h" // Includes the Logger for error output.
+
+const uint16_t Hud::NO_PARENT;
+const uint32_t Hud::MAX_QUADS;
+const int Hud::GPU_QUERIES;
+
+static const char* HUD_VERTEX_SHADER = R"(#version 330 core
+layout( location = 0 ) in vec2 aPosition;
+layout( location = 1 ) in vec2 aTexCoord;
+layout( location = 2 ) in vec4 aColor;
+uniform mat4 uProjection;
+out vec2 vTexCoord;
+out vec4 vColor;
+void main() {
+	vTexCoord = aTexCoord;
+	vColor = aColor;
+	gl_Position = uProjection * vec4( aPosition, 0.0, 1.0 );
+}
+)";
+
+// Render targets hold premultiplied color; textured passes copy them as they are.
+static const char* HUD_FRAGMENT_SHADER = R"(#version 330 core
+in vec2 vTexCoord;
+in vec4 vColor;
+uniform sampler2D uTexture;
+uniform bool uTextured;
+out vec4 fragColor;
+void main() {
+	fragColor = uTextured ? texture( uTexture, vTexCoord ) : vec4( vColor.rgb * vColor.a, vColor.a );
+}
+)";
+
+static double elapsedMs( std::chrono::steady_clock::time_point since ) {
+	return std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - since ).count();
+}
+
+/**
+ * @brief Appends a quad.
+ * @param vertices The array.
+ * @param rect The rectangle.
+ * @param color RGBA8.
+ * @param u0 Left texture coordinate; the right one is u0 + uSize.
+ * @param v0 Bottom texture coordinate; the top one is v0 + vSize.
+ * @param uSize Texture width.
+ * @param vSize Texture height.
+ */
+static void appendQuad( std::vector<HudVertex>& vertices, const HudRect& rect, uint32_t color, float u0 = 0.0f, float v0 = 0.0f,
+	float uSize = 0.0f, float vSize = 0.0f ) {
+	const float x1 = rect.x + rect.width, y1 = rect.y + rect.height;
+	vertices.push_back( { rect.x, rect.y, u0, v0, color } );
+	vertices.push_back( { x1, rect.y, u0 + uSize, v0, color } );
+	vertices.push_back( { x1, y1, u0 + uSize, v0 + vSize, color } );
+	vertices.push_back( { rect.x, y1, u0, v0 + vSize, color } );
+}
+
+/**
+ * @brief Compiles one shader stage.
+ * @param type GL_VERTEX_SHADER or GL_FRAGMENT_SHADER.
+ * @param source GLSL source.
+ * @return The shader, or 0 on failure.
+ */
+static GLuint compileShader( GLenum type, const char* source ) {
+	GLuint shader = glCreateShader( type );
+	glShaderSource( shader, 1, &source, nullptr );
+	glCompileShader( shader );
+	GLint ok = 0;
+	glGetShaderiv( shader, GL_COMPILE_STATUS, &ok );
+	if ( !ok ) {
+		char log[ 512 ];
+		glGetShaderInfoLog( shader, sizeof( log ), nullptr, log );
+		LOG_ERROR( "HUD shader failed to compile: {}", log );
+		glDeleteShader( shader );
+		return 0;
+	}
+	return shader;
+}
+
+void HudPainter::fill( const HudRect& rect, uint32_t color ) {
+	appendQuad( vertices, rect, color );
+}
+
+bool Hud::loadFont( const std::string& path ) {
+	staticDirty = true;
+	return text.loadFont( path );
+}
+
+bool Hud::initGL( int width, int height ) {
+	if ( glReady ) return true;
+	this->width = std::max( width, 1 );
+	this->height = std::max( height, 1 );
+
+	GLuint vertexShader = compileShader( GL_VERTEX_SHADER, HUD_VERTEX_SHADER );
+	GLuint fragmentShader = compileShader( GL_FRAGMENT_SHADER, HUD_FRAGMENT_SHADER );
+	if ( !vertexShader || !fragmentShader ) {
+		if ( vertexShader ) glDeleteShader( vertexShader );
+		if ( fragmentShader ) glDeleteShader( fragmentShader );
+		return false;
+	}
+	program = glCreateProgram();
+	glAttachShader( program, vertexShader );
+	glAttachShader( program, fragmentShader );
+	glLinkProgram( program );
+	glDeleteShader( vertexShader );
+	glDeleteShader( fragmentShader );
+	GLint linked = 0;
+	glGetProgramiv( program, GL_LINK_STATUS, &linked );
+	if ( !linked ) {
+		LOG_ERROR( "HUD shader failed to link." );
+		glDeleteProgram( program );
+		program = 0;
+		return false;
+	}
+	projectionLocation = glGetUniformLocation( program, "uProjection" );
+	texturedLocation = glGetUniformLocation( program, "uTextured" );
+	glUseProgram( program );
+	glUniform1i( glGetUniformLocation( program, "uTexture" ), 0 );
+
+	std::vector<uint32_t> indices( static_cast< size_t >( MAX_QUADS ) * 6 );
+	for ( uint32_t quad = 0; quad < MAX_QUADS; quad++ ) {
+		const uint32_t base = quad * 4;
+		uint32_t* index = &indices[ quad * 6 ];
+		index[ 0 ] = base; index[ 1 ] = base + 1; index[ 2 ] = base + 2;
+		index[ 3 ] = base + 2; index[ 4 ] = base + 3; index[ 5 ] = base;
+	}
+	glGenVertexArrays( 1, &vao );
+	glGenBuffers( 1, &vbo );
+	glGenBuffers( 1, &ebo );
+	glBindVertexArray( vao );
+	glBindBuffer( GL_ARRAY_BUFFER, vbo );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, ebo );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, static_cast< GLsizeiptr >( indices.size() * sizeof( uint32_t ) ), indices.data(), GL_STATIC_DRAW );
+	glEnableVertexAttribArray( 0 );
+	glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, sizeof( HudVertex ), reinterpret_cast< void* >( offsetof( HudVertex, x ) ) );
+	glEnableVertexAttribArray( 1 );
+	glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, sizeof( HudVertex ), reinterpret_cast< void* >( offsetof( HudVertex, u ) ) );
+	glEnableVertexAttribArray( 2 );
+	glVertexAttribPointer( 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof( HudVertex ), reinterpret_cast< void* >( offsetof( HudVertex, color ) ) );
+	glBindVertexArray( 0 );
+
+	glGenQueries( GPU_QUERIES, queries );
+	glReady = true; // Set first so a failed target can be cleaned up by shutdownGL().
+	if ( !text.initGL() || !createTargets() ) {
+		shutdownGL();
+		return false;
+	}
+	staticDirty = true;
+	return true;
+}
+
+void Hud::shutdownGL() {
+	if ( !glReady ) return;
+	text.shutdownGL();
+	glDeleteQueries( GPU_QUERIES, queries );
+	glDeleteFramebuffers( 1, &hudFbo );
+	glDeleteFramebuffers( 1, &staticFbo );
+	glDeleteTextures( 1, &hudTexture );
+	glDeleteTextures( 1, &staticTexture );
+	glDeleteBuffers( 1, &ebo );
+	glDeleteBuffers( 1, &vbo );
+	glDeleteVertexArrays( 1, &vao );
+	glDeleteProgram( program );
+	program = vao = vbo = ebo = 0;
+	staticFbo = staticTexture = hudFbo = hudTexture = 0;
+	for ( int i = 0; i < GPU_QUERIES; i++ ) {
+		queries[ i ] = 0;
+		queryPending[ i ] = false;
+	}
+	glReady = false;
+}
+
+void Hud::resize( int width, int height ) {
+	width = std::max( width, 1 );
+	height = std::max( height, 1 );
+	if ( width == this->width && height == this->height ) return;
+	this->width = width;
+	this->height = height;
+	staticDirty = true;
+	if ( glReady ) createTargets();
+}
+
+bool Hud::createTargets() {
+	unsigned int* targets[ 2 ][ 2 ] = { { &staticFbo, &staticTexture }, { &hudFbo, &hudTexture } };
+	for ( auto& target : targets ) {
+		if ( !*target[ 0 ] ) glGenFramebuffers( 1, target[ 0 ] );
+		if ( !*target[ 1 ] ) glGenTextures( 1, target[ 1 ] );
+		glBindTexture( GL_TEXTURE_2D, *target[ 1 ] );
+		glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+		GLint previous = 0;
+		glGetIntegerv( GL_FRAMEBUFFER_BINDING, &previous );
+		glBindFramebuffer( GL_FRAMEBUFFER, *target[ 0 ] );
+		glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *target[ 1 ], 0 );
+		const bool complete = glCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE;
+		glBindFramebuffer( GL_FRAMEBUFFER, static_cast< GLuint >( previous ) );
+		if ( !complete ) {
+			LOG_ERROR( "HUD render target is incomplete." );
+			return false;
+		}
+	}
+	return true;
+}
+
+Hud::Widget& Hud::addWidget( HudWidgetType type, uint16_t parent, const HudRect& rect ) {
+	Widget widget{};
+	widget.type = type;
+	widget.parent = parent < widgets.size() ? parent : NO_PARENT;
+	widget.rect = rect;
+	if ( widget.parent != NO_PARENT ) {
+		widget.rect.x += widgets[ parent ].rect.x;
+		widget.rect.y += widgets[ parent ].rect.y;
+	}
+	widget.dirty = true;
+	widgets.push_back( std::move( widget ) );
+	return widgets.back();
+}
+
+uint16_t Hud::addPanel( uint16_t parent, const HudRect& rect, uint32_t color, uint32_t borderColor ) {
+	Widget& widget = addWidget( HudWidgetType::Panel, parent, rect );
+	widget.color = color;
+	widget.secondColor = borderColor;
+	staticDirty = true;
+	return static_cast< uint16_t >( widgets.size() - 1 );
+}
+
+uint16_t Hud::addBar( uint16_t parent, const HudRect& rect, uint32_t fillColor, uint32_t backColor ) {
+	Widget& widget = addWidget( HudWidgetType::Bar, parent, rect );
+	widget.color = fillColor;
+	widget.secondColor = backColor;
+	widget.fillPixels = static_cast< int >( rect.width );
+	return static_cast< uint16_t >( widgets.size() - 1 );
+}
+
+uint16_t Hud::addCounter( uint16_t parent, const HudRect& rect, const std::string& label, uint32_t color ) {
+	Widget& widget = addWidget( HudWidgetType::Counter, parent, rect );
+	widget.color = color;
+	widget.label = label;
+	widget.text = label + "0";
+	return static_cast< uint16_t >( widgets.size() - 1 );
+}
+
+uint16_t Hud::addCanvas( uint16_t parent, const HudRect& rect, HudPaint paint ) {
+	Widget& widget = addWidget( HudWidgetType::Canvas, parent, rect );
+	widget.paint = std::move( paint );
+	return static_cast< uint16_t >( widgets.size() - 1 );
+}
+
+void Hud::setBar( uint16_t widget, float value, float maximum ) {
+	Widget& bar = widgets[ widget ];
+	const float fraction = maximum > 0.0f ? std::min( std::max( value / maximum, 0.0f ), 1.0f ) : 0.0f;
+	const int pixels = static_cast< int >( std::lround( fraction * bar.rect.width ) );
+	if ( pixels == bar.fillPixels ) return;
+	bar.fillPixels = pixels;
+	bar.dirty = true;
+}
+
+void Hud::setCounter( uint16_t widget, int64_t value ) {
+	Widget& counter = widgets[ widget ];
+	if ( value == counter.value ) return;
+	counter.value = value;
+	counter.text = counter.label + std::to_string( value );
+	counter.dirty = true;
+}
+
+void Hud::invalidate( uint16_t widget ) {
+	if ( widget >= widgets.size() ) return;
+	if ( widgets[ widget ].type == HudWidgetType::Panel ) staticDirty = true;
+	else widgets[ widget ].dirty = true;
+}
+
+void Hud::buildWidget( Widget& widget ) {
+	switch ( widget.type ) {
+	case HudWidgetType::Panel:
+		break;
+	case HudWidgetType::Bar: {
+		appendQuad( widgetVertices, widget.rect, widget.secondColor );
+		HudRect fill = widget.rect;
+		fill.width = static_cast< float >( widget.fillPixels );
+		if ( fill.width > 0.0f ) appendQuad( widgetVertices, fill, widget.color );
+		break;
+	}
+	case HudWidgetType::Counter: {
+		// Baseline a quarter up the rectangle leaves room for descenders. Text too long for the rectangle is
+		// scaled down to fit, since a redraw only restores the rectangle and would leave the overhang behind.
+		float size = widget.rect.height * 0.75f;
+		const float textWidth = text.measure( widget.text, size );
+		if ( textWidth > widget.rect.width ) size *= widget.rect.width / textWidth;
+		text.drawText( widget.text, glm::vec2( widget.rect.x, widget.rect.y + widget.rect.height * 0.25f ), size, widget.color );
+		break;
+	}
+	case HudWidgetType::Canvas:
+		if ( widget.paint ) {
+			HudPainter painter( widgetVertices );
+			widget.paint( painter, widget.rect );
+		}
+		break;
+	}
+	widget.dirty = false;
+}
+
+void Hud::render() {
+	const auto start = std::chrono::steady_clock::now();
+	stats.widgetsRedrawn = 0;
+	stats.quads = 0;
+	stats.drawCalls = 0;
+	if ( immediateMode ) staticDirty = true;
+
+	// Rebuild the static layer when a panel changed; everything on top of it is then redrawn.
+	const bool rebuildStatic = staticDirty;
+	if ( rebuildStatic ) {
+		staticVertices.clear();
+		for ( Widget& widget : widgets ) {
+			widget.dirty = widget.type != HudWidgetType::Panel;
+			if ( widget.type != HudWidgetType::Panel ) continue;
+			if ( widget.secondColor ) {
+				appendQuad( staticVertices, widget.rect, widget.secondColor );
+				const HudRect inner = { widget.rect.x + 1.0f, widget.rect.y + 1.0f, widget.rect.width - 2.0f, widget.rect.height - 2.0f };
+				appendQuad( staticVertices, inner, widget.color );
+			}
+			else {
+				appendQuad( staticVertices, widget.rect, widget.color );
+			}
+		}
+		stats.staticRedraws++;
+		staticDirty = false;
+	}
+
+	// A redrawn widget's rectangle is restored from the static layer, so clean widgets it overlaps are redrawn too.
+	redraw.clear();
+	for ( size_t i = 0; i < widgets.size(); i++ ) {
+		if ( widgets[ i ].dirty ) redraw.push_back( static_cast< uint16_t >( i ) );
+	}
+	if ( !rebuildStatic ) {
+		for ( size_t next = 0; next < redraw.size(); next++ ) {
+			const HudRect rect = widgets[ redraw[ next ] ].rect;
+			for ( size_t i = 0; i < widgets.size(); i++ ) {
+				Widget& other = widgets[ i ];
+				if ( other.dirty || other.type == HudWidgetType::Panel || !other.rect.overlaps( rect ) ) continue;
+				other.dirty = true;
+				redraw.push_back( static_cast< uint16_t >( i ) );
+			}
+		}
+	}
+
+	restoreVertices.clear();
+	widgetVertices.clear();
+	if ( rebuildStatic ) {
+		appendQuad( restoreVertices, { 0.0f, 0.0f, static_cast< float >( width ), static_cast< float >( height ) }, 0xFFFFFFFFu, 0.0f, 0.0f, 1.0f, 1.0f );
+	}
+	else {
+		const float texelU = 1.0f / std::max( width, 1 ), texelV = 1.0f / std::max( height, 1 );
+		for ( uint16_t index : redraw ) {
+			const HudRect& rect = widgets[ index ].rect;
+			appendQuad( restoreVertices, rect, 0xFFFFFFFFu, rect.x * texelU, rect.y * texelV, rect.width * texelU, rect.height * texelV );
+		}
+	}
+	for ( uint16_t index : redraw ) buildWidget( widgets[ index ] );
+	stats.widgetsRedrawn = static_cast< uint32_t >( redraw.size() );
+	stats.quads = static_cast< uint32_t >( ( ( rebuildStatic ? staticVertices.size() : 0 ) + widgetVertices.size() + text.getVertices().size() ) / 4 );
+
+	if ( !glReady ) {
+		text.render( glm::mat4( 1.0f ) ); // Discards the queued text.
+		stats.cpuMs = elapsedMs( start );
+		return;
+	}
+
+	// Read a timer query issued a few frames ago if it is done, then time this frame's passes with it.
+	const int slot = queryIndex;
+	bool timing = true;
+	if ( queryPending[ slot ] ) {
+		GLint available = 0;
+		glGetQueryObjectiv( queries[ slot ], GL_QUERY_RESULT_AVAILABLE, &available );
+		if ( available ) {
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v( queries[ slot ], GL_QUERY_RESULT, &nanoseconds );
+			stats.gpuMs = static_cast< double >( nanoseconds ) / 1e6;
+			queryPending[ slot ] = false;
+		}
+		else {
+			timing = false;
+		}
+	}
+	if ( timing ) glBeginQuery( GL_TIME_ELAPSED, queries[ slot ] );
+
+	GLint screenFbo = 0, viewport[ 4 ];
+	glGetIntegerv( GL_FRAMEBUFFER_BINDING, &screenFbo );
+	glGetIntegerv( GL_VIEWPORT, viewport );
+	const glm::mat4 projection = glm::ortho( 0.0f, static_cast< float >( width ), 0.0f, static_cast< float >( height ) );
+	glUseProgram( program );
+	glUniformMatrix4fv( projectionLocation, 1, GL_FALSE, &projection[ 0 ][ 0 ] );
+	glViewport( 0, 0, width, height );
+	glEnable( GL_BLEND );
+	glBlendFunc( GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
+
+	if ( rebuildStatic ) {
+		glBindFramebuffer( GL_FRAMEBUFFER, staticFbo );
+		glClearColor( 0.0f, 0.0f, 0.0f, 0.0f );
+		glClear( GL_COLOR_BUFFER_BIT );
+		draw( staticVertices, 0 );
+	}
+	if ( !redraw.empty() ) {
+		glBindFramebuffer( GL_FRAMEBUFFER, hudFbo );
+		glDisable( GL_BLEND ); // The copy replaces what was there.
+		draw( restoreVertices, staticTexture );
+		glEnable( GL_BLEND );
+		glBlendFunc( GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
+		draw( widgetVertices, 0 );
+		text.render( projection );
+		stats.drawCalls += text.getStats().drawCalls;
+	}
+
+	// Composite the cached HUD over the scene.
+	glBindFramebuffer( GL_FRAMEBUFFER, static_cast< GLuint >( screenFbo ) );
+	glViewport( viewport[ 0 ], viewport[ 1 ], viewport[ 2 ], viewport[ 3 ] );
+	glUseProgram( program );
+	glUniformMatrix4fv( projectionLocation, 1, GL_FALSE, &projection[ 0 ][ 0 ] );
+	glEnable( GL_BLEND );
+	glBlendFunc( GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
+	restoreVertices.clear();
+	appendQuad( restoreVertices, { 0.0f, 0.0f, static_cast< float >( width ), static_cast< float >( height ) }, 0xFFFFFFFFu, 0.0f, 0.0f, 1.0f, 1.0f );
+	draw( restoreVertices, hudTexture );
+
+	if ( timing ) {
+		glEndQuery( GL_TIME_ELAPSED );
+		queryPending[ slot ] = true;
+		queryIndex = ( slot + 1 ) % GPU_QUERIES;
+	}
+	stats.cpuMs = elapsedMs( start );
+}
+
+void Hud::draw( const std::vector<HudVertex>& vertices, unsigned int texture ) {
+	const size_t quads = std::min( vertices.size() / 4, static_cast< size_t >( MAX_QUADS ) );
+	if ( !quads ) return;
+	glUniform1i( texturedLocation, texture ? 1 : 0 );
+	glActiveTexture( GL_TEXTURE0 );
+	glBindTexture( GL_TEXTURE_2D, texture );
+	glBindVertexArray( vao );
+	glBindBuffer( GL_ARRAY_BUFFER, vbo );
+	const GLsizeiptr bytes = static_cast< GLsizeiptr >( quads * 4 * sizeof( HudVertex ) );
+	glBufferData( GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW );
+	glBufferSubData( GL_ARRAY_BUFFER, 0, bytes, vertices.data() );
+	glDrawElements( GL_TRIANGLES, static_cast< GLsizei >( quads * 6 ), GL_UNSIGNED_INT, nullptr );
+	glBindVertexArray( 0 );
+	stats.drawCalls++;
+}
@@ -0,0 +1,141 @@
+#include <algorithm> // Required for std::min.
+#include <memory> // Required for std::shared_ptr to share parallelFor state with workers.
+
+#include "JobSystem.h" // Includes the JobSystem class definition.
+
+JobSystem JobSystem::instance; // Definition and initialization of the static singleton instance.
+
+static thread_local int threadIndex = 0; // 0 for the main thread and any other non-worker thread.
+
+JobSystem& JobSystem::getInstance() {
+	return instance;
+}
+
+JobSystem::~JobSystem() {
+	shutdown();
+}
+
+void JobSystem::init( int workerCount ) {
+	if ( !workers.empty() ) return;
+
+	if ( workerCount < 0 ) {
+		int hardware = static_cast< int >( std::thread::hardware_concurrency() );
+		workerCount = hardware > 1 ? hardware - 1 : 0;
+	}
+
+	running = true;
+	for ( int i = 0; i < workerCount; i++ ) {
+		workers.emplace_back( &JobSystem::workerLoop, this, i + 1 );
+	}
+}
+
+void JobSystem::shutdown() {
+	{
+		std::lock_guard<std::mutex> lock( queueMutex );
+		running = false;
+	}
+	queueCondition.notify_all();
+
+	for ( std::thread& worker : workers ) worker.join();
+	workers.clear();
+
+	// Anything queued after the workers left still has to run.
+	while ( runOne() ) {}
+}
+
+int JobSystem::getThreadIndex() {
+	return threadIndex;
+}
+
+void JobSystem::submit( std::function<void()> job, JobCounter* counter ) {
+	if ( counter ) counter->pending.fetch_add( 1, std::memory_order_relaxed );
+
+	if ( workers.empty() ) {
+		Job inlineJob{ std::move( job ), counter };
+		execute( inlineJob );
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( queueMutex );
+		queue.push_back( { std::move( job ), counter } );
+	}
+	queueCondition.notify_one();
+}
+
+void JobSystem::wait( JobCounter& counter ) {
+	while ( counter.pending.load( std::memory_order_acquire ) > 0 ) {
+		if ( !runOne( &counter ) ) std::this_thread::yield();
+	}
+}
+
+void JobSystem::parallelFor( size_t count, size_t grain, const std::function<void( size_t, size_t )>& func ) {
+	if ( count == 0 ) return;
+	if ( grain == 0 ) grain = 1;
+
+	const size_t chunks = ( count + grain - 1 ) / grain;
+	if ( chunks == 1 || workers.empty() ) {
+		for ( size_t begin = 0; begin < count; begin += grain ) func( begin, std::min( begin + grain, count ) );
+		return;
+	}
+
+	// Workers and the caller pull chunks from a shared cursor until none are left. A helper that starts after
+	// the last chunk was taken finds the cursor past the end and never touches func, so only chunks are waited on.
+	struct State
+	{
+		std::atomic<size_t> next{ 0 };
+		std::atomic<size_t> finished{ 0 };
+	};
+	auto state = std::make_shared<State>();
+	auto drain = [ state, count, grain, chunks, &func ]() {
+		for ( size_t chunk = state->next.fetch_add( 1 ); chunk < chunks; chunk = state->next.fetch_add( 1 ) ) {
+			size_t begin = chunk * grain;
+			func( begin, std::min( begin + grain, count ) );
+			state->finished.fetch_add( 1, std::memory_order_release );
+		}
+	};
+
+	const size_t helpers = std::min( chunks - 1, workers.size() );
+	for ( size_t i = 0; i < helpers; i++ ) submit( drain );
+
+	// Every chunk not finished yet is running on a worker, so there is nothing to help with.
+	drain();
+	while ( state->finished.load( std::memory_order_acquire ) < chunks ) std::this_thread::yield();
+}
+
+bool JobSystem::runOne( const JobCounter* counter ) {
+	Job job;
+	{
+		std::lock_guard<std::mutex> lock( queueMutex );
+		auto found = queue.begin();
+		while ( counter && found != queue.end() && found->counter != counter ) ++found;
+		if ( found == queue.end() ) return false;
+		job = std::move( *found );
+		queue.erase( found );
+	}
+
+	execute( job );
+	return true;
+}
+
+void JobSystem::execute( Job& job ) {
+	job.func();
+	if ( job.counter ) job.counter->pending.fetch_sub( 1, std::memory_order_release );
+}
+
+void JobSystem::workerLoop( int index ) {
+	threadIndex = index;
+
+	while ( true ) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock( queueMutex );
+			queueCondition.wait( lock, [ this ]() { return !running || !queue.empty(); } );
+			if ( queue.empty() ) return; // Only reached once shutdown was requested.
+			job = std::move( queue.front() );
+			queue.pop_front();
+		}
+
+		execute( job );
+	}
+}
@@ -0,0 +1,411 @@
+#include <algorithm> // Required for std::max and std::min.
+#include <chrono> // Required for the stage timings.
+#include <cstdlib> // Required for std::abs.
+
+#include "LevelGenerator.h" // Includes the LevelGenerator class definition.
+#include "Random.h" // Includes the seeded generator every work item draws from.
+
+// Every work item gets its own stream, so results do not depend on which thread ran it.
+static const uint64_t STREAM_LAYOUT = 0;
+static const uint64_t STREAM_STITCH = 1ull << 20;
+static const uint64_t STREAM_DECORATE = 2ull << 20;
+static const uint64_t STREAM_POPULATE = 3ull << 20;
+
+static const int RW = Level::ROOM_WIDTH;
+static const int RH = Level::ROOM_HEIGHT;
+static const int DOOR_HEIGHT = 4; // Side doors span rows 1..DOOR_HEIGHT above the floor.
+static const int HATCH_X = RW / 2 - 2; // First column of the 4 wide floor and ceiling openings.
+
+/**
+ * @brief A rectangle of tiles a room template places inside the room, in room-local tiles.
+ */
+struct RoomFeature
+{
+	int x, y, w, h;
+	Tile tile;
+};
+
+/**
+ * @brief A hand-authored room interior; walls, doors and stairs are added around it when stitching.
+ *
+ * Solid steps on the floor are at most two tiles high and one-way platforms at most
+ * three rows apart, so a grunt can always cross the room.
+ */
+struct RoomTemplate
+{
+	const char* name;
+	std::vector<RoomFeature> features;
+};
+
+static const RoomTemplate TEMPLATES[] = {
+	{ "hall", { { 6, 5, 6, 1, Tile::Platform }, { 20, 5, 6, 1, Tile::Platform } } },
+	{ "pillars", { { 8, 1, 2, 2, Tile::Solid }, { 15, 1, 2, 2, Tile::Solid }, { 22, 1, 2, 2, Tile::Solid },
+		{ 5, 5, 6, 1, Tile::Platform }, { 21, 5, 6, 1, Tile::Platform } } },
+	{ "ledges", { { 4, 1, 7, 2, Tile::Solid }, { 20, 1, 8, 2, Tile::Solid }, { 11, 7, 8, 1, Tile::Platform },
+		{ 3, 10, 6, 1, Tile::Platform } } },
+	{ "canopy", { { 4, 4, 8, 1, Tile::Platform }, { 20, 4, 8, 1, Tile::Platform }, { 12, 8, 8, 1, Tile::Platform },
+		{ 4, 12, 6, 1, Tile::Platform }, { 22, 12, 6, 1, Tile::Platform } } },
+	{ "dip", { { 4, 1, 8, 2, Tile::Solid }, { 20, 1, 8, 2, Tile::Solid }, { 12, 5, 8, 1, Tile::Platform } } },
+	{ "towers", { { 5, 1, 4, 2, Tile::Solid }, { 23, 1, 4, 2, Tile::Solid }, { 9, 5, 4, 1, Tile::Platform },
+		{ 19, 5, 4, 1, Tile::Platform }, { 13, 8, 6, 1, Tile::Platform } } },
+	{ "arena", { { 3, 5, 5, 1, Tile::Platform }, { 24, 5, 5, 1, Tile::Platform }, { 10, 9, 12, 1, Tile::Platform },
+		{ 3, 13, 5, 1, Tile::Platform }, { 24, 13, 5, 1, Tile::Platform } } },
+	{ "shaft", { { 2, 4, 7, 1, Tile::Platform }, { 23, 7, 7, 1, Tile::Platform }, { 2, 10, 7, 1, Tile::Platform },
+		{ 23, 13, 7, 1, Tile::Platform } } }
+};
+static const int TEMPLATE_HALL = 0, TEMPLATE_PILLARS = 1, TEMPLATE_ARENA = 6, TEMPLATE_SHAFT = 7;
+static const int GENERIC_TEMPLATES = 6; // Templates 0..5 fit any ordinary room.
+
+/**
+ * @brief One candidate room graph produced by the layout stage.
+ */
+struct Layout
+{
+	std::vector<LevelRoom> rooms;
+	std::vector<int16_t> cellToRoom;
+	int mainPath = 0; // The first mainPath rooms form the path from the start to the boss.
+	int score = 0;
+};
+
+static double elapsedMs( std::chrono::steady_clock::time_point since ) {
+	return std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - since ).count();
+}
+
+static bool isStandable( const TileMap& map, int x, int y ) {
+	const Tile below = map.get( x, y - 1 );
+	return map.get( x, y ) == Tile::Empty && map.get( x, y + 1 ) == Tile::Empty &&
+		( below == Tile::Solid || below == Tile::Platform );
+}
+
+// Stage 1: a random walk from the start room forms the main path, then short branches grow off it.
+static Layout buildLayout( const LevelSettings& settings, Random random ) {
+	Layout layout;
+	const int gw = settings.gridWidth, gh = settings.gridHeight;
+	layout.cellToRoom.assign( static_cast< size_t >( gw ) * gh, -1 );
+
+	const glm::ivec2 steps[] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+	const uint8_t doorOut[] = { DOOR_LEFT, DOOR_RIGHT, DOOR_DOWN, DOOR_UP };
+	const uint8_t doorIn[] = { DOOR_RIGHT, DOOR_LEFT, DOOR_UP, DOOR_DOWN };
+	const int weights[] = { 3, 3, 1, 1 }; // Favour horizontal runs; vertical links become shafts.
+
+	auto addRoom = [ & ]( glm::ivec2 cell ) {
+		layout.cellToRoom[ static_cast< size_t >( cell.y ) * gw + cell.x ] = static_cast< int16_t >( layout.rooms.size() );
+		layout.rooms.push_back( { cell, RoomKind::Normal, 0, 0, 0, false } );
+		return static_cast< int >( layout.rooms.size() ) - 1;
+	};
+	// Grows one room off `from` in a random free direction; returns the new room or -1 if boxed in.
+	auto grow = [ & ]( int from ) {
+		const glm::ivec2 cell = layout.rooms[ from ].cell;
+		int total = 0, options[ 4 ], count = 0;
+		for ( int d = 0; d < 4; d++ ) {
+			const glm::ivec2 next = cell + steps[ d ];
+			if ( next.x < 0 || next.y < 0 || next.x >= gw || next.y >= gh ) continue;
+			if ( layout.cellToRoom[ static_cast< size_t >( next.y ) * gw + next.x ] >= 0 ) continue;
+			options[ count++ ] = d;
+			total += weights[ d ];
+		}
+		if ( count == 0 ) return -1;
+
+		int roll = random.range( 0, total - 1 ), pick = 0;
+		while ( roll >= weights[ options[ pick ] ] ) roll -= weights[ options[ pick++ ] ];
+		const int d = options[ pick ];
+		const int room = addRoom( cell + steps[ d ] );
+		layout.rooms[ from ].doors |= doorOut[ d ];
+		layout.rooms[ room ].doors |= doorIn[ d ];
+		return room;
+	};
+
+	int current = addRoom( glm::ivec2( random.range( 0, gw - 1 ), random.range( 0, gh - 1 ) ) );
+	for ( int i = 1; i < settings.mainPathLength; i++ ) {
+		const int next = grow( current );
+		if ( next < 0 ) break;
+		current = next;
+	}
+	layout.mainPath = static_cast< int >( layout.rooms.size() );
+
+	std::vector<int> branchEnds;
+	if ( layout.mainPath >= 3 ) {
+		for ( int b = 0; b < settings.branchCount; b++ ) {
+			int from = random.range( 1, layout.mainPath - 2 );
+			const int length = random.range( 1, 3 );
+			int end = -1;
+			for ( int i = 0; i < length; i++ ) {
+				const int next = grow( from );
+				if ( next < 0 ) break;
+				from = end = next;
+			}
+			if ( end >= 0 ) branchEnds.push_back( end );
+		}
+	}
+
+	// Room kinds: the walk decides the start, boss and treasure rooms; doors decide shafts.
+	for ( int i = 0; i < static_cast< int >( layout.rooms.size() ); i++ ) {
+		LevelRoom& room = layout.rooms[ i ];
+		const bool vertical = ( room.doors & DOOR_UP ) && ( room.doors & DOOR_DOWN );
+		if ( vertical ) room.kind = RoomKind::Shaft;
+		else if ( random.range( 0, 99 ) < 20 ) room.kind = RoomKind::Arena;
+	}
+	for ( int end : branchEnds ) layout.rooms[ end ].kind = RoomKind::Treasure;
+	layout.rooms.front().kind = RoomKind::Start;
+	if ( layout.mainPath > 1 ) layout.rooms[ layout.mainPath - 1 ].kind = RoomKind::Boss;
+
+	// Depth by breadth-first search through the doors.
+	std::vector<int> queue( 1, 0 );
+	std::vector<bool> seen( layout.rooms.size(), false );
+	seen[ 0 ] = true;
+	for ( size_t head = 0; head < queue.size(); head++ ) {
+		const LevelRoom& room = layout.rooms[ queue[ head ] ];
+		for ( int d = 0; d < 4; d++ ) {
+			if ( !( room.doors & doorOut[ d ] ) ) continue;
+			const glm::ivec2 next = room.cell + steps[ d ];
+			const int index = layout.cellToRoom[ static_cast< size_t >( next.y ) * gw + next.x ];
+			if ( seen[ index ] ) continue;
+			seen[ index ] = true;
+			layout.rooms[ index ].depth = static_cast< uint16_t >( room.depth + 1 );
+			queue.push_back( index );
+		}
+	}
+
+	int verticalLinks = 0;
+	for ( const LevelRoom& room : layout.rooms ) verticalLinks += ( room.doors & DOOR_UP ) ? 1 : 0;
+	layout.score = layout.mainPath * 100 + static_cast< int >( layout.rooms.size() ) * 10 + std::min( verticalLinks, 6 ) * 5;
+	return layout;
+}
+
+// Stage 2: walls and doors around a template, plus stairs up to a ceiling hatch.
+static void stitchRoom( Level& level, int index, Random random ) {
+	LevelRoom& room = level.rooms[ index ];
+	TileMap& map = level.map;
+	const int x0 = room.cell.x * RW, y0 = room.cell.y * RH;
+
+	switch ( room.kind ) {
+	case RoomKind::Start: room.templateIndex = TEMPLATE_HALL; break;
+	case RoomKind::Shaft: room.templateIndex = TEMPLATE_SHAFT; break;
+	case RoomKind::Arena:
+	case RoomKind::Boss: room.templateIndex = static_cast< uint16_t >( random.range( 0, 1 ) ? TEMPLATE_ARENA : TEMPLATE_PILLARS ); break;
+	default: room.templateIndex = static_cast< uint16_t >( random.range( 0, GENERIC_TEMPLATES - 1 ) ); break;
+	}
+	room.mirrored = random.range( 0, 1 ) == 1;
+
+	map.fill( x0 + 1, y0 + 1, RW - 2, RH - 2, Tile::Empty );
+	for ( const RoomFeature& feature : TEMPLATES[ room.templateIndex ].features ) {
+		const int x = room.mirrored ? RW - feature.x - feature.w : feature.x;
+		map.fill( x0 + x, y0 + feature.y, feature.w, feature.h, feature.tile );
+	}
+
+	// Side doors, with a little clear floor inside so the way in is never walled off by the template.
+	if ( room.doors & DOOR_LEFT ) map.fill( x0, y0 + 1, 4, DOOR_HEIGHT, Tile::Empty );
+	if ( room.doors & DOOR_RIGHT ) map.fill( x0 + RW - 4, y0 + 1, 4, DOOR_HEIGHT, Tile::Empty );
+	// A one-way hatch in the floor: stand on it, or drop through to the room below.
+	if ( room.doors & DOOR_DOWN ) {
+		map.fill( x0 + HATCH_X, y0, 4, 1, Tile::Platform );
+		map.fill( x0 + HATCH_X, y0 + 1, 4, 2, Tile::Empty );
+	}
+	// An opening in the ceiling, reached by one-way stairs three rows apart (a grunt's jump height).
+	if ( room.doors & DOOR_UP ) {
+		map.fill( x0 + HATCH_X, y0 + RH - 2, 4, 2, Tile::Empty );
+		const TileRect stairs[] = { { HATCH_X - 4, 3, 6, 1 }, { HATCH_X + 3, 6, 6, 1 }, { HATCH_X - 4, 9, 6, 1 },
+			{ HATCH_X + 3, 12, 6, 1 }, { HATCH_X, 15, 4, 1 } };
+		for ( const TileRect& stair : stairs ) {
+			const int x = room.mirrored ? RW - stair.x - stair.w : stair.x;
+			map.fill( x0 + x, y0 + stair.y + 1, stair.w, std::min( 2, RH - 2 - stair.y ), Tile::Empty );
+			map.fill( x0 + x, y0 + stair.y, stair.w, 1, Tile::Platform );
+		}
+	}
+}
+
+// Stage 3: visual dressing, chosen from the finished geometry of the room and its borders.
+static void decorateRoom( Level& level, int index, Random random ) {
+	const LevelRoom& room = level.rooms[ index ];
+	const TileMap& map = level.map;
+	const int x0 = room.cell.x * RW, y0 = room.cell.y * RH;
+	const bool fight = room.kind == RoomKind::Arena || room.kind == RoomKind::Boss;
+
+	for ( int y = y0; y < y0 + RH; y++ ) {
+		for ( int x = x0; x < x0 + RW; x++ ) {
+			const Tile tile = map.get( x, y );
+			Decoration decoration = Decoration::None;
+
+			if ( tile == Tile::Solid ) {
+				const bool exposed = map.get( x - 1, y ) == Tile::Empty || map.get( x + 1, y ) == Tile::Empty ||
+					map.get( x, y - 1 ) == Tile::Empty || map.get( x, y + 1 ) == Tile::Empty;
+				if ( exposed && random.range( 0, 99 ) < 12 ) decoration = Decoration::Moss;
+			}
+			else if ( tile == Tile::Empty ) {
+				const int roll = random.range( 0, 99 );
+				if ( map.get( x, y - 1 ) == Tile::Solid ) {
+					if ( room.kind == RoomKind::Treasure && roll < 15 ) decoration = Decoration::Crystal;
+					else if ( roll < ( fight ? 8 : 3 ) ) decoration = Decoration::Torch;
+					else if ( roll < 45 ) decoration = Decoration::Grass;
+				}
+				else if ( map.get( x, y + 1 ) == Tile::Solid ) {
+					if ( roll < 10 ) decoration = Decoration::Stalactite;
+					else if ( roll < 28 ) decoration = Decoration::Vines;
+				}
+			}
+			level.decorations[ static_cast< size_t >( y ) * map.getWidth() + x ] = decoration;
+		}
+	}
+}
+
+// Stage 4: enemy spawns on free tiles, spaced apart and away from the side doors.
+static void populateRoom( const Level& level, int index, Random random, std::vector<EnemySpawn>& spawns ) {
+	const LevelRoom& room = level.rooms[ index ];
+	const TileMap& map = level.map;
+	const int x0 = room.cell.x * RW, y0 = room.cell.y * RH;
+	const int difficulty = std::max( level.settings.difficulty, 0 );
+
+	int count = 0;
+	switch ( room.kind ) {
+	case RoomKind::Start: return;
+	case RoomKind::Normal: count = random.range( 1, 2 ) + difficulty; break;
+	case RoomKind::Shaft: count = 1 + difficulty / 2; break;
+	case RoomKind::Arena: count = 4 + 2 * difficulty; break;
+	case RoomKind::Treasure: count = random.range( 0, 1 ); break;
+	case RoomKind::Boss: count = 1 + difficulty; break;
+	}
+
+	std::vector<glm::ivec2> ground, air;
+	for ( int y = y0 + 1; y < y0 + RH - 1; y++ ) {
+		for ( int x = x0 + 4; x < x0 + RW - 4; x++ ) {
+			if ( isStandable( map, x, y ) ) ground.push_back( glm::ivec2( x, y ) );
+			else if ( y > y0 + 3 && map.get( x, y ) == Tile::Empty && map.get( x, y + 1 ) == Tile::Empty && map.get( x, y - 1 ) == Tile::Empty ) {
+				air.push_back( glm::ivec2( x, y ) );
+			}
+		}
+	}
+
+	const size_t first = spawns.size();
+	for ( int attempt = 0; attempt < count * 8 && static_cast< int >( spawns.size() - first ) < count; attempt++ ) {
+		EnemyKind kind = EnemyKind::Grunt;
+		if ( room.kind == RoomKind::Shaft ) kind = EnemyKind::Flyer;
+		else if ( room.kind == RoomKind::Treasure ) kind = EnemyKind::Leaper;
+		else if ( room.kind == RoomKind::Boss && spawns.size() == first ) kind = EnemyKind::Brute;
+		else if ( room.kind != RoomKind::Boss ) {
+			const int roll = random.range( 0, 99 );
+			kind = roll < 55 ? EnemyKind::Grunt : roll < 80 ? EnemyKind::Leaper : EnemyKind::Flyer;
+		}
+
+		const std::vector<glm::ivec2>& candidates = kind == EnemyKind::Flyer ? air : ground;
+		if ( candidates.empty() ) continue;
+		const glm::ivec2 tile = candidates[ random.range( 0, static_cast< int >( candidates.size() ) - 1 ) ];
+
+		bool spaced = true;
+		for ( size_t i = first; i < spawns.size() && spaced; i++ ) {
+			spaced = std::max( std::abs( spawns[ i ].tile.x - tile.x ), std::abs( spawns[ i ].tile.y - tile.y ) ) >= 3;
+		}
+		if ( spaced ) spawns.push_back( { tile, kind, static_cast< uint16_t >( index ) } );
+	}
+}
+
+Level LevelGenerator::generate( uint64_t seed, const LevelSettings& settings, LevelTimings* timings ) {
+	JobSystem& jobs = JobSystem::getInstance();
+	LevelTimings local;
+	Level level;
+	level.seed = seed;
+	level.settings = settings;
+	level.settings.gridWidth = std::max( settings.gridWidth, 1 );
+	level.settings.gridHeight = std::max( settings.gridHeight, 1 );
+	level.settings.layoutCandidates = std::max( settings.layoutCandidates, 1 );
+
+	// Layout: independent candidates in parallel; the best score wins, ties go to the lowest index.
+	auto stage = std::chrono::steady_clock::now();
+	std::vector<Layout> candidates( level.settings.layoutCandidates );
+	jobs.parallelFor( candidates.size(), 1, [ & ]( size_t begin, size_t end ) {
+		for ( size_t i = begin; i < end; i++ ) candidates[ i ] = buildLayout( level.settings, Random::derive( seed, STREAM_LAYOUT + i ) );
+	} );
+	size_t best = 0;
+	for ( size_t i = 1; i < candidates.size(); i++ ) {
+		if ( candidates[ i ].score > candidates[ best ].score ) best = i;
+	}
+	level.rooms = std::move( candidates[ best ].rooms );
+	level.cellToRoom = std::move( candidates[ best ].cellToRoom );
+	local.layoutMs = elapsedMs( stage );
+
+	// Stitching: every room owns its own cell of the map, so rooms are written concurrently.
+	stage = std::chrono::steady_clock::now();
+	level.map = TileMap( level.settings.gridWidth * RW, level.settings.gridHeight * RH );
+	level.map.fill( 0, 0, level.map.getWidth(), level.map.getHeight(), Tile::Solid );
+	jobs.parallelFor( level.rooms.size(), 1, [ & ]( size_t begin, size_t end ) {
+		for ( size_t i = begin; i < end; i++ ) stitchRoom( level, static_cast< int >( i ), Random::derive( seed, STREAM_STITCH + i ) );
+	} );
+	local.stitchMs = elapsedMs( stage );
+
+	// Decoration reads neighbouring rooms' border tiles, which is safe now that stitching is done.
+	stage = std::chrono::steady_clock::now();
+	level.decorations.assign( static_cast< size_t >( level.map.getWidth() ) * level.map.getHeight(), Decoration::None );
+	jobs.parallelFor( level.rooms.size(), 1, [ & ]( size_t begin, size_t end ) {
+		for ( size_t i = begin; i < end; i++ ) decorateRoom( level, static_cast< int >( i ), Random::derive( seed, STREAM_DECORATE + i ) );
+	} );
+	local.decorateMs = elapsedMs( stage );
+
+	// Enemies are gathered per room and concatenated in room order.
+	stage = std::chrono::steady_clock::now();
+	std::vector<std::vector<EnemySpawn>> perRoom( level.rooms.size() );
+	jobs.parallelFor( level.rooms.size(), 1, [ & ]( size_t begin, size_t end ) {
+		for ( size_t i = begin; i < end; i++ ) populateRoom( level, static_cast< int >( i ), Random::derive( seed, STREAM_POPULATE + i ), perRoom[ i ] );
+	} );
+	for ( const std::vector<EnemySpawn>& spawns : perRoom ) level.enemies.insert( level.enemies.end(), spawns.begin(), spawns.end() );
+	local.populateMs = elapsedMs( stage );
+
+	const glm::ivec2 start = level.rooms.front().cell * glm::ivec2( RW, RH );
+	level.playerSpawn = start + glm::ivec2( 3, 1 );
+	for ( int x = start.x + 3; x < start.x + RW - 3; x++ ) {
+		if ( isStandable( level.map, x, start.y + 1 ) ) {
+			level.playerSpawn = glm::ivec2( x, start.y + 1 );
+			break;
+		}
+	}
+
+	if ( timings ) *timings = local;
+	return level;
+}
+
+void LevelGenerator::generateAsync( uint64_t seed, const LevelSettings& settings ) {
+	JobSystem::getInstance().wait( counter );
+	JobSystem::getInstance().submit( [ this, seed, settings ]() { result = generate( seed, settings ); }, &counter );
+}
+
+Level LevelGenerator::take() {
+	JobSystem::getInstance().wait( counter );
+	return std::move( result );
+}
+
+LevelGenerator::~LevelGenerator() {
+	JobSystem::getInstance().wait( counter );
+}
+
+uint64_t Level::hash() const {
+	uint64_t h = 0xCBF29CE484222325ull;
+	auto mix = [ &h ]( uint64_t value, int bytes ) {
+		for ( int i = 0; i < bytes; i++ ) {
+			h ^= ( value >> ( 8 * i ) ) & 0xFF;
+			h *= 0x100000001B3ull;
+		}
+	};
+
+	mix( seed, 8 );
+	mix( static_cast< uint32_t >( map.getWidth() ), 4 );
+	mix( static_cast< uint32_t >( map.getHeight() ), 4 );
+	for ( const LevelRoom& room : rooms ) {
+		mix( static_cast< uint32_t >( room.cell.x ), 4 );
+		mix( static_cast< uint32_t >( room.cell.y ), 4 );
+		mix( static_cast< uint8_t >( room.kind ), 1 );
+		mix( room.doors, 1 );
+		mix( room.depth, 2 );
+		mix( room.templateIndex, 2 );
+		mix( room.mirrored, 1 );
+	}
+	const size_t tiles = static_cast< size_t >( map.getWidth() ) * map.getHeight();
+	for ( size_t i = 0; i < tiles; i++ ) mix( static_cast< uint8_t >( map.data()[ i ] ), 1 );
+	for ( Decoration decoration : decorations ) mix( static_cast< uint8_t >( decoration ), 1 );
+	for ( const EnemySpawn& enemy : enemies ) {
+		mix( static_cast< uint32_t >( enemy.tile.x ), 4 );
+		mix( static_cast< uint32_t >( enemy.tile.y ), 4 );
+		mix( static_cast< uint8_t >( enemy.kind ), 1 );
+		mix( enemy.room, 2 );
+	}
+	mix( static_cast< uint32_t >( playerSpawn.x ), 4 );
+	mix( static_cast< uint32_t >( playerSpawn.y ), 4 );
+	return h;
+}
@@ -0,0 +1,563 @@
+#include "Lighting2D.h" // Includes the Lighting2D class definition.
+
+#include <algorithm> // Required for std::sort, std::min and std::max.
+#include <chrono> // Required for timing updates.
+#include <cmath> // Required for std::atan2, std::cos, std::sin and std::floor.
+#include <cstddef> // Required for offsetof.
+#include <limits> // Required for std::numeric_limits.
+
+#include <glad/glad.h> // Includes GLAD for OpenGL function loading.
+
+#include "JobSystem.h" // Includes the JobSystem lights are computed on.
+#include "Log.h" // Includes the Logger for error output.
+
+const int Lighting2D::CHUNK_TILES;
+const size_t Lighting2D::BATCH_SIZE;
+
+static const float RAY_OFFSET = 1e-4f; // Radians either side of an endpoint, so rays slip past corners.
+
+// Every fan vertex carries its light, so all lights draw in one call with additive blending.
+static const char* LIGHT_VERTEX_SHADER = R"(#version 330 core
+layout( location = 0 ) in vec2 aPosition;
+layout( location = 1 ) in vec2 aCenter;
+layout( location = 2 ) in float aRadius;
+layout( location = 3 ) in vec4 aColor;
+layout( location = 4 ) in float aIntensity;
+uniform mat4 uProjection;
+out vec2 vOffset;
+out float vRadius;
+out vec3 vColor;
+void main() {
+	vOffset = aPosition - aCenter;
+	vRadius = aRadius;
+	vColor = aColor.rgb * aIntensity;
+	gl_Position = uProjection * vec4( aPosition, 0.0, 1.0 );
+}
+)";
+
+static const char* LIGHT_FRAGMENT_SHADER = R"(#version 330 core
+in vec2 vOffset;
+in float vRadius;
+in vec3 vColor;
+out vec4 fragColor;
+void main() {
+	float falloff = clamp( 1.0 - length( vOffset ) / vRadius, 0.0, 1.0 );
+	fragColor = vec4( vColor * falloff * falloff, 1.0 );
+}
+)";
+
+// A full-screen triangle from the vertex id; the light buffer is stretched over the viewport with bilinear filtering.
+static const char* COMPOSITE_VERTEX_SHADER = R"(#version 330 core
+out vec2 vUv;
+void main() {
+	vec2 corner = vec2( ( gl_VertexID << 1 ) & 2, gl_VertexID & 2 );
+	vUv = corner;
+	gl_Position = vec4( corner * 2.0 - 1.0, 0.0, 1.0 );
+}
+)";
+
+static const char* COMPOSITE_FRAGMENT_SHADER = R"(#version 330 core
+in vec2 vUv;
+uniform sampler2D uLight;
+out vec4 fragColor;
+void main() {
+	fragColor = vec4( texture( uLight, vUv ).rgb, 1.0 );
+}
+)";
+
+/**
+ * @brief Gets the milliseconds elapsed since a time point.
+ * @param since The start.
+ * @return Elapsed milliseconds.
+ */
+static double elapsedMs( std::chrono::steady_clock::time_point since ) {
+	return std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - since ).count();
+}
+
+/**
+ * @brief Compiles one shader stage.
+ * @param type GL_VERTEX_SHADER or GL_FRAGMENT_SHADER.
+ * @param source GLSL source.
+ * @return The shader, or 0 on failure.
+ */
+static GLuint compileShader( GLenum type, const char* source ) {
+	GLuint shader = glCreateShader( type );
+	glShaderSource( shader, 1, &source, nullptr );
+	glCompileShader( shader );
+	GLint ok = 0;
+	glGetShaderiv( shader, GL_COMPILE_STATUS, &ok );
+	if ( !ok ) {
+		char log[ 512 ];
+		glGetShaderInfoLog( shader, sizeof( log ), nullptr, log );
+		LOG_ERROR( "Lighting shader failed to compile: {}", log );
+		glDeleteShader( shader );
+		return 0;
+	}
+	return shader;
+}
+
+/**
+ * @brief Compiles and links a program.
+ * @param vertexSource Vertex shader GLSL.
+ * @param fragmentSource Fragment shader GLSL.
+ * @return The program, or 0 on failure.
+ */
+static GLuint linkProgram( const char* vertexSource, const char* fragmentSource ) {
+	GLuint vertexShader = compileShader( GL_VERTEX_SHADER, vertexSource );
+	GLuint fragmentShader = compileShader( GL_FRAGMENT_SHADER, fragmentSource );
+	if ( !vertexShader || !fragmentShader ) {
+		if ( vertexShader ) glDeleteShader( vertexShader );
+		if ( fragmentShader ) glDeleteShader( fragmentShader );
+		return 0;
+	}
+	GLuint program = glCreateProgram();
+	glAttachShader( program, vertexShader );
+	glAttachShader( program, fragmentShader );
+	glLinkProgram( program );
+	glDeleteShader( vertexShader );
+	glDeleteShader( fragmentShader );
+	GLint linked = 0;
+	glGetProgramiv( program, GL_LINK_STATUS, &linked );
+	if ( !linked ) {
+		LOG_ERROR( "Lighting shader failed to link." );
+		glDeleteProgram( program );
+		return 0;
+	}
+	return program;
+}
+
+/**
+ * @brief Gets the z component of the cross product of two vectors.
+ */
+static float cross( const glm::vec2& a, const glm::vec2& b ) {
+	return a.x * b.y - a.y * b.x;
+}
+
+/**
+ * @brief Clips a segment to a box (Liang-Barsky).
+ * @param edge The segment; clipped in place.
+ * @param lo The box's minimum corner.
+ * @param hi The box's maximum corner.
+ * @return False if no part of it is inside.
+ */
+static bool clipToBox( LightEdge& edge, const glm::vec2& lo, const glm::vec2& hi ) {
+	const glm::vec2 delta = edge.b - edge.a;
+	float t0 = 0.0f, t1 = 1.0f;
+	const float p[ 4 ] = { -delta.x, delta.x, -delta.y, delta.y };
+	const float q[ 4 ] = { edge.a.x - lo.x, hi.x - edge.a.x, edge.a.y - lo.y, hi.y - edge.a.y };
+	for ( int i = 0; i < 4; i++ ) {
+		if ( p[ i ] == 0.0f ) {
+			if ( q[ i ] < 0.0f ) return false;
+			continue;
+		}
+		const float t = q[ i ] / p[ i ];
+		if ( p[ i ] < 0.0f ) t0 = std::max( t0, t );
+		else t1 = std::min( t1, t );
+		if ( t0 > t1 ) return false;
+	}
+	const glm::vec2 a = edge.a;
+	edge.a = a + delta * t0;
+	edge.b = a + delta * t1;
+	return true;
+}
+
+bool Lighting2D::initGL( int width, int height ) {
+	if ( glReady ) return true;
+	lightProgram = linkProgram( LIGHT_VERTEX_SHADER, LIGHT_FRAGMENT_SHADER );
+	compositeProgram = linkProgram( COMPOSITE_VERTEX_SHADER, COMPOSITE_FRAGMENT_SHADER );
+	if ( !lightProgram || !compositeProgram ) {
+		if ( lightProgram ) glDeleteProgram( lightProgram );
+		if ( compositeProgram ) glDeleteProgram( compositeProgram );
+		lightProgram = compositeProgram = 0;
+		return false;
+	}
+	projectionLocation = glGetUniformLocation( lightProgram, "uProjection" );
+	lightTextureLocation = glGetUniformLocation( compositeProgram, "uLight" );
+
+	glGenVertexArrays( 1, &vao );
+	glGenVertexArrays( 1, &emptyVao );
+	glGenBuffers( 1, &vbo );
+	glBindVertexArray( vao );
+	glBindBuffer( GL_ARRAY_BUFFER, vbo );
+	glEnableVertexAttribArray( 0 );
+	glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, sizeof( LightVertex ), reinterpret_cast< void* >( offsetof( LightVertex, x ) ) );
+	glEnableVertexAttribArray( 1 );
+	glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, sizeof( LightVertex ), reinterpret_cast< void* >( offsetof( LightVertex, centerX ) ) );
+	glEnableVertexAttribArray( 2 );
+	glVertexAttribPointer( 2, 1, GL_FLOAT, GL_FALSE, sizeof( LightVertex ), reinterpret_cast< void* >( offsetof( LightVertex, radius ) ) );
+	glEnableVertexAttribArray( 3 );
+	glVertexAttribPointer( 3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof( LightVertex ), reinterpret_cast< void* >( offsetof( LightVertex, color ) ) );
+	glEnableVertexAttribArray( 4 );
+	glVertexAttribPointer( 4, 1, GL_FLOAT, GL_FALSE, sizeof( LightVertex ), reinterpret_cast< void* >( offsetof( LightVertex, intensity ) ) );
+	glBindVertexArray( 0 );
+	vertexCapacity = 0;
+
+	viewWidth = std::max( width, 1 );
+	viewHeight = std::max( height, 1 );
+	glReady = true;
+	if ( !createTarget() ) {
+		shutdownGL();
+		return false;
+	}
+	return true;
+}
+
+void Lighting2D::shutdownGL() {
+	if ( !glReady ) return;
+	glDeleteFramebuffers( 1, &fbo );
+	glDeleteTextures( 1, &texture );
+	glDeleteBuffers( 1, &vbo );
+	glDeleteVertexArrays( 1, &vao );
+	glDeleteVertexArrays( 1, &emptyVao );
+	glDeleteProgram( lightProgram );
+	glDeleteProgram( compositeProgram );
+	fbo = texture = vbo = vao = emptyVao = lightProgram = compositeProgram = 0;
+	vertexCapacity = 0;
+	glReady = false;
+}
+
+void Lighting2D::resize( int width, int height ) {
+	width = std::max( width, 1 );
+	height = std::max( height, 1 );
+	if ( width == viewWidth && height == viewHeight ) return;
+	viewWidth = width;
+	viewHeight = height;
+	if ( glReady ) createTarget();
+}
+
+void Lighting2D::setResolutionDivisor( int requested ) {
+	requested = std::max( requested, 1 );
+	if ( requested == divisor ) return;
+	divisor = requested;
+	if ( glReady ) createTarget();
+}
+
+bool Lighting2D::createTarget() {
+	if ( !fbo ) glGenFramebuffers( 1, &fbo );
+	if ( !texture ) glGenTextures( 1, &texture );
+	// Half floats, so many overlapping lights add up without banding. The multiply into a fixed-point framebuffer clamps
+	// the light to 1 first, so light can only keep or darken the scene, never brighten it.
+	glBindTexture( GL_TEXTURE_2D, texture );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA16F, ( viewWidth + divisor - 1 ) / divisor, ( viewHeight + divisor - 1 ) / divisor, 0, GL_RGBA, GL_HALF_FLOAT, nullptr );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	GLint previous = 0;
+	glGetIntegerv( GL_FRAMEBUFFER_BINDING, &previous );
+	glBindFramebuffer( GL_FRAMEBUFFER, fbo );
+	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0 );
+	const bool complete = glCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer( GL_FRAMEBUFFER, static_cast< GLuint >( previous ) );
+	if ( !complete ) {
+		LOG_ERROR( "Light buffer is incomplete." );
+		return false;
+	}
+	return true;
+}
+
+void Lighting2D::setTileMap( const TileMap* newMap ) {
+	map = newMap;
+	chunks.clear();
+	chunksWide = chunksHigh = 0;
+	edgeCount = 0;
+	if ( map ) {
+		tileSize = map->getTileSize();
+		chunksWide = ( map->getWidth() + CHUNK_TILES - 1 ) / CHUNK_TILES;
+		chunksHigh = ( map->getHeight() + CHUNK_TILES - 1 ) / CHUNK_TILES;
+		chunks.resize( static_cast< size_t >( chunksWide ) * chunksHigh );
+		for ( int cy = 0; cy < chunksHigh; cy++ ) {
+			for ( int cx = 0; cx < chunksWide; cx++ ) extractChunk( cx, cy );
+		}
+		chunksSince += static_cast< uint32_t >( chunks.size() );
+	}
+	for ( Light& light : lights ) {
+		if ( !light.settings.dynamic && !light.dirty ) {
+			light.dirty = true;
+			invalidatedSince++;
+		}
+	}
+}
+
+void Lighting2D::extractChunk( int cx, int cy ) {
+	Chunk& chunk = chunks[ static_cast< size_t >( cy ) * chunksWide + cx ];
+	edgeCount -= static_cast< uint32_t >( chunk.edges.size() );
+	chunk.edges.clear();
+	const int x = cx * CHUNK_TILES, y = cy * CHUNK_TILES;
+	const TileRect area = { x, y, std::min( CHUNK_TILES, map->getWidth() - x ), std::min( CHUNK_TILES, map->getHeight() - y ) };
+	extractEdges( *map, area, true, chunk.edges );
+	edgeCount += static_cast< uint32_t >( chunk.edges.size() );
+}
+
+void Lighting2D::invalidateTiles( const TileRect& rect ) {
+	if ( !map || chunks.empty() ) return;
+	// A tile's faces depend on its neighbors, so the tiles around the rectangle change too.
+	const int x0 = rect.x - 1, y0 = rect.y - 1, x1 = rect.x + rect.w, y1 = rect.y + rect.h;
+	const int cx0 = std::max( 0, static_cast< int >( std::floor( static_cast< float >( x0 ) / CHUNK_TILES ) ) );
+	const int cy0 = std::max( 0, static_cast< int >( std::floor( static_cast< float >( y0 ) / CHUNK_TILES ) ) );
+	const int cx1 = std::min( chunksWide - 1, x1 / CHUNK_TILES ), cy1 = std::min( chunksHigh - 1, y1 / CHUNK_TILES );
+	for ( int cy = cy0; cy <= cy1; cy++ ) {
+		for ( int cx = cx0; cx <= cx1; cx++ ) {
+			extractChunk( cx, cy );
+			chunksSince++;
+		}
+	}
+
+	const glm::vec2 lo = glm::vec2( x0, y0 ) * tileSize, hi = glm::vec2( x1 + 1, y1 + 1 ) * tileSize;
+	for ( Light& light : lights ) {
+		if ( light.settings.dynamic || light.dirty ) continue;
+		const glm::vec2 p = light.settings.position;
+		const float r = light.settings.radius;
+		if ( p.x + r < lo.x || p.x - r > hi.x || p.y + r < lo.y || p.y - r > hi.y ) continue;
+		light.dirty = true;
+		invalidatedSince++;
+	}
+}
+
+uint32_t Lighting2D::addLight( const Light2DSettings& settings ) {
+	Light light;
+	light.settings = settings;
+	lights.push_back( std::move( light ) );
+	return static_cast< uint32_t >( lights.size() - 1 );
+}
+
+void Lighting2D::setLightPosition( uint32_t index, const glm::vec2& position ) {
+	Light& light = lights[ index ];
+	if ( light.settings.position == position ) return;
+	light.settings.position = position;
+	light.dirty = true;
+}
+
+void Lighting2D::setLightEnabled( uint32_t index, bool enabled ) {
+	lights[ index ].enabled = enabled;
+}
+
+void Lighting2D::extractEdges( const TileMap& map, const TileRect& area, bool merge, std::vector<LightEdge>& out ) {
+	const float size = map.getTileSize();
+	const int xEnd = area.x + area.w, yEnd = area.y + area.h;
+	// Each face direction is one pass: rows for the top and bottom faces, columns for the sides.
+	for ( int side = 0; side < 4; side++ ) {
+		const bool horizontal = side < 2;
+		const int outer0 = horizontal ? area.y : area.x, outer1 = horizontal ? yEnd : xEnd;
+		const int inner0 = horizontal ? area.x : area.y, inner1 = horizontal ? xEnd : yEnd;
+		for ( int outer = outer0; outer < outer1; outer++ ) {
+			int run = -1;
+			for ( int inner = inner0; inner <= inner1; inner++ ) {
+				bool face = false;
+				if ( inner < inner1 ) {
+					const int x = horizontal ? inner : outer, y = horizontal ? outer : inner;
+					const int openX = x + ( side == 2 ? 1 : side == 3 ? -1 : 0 ), openY = y + ( side == 0 ? 1 : side == 1 ? -1 : 0 );
+					face = map.isSolid( x, y ) && !map.isSolid( openX, openY );
+				}
+				if ( face && run < 0 ) run = inner;
+				const bool flush = run >= 0 && ( !face || !merge );
+				if ( !flush ) continue;
+				const float from = static_cast< float >( run ) * size, to = static_cast< float >( face ? inner + 1 : inner ) * size;
+				const float low = static_cast< float >( outer ) * size, high = static_cast< float >( outer + 1 ) * size;
+				// Wound so the open side is on the left.
+				switch ( side ) {
+				case 0: out.push_back( { glm::vec2( from, high ), glm::vec2( to, high ) } ); break; // Top.
+				case 1: out.push_back( { glm::vec2( to, low ), glm::vec2( from, low ) } ); break; // Bottom.
+				case 2: out.push_back( { glm::vec2( high, to ), glm::vec2( high, from ) } ); break; // Right.
+				default: out.push_back( { glm::vec2( low, from ), glm::vec2( low, to ) } ); break; // Left.
+				}
+				run = -1;
+			}
+		}
+	}
+}
+
+void Lighting2D::gatherEdges( const Light2DSettings& light, std::vector<LightEdge>& out ) const {
+	out.clear();
+	const glm::vec2 lo = light.position - light.radius, hi = light.position + light.radius;
+	const float chunkSize = tileSize * CHUNK_TILES;
+	const int cx0 = std::max( 0, static_cast< int >( std::floor( lo.x / chunkSize ) ) );
+	const int cy0 = std::max( 0, static_cast< int >( std::floor( lo.y / chunkSize ) ) );
+	const int cx1 = std::min( chunksWide - 1, static_cast< int >( std::floor( hi.x / chunkSize ) ) );
+	const int cy1 = std::min( chunksHigh - 1, static_cast< int >( std::floor( hi.y / chunkSize ) ) );
+	for ( int cy = cy0; cy <= cy1; cy++ ) {
+		for ( int cx = cx0; cx <= cx1; cx++ ) {
+			for ( const LightEdge& edge : chunks[ static_cast< size_t >( cy ) * chunksWide + cx ].edges ) {
+				if ( cross( edge.b - edge.a, light.position - edge.a ) <= 0.0f ) continue; // Seen from behind.
+				if ( std::max( edge.a.x, edge.b.x ) < lo.x || std::min( edge.a.x, edge.b.x ) > hi.x ) continue;
+				if ( std::max( edge.a.y, edge.b.y ) < lo.y || std::min( edge.a.y, edge.b.y ) > hi.y ) continue;
+				out.push_back( edge );
+			}
+		}
+	}
+}
+
+void Lighting2D::computeVisibility( const glm::vec2& center, float radius, const LightEdge* edges, size_t count, std::vector<glm::vec2>& out ) {
+	thread_local std::vector<LightEdge> clipped;
+	thread_local std::vector<float> angles;
+	out.clear();
+	clipped.clear();
+	angles.clear();
+	const glm::vec2 lo = center - radius, hi = center + radius;
+	for ( size_t i = 0; i < count; i++ ) {
+		LightEdge edge = edges[ i ];
+		if ( !clipToBox( edge, lo, hi ) ) continue;
+		clipped.push_back( edge );
+		for ( const glm::vec2& point : { edge.a, edge.b } ) {
+			const float angle = std::atan2( point.y - center.y, point.x - center.x );
+			angles.push_back( angle - RAY_OFFSET );
+			angles.push_back( angle );
+			angles.push_back( angle + RAY_OFFSET );
+		}
+	}
+	for ( const glm::vec2& corner : { lo, glm::vec2( hi.x, lo.y ), hi, glm::vec2( lo.x, hi.y ) } ) {
+		angles.push_back( std::atan2( corner.y - center.y, corner.x - center.x ) );
+	}
+	std::sort( angles.begin(), angles.end() );
+
+	float previous = -std::numeric_limits<float>::infinity();
+	for ( float angle : angles ) {
+		if ( angle - previous < 1e-6f ) continue; // Shared endpoints.
+		previous = angle;
+		const glm::vec2 direction( std::cos( angle ), std::sin( angle ) );
+		// The bounding square is the farthest anything can reach.
+		const float exitX = direction.x > 0.0f ? ( hi.x - center.x ) / direction.x : direction.x < 0.0f ? ( lo.x - center.x ) / direction.x : radius * 2.0f;
+		const float exitY = direction.y > 0.0f ? ( hi.y - center.y ) / direction.y : direction.y < 0.0f ? ( lo.y - center.y ) / direction.y : radius * 2.0f;
+		float nearest = std::min( exitX, exitY );
+		for ( const LightEdge& edge : clipped ) {
+			const glm::vec2 along = edge.b - edge.a;
+			const float denominator = cross( direction, along );
+			if ( std::fabs( denominator ) < 1e-12f ) continue;
+			const glm::vec2 toEdge = edge.a - center;
+			const float t = cross( toEdge, along ) / denominator;
+			const float u = cross( toEdge, direction ) / denominator;
+			if ( t > 0.0f && t < nearest && u >= 0.0f && u <= 1.0f ) nearest = t;
+		}
+		out.push_back( center + direction * nearest );
+	}
+}
+
+void Lighting2D::update() {
+	const auto start = std::chrono::steady_clock::now();
+	stats.lights = stats.computed = stats.cached = 0;
+	stats.edgesGathered = 0;
+	work.clear();
+	for ( uint32_t i = 0; i < lights.size(); i++ ) {
+		const Light& light = lights[ i ];
+		if ( !light.enabled ) continue;
+		stats.lights++;
+		if ( light.settings.dynamic || light.dirty ) work.push_back( i );
+		else stats.cached++;
+	}
+	stats.computed = static_cast< uint32_t >( work.size() );
+
+	batchEdges.assign( ( work.size() + BATCH_SIZE - 1 ) / BATCH_SIZE, 0 );
+	JobSystem::getInstance().parallelFor( work.size(), BATCH_SIZE, [ this ]( size_t begin, size_t end ) {
+		std::vector<LightEdge> edges;
+		uint64_t& gathered = batchEdges[ begin / BATCH_SIZE ];
+		for ( size_t i = begin; i < end; i++ ) {
+			Light& light = lights[ work[ i ] ];
+			gatherEdges( light.settings, edges );
+			computeVisibility( light.settings.position, light.settings.radius, edges.data(), edges.size(), light.polygon );
+			light.dirty = false;
+			gathered += edges.size();
+		}
+	} );
+	for ( uint64_t gathered : batchEdges ) stats.edgesGathered += gathered;
+
+	stats.invalidated = invalidatedSince;
+	stats.chunks = chunksSince;
+	stats.edges = edgeCount;
+	invalidatedSince = chunksSince = 0;
+	stats.updateMs = elapsedMs( start );
+}
+
+uint32_t Lighting2D::getVertexCount() const {
+	uint32_t count = 0;
+	for ( const Light& light : lights ) {
+		if ( light.enabled ) count += static_cast< uint32_t >( light.polygon.size() ) * 3;
+	}
+	return count;
+}
+
+uint32_t Lighting2D::writeVertices( LightVertex* out ) {
+	const auto start = std::chrono::steady_clock::now();
+	vertexOffsets.resize( lights.size() );
+	uint32_t total = 0;
+	for ( size_t i = 0; i < lights.size(); i++ ) {
+		vertexOffsets[ i ] = total;
+		if ( lights[ i ].enabled ) total += static_cast< uint32_t >( lights[ i ].polygon.size() ) * 3;
+	}
+
+	JobSystem::getInstance().parallelFor( lights.size(), 16, [ this, out ]( size_t begin, size_t end ) {
+		for ( size_t i = begin; i < end; i++ ) {
+			const Light& light = lights[ i ];
+			if ( !light.enabled ) continue;
+			const Light2DSettings& settings = light.settings;
+			const LightVertex center = { settings.position.x, settings.position.y, settings.position.x, settings.position.y, settings.radius, settings.color, settings.intensity };
+			LightVertex* vertex = out + vertexOffsets[ i ];
+			const size_t points = light.polygon.size();
+			for ( size_t p = 0; p < points; p++ ) {
+				const glm::vec2& a = light.polygon[ p ];
+				const glm::vec2& b = light.polygon[ p + 1 < points ? p + 1 : 0 ];
+				vertex[ 0 ] = center;
+				vertex[ 1 ] = center;
+				vertex[ 1 ].x = a.x;
+				vertex[ 1 ].y = a.y;
+				vertex[ 2 ] = center;
+				vertex[ 2 ].x = b.x;
+				vertex[ 2 ].y = b.y;
+				vertex += 3;
+			}
+		}
+	} );
+
+	stats.vertices = total;
+	stats.writeMs = elapsedMs( start );
+	return total;
+}
+
+void Lighting2D::render( const glm::mat4& projection ) {
+	if ( !glReady ) return;
+	GLint screenFbo = 0, viewport[ 4 ];
+	glGetIntegerv( GL_FRAMEBUFFER_BINDING, &screenFbo );
+	glGetIntegerv( GL_VIEWPORT, viewport );
+
+	glBindFramebuffer( GL_FRAMEBUFFER, fbo );
+	glViewport( 0, 0, ( viewWidth + divisor - 1 ) / divisor, ( viewHeight + divisor - 1 ) / divisor );
+	glClearColor( ( ambient & 0xFFu ) / 255.0f, ( ambient >> 8 & 0xFFu ) / 255.0f, ( ambient >> 16 & 0xFFu ) / 255.0f, 1.0f );
+	glClear( GL_COLOR_BUFFER_BIT );
+
+	const uint32_t count = getVertexCount();
+	if ( count > 0 ) {
+		glBindVertexArray( vao );
+		glBindBuffer( GL_ARRAY_BUFFER, vbo );
+		if ( count > vertexCapacity ) {
+			vertexCapacity = count + count / 2;
+			glBufferData( GL_ARRAY_BUFFER, static_cast< GLsizeiptr >( vertexCapacity * sizeof( LightVertex ) ), nullptr, GL_STREAM_DRAW );
+		}
+		void* mapped = glMapBufferRange( GL_ARRAY_BUFFER, 0, static_cast< GLsizeiptr >( count * sizeof( LightVertex ) ),
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+		if ( !mapped ) LOG_ERROR( "Failed to map the light vertex buffer." );
+		else {
+			writeVertices( static_cast< LightVertex* >( mapped ) );
+			// A corrupted buffer (e.g. after a mode switch) only costs this frame's lights.
+			if ( glUnmapBuffer( GL_ARRAY_BUFFER ) ) {
+				glUseProgram( lightProgram );
+				glUniformMatrix4fv( projectionLocation, 1, GL_FALSE, &projection[ 0 ][ 0 ] );
+				glEnable( GL_BLEND );
+				glBlendFunc( GL_ONE, GL_ONE );
+				glDrawArrays( GL_TRIANGLES, 0, static_cast< GLsizei >( count ) );
+			}
+		}
+	}
+
+	// Multiply the scene by the light.
+	glBindFramebuffer( GL_FRAMEBUFFER, static_cast< GLuint >( screenFbo ) );
+	glViewport( viewport[ 0 ], viewport[ 1 ], viewport[ 2 ], viewport[ 3 ] );
+	glUseProgram( compositeProgram );
+	glActiveTexture( GL_TEXTURE0 );
+	glBindTexture( GL_TEXTURE_2D, texture );
+	glUniform1i( lightTextureLocation, 0 );
+	glEnable( GL_BLEND );
+	glBlendFunc( GL_DST_COLOR, GL_ZERO );
+	glBindVertexArray( emptyVao );
+	glDrawArrays( GL_TRIANGLES, 0, 3 );
+	glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+	glBindVertexArray( 0 );
+}
@@ -0,0 +1,403 @@
+#include "LightningSystem.h" // Includes the LightningSystem class definition.
+
+#include <algorithm> // Required for std::min, std::max and std::swap.
+#include <chrono> // Required for timing generation and output.
+#include <cmath> // Required for std::log2, std::round, std::cos and std::sin.
+#include <cstddef> // Required for offsetof.
+
+#include <glad/glad.h> // Includes GLAD for OpenGL function loading.
+
+#include "JobSystem.h" // Includes the JobSystem shapes are generated on.
+#include "Random.h" // Includes the deterministic generator shapes are displaced with.
+#include "Log.h" // Includes the Logger for error output.
+
+const int LightningSystem::MIN_DETAIL;
+const int LightningSystem::MAX_DETAIL;
+const uint32_t LightningSystem::VARIANTS;
+
+static const int ROUGHNESS_BUCKETS = 8;
+static const int BRANCHING_BUCKETS = 4;
+static const uint64_t SHAPE_SEED = 0x801u; // Mixed with the key, so every run builds the same shapes.
+
+// Six vertices per segment from gl_VertexID; instances whose shape has fewer segments than the level's longest collapse the rest.
+// Points move across the bolt by a hash of their id, the bolt's seed and a 30 Hz tick, pinned at the endpoints.
+static const char* LIGHTNING_VERTEX_SHADER = R"(#version 330 core
+layout( location = 0 ) in vec4 aEnds;
+layout( location = 1 ) in vec4 aStyle;
+layout( location = 2 ) in vec4 aColor;
+layout( location = 3 ) in ivec2 aShape;
+uniform mat4 uProjection;
+uniform samplerBuffer uSegments;
+uniform float uTime;
+uniform float uJitter;
+out vec4 vColor;
+out float vAcross;
+float hash( float n ) {
+	return fract( sin( n ) * 43758.5453 );
+}
+void main() {
+	int segment = gl_VertexID / 6;
+	int corner = gl_VertexID % 6;
+	if ( segment >= aShape.y ) {
+		gl_Position = vec4( 0.0 );
+		vColor = vec4( 0.0 );
+		vAcross = 0.0;
+		return;
+	}
+	vec4 a = texelFetch( uSegments, ( aShape.x + segment ) * 2 );
+	vec4 b = texelFetch( uSegments, ( aShape.x + segment ) * 2 + 1 );
+	bool atEnd = corner == 1 || corner == 2 || corner == 4;
+	float side = ( corner == 2 || corner == 4 || corner == 5 ) ? 1.0 : -1.0;
+	vec4 point = atEnd ? b : a;
+
+	vec2 axis = aEnds.zw - aEnds.xy;
+	vec2 across = normalize( vec2( -axis.y, axis.x ) ) * aStyle.y;
+	float along = clamp( point.x, 0.0, 1.0 );
+	float tick = floor( uTime * 30.0 );
+	float offset = ( hash( point.w * 12.9898 + aStyle.z * 78.233 + tick * 3.7 ) - 0.5 ) * 2.0 * uJitter * 4.0 * along * ( 1.0 - along );
+	vec2 position = aEnds.xy + axis * point.x + across * ( point.y + offset );
+
+	vec2 direction = axis * ( b.x - a.x ) + across * ( b.y - a.y );
+	vec2 normal = normalize( vec2( -direction.y, direction.x ) + vec2( 1e-6, 0.0 ) );
+	position += normal * side * aStyle.x * 0.5 * point.z;
+
+	vColor = vec4( aColor.rgb, aColor.a * aStyle.w );
+	vAcross = side;
+	gl_Position = uProjection * vec4( position, 0.0, 1.0 );
+}
+)";
+
+static const char* LIGHTNING_FRAGMENT_SHADER = R"(#version 330 core
+in vec4 vColor;
+in float vAcross;
+out vec4 fragColor;
+void main() {
+	float core = 1.0 - vAcross * vAcross;
+	fragColor = vec4( mix( vColor.rgb, vec3( 1.0 ), core * core ), vColor.a * core );
+}
+)";
+
+/**
+ * @brief Gets the milliseconds elapsed since a time point.
+ * @param since The start.
+ * @return Elapsed milliseconds.
+ */
+static double elapsedMs( std::chrono::steady_clock::time_point since ) {
+	return std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - since ).count();
+}
+
+/**
+ * @brief Compiles one shader stage.
+ * @param type GL_VERTEX_SHADER or GL_FRAGMENT_SHADER.
+ * @param source GLSL source.
+ * @return The shader, or 0 on failure.
+ */
+static GLuint compileShader( GLenum type, const char* source ) {
+	GLuint shader = glCreateShader( type );
+	glShaderSource( shader, 1, &source, nullptr );
+	glCompileShader( shader );
+	GLint ok = 0;
+	glGetShaderiv( shader, GL_COMPILE_STATUS, &ok );
+	if ( !ok ) {
+		char log[ 512 ];
+		glGetShaderInfoLog( shader, sizeof( log ), nullptr, log );
+		LOG_ERROR( "Lightning shader failed to compile: {}", log );
+		glDeleteShader( shader );
+		return 0;
+	}
+	return shader;
+}
+
+/**
+ * @brief Quantizes a 0 to 1 parameter into a bucket.
+ * @param value The parameter.
+ * @param buckets Number of buckets.
+ * @return 0 to buckets - 1.
+ */
+static int toBucket( float value, int buckets ) {
+	return static_cast< int >( std::round( std::min( std::max( value, 0.0f ), 1.0f ) * ( buckets - 1 ) ) );
+}
+
+bool LightningSystem::initGL() {
+	if ( glReady ) return true;
+	GLuint vertexShader = compileShader( GL_VERTEX_SHADER, LIGHTNING_VERTEX_SHADER );
+	GLuint fragmentShader = compileShader( GL_FRAGMENT_SHADER, LIGHTNING_FRAGMENT_SHADER );
+	if ( !vertexShader || !fragmentShader ) {
+		if ( vertexShader ) glDeleteShader( vertexShader );
+		if ( fragmentShader ) glDeleteShader( fragmentShader );
+		return false;
+	}
+	program = glCreateProgram();
+	glAttachShader( program, vertexShader );
+	glAttachShader( program, fragmentShader );
+	glLinkProgram( program );
+	glDeleteShader( vertexShader );
+	glDeleteShader( fragmentShader );
+	GLint linked = 0;
+	glGetProgramiv( program, GL_LINK_STATUS, &linked );
+	if ( !linked ) {
+		LOG_ERROR( "Lightning shader failed to link." );
+		glDeleteProgram( program );
+		program = 0;
+		return false;
+	}
+	projectionLocation = glGetUniformLocation( program, "uProjection" );
+	timeLocation = glGetUniformLocation( program, "uTime" );
+	jitterLocation = glGetUniformLocation( program, "uJitter" );
+	glUseProgram( program );
+	glUniform1i( glGetUniformLocation( program, "uSegments" ), 0 );
+
+	glGenVertexArrays( 1, &vao );
+	glGenBuffers( 1, &instanceVbo );
+	glGenBuffers( 1, &segmentBuffer );
+	glGenTextures( 1, &segmentTexture );
+	uploadedSegments = 0;
+	instanceCapacity = 0;
+
+	glReady = true;
+	return true;
+}
+
+void LightningSystem::shutdownGL() {
+	if ( !glReady ) return;
+	glDeleteTextures( 1, &segmentTexture );
+	glDeleteBuffers( 1, &segmentBuffer );
+	glDeleteBuffers( 1, &instanceVbo );
+	glDeleteVertexArrays( 1, &vao );
+	glDeleteProgram( program );
+	program = vao = instanceVbo = segmentBuffer = segmentTexture = 0;
+	instanceCapacity = 0;
+	uploadedSegments = 0;
+	projectionLocation = timeLocation = jitterLocation = -1;
+	glReady = false;
+}
+
+int LightningSystem::detailFor( float length, float segmentLength ) {
+	const int detail = static_cast< int >( std::round( std::log2( std::max( length / std::max( segmentLength, 1e-3f ), 1.0f ) ) ) );
+	return std::min( std::max( detail, MIN_DETAIL ), MAX_DETAIL );
+}
+
+uint32_t LightningSystem::makeKey( int level, float roughness, float branching, uint32_t variant ) {
+	return static_cast< uint32_t >( level ) << 8 | static_cast< uint32_t >( toBucket( roughness, ROUGHNESS_BUCKETS ) ) << 5 |
+		static_cast< uint32_t >( toBucket( branching, BRANCHING_BUCKETS ) ) << 3 | variant % VARIANTS;
+}
+
+void LightningSystem::generateShape( int detail, float roughness, float branching, uint64_t seed, std::vector<LightningSegment>& out ) {
+	/**
+	 * @brief A segment while subdividing; forks only fork once more.
+	 */
+	struct Working
+	{
+		LightningSegment segment;
+		int depth; // 0 for the main channel.
+	};
+
+	Random random( seed );
+	std::vector<Working> current = { { { 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f }, 0 } };
+	std::vector<Working> next;
+	float nextId = 2.0f;
+	float offset = 1.0f; // Shape y is in units of the bolt's displacement.
+	const float keep = 0.3f + 0.4f * roughness;
+	const float forkChance = 0.25f * branching;
+
+	for ( int generation = 0; generation < detail; generation++ ) {
+		next.clear();
+		for ( const Working& working : current ) {
+			const LightningSegment& s = working.segment;
+			const float mx = ( s.ax + s.bx ) * 0.5f;
+			const float my = ( s.ay + s.by ) * 0.5f + random.range( -offset, offset ) * ( working.depth ? 0.6f : 1.0f );
+			const float mWidth = ( s.aWidth + s.bWidth ) * 0.5f;
+			const float mId = nextId++;
+			next.push_back( { { s.ax, s.ay, s.aWidth, s.aId, mx, my, mWidth, mId }, working.depth } );
+			next.push_back( { { mx, my, mWidth, mId, s.bx, s.by, s.bWidth, s.bId }, working.depth } );
+
+			// Forks leave from the new point, bent away from the parent's direction, and taper to nothing.
+			if ( working.depth < 2 && generation < detail - 1 && random.nextFloat() < forkChance ) {
+				const float dx = mx - s.ax, dy = my - s.ay;
+				const float bend = random.range( 0.3f, 0.8f ) * ( random.nextU32() & 1 ? 1.0f : -1.0f );
+				const float length = random.range( 0.8f, 1.6f );
+				const float ex = mx + ( dx * std::cos( bend ) - dy * std::sin( bend ) ) * length;
+				const float ey = my + ( dx * std::sin( bend ) + dy * std::cos( bend ) ) * length;
+				next.push_back( { { mx, my, mWidth * 0.6f, mId, ex, ey, 0.0f, nextId++ }, working.depth + 1 } );
+			}
+		}
+		std::swap( current, next );
+		offset *= keep;
+	}
+
+	out.clear();
+	out.reserve( current.size() );
+	for ( const Working& working : current ) out.push_back( working.segment );
+}
+
+void LightningSystem::strike( const LightningBoltSettings& settings ) {
+	const float length = glm::length( settings.end - settings.start );
+	const int level = detailFor( length, segmentLength ) - MIN_DETAIL;
+	const uint32_t key = makeKey( level, settings.roughness, settings.branching, settings.seed );
+
+	uint32_t shape;
+	auto found = shapeIndex.find( key );
+	if ( found != shapeIndex.end() ) {
+		shape = found->second;
+		strikeHits++;
+	}
+	else {
+		shape = static_cast< uint32_t >( shapes.size() );
+		shapes.push_back( { key } );
+		shapeIndex.emplace( key, shape );
+		pending.push_back( shape );
+		strikeMisses++;
+	}
+
+	Bolt bolt;
+	bolt.instance = { settings.start.x, settings.start.y, settings.end.x, settings.end.y, settings.width, settings.displacement * length,
+		static_cast< float >( settings.seed % 4096u ), 1.0f, settings.color, 0, 0, 0 };
+	bolt.shape = shape;
+	bolt.level = static_cast< uint8_t >( level );
+	bolt.age = 0.0f;
+	bolt.duration = std::max( settings.duration, 1e-3f );
+	struck.push_back( bolt );
+}
+
+void LightningSystem::update( float dt ) {
+	// New strikes join after the aging, so their first frame is at full brightness.
+	for ( size_t i = 0; i < bolts.size(); ) {
+		Bolt& bolt = bolts[ i ];
+		bolt.age += dt;
+		if ( bolt.age >= bolt.duration ) {
+			bolt = bolts.back();
+			bolts.pop_back();
+			continue;
+		}
+		bolt.instance.fade = 1.0f - bolt.age / bolt.duration;
+		i++;
+	}
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if ( !pending.empty() ) {
+		std::vector<std::vector<LightningSegment>> generated( pending.size() );
+		JobSystem::getInstance().parallelFor( pending.size(), 1, [ this, &generated ]( size_t begin, size_t end ) {
+			for ( size_t i = begin; i < end; i++ ) {
+				const uint32_t key = shapes[ pending[ i ] ].key;
+				const float roughness = static_cast< float >( key >> 5 & 7u ) / ( ROUGHNESS_BUCKETS - 1 );
+				const float branching = static_cast< float >( key >> 3 & 3u ) / ( BRANCHING_BUCKETS - 1 );
+				generateShape( static_cast< int >( key >> 8 ) + MIN_DETAIL, roughness, branching, Random::derive( SHAPE_SEED, key ).nextU64(), generated[ i ] );
+			}
+		} );
+		for ( size_t i = 0; i < pending.size(); i++ ) {
+			Shape& shape = shapes[ pending[ i ] ];
+			shape.firstSegment = static_cast< int32_t >( segments.size() );
+			shape.segmentCount = static_cast< int32_t >( generated[ i ].size() );
+			segments.insert( segments.end(), generated[ i ].begin(), generated[ i ].end() );
+			int32_t& most = levelSegments[ shape.key >> 8 ];
+			most = std::max( most, shape.segmentCount );
+		}
+		pending.clear();
+	}
+	bolts.insert( bolts.end(), struck.begin(), struck.end() );
+	struck.clear();
+	for ( Bolt& bolt : bolts ) {
+		bolt.instance.firstSegment = shapes[ bolt.shape ].firstSegment;
+		bolt.instance.segmentCount = shapes[ bolt.shape ].segmentCount;
+	}
+
+	const double writeMs = stats.writeMs;
+	const uint32_t drawCalls = stats.drawCalls;
+	stats = LightningStats();
+	stats.generateMs = elapsedMs( start );
+	stats.writeMs = writeMs;
+	stats.drawCalls = drawCalls;
+	stats.bolts = getBoltCount();
+	stats.shapes = static_cast< uint32_t >( shapes.size() );
+	stats.segments = static_cast< uint32_t >( segments.size() );
+	stats.cacheHits = strikeHits;
+	stats.cacheMisses = strikeMisses;
+	strikeHits = strikeMisses = 0;
+}
+
+uint32_t LightningSystem::writeInstances( LightningInstance* out ) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	// A counting sort by detail level, so each level is one contiguous instance range.
+	for ( int level = 0; level < DETAIL_LEVELS; level++ ) levelCount[ level ] = 0;
+	for ( const Bolt& bolt : bolts ) levelCount[ bolt.level ]++;
+	uint32_t cursor[ DETAIL_LEVELS ];
+	uint32_t first = 0;
+	for ( int level = 0; level < DETAIL_LEVELS; level++ ) {
+		levelFirst[ level ] = cursor[ level ] = first;
+		first += levelCount[ level ];
+	}
+	for ( const Bolt& bolt : bolts ) out[ cursor[ bolt.level ]++ ] = bolt.instance;
+	stats.writeMs = elapsedMs( start );
+	return getBoltCount();
+}
+
+void LightningSystem::render( const glm::mat4& projection, float time ) {
+	stats.drawCalls = 0;
+	const uint32_t count = getBoltCount();
+	if ( !glReady || count == 0 ) return;
+
+	glBindVertexArray( vao );
+	if ( uploadedSegments != segments.size() ) {
+		// The cache only grows between clears and settles within a few seconds of play, so a full re-upload is rare.
+		glBindBuffer( GL_TEXTURE_BUFFER, segmentBuffer );
+		glBufferData( GL_TEXTURE_BUFFER, static_cast< GLsizeiptr >( segments.size() * sizeof( LightningSegment ) ), segments.data(), GL_STATIC_DRAW );
+		glBindTexture( GL_TEXTURE_BUFFER, segmentTexture );
+		glTexBuffer( GL_TEXTURE_BUFFER, GL_RGBA32F, segmentBuffer );
+		uploadedSegments = segments.size();
+	}
+
+	glBindBuffer( GL_ARRAY_BUFFER, instanceVbo );
+	if ( count > instanceCapacity ) {
+		instanceCapacity = count + count / 2;
+		glBufferData( GL_ARRAY_BUFFER, static_cast< GLsizeiptr >( instanceCapacity * sizeof( LightningInstance ) ), nullptr, GL_STREAM_DRAW );
+	}
+	void* mapped = glMapBufferRange( GL_ARRAY_BUFFER, 0, static_cast< GLsizeiptr >( count * sizeof( LightningInstance ) ),
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+	if ( !mapped ) {
+		LOG_ERROR( "Failed to map the lightning instance buffer." );
+		glBindVertexArray( 0 );
+		return;
+	}
+	writeInstances( static_cast< LightningInstance* >( mapped ) );
+	if ( !glUnmapBuffer( GL_ARRAY_BUFFER ) ) {
+		glBindVertexArray( 0 );
+		return;
+	}
+
+	glUseProgram( program );
+	glUniformMatrix4fv( projectionLocation, 1, GL_FALSE, &projection[ 0 ][ 0 ] );
+	glUniform1f( timeLocation, time );
+	glUniform1f( jitterLocation, jitter );
+	glActiveTexture( GL_TEXTURE0 );
+	glBindTexture( GL_TEXTURE_BUFFER, segmentTexture );
+	glEnable( GL_BLEND );
+	glBlendFunc( GL_SRC_ALPHA, GL_ONE );
+	for ( int i = 0; i < 4; i++ ) {
+		glEnableVertexAttribArray( i );
+		glVertexAttribDivisor( i, 1 );
+	}
+	for ( int level = 0; level < DETAIL_LEVELS; level++ ) {
+		if ( !levelCount[ level ] ) continue;
+		// GL 3.3 has no base instance, so each level's range is selected by offsetting the attributes.
+		const size_t base = levelFirst[ level ] * sizeof( LightningInstance );
+		glVertexAttribPointer( 0, 4, GL_FLOAT, GL_FALSE, sizeof( LightningInstance ), reinterpret_cast< void* >( base + offsetof( LightningInstance, startX ) ) );
+		glVertexAttribPointer( 1, 4, GL_FLOAT, GL_FALSE, sizeof( LightningInstance ), reinterpret_cast< void* >( base + offsetof( LightningInstance, width ) ) );
+		glVertexAttribPointer( 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof( LightningInstance ), reinterpret_cast< void* >( base + offsetof( LightningInstance, color ) ) );
+		glVertexAttribIPointer( 3, 2, GL_INT, sizeof( LightningInstance ), reinterpret_cast< void* >( base + offsetof( LightningInstance, firstSegment ) ) );
+		glDrawArraysInstanced( GL_TRIANGLES, 0, levelSegments[ level ] * 6, static_cast< GLsizei >( levelCount[ level ] ) );
+		stats.drawCalls++;
+	}
+	glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+	glBindVertexArray( 0 );
+}
+
+void LightningSystem::clearCache() {
+	bolts.clear();
+	struck.clear();
+	shapes.clear();
+	shapeIndex.clear();
+	pending.clear();
+	segments.clear();
+	for ( int level = 0; level < DETAIL_LEVELS; level++ ) levelSegments[ level ] = 0;
+	uploadedSegments = static_cast< size_t >( -1 );
+}
@@ -0,0 +1,518 @@
+#ifdef _WIN32
+#include <io.h> // Required for _write and _fileno.
+#else
+#include <unistd.h> // Required for write.
+#endif
+
+#include <cerrno> // Required to retry interrupted writes and keep errno across the signal handler.
+#include <csignal> // Required for the fatal signal handlers.
+#include <exception> // Required for std::set_terminate.
+#include <iostream> // Required for std::cerr when the log file cannot be opened.
+
+#include "Log.h" // Includes the Logger class definition.
+
+Logger Logger::instance;
+thread_local Logger::Ring* Logger::threadRing = nullptr;
+
+const size_t Logger::MAX_STRING;
+const uint32_t Logger::PADDING;
+
+static const char* LEVEL_PREFIXES[] = { "Trace: ", "Debug: ", "Info: ", "Warn: ", "Err: ", "Fatal: " };
+static const int FATAL_SIGNALS[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+static const int FATAL_SIGNAL_COUNT = sizeof( FATAL_SIGNALS ) / sizeof( FATAL_SIGNALS[ 0 ] );
+#ifdef _WIN32
+static void ( *previousSignals[ FATAL_SIGNAL_COUNT ] )( int ) = {};
+#else
+static struct sigaction previousSignals[ FATAL_SIGNAL_COUNT ];
+#endif
+static std::terminate_handler previousTerminate = nullptr;
+static bool handlersInstalled = false; // Installed by init() and restored by shutdown(), so a second init() never chains to itself.
+
+/**
+ * @brief Writes all of a buffer to a file descriptor; async-signal-safe.
+ * @param descriptor The descriptor, or -1 to do nothing.
+ * @param data The bytes.
+ * @param size Their count.
+ */
+static void writeAll( int descriptor, const char* data, size_t size ) {
+	while ( descriptor >= 0 && size > 0 ) {
+#ifdef _WIN32
+		const int count = _write( descriptor, data, static_cast< unsigned >( size ) );
+#else
+		const ssize_t count = write( descriptor, data, size );
+#endif
+		if ( count < 0 && errno == EINTR ) continue;
+		if ( count <= 0 ) return;
+		data += count;
+		size -= static_cast< size_t >( count );
+	}
+}
+
+/**
+ * @brief Writes an unsigned number in a base into the end of a buffer, without locale or allocation.
+ * @param value The number.
+ * @param base 10 or 16.
+ * @param end One past the last character to write.
+ * @return The first character written.
+ */
+static char* formatUnsigned( uint64_t value, unsigned base, char* end ) {
+	do {
+		*--end = "0123456789abcdef"[ value % base ];
+		value /= base;
+	} while ( value );
+	return end;
+}
+
+/**
+ * @brief Collects formatted messages in a string; used by the writer thread and synchronous writes.
+ */
+struct StringSink
+{
+	std::string& out;
+
+	void append( const char* data, size_t size ) { out.append( data, size ); }
+	void append( char c ) { out += c; }
+	/**
+	 * @brief Appends a floating-point number.
+	 * @param value The number.
+	 * @param width The minimum width, padded with spaces on the left.
+	 * @param precision Digits after the point, or -1 for the shortest of fixed and exponent notation.
+	 */
+	void appendDouble( double value, int width, int precision ) {
+		char number[ 64 ];
+		const int length = precision < 0 ? std::snprintf( number, sizeof( number ), "%*g", width, value ) :
+			std::snprintf( number, sizeof( number ), "%*.*f", width, precision, value );
+		if ( length > 0 ) out.append( number, std::min( static_cast< size_t >( length ), sizeof( number ) - 1 ) );
+	}
+};
+
+/**
+ * @brief Collects formatted messages in a static buffer and writes it out with write(2) whenever it fills.
+ * Only used by the crash handlers, which must not allocate, lock or call stdio; there is one at a time.
+ */
+class CrashSink
+{
+public:
+	/**
+	 * @param console The descriptor of the console, or -1.
+	 * @param file The descriptor of the log file, or -1.
+	 */
+	CrashSink( int console, int file ) : console( console ), file( file ) {}
+
+	void append( const char* data, size_t size ) {
+		while ( size > 0 ) {
+			if ( used == sizeof( buffer ) ) flush();
+			const size_t count = std::min( size, sizeof( buffer ) - used );
+			std::memcpy( buffer + used, data, count );
+			used += count;
+			data += count;
+			size -= count;
+		}
+	}
+	void append( char c ) { append( &c, 1 ); }
+	/**
+	 * @brief Appends a floating-point number in fixed notation.
+	 * @param value The number.
+	 * @param width The minimum width, padded with spaces on the left.
+	 * @param precision Digits after the point, or -1 for up to six with trailing zeros removed.
+	 */
+	void appendDouble( double value, int width, int precision ) {
+		char number[ 48 ];
+		char* const end = number + sizeof( number );
+		char* first = end;
+		const bool negative = value < 0.0;
+		if ( negative ) value = -value;
+		if ( value != value || value >= 1e18 ) {
+			first -= 3;
+			std::memcpy( first, value != value ? "nan" : "inf", 3 );
+		}
+		else {
+			int digits = precision < 0 ? 6 : std::min( precision, 9 );
+			uint64_t scale = 1;
+			for ( int i = 0; i < digits; i++ ) scale *= 10;
+			uint64_t whole = static_cast< uint64_t >( value );
+			uint64_t fraction = static_cast< uint64_t >( ( value - static_cast< double >( whole ) ) * static_cast< double >( scale ) + 0.5 );
+			if ( fraction >= scale ) {
+				whole++;
+				fraction -= scale;
+			}
+			while ( precision < 0 && digits > 0 && fraction % 10 == 0 ) {
+				fraction /= 10;
+				scale /= 10;
+				digits--;
+			}
+			if ( digits > 0 ) {
+				first = formatUnsigned( fraction + scale, 10, end ) + 1; // The leading 1 keeps the zeros after the point.
+				*--first = '.';
+			}
+			first = formatUnsigned( whole, 10, first );
+		}
+		if ( negative ) *--first = '-';
+		while ( end - first < width && first > number ) *--first = ' ';
+		append( first, static_cast< size_t >( end - first ) );
+	}
+	/**
+	 * @brief Writes what has been collected to the console and the log file.
+	 */
+	void flush() {
+		writeAll( console, buffer, used );
+		writeAll( file, buffer, used );
+		used = 0;
+	}
+
+private:
+	static char buffer[ 8192 ];
+	size_t used = 0;
+	int console;
+	int file;
+};
+
+char CrashSink::buffer[ 8192 ];
+
+Logger::Logger() : startTime( now() ), secondsPerTick( 1e-9 ) {
+#if ARCANTHA_LOG_TSC
+	// Count ticks over two milliseconds of the steady clock; invariant counters tick at a constant rate.
+	const auto begin = std::chrono::steady_clock::now();
+	const uint64_t beginTicks = now();
+	while ( std::chrono::steady_clock::now() - begin < std::chrono::milliseconds( 2 ) ) {}
+	const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+	secondsPerTick = seconds / static_cast< double >( now() - beginTicks );
+#endif
+}
+
+Logger::~Logger() {
+	if ( writer.joinable() ) shutdown();
+}
+
+Logger& Logger::getInstance() {
+	return instance;
+}
+
+bool Logger::init( const LogSettings& settings ) {
+	if ( running ) shutdown();
+	this->settings = settings;
+	size_t capacity = 4096;
+	while ( capacity < settings.ringBytes ) capacity <<= 1;
+	this->settings.ringBytes = capacity;
+
+	bool opened = true;
+	if ( !settings.filePath.empty() ) {
+		file = std::fopen( settings.filePath.c_str(), "w" );
+		if ( !file ) {
+			std::cerr << "Err: Failure to open log file " << settings.filePath << "." << std::endl;
+			opened = false;
+		}
+#ifdef _WIN32
+		else fileDescriptor = _fileno( file );
+#else
+		else fileDescriptor = fileno( file );
+#endif
+	}
+	if ( settings.crashHandlers && !handlersInstalled ) {
+		handlersInstalled = true;
+		for ( int i = 0; i < FATAL_SIGNAL_COUNT; i++ ) {
+#ifdef _WIN32
+			previousSignals[ i ] = std::signal( FATAL_SIGNALS[ i ], onSignal );
+#else
+			struct sigaction action = {};
+			action.sa_sigaction = onSignal;
+			action.sa_flags = SA_SIGINFO;
+			sigemptyset( &action.sa_mask );
+			sigaction( FATAL_SIGNALS[ i ], &action, &previousSignals[ i ] );
+#endif
+		}
+		previousTerminate = std::set_terminate( onTerminate );
+	}
+
+	running = true;
+	writer = std::thread( &Logger::run, this );
+	return opened;
+}
+
+void Logger::shutdown() {
+	if ( running ) {
+		running = false;
+		wake.notify_one();
+	}
+	if ( writer.joinable() ) writer.join();
+	flush();
+	if ( handlersInstalled ) {
+		handlersInstalled = false;
+		for ( int i = 0; i < FATAL_SIGNAL_COUNT; i++ ) {
+#ifdef _WIN32
+			if ( previousSignals[ i ] != SIG_ERR ) std::signal( FATAL_SIGNALS[ i ], previousSignals[ i ] );
+#else
+			sigaction( FATAL_SIGNALS[ i ], &previousSignals[ i ], nullptr );
+#endif
+		}
+		std::set_terminate( previousTerminate );
+		previousTerminate = nullptr;
+	}
+	if ( file ) {
+		fileDescriptor = -1;
+		std::fclose( file );
+		file = nullptr;
+	}
+}
+
+void Logger::flush() {
+	std::lock_guard<std::mutex> lock( drainMutex );
+	drainLocked();
+}
+
+LogStats Logger::getStats() const {
+	LogStats stats;
+	stats.written = written.load();
+	stats.suppressed = suppressed.load();
+	std::lock_guard<std::mutex> lock( ringsMutex );
+	for ( const std::unique_ptr<Ring>& ring : rings ) stats.dropped += ring->dropped.load();
+	stats.threads = static_cast< uint32_t >( rings.size() );
+	return stats;
+}
+
+bool Logger::admit( LogSite& site, uint64_t time, uint32_t& held ) {
+	if ( settings.rateLimit == 0 ) return true;
+	// The thread that moves the site into a new second resets its count and reports what was held back.
+	const uint64_t window = static_cast< uint64_t >( static_cast< double >( static_cast< int64_t >( time - startTime ) ) * secondsPerTick );
+	uint64_t current = site.window.load( std::memory_order_relaxed );
+	if ( window != current && site.window.compare_exchange_strong( current, window, std::memory_order_relaxed ) ) {
+		site.count.store( 0, std::memory_order_relaxed );
+		held = site.held.exchange( 0, std::memory_order_relaxed );
+	}
+	if ( site.count.fetch_add( 1, std::memory_order_relaxed ) < settings.rateLimit ) return true;
+	site.held.fetch_add( 1, std::memory_order_relaxed );
+	suppressed.fetch_add( 1, std::memory_order_relaxed );
+	return false;
+}
+
+Logger::Ring& Logger::registerThread() {
+	std::unique_ptr<Ring> ring( new Ring() );
+	ring->capacity = settings.ringBytes;
+	ring->data.reset( new char[ ring->capacity ] );
+	threadRing = ring.get();
+	std::lock_guard<std::mutex> lock( ringsMutex );
+	ring->next = lastRing.load( std::memory_order_relaxed );
+	lastRing.store( ring.get(), std::memory_order_release );
+	rings.push_back( std::move( ring ) );
+	return *threadRing;
+}
+
+void Logger::writeNow( const Record& record ) {
+	std::string line;
+	StringSink sink{ line };
+	format( record, sink );
+	std::lock_guard<std::mutex> lock( outputMutex );
+	output( line.data(), line.size() );
+	written.fetch_add( 1, std::memory_order_relaxed );
+}
+
+template <typename Sink>
+void Logger::format( const Record& record, Sink& out ) const {
+	char number[ 24 ];
+	char* const end = number + sizeof( number );
+	const auto appendUnsigned = [ & ]( uint64_t value, unsigned base ) {
+		const char* first = formatUnsigned( value, base, end );
+		out.append( first, static_cast< size_t >( end - first ) );
+	};
+	const auto appendText = [ & ]( const char* text ) { out.append( text, std::strlen( text ) ); };
+
+	const double seconds = static_cast< double >( static_cast< int64_t >( record.time - startTime ) ) * secondsPerTick;
+	out.append( '[' );
+	out.appendDouble( seconds, 10, 3 );
+	out.append( "] ", 2 );
+	appendText( LEVEL_PREFIXES[ static_cast< int >( record.site->level ) ] );
+
+	const char* in = reinterpret_cast< const char* >( &record ) + sizeof( Record );
+	uint32_t remaining = record.argCount;
+	const auto appendArg = [ & ]() {
+		const ArgType type = static_cast< ArgType >( *in++ );
+		switch ( type ) {
+		case ArgType::Int: {
+			int64_t value;
+			std::memcpy( &value, in, sizeof( value ) );
+			in += sizeof( value );
+			if ( value < 0 ) out.append( '-' );
+			appendUnsigned( value < 0 ? 0 - static_cast< uint64_t >( value ) : static_cast< uint64_t >( value ), 10 );
+			break;
+		}
+		case ArgType::UInt: {
+			uint64_t value;
+			std::memcpy( &value, in, sizeof( value ) );
+			in += sizeof( value );
+			appendUnsigned( value, 10 );
+			break;
+		}
+		case ArgType::Double: {
+			double value;
+			std::memcpy( &value, in, sizeof( value ) );
+			in += sizeof( value );
+			out.appendDouble( value, 0, -1 );
+			break;
+		}
+		case ArgType::Bool:
+			appendText( *in++ ? "true" : "false" );
+			break;
+		case ArgType::Char:
+			out.append( *in++ );
+			break;
+		case ArgType::String: {
+			uint16_t length;
+			std::memcpy( &length, in, sizeof( length ) );
+			out.append( in + sizeof( length ), length );
+			in += sizeof( length ) + length;
+			break;
+		}
+		case ArgType::Pointer: {
+			uint64_t value;
+			std::memcpy( &value, in, sizeof( value ) );
+			in += sizeof( value );
+			out.append( "0x", 2 );
+			appendUnsigned( value, 16 );
+			break;
+		}
+		}
+	};
+
+	for ( const char* c = record.format; *c; c++ ) {
+		if ( c[ 0 ] == '{' && c[ 1 ] == '}' && remaining > 0 ) {
+			appendArg();
+			remaining--;
+			c++;
+		}
+		else out.append( *c );
+	}
+	// Arguments without a placeholder are appended rather than lost.
+	while ( remaining-- > 0 ) {
+		out.append( ' ' );
+		appendArg();
+	}
+
+	if ( record.site->level >= LogLevel::Error ) {
+		const char* file = record.site->file;
+		for ( const char* c = file; *c; c++ ) {
+			if ( *c == '/' || *c == '\\' ) file = c + 1;
+		}
+		out.append( " (", 2 );
+		appendText( file );
+		out.append( ':' );
+		appendUnsigned( static_cast< uint64_t >( record.site->line ), 10 );
+		out.append( ')' );
+	}
+	if ( record.held > 0 ) {
+		out.append( " [", 2 );
+		appendUnsigned( record.held, 10 );
+		appendText( " similar messages suppressed]" );
+	}
+	out.append( '\n' );
+}
+
+template <typename Sink>
+uint64_t Logger::consume( Ring& ring, Sink& out ) {
+	uint64_t count = 0;
+	size_t head = ring.head.load( std::memory_order_relaxed );
+	const size_t tail = ring.tail.load( std::memory_order_acquire );
+	while ( head != tail ) {
+		const char* at = ring.data.get() + ( head & ( ring.capacity - 1 ) );
+		uint32_t size;
+		std::memcpy( &size, at, sizeof( size ) );
+		if ( !( size & PADDING ) ) {
+			format( *reinterpret_cast< const Record* >( at ), out );
+			count++;
+		}
+		head += size & ~PADDING;
+	}
+	ring.head.store( head, std::memory_order_release );
+	return count;
+}
+
+void Logger::drainLocked() {
+	uint64_t count = 0;
+	StringSink sink{ text };
+	for ( Ring* ring = lastRing.load( std::memory_order_acquire ); ring; ring = ring->next ) {
+		// A crash handler that took the ring keeps it, so it is never read by two threads.
+		if ( ring->consuming.exchange( true, std::memory_order_acquire ) ) continue;
+		count += consume( *ring, sink );
+		ring->consuming.store( false, std::memory_order_release );
+	}
+
+	if ( !text.empty() ) {
+		std::lock_guard<std::mutex> lock( outputMutex );
+		output( text.data(), text.size() );
+		text.clear();
+	}
+	written.fetch_add( count, std::memory_order_relaxed );
+}
+
+void Logger::output( const char* data, size_t size ) {
+	if ( settings.console ) {
+		std::fwrite( data, 1, size, stderr );
+		std::fflush( stderr );
+	}
+	if ( file ) {
+		std::fwrite( data, 1, size, file );
+		std::fflush( file );
+	}
+}
+
+void Logger::run() {
+	while ( running.load( std::memory_order_acquire ) ) {
+		{
+			std::unique_lock<std::mutex> lock( wakeMutex );
+			wake.wait_for( lock, std::chrono::milliseconds( settings.flushIntervalMs ) );
+		}
+		flush();
+	}
+}
+
+void Logger::crashFlush() {
+	if ( crashed.exchange( true ) ) return;
+	// No locks: the writer thread may hold them, or be this thread. Rings it is draining are skipped.
+	CrashSink sink( settings.console ? 2 : -1, fileDescriptor );
+	uint64_t count = 0;
+	for ( Ring* ring = lastRing.load( std::memory_order_acquire ); ring; ring = ring->next ) {
+		if ( ring->consuming.exchange( true, std::memory_order_acquire ) ) continue;
+		count += consume( *ring, sink );
+	}
+	sink.flush();
+	written.fetch_add( count, std::memory_order_relaxed );
+}
+
+#ifdef _WIN32
+
+void Logger::onSignal( int signal ) {
+	instance.crashFlush();
+	int slot = 0;
+	while ( slot < FATAL_SIGNAL_COUNT - 1 && FATAL_SIGNALS[ slot ] != signal ) slot++;
+	void ( *previous )( int ) = previousSignals[ slot ];
+	if ( previous != SIG_DFL && previous != SIG_IGN && previous != SIG_ERR && previous ) return previous( signal );
+	std::signal( signal, SIG_DFL );
+	std::raise( signal );
+}
+
+#else
+
+void Logger::onSignal( int signal, siginfo_t* info, void* context ) {
+	const int error = errno;
+	instance.crashFlush();
+	errno = error;
+
+	// Put the previous handler back and hand it the signal. If it returns, or is the default action, the
+	// signal raised here or the faulting instruction run again is delivered to it once this handler returns.
+	int slot = 0;
+	while ( slot < FATAL_SIGNAL_COUNT - 1 && FATAL_SIGNALS[ slot ] != signal ) slot++;
+	const struct sigaction& previous = previousSignals[ slot ];
+	sigaction( signal, &previous, nullptr );
+	if ( previous.sa_flags & SA_SIGINFO ) {
+		if ( previous.sa_sigaction ) previous.sa_sigaction( signal, info, context );
+	}
+	else if ( previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN ) previous.sa_handler( signal );
+	else raise( signal );
+}
+
+#endif
+
+void Logger::onTerminate() {
+	instance.crashFlush();
+	if ( previousTerminate ) previousTerminate();
+	std::abort();
+}
@@ -0,0 +1,113 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h> // Required for CreateFileMapping and MapViewOfFile.
+#else
+#include <fcntl.h> // Required for open.
+#include <sys/mman.h> // Required for mmap, munmap and madvise.
+#include <sys/stat.h> // Required for fstat to get the file size.
+#include <unistd.h> // Required for close and sysconf.
+#endif
+
+#include "MappedFile.h" // Includes the MappedFile class definition.
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open( const std::string& path ) {
+	close();
+
+	HANDLE file = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	if ( file == INVALID_HANDLE_VALUE ) return false;
+
+	LARGE_INTEGER fileSize;
+	if ( !GetFileSizeEx( file, &fileSize ) || fileSize.QuadPart == 0 ) {
+		CloseHandle( file );
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	if ( !mapping ) {
+		CloseHandle( file );
+		return false;
+	}
+
+	void* view = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	if ( !view ) {
+		CloseHandle( mapping );
+		CloseHandle( file );
+		return false;
+	}
+
+	fileHandle = file;
+	mappingHandle = mapping;
+	bytes = static_cast< const uint8_t* >( view );
+	length = static_cast< size_t >( fileSize.QuadPart );
+	return true;
+}
+
+void MappedFile::close() {
+	if ( bytes ) UnmapViewOfFile( bytes );
+	if ( mappingHandle ) CloseHandle( mappingHandle );
+	if ( fileHandle ) CloseHandle( fileHandle );
+	bytes = nullptr;
+	length = 0;
+	fileHandle = mappingHandle = nullptr;
+}
+
+void MappedFile::adviseSequential() const {
+	// FILE_FLAG_SEQUENTIAL_SCAN was passed at open.
+}
+
+void MappedFile::release( size_t offset, size_t length ) const {
+	// Unlocking a range that was never locked trims it from the working set.
+	if ( bytes && length ) VirtualUnlock( const_cast< uint8_t* >( bytes ) + offset, length );
+}
+
+#else
+
+bool MappedFile::open( const std::string& path ) {
+	close();
+
+	int fd = ::open( path.c_str(), O_RDONLY );
+	if ( fd < 0 ) return false;
+
+	struct stat info;
+	if ( fstat( fd, &info ) != 0 || info.st_size == 0 ) {
+		::close( fd );
+		return false;
+	}
+
+	void* view = mmap( nullptr, static_cast< size_t >( info.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+	::close( fd ); // The mapping keeps its own reference to the file.
+	if ( view == MAP_FAILED ) return false;
+
+	bytes = static_cast< const uint8_t* >( view );
+	length = static_cast< size_t >( info.st_size );
+	return true;
+}
+
+void MappedFile::close() {
+	if ( bytes ) munmap( const_cast< uint8_t* >( bytes ), length );
+	bytes = nullptr;
+	length = 0;
+}
+
+void MappedFile::adviseSequential() const {
+	if ( bytes ) madvise( const_cast< uint8_t* >( bytes ), length, MADV_SEQUENTIAL );
+}
+
+void MappedFile::release( size_t offset, size_t length ) const {
+	if ( !bytes || offset >= this->length ) return;
+	if ( length > this->length - offset ) length = this->length - offset;
+
+	// madvise needs page-aligned ranges.
+	static const size_t pageSize = static_cast< size_t >( sysconf( _SC_PAGESIZE ) );
+	size_t begin = offset / pageSize * pageSize;
+	size_t end = ( offset + length ) / pageSize * pageSize;
+	if ( end > begin ) madvise( const_cast< uint8_t* >( bytes ) + begin, end - begin, MADV_DONTNEED );
+}
+
+#endif
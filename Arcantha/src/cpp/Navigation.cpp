@@ -0,0 +1,466 @@
+#include <algorithm> // Required for std::push_heap, std::pop_heap, std::reverse and std::max.
+#include <chrono> // Required for the per-frame search deadline.
+#include <cmath> // Required for std::sqrt and std::floor.
+#include <cstdlib> // Required for std::abs.
+
+#include "JobSystem.h" // Includes the JobSystem used to advance searches in parallel.
+#include "Navigation.h" // Includes the navigation class definitions.
+
+static const float JUMP_PENALTY = 2.0f; // Extra cost of a jump so walking is preferred when it is not much longer.
+
+static int64_t nowNs() {
+	return std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+static int chebyshev( glm::ivec2 a, glm::ivec2 b ) {
+	return std::max( std::abs( a.x - b.x ), std::abs( a.y - b.y ) );
+}
+
+void NavGraph::build( const TileMap& map, const NavArchetype& archetype ) {
+	this->archetype = archetype;
+	width = map.getWidth();
+	height = map.getHeight();
+	nodes.clear();
+	edges.clear();
+	firstEdge.clear();
+	cellToNode.assign( static_cast< size_t >( width ) * height, -1 );
+	solid.assign( static_cast< size_t >( width ) * height, 0 );
+
+	for ( int y = 0; y < height; y++ ) {
+		for ( int x = 0; x < width; x++ ) {
+			const size_t cell = static_cast< size_t >( y ) * width + x;
+			solid[ cell ] = map.isSolid( x, y );
+			if ( archetype.flying ? isOpen( map, x, y ) : canStand( map, x, y ) ) {
+				cellToNode[ cell ] = static_cast< int32_t >( nodes.size() );
+				nodes.push_back( glm::ivec2( x, y ) );
+			}
+		}
+	}
+
+	auto nodeAt = [ this ]( int x, int y ) -> int32_t {
+		if ( x < 0 || y < 0 || x >= width || y >= height ) return -1;
+		return cellToNode[ static_cast< size_t >( y ) * width + x ];
+	};
+	auto addEdge = [ this ]( int32_t to, float cost, NavLinkType type ) {
+		edges.push_back( { static_cast< uint32_t >( to ), cost, type } );
+	};
+
+	firstEdge.reserve( nodes.size() + 1 );
+	for ( const glm::ivec2& node : nodes ) {
+		firstEdge.push_back( static_cast< uint32_t >( edges.size() ) );
+		const int x = node.x, y = node.y;
+
+		if ( archetype.flying ) {
+			for ( int dy = -1; dy <= 1; dy++ ) {
+				for ( int dx = -1; dx <= 1; dx++ ) {
+					if ( !dx && !dy ) continue;
+					int32_t target = nodeAt( x + dx, y + dy );
+					if ( target < 0 ) continue;
+					if ( dx && dy && ( nodeAt( x + dx, y ) < 0 || nodeAt( x, y + dy ) < 0 ) ) continue; // No corner cutting.
+					addEdge( target, ( dx && dy ) ? 1.41421356f : 1.0f, NavLinkType::Fly );
+				}
+			}
+			continue;
+		}
+
+		for ( int dir = -1; dir <= 1; dir += 2 ) {
+			// Walk to the neighbouring tile of the same surface.
+			int32_t target = nodeAt( x + dir, y );
+			if ( target >= 0 ) {
+				addEdge( target, 1.0f, NavLinkType::Walk );
+				continue;
+			}
+
+			// Walk off the ledge and land on the first surface below.
+			if ( !isOpen( map, x + dir, y ) ) continue;
+			for ( int fy = y - 1; fy >= y - archetype.maxDrop; fy-- ) {
+				if ( !isOpen( map, x + dir, fy ) ) break;
+				target = nodeAt( x + dir, fy );
+				if ( target >= 0 ) {
+					addEdge( target, 1.0f + ( y - fy ), NavLinkType::Fall );
+					break;
+				}
+			}
+		}
+
+		// Drop through a one-way platform.
+		if ( map.get( x, y - 1 ) == Tile::Platform ) {
+			for ( int fy = y - 1; fy >= y - 1 - archetype.maxDrop; fy-- ) {
+				if ( !isOpen( map, x, fy ) ) break;
+				int32_t target = nodeAt( x, fy );
+				if ( target >= 0 ) {
+					addEdge( target, static_cast< float >( y - fy ), NavLinkType::Fall );
+					break;
+				}
+			}
+		}
+
+		// Jumps to every surface the arc can reach; short hops down are covered by falls.
+		if ( archetype.jumpHeight <= 0 ) continue;
+		for ( int dy = -archetype.maxDrop; dy <= archetype.jumpHeight; dy++ ) {
+			for ( int dx = -archetype.jumpDistance; dx <= archetype.jumpDistance; dx++ ) {
+				if ( dx == 0 && dy <= 0 ) continue;
+				if ( std::abs( dx ) <= 1 && dy <= 0 ) continue;
+				int32_t target = nodeAt( x + dx, y + dy );
+				if ( target < 0 ) continue;
+
+				if ( dy == 0 ) {
+					// Skip gaps that are not gaps: the surface is continuous, so walking covers it.
+					bool continuous = true;
+					for ( int i = 1; i < std::abs( dx ) && continuous; i++ ) continuous = nodeAt( x + ( dx > 0 ? i : -i ), y ) >= 0;
+					if ( continuous ) continue;
+				}
+				if ( !isArcClear( map, node, glm::ivec2( x + dx, y + dy ) ) ) continue;
+				addEdge( target, static_cast< float >( std::abs( dx ) + std::abs( dy ) ) + JUMP_PENALTY, NavLinkType::Jump );
+			}
+		}
+	}
+	firstEdge.push_back( static_cast< uint32_t >( edges.size() ) );
+}
+
+int NavGraph::findNode( glm::ivec2 tile ) const {
+	auto nodeAt = [ this ]( int x, int y ) -> int32_t {
+		if ( x < 0 || y < 0 || x >= width || y >= height ) return -1;
+		return cellToNode[ static_cast< size_t >( y ) * width + x ];
+	};
+	auto isSolid = [ this ]( int x, int y ) {
+		if ( x < 0 || y < 0 || x >= width || y >= height ) return true;
+		return solid[ static_cast< size_t >( y ) * width + x ] != 0;
+	};
+
+	int32_t exact = nodeAt( tile.x, tile.y );
+	if ( exact >= 0 ) return exact;
+
+	const int offsets[] = { 0, -1, 1, -2, 2 };
+	for ( int ox : offsets ) {
+		const int x = tile.x + ox;
+		if ( archetype.flying ) {
+			for ( int oy : offsets ) {
+				int32_t node = nodeAt( x, tile.y + oy );
+				if ( node >= 0 ) return node;
+			}
+			continue;
+		}
+
+		// Airborne agents belong to the surface they will land on.
+		for ( int y = tile.y; y >= 0 && y >= tile.y - 2 * archetype.maxDrop; y-- ) {
+			if ( isSolid( x, y ) ) break;
+			int32_t node = nodeAt( x, y );
+			if ( node >= 0 ) return node;
+		}
+	}
+	return -1;
+}
+
+bool NavGraph::isOpen( const TileMap& map, int x, int y ) const {
+	if ( x < 0 || y < 0 || x >= map.getWidth() || y + archetype.clearance > map.getHeight() ) return false;
+	for ( int i = 0; i < archetype.clearance; i++ ) {
+		if ( map.isSolid( x, y + i ) ) return false;
+	}
+	return true;
+}
+
+bool NavGraph::canStand( const TileMap& map, int x, int y ) const {
+	const Tile below = map.get( x, y - 1 );
+	return isOpen( map, x, y ) && y > 0 && ( below == Tile::Solid || below == Tile::Platform );
+}
+
+bool NavGraph::isArcClear( const TileMap& map, glm::ivec2 from, glm::ivec2 to ) const {
+	const int dx = to.x - from.x, dy = to.y - from.y;
+	if ( dy > archetype.jumpHeight ) return false;
+
+	// Parabola y(t) = a t^2 + b t from (0, 0) to (1, dy) peaking one tile above the higher end.
+	const float apex = static_cast< float >( std::min( std::max( dy, 0 ) + 1, archetype.jumpHeight ) );
+	const float b = 2.0f * ( apex + std::sqrt( apex * ( apex - dy ) ) );
+	const float a = dy - b;
+
+	const int steps = 2 * ( std::abs( dx ) + 2 * static_cast< int >( apex ) - dy ) + 4;
+	for ( int i = 1; i < steps; i++ ) {
+		const float t = static_cast< float >( i ) / steps;
+		const float px = from.x + 0.5f + dx * t;
+		const float py = from.y + ( a * t + b ) * t;
+		const int cx = static_cast< int >( std::floor( px ) );
+		const int top = static_cast< int >( std::floor( py + archetype.clearance - 0.01f ) );
+		for ( int cy = static_cast< int >( std::floor( py ) ); cy <= top; cy++ ) {
+			if ( map.isSolid( cx, cy ) ) return false;
+		}
+	}
+	return true;
+}
+
+PathService::PathService( const TileMap& map ) : map( map ), searches( MAX_ACTIVE_SEARCHES ) {}
+
+int PathService::addArchetype( const NavArchetype& archetype ) {
+	archetypes.push_back( archetype );
+	graphs.emplace_back();
+	graphs.back().build( map, archetype );
+	return static_cast< int >( graphs.size() - 1 );
+}
+
+void PathService::rebuild() {
+	for ( size_t i = 0; i < graphs.size(); i++ ) graphs[ i ].build( map, archetypes[ i ] );
+
+	// Node indices changed, so nothing computed before is valid.
+	cache.clear();
+	pending.clear();
+	for ( Search& search : searches ) search.active = false;
+	activeCount = 0;
+	for ( Agent& agent : agents ) agent = Agent();
+}
+
+void PathService::requestPath( uint32_t agentId, int archetype, glm::vec2 from, glm::vec2 to ) {
+	stats.requests++;
+	if ( agentId >= agents.size() ) agents.resize( agentId + 1 );
+
+	Agent& agent = agents[ agentId ];
+	const bool sameArchetype = agent.archetype == archetype;
+	agent.serial++;
+	agent.archetype = archetype;
+	agent.prefix.clear();
+	if ( agent.search >= 0 ) {
+		searches[ agent.search ].active = false;
+		activeCount--;
+		agent.search = -1;
+	}
+
+	const NavGraph& graph = graphs[ archetype ];
+	const int start = graph.findNode( map.worldToTile( from ) );
+	const int goal = graph.findNode( map.worldToTile( to ) );
+	if ( start < 0 || goal < 0 ) {
+		agent.status = PathStatus::Failed;
+		agent.nodes.clear();
+		agent.path.clear();
+		return;
+	}
+
+	const bool hasPath = sameArchetype && !agent.nodes.empty() && ( agent.status == PathStatus::Ready || agent.status == PathStatus::Pending );
+	auto startInPath = std::find( agent.nodes.begin(), agent.nodes.end(), static_cast< uint32_t >( start ) );
+
+	// The current path already leads to the goal through the agent's position: just drop what is behind it.
+	if ( hasPath && agent.nodes.back() == static_cast< uint32_t >( goal ) && startInPath != agent.nodes.end() ) {
+		std::vector<uint32_t> remaining( startInPath, agent.nodes.end() );
+		assign( agent, std::move( remaining ) );
+		agent.status = PathStatus::Ready;
+		stats.cacheHits++;
+		return;
+	}
+
+	auto cached = cache.find( cacheKey( archetype, start, goal ) );
+	if ( cached != cache.end() ) {
+		cached->second.lastUse = ++useCounter;
+		assign( agent, cached->second.nodes );
+		agent.status = PathStatus::Ready;
+		stats.cacheHits++;
+		return;
+	}
+
+	// The goal moved a little: keep the path up to a few nodes before its old end and search only from there.
+	uint32_t searchStart = static_cast< uint32_t >( start );
+	if ( hasPath && startInPath != agent.nodes.end() &&
+		chebyshev( graph.getNodeTile( agent.nodes.back() ), graph.getNodeTile( goal ) ) <= REPATH_RADIUS ) {
+		const size_t from = static_cast< size_t >( startInPath - agent.nodes.begin() );
+		const size_t splice = std::max( from, agent.nodes.size() - 1 - std::min<size_t>( SPLICE_BACK, agent.nodes.size() - 1 ) );
+		agent.prefix.assign( agent.nodes.begin() + from, agent.nodes.begin() + splice );
+		searchStart = agent.nodes[ splice ];
+		stats.partialRepaths++;
+	}
+
+	agent.start = static_cast< int32_t >( searchStart );
+	agent.goal = goal;
+	agent.status = PathStatus::Pending;
+	if ( !agent.queued ) {
+		agent.queued = true;
+		pending.push_back( agentId );
+	}
+}
+
+void PathService::update( double budgetMs ) {
+	const int64_t deadline = nowNs() + static_cast< int64_t >( budgetMs * 1e6 );
+	std::vector<int> running;
+	running.reserve( searches.size() );
+
+	while ( true ) {
+		// Hand free slots to queued agents, skipping requests that were superseded or failed.
+		for ( int slot = 0; slot < static_cast< int >( searches.size() ) && !pending.empty(); slot++ ) {
+			if ( searches[ slot ].active ) continue;
+			while ( !pending.empty() ) {
+				uint32_t agentId = pending.front();
+				pending.pop_front();
+				Agent& agent = agents[ agentId ];
+				const bool waiting = agent.queued && agent.status == PathStatus::Pending;
+				agent.queued = false;
+				if ( waiting ) {
+					begin( slot, agentId );
+					break;
+				}
+			}
+		}
+		if ( activeCount == 0 ) break;
+
+		running.clear();
+		for ( int slot = 0; slot < static_cast< int >( searches.size() ); slot++ ) {
+			if ( searches[ slot ].active ) running.push_back( slot );
+		}
+		JobSystem::getInstance().parallelFor( running.size(), 1, [ & ]( size_t first, size_t last ) {
+			for ( size_t i = first; i < last; i++ ) advance( searches[ running[ i ] ], deadline );
+		} );
+
+		for ( int slot : running ) {
+			Search& search = searches[ slot ];
+			stats.expansions += search.expansions;
+			search.expansions = 0;
+			if ( search.done ) finish( slot );
+		}
+		if ( nowNs() >= deadline ) break; // Unfinished searches resume next frame.
+	}
+}
+
+PathStatus PathService::getStatus( uint32_t agent ) const {
+	return agent < agents.size() ? agents[ agent ].status : PathStatus::None;
+}
+
+const std::vector<NavWaypoint>& PathService::getPath( uint32_t agent ) const {
+	static const std::vector<NavWaypoint> empty;
+	return agent < agents.size() ? agents[ agent ].path : empty;
+}
+
+void PathService::begin( int slot, uint32_t agentId ) {
+	Agent& agent = agents[ agentId ];
+	Search& search = searches[ slot ];
+	const NavGraph& graph = graphs[ agent.archetype ];
+
+	search.active = true;
+	search.done = false;
+	search.found = false;
+	search.agent = agentId;
+	search.serial = agent.serial;
+	search.archetype = agent.archetype;
+	search.start = static_cast< uint32_t >( agent.start );
+	search.goal = static_cast< uint32_t >( agent.goal );
+	search.expansions = 0;
+
+	const size_t nodeCount = graph.getNodeCount();
+	if ( search.visited.size() < nodeCount ) {
+		search.g.resize( nodeCount );
+		search.parent.resize( nodeCount );
+		search.visited.resize( nodeCount, 0 );
+		search.closed.resize( nodeCount );
+	}
+	if ( ++search.stamp == 0 ) {
+		std::fill( search.visited.begin(), search.visited.end(), 0 );
+		search.stamp = 1;
+	}
+
+	search.open.clear();
+	search.visited[ search.start ] = search.stamp;
+	search.closed[ search.start ] = 0;
+	search.g[ search.start ] = 0.0f;
+	search.parent[ search.start ] = search.start;
+	search.open.push_back( { static_cast< float >( chebyshev( graph.getNodeTile( search.start ), graph.getNodeTile( search.goal ) ) ), search.start } );
+
+	agent.search = slot;
+	activeCount++;
+}
+
+void PathService::advance( Search& search, int64_t deadline ) const {
+	const NavGraph& graph = graphs[ search.archetype ];
+	const glm::ivec2 goalTile = graph.getNodeTile( search.goal );
+	auto greater = []( const OpenEntry& a, const OpenEntry& b ) { return a.f > b.f; };
+
+	// The clock is read on entry and every 32 pops, so a slot that starts late does not overrun the budget.
+	for ( uint32_t pops = 0; !search.open.empty(); pops++ ) {
+		if ( ( pops & 31 ) == 0 && nowNs() >= deadline ) return;
+
+		std::pop_heap( search.open.begin(), search.open.end(), greater );
+		const uint32_t node = search.open.back().node;
+		search.open.pop_back();
+		if ( search.closed[ node ] ) continue; // Stale duplicate of a node already expanded.
+		search.closed[ node ] = 1;
+		search.expansions++;
+
+		if ( node == search.goal ) {
+			search.found = true;
+			search.done = true;
+			return;
+		}
+
+		for ( uint32_t e = graph.getEdgeBegin( node ); e < graph.getEdgeBegin( node + 1 ); e++ ) {
+			const NavEdge& edge = graph.getEdge( e );
+			const float g = search.g[ node ] + edge.cost;
+			if ( search.visited[ edge.to ] == search.stamp ) {
+				if ( search.closed[ edge.to ] || g >= search.g[ edge.to ] ) continue;
+			}
+			else {
+				search.visited[ edge.to ] = search.stamp;
+				search.closed[ edge.to ] = 0;
+			}
+			search.g[ edge.to ] = g;
+			search.parent[ edge.to ] = node;
+			search.open.push_back( { g + static_cast< float >( chebyshev( graph.getNodeTile( edge.to ), goalTile ) ), edge.to } );
+			std::push_heap( search.open.begin(), search.open.end(), greater );
+		}
+	}
+	search.done = true;
+}
+
+void PathService::finish( int slot ) {
+	Search& search = searches[ slot ];
+	search.active = false;
+	activeCount--;
+
+	Agent& agent = agents[ search.agent ];
+	if ( agent.serial != search.serial ) return; // Superseded by a newer request.
+	agent.search = -1;
+
+	if ( !search.found ) {
+		agent.status = PathStatus::Failed;
+		agent.nodes.clear();
+		agent.path.clear();
+		stats.failed++;
+		return;
+	}
+
+	std::vector<uint32_t> nodes;
+	for ( uint32_t node = search.goal; node != search.start; node = search.parent[ node ] ) nodes.push_back( node );
+	nodes.push_back( search.start );
+	std::reverse( nodes.begin(), nodes.end() );
+	nodes.insert( nodes.begin(), agent.prefix.begin(), agent.prefix.end() );
+	agent.prefix.clear();
+
+	store( cacheKey( search.archetype, nodes.front(), search.goal ), nodes );
+	assign( agent, std::move( nodes ) );
+	agent.status = PathStatus::Ready;
+	stats.completed++;
+}
+
+void PathService::assign( Agent& agent, std::vector<uint32_t> nodes ) {
+	const NavGraph& graph = graphs[ agent.archetype ];
+	agent.nodes = std::move( nodes );
+	agent.path.clear();
+	agent.path.reserve( agent.nodes.size() );
+
+	for ( size_t i = 0; i < agent.nodes.size(); i++ ) {
+		NavLinkType link = NavLinkType::Walk;
+		if ( i > 0 ) {
+			for ( uint32_t e = graph.getEdgeBegin( agent.nodes[ i - 1 ] ); e < graph.getEdgeBegin( agent.nodes[ i - 1 ] + 1 ); e++ ) {
+				if ( graph.getEdge( e ).to == agent.nodes[ i ] ) {
+					link = graph.getEdge( e ).type;
+					break;
+				}
+			}
+		}
+		const glm::ivec2 tile = graph.getNodeTile( agent.nodes[ i ] );
+		agent.path.push_back( { map.tileCenter( tile.x, tile.y ), link } );
+	}
+}
+
+void PathService::store( uint64_t key, const std::vector<uint32_t>& nodes ) {
+	if ( cache.size() >= CACHE_CAPACITY && cache.find( key ) == cache.end() ) {
+		auto oldest = cache.begin();
+		for ( auto it = cache.begin(); it != cache.end(); ++it ) {
+			if ( it->second.lastUse < oldest->second.lastUse ) oldest = it;
+		}
+		cache.erase( oldest );
+	}
+	cache[ key ] = { nodes, ++useCounter };
+}
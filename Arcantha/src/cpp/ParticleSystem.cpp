@@ -0,0 +1,580 @@
+#include "ParticleSystem.h" // Includes the ParticleSystem class definition.
+
+#include <algorithm> // Required for std::min and std::max.
+#include <chrono> // Required for timing updates.
+#include <cmath> // Required for std::cos, std::sin and std::pow.
+#include <cstddef> // Required for offsetof.
+
+#include <glad/glad.h> // Includes GLAD for OpenGL function loading.
+
+#include "JobSystem.h" // Includes the JobSystem emitters are processed on.
+#include "Simd.h" // Includes the SSE/AVX capability switches.
+#include "Log.h" // Includes the Logger for error output.
+
+const uint32_t ParticleSystem::LANES;
+
+// Each instance is a quad around its center; the fragment shader fades it to a soft disc for additive glow.
+static const char* PARTICLE_VERTEX_SHADER = R"(#version 330 core
+layout( location = 0 ) in vec2 aCorner;
+layout( location = 1 ) in vec3 aInstance;
+layout( location = 2 ) in vec4 aColor;
+uniform mat4 uProjection;
+out vec2 vCorner;
+out vec4 vColor;
+void main() {
+	vCorner = aCorner * 2.0;
+	vColor = aColor;
+	gl_Position = uProjection * vec4( aInstance.xy + aCorner * aInstance.z, 0.0, 1.0 );
+}
+)";
+
+static const char* PARTICLE_FRAGMENT_SHADER = R"(#version 330 core
+in vec2 vCorner;
+in vec4 vColor;
+out vec4 fragColor;
+void main() {
+	float falloff = clamp( 1.0 - dot( vCorner, vCorner ), 0.0, 1.0 );
+	fragColor = vec4( vColor.rgb, vColor.a * falloff * falloff );
+}
+)";
+
+/**
+ * @brief Gets the milliseconds elapsed since a time point.
+ * @param since The start.
+ * @return Elapsed milliseconds.
+ */
+static double elapsedMs( std::chrono::steady_clock::time_point since ) {
+	return std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - since ).count();
+}
+
+/**
+ * @brief Compiles one shader stage.
+ * @param type GL_VERTEX_SHADER or GL_FRAGMENT_SHADER.
+ * @param source GLSL source.
+ * @return The shader, or 0 on failure.
+ */
+static GLuint compileShader( GLenum type, const char* source ) {
+	GLuint shader = glCreateShader( type );
+	glShaderSource( shader, 1, &source, nullptr );
+	glCompileShader( shader );
+	GLint ok = 0;
+	glGetShaderiv( shader, GL_COMPILE_STATUS, &ok );
+	if ( !ok ) {
+		char log[ 512 ];
+		glGetShaderInfoLog( shader, sizeof( log ), nullptr, log );
+		LOG_ERROR( "Particle shader failed to compile: {}", log );
+		glDeleteShader( shader );
+		return 0;
+	}
+	return shader;
+}
+
+/**
+ * @brief Converts a coordinate to a tile index of the bordered collision grid.
+ *
+ * The SIMD kernels floor the same way (truncate, then step down where that
+ * rounded up), so every kernel picks the same tile.
+ * @param meters The coordinate.
+ * @param inverseTileSize Tiles per meter.
+ * @param tiles Tiles along the axis.
+ * @return The tile, -1 to tiles inclusive; both ends are the solid border.
+ */
+static int toTile( float meters, float inverseTileSize, int tiles ) {
+	const float clamped = std::min( std::max( meters * inverseTileSize, -1.0f ), static_cast< float >( tiles ) );
+	int tile = static_cast< int >( clamped );
+	if ( static_cast< float >( tile ) > clamped ) tile--;
+	return tile;
+}
+
+/**
+ * @brief Counts the set bits of a lane mask.
+ * @param mask Up to eight lanes.
+ * @return The number of lanes set.
+ */
+static int countLanes( int mask ) {
+	int lanes = 0;
+	for ( ; mask; mask &= mask - 1 ) lanes++;
+	return lanes;
+}
+
+/**
+ * @brief Per-emitter constants of the color and size curves.
+ */
+struct CurveConstants
+{
+	float size0, sizeDelta;
+	float channel0[ 4 ], channelDelta[ 4 ]; // RGBA, 0-255.
+
+	explicit CurveConstants( const ParticleEmitterSettings& settings ) {
+		size0 = settings.sizeStart;
+		sizeDelta = settings.sizeEnd - settings.sizeStart;
+		for ( int c = 0; c < 4; c++ ) {
+			channel0[ c ] = static_cast< float >( settings.colorStart >> ( 8 * c ) & 0xFFu );
+			channelDelta[ c ] = static_cast< float >( settings.colorEnd >> ( 8 * c ) & 0xFFu ) - channel0[ c ];
+		}
+	}
+};
+
+/**
+ * @brief Evaluates the curves for one particle; the SIMD writers do the same operations lane-wise.
+ * @param curve The emitter's curves.
+ * @param t Normalized age, 0 to 1.
+ * @param x Position X.
+ * @param y Position Y.
+ * @return The instance.
+ */
+static ParticleInstance makeInstance( const CurveConstants& curve, float t, float x, float y ) {
+	ParticleInstance instance;
+	instance.x = x;
+	instance.y = y;
+	instance.size = curve.size0 + curve.sizeDelta * t;
+	instance.color = 0;
+	for ( int c = 0; c < 4; c++ ) {
+		instance.color |= static_cast< uint32_t >( static_cast< int >( curve.channel0[ c ] + curve.channelDelta[ c ] * t + 0.5f ) ) << ( 8 * c );
+	}
+	return instance;
+}
+
+ParticleSystem::ParticleSystem() {
+#if ARCANTHA_SIMD_AVX
+	kernel = ParticleKernel::Avx;
+#elif ARCANTHA_SIMD_SSE
+	kernel = ParticleKernel::Sse;
+#else
+	kernel = ParticleKernel::Scalar;
+#endif
+}
+
+bool ParticleSystem::initGL() {
+	if ( glReady ) return true;
+	GLuint vertexShader = compileShader( GL_VERTEX_SHADER, PARTICLE_VERTEX_SHADER );
+	GLuint fragmentShader = compileShader( GL_FRAGMENT_SHADER, PARTICLE_FRAGMENT_SHADER );
+	if ( !vertexShader || !fragmentShader ) {
+		if ( vertexShader ) glDeleteShader( vertexShader );
+		if ( fragmentShader ) glDeleteShader( fragmentShader );
+		return false;
+	}
+	program = glCreateProgram();
+	glAttachShader( program, vertexShader );
+	glAttachShader( program, fragmentShader );
+	glLinkProgram( program );
+	glDeleteShader( vertexShader );
+	glDeleteShader( fragmentShader );
+	GLint linked = 0;
+	glGetProgramiv( program, GL_LINK_STATUS, &linked );
+	if ( !linked ) {
+		LOG_ERROR( "Particle shader failed to link." );
+		glDeleteProgram( program );
+		program = 0;
+		return false;
+	}
+	projectionLocation = glGetUniformLocation( program, "uProjection" );
+
+	static const float corners[ 8 ] = { -0.5f, -0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f };
+	glGenVertexArrays( 1, &vao );
+	glGenBuffers( 1, &quadVbo );
+	glGenBuffers( 1, &instanceVbo );
+	glBindVertexArray( vao );
+	glBindBuffer( GL_ARRAY_BUFFER, quadVbo );
+	glBufferData( GL_ARRAY_BUFFER, sizeof( corners ), corners, GL_STATIC_DRAW );
+	glEnableVertexAttribArray( 0 );
+	glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof( float ), nullptr );
+	glBindBuffer( GL_ARRAY_BUFFER, instanceVbo );
+	glEnableVertexAttribArray( 1 );
+	glVertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, sizeof( ParticleInstance ), reinterpret_cast< void* >( offsetof( ParticleInstance, x ) ) );
+	glVertexAttribDivisor( 1, 1 );
+	glEnableVertexAttribArray( 2 );
+	glVertexAttribPointer( 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof( ParticleInstance ), reinterpret_cast< void* >( offsetof( ParticleInstance, color ) ) );
+	glVertexAttribDivisor( 2, 1 );
+	glBindVertexArray( 0 );
+	instanceCapacity = 0;
+
+	glReady = true;
+	return true;
+}
+
+void ParticleSystem::shutdownGL() {
+	if ( !glReady ) return;
+	glDeleteBuffers( 1, &quadVbo );
+	glDeleteBuffers( 1, &instanceVbo );
+	glDeleteVertexArrays( 1, &vao );
+	glDeleteProgram( program );
+	program = vao = quadVbo = instanceVbo = 0;
+	instanceCapacity = 0;
+	projectionLocation = -1;
+	glReady = false;
+}
+
+void ParticleSystem::setTileMap( const TileMap* map ) {
+	solid.clear();
+	tilesWide = tilesHigh = 0;
+	if ( !map ) return;
+
+	// One tile of solid border on every side, so out-of-bounds coordinates clamp onto it without a bounds check.
+	tilesWide = map->getWidth();
+	tilesHigh = map->getHeight();
+	inverseTileSize = 1.0f / map->getTileSize();
+	const int stride = tilesWide + 2;
+	solid.assign( static_cast< size_t >( stride ) * ( tilesHigh + 2 ), 1 );
+	for ( int y = 0; y < tilesHigh; y++ ) {
+		for ( int x = 0; x < tilesWide; x++ ) solid[ ( y + 1 ) * stride + x + 1 ] = map->isSolid( x, y ) ? 1 : 0;
+	}
+}
+
+void ParticleSystem::setKernel( ParticleKernel requested ) {
+#if !ARCANTHA_SIMD_AVX
+	if ( requested == ParticleKernel::Avx ) requested = ParticleKernel::Sse;
+#endif
+#if !ARCANTHA_SIMD_SSE
+	if ( requested == ParticleKernel::Sse ) requested = ParticleKernel::Scalar;
+#endif
+	kernel = requested;
+}
+
+uint32_t ParticleSystem::addEmitter( const ParticleEmitterSettings& settings ) {
+	Emitter emitter;
+	emitter.settings = settings;
+	emitter.random = Random::derive( settings.seed, emitters.size() );
+	const size_t padded = ( settings.capacity + LANES - 1 ) / LANES * LANES;
+	for ( std::vector<float>* column : { &emitter.x, &emitter.y, &emitter.vx, &emitter.vy, &emitter.age, &emitter.invLife } ) column->assign( padded, 0.0f );
+	emitter.dead.reserve( settings.capacity );
+	emitters.push_back( std::move( emitter ) );
+	return static_cast< uint32_t >( emitters.size() - 1 );
+}
+
+void ParticleSystem::setEmitterPosition( uint32_t emitter, const glm::vec2& position ) {
+	emitters[ emitter ].settings.position = position;
+}
+
+void ParticleSystem::setEmitterActive( uint32_t emitter, bool active ) {
+	emitters[ emitter ].active = active;
+}
+
+void ParticleSystem::burst( uint32_t emitter, uint32_t count ) {
+	emitters[ emitter ].pendingBurst += count;
+}
+
+void ParticleSystem::update( float dt ) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	JobSystem::getInstance().parallelFor( emitters.size(), 1, [ this, dt ]( size_t begin, size_t end ) {
+		for ( size_t i = begin; i < end; i++ ) {
+			Emitter& emitter = emitters[ i ];
+			integrate( emitter, dt );
+			compact( emitter );
+			spawn( emitter, dt );
+		}
+	} );
+
+	const double updateMs = elapsedMs( start );
+	const double writeMs = stats.writeMs;
+	stats = ParticleStats();
+	stats.updateMs = updateMs;
+	stats.writeMs = writeMs;
+	for ( Emitter& emitter : emitters ) {
+		emitter.offset = stats.alive;
+		stats.alive += emitter.count;
+		stats.spawned += emitter.spawned;
+		stats.expired += emitter.expired;
+		stats.collisions += emitter.collisions;
+	}
+}
+
+void ParticleSystem::spawn( Emitter& emitter, float dt ) {
+	const ParticleEmitterSettings& settings = emitter.settings;
+	uint32_t wanted = emitter.pendingBurst;
+	emitter.pendingBurst = 0;
+	if ( emitter.active ) {
+		emitter.spawnDebt += settings.rate * dt;
+		const uint32_t owed = static_cast< uint32_t >( emitter.spawnDebt );
+		emitter.spawnDebt -= static_cast< float >( owed );
+		wanted += owed;
+	}
+	const uint32_t room = settings.capacity - emitter.count;
+	emitter.spawned = std::min( wanted, room );
+
+	Random& random = emitter.random;
+	for ( uint32_t n = 0; n < emitter.spawned; n++ ) {
+		const uint32_t i = emitter.count++;
+		const float angle = settings.direction + random.range( -settings.spread, settings.spread );
+		const float speed = random.range( settings.speedMin, settings.speedMax );
+		emitter.x[ i ] = settings.position.x + random.range( -settings.spawnRadius, settings.spawnRadius );
+		emitter.y[ i ] = settings.position.y + random.range( -settings.spawnRadius, settings.spawnRadius );
+		emitter.vx[ i ] = std::cos( angle ) * speed;
+		emitter.vy[ i ] = std::sin( angle ) * speed;
+		emitter.age[ i ] = 0.0f;
+		emitter.invLife[ i ] = 1.0f / std::max( random.range( settings.lifeMin, settings.lifeMax ), 1e-4f );
+	}
+}
+
+void ParticleSystem::integrate( Emitter& emitter, float dt ) {
+	const ParticleEmitterSettings& settings = emitter.settings;
+	const uint32_t count = emitter.count;
+	emitter.dead.clear();
+	emitter.expired = emitter.collisions = 0;
+	if ( count == 0 ) return;
+
+	const float gravityX = settings.gravity.x * dt, gravityY = settings.gravity.y * dt;
+	const float damping = std::pow( std::max( 1.0f - settings.drag, 0.0f ), dt );
+	const bool collide = settings.collide && !solid.empty();
+	const int stride = tilesWide + 2;
+	const uint8_t* grid = solid.data();
+	float* x = emitter.x.data();
+	float* y = emitter.y.data();
+	float* vx = emitter.vx.data();
+	float* vy = emitter.vy.data();
+	float* age = emitter.age.data();
+	const float* invLife = emitter.invLife.data();
+
+	// Lanes past count hold stale particles; they are integrated harmlessly and masked out of the results.
+	switch ( kernel ) {
+#if ARCANTHA_SIMD_AVX
+	case ParticleKernel::Avx: {
+		const __m256 step = _mm256_set1_ps( dt ), gx = _mm256_set1_ps( gravityX ), gy = _mm256_set1_ps( gravityY ), damp = _mm256_set1_ps( damping );
+		const __m256 one = _mm256_set1_ps( 1.0f ), bounce = _mm256_set1_ps( -settings.bounce ), friction = _mm256_set1_ps( settings.friction );
+		const __m256 inverseTile = _mm256_set1_ps( inverseTileSize ), low = _mm256_set1_ps( -1.0f );
+		const __m256 highX = _mm256_set1_ps( static_cast< float >( tilesWide ) ), highY = _mm256_set1_ps( static_cast< float >( tilesHigh ) );
+		for ( uint32_t j = 0; j < count; j += 8 ) {
+			const int valid = count - j >= 8 ? 0xFF : ( 1 << ( count - j ) ) - 1;
+			const __m256 px = _mm256_loadu_ps( x + j ), py = _mm256_loadu_ps( y + j );
+			__m256 velX = _mm256_mul_ps( _mm256_add_ps( _mm256_loadu_ps( vx + j ), gx ), damp );
+			__m256 velY = _mm256_mul_ps( _mm256_add_ps( _mm256_loadu_ps( vy + j ), gy ), damp );
+			__m256 nx = _mm256_add_ps( px, _mm256_mul_ps( velX, step ) );
+			__m256 ny = _mm256_add_ps( py, _mm256_mul_ps( velY, step ) );
+			if ( collide ) {
+				alignas( 32 ) int32_t tileX[ 8 ], tileY[ 8 ];
+				const __m256 fx = _mm256_floor_ps( _mm256_min_ps( _mm256_max_ps( _mm256_mul_ps( nx, inverseTile ), low ), highX ) );
+				const __m256 fy = _mm256_floor_ps( _mm256_min_ps( _mm256_max_ps( _mm256_mul_ps( ny, inverseTile ), low ), highY ) );
+				_mm256_store_si256( reinterpret_cast< __m256i* >( tileX ), _mm256_cvttps_epi32( fx ) );
+				_mm256_store_si256( reinterpret_cast< __m256i* >( tileY ), _mm256_cvttps_epi32( fy ) );
+				alignas( 32 ) int32_t hit[ 8 ];
+				int hits = 0;
+				for ( int lane = 0; lane < 8; lane++ ) {
+					const int32_t tile = grid[ ( tileY[ lane ] + 1 ) * stride + tileX[ lane ] + 1 ];
+					hit[ lane ] = -tile;
+					hits |= tile << lane;
+				}
+				if ( hits ) {
+					const __m256 mask = _mm256_castsi256_ps( _mm256_load_si256( reinterpret_cast< const __m256i* >( hit ) ) );
+					nx = _mm256_blendv_ps( nx, px, mask );
+					ny = _mm256_blendv_ps( ny, py, mask );
+					velX = _mm256_blendv_ps( velX, _mm256_mul_ps( velX, friction ), mask );
+					velY = _mm256_blendv_ps( velY, _mm256_mul_ps( velY, bounce ), mask );
+					emitter.collisions += countLanes( hits & valid );
+				}
+			}
+			_mm256_storeu_ps( x + j, nx );
+			_mm256_storeu_ps( y + j, ny );
+			_mm256_storeu_ps( vx + j, velX );
+			_mm256_storeu_ps( vy + j, velY );
+			const __m256 older = _mm256_add_ps( _mm256_loadu_ps( age + j ), step );
+			_mm256_storeu_ps( age + j, older );
+			int dead = _mm256_movemask_ps( _mm256_cmp_ps( _mm256_mul_ps( older, _mm256_loadu_ps( invLife + j ) ), one, _CMP_GE_OQ ) ) & valid;
+			for ( int lane = 0; lane < 8; lane++ ) {
+				if ( dead & ( 1 << lane ) ) emitter.dead.push_back( j + lane );
+			}
+		}
+		break;
+	}
+#endif
+#if ARCANTHA_SIMD_SSE
+	case ParticleKernel::Sse: {
+		const __m128 step = _mm_set1_ps( dt ), gx = _mm_set1_ps( gravityX ), gy = _mm_set1_ps( gravityY ), damp = _mm_set1_ps( damping );
+		const __m128 one = _mm_set1_ps( 1.0f ), bounce = _mm_set1_ps( -settings.bounce ), friction = _mm_set1_ps( settings.friction );
+		const __m128 inverseTile = _mm_set1_ps( inverseTileSize ), low = _mm_set1_ps( -1.0f );
+		const __m128 highX = _mm_set1_ps( static_cast< float >( tilesWide ) ), highY = _mm_set1_ps( static_cast< float >( tilesHigh ) );
+		// SSE2 has no floor: truncate, then step down the lanes where truncation rounded up.
+		auto floorToInt = []( __m128 value ) {
+			const __m128i truncated = _mm_cvttps_epi32( value );
+			return _mm_add_epi32( truncated, _mm_castps_si128( _mm_cmpgt_ps( _mm_cvtepi32_ps( truncated ), value ) ) );
+		};
+		for ( uint32_t j = 0; j < count; j += 4 ) {
+			const int valid = count - j >= 4 ? 0xF : ( 1 << ( count - j ) ) - 1;
+			const __m128 px = _mm_loadu_ps( x + j ), py = _mm_loadu_ps( y + j );
+			__m128 velX = _mm_mul_ps( _mm_add_ps( _mm_loadu_ps( vx + j ), gx ), damp );
+			__m128 velY = _mm_mul_ps( _mm_add_ps( _mm_loadu_ps( vy + j ), gy ), damp );
+			__m128 nx = _mm_add_ps( px, _mm_mul_ps( velX, step ) );
+			__m128 ny = _mm_add_ps( py, _mm_mul_ps( velY, step ) );
+			if ( collide ) {
+				const __m128i tileX = floorToInt( _mm_min_ps( _mm_max_ps( _mm_mul_ps( nx, inverseTile ), low ), highX ) );
+				const __m128i tileY = floorToInt( _mm_min_ps( _mm_max_ps( _mm_mul_ps( ny, inverseTile ), low ), highY ) );
+				alignas( 16 ) int32_t tileXs[ 4 ], tileYs[ 4 ];
+				_mm_store_si128( reinterpret_cast< __m128i* >( tileXs ), tileX );
+				_mm_store_si128( reinterpret_cast< __m128i* >( tileYs ), tileY );
+				int hits = 0;
+				for ( int lane = 0; lane < 4; lane++ ) hits |= grid[ ( tileYs[ lane ] + 1 ) * stride + tileXs[ lane ] + 1 ] << lane;
+				if ( hits ) {
+					const __m128 mask = _mm_castsi128_ps( _mm_set_epi32( -( hits >> 3 & 1 ), -( hits >> 2 & 1 ), -( hits >> 1 & 1 ), -( hits & 1 ) ) );
+					nx = _mm_or_ps( _mm_and_ps( mask, px ), _mm_andnot_ps( mask, nx ) );
+					ny = _mm_or_ps( _mm_and_ps( mask, py ), _mm_andnot_ps( mask, ny ) );
+					velX = _mm_or_ps( _mm_and_ps( mask, _mm_mul_ps( velX, friction ) ), _mm_andnot_ps( mask, velX ) );
+					velY = _mm_or_ps( _mm_and_ps( mask, _mm_mul_ps( velY, bounce ) ), _mm_andnot_ps( mask, velY ) );
+					emitter.collisions += countLanes( hits & valid );
+				}
+			}
+			_mm_storeu_ps( x + j, nx );
+			_mm_storeu_ps( y + j, ny );
+			_mm_storeu_ps( vx + j, velX );
+			_mm_storeu_ps( vy + j, velY );
+			const __m128 older = _mm_add_ps( _mm_loadu_ps( age + j ), step );
+			_mm_storeu_ps( age + j, older );
+			int dead = _mm_movemask_ps( _mm_cmpge_ps( _mm_mul_ps( older, _mm_loadu_ps( invLife + j ) ), one ) ) & valid;
+			for ( int lane = 0; lane < 4; lane++ ) {
+				if ( dead & ( 1 << lane ) ) emitter.dead.push_back( j + lane );
+			}
+		}
+		break;
+	}
+#endif
+	default:
+		for ( uint32_t i = 0; i < count; i++ ) {
+			const float velX = ( vx[ i ] + gravityX ) * damping;
+			const float velY = ( vy[ i ] + gravityY ) * damping;
+			const float nx = x[ i ] + velX * dt;
+			const float ny = y[ i ] + velY * dt;
+			if ( collide && grid[ ( toTile( ny, inverseTileSize, tilesHigh ) + 1 ) * stride + toTile( nx, inverseTileSize, tilesWide ) + 1 ] ) {
+				vx[ i ] = velX * settings.friction;
+				vy[ i ] = velY * -settings.bounce;
+				emitter.collisions++;
+			}
+			else {
+				x[ i ] = nx;
+				y[ i ] = ny;
+				vx[ i ] = velX;
+				vy[ i ] = velY;
+			}
+			age[ i ] += dt;
+			if ( age[ i ] * invLife[ i ] >= 1.0f ) emitter.dead.push_back( i );
+		}
+		break;
+	}
+}
+
+void ParticleSystem::compact( Emitter& emitter ) {
+	// Descending, so the particle swapped in from the end is always one that survived.
+	emitter.expired = static_cast< uint32_t >( emitter.dead.size() );
+	for ( size_t n = emitter.dead.size(); n-- > 0; ) {
+		const uint32_t slot = emitter.dead[ n ];
+		const uint32_t last = --emitter.count;
+		if ( slot == last ) continue;
+		emitter.x[ slot ] = emitter.x[ last ];
+		emitter.y[ slot ] = emitter.y[ last ];
+		emitter.vx[ slot ] = emitter.vx[ last ];
+		emitter.vy[ slot ] = emitter.vy[ last ];
+		emitter.age[ slot ] = emitter.age[ last ];
+		emitter.invLife[ slot ] = emitter.invLife[ last ];
+	}
+}
+
+uint32_t ParticleSystem::writeInstances( ParticleInstance* out ) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	JobSystem::getInstance().parallelFor( emitters.size(), 1, [ this, out ]( size_t begin, size_t end ) {
+		for ( size_t i = begin; i < end; i++ ) writeEmitter( emitters[ i ], out + emitters[ i ].offset );
+	} );
+	stats.writeMs = elapsedMs( start );
+	return getAliveCount();
+}
+
+void ParticleSystem::writeEmitter( const Emitter& emitter, ParticleInstance* out ) const {
+	const CurveConstants curve( emitter.settings );
+	const uint32_t count = emitter.count;
+	const float* x = emitter.x.data();
+	const float* y = emitter.y.data();
+	const float* age = emitter.age.data();
+	const float* invLife = emitter.invLife.data();
+	uint32_t i = 0;
+
+	// Whole blocks are transposed from SoA into interleaved instances in registers; the tail goes scalar.
+	switch ( kernel ) {
+#if ARCANTHA_SIMD_AVX
+	case ParticleKernel::Avx: {
+		const __m256 one = _mm256_set1_ps( 1.0f ), half = _mm256_set1_ps( 0.5f );
+		const __m256 size0 = _mm256_set1_ps( curve.size0 ), sizeDelta = _mm256_set1_ps( curve.sizeDelta );
+		for ( ; i + 8 <= count; i += 8 ) {
+			const __m256 t = _mm256_min_ps( _mm256_mul_ps( _mm256_loadu_ps( age + i ), _mm256_loadu_ps( invLife + i ) ), one );
+			const __m256 size = _mm256_add_ps( size0, _mm256_mul_ps( sizeDelta, t ) );
+			// AVX1 has no 256-bit integer shifts, so the channels are packed in 128-bit halves.
+			__m128i colorLow = _mm_setzero_si128(), colorHigh = _mm_setzero_si128();
+			for ( int c = 0; c < 4; c++ ) {
+				const __m256 channel = _mm256_add_ps( _mm256_add_ps( _mm256_set1_ps( curve.channel0[ c ] ), _mm256_mul_ps( _mm256_set1_ps( curve.channelDelta[ c ] ), t ) ), half );
+				const __m256i value = _mm256_cvttps_epi32( channel );
+				colorLow = _mm_or_si128( colorLow, _mm_slli_epi32( _mm256_castsi256_si128( value ), 8 * c ) );
+				colorHigh = _mm_or_si128( colorHigh, _mm_slli_epi32( _mm256_extractf128_si256( value, 1 ), 8 * c ) );
+			}
+			const __m256 px = _mm256_loadu_ps( x + i ), py = _mm256_loadu_ps( y + i );
+			__m128 rows[ 2 ][ 4 ] = {
+				{ _mm256_castps256_ps128( px ), _mm256_castps256_ps128( py ), _mm256_castps256_ps128( size ), _mm_castsi128_ps( colorLow ) },
+				{ _mm256_extractf128_ps( px, 1 ), _mm256_extractf128_ps( py, 1 ), _mm256_extractf128_ps( size, 1 ), _mm_castsi128_ps( colorHigh ) } };
+			for ( int h = 0; h < 2; h++ ) {
+				_MM_TRANSPOSE4_PS( rows[ h ][ 0 ], rows[ h ][ 1 ], rows[ h ][ 2 ], rows[ h ][ 3 ] );
+				for ( int lane = 0; lane < 4; lane++ ) _mm_storeu_ps( reinterpret_cast< float* >( out + i + 4 * h + lane ), rows[ h ][ lane ] );
+			}
+		}
+		break;
+	}
+#endif
+#if ARCANTHA_SIMD_SSE
+	case ParticleKernel::Sse: {
+		const __m128 one = _mm_set1_ps( 1.0f ), half = _mm_set1_ps( 0.5f );
+		const __m128 size0 = _mm_set1_ps( curve.size0 ), sizeDelta = _mm_set1_ps( curve.sizeDelta );
+		for ( ; i + 4 <= count; i += 4 ) {
+			const __m128 t = _mm_min_ps( _mm_mul_ps( _mm_loadu_ps( age + i ), _mm_loadu_ps( invLife + i ) ), one );
+			__m128 size = _mm_add_ps( size0, _mm_mul_ps( sizeDelta, t ) );
+			__m128i color = _mm_setzero_si128();
+			for ( int c = 0; c < 4; c++ ) {
+				const __m128 channel = _mm_add_ps( _mm_add_ps( _mm_set1_ps( curve.channel0[ c ] ), _mm_mul_ps( _mm_set1_ps( curve.channelDelta[ c ] ), t ) ), half );
+				color = _mm_or_si128( color, _mm_slli_epi32( _mm_cvttps_epi32( channel ), 8 * c ) );
+			}
+			__m128 px = _mm_loadu_ps( x + i ), py = _mm_loadu_ps( y + i ), packed = _mm_castsi128_ps( color );
+			_MM_TRANSPOSE4_PS( px, py, size, packed );
+			_mm_storeu_ps( reinterpret_cast< float* >( out + i ), px );
+			_mm_storeu_ps( reinterpret_cast< float* >( out + i + 1 ), py );
+			_mm_storeu_ps( reinterpret_cast< float* >( out + i + 2 ), size );
+			_mm_storeu_ps( reinterpret_cast< float* >( out + i + 3 ), packed );
+		}
+		break;
+	}
+#endif
+	default:
+		break;
+	}
+	for ( ; i < count; i++ ) out[ i ] = makeInstance( curve, std::min( age[ i ] * invLife[ i ], 1.0f ), x[ i ], y[ i ] );
+}
+
+void ParticleSystem::render( const glm::mat4& projection ) {
+	const uint32_t alive = getAliveCount();
+	if ( !glReady || alive == 0 ) return;
+
+	glBindVertexArray( vao );
+	glBindBuffer( GL_ARRAY_BUFFER, instanceVbo );
+	if ( alive > instanceCapacity ) {
+		instanceCapacity = alive + alive / 2;
+		glBufferData( GL_ARRAY_BUFFER, static_cast< GLsizeiptr >( instanceCapacity * sizeof( ParticleInstance ) ), nullptr, GL_STREAM_DRAW );
+	}
+	// The jobs write straight into the driver's buffer; invalidating it avoids waiting on last frame's draw.
+	void* mapped = glMapBufferRange( GL_ARRAY_BUFFER, 0, static_cast< GLsizeiptr >( alive * sizeof( ParticleInstance ) ),
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+	if ( !mapped ) {
+		LOG_ERROR( "Failed to map the particle instance buffer." );
+		glBindVertexArray( 0 );
+		return;
+	}
+	writeInstances( static_cast< ParticleInstance* >( mapped ) );
+	if ( !glUnmapBuffer( GL_ARRAY_BUFFER ) ) {
+		glBindVertexArray( 0 );
+		return; // The buffer was corrupted, e.g. by a mode switch; skip a frame.
+	}
+
+	glUseProgram( program );
+	glUniformMatrix4fv( projectionLocation, 1, GL_FALSE, &projection[ 0 ][ 0 ] );
+	glEnable( GL_BLEND );
+	glBlendFunc( GL_SRC_ALPHA, GL_ONE );
+	glDrawArraysInstanced( GL_TRIANGLE_STRIP, 0, 4, static_cast< GLsizei >( alive ) );
+	glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+	glBindVertexArray( 0 );
+}
+
+uint32_t ParticleSystem::getAliveCount() const {
+	uint32_t alive = 0;
+	for ( const Emitter& emitter : emitters ) alive += emitter.count;
+	return alive;
+}
@@ -0,0 +1,201 @@
+#include <algorithm> // Required for std::find and std::swap.
+
+#include "Physics.h" // Includes the PhysicsWorld class definition.
+
+// A body rising faster than this passes through one-way platforms; resting bodies jitter well below it.
+static const float PLATFORM_RISE_SPEED = 0.05f;
+// How far a body's bottom may sink into a platform and still stand on it, to allow for solver penetration.
+static const float PLATFORM_TOLERANCE = 3.0f * b2_linearSlop;
+
+const uintptr_t PhysicsWorld::PLATFORM_FIXTURE;
+
+PhysicsWorld::PhysicsWorld( const PhysicsSettings& settings ) :
+	settings( settings ), world( settings.gravity ), platformFilter( *this ), accumulator( 0.0 ), structureVersion( 0 ) {
+	world.SetContactListener( &platformFilter );
+}
+
+b2Body* PhysicsWorld::createStaticTiles( const TileMap& map ) {
+	BodyParams params;
+	params.type = b2_staticBody;
+	params.category = CATEGORY_TILES;
+	params.density = 0.0f;
+	b2Body* body = createBody( params );
+
+	const int width = map.getWidth();
+	const int height = map.getHeight();
+	const float size = map.getTileSize();
+
+	for ( const TileRect& rect : map.mergeSolidRects() ) {
+		b2PolygonShape box;
+		box.SetAsBox( rect.w * size * 0.5f, rect.h * size * 0.5f,
+			b2Vec2( ( rect.x + rect.w * 0.5f ) * size, ( rect.y + rect.h * 0.5f ) * size ), 0.0f );
+		createFixture( body, box, params );
+	}
+
+	// One-way platforms become a single edge per horizontal run along the top of the tiles.
+	for ( int y = 0; y < height; y++ ) {
+		for ( int x = 0; x < width; x++ ) {
+			if ( map.get( x, y ) != Tile::Platform ) continue;
+
+			int w = 1;
+			while ( x + w < width && map.get( x + w, y ) == Tile::Platform ) w++;
+
+			b2EdgeShape edge;
+			edge.SetTwoSided( b2Vec2( x * size, ( y + 1 ) * size ), b2Vec2( ( x + w ) * size, ( y + 1 ) * size ) );
+			createFixture( body, edge, params, PLATFORM_FIXTURE );
+			x += w - 1;
+		}
+	}
+
+	return body;
+}
+
+b2Body* PhysicsWorld::createBox( const BodyParams& params, float halfWidth, float halfHeight ) {
+	b2Body* body = createBody( params );
+
+	b2PolygonShape box;
+	box.SetAsBox( halfWidth, halfHeight );
+	createFixture( body, box, params );
+
+	return body;
+}
+
+b2Body* PhysicsWorld::createCircle( const BodyParams& params, float radius ) {
+	b2Body* body = createBody( params );
+
+	b2CircleShape circle;
+	circle.m_radius = radius;
+	createFixture( body, circle, params );
+
+	return body;
+}
+
+void PhysicsWorld::destroyBody( b2Body* body ) {
+	auto it = std::find( bodies.begin(), bodies.end(), body );
+	if ( it == bodies.end() ) return;
+
+	bodies.erase( it ); // Erase rather than swap so the creation order stays stable.
+	setDroppingThrough( body, false );
+	world.DestroyBody( body );
+	structureVersion++;
+}
+
+void PhysicsWorld::setDroppingThrough( const b2Body* body, bool dropping ) {
+	auto it = std::find( droppingBodies.begin(), droppingBodies.end(), body );
+	if ( dropping && it == droppingBodies.end() ) droppingBodies.push_back( body );
+	else if ( !dropping && it != droppingBodies.end() ) droppingBodies.erase( it );
+}
+
+void PhysicsWorld::mirrorInto( PhysicsWorld& other ) const {
+	for ( b2Body* body : other.bodies ) other.world.DestroyBody( body );
+	other.bodies.clear();
+	other.droppingBodies.clear();
+	other.accumulator = accumulator;
+
+	for ( const b2Body* body : bodies ) {
+		b2BodyDef def;
+		def.type = body->GetType();
+		def.position = body->GetPosition();
+		def.angle = body->GetAngle();
+		def.linearVelocity = body->GetLinearVelocity();
+		def.angularVelocity = body->GetAngularVelocity();
+		def.linearDamping = body->GetLinearDamping();
+		def.angularDamping = body->GetAngularDamping();
+		def.allowSleep = body->IsSleepingAllowed();
+		def.awake = body->IsAwake();
+		def.fixedRotation = body->IsFixedRotation();
+		def.bullet = body->IsBullet();
+		def.enabled = body->IsEnabled();
+		def.gravityScale = body->GetGravityScale();
+		def.userData = body->GetUserData();
+
+		b2Body* copy = other.world.CreateBody( &def );
+		for ( const b2Fixture* fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext() ) {
+			b2FixtureDef fixtureDef;
+			fixtureDef.shape = fixture->GetShape();
+			fixtureDef.density = fixture->GetDensity();
+			fixtureDef.friction = fixture->GetFriction();
+			fixtureDef.restitution = fixture->GetRestitution();
+			fixtureDef.restitutionThreshold = fixture->GetRestitutionThreshold();
+			fixtureDef.isSensor = fixture->IsSensor();
+			fixtureDef.filter = fixture->GetFilterData();
+			fixtureDef.userData = fixture->GetUserData();
+			copy->CreateFixture( &fixtureDef );
+		}
+		other.bodies.push_back( copy );
+		if ( std::find( droppingBodies.begin(), droppingBodies.end(), body ) != droppingBodies.end() ) other.droppingBodies.push_back( copy );
+	}
+
+	other.structureVersion = structureVersion;
+}
+
+int PhysicsWorld::step( double dt ) {
+	accumulator += dt;
+
+	int steps = 0;
+	while ( accumulator >= settings.timeStep && steps < settings.maxSubSteps ) {
+		stepFixed();
+		accumulator -= settings.timeStep;
+		steps++;
+	}
+
+	// Drop time we could not catch up on instead of carrying it into the next frame.
+	if ( steps == settings.maxSubSteps && accumulator > settings.timeStep ) accumulator = 0.0;
+
+	return steps;
+}
+
+void PhysicsWorld::stepFixed() {
+	world.Step( settings.timeStep, settings.velocityIterations, settings.positionIterations );
+}
+
+b2Body* PhysicsWorld::createBody( const BodyParams& params ) {
+	b2BodyDef def;
+	def.type = params.type;
+	def.position = params.position;
+	def.fixedRotation = params.fixedRotation;
+	def.bullet = params.bullet;
+	def.gravityScale = params.gravityScale;
+
+	b2Body* body = world.CreateBody( &def );
+	bodies.push_back( body );
+	structureVersion++;
+	return body;
+}
+
+void PhysicsWorld::createFixture( b2Body* body, const b2Shape& shape, const BodyParams& params, uintptr_t userData ) {
+	b2FixtureDef def;
+	def.shape = &shape;
+	def.userData.pointer = userData;
+	def.density = params.density;
+	def.friction = params.friction;
+	def.filter.categoryBits = params.category;
+	def.filter.maskBits = params.mask;
+
+	body->CreateFixture( &def );
+}
+
+void PhysicsWorld::PlatformFilter::PreSolve( b2Contact* contact, const b2Manifold* ) {
+	b2Fixture* platform = contact->GetFixtureA();
+	b2Fixture* other = contact->GetFixtureB();
+	int32 childIndex = contact->GetChildIndexB();
+	if ( other->GetUserData().pointer == PLATFORM_FIXTURE ) {
+		std::swap( platform, other );
+		childIndex = contact->GetChildIndexA();
+	}
+	if ( platform->GetUserData().pointer != PLATFORM_FIXTURE ) return;
+
+	const b2Body* body = other->GetBody();
+	const std::vector<const b2Body*>& dropping = owner.droppingBodies;
+	if ( body->GetLinearVelocity().y > PLATFORM_RISE_SPEED || std::find( dropping.begin(), dropping.end(), body ) != dropping.end() ) {
+		contact->SetEnabled( false );
+		return;
+	}
+
+	// Only a body whose bottom is at or above the edge is standing on it; anything lower is passing through.
+	const b2EdgeShape* edge = static_cast< const b2EdgeShape* >( platform->GetShape() );
+	const float top = b2Mul( platform->GetBody()->GetTransform(), edge->m_vertex1 ).y;
+	b2AABB bounds;
+	other->GetShape()->ComputeAABB( &bounds, body->GetTransform(), childIndex );
+	if ( bounds.lowerBound.y < top - PLATFORM_TOLERANCE ) contact->SetEnabled( false );
+}
@@ -0,0 +1,333 @@
+#include <algorithm> // Required for std::min and std::max.
+#include <chrono> // Required for timing execute().
+#include <cmath> // Required for std::fabs.
+
+#include "PhysicsQuery.h" // Includes the QueryService class definition.
+#include "JobSystem.h" // Includes the JobSystem the batches run on.
+#include "Simd.h" // Includes the SIMD capability macros and intrinsics.
+
+static const size_t QUERY_GRAIN = 64; // Queries per parallel chunk.
+static const float FAR_AWAY = 1e30f; // Coordinate used for padding rectangles that can never be hit.
+
+/**
+ * @brief Closest slab-test hit against a set of rectangles.
+ */
+struct SlabHit
+{
+	float t = 1.0f; // Ray parameter of the entry point.
+	int index = -1; // Hit rectangle, or -1.
+	bool xAxis = false; // True if the ray entered through a vertical face.
+};
+
+/**
+ * @brief Finds the closest rectangle a ray segment enters.
+ *
+ * Rectangles are stored SoA with a count that is a multiple of 4, so the SSE
+ * path can test four of them per iteration with no scalar tail.
+ */
+static SlabHit slabTest( const float* minX, const float* minY, const float* maxX, const float* maxY, size_t count,
+	const b2Vec2& origin, const b2Vec2& invDir, float maxT ) {
+	SlabHit best;
+	best.t = maxT;
+
+#if ARCANTHA_SIMD_SSE
+	const __m128 ox = _mm_set1_ps( origin.x ), oy = _mm_set1_ps( origin.y );
+	const __m128 ix = _mm_set1_ps( invDir.x ), iy = _mm_set1_ps( invDir.y );
+	const __m128 zero = _mm_setzero_ps();
+
+	for ( size_t i = 0; i < count; i += 4 ) {
+		__m128 tx1 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( minX + i ), ox ), ix );
+		__m128 tx2 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( maxX + i ), ox ), ix );
+		__m128 ty1 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( minY + i ), oy ), iy );
+		__m128 ty2 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( maxY + i ), oy ), iy );
+
+		__m128 txMin = _mm_min_ps( tx1, tx2 ), txMax = _mm_max_ps( tx1, tx2 );
+		__m128 tyMin = _mm_min_ps( ty1, ty2 ), tyMax = _mm_max_ps( ty1, ty2 );
+		__m128 tEnter = _mm_max_ps( txMin, tyMin );
+		__m128 tExit = _mm_min_ps( txMax, tyMax );
+
+		__m128 hits = _mm_and_ps( _mm_cmpge_ps( tExit, _mm_max_ps( tEnter, zero ) ),
+			_mm_cmplt_ps( tEnter, _mm_set1_ps( best.t ) ) );
+		int mask = _mm_movemask_ps( hits );
+		if ( !mask ) continue;
+
+		alignas( 16 ) float enter[ 4 ], enterX[ 4 ];
+		_mm_store_ps( enter, tEnter );
+		_mm_store_ps( enterX, txMin );
+		for ( int lane = 0; lane < 4; lane++ ) {
+			if ( !( mask & ( 1 << lane ) ) ) continue;
+			float t = std::max( enter[ lane ], 0.0f );
+			if ( t < best.t ) {
+				best.t = t;
+				best.index = static_cast< int >( i ) + lane;
+				best.xAxis = enterX[ lane ] >= enter[ lane ];
+			}
+		}
+	}
+#else
+	for ( size_t i = 0; i < count; i++ ) {
+		float tx1 = ( minX[ i ] - origin.x ) * invDir.x, tx2 = ( maxX[ i ] - origin.x ) * invDir.x;
+		float ty1 = ( minY[ i ] - origin.y ) * invDir.y, ty2 = ( maxY[ i ] - origin.y ) * invDir.y;
+		float txMin = std::min( tx1, tx2 );
+		float tEnter = std::max( txMin, std::min( ty1, ty2 ) );
+		float tExit = std::min( std::max( tx1, tx2 ), std::max( ty1, ty2 ) );
+
+		if ( tExit >= std::max( tEnter, 0.0f ) && tEnter < best.t ) {
+			best.t = std::max( tEnter, 0.0f );
+			best.index = static_cast< int >( i );
+			best.xAxis = txMin >= tEnter;
+		}
+	}
+#endif
+
+	return best;
+}
+
+/**
+ * @brief Tests whether a box overlaps any of a set of rectangles; touching edges do not count.
+ *
+ * Uses the same padded SoA layout as slabTest, four rectangles per iteration on the SSE path.
+ */
+static bool overlapTest( const float* minX, const float* minY, const float* maxX, const float* maxY, size_t count, const b2AABB& box ) {
+#if ARCANTHA_SIMD_SSE
+	const __m128 lx = _mm_set1_ps( box.lowerBound.x ), ly = _mm_set1_ps( box.lowerBound.y );
+	const __m128 ux = _mm_set1_ps( box.upperBound.x ), uy = _mm_set1_ps( box.upperBound.y );
+
+	for ( size_t i = 0; i < count; i += 4 ) {
+		__m128 overlapX = _mm_and_ps( _mm_cmplt_ps( lx, _mm_loadu_ps( maxX + i ) ), _mm_cmpgt_ps( ux, _mm_loadu_ps( minX + i ) ) );
+		__m128 overlapY = _mm_and_ps( _mm_cmplt_ps( ly, _mm_loadu_ps( maxY + i ) ), _mm_cmpgt_ps( uy, _mm_loadu_ps( minY + i ) ) );
+		if ( _mm_movemask_ps( _mm_and_ps( overlapX, overlapY ) ) ) return true;
+	}
+#else
+	for ( size_t i = 0; i < count; i++ ) {
+		if ( box.lowerBound.x < maxX[ i ] && box.upperBound.x > minX[ i ] && box.lowerBound.y < maxY[ i ] && box.upperBound.y > minY[ i ] ) return true;
+	}
+#endif
+
+	return false;
+}
+
+/**
+ * @brief Appends a rectangle to SoA storage.
+ */
+static void pushRect( std::vector<float>& minX, std::vector<float>& minY, std::vector<float>& maxX, std::vector<float>& maxY,
+	float x0, float y0, float x1, float y1 ) {
+	minX.push_back( x0 );
+	minY.push_back( y0 );
+	maxX.push_back( x1 );
+	maxY.push_back( y1 );
+}
+
+/**
+ * @brief Pads SoA rectangle storage to a multiple of 4 with rectangles no ray segment can reach.
+ */
+static void padRects( std::vector<float>& minX, std::vector<float>& minY, std::vector<float>& maxX, std::vector<float>& maxY ) {
+	while ( minX.size() % 4 ) pushRect( minX, minY, maxX, maxY, FAR_AWAY, FAR_AWAY, FAR_AWAY, FAR_AWAY );
+}
+
+/**
+ * @brief Broadphase ray callback keeping the closest non-tile fixture.
+ */
+struct TreeRayCallback
+{
+	const b2BroadPhase* broadPhase;
+	uint16_t mask;
+	bool skipTiles;
+	RayHit* hit;
+
+	float RayCastCallback( const b2RayCastInput& input, int32 proxyId ) {
+		const b2FixtureProxy* proxy = static_cast< const b2FixtureProxy* >( broadPhase->GetUserData( proxyId ) );
+		b2Fixture* fixture = proxy->fixture;
+		const uint16_t category = fixture->GetFilterData().categoryBits;
+
+		if ( !( category & mask ) || fixture->IsSensor() ) return input.maxFraction;
+		if ( skipTiles && ( category & CATEGORY_TILES ) ) return input.maxFraction;
+
+		b2RayCastOutput output;
+		if ( !fixture->RayCast( &output, input, proxy->childIndex ) ) return input.maxFraction;
+
+		hit->fixture = fixture;
+		hit->fraction = output.fraction;
+		hit->normal = output.normal;
+		hit->hit = true;
+		hit->hitTiles = false;
+		return output.fraction; // Clip the rest of the walk to this hit.
+	}
+};
+
+/**
+ * @brief Broadphase AABB callback collecting every fixture whose tight AABB overlaps the query.
+ */
+struct TreeAabbCallback
+{
+	const b2BroadPhase* broadPhase;
+	const b2AABB* box;
+	uint16_t mask;
+	bool skipTiles;
+	std::vector<b2Fixture*>* out;
+
+	bool QueryCallback( int32 proxyId ) {
+		const b2FixtureProxy* proxy = static_cast< const b2FixtureProxy* >( broadPhase->GetUserData( proxyId ) );
+		const uint16_t category = proxy->fixture->GetFilterData().categoryBits;
+
+		if ( !( category & mask ) ) return true;
+		if ( skipTiles && ( category & CATEGORY_TILES ) ) return true;
+		if ( b2TestOverlap( proxy->aabb, *box ) ) out->push_back( proxy->fixture );
+		return true;
+	}
+};
+
+QueryService::QueryService( const PhysicsWorld& world ) :
+	world( world ), tileMap( nullptr ) {}
+
+void QueryService::setTileMap( const TileMap* map ) {
+	tileMap = map;
+
+	solidMinX.clear(); solidMinY.clear(); solidMaxX.clear(); solidMaxY.clear();
+	platformMinX.clear(); platformMinY.clear(); platformMaxX.clear(); platformMaxY.clear();
+	if ( !map ) return;
+
+	const float size = map->getTileSize();
+	for ( const TileRect& rect : map->mergeSolidRects() ) {
+		pushRect( solidMinX, solidMinY, solidMaxX, solidMaxY,
+			rect.x * size, rect.y * size, ( rect.x + rect.w ) * size, ( rect.y + rect.h ) * size );
+	}
+
+	// Platforms are zero-thickness slabs along the top of each horizontal run.
+	for ( int y = 0; y < map->getHeight(); y++ ) {
+		for ( int x = 0; x < map->getWidth(); x++ ) {
+			if ( map->get( x, y ) != Tile::Platform ) continue;
+
+			int w = 1;
+			while ( x + w < map->getWidth() && map->get( x + w, y ) == Tile::Platform ) w++;
+			pushRect( platformMinX, platformMinY, platformMaxX, platformMaxY, x * size, ( y + 1 ) * size, ( x + w ) * size, ( y + 1 ) * size );
+			x += w - 1;
+		}
+	}
+
+	padRects( solidMinX, solidMinY, solidMaxX, solidMaxY );
+	padRects( platformMinX, platformMinY, platformMaxX, platformMaxY );
+}
+
+uint32_t QueryService::submitRay( const RayQuery& query ) {
+	return submitRays( &query, 1 );
+}
+
+uint32_t QueryService::submitRays( const RayQuery* queries, size_t count ) {
+	std::lock_guard<std::mutex> lock( submitMutex );
+	uint32_t first = static_cast< uint32_t >( rays.size() );
+	rays.insert( rays.end(), queries, queries + count );
+	return first;
+}
+
+uint32_t QueryService::submitAabb( const AabbQuery& query ) {
+	return submitAabbs( &query, 1 );
+}
+
+uint32_t QueryService::submitAabbs( const AabbQuery* queries, size_t count ) {
+	std::lock_guard<std::mutex> lock( submitMutex );
+	uint32_t first = static_cast< uint32_t >( aabbs.size() );
+	aabbs.insert( aabbs.end(), queries, queries + count );
+	return first;
+}
+
+void QueryService::execute() {
+	auto begin = std::chrono::steady_clock::now();
+	JobSystem& jobs = JobSystem::getInstance();
+
+	// Rays write straight into their own slot, so no merging is needed.
+	rayHits.assign( rays.size(), RayHit() );
+	jobs.parallelFor( rays.size(), QUERY_GRAIN, [ this ]( size_t first, size_t last ) {
+		for ( size_t i = first; i < last; i++ ) castRay( rays[ i ], rayHits[ i ] );
+	} );
+
+	// AABB queries append to per-chunk lists, which are then concatenated in chunk order.
+	const size_t chunks = ( aabbs.size() + QUERY_GRAIN - 1 ) / QUERY_GRAIN;
+	if ( chunkOverlaps.size() < chunks ) chunkOverlaps.resize( chunks );
+	aabbResults.assign( aabbs.size(), AabbResult() );
+	jobs.parallelFor( aabbs.size(), QUERY_GRAIN, [ this ]( size_t first, size_t last ) {
+		std::vector<b2Fixture*>& out = chunkOverlaps[ first / QUERY_GRAIN ];
+		out.clear();
+		for ( size_t i = first; i < last; i++ ) {
+			aabbResults[ i ].first = static_cast< uint32_t >( out.size() );
+			queryAabb( aabbs[ i ], aabbResults[ i ], out );
+		}
+	} );
+
+	overlaps.clear();
+	for ( size_t chunk = 0; chunk < chunks; chunk++ ) {
+		const uint32_t base = static_cast< uint32_t >( overlaps.size() );
+		const size_t last = std::min( ( chunk + 1 ) * QUERY_GRAIN, aabbs.size() );
+		for ( size_t i = chunk * QUERY_GRAIN; i < last; i++ ) aabbResults[ i ].first += base;
+		overlaps.insert( overlaps.end(), chunkOverlaps[ chunk ].begin(), chunkOverlaps[ chunk ].end() );
+	}
+
+	stats.rays = rays.size();
+	stats.aabbs = aabbs.size();
+	stats.executeMs = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - begin ).count();
+	stats.queriesPerMs = stats.executeMs > 0.0 ? ( stats.rays + stats.aabbs ) / stats.executeMs : 0.0;
+
+	rays.clear();
+	aabbs.clear();
+}
+
+void QueryService::clear() {
+	std::lock_guard<std::mutex> lock( submitMutex );
+	rays.clear();
+	aabbs.clear();
+	rayHits.clear();
+	aabbResults.clear();
+	overlaps.clear();
+}
+
+void QueryService::castRay( const RayQuery& query, RayHit& hit ) const {
+	const b2Vec2 d = query.to - query.from;
+	hit.point = query.to;
+
+	if ( tileMap && ( query.mask & CATEGORY_TILES ) ) {
+		// Clamp near-zero directions so the slab math never multiplies 0 by infinity.
+		b2Vec2 invDir( 1.0f / ( std::fabs( d.x ) > 1e-12f ? d.x : ( d.x < 0.0f ? -1e-12f : 1e-12f ) ),
+			1.0f / ( std::fabs( d.y ) > 1e-12f ? d.y : ( d.y < 0.0f ? -1e-12f : 1e-12f ) ) );
+
+		SlabHit best = slabTest( solidMinX.data(), solidMinY.data(), solidMaxX.data(), solidMaxY.data(), solidMinX.size(),
+			query.from, invDir, 1.0f );
+		if ( d.y < 0.0f ) {
+			SlabHit platform = slabTest( platformMinX.data(), platformMinY.data(), platformMaxX.data(), platformMaxY.data(),
+				platformMinX.size(), query.from, invDir, best.t );
+			if ( platform.index >= 0 ) best = platform;
+		}
+
+		if ( best.index >= 0 ) {
+			hit.hit = true;
+			hit.hitTiles = true;
+			hit.fraction = best.t;
+			hit.normal = best.xAxis ? b2Vec2( d.x > 0.0f ? -1.0f : 1.0f, 0.0f ) : b2Vec2( 0.0f, d.y > 0.0f ? -1.0f : 1.0f );
+		}
+	}
+
+	if ( hit.fraction > 0.0f ) {
+		const b2BroadPhase& broadPhase = world.getWorld().GetContactManager().m_broadPhase;
+		TreeRayCallback callback{ &broadPhase, query.mask, tileMap != nullptr, &hit };
+
+		b2RayCastInput input;
+		input.p1 = query.from;
+		input.p2 = query.to;
+		input.maxFraction = hit.fraction; // Nothing behind the nearest wall can be hit.
+		broadPhase.RayCast( &callback, input );
+	}
+
+	if ( hit.hit ) hit.point = query.from + hit.fraction * d;
+}
+
+void QueryService::queryAabb( const AabbQuery& query, AabbResult& result, std::vector<b2Fixture*>& out ) const {
+	if ( tileMap && ( query.mask & CATEGORY_TILES ) ) {
+		result.touchesTiles = overlapTest( solidMinX.data(), solidMinY.data(), solidMaxX.data(), solidMaxY.data(), solidMinX.size(), query.box );
+	}
+
+	const size_t before = out.size();
+	const b2BroadPhase& broadPhase = world.getWorld().GetContactManager().m_broadPhase;
+	TreeAabbCallback callback{ &broadPhase, &query.box, query.mask, tileMap != nullptr, &out };
+	broadPhase.Query( &callback, query.box );
+
+	result.count = static_cast< uint32_t >( out.size() - before );
+}
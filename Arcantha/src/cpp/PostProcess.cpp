@@ -0,0 +1,555 @@
+#include "PostProcess.h" // Includes the PostProcess and RenderTargetPool class definitions.
+#include "Log.h" // Includes the Logger for error output.
+
+#include <algorithm> // Required for std::min and std::max.
+#include <chrono> // Required for timing endScene().
+#include <string> // Required for assembling composite shader variants.
+
+#include <glad/glad.h> // Includes GLAD for OpenGL function loading.
+
+const uint64_t RenderTargetPool::EVICT_FRAMES;
+const int PostProcess::MAX_BLOOM_LEVELS;
+const int PostProcess::MAX_PASSES;
+const int PostProcess::GPU_QUERIES;
+const uint32_t PostProcess::FEATURE_BLOOM;
+const uint32_t PostProcess::FEATURE_GRADING;
+const uint32_t PostProcess::FEATURE_VIGNETTE;
+
+// A full-screen triangle from the vertex id, shared by every pass.
+static const char* FULLSCREEN_VERTEX_SHADER = R"(#version 330 core
+out vec2 vUv;
+void main() {
+	vec2 corner = vec2( ( gl_VertexID << 1 ) & 2, gl_VertexID & 2 );
+	vUv = corner;
+	gl_Position = vec4( corner * 2.0 - 1.0, 0.0, 1.0 );
+}
+)";
+
+// 13 bilinear taps in overlapping boxes, which keeps small bright spots from flickering as they move.
+// A positive threshold merges the bloom bright pass into the first step.
+static const char* DOWNSAMPLE_FRAGMENT_SHADER = R"(#version 330 core
+in vec2 vUv;
+uniform sampler2D uSource;
+uniform vec2 uTexel;
+uniform float uThreshold;
+uniform float uKnee;
+out vec4 fragColor;
+vec3 tap( float x, float y ) {
+	return texture( uSource, vUv + uTexel * vec2( x, y ) ).rgb;
+}
+void main() {
+	vec3 color = tap( 0.0, 0.0 ) * 0.125;
+	color += ( tap( -2.0, 2.0 ) + tap( 2.0, 2.0 ) + tap( -2.0, -2.0 ) + tap( 2.0, -2.0 ) ) * 0.03125;
+	color += ( tap( 0.0, 2.0 ) + tap( -2.0, 0.0 ) + tap( 2.0, 0.0 ) + tap( 0.0, -2.0 ) ) * 0.0625;
+	color += ( tap( -1.0, 1.0 ) + tap( 1.0, 1.0 ) + tap( -1.0, -1.0 ) + tap( 1.0, -1.0 ) ) * 0.125;
+	if ( uThreshold > 0.0 ) {
+		float brightness = max( color.r, max( color.g, color.b ) );
+		float soft = clamp( brightness - uThreshold + uKnee, 0.0, 2.0 * uKnee );
+		soft = soft * soft / ( 4.0 * uKnee + 1e-5 );
+		color *= max( soft, brightness - uThreshold ) / max( brightness, 1e-5 );
+	}
+	fragColor = vec4( color, 1.0 );
+}
+)";
+
+// A 3x3 tent, blended additively onto the next larger mip.
+static const char* UPSAMPLE_FRAGMENT_SHADER = R"(#version 330 core
+in vec2 vUv;
+uniform sampler2D uSource;
+uniform vec2 uTexel;
+uniform float uRadius;
+out vec4 fragColor;
+vec3 tap( float x, float y ) {
+	return texture( uSource, vUv + uTexel * uRadius * vec2( x, y ) ).rgb;
+}
+void main() {
+	vec3 color = tap( 0.0, 0.0 ) * 4.0;
+	color += ( tap( 0.0, 1.0 ) + tap( -1.0, 0.0 ) + tap( 1.0, 0.0 ) + tap( 0.0, -1.0 ) ) * 2.0;
+	color += tap( -1.0, 1.0 ) + tap( 1.0, 1.0 ) + tap( -1.0, -1.0 ) + tap( 1.0, -1.0 );
+	fragColor = vec4( color / 16.0, 1.0 );
+}
+)";
+
+// Every per-pixel effect of the final image in one pass; the #defines in front pick the effects.
+static const char* COMPOSITE_FRAGMENT_SHADER = R"(
+in vec2 vUv;
+uniform sampler2D uScene;
+uniform sampler2D uBloom;
+uniform float uBloomIntensity;
+uniform float uExposure;
+uniform vec3 uLift;
+uniform vec3 uGamma;
+uniform vec3 uGain;
+uniform float uSaturation;
+uniform float uVignette;
+out vec4 fragColor;
+void main() {
+	vec3 color = texture( uScene, vUv ).rgb;
+#if BLOOM
+	color += texture( uBloom, vUv ).rgb * uBloomIntensity;
+#endif
+	color = vec3( 1.0 ) - exp( -color * uExposure );
+#if GRADING
+	color = uGain * ( color + uLift * ( vec3( 1.0 ) - color ) );
+	color = pow( max( color, vec3( 0.0 ) ), vec3( 1.0 ) / uGamma );
+	float luma = dot( color, vec3( 0.2126, 0.7152, 0.0722 ) );
+	color = mix( vec3( luma ), color, uSaturation );
+#endif
+#if VIGNETTE
+	vec2 fromCenter = vUv - 0.5;
+	color *= 1.0 - uVignette * dot( fromCenter, fromCenter ) * 2.0;
+#endif
+	fragColor = vec4( color, 1.0 );
+}
+)";
+
+/**
+ * @brief Gets the milliseconds elapsed since a time point.
+ * @param since The start.
+ * @return Elapsed milliseconds.
+ */
+static double elapsedMs( std::chrono::steady_clock::time_point since ) {
+	return std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - since ).count();
+}
+
+/**
+ * @brief Compiles one shader stage.
+ * @param type GL_VERTEX_SHADER or GL_FRAGMENT_SHADER.
+ * @param source GLSL source.
+ * @return The shader, or 0 on failure.
+ */
+static GLuint compileShader( GLenum type, const char* source ) {
+	GLuint shader = glCreateShader( type );
+	glShaderSource( shader, 1, &source, nullptr );
+	glCompileShader( shader );
+	GLint ok = 0;
+	glGetShaderiv( shader, GL_COMPILE_STATUS, &ok );
+	if ( !ok ) {
+		char log[ 512 ];
+		glGetShaderInfoLog( shader, sizeof( log ), nullptr, log );
+		LOG_ERROR( "Post-process shader failed to compile: {}", log );
+		glDeleteShader( shader );
+		return 0;
+	}
+	return shader;
+}
+
+/**
+ * @brief Compiles and links a program.
+ * @param vertexSource Vertex shader GLSL.
+ * @param fragmentSource Fragment shader GLSL.
+ * @return The program, or 0 on failure.
+ */
+static GLuint linkProgram( const char* vertexSource, const char* fragmentSource ) {
+	GLuint vertexShader = compileShader( GL_VERTEX_SHADER, vertexSource );
+	GLuint fragmentShader = compileShader( GL_FRAGMENT_SHADER, fragmentSource );
+	if ( !vertexShader || !fragmentShader ) {
+		if ( vertexShader ) glDeleteShader( vertexShader );
+		if ( fragmentShader ) glDeleteShader( fragmentShader );
+		return 0;
+	}
+	GLuint program = glCreateProgram();
+	glAttachShader( program, vertexShader );
+	glAttachShader( program, fragmentShader );
+	glLinkProgram( program );
+	glDeleteShader( vertexShader );
+	glDeleteShader( fragmentShader );
+	GLint linked = 0;
+	glGetProgramiv( program, GL_LINK_STATUS, &linked );
+	if ( !linked ) {
+		LOG_ERROR( "Post-process shader failed to link." );
+		glDeleteProgram( program );
+		return 0;
+	}
+	return program;
+}
+
+void RenderTargetPool::setGLEnabled( bool enabled ) {
+	if ( enabled == glEnabled ) return;
+	clear(); // Targets made in the other mode have no (or dead) GL objects.
+	glEnabled = enabled;
+}
+
+int RenderTargetPool::acquire( const RenderTargetDesc& desc ) {
+	int emptySlot = -1;
+	for ( size_t i = 0; i < entries.size(); i++ ) {
+		Entry& entry = entries[ i ];
+		if ( entry.desc.width == 0 ) {
+			if ( emptySlot < 0 ) emptySlot = static_cast< int >( i );
+			continue;
+		}
+		if ( entry.inUse || !( entry.desc == desc ) ) continue;
+		entry.inUse = true;
+		entry.lastUsed = frame;
+		stats.reused++;
+		stats.inUse++;
+		return static_cast< int >( i );
+	}
+
+	if ( emptySlot < 0 ) {
+		entries.emplace_back();
+		emptySlot = static_cast< int >( entries.size() - 1 );
+	}
+	Entry& entry = entries[ emptySlot ];
+	entry.desc = desc;
+	if ( glEnabled && !createGL( entry ) ) {
+		entry = Entry();
+		return -1;
+	}
+	entry.inUse = true;
+	entry.lastUsed = frame;
+	stats.created++;
+	stats.targets++;
+	stats.inUse++;
+	stats.bytes += static_cast< uint64_t >( desc.width ) * desc.height * bytesPerPixel( desc.format );
+	return emptySlot;
+}
+
+void RenderTargetPool::release( int handle ) {
+	if ( handle < 0 || handle >= static_cast< int >( entries.size() ) || !entries[ handle ].inUse ) return;
+	entries[ handle ].inUse = false;
+	stats.inUse--;
+}
+
+void RenderTargetPool::endFrame() {
+	frame++;
+	for ( Entry& entry : entries ) {
+		if ( entry.desc.width == 0 || entry.inUse || frame - entry.lastUsed <= EVICT_FRAMES ) continue;
+		destroy( entry );
+		stats.evicted++;
+	}
+}
+
+void RenderTargetPool::clear() {
+	for ( Entry& entry : entries ) {
+		if ( entry.desc.width != 0 ) destroy( entry );
+	}
+	entries.clear();
+	stats.inUse = 0;
+}
+
+bool RenderTargetPool::createGL( Entry& entry ) {
+	GLint internalFormat = GL_RGBA8;
+	GLenum format = GL_RGBA, type = GL_UNSIGNED_BYTE;
+	if ( entry.desc.format == TargetFormat::R11G11B10F ) {
+		internalFormat = GL_R11F_G11F_B10F;
+		format = GL_RGB;
+		type = GL_HALF_FLOAT;
+	}
+	else if ( entry.desc.format == TargetFormat::Rgba16F ) {
+		internalFormat = GL_RGBA16F;
+		type = GL_HALF_FLOAT;
+	}
+	glGenTextures( 1, &entry.texture );
+	glBindTexture( GL_TEXTURE_2D, entry.texture );
+	glTexImage2D( GL_TEXTURE_2D, 0, internalFormat, entry.desc.width, entry.desc.height, 0, format, type, nullptr );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	glGenFramebuffers( 1, &entry.fbo );
+	GLint previous = 0;
+	glGetIntegerv( GL_FRAMEBUFFER_BINDING, &previous );
+	glBindFramebuffer( GL_FRAMEBUFFER, entry.fbo );
+	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, entry.texture, 0 );
+	const bool complete = glCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer( GL_FRAMEBUFFER, static_cast< GLuint >( previous ) );
+	if ( !complete ) {
+		LOG_ERROR( "Pooled render target {}x{} is incomplete.", entry.desc.width, entry.desc.height );
+		glDeleteFramebuffers( 1, &entry.fbo );
+		glDeleteTextures( 1, &entry.texture );
+		entry.fbo = entry.texture = 0;
+		return false;
+	}
+	return true;
+}
+
+void RenderTargetPool::destroy( Entry& entry ) {
+	if ( glEnabled ) {
+		glDeleteFramebuffers( 1, &entry.fbo );
+		glDeleteTextures( 1, &entry.texture );
+	}
+	if ( entry.inUse ) stats.inUse--;
+	stats.targets--;
+	stats.bytes -= static_cast< uint64_t >( entry.desc.width ) * entry.desc.height * bytesPerPixel( entry.desc.format );
+	entry = Entry();
+}
+
+PostQualitySettings PostProcess::settingsFor( PostQuality quality ) {
+	PostQualitySettings settings;
+	switch ( quality ) {
+	case PostQuality::Off:
+		settings.sceneFormat = TargetFormat::Rgba8;
+		break;
+	case PostQuality::Low:
+		settings.bloomLevels = 3;
+		settings.bloomDivisor = 4;
+		settings.grading = true;
+		break;
+	case PostQuality::Medium:
+		settings.bloomLevels = 5;
+		settings.grading = true;
+		settings.vignette = true;
+		break;
+	case PostQuality::High:
+		settings.bloomLevels = 6;
+		settings.sceneFormat = TargetFormat::Rgba16F;
+		settings.grading = true;
+		settings.vignette = true;
+		break;
+	}
+	return settings;
+}
+
+PostPlan PostProcess::buildPlan( int width, int height, const PostQualitySettings& quality ) {
+	PostPlan plan;
+	plan.width = std::max( width, 1 );
+	plan.height = std::max( height, 1 );
+	plan.targets.push_back( { plan.width, plan.height, quality.sceneFormat } );
+
+	const auto area = []( const RenderTargetDesc& desc ) { return static_cast< uint64_t >( desc.width ) * desc.height; };
+	const auto addPass = [ & ]( PostPassKind kind, int source, int target, bool blend ) {
+		const RenderTargetDesc& read = plan.targets[ source ];
+		const RenderTargetDesc& written = plan.targets[ target ];
+		const uint64_t fragments = area( written );
+		const uint64_t bytes = area( read ) * RenderTargetPool::bytesPerPixel( read.format ) + fragments * RenderTargetPool::bytesPerPixel( written.format ) * ( blend ? 2 : 1 );
+		plan.passes.push_back( { kind, source, target, written.width, written.height, fragments, bytes } );
+	};
+
+	const int levels = std::min( quality.bloomLevels, MAX_BLOOM_LEVELS );
+	int levelWidth = std::max( plan.width / std::max( quality.bloomDivisor, 1 ), 1 ), levelHeight = std::max( plan.height / std::max( quality.bloomDivisor, 1 ), 1 );
+	for ( int level = 0; level < levels; level++ ) {
+		plan.targets.push_back( { levelWidth, levelHeight, TargetFormat::R11G11B10F } );
+		if ( levelWidth == 1 && levelHeight == 1 ) break;
+		levelWidth = std::max( levelWidth / 2, 1 );
+		levelHeight = std::max( levelHeight / 2, 1 );
+	}
+	const int mips = static_cast< int >( plan.targets.size() ) - 1;
+	if ( mips > 0 ) {
+		addPass( PostPassKind::Prefilter, 0, 1, false );
+		for ( int mip = 2; mip <= mips; mip++ ) addPass( PostPassKind::Downsample, mip - 1, mip, false );
+		for ( int mip = mips; mip >= 2; mip-- ) addPass( PostPassKind::Upsample, mip, mip - 1, true );
+		plan.compositeFeatures |= FEATURE_BLOOM;
+	}
+	if ( quality.grading ) plan.compositeFeatures |= FEATURE_GRADING;
+	if ( quality.vignette ) plan.compositeFeatures |= FEATURE_VIGNETTE;
+
+	// The composite reads the scene and the largest bloom mip and writes the 8-bit output.
+	const uint64_t screen = area( plan.targets[ 0 ] );
+	uint64_t compositeBytes = screen * RenderTargetPool::bytesPerPixel( quality.sceneFormat ) + screen * 4;
+	if ( mips > 0 ) compositeBytes += area( plan.targets[ 1 ] ) * RenderTargetPool::bytesPerPixel( TargetFormat::R11G11B10F );
+	plan.passes.push_back( { PostPassKind::Composite, 0, -1, plan.width, plan.height, screen, compositeBytes } );
+
+	for ( const PostPass& pass : plan.passes ) {
+		plan.fragments += pass.fragments;
+		plan.bytes += pass.bytes;
+	}
+	return plan;
+}
+
+bool PostProcess::initGL( int width, int height ) {
+	if ( glReady ) return true;
+	downsampleProgram = linkProgram( FULLSCREEN_VERTEX_SHADER, DOWNSAMPLE_FRAGMENT_SHADER );
+	upsampleProgram = linkProgram( FULLSCREEN_VERTEX_SHADER, UPSAMPLE_FRAGMENT_SHADER );
+	if ( !downsampleProgram || !upsampleProgram ) {
+		if ( downsampleProgram ) glDeleteProgram( downsampleProgram );
+		if ( upsampleProgram ) glDeleteProgram( upsampleProgram );
+		downsampleProgram = upsampleProgram = 0;
+		return false;
+	}
+	downsampleTexelLocation = glGetUniformLocation( downsampleProgram, "uTexel" );
+	thresholdLocation = glGetUniformLocation( downsampleProgram, "uThreshold" );
+	kneeLocation = glGetUniformLocation( downsampleProgram, "uKnee" );
+	upsampleTexelLocation = glGetUniformLocation( upsampleProgram, "uTexel" );
+	radiusLocation = glGetUniformLocation( upsampleProgram, "uRadius" );
+
+	glGenVertexArrays( 1, &emptyVao );
+	glGenQueries( GPU_QUERIES * MAX_PASSES, &queries[ 0 ][ 0 ] );
+	pool.setGLEnabled( true );
+	glReady = true;
+	this->width = this->height = 0; // Forces resize() to rebuild the plan.
+	resize( width, height );
+	return true;
+}
+
+void PostProcess::shutdownGL() {
+	if ( !glReady ) return;
+	pool.setGLEnabled( false );
+	glDeleteQueries( GPU_QUERIES * MAX_PASSES, &queries[ 0 ][ 0 ] );
+	for ( CompositeProgram& composite : compositePrograms ) {
+		if ( composite.program ) glDeleteProgram( composite.program );
+		composite = CompositeProgram();
+	}
+	glDeleteProgram( downsampleProgram );
+	glDeleteProgram( upsampleProgram );
+	glDeleteVertexArrays( 1, &emptyVao );
+	downsampleProgram = upsampleProgram = emptyVao = 0;
+	for ( int row = 0; row < GPU_QUERIES; row++ ) {
+		for ( int pass = 0; pass < MAX_PASSES; pass++ ) queries[ row ][ pass ] = 0;
+		queryPasses[ row ] = 0;
+	}
+	sceneHandle = -1;
+	glReady = false;
+}
+
+void PostProcess::resize( int width, int height ) {
+	width = std::max( width, 1 );
+	height = std::max( height, 1 );
+	if ( width == this->width && height == this->height ) return;
+	this->width = width;
+	this->height = height;
+	rebuildPlan();
+}
+
+void PostProcess::setQuality( PostQuality requested ) {
+	if ( requested == quality && !plan.passes.empty() ) return;
+	quality = requested;
+	rebuildPlan();
+}
+
+void PostProcess::rebuildPlan() {
+	plan = buildPlan( width, height, settingsFor( quality ) );
+	stats.passGpuMs.assign( plan.passes.size(), 0.0 );
+	stats.gpuMs = 0.0;
+	for ( int& passes : queryPasses ) passes = 0; // Timings of the old passes would be misattributed.
+}
+
+const PostProcess::CompositeProgram& PostProcess::compositeProgram( uint32_t features ) {
+	CompositeProgram& composite = compositePrograms[ features & 7u ];
+	if ( composite.program ) return composite;
+	std::string source = "#version 330 core\n";
+	source += ( features & FEATURE_BLOOM ) ? "#define BLOOM 1\n" : "#define BLOOM 0\n";
+	source += ( features & FEATURE_GRADING ) ? "#define GRADING 1\n" : "#define GRADING 0\n";
+	source += ( features & FEATURE_VIGNETTE ) ? "#define VIGNETTE 1\n" : "#define VIGNETTE 0\n";
+	source += COMPOSITE_FRAGMENT_SHADER;
+	const GLuint program = linkProgram( FULLSCREEN_VERTEX_SHADER, source.c_str() );
+	composite.program = program;
+	if ( !program ) return composite;
+
+	glUseProgram( program );
+	glUniform1i( glGetUniformLocation( program, "uScene" ), 0 );
+	glUniform1i( glGetUniformLocation( program, "uBloom" ), 1 );
+	composite.bloomIntensityLocation = glGetUniformLocation( program, "uBloomIntensity" );
+	composite.exposureLocation = glGetUniformLocation( program, "uExposure" );
+	composite.liftLocation = glGetUniformLocation( program, "uLift" );
+	composite.gammaLocation = glGetUniformLocation( program, "uGamma" );
+	composite.gainLocation = glGetUniformLocation( program, "uGain" );
+	composite.saturationLocation = glGetUniformLocation( program, "uSaturation" );
+	composite.vignetteLocation = glGetUniformLocation( program, "uVignette" );
+	return composite;
+}
+
+bool PostProcess::beginScene() {
+	if ( !glReady ) return false;
+	glGetIntegerv( GL_FRAMEBUFFER_BINDING, &outputFbo );
+	glGetIntegerv( GL_VIEWPORT, outputViewport );
+	sceneHandle = pool.acquire( plan.targets[ 0 ] );
+	if ( sceneHandle < 0 ) return false;
+	glBindFramebuffer( GL_FRAMEBUFFER, pool.getFramebuffer( sceneHandle ) );
+	glViewport( 0, 0, plan.width, plan.height );
+	return true;
+}
+
+void PostProcess::endScene() {
+	if ( !glReady || sceneHandle < 0 ) return;
+	const auto start = std::chrono::steady_clock::now();
+
+	// Read the timings issued GPU_QUERIES frames ago if they are done; otherwise skip timing this frame.
+	const int slot = queryIndex;
+	bool timing = true;
+	if ( queryPasses[ slot ] > 0 ) {
+		GLint available = 0;
+		glGetQueryObjectiv( queries[ slot ][ queryPasses[ slot ] - 1 ], GL_QUERY_RESULT_AVAILABLE, &available );
+		if ( available ) {
+			stats.gpuMs = 0.0;
+			for ( int pass = 0; pass < queryPasses[ slot ]; pass++ ) {
+				GLuint64 nanoseconds = 0;
+				glGetQueryObjectui64v( queries[ slot ][ pass ], GL_QUERY_RESULT, &nanoseconds );
+				stats.passGpuMs[ pass ] = static_cast< double >( nanoseconds ) / 1e6;
+				stats.gpuMs += stats.passGpuMs[ pass ];
+			}
+			queryPasses[ slot ] = 0;
+		}
+		else {
+			timing = false;
+		}
+	}
+
+	// Without every bloom mip the chain falls back to the composite alone.
+	handles.assign( plan.targets.size(), -1 );
+	handles[ 0 ] = sceneHandle;
+	const bool planned = ( plan.compositeFeatures & FEATURE_BLOOM ) != 0;
+	bool bloom = planned;
+	for ( size_t target = 1; target < plan.targets.size() && bloom; target++ ) {
+		handles[ target ] = pool.acquire( plan.targets[ target ] );
+		bloom = handles[ target ] >= 0;
+	}
+
+	stats.drawCalls = 0;
+	glBindVertexArray( emptyVao );
+	glActiveTexture( GL_TEXTURE0 );
+	for ( size_t index = 0; index < plan.passes.size(); index++ ) {
+		const PostPass& pass = plan.passes[ index ];
+		if ( pass.kind != PostPassKind::Composite && !bloom ) continue;
+		if ( timing ) glBeginQuery( GL_TIME_ELAPSED, queries[ slot ][ index ] );
+		const RenderTargetDesc& source = plan.targets[ pass.source ];
+		const glm::vec2 texel( 1.0f / source.width, 1.0f / source.height );
+		if ( pass.kind == PostPassKind::Composite ) {
+			const uint32_t features = bloom ? plan.compositeFeatures : plan.compositeFeatures & ~FEATURE_BLOOM;
+			const CompositeProgram& composite = compositeProgram( features );
+			glBindFramebuffer( GL_FRAMEBUFFER, static_cast< GLuint >( outputFbo ) );
+			glViewport( outputViewport[ 0 ], outputViewport[ 1 ], outputViewport[ 2 ], outputViewport[ 3 ] );
+			glDisable( GL_BLEND );
+			glUseProgram( composite.program );
+			glUniform1f( composite.bloomIntensityLocation, settings.bloomIntensity );
+			glUniform1f( composite.exposureLocation, settings.exposure );
+			glUniform3fv( composite.liftLocation, 1, &settings.lift[ 0 ] );
+			glUniform3fv( composite.gammaLocation, 1, &settings.gamma[ 0 ] );
+			glUniform3fv( composite.gainLocation, 1, &settings.gain[ 0 ] );
+			glUniform1f( composite.saturationLocation, settings.saturation );
+			glUniform1f( composite.vignetteLocation, settings.vignette );
+			glBindTexture( GL_TEXTURE_2D, pool.getTexture( sceneHandle ) );
+			if ( bloom ) {
+				glActiveTexture( GL_TEXTURE1 );
+				glBindTexture( GL_TEXTURE_2D, pool.getTexture( handles[ 1 ] ) );
+				glActiveTexture( GL_TEXTURE0 );
+			}
+		}
+		else {
+			const RenderTargetDesc& target = plan.targets[ pass.target ];
+			glBindFramebuffer( GL_FRAMEBUFFER, pool.getFramebuffer( handles[ pass.target ] ) );
+			glViewport( 0, 0, target.width, target.height );
+			glBindTexture( GL_TEXTURE_2D, pool.getTexture( handles[ pass.source ] ) );
+			if ( pass.kind == PostPassKind::Upsample ) {
+				glUseProgram( upsampleProgram );
+				glUniform2f( upsampleTexelLocation, texel.x, texel.y );
+				glUniform1f( radiusLocation, settings.bloomRadius );
+				glEnable( GL_BLEND );
+				glBlendFunc( GL_ONE, GL_ONE );
+			}
+			else {
+				glUseProgram( downsampleProgram );
+				glUniform2f( downsampleTexelLocation, texel.x, texel.y );
+				glUniform1f( thresholdLocation, pass.kind == PostPassKind::Prefilter ? settings.bloomThreshold : 0.0f );
+				glUniform1f( kneeLocation, settings.bloomKnee );
+				glDisable( GL_BLEND );
+			}
+		}
+		glDrawArrays( GL_TRIANGLES, 0, 3 );
+		stats.drawCalls++;
+		if ( timing ) glEndQuery( GL_TIME_ELAPSED );
+	}
+	if ( timing && bloom == planned ) {
+		queryPasses[ slot ] = static_cast< int >( plan.passes.size() );
+		queryIndex = ( slot + 1 ) % GPU_QUERIES;
+	}
+	glBindVertexArray( 0 );
+	glEnable( GL_BLEND );
+	glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+
+	for ( int handle : handles ) pool.release( handle );
+	sceneHandle = -1;
+	pool.endFrame();
+	stats.passes = static_cast< uint32_t >( plan.passes.size() );
+	stats.cpuMs = elapsedMs( start );
+}
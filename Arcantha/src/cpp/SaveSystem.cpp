@@ -0,0 +1,470 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h> // Required for CreateFile, FlushFileBuffers and MoveFileEx.
+#else
+#include <fcntl.h> // Required for open.
+#include <unistd.h> // Required for write, fsync and close.
+#endif
+
+#include <algorithm> // Required for std::min.
+#include <chrono> // Required for timing snapshots and writes.
+#include <cstdio> // Required for std::snprintf and std::rename.
+#include <cstring> // Required for std::memcpy.
+#include <filesystem> // Required to create and list the save directory.
+
+#include "MappedFile.h" // Includes the MappedFile used to load chunks and the manifest.
+#include "SaveSystem.h" // Includes the SaveSystem class definition.
+#include "Log.h" // Includes the Logger for error output.
+
+static const uint32_t CHUNK_MAGIC = 0x4B484341; // "ACHK" little-endian.
+static const uint32_t MANIFEST_MAGIC = 0x4E414D41; // "AMAN" little-endian.
+static const size_t CHUNK_HEADER_BYTES = 40; // magic, format, id, version, element size, generation, size, crc, padding.
+static const size_t MANIFEST_HEADER_BYTES = 20; // magic, format, generation, entry count.
+static const size_t ENTRY_BYTES = 28; // id, version, element size, generation, size, crc.
+static const char* MANIFEST_NAME = "manifest.bin";
+static const char* MANIFEST_TEMP_NAME = "manifest.tmp";
+
+const uint32_t SaveSystem::FORMAT_VERSION;
+
+/**
+ * @brief Updates a CRC-32 (IEEE, as in zlib) with more bytes.
+ */
+static uint32_t crc32( uint32_t crc, const void* data, size_t size ) {
+	static const struct Table
+	{
+		uint32_t values[ 256 ];
+		Table() {
+			for ( uint32_t i = 0; i < 256; i++ ) {
+				uint32_t c = i;
+				for ( int bit = 0; bit < 8; bit++ ) c = ( c & 1 ) ? 0xEDB88320u ^ ( c >> 1 ) : c >> 1;
+				values[ i ] = c;
+			}
+		}
+	} table;
+
+	const uint8_t* bytes = static_cast< const uint8_t* >( data );
+	crc = ~crc;
+	for ( size_t i = 0; i < size; i++ ) crc = table.values[ ( crc ^ bytes[ i ] ) & 0xFF ] ^ ( crc >> 8 );
+	return ~crc;
+}
+
+// Little helpers to lay out headers field by field, independent of struct padding.
+template < typename T >
+static void put( uint8_t*& cursor, T value ) {
+	std::memcpy( cursor, &value, sizeof( T ) );
+	cursor += sizeof( T );
+}
+
+template < typename T >
+static T get( const uint8_t*& cursor ) {
+	T value;
+	std::memcpy( &value, cursor, sizeof( T ) );
+	cursor += sizeof( T );
+	return value;
+}
+
+/**
+ * @brief A contiguous range of bytes to write.
+ */
+struct WritePiece
+{
+	const void* data;
+	size_t size;
+};
+
+#ifdef _WIN32
+
+// Writes a file and flushes it to the disk before returning.
+static bool writeDurable( const std::string& path, const std::vector<WritePiece>& pieces ) {
+	HANDLE file = CreateFileA( path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( file == INVALID_HANDLE_VALUE ) return false;
+	bool ok = true;
+	for ( const WritePiece& piece : pieces ) {
+		DWORD written = 0;
+		if ( !WriteFile( file, piece.data, static_cast< DWORD >( piece.size ), &written, NULL ) || written != piece.size ) {
+			ok = false;
+			break;
+		}
+	}
+	ok = ok && FlushFileBuffers( file );
+	CloseHandle( file );
+	return ok;
+}
+
+// Atomically replaces a file; MOVEFILE_WRITE_THROUGH returns once the rename is on disk.
+static bool replaceDurable( const std::string& from, const std::string& to, const std::string& ) {
+	return MoveFileExA( from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH ) != 0;
+}
+
+#else
+
+// Writes a file and fsyncs it before returning.
+static bool writeDurable( const std::string& path, const std::vector<WritePiece>& pieces ) {
+	int fd = ::open( path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+	if ( fd < 0 ) return false;
+	bool ok = true;
+	for ( const WritePiece& piece : pieces ) {
+		const uint8_t* bytes = static_cast< const uint8_t* >( piece.data );
+		size_t left = piece.size;
+		while ( ok && left > 0 ) {
+			const ssize_t written = ::write( fd, bytes, left );
+			if ( written <= 0 ) ok = false;
+			else {
+				bytes += written;
+				left -= static_cast< size_t >( written );
+			}
+		}
+	}
+	ok = ok && fsync( fd ) == 0;
+	::close( fd );
+	return ok;
+}
+
+// Atomically replaces a file, then fsyncs the directory so the rename itself is durable.
+static bool replaceDurable( const std::string& from, const std::string& to, const std::string& directory ) {
+	if ( std::rename( from.c_str(), to.c_str() ) != 0 ) return false;
+	int fd = ::open( directory.c_str(), O_RDONLY );
+	if ( fd < 0 ) return false;
+	const bool ok = fsync( fd ) == 0;
+	::close( fd );
+	return ok;
+}
+
+#endif
+
+SaveSystem::~SaveSystem() {
+	close();
+}
+
+void SaveSystem::registerSection( uint32_t id, uint16_t version, PagedBuffer* buffer, SaveMigration migration ) {
+	sections.push_back( { id, version, buffer, std::move( migration ) } );
+}
+
+bool SaveSystem::open( const std::string& path ) {
+	close();
+
+	std::error_code error;
+	std::filesystem::create_directories( path, error );
+	if ( error ) {
+		LOG_ERROR( "Failed to create save directory {}: {}", path, error.message() );
+		return false;
+	}
+	directory = path;
+
+	uint64_t generation = 0;
+	entries.clear();
+	if ( !readManifest( entries, generation ) ) entries.clear();
+	committed.store( generation, std::memory_order_release );
+	nextGeneration = generation + 1;
+	previous.clear();
+	removeStrayChunks();
+
+	running = true;
+	thread = std::thread( &SaveSystem::threadLoop, this );
+	return true;
+}
+
+void SaveSystem::close() {
+	if ( !running ) return;
+
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		running = false;
+	}
+	wake.notify_one();
+	thread.join(); // The writer finishes the queued job before it exits.
+	directory.clear();
+}
+
+bool SaveSystem::save() {
+	if ( !running ) return false;
+
+	const auto start = std::chrono::steady_clock::now();
+	std::unique_ptr<Job> job( new Job() );
+	job->buffers.reserve( sections.size() );
+	for ( const Section& section : sections ) job->buffers.push_back( *section.buffer ); // Copies page pointers only.
+
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		if ( queued ) stats.coalesced++;
+		queued = std::move( job );
+		stats.saves++;
+		stats.lastSnapshotUs = std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now() - start ).count();
+	}
+	wake.notify_one();
+	return true;
+}
+
+void SaveSystem::flush() {
+	std::unique_lock<std::mutex> lock( mutex );
+	idle.wait( lock, [ this ] { return !queued && !writing; } );
+}
+
+SaveStats SaveSystem::getStats() const {
+	std::lock_guard<std::mutex> lock( mutex );
+	return stats;
+}
+
+void SaveSystem::threadLoop() {
+	std::unique_lock<std::mutex> lock( mutex );
+	for ( ;; ) {
+		wake.wait( lock, [ this ] { return queued || !running; } );
+		if ( !queued ) break;
+
+		std::unique_ptr<Job> job = std::move( queued );
+		writing = true;
+		lock.unlock();
+
+		// The old snapshot is released on this thread, after the new one is written.
+		const bool ok = write( *job );
+		job.reset();
+
+		lock.lock();
+		writing = false;
+		if ( !ok ) stats.failures++;
+		if ( !queued ) idle.notify_all();
+	}
+	idle.notify_all();
+}
+
+std::string SaveSystem::chunkPath( uint32_t id, uint64_t generation ) const {
+	char name[ 48 ];
+	std::snprintf( name, sizeof( name ), "section_%08x_%016llx.chunk", id, static_cast< unsigned long long >( generation ) );
+	return ( std::filesystem::path( directory ) / name ).string();
+}
+
+bool SaveSystem::write( Job& job ) {
+	const auto start = std::chrono::steady_clock::now();
+	const uint64_t generation = nextGeneration++;
+	std::vector<Entry> next = entries;
+	std::vector<std::string> superseded;
+	uint64_t written = 0, skipped = 0, bytes = 0;
+
+	for ( size_t i = 0; i < sections.size(); i++ ) {
+		const Section& section = sections[ i ];
+		const PagedBuffer& buffer = job.buffers[ i ];
+
+		// A page written since the last commit was detached, so its pointer no longer matches.
+		size_t entryIndex = next.size();
+		for ( size_t e = 0; e < next.size(); e++ ) {
+			if ( next[ e ].id == section.id ) entryIndex = e;
+		}
+		bool changed = entryIndex == next.size() || previous.size() != sections.size() ||
+			next[ entryIndex ].version != section.version || previous[ i ].size() != buffer.size();
+		for ( size_t page = 0; !changed && page < buffer.getPageCount(); page++ ) {
+			changed = buffer.getPageData( page ) != previous[ i ].getPageData( page );
+		}
+		if ( !changed ) {
+			skipped++;
+			continue;
+		}
+
+		// Payload: the used part of every page, back to back.
+		const size_t elementSize = buffer.getElementSize(), perPage = buffer.getElementsPerPage();
+		std::vector<WritePiece> pieces( 1 );
+		uint32_t crc = 0;
+		size_t size = 0;
+		for ( size_t page = 0; page < buffer.getPageCount(); page++ ) {
+			const size_t count = std::min( perPage, buffer.size() - page * perPage );
+			pieces.push_back( { buffer.getPageData( page ), count * elementSize } );
+			crc = crc32( crc, buffer.getPageData( page ), count * elementSize );
+			size += count * elementSize;
+		}
+
+		Entry entry{ section.id, section.version, static_cast< uint16_t >( elementSize ), generation, size, crc };
+		uint8_t header[ CHUNK_HEADER_BYTES ] = {};
+		uint8_t* cursor = header;
+		put( cursor, CHUNK_MAGIC );
+		put( cursor, FORMAT_VERSION );
+		put( cursor, entry.id );
+		put( cursor, entry.version );
+		put( cursor, entry.elementSize );
+		put( cursor, entry.generation );
+		put( cursor, entry.size );
+		put( cursor, entry.crc );
+		pieces[ 0 ] = { header, sizeof( header ) };
+
+		if ( !writeDurable( chunkPath( section.id, generation ), pieces ) ) {
+			LOG_ERROR( "Failed to write save chunk {}", chunkPath( section.id, generation ) );
+			return false;
+		}
+		written++;
+		bytes += sizeof( header ) + size;
+
+		if ( entryIndex == next.size() ) next.push_back( entry );
+		else {
+			superseded.push_back( chunkPath( next[ entryIndex ].id, next[ entryIndex ].generation ) );
+			next[ entryIndex ] = entry;
+		}
+	}
+
+	// The manifest: header, entries, then a CRC of everything before it.
+	std::vector<uint8_t> manifest( MANIFEST_HEADER_BYTES + next.size() * ENTRY_BYTES + sizeof( uint32_t ) );
+	uint8_t* cursor = manifest.data();
+	put( cursor, MANIFEST_MAGIC );
+	put( cursor, FORMAT_VERSION );
+	put( cursor, generation );
+	put( cursor, static_cast< uint32_t >( next.size() ) );
+	for ( const Entry& entry : next ) {
+		put( cursor, entry.id );
+		put( cursor, entry.version );
+		put( cursor, entry.elementSize );
+		put( cursor, entry.generation );
+		put( cursor, entry.size );
+		put( cursor, entry.crc );
+	}
+	put( cursor, crc32( 0, manifest.data(), manifest.size() - sizeof( uint32_t ) ) );
+
+	const std::string temp = ( std::filesystem::path( directory ) / MANIFEST_TEMP_NAME ).string();
+	const std::string target = ( std::filesystem::path( directory ) / MANIFEST_NAME ).string();
+	if ( !writeDurable( temp, { { manifest.data(), manifest.size() } } ) || !replaceDurable( temp, target, directory ) ) {
+		LOG_ERROR( "Failed to commit save manifest in {}", directory );
+		return false;
+	}
+	bytes += manifest.size();
+
+	// Committed. Chunks the new manifest no longer refers to can go.
+	for ( const std::string& path : superseded ) {
+		std::error_code ignored;
+		std::filesystem::remove( path, ignored );
+	}
+	entries = std::move( next );
+	previous = job.buffers;
+	committed.store( generation, std::memory_order_release );
+
+	std::lock_guard<std::mutex> lock( mutex );
+	stats.commits++;
+	stats.sectionsWritten += written;
+	stats.sectionsSkipped += skipped;
+	stats.bytesWritten += bytes;
+	stats.lastWriteMs = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+	return true;
+}
+
+bool SaveSystem::readManifest( std::vector<Entry>& result, uint64_t& generation ) const {
+	MappedFile file;
+	if ( !file.open( ( std::filesystem::path( directory ) / MANIFEST_NAME ).string() ) ) return false;
+	if ( file.size() < MANIFEST_HEADER_BYTES + sizeof( uint32_t ) ) return false;
+
+	const uint8_t* cursor = file.data();
+	const uint32_t magic = get<uint32_t>( cursor ), format = get<uint32_t>( cursor );
+	generation = get<uint64_t>( cursor );
+	const uint32_t count = get<uint32_t>( cursor );
+	if ( magic != MANIFEST_MAGIC || format != FORMAT_VERSION || file.size() != MANIFEST_HEADER_BYTES + count * ENTRY_BYTES + sizeof( uint32_t ) ) {
+		LOG_ERROR( "Save manifest in {} has an unknown format.", directory );
+		return false;
+	}
+	const uint8_t* end = file.data() + file.size() - sizeof( uint32_t );
+	const uint8_t* crcCursor = end;
+	if ( get<uint32_t>( crcCursor ) != crc32( 0, file.data(), file.size() - sizeof( uint32_t ) ) ) {
+		LOG_ERROR( "Save manifest in {} is damaged.", directory );
+		return false;
+	}
+
+	result.clear();
+	for ( uint32_t i = 0; i < count; i++ ) {
+		Entry entry;
+		entry.id = get<uint32_t>( cursor );
+		entry.version = get<uint16_t>( cursor );
+		entry.elementSize = get<uint16_t>( cursor );
+		entry.generation = get<uint64_t>( cursor );
+		entry.size = get<uint64_t>( cursor );
+		entry.crc = get<uint32_t>( cursor );
+		result.push_back( entry );
+	}
+	return true;
+}
+
+void SaveSystem::removeStrayChunks() const {
+	std::error_code error;
+	for ( const auto& file : std::filesystem::directory_iterator( directory, error ) ) {
+		const std::string name = file.path().filename().string();
+		if ( name == MANIFEST_TEMP_NAME ) {
+			std::filesystem::remove( file.path(), error );
+			continue;
+		}
+		if ( file.path().extension() != ".chunk" ) continue;
+
+		bool referenced = false;
+		for ( const Entry& entry : entries ) {
+			if ( std::filesystem::path( chunkPath( entry.id, entry.generation ) ).filename() == file.path().filename() ) referenced = true;
+		}
+		if ( !referenced ) std::filesystem::remove( file.path(), error );
+	}
+}
+
+bool SaveSystem::load() {
+	if ( !running ) return false;
+	flush();
+
+	std::vector<Entry> manifest;
+	uint64_t generation = 0;
+	if ( !readManifest( manifest, generation ) ) return false;
+
+	// Map and verify every chunk of a registered section before touching any section.
+	std::vector<MappedFile> files( sections.size() );
+	std::vector<const Entry*> found( sections.size(), nullptr );
+	for ( size_t i = 0; i < sections.size(); i++ ) {
+		for ( const Entry& entry : manifest ) {
+			if ( entry.id == sections[ i ].id ) found[ i ] = &entry;
+		}
+		const Entry* entry = found[ i ];
+		if ( !entry ) continue;
+
+		const std::string path = chunkPath( entry->id, entry->generation );
+		MappedFile& file = files[ i ];
+		if ( !file.open( path ) || file.size() != CHUNK_HEADER_BYTES + entry->size ) {
+			LOG_ERROR( "Save chunk {} is missing or truncated.", path );
+			return false;
+		}
+		file.adviseSequential();
+		const uint8_t* cursor = file.data();
+		const uint32_t magic = get<uint32_t>( cursor ), format = get<uint32_t>( cursor ), id = get<uint32_t>( cursor );
+		const uint16_t version = get<uint16_t>( cursor ), elementSize = get<uint16_t>( cursor );
+		const uint64_t chunkGeneration = get<uint64_t>( cursor ), size = get<uint64_t>( cursor );
+		const uint32_t crc = get<uint32_t>( cursor );
+		if ( magic != CHUNK_MAGIC || format != FORMAT_VERSION || id != entry->id || version != entry->version || elementSize != entry->elementSize ||
+			chunkGeneration != entry->generation || size != entry->size || crc != entry->crc || crc32( 0, file.data() + CHUNK_HEADER_BYTES, size ) != crc ) {
+			LOG_ERROR( "Save chunk {} does not match the manifest.", path );
+			return false;
+		}
+		if ( version != sections[ i ].version && !sections[ i ].migration ) {
+			LOG_ERROR( "Save section {} has version {} and no migration to {}.", path, version, sections[ i ].version );
+			return false;
+		}
+		if ( version == sections[ i ].version && elementSize != sections[ i ].buffer->getElementSize() ) {
+			LOG_ERROR( "Save section {} has a different element size than its registration.", path );
+			return false;
+		}
+	}
+
+	// Everything is valid: copy it in.
+	for ( size_t i = 0; i < sections.size(); i++ ) {
+		if ( !found[ i ] ) continue;
+		const uint8_t* payload = files[ i ].data() + CHUNK_HEADER_BYTES;
+		PagedBuffer& buffer = *sections[ i ].buffer;
+		if ( found[ i ]->version != sections[ i ].version ) {
+			if ( !sections[ i ].migration( found[ i ]->version, payload, found[ i ]->size, buffer ) ) {
+				LOG_ERROR( "Failed to migrate save section {} from version {}.", sections[ i ].id, found[ i ]->version );
+				return false;
+			}
+			continue;
+		}
+
+		const size_t elementSize = buffer.getElementSize(), perPage = buffer.getElementsPerPage();
+		buffer.resize( found[ i ]->size / elementSize );
+		for ( size_t first = 0; first < buffer.size(); first += perPage ) {
+			const size_t count = std::min( perPage, buffer.size() - first );
+			std::memcpy( buffer.write( first ), payload + first * elementSize, count * elementSize );
+		}
+	}
+
+	// The loaded state is what is on disk, so the next save only writes what changes after this.
+	std::lock_guard<std::mutex> lock( mutex );
+	entries = manifest;
+	previous.clear();
+	for ( const Section& section : sections ) previous.push_back( *section.buffer );
+	committed.store( generation, std::memory_order_release );
+	nextGeneration = std::max( nextGeneration, generation + 1 );
+	return true;
+}
@@ -0,0 +1,142 @@
+#include <cassert> // Required for assert on the element size.
+#include <cstring> // Required for std::memcpy and std::memset.
+
+#include "Snapshot.h" // Includes the snapshot class definitions.
+
+PagedBuffer::PagedBuffer( size_t elementSize ) :
+	elementSize( elementSize ), perPage( 0 ), count( 0 ) {
+	// An element must fit in a page; zero elements per page would divide by zero in every index calculation.
+	assert( elementSize > 0 && elementSize <= PAGE_BYTES );
+	perPage = PAGE_BYTES / elementSize;
+}
+
+void PagedBuffer::resize( size_t newCount ) {
+	const size_t neededPages = ( newCount + perPage - 1 ) / perPage;
+	while ( pages.size() < neededPages ) pages.push_back( std::make_shared<Page>() ); // Value-initialized, so zeroed.
+	pages.resize( neededPages );
+
+	// Zero the tail of a partially used last page so growing again exposes zeroed elements.
+	if ( newCount < count && newCount % perPage ) {
+		std::shared_ptr<Page>& last = pages.back();
+		if ( last.use_count() > 1 ) detach( last );
+		else std::atomic_thread_fence( std::memory_order_acquire ); // See write().
+
+		size_t first = newCount % perPage;
+		std::memset( last->bytes + first * elementSize, 0, ( perPage - first ) * elementSize );
+	}
+	count = newCount;
+}
+
+size_t PagedBuffer::getSharedPageCount() const {
+	size_t shared = 0;
+	for ( const auto& page : pages ) {
+		if ( page.use_count() > 1 ) shared++;
+	}
+	return shared;
+}
+
+void PagedBuffer::detach( std::shared_ptr<Page>& page ) {
+	auto copy = std::make_shared<Page>();
+	std::memcpy( copy->bytes, page->bytes, PAGE_BYTES );
+	page = std::move( copy );
+}
+
+void PhysicsSnapshot::capture( const PhysicsWorld& world ) {
+	const std::vector<b2Body*>& source = world.getBodies();
+	structureVersion = world.getStructureVersion();
+	bodies.resize( source.size() );
+
+	for ( size_t i = 0; i < source.size(); i++ ) {
+		const b2Body* body = source[ i ];
+		BodyState& state = bodies[ i ];
+		state.position = body->GetPosition();
+		state.angle = body->GetAngle();
+		state.linearVelocity = body->GetLinearVelocity();
+		state.angularVelocity = body->GetAngularVelocity();
+		state.awake = body->IsAwake();
+		state.enabled = body->IsEnabled();
+		state.padding[ 0 ] = state.padding[ 1 ] = 0;
+	}
+}
+
+bool PhysicsSnapshot::restore( PhysicsWorld& world ) const {
+	const std::vector<b2Body*>& target = world.getBodies();
+	if ( target.size() != bodies.size() ) return false;
+
+	for ( size_t i = 0; i < target.size(); i++ ) {
+		b2Body* body = target[ i ];
+		const BodyState& state = bodies[ i ];
+		if ( body->GetType() == b2_staticBody ) continue; // Static bodies never move.
+
+		body->SetEnabled( state.enabled != 0 );
+		body->SetTransform( state.position, state.angle );
+		body->SetLinearVelocity( state.linearVelocity );
+		body->SetAngularVelocity( state.angularVelocity );
+		body->SetAwake( state.awake != 0 );
+	}
+	return true;
+}
+
+void SnapshotRegistry::registerBuffer( PagedBuffer* buffer ) {
+	buffers.push_back( buffer );
+}
+
+void SnapshotRegistry::registerRandom( Random* random ) {
+	randoms.push_back( random );
+}
+
+void SnapshotRegistry::capture( const PhysicsWorld& world, WorldSnapshot& snapshot ) const {
+	snapshot.physics.capture( world );
+
+	snapshot.randoms.resize( randoms.size() );
+	for ( size_t i = 0; i < randoms.size(); i++ ) snapshot.randoms[ i ] = randoms[ i ]->getState();
+
+	// Copying a PagedBuffer shares its pages; nothing is duplicated until someone writes.
+	snapshot.buffers.resize( buffers.size() );
+	for ( size_t i = 0; i < buffers.size(); i++ ) snapshot.buffers[ i ] = *buffers[ i ];
+}
+
+bool SnapshotRegistry::restore( const WorldSnapshot& snapshot, PhysicsWorld& world ) const {
+	if ( snapshot.randoms.size() != randoms.size() || snapshot.buffers.size() != buffers.size() ) return false;
+	if ( snapshot.physics.structureVersion != world.getStructureVersion() ) return false;
+	if ( !snapshot.physics.restore( world ) ) return false;
+
+	for ( size_t i = 0; i < randoms.size(); i++ ) randoms[ i ]->setState( snapshot.randoms[ i ] );
+	for ( size_t i = 0; i < buffers.size(); i++ ) *buffers[ i ] = snapshot.buffers[ i ];
+	return true;
+}
+
+Lookahead::~Lookahead() {
+	wait();
+}
+
+void Lookahead::start( const PhysicsWorld& source, const WorldSnapshot& snapshot, int steps, StepFunction onStep ) {
+	wait();
+
+	if ( mirroredVersion != source.getStructureVersion() ) {
+		source.mirrorInto( shadow );
+		mirroredVersion = source.getStructureVersion();
+	}
+
+	origin = snapshot.physics;
+	buffers = snapshot.buffers;
+	randoms.clear();
+	for ( const RandomState& state : snapshot.randoms ) {
+		randoms.emplace_back();
+		randoms.back().setState( state );
+	}
+
+	JobSystem::getInstance().submit( [ this, steps, onStep ]() {
+		origin.restore( shadow );
+
+		LookaheadState state{ shadow, buffers, randoms };
+		for ( int step = 0; step < steps; step++ ) {
+			if ( onStep ) onStep( state, step );
+			shadow.stepFixed();
+		}
+	}, &counter );
+}
+
+void Lookahead::wait() {
+	JobSystem::getInstance().wait( counter );
+}
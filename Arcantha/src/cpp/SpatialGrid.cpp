@@ -0,0 +1,244 @@
+#include <algorithm> // Required for std::min, std::max and the heap functions.
+#include <chrono> // Required for timing rebuilds and batches.
+#include <cmath> // Required for std::floor and std::ceil.
+#include <utility> // Required for std::pair.
+
+#include "SpatialGrid.h" // Includes the SpatialGrid class definition.
+#include "JobSystem.h" // Includes the JobSystem the rebuild and batches run on.
+#include "Log.h" // Includes the Logger for error output.
+
+const size_t SpatialGrid::REBUILD_GRAIN;
+const size_t SpatialGrid::QUERY_GRAIN;
+
+static const size_t CELL_GRAIN = 4096; // Cells per job when turning counts into offsets.
+static const float INFINITE_DISTANCE = 1e30f; // Covered distance of a side that reaches the grid's border.
+
+SpatialGrid::SpatialGrid( const glm::vec2& origin, const glm::vec2& size, float cellSize ) : origin( origin ), cellSize( cellSize ) {
+	if ( !( cellSize > 0.0f ) ) {
+		LOG_WARN( "SpatialGrid cell size must be positive, using 1." );
+		this->cellSize = 1.0f;
+	}
+	inverseCellSize = 1.0f / this->cellSize;
+	cellsWide = std::max( 1, static_cast< int >( std::ceil( size.x * inverseCellSize ) ) );
+	cellsHigh = std::max( 1, static_cast< int >( std::ceil( size.y * inverseCellSize ) ) );
+	cellStart.assign( static_cast< size_t >( cellsWide ) * cellsHigh + 1, 0 );
+	stats.cells = static_cast< uint32_t >( cellsWide * cellsHigh );
+}
+
+glm::ivec2 SpatialGrid::cellOf( const glm::vec2& position ) const {
+	// Clamp as floats first so far away and NaN positions land in a border cell.
+	const glm::vec2 cell = glm::floor( ( position - origin ) * inverseCellSize );
+	const float x = std::min( std::max( 0.0f, cell.x ), static_cast< float >( cellsWide - 1 ) );
+	const float y = std::min( std::max( 0.0f, cell.y ), static_cast< float >( cellsHigh - 1 ) );
+	return glm::ivec2( static_cast< int >( x ), static_cast< int >( y ) );
+}
+
+void SpatialGrid::rebuild( const glm::vec2* positions, const uint32_t* categories, size_t count ) {
+	auto begin = std::chrono::steady_clock::now();
+	JobSystem& jobs = JobSystem::getInstance();
+	const size_t cells = static_cast< size_t >( cellsWide ) * cellsHigh;
+	// One chunk per thread at most: every chunk costs a pass over all cells.
+	const size_t threads = static_cast< size_t >( jobs.getWorkerCount() ) + 1;
+	const size_t grain = std::max( REBUILD_GRAIN, ( count + threads - 1 ) / threads );
+	const size_t chunks = ( count + grain - 1 ) / grain;
+
+	entityCells.resize( count );
+	sortedX.resize( count );
+	sortedY.resize( count );
+	sortedCategories.resize( count );
+	sortedIds.resize( count );
+	chunkCounts.assign( chunks * cells, 0 );
+
+	// Every chunk counts its entities per cell.
+	jobs.parallelFor( count, grain, [ this, positions, cells, grain ]( size_t first, size_t last ) {
+		uint32_t* counts = &chunkCounts[ first / grain * cells ];
+		for ( size_t i = first; i < last; i++ ) {
+			const glm::ivec2 cell = cellOf( positions[ i ] );
+			const uint32_t index = static_cast< uint32_t >( cell.y * cellsWide + cell.x );
+			entityCells[ i ] = index;
+			counts[ index ]++;
+		}
+	} );
+
+	// Cell sizes, then their prefix sum gives where each cell starts. Chunks are the outer loop so each pass reads rows of counts.
+	jobs.parallelFor( cells, CELL_GRAIN, [ this, cells, chunks ]( size_t first, size_t last ) {
+		std::fill( cellStart.begin() + first, cellStart.begin() + last, 0u );
+		for ( size_t chunk = 0; chunk < chunks; chunk++ ) {
+			const uint32_t* counts = &chunkCounts[ chunk * cells ];
+			for ( size_t cell = first; cell < last; cell++ ) cellStart[ cell ] += counts[ cell ];
+		}
+	} );
+	uint32_t running = 0, occupied = 0;
+	for ( size_t cell = 0; cell < cells; cell++ ) {
+		const uint32_t size = cellStart[ cell ];
+		cellStart[ cell ] = running;
+		running += size;
+		if ( size > 0 ) occupied++;
+	}
+	cellStart[ cells ] = running;
+
+	// Within a cell, earlier chunks write first, which keeps every cell in entity order.
+	cellCursor.resize( cells );
+	jobs.parallelFor( cells, CELL_GRAIN, [ this, cells, chunks ]( size_t first, size_t last ) {
+		std::copy( cellStart.begin() + first, cellStart.begin() + last, cellCursor.begin() + first );
+		for ( size_t chunk = 0; chunk < chunks; chunk++ ) {
+			uint32_t* counts = &chunkCounts[ chunk * cells ];
+			for ( size_t cell = first; cell < last; cell++ ) {
+				const uint32_t size = counts[ cell ];
+				counts[ cell ] = cellCursor[ cell ];
+				cellCursor[ cell ] += size;
+			}
+		}
+	} );
+
+	jobs.parallelFor( count, grain, [ this, positions, categories, cells, grain ]( size_t first, size_t last ) {
+		uint32_t* offsets = &chunkCounts[ first / grain * cells ];
+		for ( size_t i = first; i < last; i++ ) {
+			const uint32_t slot = offsets[ entityCells[ i ] ]++;
+			sortedX[ slot ] = positions[ i ].x;
+			sortedY[ slot ] = positions[ i ].y;
+			sortedCategories[ slot ] = categories ? categories[ i ] : 0xFFFFFFFFu;
+			sortedIds[ slot ] = static_cast< uint32_t >( i );
+		}
+	} );
+
+	stats.entities = static_cast< uint32_t >( count );
+	stats.occupiedCells = occupied;
+	stats.rebuildMs = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - begin ).count();
+}
+
+template <typename Run>
+void SpatialGrid::runBatch( size_t count, const Run& run ) {
+	auto begin = std::chrono::steady_clock::now();
+	const size_t chunks = ( count + QUERY_GRAIN - 1 ) / QUERY_GRAIN;
+	if ( chunkIds.size() < chunks ) chunkIds.resize( chunks );
+	chunkTested.assign( chunks, 0 );
+	results.assign( count, SpatialResult() );
+
+	// Queries append to per-chunk lists, which are then concatenated in chunk order.
+	JobSystem::getInstance().parallelFor( count, QUERY_GRAIN, [ this, &run ]( size_t first, size_t last ) {
+		const size_t chunk = first / QUERY_GRAIN;
+		std::vector<uint32_t>& out = chunkIds[ chunk ];
+		out.clear();
+		uint64_t tested = 0;
+		for ( size_t i = first; i < last; i++ ) {
+			results[ i ].first = static_cast< uint32_t >( out.size() );
+			tested += run( i, out );
+			results[ i ].count = static_cast< uint32_t >( out.size() ) - results[ i ].first;
+		}
+		chunkTested[ chunk ] = tested;
+	} );
+
+	ids.clear();
+	stats.tested = 0;
+	for ( size_t chunk = 0; chunk < chunks; chunk++ ) {
+		const uint32_t base = static_cast< uint32_t >( ids.size() );
+		const size_t last = std::min( ( chunk + 1 ) * QUERY_GRAIN, count );
+		for ( size_t i = chunk * QUERY_GRAIN; i < last; i++ ) results[ i ].first += base;
+		ids.insert( ids.end(), chunkIds[ chunk ].begin(), chunkIds[ chunk ].end() );
+		stats.tested += chunkTested[ chunk ];
+	}
+
+	stats.queries = count;
+	stats.found = ids.size();
+	stats.queryMs = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - begin ).count();
+}
+
+void SpatialGrid::queryRadius( const RadiusQuery* queries, size_t count ) {
+	runBatch( count, [ this, queries ]( size_t i, std::vector<uint32_t>& out ) {
+		const RadiusQuery& query = queries[ i ];
+		const glm::vec2 extent( query.radius );
+		return collect( query.center - extent, query.center + extent, true, query.center, query.radius, query.mask, out );
+	} );
+}
+
+void SpatialGrid::queryBox( const BoxQuery* queries, size_t count ) {
+	runBatch( count, [ this, queries ]( size_t i, std::vector<uint32_t>& out ) {
+		const BoxQuery& query = queries[ i ];
+		return collect( query.min, query.max, false, glm::vec2( 0.0f ), 0.0f, query.mask, out );
+	} );
+}
+
+void SpatialGrid::queryNearest( const NearestQuery* queries, size_t count ) {
+	runBatch( count, [ this, queries ]( size_t i, std::vector<uint32_t>& out ) {
+		return nearest( queries[ i ], out );
+	} );
+}
+
+uint64_t SpatialGrid::collect( const glm::vec2& min, const glm::vec2& max, bool circle, const glm::vec2& center, float radius, uint32_t mask,
+	std::vector<uint32_t>& out ) const {
+	if ( !( min.x <= max.x && min.y <= max.y ) || ( circle && !( radius >= 0.0f ) ) ) return 0;
+	const glm::ivec2 low = cellOf( min ), high = cellOf( max );
+	const float radiusSquared = radius * radius;
+	uint64_t tested = 0;
+	for ( int y = low.y; y <= high.y; y++ ) {
+		// The cells of a row are adjacent in the sorted order, so each row is one run.
+		const uint32_t first = cellStart[ y * cellsWide + low.x ], last = cellStart[ y * cellsWide + high.x + 1 ];
+		tested += last - first;
+		for ( uint32_t j = first; j < last; j++ ) {
+			const float x = sortedX[ j ], z = sortedY[ j ];
+			if ( x < min.x || x > max.x || z < min.y || z > max.y || !( sortedCategories[ j ] & mask ) ) continue;
+			if ( circle ) {
+				const float dx = x - center.x, dy = z - center.y;
+				if ( dx * dx + dy * dy > radiusSquared ) continue;
+			}
+			out.push_back( sortedIds[ j ] );
+		}
+	}
+	return tested;
+}
+
+uint64_t SpatialGrid::nearest( const NearestQuery& query, std::vector<uint32_t>& out ) const {
+	if ( query.k == 0 || stats.entities == 0 || !( query.maxRadius >= 0.0f ) ) return 0;
+	thread_local std::vector<std::pair<float, uint32_t>> best; // Max-heap on distance, then ID.
+	best.clear();
+	const float maxSquared = query.maxRadius * query.maxRadius;
+	const glm::ivec2 center = cellOf( query.center );
+	uint64_t tested = 0;
+
+	const auto scan = [ & ]( int y, int x0, int x1 ) {
+		const uint32_t first = cellStart[ y * cellsWide + x0 ], last = cellStart[ y * cellsWide + x1 + 1 ];
+		tested += last - first;
+		for ( uint32_t j = first; j < last; j++ ) {
+			if ( !( sortedCategories[ j ] & query.mask ) ) continue;
+			const float dx = sortedX[ j ] - query.center.x, dy = sortedY[ j ] - query.center.y;
+			const std::pair<float, uint32_t> candidate( dx * dx + dy * dy, sortedIds[ j ] );
+			if ( candidate.first > maxSquared ) continue;
+			if ( best.size() < query.k ) {
+				best.push_back( candidate );
+				std::push_heap( best.begin(), best.end() );
+			}
+			else if ( candidate < best.front() ) {
+				std::pop_heap( best.begin(), best.end() );
+				best.back() = candidate;
+				std::push_heap( best.begin(), best.end() );
+			}
+		}
+	};
+
+	// Search square rings of cells outwards until nothing outside them can beat the k-th best.
+	const int rings = std::max( cellsWide, cellsHigh );
+	for ( int ring = 0; ring <= rings; ring++ ) {
+		const int x0 = std::max( 0, center.x - ring ), x1 = std::min( cellsWide - 1, center.x + ring );
+		for ( int y = std::max( 0, center.y - ring ); y <= std::min( cellsHigh - 1, center.y + ring ); y++ ) {
+			if ( ring == 0 || y == center.y - ring || y == center.y + ring ) scan( y, x0, x1 );
+			else {
+				if ( center.x - ring >= 0 ) scan( y, x0, x0 );
+				if ( center.x + ring < cellsWide ) scan( y, x1, x1 );
+			}
+		}
+
+		// Entities in cells not yet searched are at least this far; sides at the border hide nothing.
+		const float left = center.x - ring <= 0 ? INFINITE_DISTANCE : query.center.x - ( origin.x + ( center.x - ring ) * cellSize );
+		const float right = center.x + ring >= cellsWide - 1 ? INFINITE_DISTANCE : origin.x + ( center.x + ring + 1 ) * cellSize - query.center.x;
+		const float bottom = center.y - ring <= 0 ? INFINITE_DISTANCE : query.center.y - ( origin.y + ( center.y - ring ) * cellSize );
+		const float top = center.y + ring >= cellsHigh - 1 ? INFINITE_DISTANCE : origin.y + ( center.y + ring + 1 ) * cellSize - query.center.y;
+		const float covered = std::min( std::min( left, right ), std::min( bottom, top ) );
+		if ( covered >= INFINITE_DISTANCE || covered > query.maxRadius ) break;
+		if ( best.size() == query.k && best.front().first < covered * covered ) break;
+	}
+
+	std::sort_heap( best.begin(), best.end() );
+	for ( const std::pair<float, uint32_t>& entry : best ) out.push_back( entry.second );
+	return tested;
+}
@@ -0,0 +1,211 @@
+#include <algorithm> // Required for std::min_element and std::max_element.
+#include <unordered_map> // Required to look tasks up by name.
+
+#include "StartupGraph.h" // Includes the StartupGraph class definition.
+#include "JobSystem.h" // Includes the JobSystem that runs worker tasks.
+#include "Log.h" // Includes the Logger for the trace and for graph errors.
+
+const double StartupGraph::FIRST_FRAME_BUDGET_MS = 1000.0;
+
+static const char* STATUS_NAMES[] = { "pending", "ok", "failed", "skipped" };
+
+StartupGraph::StartupGraph() : origin( std::chrono::steady_clock::now() ) {}
+
+double StartupGraph::now() const {
+	return std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - origin ).count();
+}
+
+bool StartupGraph::add( const std::string& name, StartupThread thread, std::function<bool()> func,
+	const std::vector<std::string>& dependencies ) {
+	if ( started ) {
+		LOG_ERROR( "Startup task {} added after the graph ran.", name );
+		return false;
+	}
+	for ( const StartupTaskTrace& other : trace ) {
+		if ( other.name == name ) {
+			LOG_ERROR( "Startup task {} is declared twice.", name );
+			return false;
+		}
+	}
+
+	Task task;
+	task.func = std::move( func );
+	task.dependencyNames = dependencies;
+	tasks.push_back( std::move( task ) );
+	StartupTaskTrace entry;
+	entry.name = name;
+	entry.thread = thread;
+	trace.push_back( entry );
+	return true;
+}
+
+bool StartupGraph::resolve() {
+	std::unordered_map<std::string, size_t> indices;
+	for ( size_t i = 0; i < trace.size(); i++ ) indices[ trace[ i ].name ] = i;
+
+	for ( size_t i = 0; i < tasks.size(); i++ ) {
+		for ( const std::string& dependency : tasks[ i ].dependencyNames ) {
+			const auto found = indices.find( dependency );
+			if ( found == indices.end() ) {
+				LOG_ERROR( "Startup task {} depends on unknown task {}.", trace[ i ].name, dependency );
+				return false;
+			}
+			tasks[ found->second ].dependents.push_back( i );
+			tasks[ i ].remaining++;
+		}
+	}
+
+	// Every task is reachable in dependency order unless some of them form a cycle.
+	std::vector<size_t> remaining( tasks.size() ), order;
+	for ( size_t i = 0; i < tasks.size(); i++ ) {
+		remaining[ i ] = tasks[ i ].remaining;
+		if ( remaining[ i ] == 0 ) order.push_back( i );
+	}
+	for ( size_t next = 0; next < order.size(); next++ ) {
+		for ( size_t dependent : tasks[ order[ next ] ].dependents ) {
+			if ( --remaining[ dependent ] == 0 ) order.push_back( dependent );
+		}
+	}
+	if ( order.size() != tasks.size() ) {
+		for ( size_t i = 0; i < tasks.size(); i++ ) {
+			if ( remaining[ i ] > 0 ) LOG_ERROR( "Startup task {} is part of a dependency cycle.", trace[ i ].name );
+		}
+		return false;
+	}
+	return true;
+}
+
+bool StartupGraph::run() {
+	if ( started ) return false;
+	started = true;
+	if ( !resolve() ) return false;
+
+	std::vector<size_t> readyWorkers;
+	std::unique_lock<std::mutex> lock( mutex );
+	unfinished = tasks.size();
+	const double start = now();
+	for ( size_t i = 0; i < tasks.size(); i++ ) {
+		if ( tasks[ i ].remaining > 0 ) continue;
+		trace[ i ].readyMs = start;
+		if ( trace[ i ].thread == StartupThread::Main ) readyMain.push_back( i );
+		else readyWorkers.push_back( i );
+	}
+	lock.unlock();
+	// Workers first, so they are busy while this thread runs the main tasks.
+	for ( size_t task : readyWorkers ) submit( task );
+	lock.lock();
+
+	while ( unfinished > 0 ) {
+		if ( readyMain.empty() ) {
+			finished.wait( lock );
+			continue;
+		}
+		// Run main tasks in declaration order, so the window comes before what draws into it.
+		const auto first = std::min_element( readyMain.begin(), readyMain.end() );
+		const size_t task = *first;
+		readyMain.erase( first );
+		lock.unlock();
+		execute( task );
+		lock.lock();
+	}
+	runMs = now();
+
+	for ( const StartupTaskTrace& entry : trace ) {
+		if ( entry.status != StartupStatus::Succeeded ) return false;
+	}
+	return true;
+}
+
+void StartupGraph::execute( size_t task ) {
+	StartupTaskTrace& entry = trace[ task ];
+	entry.threadIndex = JobSystem::getThreadIndex();
+	entry.beginMs = now();
+	const bool ok = !tasks[ task ].func || tasks[ task ].func();
+	entry.endMs = now();
+	if ( !ok ) LOG_WARN( "Startup task {} failed.", entry.name );
+
+	std::vector<size_t> readyWorkers;
+	{
+		// Notified under the lock: once run() sees the last task finish, the graph may be destroyed.
+		std::lock_guard<std::mutex> lock( mutex );
+		complete( task, ok ? StartupStatus::Succeeded : StartupStatus::Failed, readyWorkers );
+		finished.notify_one();
+	}
+	for ( size_t worker : readyWorkers ) submit( worker );
+}
+
+void StartupGraph::submit( size_t task ) {
+	JobSystem::getInstance().submit( [ this, task ]() { execute( task ); } );
+}
+
+void StartupGraph::complete( size_t task, StartupStatus status, std::vector<size_t>& readyWorkers ) {
+	trace[ task ].status = status;
+	unfinished--;
+
+	const double time = now();
+	for ( size_t dependent : tasks[ task ].dependents ) {
+		Task& next = tasks[ dependent ];
+		next.blocked = next.blocked || status != StartupStatus::Succeeded;
+		if ( --next.remaining > 0 ) continue;
+
+		StartupTaskTrace& entry = trace[ dependent ];
+		entry.readyMs = time;
+		entry.waitedOn = trace[ task ].name;
+		if ( next.blocked ) {
+			entry.beginMs = entry.endMs = time;
+			LOG_WARN( "Startup task {} skipped because {} did not succeed.", entry.name, trace[ task ].name );
+			complete( dependent, StartupStatus::Skipped, readyWorkers );
+		}
+		else if ( entry.thread == StartupThread::Main ) readyMain.push_back( dependent );
+		else readyWorkers.push_back( dependent );
+	}
+}
+
+bool StartupGraph::markFirstFrame() {
+	if ( firstFrameMs > 0.0 ) return false;
+	firstFrameMs = now();
+	return true;
+}
+
+bool StartupGraph::succeeded( const std::string& name ) const {
+	std::lock_guard<std::mutex> lock( mutex );
+	for ( const StartupTaskTrace& entry : trace ) {
+		if ( entry.name == name ) return entry.status == StartupStatus::Succeeded;
+	}
+	return false;
+}
+
+std::vector<std::string> StartupGraph::getCriticalPath() const {
+	std::vector<std::string> path;
+	if ( trace.empty() ) return path;
+
+	// Walk back from the last task to finish through the dependency each one waited on.
+	const StartupTaskTrace* entry = &*std::max_element( trace.begin(), trace.end(),
+		[]( const StartupTaskTrace& a, const StartupTaskTrace& b ) { return a.endMs < b.endMs; } );
+	while ( entry ) {
+		path.insert( path.begin(), entry->name );
+		const std::string& waitedOn = entry->waitedOn;
+		entry = nullptr;
+		for ( const StartupTaskTrace& other : trace ) {
+			if ( !waitedOn.empty() && other.name == waitedOn ) entry = &other;
+		}
+	}
+	return path;
+}
+
+void StartupGraph::logTrace() const {
+	for ( const StartupTaskTrace& entry : trace ) {
+		LOG_INFO( "Startup {} {} on thread {}: ready {} ms, ran {} to {} ms ({} ms).", entry.name,
+			STATUS_NAMES[ static_cast< int >( entry.status ) ], entry.threadIndex, entry.readyMs, entry.beginMs,
+			entry.endMs, entry.endMs - entry.beginMs );
+	}
+
+	std::string path;
+	for ( const std::string& name : getCriticalPath() ) path += ( path.empty() ? "" : " > " ) + name;
+	LOG_INFO( "Startup finished at {} ms, critical path {}.", runMs, path );
+	if ( firstFrameMs <= 0.0 ) return;
+	if ( firstFrameMs > FIRST_FRAME_BUDGET_MS ) {
+		LOG_WARN( "First frame at {} ms, over the {} ms budget.", firstFrameMs, FIRST_FRAME_BUDGET_MS );
+	}
+	else LOG_INFO( "First frame at {} ms.", firstFrameMs );
+}
@@ -0,0 +1,280 @@
+#include <algorithm> // Required for std::min and std::max.
+#include <cmath> // Required for std::ceil.
+#include <cstdio> // Required for writing captures with std::fprintf.
+#include <filesystem> // Required to create the capture directory.
+
+#include "Telemetry.h" // Includes the Telemetry class definition.
+#include "Log.h" // Includes the Logger for capture notices and failures.
+
+Telemetry Telemetry::instance;
+std::atomic<uint64_t> Telemetry::allocationCount{ 0 };
+std::atomic<uint64_t> Telemetry::allocationBytes{ 0 };
+
+const int FrameHistogram::SUB_BITS;
+const uint64_t FrameHistogram::SUB_COUNT;
+const int FrameHistogram::MAX_SHIFT;
+const int TelemetryFrame::MAX_SUBSYSTEMS;
+const int TelemetryFrame::MAX_COUNTERS;
+
+static const char* PHASE_NAMES[] = { "frame_ms", "simulation_ms", "render_ms" };
+
+FrameHistogram::FrameHistogram() : buckets( ( MAX_SHIFT + 2 ) * SUB_COUNT, 0 ) {
+	reset();
+}
+
+void FrameHistogram::reset() {
+	std::fill( buckets.begin(), buckets.end(), 0 );
+	count = 0;
+	minUs = UINT64_MAX;
+	maxUs = 0;
+	sumUs = 0.0;
+}
+
+size_t FrameHistogram::bucketOf( uint64_t us ) {
+	if ( us < SUB_COUNT ) return static_cast< size_t >( us );
+	// Below SUB_COUNT every microsecond has a bucket; above, each power of two is split into SUB_COUNT buckets.
+	int top = 63;
+	while ( !( us >> top ) ) top--;
+	const int shift = std::min( top - SUB_BITS, MAX_SHIFT );
+	const uint64_t sub = std::min( us >> shift, 2 * SUB_COUNT - 1 ) - SUB_COUNT;
+	return static_cast< size_t >( ( shift + 1 ) * SUB_COUNT + sub );
+}
+
+double FrameHistogram::valueOf( size_t bucket ) {
+	if ( bucket < SUB_COUNT ) return static_cast< double >( bucket );
+	const int shift = static_cast< int >( bucket / SUB_COUNT ) - 1;
+	const uint64_t sub = bucket % SUB_COUNT + SUB_COUNT;
+	return static_cast< double >( sub << shift ) + static_cast< double >( ( 1ull << shift ) - 1 ) * 0.5;
+}
+
+void FrameHistogram::record( double ms ) {
+	const uint64_t us = ms > 0.0 ? static_cast< uint64_t >( ms * 1000.0 + 0.5 ) : 0;
+	buckets[ bucketOf( us ) ]++;
+	count++;
+	minUs = std::min( minUs, us );
+	maxUs = std::max( maxUs, us );
+	sumUs += static_cast< double >( us );
+}
+
+double FrameHistogram::percentile( double q ) const {
+	if ( count == 0 ) return 0.0;
+	// Nearest rank, as in the benchmarks: the smallest bucket with at least q of the durations at or below it.
+	const uint64_t rank = std::max< uint64_t >( 1, static_cast< uint64_t >( std::ceil( q * count ) ) );
+	uint64_t seen = 0;
+	for ( size_t bucket = 0; bucket < buckets.size(); bucket++ ) {
+		seen += buckets[ bucket ];
+		if ( seen >= rank ) {
+			const double us = std::min( std::max( valueOf( bucket ), static_cast< double >( minUs ) ), static_cast< double >( maxUs ) );
+			return us * 1e-3;
+		}
+	}
+	return maxUs * 1e-3;
+}
+
+Telemetry& Telemetry::getInstance() {
+	return instance;
+}
+
+Telemetry::~Telemetry() {
+	shutdown();
+}
+
+void Telemetry::init( const TelemetrySettings& settings ) {
+	shutdown();
+	this->settings = settings;
+	ring.assign( std::max< uint32_t >( settings.ringFrames, 1 ), TelemetryFrame() );
+	for ( FrameHistogram& histogram : histograms ) histogram.reset();
+	current = TelemetryFrame();
+	frames = 0;
+	pending = false;
+	lastCaptureSeconds = -1e30;
+	start = frameBegin = std::chrono::steady_clock::now();
+	lastAllocations = allocationCount.load( std::memory_order_relaxed );
+	lastAllocatedBytes = allocationBytes.load( std::memory_order_relaxed );
+
+	std::lock_guard<std::mutex> lock( mutex );
+	stats = TelemetryStats();
+	running = true;
+	thread = std::thread( &Telemetry::threadLoop, this );
+}
+
+void Telemetry::shutdown() {
+	if ( !thread.joinable() ) return;
+	if ( pending ) queueCapture();
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		running = false;
+	}
+	wake.notify_one();
+	thread.join(); // The writer finishes the queued capture before it exits.
+}
+
+uint32_t Telemetry::registerSubsystem( const std::string& name, TelemetryPhase phase ) {
+	for ( size_t i = 0; i < subsystems.size(); i++ ) {
+		if ( subsystems[ i ].name == name ) return static_cast< uint32_t >( i );
+	}
+	if ( subsystems.size() >= TelemetryFrame::MAX_SUBSYSTEMS ) {
+		LOG_ERROR( "Telemetry has no slot left for subsystem {}.", name );
+		return TelemetryFrame::MAX_SUBSYSTEMS;
+	}
+	subsystems.push_back( { name, phase } );
+	return static_cast< uint32_t >( subsystems.size() - 1 );
+}
+
+uint32_t Telemetry::registerCounter( const std::string& name ) {
+	for ( size_t i = 0; i < counterNames.size(); i++ ) {
+		if ( counterNames[ i ] == name ) return static_cast< uint32_t >( i );
+	}
+	if ( counterNames.size() >= TelemetryFrame::MAX_COUNTERS ) {
+		LOG_ERROR( "Telemetry has no slot left for counter {}.", name );
+		return TelemetryFrame::MAX_COUNTERS;
+	}
+	counterNames.push_back( name );
+	return static_cast< uint32_t >( counterNames.size() - 1 );
+}
+
+void Telemetry::beginFrame() {
+	std::fill( std::begin( current.subsystemMs ), std::end( current.subsystemMs ), 0.0f );
+	frameBegin = std::chrono::steady_clock::now();
+	lastAllocations = allocationCount.load( std::memory_order_relaxed );
+	lastAllocatedBytes = allocationBytes.load( std::memory_order_relaxed );
+}
+
+void Telemetry::endFrame() {
+	const auto now = std::chrono::steady_clock::now();
+	if ( ring.empty() ) return;
+	const uint64_t allocations = allocationCount.load( std::memory_order_relaxed );
+	const uint64_t allocatedBytes = allocationBytes.load( std::memory_order_relaxed );
+
+	TelemetryFrame& frame = ring[ frames % ring.size() ];
+	frame = current;
+	frame.index = frames;
+	frame.seconds = std::chrono::duration<double>( now - start ).count();
+	frame.phaseMs[ static_cast< int >( TelemetryPhase::Frame ) ] = static_cast< float >( std::chrono::duration<double, std::milli>( now - frameBegin ).count() );
+	for ( size_t i = 0; i < subsystems.size(); i++ ) frame.phaseMs[ static_cast< int >( subsystems[ i ].phase ) ] += frame.subsystemMs[ i ];
+	frame.allocations = static_cast< uint32_t >( allocations - lastAllocations );
+	frame.allocatedBytes = allocatedBytes - lastAllocatedBytes;
+	frame.hitch = frame.phaseMs[ static_cast< int >( TelemetryPhase::Frame ) ] > settings.hitchMs;
+	for ( int phase = 0; phase < TELEMETRY_PHASE_COUNT; phase++ ) histograms[ phase ].record( frame.phaseMs[ phase ] );
+
+	// Timings start over each frame; counters keep their values until set again.
+	std::fill( std::begin( current.subsystemMs ), std::end( current.subsystemMs ), 0.0f );
+	frames++;
+	frameBegin = now;
+	lastAllocations = allocations;
+	lastAllocatedBytes = allocatedBytes;
+
+	if ( frame.hitch ) {
+		bool coalesced = true;
+		if ( !pending && frame.seconds - lastCaptureSeconds >= settings.captureCooldownSeconds ) {
+			pending = true;
+			pendingFrame = frame.index;
+			framesUntilCapture = settings.framesAfterHitch;
+			coalesced = false;
+		}
+		std::lock_guard<std::mutex> lock( mutex );
+		stats.hitches++;
+		if ( coalesced ) stats.coalesced++;
+	}
+	else if ( pending && framesUntilCapture > 0 ) framesUntilCapture--;
+	if ( pending && framesUntilCapture == 0 ) queueCapture();
+}
+
+void Telemetry::queueCapture() {
+	pending = false;
+	const TelemetryFrame& last = ring[ ( frames - 1 ) % ring.size() ];
+	lastCaptureSeconds = last.seconds;
+
+	std::unique_ptr<Capture> capture( new Capture() );
+	capture->hitchFrame = pendingFrame;
+	capture->subsystemCount = subsystems.size();
+	capture->counterCount = counterNames.size();
+	capture->header = "frame,seconds,hitch";
+	for ( const char* phase : PHASE_NAMES ) capture->header += std::string( "," ) + phase;
+	for ( const Subsystem& subsystem : subsystems ) capture->header += "," + subsystem.name + "_ms";
+	capture->header += ",allocations,allocated_bytes";
+	for ( const std::string& counter : counterNames ) capture->header += "," + counter;
+	const uint64_t available = std::min< uint64_t >( frames, ring.size() );
+	const double hitchSeconds = ring[ pendingFrame % ring.size() ].seconds;
+	uint64_t first = frames - available;
+	while ( first < frames && ring[ first % ring.size() ].seconds < hitchSeconds - settings.historySeconds ) first++;
+	capture->frames.reserve( static_cast< size_t >( frames - first ) );
+	for ( uint64_t i = first; i < frames; i++ ) capture->frames.push_back( ring[ i % ring.size() ] );
+
+	{
+		// A capture still waiting is replaced; the new one reaches as far back as the ring allows.
+		std::lock_guard<std::mutex> lock( mutex );
+		if ( queued ) stats.coalesced++;
+		queued = std::move( capture );
+	}
+	wake.notify_one();
+}
+
+void Telemetry::threadLoop() {
+	std::unique_lock<std::mutex> lock( mutex );
+	for ( ;; ) {
+		wake.wait( lock, [ this ] { return queued || !running; } );
+		if ( !queued ) return;
+
+		std::unique_ptr<Capture> capture = std::move( queued );
+		lock.unlock();
+		const bool written = writeCapture( *capture );
+		lock.lock();
+		if ( written ) stats.captures++;
+		else stats.failed++;
+	}
+}
+
+bool Telemetry::writeCapture( const Capture& capture ) const {
+	std::error_code error;
+	std::filesystem::create_directories( settings.captureDirectory, error );
+	const std::string path = ( std::filesystem::path( settings.captureDirectory ) /
+		( "hitch_" + std::to_string( capture.hitchFrame ) + ".csv" ) ).string();
+	std::FILE* file = std::fopen( path.c_str(), "w" );
+	if ( !file ) {
+		LOG_ERROR( "Failure to write telemetry capture {}.", path );
+		return false;
+	}
+
+	std::fprintf( file, "# Hitch at frame %llu; threshold %g ms\n", static_cast< unsigned long long >( capture.hitchFrame ), settings.hitchMs );
+	std::fprintf( file, "%s\n", capture.header.c_str() );
+
+	for ( const TelemetryFrame& frame : capture.frames ) {
+		std::fprintf( file, "%llu,%.6f,%d", static_cast< unsigned long long >( frame.index ), frame.seconds, frame.hitch ? 1 : 0 );
+		for ( float ms : frame.phaseMs ) std::fprintf( file, ",%.3f", ms );
+		for ( size_t i = 0; i < capture.subsystemCount; i++ ) std::fprintf( file, ",%.3f", frame.subsystemMs[ i ] );
+		std::fprintf( file, ",%u,%llu", frame.allocations, static_cast< unsigned long long >( frame.allocatedBytes ) );
+		for ( size_t i = 0; i < capture.counterCount; i++ ) std::fprintf( file, ",%llu", static_cast< unsigned long long >( frame.counters[ i ] ) );
+		std::fprintf( file, "\n" );
+	}
+	const bool ok = !std::ferror( file );
+	std::fclose( file );
+	if ( ok ) LOG_INFO( "Captured {} frames around the hitch at frame {} to {}.", capture.frames.size(), capture.hitchFrame, path );
+	else LOG_ERROR( "Failure to write telemetry capture {}.", path );
+	return ok;
+}
+
+TelemetrySummary Telemetry::getSummary( TelemetryPhase phase ) const {
+	const FrameHistogram& histogram = getHistogram( phase );
+	TelemetrySummary summary;
+	summary.frames = histogram.getCount();
+	summary.minMs = histogram.getMinMs();
+	summary.meanMs = histogram.getMeanMs();
+	summary.p50Ms = histogram.percentile( 0.50 );
+	summary.p95Ms = histogram.percentile( 0.95 );
+	summary.p99Ms = histogram.percentile( 0.99 );
+	summary.maxMs = histogram.getMaxMs();
+	return summary;
+}
+
+const TelemetryFrame& Telemetry::getLastFrame() const {
+	static const TelemetryFrame empty;
+	return frames ? ring[ ( frames - 1 ) % ring.size() ] : empty;
+}
+
+TelemetryStats Telemetry::getStats() const {
+	std::lock_guard<std::mutex> lock( mutex );
+	TelemetryStats copy = stats;
+	copy.frames = frames;
+	return copy;
+}
@@ -0,0 +1,65 @@
+#include <cstdlib> // Required for std::malloc, std::aligned_alloc and std::free.
+#ifdef _WIN32
+#include <malloc.h> // Required for _aligned_malloc and _aligned_free.
+#endif
+#include <new> // Required for std::bad_alloc and the replaceable operator new.
+
+#include "Telemetry.h" // Includes Telemetry::countAllocation.
+
+// Counts heap allocations for Telemetry by replacing the global operator new. Linked into the game executable
+// only, not the engine library, since the benchmarks count allocations their own way.
+void* operator new( size_t size ) {
+	Telemetry::countAllocation( size );
+	void* p = std::malloc( size ? size : 1 );
+	if ( !p ) throw std::bad_alloc();
+	return p;
+}
+void* operator new[]( size_t size ) {
+	return operator new( size );
+}
+void operator delete( void* p ) noexcept {
+	std::free( p );
+}
+void operator delete[]( void* p ) noexcept {
+	std::free( p );
+}
+void operator delete( void* p, size_t ) noexcept {
+	std::free( p );
+}
+void operator delete[]( void* p, size_t ) noexcept {
+	std::free( p );
+}
+
+// The std::align_val_t forms serve over-aligned types such as SIMD vectors; they are counted the same way.
+void* operator new( size_t size, std::align_val_t alignment ) {
+	Telemetry::countAllocation( size );
+	const size_t align = static_cast< size_t >( alignment );
+#ifdef _WIN32
+	void* p = _aligned_malloc( size ? size : 1, align );
+#else
+	void* p = std::aligned_alloc( align, ( ( size ? size : 1 ) + align - 1 ) / align * align ); // The size must be a multiple of the alignment.
+#endif
+	if ( !p ) throw std::bad_alloc();
+	return p;
+}
+void* operator new[]( size_t size, std::align_val_t alignment ) {
+	return operator new( size, alignment );
+}
+#ifdef _WIN32
+void operator delete( void* p, std::align_val_t ) noexcept {
+	_aligned_free( p );
+}
+#else
+void operator delete( void* p, std::align_val_t ) noexcept {
+	std::free( p );
+}
+#endif
+void operator delete[]( void* p, std::align_val_t alignment ) noexcept {
+	operator delete( p, alignment );
+}
+void operator delete( void* p, size_t, std::align_val_t alignment ) noexcept {
+	operator delete( p, alignment );
+}
+void operator delete[]( void* p, size_t, std::align_val_t alignment ) noexcept {
+	operator delete( p, alignment );
+}
@@ -0,0 +1,453 @@
+#include <algorithm> // Required for std::min and std::max.
+#include <cstddef> // Required for offsetof.
+#include <cstring> // Required for std::memcpy and std::memset.
+#include <fstream> // Required for std::ifstream to read the font file.
+#include <utility> // Required for std::move.
+
+#include <glad/glad.h> // Includes GLAD for OpenGL function loading.
+
+// imgui_draw.cpp compiles its copy of imstb_truetype as static functions, so this file needs its own.
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#if defined( __GNUC__ )
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function" // Most of the library is not used here.
+#endif
+#include "imstb_truetype.h" // Includes the TrueType parser and SDF rasterizer that ships with ImGui.
+#if defined( __GNUC__ )
+#pragma GCC diagnostic pop
+#endif
+
+#include "TextRenderer.h" // Includes the TextRenderer class definition.
+#include "Log.h" // Includes the Logger for error output.
+
+const int TextRenderer::ATLAS_SIZE;
+const int TextRenderer::BASE_SIZE;
+const int TextRenderer::SDF_PADDING;
+const size_t TextRenderer::SHAPE_CACHE_CAPACITY;
+const uint32_t TextRenderer::MAX_QUADS;
+
+static const char* TEXT_VERTEX_SHADER = R"(#version 330 core
+layout( location = 0 ) in vec2 aPosition;
+layout( location = 1 ) in vec2 aTexCoord;
+layout( location = 2 ) in vec4 aColor;
+uniform mat4 uProjection;
+out vec2 vTexCoord;
+out vec4 vColor;
+void main() {
+	vTexCoord = aTexCoord;
+	vColor = aColor;
+	gl_Position = uProjection * vec4( aPosition, 0.0, 1.0 );
+}
+)";
+
+// The edge sits at 0.5; fwidth keeps it about one pixel soft at any size.
+static const char* TEXT_FRAGMENT_SHADER = R"(#version 330 core
+in vec2 vTexCoord;
+in vec4 vColor;
+uniform sampler2D uAtlas;
+out vec4 fragColor;
+void main() {
+	float distance = texture( uAtlas, vTexCoord ).r;
+	float width = max( fwidth( distance ) * 0.75, 1e-4 );
+	fragColor = vec4( vColor.rgb, vColor.a * smoothstep( 0.5 - width, 0.5 + width, distance ) );
+}
+)";
+
+/**
+ * @brief Decodes one UTF-8 sequence. Malformed bytes decode as U+FFFD.
+ * @param text The string.
+ * @param index Position of the sequence; advanced past it.
+ * @return The codepoint.
+ */
+static uint32_t decodeUtf8( const std::string& text, size_t& index ) {
+	const uint8_t lead = static_cast< uint8_t >( text[ index++ ] );
+	if ( lead < 0x80 ) return lead;
+	int length = 0;
+	uint32_t codepoint = 0;
+	if ( ( lead & 0xE0 ) == 0xC0 ) { length = 1; codepoint = lead & 0x1F; }
+	else if ( ( lead & 0xF0 ) == 0xE0 ) { length = 2; codepoint = lead & 0x0F; }
+	else if ( ( lead & 0xF8 ) == 0xF0 ) { length = 3; codepoint = lead & 0x07; }
+	else return 0xFFFD;
+	for ( int i = 0; i < length; i++ ) {
+		if ( index >= text.size() || ( static_cast< uint8_t >( text[ index ] ) & 0xC0 ) != 0x80 ) return 0xFFFD;
+		codepoint = ( codepoint << 6 ) | ( static_cast< uint8_t >( text[ index++ ] ) & 0x3F );
+	}
+	return codepoint;
+}
+
+/**
+ * @brief Compiles one shader stage.
+ * @param type GL_VERTEX_SHADER or GL_FRAGMENT_SHADER.
+ * @param source GLSL source.
+ * @return The shader, or 0 on failure.
+ */
+static GLuint compileShader( GLenum type, const char* source ) {
+	GLuint shader = glCreateShader( type );
+	glShaderSource( shader, 1, &source, nullptr );
+	glCompileShader( shader );
+	GLint ok = 0;
+	glGetShaderiv( shader, GL_COMPILE_STATUS, &ok );
+	if ( !ok ) {
+		char log[ 512 ];
+		glGetShaderInfoLog( shader, sizeof( log ), nullptr, log );
+		LOG_ERROR( "Text shader failed to compile: {}", log );
+		glDeleteShader( shader );
+		return 0;
+	}
+	return shader;
+}
+
+TextRenderer::TextRenderer() = default;
+TextRenderer::~TextRenderer() = default;
+
+bool TextRenderer::loadFont( const std::string& path ) {
+	std::ifstream file( path, std::ios::binary | std::ios::ate );
+	if ( !file ) {
+		LOG_ERROR( "Could not open font {}", path );
+		return false;
+	}
+	std::vector<uint8_t> data( static_cast< size_t >( file.tellg() ) );
+	file.seekg( 0 );
+	file.read( reinterpret_cast< char* >( data.data() ), static_cast< std::streamsize >( data.size() ) );
+
+	std::unique_ptr<stbtt_fontinfo> info( new stbtt_fontinfo() );
+	if ( !file || !stbtt_InitFont( info.get(), data.data(), stbtt_GetFontOffsetForIndex( data.data(), 0 ) ) ) {
+		LOG_ERROR( "{} is not a TrueType font.", path );
+		return false;
+	}
+	fontData = std::move( data ); // The vector's buffer does not move, so info stays valid.
+	font = std::move( info );
+	fontScale = stbtt_ScaleForPixelHeight( font.get(), static_cast< float >( BASE_SIZE ) );
+
+	atlas.assign( static_cast< size_t >( ATLAS_SIZE ) * ATLAS_SIZE, 0 );
+	resetAtlas();
+	shapes.clear();
+	oldShapes.clear();
+	return true;
+}
+
+bool TextRenderer::initGL() {
+	if ( glReady ) return true;
+	GLuint vertexShader = compileShader( GL_VERTEX_SHADER, TEXT_VERTEX_SHADER );
+	GLuint fragmentShader = compileShader( GL_FRAGMENT_SHADER, TEXT_FRAGMENT_SHADER );
+	if ( !vertexShader || !fragmentShader ) {
+		if ( vertexShader ) glDeleteShader( vertexShader );
+		if ( fragmentShader ) glDeleteShader( fragmentShader );
+		return false;
+	}
+	program = glCreateProgram();
+	glAttachShader( program, vertexShader );
+	glAttachShader( program, fragmentShader );
+	glLinkProgram( program );
+	glDeleteShader( vertexShader );
+	glDeleteShader( fragmentShader );
+	GLint linked = 0;
+	glGetProgramiv( program, GL_LINK_STATUS, &linked );
+	if ( !linked ) {
+		LOG_ERROR( "Text shader failed to link." );
+		glDeleteProgram( program );
+		program = 0;
+		return false;
+	}
+	projectionLocation = glGetUniformLocation( program, "uProjection" );
+	glUseProgram( program );
+	glUniform1i( glGetUniformLocation( program, "uAtlas" ), 0 );
+
+	// Every frame draws with the same quad indices, so they are uploaded once.
+	std::vector<uint32_t> indices( static_cast< size_t >( MAX_QUADS ) * 6 );
+	for ( uint32_t quad = 0; quad < MAX_QUADS; quad++ ) {
+		const uint32_t base = quad * 4;
+		uint32_t* index = &indices[ quad * 6 ];
+		index[ 0 ] = base; index[ 1 ] = base + 1; index[ 2 ] = base + 2;
+		index[ 3 ] = base + 2; index[ 4 ] = base + 3; index[ 5 ] = base;
+	}
+
+	glGenVertexArrays( 1, &vao );
+	glGenBuffers( 1, &vbo );
+	glGenBuffers( 1, &ebo );
+	glBindVertexArray( vao );
+	glBindBuffer( GL_ARRAY_BUFFER, vbo );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, ebo );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, static_cast< GLsizeiptr >( indices.size() * sizeof( uint32_t ) ), indices.data(), GL_STATIC_DRAW );
+	glEnableVertexAttribArray( 0 );
+	glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, sizeof( TextVertex ), reinterpret_cast< void* >( offsetof( TextVertex, x ) ) );
+	glEnableVertexAttribArray( 1 );
+	glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, sizeof( TextVertex ), reinterpret_cast< void* >( offsetof( TextVertex, u ) ) );
+	glEnableVertexAttribArray( 2 );
+	glVertexAttribPointer( 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof( TextVertex ), reinterpret_cast< void* >( offsetof( TextVertex, color ) ) );
+	glBindVertexArray( 0 );
+
+	if ( atlas.empty() ) atlas.assign( static_cast< size_t >( ATLAS_SIZE ) * ATLAS_SIZE, 0 );
+	glGenTextures( 1, &texture );
+	glBindTexture( GL_TEXTURE_2D, texture );
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_R8, ATLAS_SIZE, ATLAS_SIZE, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.data() );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	dirtyMin = ATLAS_SIZE;
+	dirtyMax = 0;
+
+	glReady = true;
+	return true;
+}
+
+void TextRenderer::shutdownGL() {
+	if ( !glReady ) return;
+	glDeleteTextures( 1, &texture );
+	glDeleteBuffers( 1, &ebo );
+	glDeleteBuffers( 1, &vbo );
+	glDeleteVertexArrays( 1, &vao );
+	glDeleteProgram( program );
+	program = vao = vbo = ebo = texture = 0;
+	projectionLocation = -1;
+	glReady = false;
+}
+
+void TextRenderer::beginFrame() {
+	if ( frameStarted ) return;
+	stats.strings = 0;
+	stats.quads = 0;
+	stats.shapeHits = 0;
+	stats.shapeMisses = 0;
+	frameStarted = true;
+}
+
+void TextRenderer::drawText( const std::string& text, glm::vec2 position, float size, uint32_t color, TextAlign align ) {
+	beginFrame();
+	if ( !font || text.empty() ) return;
+	stats.strings++;
+	const ShapedText& shaped = getShape( text );
+
+	const float scale = size / BASE_SIZE;
+	float x = position.x;
+	if ( align == TextAlign::Center ) x -= shaped.width * scale * 0.5f;
+	else if ( align == TextAlign::Right ) x -= shaped.width * scale;
+	const float y = position.y;
+
+	const size_t queued = vertices.size() / 4;
+	const size_t count = std::min( shaped.quads.size(), static_cast< size_t >( MAX_QUADS ) - std::min( queued, static_cast< size_t >( MAX_QUADS ) ) );
+	vertices.resize( ( queued + count ) * 4 );
+	TextVertex* out = &vertices[ queued * 4 ];
+	for ( size_t i = 0; i < count; i++, out += 4 ) {
+		const Glyph& glyph = shaped.quads[ i ];
+		const float x0 = x + glyph.x0 * scale, x1 = x + glyph.x1 * scale;
+		const float y0 = y + glyph.y0 * scale, y1 = y + glyph.y1 * scale;
+		out[ 0 ] = { x0, y0, glyph.u0, glyph.v0, color };
+		out[ 1 ] = { x1, y0, glyph.u1, glyph.v0, color };
+		out[ 2 ] = { x1, y1, glyph.u1, glyph.v1, color };
+		out[ 3 ] = { x0, y1, glyph.u0, glyph.v1, color };
+	}
+}
+
+float TextRenderer::measure( const std::string& text, float size ) {
+	beginFrame();
+	if ( !font || text.empty() ) return 0.0f;
+	return getShape( text ).width * size / BASE_SIZE;
+}
+
+void TextRenderer::render( const glm::mat4& projection ) {
+	beginFrame();
+	stats.quads = static_cast< uint32_t >( vertices.size() / 4 );
+	stats.drawCalls = 0;
+	stats.atlasShelfTop = static_cast< uint32_t >( shelfTop );
+
+	if ( glReady && stats.quads > 0 ) {
+		glBindTexture( GL_TEXTURE_2D, texture );
+		if ( dirtyMin < dirtyMax ) {
+			// Rows are contiguous in the atlas, so the changed band uploads in one call.
+			glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+			glTexSubImage2D( GL_TEXTURE_2D, 0, 0, dirtyMin, ATLAS_SIZE, dirtyMax - dirtyMin, GL_RED, GL_UNSIGNED_BYTE,
+				atlas.data() + static_cast< size_t >( dirtyMin ) * ATLAS_SIZE );
+			dirtyMin = ATLAS_SIZE;
+			dirtyMax = 0;
+		}
+
+		glUseProgram( program );
+		glUniformMatrix4fv( projectionLocation, 1, GL_FALSE, &projection[ 0 ][ 0 ] );
+		glActiveTexture( GL_TEXTURE0 );
+		glBindVertexArray( vao );
+		glBindBuffer( GL_ARRAY_BUFFER, vbo );
+		// Orphan the buffer so the driver does not wait for last frame's draw.
+		const GLsizeiptr bytes = static_cast< GLsizeiptr >( vertices.size() * sizeof( TextVertex ) );
+		glBufferData( GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW );
+		glBufferSubData( GL_ARRAY_BUFFER, 0, bytes, vertices.data() );
+
+		glEnable( GL_BLEND );
+		// Alpha accumulates as coverage, so text drawn into an offscreen target composites correctly later.
+		glBlendFuncSeparate( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
+		glDrawElements( GL_TRIANGLES, static_cast< GLsizei >( stats.quads * 6 ), GL_UNSIGNED_INT, nullptr );
+		glBindVertexArray( 0 );
+		stats.drawCalls = 1;
+	}
+
+	vertices.clear();
+	frameStarted = false;
+	if ( atlasResetPending ) {
+		resetAtlas();
+		atlasResetPending = false;
+	}
+}
+
+bool TextRenderer::getGlyph( uint32_t codepoint, Glyph& glyph ) {
+	if ( codepoint < 128 ) {
+		if ( asciiCached[ codepoint ] ) {
+			glyph = asciiGlyphs[ codepoint ];
+			return true;
+		}
+		if ( !rasterize( codepoint, glyph ) ) return false;
+		asciiGlyphs[ codepoint ] = glyph;
+		asciiCached[ codepoint ] = true;
+		return true;
+	}
+	std::unordered_map<uint32_t, Glyph>::const_iterator it = glyphs.find( codepoint );
+	if ( it != glyphs.end() ) {
+		glyph = it->second;
+		return true;
+	}
+	if ( !rasterize( codepoint, glyph ) ) return false;
+	glyphs.emplace( codepoint, glyph );
+	return true;
+}
+
+bool TextRenderer::rasterize( uint32_t codepoint, Glyph& glyph ) {
+	int advance = 0, leftBearing = 0;
+	stbtt_GetCodepointHMetrics( font.get(), static_cast< int >( codepoint ), &advance, &leftBearing );
+	glyph = Glyph{};
+	glyph.advance = advance * fontScale;
+
+	int width = 0, height = 0, xOffset = 0, yOffset = 0;
+	unsigned char* sdf = stbtt_GetCodepointSDF( font.get(), fontScale, static_cast< int >( codepoint ), SDF_PADDING, 128,
+		128.0f / SDF_PADDING, &width, &height, &xOffset, &yOffset );
+	if ( !sdf ) return true; // Nothing to draw, e.g. a space.
+
+	int x = 0, y = 0;
+	if ( !pack( width, height, x, y ) ) {
+		stbtt_FreeSDF( sdf, nullptr );
+		if ( shelfTop == 0 ) return true; // Larger than an empty atlas; drawn as a blank.
+		return false;
+	}
+	for ( int row = 0; row < height; row++ ) {
+		std::memcpy( &atlas[ static_cast< size_t >( y + row ) * ATLAS_SIZE + x ], sdf + static_cast< size_t >( row ) * width, static_cast< size_t >( width ) );
+	}
+	stbtt_FreeSDF( sdf, nullptr );
+	dirtyMin = std::min( dirtyMin, y );
+	dirtyMax = std::max( dirtyMax, y + height );
+	stats.glyphsRasterized++;
+
+	// The SDF bitmap's offset is from the pen to its top left, y down; quads are y up.
+	const float texel = 1.0f / ATLAS_SIZE;
+	glyph.x0 = static_cast< float >( xOffset );
+	glyph.x1 = static_cast< float >( xOffset + width );
+	glyph.y0 = static_cast< float >( -( yOffset + height ) );
+	glyph.y1 = static_cast< float >( -yOffset );
+	glyph.u0 = x * texel;
+	glyph.u1 = ( x + width ) * texel;
+	glyph.v0 = ( y + height ) * texel;
+	glyph.v1 = y * texel;
+	glyph.visible = true;
+	return true;
+}
+
+bool TextRenderer::pack( int width, int height, int& x, int& y ) {
+	const int paddedWidth = width + 1, paddedHeight = height + 1; // One texel apart so filtering cannot bleed.
+
+	// The lowest shelf the rectangle fits, among those not much taller than it.
+	Shelf* best = nullptr;
+	for ( Shelf& shelf : shelves ) {
+		if ( shelf.height < paddedHeight || shelf.height > paddedHeight + paddedHeight / 4 + 2 ) continue;
+		if ( shelf.x + paddedWidth > ATLAS_SIZE ) continue;
+		if ( !best || shelf.height < best->height ) best = &shelf;
+	}
+	if ( !best ) {
+		if ( shelfTop + paddedHeight > ATLAS_SIZE || paddedWidth > ATLAS_SIZE ) return false;
+		shelves.push_back( { shelfTop, paddedHeight, 0 } );
+		shelfTop += paddedHeight;
+		best = &shelves.back();
+	}
+	x = best->x;
+	y = best->y;
+	best->x += paddedWidth;
+	return true;
+}
+
+void TextRenderer::resetAtlas() {
+	if ( shelfTop > 0 ) stats.atlasResets++;
+	std::fill( atlas.begin(), atlas.end(), static_cast< uint8_t >( 0 ) );
+	shelves.clear();
+	shelfTop = 0;
+	std::memset( asciiCached, 0, sizeof( asciiCached ) );
+	glyphs.clear();
+	atlasEpoch++;
+}
+
+void TextRenderer::shape( const std::string& text, ShapedText& shaped ) {
+	// A full atlas is cleared here at most once per string, and only while no queued quad refers to it. Otherwise
+	// the glyphs that do not fit are left out and the atlas is cleared after render() has drawn the frame.
+	for ( bool reset = false;; reset = true ) {
+		const bool canReset = !reset && vertices.empty();
+		shaped.quads.clear();
+		float pen = 0.0f;
+		uint32_t previous = 0;
+		bool full = false;
+		for ( size_t index = 0; index < text.size(); ) {
+			const uint32_t codepoint = decodeUtf8( text, index );
+			if ( previous ) pen += stbtt_GetCodepointKernAdvance( font.get(), static_cast< int >( previous ), static_cast< int >( codepoint ) ) * fontScale;
+			Glyph glyph;
+			if ( !getGlyph( codepoint, glyph ) ) {
+				full = true;
+				if ( canReset ) break;
+			}
+			else if ( glyph.visible ) {
+				glyph.x0 += pen;
+				glyph.x1 += pen;
+				shaped.quads.push_back( glyph );
+			}
+			pen += glyph.advance; // Set even for a glyph that did not fit, so the rest of the string keeps its place.
+			previous = codepoint;
+		}
+		if ( full && canReset ) {
+			resetAtlas();
+			continue;
+		}
+		if ( full && reset ) LOG_ERROR( "The glyphs of \"{}\" do not fit in an empty text atlas; some are not drawn.", text );
+		else if ( full ) atlasResetPending = true;
+		shaped.width = pen;
+		shaped.atlasEpoch = atlasEpoch; // A pending reset makes this shape stale, so it is completed next frame.
+		return;
+	}
+}
+
+const TextRenderer::ShapedText& TextRenderer::getShape( const std::string& text ) {
+	if ( !shapeCacheEnabled ) {
+		stats.shapeMisses++;
+		shape( text, scratch );
+		return scratch;
+	}
+
+	std::unordered_map<std::string, ShapedText>::iterator it = shapes.find( text );
+	if ( it == shapes.end() ) {
+		// Two generations approximate LRU: when the current one is full it becomes the old one,
+		// and strings still in use move back on their next lookup.
+		if ( shapes.size() >= SHAPE_CACHE_CAPACITY ) {
+			oldShapes = std::move( shapes );
+			shapes.clear();
+		}
+		std::unordered_map<std::string, ShapedText>::iterator old = oldShapes.find( text );
+		if ( old != oldShapes.end() ) {
+			it = shapes.emplace( text, std::move( old->second ) ).first;
+			oldShapes.erase( old );
+		}
+	}
+	if ( it != shapes.end() && it->second.atlasEpoch == atlasEpoch ) {
+		stats.shapeHits++;
+		return it->second;
+	}
+
+	stats.shapeMisses++;
+	if ( it == shapes.end() ) it = shapes.emplace( text, ShapedText() ).first;
+	shape( text, it->second ); // May reset the atlas, which leaves the shape maps alone.
+	return it->second;
+}
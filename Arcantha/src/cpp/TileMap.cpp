@@ -0,0 +1,69 @@
+#include <algorithm> // Required for std::max and std::min when clipping rectangles.
+#include <cmath> // Required for std::floor.
+
+#include "TileMap.h" // Includes the TileMap class definition.
+
+TileMap::TileMap( int width, int height, float tileSize ) :
+	width( width ), height( height ), tileSize( tileSize ),
+	tiles( static_cast< size_t >( width ) * height, Tile::Empty ) {}
+
+void TileMap::set( int x, int y, Tile tile ) {
+	if ( x < 0 || y < 0 || x >= width || y >= height ) return;
+
+	tiles[ static_cast< size_t >( y ) * width + x ] = tile;
+}
+
+void TileMap::fill( int x, int y, int w, int h, Tile tile ) {
+	// Clip the rectangle to the map so callers can pass loose bounds.
+	int x0 = std::max( x, 0 ), y0 = std::max( y, 0 );
+	int x1 = std::min( x + w, width ), y1 = std::min( y + h, height );
+
+	for ( int ty = y0; ty < y1; ty++ ) {
+		for ( int tx = x0; tx < x1; tx++ ) {
+			tiles[ static_cast< size_t >( ty ) * width + tx ] = tile;
+		}
+	}
+}
+
+std::vector<TileRect> TileMap::mergeSolidRects() const {
+	std::vector<TileRect> rects;
+	std::vector<bool> merged( tiles.size(), false );
+
+	auto isFree = [ & ]( int x, int y ) {
+		size_t index = static_cast< size_t >( y ) * width + x;
+		return tiles[ index ] == Tile::Solid && !merged[ index ];
+	};
+
+	for ( int y = 0; y < height; y++ ) {
+		for ( int x = 0; x < width; x++ ) {
+			if ( !isFree( x, y ) ) continue;
+
+			int w = 1;
+			while ( x + w < width && isFree( x + w, y ) ) w++;
+
+			int h = 1;
+			while ( y + h < height ) {
+				bool rowFree = true;
+				for ( int i = 0; i < w && rowFree; i++ ) rowFree = isFree( x + i, y + h );
+				if ( !rowFree ) break;
+				h++;
+			}
+
+			for ( int ty = y; ty < y + h; ty++ ) {
+				for ( int tx = x; tx < x + w; tx++ ) merged[ static_cast< size_t >( ty ) * width + tx ] = true;
+			}
+			rects.push_back( { x, y, w, h } );
+		}
+	}
+
+	return rects;
+}
+
+glm::ivec2 TileMap::worldToTile( const glm::vec2& position ) const {
+	return glm::ivec2( static_cast< int >( std::floor( position.x / tileSize ) ),
+		static_cast< int >( std::floor( position.y / tileSize ) ) );
+}
+
+glm::vec2 TileMap::tileCenter( int x, int y ) const {
+	return glm::vec2( ( x + 0.5f ) * tileSize, ( y + 0.5f ) * tileSize );
+}
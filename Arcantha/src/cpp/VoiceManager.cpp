@@ -0,0 +1,341 @@
+#include <algorithm> // Required for std::nth_element and std::min.
+#include <cmath> // Required for std::fmod.
+
+#include <AL/efx.h> // Includes the auxiliary send source property.
+
+#include "MappedFile.h" // Includes MappedFile to read sound files.
+#include "AudioEngine.h" // Includes parseWav.
+#include "VoiceManager.h" // Includes the VoiceManager class definition.
+#include "Log.h" // Includes the Logger for error output.
+
+VoiceManager::~VoiceManager() {
+	shutdown();
+}
+
+bool VoiceManager::init( int realVoices, int virtualVoices ) {
+	shutdown();
+	virtualVoices = std::max( 1, std::min( virtualVoices, 65535 ) );
+
+	// Create sources one at a time until OpenAL refuses; the device may support fewer than asked.
+	alGetError();
+	for ( int i = 0; i < realVoices; i++ ) {
+		ALuint source = 0;
+		alGenSources( 1, &source );
+		if ( alGetError() != AL_NO_ERROR ) break;
+		sources.push_back( source );
+	}
+	if ( sources.empty() ) {
+		LOG_ERROR( "Failure to create any OpenAL voice source." );
+		return false;
+	}
+	freeSources = sources;
+
+	alDistanceModel( AL_LINEAR_DISTANCE_CLAMPED ); // Matches the attenuation used for ranking in score().
+	setAttenuation( referenceDistance, maxDistance );
+
+	voices.assign( static_cast< size_t >( virtualVoices ), Voice() );
+	ranked.reserve( voices.size() );
+	freeSlots.reserve( voices.size() );
+	for ( int i = virtualVoices - 1; i >= 0; i-- ) freeSlots.push_back( static_cast< uint16_t >( i ) );
+
+	setCategoryLimit( SoundCategory::Footstep, 4 );
+	stats = VoiceStats();
+	return true;
+}
+
+void VoiceManager::shutdown() {
+	for ( size_t i = 0; i < voices.size(); i++ ) {
+		if ( voices[ i ].active ) release( static_cast< int >( i ) );
+	}
+	if ( !sources.empty() ) alDeleteSources( static_cast< ALsizei >( sources.size() ), sources.data() );
+	if ( !loadedBuffers.empty() ) alDeleteBuffers( static_cast< ALsizei >( loadedBuffers.size() ), loadedBuffers.data() );
+
+	voices.clear();
+	freeSlots.clear();
+	sources.clear();
+	freeSources.clear();
+	loadedBuffers.clear();
+	ranked.clear();
+	for ( int& count : categoryCounts ) count = 0;
+}
+
+ALuint VoiceManager::loadSound( const std::string& path ) {
+	MappedFile file;
+	WavData wav;
+	if ( !file.open( path ) || !parseWav( file.data(), file.size(), wav ) ) {
+		LOG_ERROR( "Failure to load sound {}", path );
+		return 0;
+	}
+
+	alGetError();
+	ALuint buffer = 0;
+	alGenBuffers( 1, &buffer );
+	alBufferData( buffer, wav.format, wav.samples, static_cast< ALsizei >( wav.bytes ), wav.sampleRate );
+	if ( alGetError() != AL_NO_ERROR ) {
+		LOG_ERROR( "Failure to upload sound {}", path );
+		alDeleteBuffers( 1, &buffer );
+		return 0;
+	}
+
+	loadedBuffers.push_back( buffer );
+	return buffer;
+}
+
+VoiceHandle VoiceManager::play( ALuint buffer, const VoiceParams& params ) {
+	if ( !buffer || voices.empty() ) {
+		stats.rejected++;
+		return 0;
+	}
+
+	Voice candidate;
+	candidate.buffer = buffer;
+	candidate.category = params.category;
+	candidate.priority = std::max( 0, params.priority );
+	candidate.position = params.position;
+	candidate.gain = params.gain;
+	candidate.pitch = params.pitch;
+	candidate.loop = params.loop;
+	candidate.positional = params.positional;
+
+	ALint size = 0, channels = 1, bits = 16, frequency = 1;
+	alGetBufferi( buffer, AL_SIZE, &size );
+	alGetBufferi( buffer, AL_CHANNELS, &channels );
+	alGetBufferi( buffer, AL_BITS, &bits );
+	alGetBufferi( buffer, AL_FREQUENCY, &frequency );
+	const int bytesPerFrame = std::max( 1, channels * bits / 8 );
+	candidate.duration = static_cast< float >( size / bytesPerFrame ) / static_cast< float >( std::max( 1, frequency ) );
+	candidate.score = score( candidate );
+
+	// Category limit first, then the global slot limit; either can steal a weaker voice.
+	const int category = static_cast< int >( params.category );
+	if ( categoryLimits[ category ] > 0 && categoryCounts[ category ] >= categoryLimits[ category ] ) {
+		int weakest = findWeakest( params.category );
+		if ( weakest < 0 || score( voices[ weakest ] ) >= candidate.score ) {
+			stats.rejected++;
+			return 0;
+		}
+		release( weakest );
+		stats.stolen++;
+	}
+	if ( freeSlots.empty() ) {
+		int weakest = findWeakest( SoundCategory::COUNT );
+		if ( weakest < 0 || score( voices[ weakest ] ) >= candidate.score ) {
+			stats.rejected++;
+			return 0;
+		}
+		release( weakest );
+		stats.stolen++;
+	}
+
+	const uint16_t slot = freeSlots.back();
+	freeSlots.pop_back();
+	Voice& voice = voices[ slot ];
+	candidate.generation = voice.generation;
+	candidate.active = true;
+	voice = candidate;
+	categoryCounts[ category ]++;
+	stats.started++;
+
+	// Audible voices start immediately if a source is free; otherwise the next update decides.
+	if ( !freeSources.empty() && voice.score >= 0.0f ) {
+		ALuint source = freeSources.back();
+		freeSources.pop_back();
+		promote( voice, source );
+	}
+
+	return ( static_cast< VoiceHandle >( voice.generation ) << 16 ) | ( static_cast< VoiceHandle >( slot ) + 1 );
+}
+
+void VoiceManager::stop( VoiceHandle handle ) {
+	if ( resolve( handle ) ) release( static_cast< int >( ( handle & 0xFFFF ) - 1 ) );
+}
+
+void VoiceManager::setPosition( VoiceHandle handle, glm::vec2 position ) {
+	if ( Voice* voice = resolve( handle ) ) {
+		voice->position = position;
+		voice->dirty = true;
+	}
+}
+
+void VoiceManager::setGain( VoiceHandle handle, float gain ) {
+	if ( Voice* voice = resolve( handle ) ) {
+		voice->gain = gain;
+		voice->dirty = true;
+	}
+}
+
+bool VoiceManager::isPlaying( VoiceHandle handle ) const {
+	return resolve( handle ) != nullptr;
+}
+
+bool VoiceManager::isReal( VoiceHandle handle ) const {
+	const Voice* voice = resolve( handle );
+	return voice && voice->source;
+}
+
+void VoiceManager::setCategoryLimit( SoundCategory category, int limit ) {
+	categoryLimits[ static_cast< int >( category ) ] = std::max( 0, limit );
+}
+
+void VoiceManager::setAttenuation( float referenceDistance, float maxDistance ) {
+	this->referenceDistance = referenceDistance;
+	this->maxDistance = std::max( maxDistance, referenceDistance + 0.001f );
+	for ( ALuint source : sources ) {
+		alSourcef( source, AL_REFERENCE_DISTANCE, this->referenceDistance );
+		alSourcef( source, AL_MAX_DISTANCE, this->maxDistance );
+		alSourcef( source, AL_ROLLOFF_FACTOR, 1.0f );
+	}
+}
+
+void VoiceManager::setAuxiliarySend( ALuint effectSlot ) {
+	for ( ALuint source : sources ) alSource3i( source, AL_AUXILIARY_SEND_FILTER, static_cast< ALint >( effectSlot ), 0, AL_FILTER_NULL );
+}
+
+void VoiceManager::setListener( glm::vec2 position ) {
+	listener = position;
+	alListener3f( AL_POSITION, position.x, position.y, 0.0f );
+}
+
+void VoiceManager::update( float dt ) {
+	ranked.clear();
+
+	for ( size_t i = 0; i < voices.size(); i++ ) {
+		Voice& voice = voices[ i ];
+		if ( !voice.active ) continue;
+
+		// Real voices end when their source does; virtual ones when their playhead passes the end.
+		if ( voice.source && !voice.loop ) {
+			ALint state = AL_STOPPED;
+			alGetSourcei( voice.source, AL_SOURCE_STATE, &state );
+			if ( state == AL_STOPPED ) {
+				release( static_cast< int >( i ) );
+				continue;
+			}
+		}
+		voice.time += dt * voice.pitch;
+		if ( voice.time >= voice.duration ) {
+			if ( !voice.loop && !voice.source ) {
+				release( static_cast< int >( i ) );
+				continue;
+			}
+			if ( voice.loop && voice.duration > 0.0f ) voice.time = std::fmod( voice.time, voice.duration );
+		}
+
+		voice.score = score( voice );
+		if ( voice.score >= 0.0f && voice.source ) voice.score += REAL_VOICE_BONUS;
+		ranked.push_back( static_cast< uint16_t >( i ) );
+	}
+
+	// The top realCount voices by score own the sources this frame.
+	const size_t realCount = std::min( sources.size(), ranked.size() );
+	if ( realCount < ranked.size() ) {
+		std::nth_element( ranked.begin(), ranked.begin() + realCount, ranked.end(), [ this ]( uint16_t a, uint16_t b ) {
+			return voices[ a ].score > voices[ b ].score;
+		} );
+	}
+
+	// Demote first so the freed sources are available to the voices being promoted.
+	for ( size_t k = 0; k < ranked.size(); k++ ) {
+		Voice& voice = voices[ ranked[ k ] ];
+		if ( voice.source && ( k >= realCount || voice.score < 0.0f ) ) demote( voice );
+	}
+	for ( size_t k = 0; k < realCount; k++ ) {
+		Voice& voice = voices[ ranked[ k ] ];
+		if ( voice.score < 0.0f ) continue;
+
+		if ( !voice.source ) {
+			ALuint source = freeSources.back();
+			freeSources.pop_back();
+			promote( voice, source );
+		}
+		else if ( voice.dirty ) {
+			apply( voice );
+		}
+	}
+
+	stats.live = static_cast< int >( ranked.size() );
+	stats.real = static_cast< int >( sources.size() - freeSources.size() );
+}
+
+VoiceManager::Voice* VoiceManager::resolve( VoiceHandle handle ) {
+	return const_cast< Voice* >( static_cast< const VoiceManager* >( this )->resolve( handle ) );
+}
+
+const VoiceManager::Voice* VoiceManager::resolve( VoiceHandle handle ) const {
+	const uint32_t slot = ( handle & 0xFFFF );
+	if ( slot == 0 || slot > voices.size() ) return nullptr;
+
+	const Voice& voice = voices[ slot - 1 ];
+	return voice.active && voice.generation == ( handle >> 16 ) ? &voice : nullptr;
+}
+
+float VoiceManager::score( const Voice& voice ) const {
+	float audibility = voice.gain;
+	if ( voice.positional ) {
+		const float distance = glm::length( voice.position - listener );
+		if ( distance >= maxDistance ) audibility = 0.0f;
+		else if ( distance > referenceDistance ) audibility *= 1.0f - ( distance - referenceDistance ) / ( maxDistance - referenceDistance );
+	}
+	if ( audibility < INAUDIBLE ) return -1.0f;
+
+	return static_cast< float >( voice.priority ) + std::min( audibility, 1.0f );
+}
+
+int VoiceManager::findWeakest( SoundCategory category ) const {
+	int weakest = -1;
+	float weakestScore = 0.0f;
+	for ( size_t i = 0; i < voices.size(); i++ ) {
+		const Voice& voice = voices[ i ];
+		if ( !voice.active || ( category != SoundCategory::COUNT && voice.category != category ) ) continue;
+
+		const float voiceScore = score( voice );
+		if ( weakest < 0 || voiceScore < weakestScore ) {
+			weakest = static_cast< int >( i );
+			weakestScore = voiceScore;
+		}
+	}
+	return weakest;
+}
+
+void VoiceManager::promote( Voice& voice, ALuint source ) {
+	voice.source = source;
+	alSourcei( source, AL_BUFFER, static_cast< ALint >( voice.buffer ) );
+	alSourcei( source, AL_LOOPING, voice.loop ? AL_TRUE : AL_FALSE );
+	alSourcei( source, AL_SOURCE_RELATIVE, voice.positional ? AL_FALSE : AL_TRUE );
+	apply( voice );
+	alSourcef( source, AL_SEC_OFFSET, voice.time ); // Resume where the voice would be had it been audible all along.
+	alSourcePlay( source );
+	stats.promotions++;
+}
+
+void VoiceManager::demote( Voice& voice ) {
+	alGetSourcef( voice.source, AL_SEC_OFFSET, &voice.time );
+	alSourceStop( voice.source );
+	alSourcei( voice.source, AL_BUFFER, 0 );
+	freeSources.push_back( voice.source );
+	voice.source = 0;
+	stats.demotions++;
+}
+
+void VoiceManager::apply( Voice& voice ) {
+	if ( voice.positional ) alSource3f( voice.source, AL_POSITION, voice.position.x, voice.position.y, 0.0f );
+	else alSource3f( voice.source, AL_POSITION, 0.0f, 0.0f, 0.0f );
+	alSourcef( voice.source, AL_GAIN, voice.gain );
+	alSourcef( voice.source, AL_PITCH, voice.pitch );
+	voice.dirty = false;
+}
+
+void VoiceManager::release( int index ) {
+	Voice& voice = voices[ index ];
+	if ( voice.source ) {
+		alSourceStop( voice.source );
+		alSourcei( voice.source, AL_BUFFER, 0 );
+		freeSources.push_back( voice.source );
+		voice.source = 0;
+	}
+
+	voice.active = false;
+	if ( ++voice.generation == 0 ) voice.generation = 1; // 0 would make handle 0 reachable.
+	categoryCounts[ static_cast< int >( voice.category ) ]--;
+	freeSlots.push_back( static_cast< uint16_t >( index ) );
+}
@@ -1,10 +1,10 @@
-#include <iostream> // Required for std::cerr for error output.
 #include <string> // Required for std::string operations.
 
 #include <glad/glad.h> // Includes GLAD for OpenGL function loading.
 #include <GLFW/glfw3.h> // Includes GLFW for windowing and context creation.
 
 #include "Window.h" // Includes the Window class definition.
+#include "Log.h" // Includes the Logger for error output.
 
 /**
  * @brief Constructor for the Window class.
@@ -31,14 +31,14 @@ Window::Window( const int width, const int height, glm::vec4 clear, const std::s
  * makes the window visible, and enables alpha blending.
  */
 void Window::init() {
-	// Set GLFW error callback to print errors to stderr.
+	// Set GLFW error callback to log errors; the callback may fire every frame, so it must not block.
 	glfwSetErrorCallback( []( int error, const char* description ) {
-		std::cerr << "Err: " << error << " | " << description << std::endl;
+		LOG_ERROR( "{} | {}", error, description );
 	} );
 
 	// Initialize GLFW. If initialization fails, print an error and exit.
 	if ( !glfwInit() ) {
-		std::cerr << "Err: Failure to initialize GLFW." << std::endl;
+		LOG_FATAL( "Failure to initialize GLFW." );
 		exit( -1 ); // Exit with an error code.
 	}
 
@@ -52,7 +52,7 @@ void Window::init() {
 	// Create the GLFW window. If creation fails, print an error and exit.
 	this->window = glfwCreateWindow( this->width, this->height, this->title.c_str(), NULL, NULL );
 	if ( !window ) {
-		std::cerr << "Err: Failure to create GLFW window." << std::endl;
+		LOG_FATAL( "Failure to create GLFW window." );
 		glfwTerminate(); // Terminate GLFW before exiting.
 		exit( -2 ); // Exit with an error code.
 	}
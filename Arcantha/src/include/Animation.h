@@ -0,0 +1,377 @@
+#pragma once
+
+#include <cstdint> // Required for fixed-width integer types.
+#include <string> // Required for clip names.
+#include <vector> // Required for the skeleton, clip, machine and character arrays.
+
+#include <glm/glm.hpp> // Includes GLM for glm::vec2 positions and glm::mat3x2 bone transforms.
+
+/**
+ * @brief A bone's transform relative to its parent.
+ */
+struct BonePose
+{
+	float x = 0.0f, y = 0.0f; // Translation in meters.
+	float rotation = 0.0f; // Radians, counterclockwise.
+	float scale = 1.0f; // Uniform scale.
+};
+
+/**
+ * @brief Which part of a BonePose a key animates.
+ */
+enum class AnimChannel : uint8_t
+{
+	X,
+	Y,
+	Rotation,
+	Scale
+};
+
+/**
+ * @brief One authored keyframe.
+ */
+struct AnimKey
+{
+	uint16_t bone;
+	AnimChannel channel;
+	float time; // Seconds from the clip start.
+	float value;
+};
+
+/**
+ * @brief An authored clip, before it is compiled to quantized tracks.
+ */
+struct AnimClipDesc
+{
+	std::string name;
+	float duration = 1.0f; // Seconds.
+	bool loop = true;
+	std::vector<AnimKey> keys; // Any order; channels without keys keep the bind pose.
+	std::vector<uint16_t> flipbook; // Sprite frames shown over the clip, evenly spaced; may be empty.
+};
+
+/**
+ * @brief A skinned vertex: a point bound to up to two bones.
+ */
+struct AnimVertex
+{
+	float x, y; // Bind-pose position in meters.
+	uint8_t bone0, bone1;
+	float weight; // Of bone0; bone1 gets the rest.
+};
+
+/**
+ * @brief When a state machine transition fires.
+ */
+enum class AnimCondition : uint8_t
+{
+	Greater, // The parameter is above the threshold.
+	Less, // The parameter is below the threshold.
+	Finished // The state's clip reached its end (non-looping clips).
+};
+
+/**
+ * @brief A state of a state machine: a clip played at a speed.
+ */
+struct AnimStateDesc
+{
+	uint16_t clip;
+	float speed = 1.0f;
+};
+
+/**
+ * @brief A transition between states; the first one of a state whose condition holds is taken.
+ */
+struct AnimTransitionDesc
+{
+	uint16_t from, to;
+	AnimCondition condition;
+	uint8_t parameter = 0; // Ignored for Finished.
+	float threshold = 0.0f;
+	float blend = 0.1f; // Crossfade seconds.
+};
+
+/**
+ * @brief How often a character's pose is evaluated, in frames.
+ */
+enum class AnimLod : uint8_t
+{
+	Near = 1, // Visible or near the player: posed and skinned every frame.
+	Far = 4, // Off-screen: posed every 4 frames, never skinned.
+	Dormant = 16 // Off-screen and far away: posed every 16 frames, never skinned.
+};
+
+/**
+ * @brief Settings of the level of detail classification.
+ */
+struct AnimLodSettings
+{
+	float nearRadius = 12.0f; // Characters closer to the focus than this are always Near.
+	float farRadius = 40.0f; // Off-screen characters beyond this are Dormant.
+	glm::vec2 viewHalfSize{ 16.0f, 9.0f }; // Half extents of the visible area around the focus.
+	bool enabled = true; // When false, every character is posed and skinned every frame.
+};
+
+/**
+ * @brief Counters of the last AnimationSystem::update().
+ */
+struct AnimStats
+{
+	uint32_t characters = 0;
+	uint32_t posed = 0; // Poses evaluated this frame.
+	uint32_t skinned = 0; // Meshes skinned this frame.
+	uint32_t transitions = 0; // State changes this frame.
+	uint32_t lodCounts[ 3 ] = {}; // Characters at Near, Far and Dormant.
+	uint32_t trackBytes = 0; // Size of every compiled clip's quantized samples.
+	double updateMs = 0.0;
+};
+
+/**
+ * @brief Data-driven 2D skeletal and flipbook animation for many characters.
+ *
+ * Clips are compiled from keyframes into tracks resampled at SAMPLE_RATE and
+ * quantized to 16 bits over each track's range; channels that never change
+ * are dropped and keep the bind pose. State machines are compiled to flat
+ * tables: each state owns a contiguous run of transitions, tested in order
+ * against the character's parameters.
+ *
+ * update() advances every character's state machine and clip time, then
+ * evaluates poses (sample, crossfade, bone hierarchy) and skins meshes for
+ * the characters that are due, in batches on the JobSystem. Off-screen
+ * characters keep their state and time exact but are posed less often and
+ * not skinned, like AiSystem's agents; a character that comes into view is
+ * Near again, so it is posed and skinned that frame.
+ *
+ * Skinning blends two bones per vertex, four vertices per SSE step; runs of
+ * four vertices bound to the same bones, as in sprite quads, skip the
+ * per-lane gather.
+ *
+ * Call everything from the game thread.
+ */
+class AnimationSystem
+{
+public:
+	static const int PARAMETERS = 8; // State machine parameters per character.
+	static const float SAMPLE_RATE; // Samples per second of compiled tracks.
+	static const size_t BATCH_SIZE = 32; // Characters per job.
+
+	/**
+	 * @brief Adds a skeleton.
+	 * @param parents Parent of every bone, -1 for the root; parents must come before their children.
+	 * @param bind Bind pose of every bone, relative to its parent.
+	 * @return The skeleton index, or -1 if the hierarchy is invalid.
+	 */
+	int addSkeleton( const std::vector<int16_t>& parents, const std::vector<BonePose>& bind );
+	/**
+	 * @brief Compiles a clip.
+	 * @param skeleton The skeleton it animates.
+	 * @param desc The authored clip.
+	 * @return The clip index, or -1 if a key names a missing bone.
+	 */
+	int addClip( int skeleton, const AnimClipDesc& desc );
+	/**
+	 * @brief Adds a skinned mesh.
+	 * @param skeleton The skeleton it is bound to.
+	 * @param vertices The vertices; keep those of one sprite quad together.
+	 * @return The mesh index, or -1 if a vertex names a missing bone.
+	 */
+	int addMesh( int skeleton, const std::vector<AnimVertex>& vertices );
+	/**
+	 * @brief Compiles a state machine; state 0 is the entry state.
+	 * @param states The states; their clips must share one skeleton.
+	 * @param transitions The transitions, tested in the given order per state.
+	 * @return The machine index, or -1 if a state or clip is missing.
+	 */
+	int addStateMachine( const std::vector<AnimStateDesc>& states, const std::vector<AnimTransitionDesc>& transitions );
+
+	/**
+	 * @brief Adds a character in its machine's entry state.
+	 * @param machine The state machine.
+	 * @param mesh A mesh of the machine's skeleton, or -1 for a flipbook-only character.
+	 * @param position Position in meters, for LOD.
+	 * @return The character index.
+	 */
+	uint32_t addCharacter( int machine, int mesh, glm::vec2 position );
+	/**
+	 * @brief Swaps a character's machine and mesh, e.g. to shape-shift; it restarts in the entry state.
+	 * @param character The character.
+	 * @param machine The new state machine.
+	 * @param mesh A mesh of the new machine's skeleton, or -1.
+	 */
+	void setMachine( uint32_t character, int machine, int mesh );
+	/**
+	 * @brief Sets a state machine parameter.
+	 * @param character The character.
+	 * @param parameter 0 to PARAMETERS - 1.
+	 * @param value The value.
+	 */
+	void setParameter( uint32_t character, int parameter, float value ) { characters[ character ].parameters[ parameter ] = value; }
+	/**
+	 * @brief Moves a character, for LOD.
+	 * @param character The character.
+	 * @param position Position in meters.
+	 */
+	void setPosition( uint32_t character, glm::vec2 position ) { characters[ character ].position = position; }
+	/**
+	 * @brief Sets the LOD settings.
+	 * @param settings The new settings.
+	 */
+	void setLodSettings( const AnimLodSettings& settings ) { lodSettings = settings; }
+
+	/**
+	 * @brief Advances every character and evaluates the poses and meshes that are due.
+	 * @param dt The frame time in seconds.
+	 * @param focus The player's position.
+	 */
+	void update( float dt, glm::vec2 focus );
+
+	/**
+	 * @brief Gets a character's current state.
+	 * @param character The character.
+	 * @return The state index in its machine.
+	 */
+	uint16_t getState( uint32_t character ) const { return characters[ character ].state; }
+	/**
+	 * @brief Gets a character's flipbook frame.
+	 * @param character The character.
+	 * @return The sprite frame of its current clip, or 0 if the clip has no flipbook.
+	 */
+	uint16_t getSpriteFrame( uint32_t character ) const { return characters[ character ].spriteFrame; }
+	/**
+	 * @brief Gets a character's bone transforms from its last evaluated pose.
+	 * @param character The character.
+	 * @return One model-space transform per bone.
+	 */
+	const std::vector<glm::mat3x2>& getBones( uint32_t character ) const { return characters[ character ].bones; }
+	/**
+	 * @brief Gets a character's skinned vertices from its last skinning.
+	 * @param character The character.
+	 * @return Model-space positions, one per mesh vertex (plus padding).
+	 */
+	const std::vector<glm::vec2>& getSkinnedVertices( uint32_t character ) const { return characters[ character ].skinned; }
+	/**
+	 * @brief Gets the number of characters.
+	 * @return The count.
+	 */
+	uint32_t getCharacterCount() const { return static_cast< uint32_t >( characters.size() ); }
+	/**
+	 * @brief Gets the counters of the last update.
+	 * @return The statistics.
+	 */
+	const AnimStats& getStats() const { return stats; }
+
+private:
+	/**
+	 * @brief A bone hierarchy.
+	 */
+	struct Skeleton
+	{
+		std::vector<int16_t> parents;
+		std::vector<BonePose> bind;
+		std::vector<glm::mat3x2> inverseBind; // Model space to bone space in the bind pose.
+	};
+
+	/**
+	 * @brief One animated channel of a compiled clip.
+	 */
+	struct Track
+	{
+		uint16_t bone;
+		AnimChannel channel;
+		float base, step; // value = base + step * sample.
+		uint32_t first; // First sample in the clip's samples.
+	};
+
+	/**
+	 * @brief A compiled clip.
+	 */
+	struct Clip
+	{
+		std::string name;
+		int skeleton;
+		float duration;
+		bool loop;
+		uint32_t frames; // Samples per track.
+		std::vector<Track> tracks;
+		std::vector<uint16_t> samples; // Every track's samples, back to back.
+		std::vector<uint16_t> flipbook;
+	};
+
+	/**
+	 * @brief A skinned mesh in SoA form, padded to a multiple of four vertices.
+	 */
+	struct Mesh
+	{
+		int skeleton;
+		uint32_t count;
+		std::vector<float> x, y, weight;
+		std::vector<uint8_t> bone0, bone1;
+	};
+
+	/**
+	 * @brief A compiled state machine.
+	 */
+	struct StateMachine
+	{
+		int skeleton;
+		std::vector<AnimStateDesc> states;
+		std::vector<uint32_t> firstTransition; // Per state, plus one past the end.
+		std::vector<AnimTransitionDesc> transitions; // Sorted by state, authored order within a state.
+	};
+
+	/**
+	 * @brief One animated character.
+	 */
+	struct Character
+	{
+		int machine = -1;
+		int mesh = -1;
+		glm::vec2 position{ 0.0f };
+		float parameters[ PARAMETERS ] = {};
+		uint16_t state = 0, fromState = 0;
+		float time = 0.0f, fromTime = 0.0f; // Clip time of the current and the fading out state.
+		float blend = 1.0f, blendDuration = 0.0f; // Crossfade progress, 1 when done.
+		uint16_t spriteFrame = 0;
+		uint8_t lod = static_cast< uint8_t >( AnimLod::Near );
+		uint8_t phase = 0; // Frame offset that staggers characters with the same LOD.
+		std::vector<glm::mat3x2> bones;
+		std::vector<glm::vec2> skinned;
+	};
+
+	std::vector<Skeleton> skeletons;
+	std::vector<Clip> clips;
+	std::vector<Mesh> meshes;
+	std::vector<StateMachine> machines;
+	std::vector<Character> characters;
+	std::vector<uint32_t> batchCounts; // posed, skinned and transitions per batch of this frame.
+	AnimLodSettings lodSettings;
+	uint64_t frame = 0;
+	AnimStats stats;
+
+	/**
+	 * @brief Steps a character's state machine and clip times.
+	 * @param character The character.
+	 * @param dt The frame time.
+	 * @return True if it changed state.
+	 */
+	bool advance( Character& character, float dt ) const;
+	/**
+	 * @brief Samples a clip into a local pose that starts as the bind pose.
+	 * @param clip The clip.
+	 * @param time Clip time in seconds.
+	 * @param pose One entry per bone.
+	 */
+	void sample( const Clip& clip, float time, BonePose* pose ) const;
+	/**
+	 * @brief Evaluates a character's pose into its bone transforms.
+	 * @param character The character.
+	 * @param scratch Room for two local poses.
+	 */
+	void evaluatePose( Character& character, std::vector<BonePose>& scratch ) const;
+	/**
+	 * @brief Skins a character's mesh with its bone transforms.
+	 * @param character The character.
+	 * @param palette Room for one skinning transform per bone.
+	 */
+	void skin( Character& character, std::vector<glm::mat3x2>& palette ) const;
+};
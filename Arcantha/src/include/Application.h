@@ -1,9 +1,12 @@
 #pragma once 
 
+#include <cstdint> // Required for uint32_t telemetry ids.
 #include <string> // Required for std::string operations.
 
 #include "Window.h" // Includes the Window class definition, which Application depends on.
 #include "Input.h"
+#include "StartupGraph.h" // Includes the StartupGraph that runs subsystem initialization.
+#include "VoiceManager.h" // Includes the VoiceManager class used for sound effects.
 
 /**
  * @brief The Application class represents the main application instance.
@@ -33,6 +36,14 @@ private:
 
 	Window mainWindow; // The main window of the application.
 	EventDispatcher& eventDispatcher;
+	VoiceManager voices; // Pooled sound effect voices, only initialized if audio is available.
+	StartupGraph startup; // Subsystem initialization; created with the application, so its trace starts at launch.
+	uint32_t telemetryInput = 0; // Telemetry subsystem id of event polling and input.
+	uint32_t telemetrySimulation = 0; // Telemetry subsystem id of gameplay event delivery.
+	uint32_t telemetryAudio = 0; // Telemetry subsystem id of voice updates.
+	uint32_t telemetryRender = 0; // Telemetry subsystem id of presentation and drawing.
+	uint32_t telemetryEvents = 0; // Telemetry counter id of events posted per frame.
+	uint32_t telemetryVoices = 0; // Telemetry counter id of live voices.
 
 	/**
 	 * @brief Private constructor to enforce Singleton pattern.
@@ -49,7 +60,8 @@ private:
 	/**
 	 * @brief Initializes the application.
 	 *
-	 * This includes initializing the main window and the input manager.
+	 * Runs the subsystem initializers through the startup graph: the main
+	 * window and input manager on this thread, audio concurrently on a worker.
 	 */
 	void init();
 	/**
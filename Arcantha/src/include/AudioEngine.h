@@ -0,0 +1,267 @@
+#pragma once
+
+#include <atomic> // Required for the handle counter and the thread flags.
+#include <cstddef> // Required for size_t.
+#include <cstdint> // Required for fixed-width integer types.
+#include <string> // Required for std::string paths.
+#include <thread> // Required for the audio thread.
+#include <vector> // Required for std::vector scratch buffers.
+
+#include <AL/al.h> // Includes the OpenAL source and buffer API.
+#include <AL/alc.h> // Includes the OpenAL device and context API.
+
+#include "MappedFile.h" // Includes MappedFile to stream audio straight from disk.
+#include "SpscQueue.h" // Includes the lock-free queue used for game thread commands.
+
+/**
+ * @brief The sample layout of a parsed WAV file. The samples point into the file data.
+ */
+struct WavData
+{
+	const uint8_t* samples = nullptr; // First byte of the interleaved sample data.
+	size_t bytes = 0; // Size of the sample data in bytes.
+	ALenum format = AL_NONE; // Matching OpenAL buffer format.
+	int sampleRate = 0; // Frames per second.
+	int channels = 0; // 1 (mono) or 2 (stereo).
+	int bytesPerFrame = 0; // Bytes of one sample for every channel.
+};
+
+/**
+ * @brief Reads the header of a RIFF/WAVE file without copying any samples.
+ *
+ * Supports 8 and 16-bit integer PCM and 32-bit float, mono or stereo.
+ * @param data The file contents.
+ * @param size The size of the file contents in bytes.
+ * @param out Receives the sample layout.
+ * @return False if the file is not a supported WAV.
+ */
+bool parseWav( const uint8_t* data, size_t size, WavData& out );
+
+/**
+ * @brief Identifies a stream started with AudioEngine; 0 is never a valid handle.
+ */
+using StreamHandle = uint32_t;
+
+/**
+ * @brief The AudioEngine class streams music and long ambience on a dedicated audio thread.
+ *
+ * This class implements the Singleton design pattern. Files are memory mapped
+ * and fed to each OpenAL source through a small ring of queued buffers, so a
+ * stream's resident memory is bounded by getStreamMemoryBound() regardless of
+ * track length, and nothing is decoded or loaded on the game thread.
+ *
+ * The game thread talks to the audio thread only through a lock-free command
+ * queue: every public method below besides init and shutdown just enqueues a
+ * command and returns. Commands must all be issued from the same thread.
+ */
+class AudioEngine
+{
+public:
+	static const int MAX_STREAMS = 8; // Streams that can play at once, including ones fading out.
+	static const int BUFFERS_PER_STREAM = 4; // OpenAL buffers queued per stream.
+	static const size_t BUFFER_BYTES = 32768; // Size of one queued buffer (~0.19 s of 44.1 kHz 16-bit stereo).
+	static const int UPDATE_MS = 5; // Audio thread polling period.
+
+	/**
+	 * @brief Gets the singleton instance of the AudioEngine.
+	 * @return A reference to the single AudioEngine instance.
+	 */
+	static AudioEngine& getInstance();
+
+	/**
+	 * @brief Opens the audio device, creates the stream sources and starts the audio thread.
+	 * @param deviceName The OpenAL device to open, or nullptr for the default device.
+	 * @return False if the device or context cannot be created; the engine then stays silent.
+	 */
+	bool init( const char* deviceName = nullptr );
+	/**
+	 * @brief Stops every stream, joins the audio thread and closes the device.
+	 */
+	void shutdown();
+
+	/**
+	 * @brief Starts streaming a WAV file.
+	 * @param path The file to stream.
+	 * @param gain The target gain.
+	 * @param loop If true, the stream restarts at the end of the file.
+	 * @param fadeInSeconds Time to ramp from silence to gain.
+	 * @return A handle for later commands, or 0 if the engine is not running or the queue is full.
+	 */
+	StreamHandle playStream( const std::string& path, float gain = 1.0f, bool loop = false, float fadeInSeconds = 0.0f );
+	/**
+	 * @brief Stops a stream.
+	 * @param handle The stream to stop.
+	 * @param fadeOutSeconds Time to ramp to silence before stopping.
+	 */
+	void stopStream( StreamHandle handle, float fadeOutSeconds = 0.0f );
+	/**
+	 * @brief Changes the gain of a stream.
+	 * @param handle The stream to change.
+	 * @param gain The new target gain.
+	 * @param fadeSeconds Time to ramp to the new gain.
+	 */
+	void setStreamGain( StreamHandle handle, float gain, float fadeSeconds = 0.0f );
+	/**
+	 * @brief Switches the music track, crossfading from the current one. Music always loops.
+	 * @param path The new track.
+	 * @param crossfadeSeconds Time over which the old track fades out and the new one fades in.
+	 * @param gain The target gain of the new track.
+	 * @return The handle of the new track.
+	 */
+	StreamHandle playMusic( const std::string& path, float crossfadeSeconds = 1.5f, float gain = 1.0f );
+	/**
+	 * @brief Fades out the current music track.
+	 * @param fadeOutSeconds Time to ramp to silence.
+	 */
+	void stopMusic( float fadeOutSeconds = 1.5f );
+	/**
+	 * @brief Sets the gain applied on top of every stream.
+	 * @param gain The master gain.
+	 */
+	void setMasterGain( float gain );
+
+	/**
+	 * @brief Gets the number of streams currently playing or fading.
+	 * @return The active stream count, updated by the audio thread.
+	 */
+	int getActiveStreamCount() const { return activeStreams.load( std::memory_order_relaxed ); }
+	/**
+	 * @brief Gets the number of commands dropped because the queue was full.
+	 * @return The dropped command count.
+	 */
+	uint64_t getDroppedCommandCount() const { return droppedCommands; }
+	/**
+	 * @brief Gets the most memory one stream keeps resident, excluding OS read-ahead.
+	 * @return The queued buffers, the wrap-around scratch buffer and one buffer of mapped pages.
+	 */
+	static constexpr size_t getStreamMemoryBound() { return ( BUFFERS_PER_STREAM + 2 ) * BUFFER_BYTES; }
+	/**
+	 * @brief Checks if the engine is running.
+	 * @return True between a successful init and shutdown.
+	 */
+	bool isRunning() const { return running.load( std::memory_order_acquire ); }
+
+private:
+	static AudioEngine instance; // The single instance of the AudioEngine class, implementing the Singleton pattern.
+
+	static const size_t MAX_PATH_LENGTH = 256; // Longest path a command can carry, including the terminator.
+
+	/**
+	 * @brief The kinds of command sent to the audio thread.
+	 */
+	enum class CommandType : uint8_t
+	{
+		Play, // Start a stream.
+		PlayMusic, // Start a music stream, crossfading from the previous one.
+		Stop, // Fade out and stop a stream.
+		StopMusic, // Fade out and stop the music stream.
+		SetGain, // Ramp a stream to a new gain.
+		SetMasterGain // Change the master gain.
+	};
+
+	/**
+	 * @brief One game thread request. Fixed size so pushing never allocates.
+	 */
+	struct Command
+	{
+		CommandType type;
+		StreamHandle handle;
+		float gain;
+		float fadeSeconds;
+		bool loop;
+		char path[ MAX_PATH_LENGTH ];
+	};
+
+	/**
+	 * @brief The audio thread's state for one source and its buffer ring.
+	 */
+	struct Stream
+	{
+		ALuint source = 0; // The OpenAL source, created at init.
+		ALuint buffers[ BUFFERS_PER_STREAM ] = {}; // The buffer ring, created at init.
+		MappedFile file; // The streamed file.
+		WavData wav; // Layout of the streamed file.
+		std::vector<uint8_t> scratch; // Staging for buffers that wrap around the end of a looping file.
+		StreamHandle handle = 0; // 0 while the slot is free.
+		size_t cursor = 0; // Next byte of sample data to queue.
+		size_t released = 0; // Sample data before this byte has been released from memory.
+		float gain = 0.0f; // Current gain.
+		float targetGain = 0.0f; // Gain being ramped towards.
+		float fadeRate = 0.0f; // Gain change per second while ramping.
+		bool loop = false; // Restart at the end of the file.
+		bool stopping = false; // Free the slot once the gain reaches zero.
+		bool ended = false; // All sample data has been queued.
+	};
+
+	SpscQueue<Command, 256> commands; // Game thread to audio thread.
+	std::thread thread; // The audio thread.
+	std::atomic<bool> running{ false }; // Cleared to ask the audio thread to exit.
+	std::atomic<uint32_t> nextHandle{ 1 }; // Handles are allocated on the game thread.
+	std::atomic<int> activeStreams{ 0 }; // Published by the audio thread.
+	uint64_t droppedCommands = 0; // Game thread only.
+	ALCdevice* device = nullptr;
+	ALCcontext* context = nullptr;
+
+	// Audio thread only.
+	Stream streams[ MAX_STREAMS ];
+	StreamHandle musicHandle = 0; // The current music stream.
+	float masterGain = 1.0f;
+
+	AudioEngine() = default; // Private constructor for singleton.
+	~AudioEngine();
+	AudioEngine( const AudioEngine& ) = delete; // Delete copy constructor to prevent copying.
+	AudioEngine& operator=( const AudioEngine& ) = delete; // Delete assignment operator to prevent assignment.
+
+	/**
+	 * @brief Queues a command, counting it as dropped if the queue is full.
+	 * @param command The command to send.
+	 * @return True if the command was queued.
+	 */
+	bool send( const Command& command );
+	/**
+	 * @brief Body of the audio thread.
+	 */
+	void threadLoop();
+	/**
+	 * @brief Executes one command on the audio thread.
+	 * @param command The command to execute.
+	 */
+	void process( const Command& command );
+	/**
+	 * @brief Opens a file into a free slot and starts playing it.
+	 * @param command The Play or PlayMusic command.
+	 * @return The slot, or nullptr if the file cannot be streamed.
+	 */
+	Stream* start( const Command& command );
+	/**
+	 * @brief Refills processed buffers, advances fades and frees finished streams.
+	 * @param stream The stream to update.
+	 * @param dt Seconds since the last update.
+	 */
+	void update( Stream& stream, float dt );
+	/**
+	 * @brief Fills one buffer with the next chunk of the stream.
+	 * @param stream The stream to read from.
+	 * @param buffer The buffer to fill.
+	 * @return False if the stream has no data left.
+	 */
+	bool fill( Stream& stream, ALuint buffer );
+	/**
+	 * @brief Stops a stream's source and frees its slot.
+	 * @param stream The stream to free.
+	 */
+	void release( Stream& stream );
+	/**
+	 * @brief Finds the slot playing a handle.
+	 * @param handle The stream handle.
+	 * @return The slot, or nullptr if the stream already finished.
+	 */
+	Stream* find( StreamHandle handle );
+	/**
+	 * @brief Starts ramping a stream's gain.
+	 * @param stream The stream.
+	 * @param target The gain to reach.
+	 * @param seconds The ramp duration; 0 jumps immediately.
+	 */
+	static void fadeTo( Stream& stream, float target, float seconds );
+};
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <cstdint> // Required for fixed-width integer types.
+#include <vector> // Required for the node, column and agent arrays.
+
+#include <glm/glm.hpp> // Includes GLM for glm::vec2 focus and view positions.
+
+/**
+ * @brief The result of evaluating a node.
+ */
+enum class BtStatus : uint8_t
+{
+	Success,
+	Failure,
+	Running // An action that is still in progress; composites treat it as final for this tick.
+};
+
+/**
+ * @brief What a node does when evaluated.
+ */
+enum class BtNodeType : uint8_t
+{
+	Selector, // Evaluates children in order until one does not fail.
+	Sequence, // Evaluates children in order until one does not succeed.
+	Inverter, // Swaps the success and failure of its only child.
+	Condition, // Compares a blackboard value with a constant.
+	Action // Runs a registered action function.
+};
+
+/**
+ * @brief Comparison of a Condition node.
+ */
+enum class BtCompare : uint8_t
+{
+	Less, // Succeeds if the value is below the constant.
+	Greater // Succeeds if the value is above the constant.
+};
+
+/**
+ * @brief One node of a compiled tree.
+ *
+ * Nodes are stored in preorder, so a node's first child directly follows it
+ * and the next sibling of any node starts at its end index.
+ */
+struct BtNode
+{
+	BtNodeType type;
+	BtCompare compare; // Condition only.
+	uint16_t end; // Index one past the node's subtree.
+	uint16_t key; // Condition only: blackboard column.
+	uint16_t action; // Action only: index into the action table.
+	float value; // Condition only: constant compared against.
+};
+
+/**
+ * @brief Per-agent state of every agent running one tree, SoA.
+ *
+ * Each key is a column of floats with one entry per agent, so the values a
+ * batch of agents reads from one condition are contiguous.
+ */
+class Blackboard
+{
+public:
+	/**
+	 * @brief Adds a column.
+	 * @return The key of the column, used by condition nodes and actions.
+	 */
+	uint16_t addKey();
+	/**
+	 * @brief Adds an agent with every value set to 0.
+	 * @return The agent's row.
+	 */
+	uint32_t addAgent();
+
+	/**
+	 * @brief Gets a value.
+	 * @param key The column.
+	 * @param agent The row.
+	 * @return The value, writable.
+	 */
+	float& at( uint16_t key, uint32_t agent ) { return columns[ key ][ agent ]; }
+	float at( uint16_t key, uint32_t agent ) const { return columns[ key ][ agent ]; }
+	/**
+	 * @brief Gets a whole column.
+	 * @param key The column.
+	 * @return One value per agent.
+	 */
+	std::vector<float>& column( uint16_t key ) { return columns[ key ]; }
+	const std::vector<float>& column( uint16_t key ) const { return columns[ key ]; }
+
+	/**
+	 * @brief Gets the number of agents.
+	 * @return The row count.
+	 */
+	uint32_t getAgentCount() const { return agentCount; }
+	/**
+	 * @brief Gets the number of keys.
+	 * @return The column count.
+	 */
+	size_t getKeyCount() const { return columns.size(); }
+
+private:
+	std::vector<std::vector<float>> columns; // One column per key.
+	uint32_t agentCount = 0; // Rows of every column.
+};
+
+/**
+ * @brief What an action sees of the frame it runs in.
+ */
+struct AiTickContext
+{
+	uint64_t frame; // Frame number.
+	float dt; // Time since the agent was last evaluated, in seconds.
+	glm::vec2 focus; // The player's position.
+};
+
+/**
+ * @brief An action leaf. Must only touch its own agent's row, as agents are evaluated in parallel.
+ */
+using AiAction = BtStatus( * )( Blackboard& blackboard, uint32_t agent, const AiTickContext& context );
+
+/**
+ * @brief A behavior tree compiled into a flat preorder node array.
+ *
+ * Trees are built with the composite functions, each closed by end():
+ *
+ *     tree.selector();
+ *         tree.sequence();
+ *             tree.condition( DISTANCE, BtCompare::Less, 2.0f );
+ *             tree.action( ATTACK );
+ *         tree.end();
+ *         tree.action( CHASE );
+ *     tree.end();
+ *
+ * Evaluation walks the array by index; there are no node objects or
+ * pointers, so a whole tree usually fits in a few cache lines.
+ */
+class BehaviorTree
+{
+public:
+	/**
+	 * @brief Opens a selector node.
+	 */
+	void selector() { open( BtNodeType::Selector ); }
+	/**
+	 * @brief Opens a sequence node.
+	 */
+	void sequence() { open( BtNodeType::Sequence ); }
+	/**
+	 * @brief Opens an inverter node; give it exactly one child.
+	 */
+	void inverter() { open( BtNodeType::Inverter ); }
+	/**
+	 * @brief Closes the most recently opened composite.
+	 */
+	void end();
+	/**
+	 * @brief Adds a condition leaf.
+	 * @param key The blackboard column compared.
+	 * @param compare The comparison.
+	 * @param value The constant.
+	 */
+	void condition( uint16_t key, BtCompare compare, float value );
+	/**
+	 * @brief Adds an action leaf.
+	 * @param action Index into the action table passed to evaluate().
+	 */
+	void action( uint16_t action );
+
+	/**
+	 * @brief Checks that every composite was closed and the tree has a root.
+	 * @return True if the tree can be evaluated.
+	 */
+	bool isComplete() const { return !nodes.empty() && openNodes.empty(); }
+
+	/**
+	 * @brief Evaluates the tree for one agent.
+	 * @param blackboard The agents' state.
+	 * @param agent The agent's row.
+	 * @param context The frame.
+	 * @param actions The action table.
+	 * @param visits Incremented by the number of nodes evaluated.
+	 * @return The status of the root.
+	 */
+	BtStatus evaluate( Blackboard& blackboard, uint32_t agent, const AiTickContext& context, const std::vector<AiAction>& actions, uint32_t& visits ) const;
+
+	/**
+	 * @brief Gets the compiled nodes.
+	 * @return The nodes in preorder.
+	 */
+	const std::vector<BtNode>& getNodes() const { return nodes; }
+
+private:
+	std::vector<BtNode> nodes; // Preorder.
+	std::vector<uint16_t> openNodes; // Composites waiting for end().
+
+	/**
+	 * @brief Appends a composite and leaves it open.
+	 * @param type The composite type.
+	 */
+	void open( BtNodeType type );
+	/**
+	 * @brief Evaluates a subtree.
+	 * @param index The subtree's root node.
+	 * @return The status of the node.
+	 */
+	BtStatus evaluateNode( uint16_t index, Blackboard& blackboard, uint32_t agent, const AiTickContext& context, const std::vector<AiAction>& actions, uint32_t& visits ) const;
+};
+
+/**
+ * @brief How often an agent's tree runs, in frames.
+ */
+enum class AiLod : uint8_t
+{
+	Near = 1, // Visible or near the player: every frame.
+	Far = 4, // Off-screen: every 4 frames.
+	Dormant = 16 // Off-screen and far away: every 16 frames.
+};
+
+/**
+ * @brief Settings of the level of detail classification.
+ */
+struct AiLodSettings
+{
+	float nearRadius = 12.0f; // Agents closer to the focus than this are always Near.
+	float farRadius = 40.0f; // Off-screen agents beyond this are Dormant.
+	glm::vec2 viewHalfSize{ 16.0f, 9.0f }; // Half extents of the visible area around the focus.
+	bool enabled = true; // When false, every agent runs every frame.
+};
+
+/**
+ * @brief Counters of the last AiSystem::update().
+ */
+struct AiStats
+{
+	uint32_t agents = 0; // Agents in all groups.
+	uint32_t evaluated = 0; // Trees evaluated this frame.
+	uint32_t nodeVisits = 0; // Nodes evaluated this frame.
+	uint32_t lodCounts[ 3 ] = {}; // Agents at Near, Far and Dormant.
+};
+
+/**
+ * @brief Runs many agents' behavior trees with level of detail and batching.
+ *
+ * Agents are grouped by tree: each group owns a tree and a SoA blackboard for
+ * its agents, so one batch walks the same nodes over neighboring rows. Every
+ * update each agent's LOD is chosen from its distance to the focus and
+ * whether it is on screen; an agent with LOD n runs every n-th frame, with
+ * agents staggered so the load is even across frames, and receives the time
+ * accumulated since its last run as dt. The due agents of each group are
+ * evaluated in batches on the JobSystem.
+ *
+ * Call everything from the game thread. Actions run on workers and must only
+ * write their own agent's row.
+ */
+class AiSystem
+{
+public:
+	static const size_t BATCH_SIZE = 64; // Agents per job.
+
+	/**
+	 * @brief Registers an action.
+	 * @param action The action function.
+	 * @return The action index used by BehaviorTree::action().
+	 */
+	uint16_t addAction( AiAction action );
+	/**
+	 * @brief Adds a group of agents sharing a tree.
+	 * @param tree A complete tree.
+	 * @param blackboard The group's blackboard, with its keys already added.
+	 * @param positionX Blackboard key holding agent x positions, used for LOD.
+	 * @param positionY Blackboard key holding agent y positions.
+	 * @return The group index, or -1 if the tree is incomplete.
+	 */
+	int addGroup( const BehaviorTree& tree, const Blackboard& blackboard, uint16_t positionX, uint16_t positionY );
+	/**
+	 * @brief Adds an agent to a group.
+	 * @param group The group.
+	 * @return The agent's blackboard row.
+	 */
+	uint32_t addAgent( int group );
+
+	/**
+	 * @brief Classifies every agent and evaluates the trees that are due.
+	 * @param dt The frame time in seconds.
+	 * @param focus The player's position.
+	 */
+	void update( float dt, glm::vec2 focus );
+
+	/**
+	 * @brief Sets the LOD settings.
+	 * @param settings The new settings.
+	 */
+	void setLodSettings( const AiLodSettings& settings ) { lodSettings = settings; }
+	/**
+	 * @brief Gets a group's blackboard.
+	 * @param group The group.
+	 * @return The blackboard.
+	 */
+	Blackboard& getBlackboard( int group ) { return groups[ group ].blackboard; }
+	/**
+	 * @brief Gets the status an agent's tree returned when it last ran.
+	 * @param group The group.
+	 * @param agent The agent's row.
+	 * @return The root status.
+	 */
+	BtStatus getLastStatus( int group, uint32_t agent ) const { return groups[ group ].status[ agent ]; }
+	/**
+	 * @brief Gets the counters of the last update.
+	 * @return The statistics.
+	 */
+	const AiStats& getStats() const { return stats; }
+
+private:
+	/**
+	 * @brief Agents sharing one tree.
+	 */
+	struct Group
+	{
+		BehaviorTree tree;
+		Blackboard blackboard;
+		uint16_t positionX, positionY; // Blackboard keys of the position.
+		std::vector<uint8_t> lod; // AiLod per agent.
+		std::vector<uint8_t> phase; // Frame offset that staggers agents with the same LOD.
+		std::vector<float> pendingDt; // Time since the agent last ran.
+		std::vector<BtStatus> status; // Root status of the last run.
+		std::vector<uint32_t> due; // Agents evaluated this frame.
+		std::vector<uint32_t> batchVisits; // Node visits per batch of this frame.
+	};
+
+	std::vector<AiAction> actions; // Registered actions.
+	std::vector<Group> groups; // One per tree.
+	AiLodSettings lodSettings;
+	uint64_t frame = 0; // Frames updated.
+	AiStats stats;
+
+	/**
+	 * @brief Chooses the LOD of every agent of a group and collects the agents due this frame.
+	 * @param group The group.
+	 * @param dt The frame time.
+	 * @param focus The player's position.
+	 */
+	void schedule( Group& group, float dt, glm::vec2 focus );
+};
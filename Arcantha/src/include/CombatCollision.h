@@ -0,0 +1,317 @@
+#pragma once
+
+#include <cstdint> // Required for fixed-width integer types.
+#include <string> // Required for attack names.
+#include <vector> // Required for the frame-data and box arrays.
+
+#include <glm/glm.hpp> // Includes GLM for glm::vec2 positions and box extents.
+
+/**
+ * @brief What a combat box does when it overlaps another one.
+ */
+enum class BoxKind : uint8_t
+{
+	Hurt, // Can be hit. Every living combatant has one.
+	Hit, // Deals the attack's damage to hurt boxes.
+	Guard, // Blocks hits whose pierce is below the guard level.
+	Parry // Turns any hit back on the attacker.
+};
+
+/**
+ * @brief One authored box of an attack, present on a range of the attack's frames.
+ */
+struct FrameBox
+{
+	uint16_t firstFrame; // First frame (from the start of the attack) the box is present on.
+	uint16_t lastFrame; // Last frame the box is present on, inclusive.
+	BoxKind kind; // Hit, Guard or Parry.
+	glm::vec2 offset; // Center relative to the combatant, for a combatant facing right.
+	glm::vec2 halfSize; // Half extents.
+};
+
+/**
+ * @brief Frame data of one attack (or guard) at 60 ticks per second.
+ */
+struct AttackData
+{
+	std::string name; // Name used to look the attack up.
+	uint16_t totalFrames = 1; // Startup, active and recovery frames together.
+	float damage = 0.0f; // Damage of a clean hit.
+	uint8_t priority = 0; // When two hit boxes meet, the higher priority attack wins the clash.
+	uint8_t pierce = 0; // Guards with a level at or below this are broken through.
+	uint8_t guardLevel = 0; // Level of this move's guard boxes.
+	uint16_t hitStop = 0; // Frames attacker and defender freeze on a hit.
+	uint16_t hitStun = 0; // Frames the defender is stunned (and its own attack cancelled) by a hit.
+	uint16_t blockStun = 0; // Frames the defender is stunned when blocking this attack.
+	uint16_t parryStun = 0; // Frames the attacker is stunned when this attack is parried.
+	std::vector<FrameBox> boxes; // Hit, guard and parry boxes by frame.
+};
+
+/**
+ * @brief The authored frame data of every attack, indexed by attack id.
+ */
+class FrameDataTable
+{
+public:
+	/**
+	 * @brief Adds an attack.
+	 * @param attack The frame data.
+	 * @return The attack id.
+	 */
+	uint16_t add( const AttackData& attack );
+	/**
+	 * @brief Finds an attack by name.
+	 * @param name The attack name.
+	 * @return The attack id, or INVALID if there is no such attack.
+	 */
+	uint16_t find( const std::string& name ) const;
+	/**
+	 * @brief Gets an attack.
+	 * @param id The attack id.
+	 * @return The frame data.
+	 */
+	const AttackData& get( uint16_t id ) const { return attacks[ id ]; }
+	/**
+	 * @brief Gets the number of attacks.
+	 * @return The attack count.
+	 */
+	size_t size() const { return attacks.size(); }
+
+	/**
+	 * @brief Creates the standard moveset: light, heavy, spear, shield and parry.
+	 * @return The table.
+	 */
+	static FrameDataTable createDefault();
+
+	static const uint16_t INVALID = 0xFFFF; // Returned by find() for unknown names.
+
+private:
+	std::vector<AttackData> attacks; // Frame data, indexed by attack id.
+};
+
+/**
+ * @brief The outcome of one attack connecting with one defender.
+ */
+enum class CombatEventType : uint8_t
+{
+	Hit, // Damage dealt; both sides freeze for the attack's hit-stop.
+	Blocked, // A guard stopped the hit; the defender is block-stunned.
+	GuardBreak, // The attack pierced the guard; counts as a hit.
+	Parried, // The defender parried; the attacker is stunned.
+	Clash // Two hit boxes met; the lower priority attack (or both, if equal) is cancelled.
+};
+
+/**
+ * @brief One resolved interaction of a tick.
+ */
+struct CombatEvent
+{
+	CombatEventType type;
+	uint32_t attacker; // Combatant whose hit box connected (for a clash, the winner or the lower id).
+	uint32_t defender; // Combatant that was hit, blocked or parried.
+	uint16_t attack; // The attacker's attack id.
+	float damage; // Damage dealt (0 unless Hit or GuardBreak).
+};
+
+/**
+ * @brief The boxes of the current tick, SoA so overlap tests run four at a time.
+ */
+struct CombatBoxes
+{
+	std::vector<float> minX, minY, maxX, maxY; // Extents, sorted by minX, followed by 4 never-overlapping pad boxes.
+	std::vector<uint32_t> owner; // Combatant owning each box.
+	std::vector<uint8_t> team; // Team of the owner.
+	std::vector<BoxKind> kind; // What each box does.
+
+	/**
+	 * @brief Removes every box.
+	 */
+	void clear();
+	/**
+	 * @brief Appends a box.
+	 * @param x0 Minimum x.
+	 * @param y0 Minimum y.
+	 * @param x1 Maximum x.
+	 * @param y1 Maximum y.
+	 * @param boxOwner Combatant owning the box.
+	 * @param boxTeam Team of the owner.
+	 * @param boxKind What the box does.
+	 */
+	void push( float x0, float y0, float x1, float y1, uint32_t boxOwner, uint8_t boxTeam, BoxKind boxKind );
+	/**
+	 * @brief Gets the number of boxes.
+	 * @return The box count, not counting the padding.
+	 */
+	size_t size() const { return owner.size(); }
+};
+
+/**
+ * @brief Figures of the last tick.
+ */
+struct CombatStats
+{
+	size_t hitBoxes = 0; // Active hit boxes.
+	size_t targetBoxes = 0; // Hurt, guard, parry and hit boxes hit boxes were tested against.
+	size_t candidatePairs = 0; // Pairs whose boxes overlap, before team and ownership filtering.
+	size_t contacts = 0; // Overlaps between enemies that involve a hit box.
+	size_t events = 0; // Events produced.
+};
+
+/**
+ * @brief Frame-exact hit detection for melee combat, outside the physics broadphase.
+ *
+ * Combatants play attacks from a FrameDataTable. Every tick only the boxes
+ * active on that frame are gathered into flat SoA arrays: hit boxes on one
+ * side, hurt, guard, parry and hit boxes on the other. Both arrays are sorted
+ * on X and swept against each other (sweep-and-prune), testing four boxes per
+ * SIMD instruction. All contacts of the tick are then resolved in one batched
+ * pass: per attacker and defender, a parry beats a guard, which beats a
+ * hurt box. Effects (damage, hit-stop, stuns, cancelled attacks) are applied
+ * together afterwards, so the outcome does not depend on processing order.
+ */
+class CombatCollision
+{
+public:
+	/**
+	 * @brief Constructor for the CombatCollision class.
+	 * @param table The frame data; must outlive this object.
+	 */
+	explicit CombatCollision( const FrameDataTable& table );
+
+	/**
+	 * @brief Adds a combatant.
+	 * @param position The position of the combatant's center.
+	 * @param hurtHalfSize Half extents of its hurt box.
+	 * @param team Combatants on the same team never hit each other.
+	 * @param health Starting health; the hurt box disappears at 0.
+	 * @return The combatant id.
+	 */
+	uint32_t addCombatant( glm::vec2 position, glm::vec2 hurtHalfSize, uint8_t team, float health = 100.0f );
+	/**
+	 * @brief Moves a combatant. Call before tick().
+	 * @param id The combatant.
+	 * @param position The new center.
+	 * @param facingLeft True to mirror its boxes.
+	 */
+	void setPosition( uint32_t id, glm::vec2 position, bool facingLeft );
+	/**
+	 * @brief Starts an attack (or a guard).
+	 * @param id The combatant.
+	 * @param attack The attack id.
+	 * @return False if the combatant is dead, stunned, frozen or already attacking.
+	 */
+	bool startAttack( uint32_t id, uint16_t attack );
+
+	/**
+	 * @brief Advances every combatant by one frame and resolves the frame's contacts.
+	 */
+	void tick();
+
+	/**
+	 * @brief Gets the events of the last tick, sorted by attacker then defender.
+	 * @return The events.
+	 */
+	const std::vector<CombatEvent>& getEvents() const { return events; }
+	/**
+	 * @brief Gets the hit boxes of the last tick.
+	 * @return The hit boxes, sorted on X.
+	 */
+	const CombatBoxes& getHitBoxes() const { return hitBoxes; }
+	/**
+	 * @brief Gets the boxes the hit boxes of the last tick were tested against.
+	 * @return The hurt, guard, parry and hit boxes, sorted on X.
+	 */
+	const CombatBoxes& getTargetBoxes() const { return targetBoxes; }
+	/**
+	 * @brief Gets the figures of the last tick.
+	 * @return The stats.
+	 */
+	const CombatStats& getStats() const { return stats; }
+
+	/**
+	 * @brief Checks if a combatant can act.
+	 * @param id The combatant.
+	 * @return True if it is alive, not attacking, not stunned and not frozen.
+	 */
+	bool isIdle( uint32_t id ) const;
+	/**
+	 * @brief Gets the hit-stop frames left on a combatant.
+	 * @param id The combatant.
+	 * @return Frames it stays frozen for.
+	 */
+	int getHitStop( uint32_t id ) const { return hitStop[ id ]; }
+	/**
+	 * @brief Gets a combatant's health.
+	 * @param id The combatant.
+	 * @return The remaining health.
+	 */
+	float getHealth( uint32_t id ) const { return health[ id ]; }
+	/**
+	 * @brief Gets the number of combatants.
+	 * @return The combatant count.
+	 */
+	size_t getCombatantCount() const { return positionX.size(); }
+
+private:
+	/**
+	 * @brief An overlap between an attacker's hit box and a box of an enemy.
+	 */
+	struct Contact
+	{
+		uint32_t attacker;
+		uint32_t defender;
+		BoxKind kind; // The defender's box kind.
+	};
+
+	const FrameDataTable& table; // The frame data.
+
+	// Combatant state, SoA.
+	std::vector<float> positionX, positionY;
+	std::vector<float> hurtHalfX, hurtHalfY;
+	std::vector<uint8_t> team;
+	std::vector<uint8_t> facingLeft;
+	std::vector<float> health;
+	std::vector<uint16_t> attack; // Current attack, or FrameDataTable::INVALID.
+	std::vector<uint16_t> frame; // Frame of the current attack; starts one before 0 so the next tick plays frame 0.
+	std::vector<uint16_t> hitStop; // Frozen frames left; attacks do not advance while frozen.
+	std::vector<uint16_t> stun; // Stunned frames left; cannot attack.
+	std::vector<std::vector<uint32_t>> victims; // Combatants the current attack already connected with.
+
+	CombatBoxes hitBoxes; // Active hit boxes of this tick.
+	CombatBoxes targetBoxes; // Everything hit boxes can connect with.
+	CombatBoxes unsorted; // Gather scratch.
+	std::vector<uint32_t> order; // Sort scratch.
+	std::vector<uint8_t> cancel; // Attacks cancelled by this tick's resolution, applied after it.
+	std::vector<Contact> contacts; // Overlaps of this tick.
+	std::vector<CombatEvent> events; // Resolved events of this tick.
+	CombatStats stats; // Figures of the last tick.
+
+	/**
+	 * @brief Advances attack frames, hit-stop and stun counters.
+	 */
+	void advance();
+	/**
+	 * @brief Collects the boxes present on this frame and sorts both sets on X.
+	 */
+	void gatherBoxes();
+	/**
+	 * @brief Sorts a gathered box set on minX into a destination and pads it.
+	 * @param source The gathered boxes.
+	 * @param destination Receives the sorted, padded boxes.
+	 */
+	void sortBoxes( const CombatBoxes& source, CombatBoxes& destination );
+	/**
+	 * @brief Sweeps the hit boxes against the target boxes and fills contacts.
+	 */
+	void sweep();
+	/**
+	 * @brief Resolves all contacts of the tick and applies their effects.
+	 */
+	void resolve();
+	/**
+	 * @brief Records a box pair found by the sweep if it is an interaction between enemies.
+	 * @param hit Index into hitBoxes.
+	 * @param target Index into targetBoxes.
+	 */
+	void addContact( uint32_t hit, uint32_t target );
+};
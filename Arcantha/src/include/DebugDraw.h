@@ -0,0 +1,285 @@
+#pragma once
+
+#include <cstdint> // Required for fixed-width integer types.
+#include <string> // Required for std::string labels.
+
+#include <box2d/box2d.h> // Includes Box2D for b2Draw, b2World and the math types.
+
+// Debug drawing is compiled in unless NDEBUG is set; define ARCANTHA_DEBUG_DRAW to 0 or 1 to override.
+// When it is 0 every call below is an empty inline function and nothing else is built.
+#ifndef ARCANTHA_DEBUG_DRAW
+#ifdef NDEBUG
+#define ARCANTHA_DEBUG_DRAW 0
+#else
+#define ARCANTHA_DEBUG_DRAW 1
+#endif
+#endif
+
+#if ARCANTHA_DEBUG_DRAW
+#include <memory> // Required for std::unique_ptr thread buffers.
+#include <mutex> // Required to guard thread buffer registration.
+#include <vector> // Required for the vertex arrays.
+
+#include "TextRenderer.h" // Includes the TextRenderer that draws labels.
+#endif
+
+/**
+ * @brief Counters of the last flush().
+ */
+struct DebugDrawStats
+{
+	uint32_t lines = 0; // Line segments drawn.
+	uint32_t triangles = 0; // Filled triangles drawn.
+	uint32_t texts = 0; // Labels drawn.
+	uint32_t culled = 0; // Primitives rejected because they were outside the camera.
+	uint32_t threads = 0; // Threads that submitted primitives.
+	uint32_t batches = 0; // Non-empty batches (lines, triangles, text); one draw call each with GL.
+	uint32_t drawCalls = 0; // Draw calls issued.
+};
+
+#if ARCANTHA_DEBUG_DRAW
+
+/**
+ * @brief Batched debug drawing for Box2D and gameplay overlays.
+ *
+ * This class implements the Singleton design pattern. It is a b2Draw, so it
+ * can be registered with b2World::SetDebugDraw(), and adds a gameplay API for
+ * lines, AABBs, circles and labels. The main thread and the JobSystem workers
+ * may draw: each appends to the buffers of its JobSystem thread index without
+ * locking. Other threads share index 0 with the main thread and must not draw.
+ * Primitives outside the camera are rejected as they are submitted, and
+ * drawWorld() finds the fixtures in view through the broadphase instead of
+ * visiting every body.
+ *
+ * flush() runs on the render thread once all drawing threads are done for
+ * the frame. It uploads every thread's triangles and lines into one buffer
+ * and issues at most three draw calls: triangles, lines and labels.
+ *
+ * Without initGL() flush() discards the primitives, so the CPU side can be
+ * measured headless. Set ARCANTHA_DEBUG_DRAW to 0 to compile it out.
+ */
+class DebugDraw : public b2Draw
+{
+public:
+	/**
+	 * @brief Gets the singleton instance of the DebugDraw.
+	 * @return A reference to the single DebugDraw instance.
+	 */
+	static DebugDraw& getInstance();
+
+	/**
+	 * @brief Creates the shader and buffers. Requires a current OpenGL 3.3 context.
+	 * @return False if the shader fails to compile.
+	 */
+	bool initGL();
+	/**
+	 * @brief Deletes the GL objects. Requires the context that initGL() ran with.
+	 */
+	void shutdownGL();
+	/**
+	 * @brief Loads the font labels are drawn with; without one labels are skipped.
+	 * @param path The .ttf file.
+	 * @return False if the font cannot be loaded.
+	 */
+	bool loadFont( const std::string& path );
+
+	/**
+	 * @brief Sets the visible area. Call before drawing each frame.
+	 * @param min Bottom left corner in meters.
+	 * @param max Top right corner in meters.
+	 * @param pixelsPerMeter Screen scale, used for circle detail and label sizes.
+	 */
+	void setCamera( const b2Vec2& min, const b2Vec2& max, float pixelsPerMeter );
+	/**
+	 * @brief Enables or disables culling, e.g. to measure its effect.
+	 * @param enabled False to keep every primitive and visit every body.
+	 */
+	void setCulling( bool enabled ) { culling = enabled; }
+
+	/**
+	 * @brief Draws a line.
+	 * @param a Start in meters.
+	 * @param b End in meters.
+	 * @param color RGBA8, red in the lowest byte.
+	 */
+	void line( const b2Vec2& a, const b2Vec2& b, uint32_t color );
+	/**
+	 * @brief Draws a box outline.
+	 * @param box The box in meters.
+	 * @param color RGBA8.
+	 */
+	void aabb( const b2AABB& box, uint32_t color );
+	/**
+	 * @brief Draws a circle outline.
+	 * @param center Center in meters.
+	 * @param radius Radius in meters.
+	 * @param color RGBA8.
+	 */
+	void circle( const b2Vec2& center, float radius, uint32_t color );
+	/**
+	 * @brief Draws a label.
+	 * @param label UTF-8 text.
+	 * @param position Baseline start in meters.
+	 * @param pixels Text height in screen pixels.
+	 * @param color RGBA8.
+	 */
+	void text( const std::string& label, const b2Vec2& position, float pixels, uint32_t color );
+	/**
+	 * @brief Draws the fixtures of a world that are in view.
+	 * @param world The world.
+	 * @param flags b2Draw::e_shapeBit for shapes, b2Draw::e_aabbBit for fixture AABBs.
+	 */
+	void drawWorld( const b2World& world, uint32_t flags = e_shapeBit );
+
+	/**
+	 * @brief Draws everything submitted since the last flush and clears the buffers.
+	 *
+	 * Call on the render thread while no other thread is drawing.
+	 */
+	void flush();
+	/**
+	 * @brief Gets the counters.
+	 * @return The statistics of the last flush().
+	 */
+	const DebugDrawStats& getStats() const { return stats; }
+
+	void DrawPolygon( const b2Vec2* vertices, int32 vertexCount, const b2Color& color ) override;
+	void DrawSolidPolygon( const b2Vec2* vertices, int32 vertexCount, const b2Color& color ) override;
+	void DrawCircle( const b2Vec2& center, float radius, const b2Color& color ) override;
+	void DrawSolidCircle( const b2Vec2& center, float radius, const b2Vec2& axis, const b2Color& color ) override;
+	void DrawSegment( const b2Vec2& p1, const b2Vec2& p2, const b2Color& color ) override;
+	void DrawTransform( const b2Transform& xf ) override;
+	void DrawPoint( const b2Vec2& p, float size, const b2Color& color ) override;
+
+private:
+	static DebugDraw instance; // The single instance of the DebugDraw class, implementing the Singleton pattern.
+
+	/**
+	 * @brief A colored vertex, as uploaded to the GPU.
+	 */
+	struct Vertex
+	{
+		float x, y;
+		uint32_t color;
+	};
+
+	/**
+	 * @brief A queued label.
+	 */
+	struct Label
+	{
+		std::string text;
+		b2Vec2 position;
+		float pixels;
+		uint32_t color;
+	};
+
+	/**
+	 * @brief The primitives one thread submitted this frame.
+	 */
+	struct ThreadBuffer
+	{
+		std::vector<Vertex> lines; // Two per segment.
+		std::vector<Vertex> triangles; // Three per triangle.
+		std::vector<Label> labels;
+		uint32_t culled = 0;
+	};
+
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers; // Indexed by JobSystem thread index; null for threads that never drew.
+	std::mutex buffersMutex; // Guards registration.
+
+	b2AABB camera = { b2Vec2( -1e9f, -1e9f ), b2Vec2( 1e9f, 1e9f ) };
+	float pixelsPerMeter = 32.0f;
+	bool culling = true;
+	TextRenderer textRenderer; // Labels, fed on the render thread.
+	bool hasFont = false;
+	DebugDrawStats stats;
+
+	unsigned int program = 0, vao = 0, vbo = 0; // GL objects.
+	int projectionLocation = -1;
+	bool glReady = false;
+
+	DebugDraw(); // Private constructor for singleton.
+	~DebugDraw() = default;
+	DebugDraw( const DebugDraw& ) = delete;
+	DebugDraw& operator=( const DebugDraw& ) = delete;
+
+	/**
+	 * @brief Gets the buffers of the calling thread's JobSystem index, creating them on first use.
+	 * @return The buffers.
+	 */
+	ThreadBuffer& getBuffer();
+	/**
+	 * @brief Tests bounds against the camera, counting a rejection.
+	 * @param lower Bottom left of the bounds.
+	 * @param upper Top right of the bounds.
+	 * @param buffer The calling thread's buffers.
+	 * @return True if the bounds are visible.
+	 */
+	bool isVisible( const b2Vec2& lower, const b2Vec2& upper, ThreadBuffer& buffer ) const;
+	/**
+	 * @brief Appends a polygon outline and optionally a translucent fill, already culled.
+	 * @param vertices The polygon, CCW.
+	 * @param count Number of vertices.
+	 * @param color RGBA8 outline; the fill uses half its alpha.
+	 * @param solid True to add the fill.
+	 * @param buffer The calling thread's buffers.
+	 */
+	void appendPolygon( const b2Vec2* vertices, int count, uint32_t color, bool solid, ThreadBuffer& buffer );
+	/**
+	 * @brief Appends a circle outline and optionally a translucent fill, already culled.
+	 * @param center Center in meters.
+	 * @param radius Radius in meters.
+	 * @param color RGBA8 outline; the fill uses half its alpha.
+	 * @param solid True to add the fill.
+	 * @param buffer The calling thread's buffers.
+	 */
+	void appendCircle( const b2Vec2& center, float radius, uint32_t color, bool solid, ThreadBuffer& buffer );
+	/**
+	 * @brief Appends one fixture's shape in world space.
+	 * @param fixture The fixture.
+	 * @param color RGBA8.
+	 * @param buffer The calling thread's buffers.
+	 */
+	void appendFixture( const b2Fixture& fixture, uint32_t color, ThreadBuffer& buffer );
+};
+
+#else
+
+/**
+ * @brief Compiled-out debug drawing: every call does nothing.
+ */
+class DebugDraw : public b2Draw
+{
+public:
+	static DebugDraw& getInstance() {
+		static DebugDraw instance;
+		return instance;
+	}
+
+	bool initGL() { return true; }
+	void shutdownGL() {}
+	bool loadFont( const std::string& ) { return true; }
+	void setCamera( const b2Vec2&, const b2Vec2&, float ) {}
+	void setCulling( bool ) {}
+	void line( const b2Vec2&, const b2Vec2&, uint32_t ) {}
+	void aabb( const b2AABB&, uint32_t ) {}
+	void circle( const b2Vec2&, float, uint32_t ) {}
+	void text( const std::string&, const b2Vec2&, float, uint32_t ) {}
+	void drawWorld( const b2World&, uint32_t = e_shapeBit ) {}
+	void flush() {}
+	const DebugDrawStats& getStats() const { return stats; }
+
+	void DrawPolygon( const b2Vec2*, int32, const b2Color& ) override {}
+	void DrawSolidPolygon( const b2Vec2*, int32, const b2Color& ) override {}
+	void DrawCircle( const b2Vec2&, float, const b2Color& ) override {}
+	void DrawSolidCircle( const b2Vec2&, float, const b2Vec2&, const b2Color& ) override {}
+	void DrawSegment( const b2Vec2&, const b2Vec2&, const b2Color& ) override {}
+	void DrawTransform( const b2Transform& ) override {}
+	void DrawPoint( const b2Vec2&, float, const b2Color& ) override {}
+
+private:
+	DebugDrawStats stats;
+};
+
+#endif
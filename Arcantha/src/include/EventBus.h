@@ -0,0 +1,345 @@
+#pragma once
+
+#include <atomic> // Required for the once-per-type error flags.
+#include <cstdint> // Required for fixed-width integer types.
+#include <functional> // Required for std::function to store subscribers.
+#include <memory> // Required for std::unique_ptr to own queues and thread buffers.
+#include <mutex> // Required to guard thread buffer registration.
+#include <string> // Required for event type names.
+#include <typeinfo> // Required to name unregistered event types in errors.
+#include <vector> // Required for the event queues.
+
+/**
+ * @brief The points of a frame at which gameplay events are delivered, in frame order.
+ */
+enum class EventPhase : uint8_t
+{
+	Input, // After input is polled, before the simulation.
+	Simulation, // After gameplay logic, before physics.
+	PostPhysics, // After the physics step; contacts, damage and deaths.
+	Presentation // Before rendering; HUD, audio and effects.
+};
+
+static const size_t EVENT_PHASE_COUNT = 4;
+
+/**
+ * @brief A contiguous run of events of one type, handed to a subscriber at once.
+ */
+template <typename T>
+struct EventBatch
+{
+	const T* events = nullptr;
+	size_t count = 0;
+
+	const T* begin() const { return events; }
+	const T* end() const { return events + count; }
+	size_t size() const { return count; }
+	const T& operator[]( size_t i ) const { return events[ i ]; }
+};
+
+/**
+ * @brief Counters and timing of one event type over the last frame.
+ */
+struct EventTypeStats
+{
+	std::string name;
+	uint32_t subscribers = 0;
+	uint64_t posted = 0; // Events posted.
+	uint64_t delivered = 0; // Events handed to subscribers; an event counts once per subscriber.
+	uint32_t calls = 0; // Subscriber calls; one per subscriber and delivery with events.
+	double deliverMs = 0.0; // Time spent in this type's subscribers.
+	uint64_t totalPosted = 0; // Since startup.
+};
+
+/**
+ * @brief Totals of the last frame over every event type.
+ */
+struct EventBusStats
+{
+	uint64_t posted = 0;
+	uint64_t delivered = 0;
+	uint32_t calls = 0;
+	double deliverMs = 0.0; // Whole deliver() calls, including collecting the thread buffers.
+	uint32_t threads = 0; // Threads that have posted events since startup.
+};
+
+using SubscriberID = unsigned long long;
+
+/**
+ * @brief Batched, phase-ordered delivery of gameplay events.
+ *
+ * This class implements the Singleton design pattern. Gameplay events
+ * (damage dealt, enemy killed, door opened, parry succeeded) are plain
+ * structs, registered once by type with registerType(). post() appends an
+ * event to the calling thread's queue for its type, so job workers post
+ * without locking and no subscriber ever runs inside the code that posts.
+ *
+ * deliver( phase ) runs on the main thread at fixed points of the frame,
+ * once every posting thread is done for that part of the frame. It moves
+ * the thread queues into one contiguous batch per type (main thread first,
+ * then workers by index) and calls that phase's subscribers in subscription
+ * order, each with every event of its type it has not seen yet. Events
+ * posted by a subscriber are therefore seen by later phases of the same
+ * frame, or by earlier phases next frame; every subscriber receives every
+ * event exactly once. Unlike the EventDispatcher's immediate listeners, a
+ * subscriber iterates a whole batch and can never be re-entered.
+ *
+ * Posted, delivered and timing figures per type are published at endFrame()
+ * for the debug overlay.
+ */
+class EventBus
+{
+public:
+	/**
+	 * @brief Gets the singleton instance of the EventBus.
+	 * @return A reference to the single EventBus instance.
+	 */
+	static EventBus& getInstance();
+
+	/**
+	 * @brief Registers an event type. Call on the main thread, before any thread posts it.
+	 * @param name Name of the type in the statistics.
+	 */
+	template <typename T>
+	void registerType( const std::string& name );
+
+	/**
+	 * @brief Queues an event for the next delivery. Safe from any thread.
+	 *
+	 * Events of an unregistered type are dropped; the first drop of each type is logged.
+	 * @param event The event, copied.
+	 */
+	template <typename T>
+	void post( const T& event ) {
+		std::vector<T>* queue = getQueue<T>();
+		if ( queue ) queue->push_back( event );
+	}
+	/**
+	 * @brief Queues several events for the next delivery. Safe from any thread.
+	 * @param events The events, copied.
+	 * @param count The number of events.
+	 */
+	template <typename T>
+	void post( const T* events, size_t count ) {
+		std::vector<T>* queue = getQueue<T>();
+		if ( queue ) queue->insert( queue->end(), events, events + count );
+	}
+
+	/**
+	 * @brief Registers a subscriber for an event type. Call on the main thread.
+	 * @param phase The phase the subscriber is called in.
+	 * @param func Called with the events posted since its last call; not called without any.
+	 * @return Unique ID for the subscriber (for unsubscribing), or 0 if the type is not registered.
+	 */
+	template <typename T>
+	SubscriberID subscribe( EventPhase phase, std::function<void( const EventBatch<T>& )> func );
+	/**
+	 * @brief Removes a subscriber. Call on the main thread; may be called from a subscriber.
+	 * @param id Unique ID of the subscriber.
+	 * @return Bool to indicate success or failure to remove.
+	 */
+	bool unsubscribe( SubscriberID id );
+
+	/**
+	 * @brief Collects every thread's events and calls the phase's subscribers. Call on the main thread.
+	 * @param phase The phase of the frame that has been reached.
+	 */
+	void deliver( EventPhase phase );
+	/**
+	 * @brief Publishes the frame's statistics and drops events every subscriber has seen.
+	 */
+	void endFrame();
+	/**
+	 * @brief Drops every queued event. Types and subscribers are kept.
+	 */
+	void clear();
+
+	/**
+	 * @brief Gets the statistics of the last frame, indexed like the registered types.
+	 * @return One entry per registered type.
+	 */
+	const std::vector<EventTypeStats>& getTypeStats() const { return typeStats; }
+	/**
+	 * @brief Gets the totals of the last frame.
+	 * @return The statistics.
+	 */
+	const EventBusStats& getStats() const { return stats; }
+
+private:
+	static EventBus instance; // The single instance of the EventBus class, implementing the Singleton pattern.
+
+	/**
+	 * @brief The events of one type, type-erased so types can be handled together.
+	 */
+	struct QueueBase
+	{
+		virtual ~QueueBase() = default;
+		virtual size_t size() const = 0;
+		virtual void clear() = 0;
+		virtual void moveTo( QueueBase& target ) = 0; // Appends every event to target, then clears.
+		virtual void discard( size_t count ) = 0; // Removes the first count events.
+	};
+
+	template <typename T>
+	struct Queue : QueueBase
+	{
+		std::vector<T> events;
+
+		size_t size() const override { return events.size(); }
+		void clear() override { events.clear(); }
+		void moveTo( QueueBase& target ) override {
+			std::vector<T>& to = static_cast< Queue<T>& >( target ).events;
+			to.insert( to.end(), events.begin(), events.end() );
+			events.clear();
+		}
+		void discard( size_t count ) override { events.erase( events.begin(), events.begin() + count ); }
+	};
+
+	/**
+	 * @brief A registered event type: its batch of the frame.
+	 */
+	struct Channel
+	{
+		std::unique_ptr<QueueBase> batch; // Collected events, not yet seen by every subscriber.
+		std::unique_ptr<QueueBase>( *create )() = nullptr; // Makes an empty queue of this type.
+	};
+
+	/**
+	 * @brief A subscriber and how far into its type's batch it has read.
+	 */
+	struct Subscriber
+	{
+		SubscriberID id;
+		uint32_t type;
+		EventPhase phase;
+		std::function<void( const QueueBase&, size_t )> call; // Called with the batch and the first unseen event.
+		size_t cursor; // Events of the batch already delivered.
+		bool active;
+	};
+
+	/**
+	 * @brief The events one thread has posted since the last delivery, one queue per type.
+	 */
+	struct ThreadBuffer
+	{
+		int threadIndex = 0; // JobSystem thread index; orders the buffers.
+		std::vector<std::unique_ptr<QueueBase>> queues;
+	};
+
+	std::vector<Channel> channels; // By type index; empty for types of no interest.
+	std::vector<Subscriber> subscribers; // In subscription order.
+	std::vector<Subscriber> added; // Subscribed during a delivery; joined after it.
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers; // One per thread that has posted, by thread index; kept for the process lifetime.
+	std::mutex buffersMutex; // Guards registration.
+	SubscriberID nextID = 0;
+	bool delivering = false;
+
+	std::vector<EventTypeStats> frameStats; // Accumulated over the current frame.
+	std::vector<EventTypeStats> typeStats; // Of the last frame.
+	EventBusStats frameTotals, stats;
+
+	EventBus() = default; // Private constructor for singleton.
+	~EventBus() = default;
+	EventBus( const EventBus& ) = delete;
+	EventBus& operator=( const EventBus& ) = delete;
+
+	/**
+	 * @brief Hands out a new index for every event type, in first-use order.
+	 * @return The next index.
+	 */
+	static uint32_t nextTypeIndex();
+	/**
+	 * @brief Gets the index of an event type, the same in every translation unit.
+	 * @return The index.
+	 */
+	template <typename T>
+	static uint32_t typeIndex() {
+		static const uint32_t index = nextTypeIndex();
+		return index;
+	}
+	/**
+	 * @brief Logs the use of an unregistered event type.
+	 * @param action What was attempted, e.g. "Posting".
+	 * @param typeName The compiler's name of the type.
+	 */
+	static void logUnregistered( const char* action, const char* typeName );
+	/**
+	 * @brief Reports the use of an unregistered event type, only the first time for each type.
+	 * @param action What was attempted, e.g. "Posting".
+	 */
+	template <typename T>
+	static void reportUnregistered( const char* action ) {
+		static std::atomic<bool> reported{ false };
+		if ( !reported.load( std::memory_order_relaxed ) && !reported.exchange( true, std::memory_order_relaxed ) ) {
+			logUnregistered( action, typeid( T ).name() );
+		}
+	}
+	/**
+	 * @brief Gets the calling thread's buffers, registering them on first use.
+	 * @return The buffers.
+	 */
+	ThreadBuffer& getBuffer();
+	/**
+	 * @brief Gets the calling thread's queue of an event type, creating it on first use.
+	 * @return The queue, or nullptr if the type was never registered.
+	 */
+	template <typename T>
+	std::vector<T>* getQueue();
+	/**
+	 * @brief Moves every thread's events into the batches of their types.
+	 */
+	void collect();
+};
+
+template <typename T>
+void EventBus::registerType( const std::string& name ) {
+	const uint32_t index = typeIndex<T>();
+	if ( channels.size() <= index ) {
+		channels.resize( index + 1 );
+		frameStats.resize( index + 1 );
+		typeStats.resize( index + 1 );
+	}
+	if ( channels[ index ].batch ) return;
+	channels[ index ].create = []() { return std::unique_ptr<QueueBase>( new Queue<T>() ); };
+	channels[ index ].batch = channels[ index ].create();
+	frameStats[ index ].name = name;
+	typeStats[ index ].name = name;
+}
+
+template <typename T>
+SubscriberID EventBus::subscribe( EventPhase phase, std::function<void( const EventBatch<T>& )> func ) {
+	const uint32_t index = typeIndex<T>();
+	if ( index >= channels.size() || !channels[ index ].batch ) {
+		reportUnregistered<T>( "Subscribing to" );
+		return 0;
+	}
+	Subscriber subscriber;
+	subscriber.id = ++nextID;
+	subscriber.type = index;
+	subscriber.phase = phase;
+	subscriber.call = [ func ]( const QueueBase& batch, size_t first ) {
+		const std::vector<T>& events = static_cast< const Queue<T>& >( batch ).events;
+		EventBatch<T> view;
+		view.events = events.data() + first;
+		view.count = events.size() - first;
+		func( view );
+	};
+	subscriber.cursor = channels[ index ].batch->size(); // Only events collected from now on.
+	subscriber.active = true;
+	frameStats[ index ].subscribers++;
+	( delivering ? added : subscribers ).push_back( std::move( subscriber ) );
+	return nextID;
+}
+
+template <typename T>
+std::vector<T>* EventBus::getQueue() {
+	const uint32_t index = typeIndex<T>();
+	if ( index >= channels.size() || !channels[ index ].batch ) {
+		reportUnregistered<T>( "Posting" );
+		return nullptr;
+	}
+	ThreadBuffer& buffer = getBuffer();
+	if ( buffer.queues.size() <= index ) buffer.queues.resize( index + 1 );
+	if ( !buffer.queues[ index ] ) buffer.queues[ index ] = channels[ index ].create();
+	return &static_cast< Queue<T>& >( *buffer.queues[ index ] ).events;
+}
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <cstdint> // Required for fixed-width integer types.
+#include <functional> // Required for std::function canvas painters.
+#include <string> // Required for std::string labels.
+#include <vector> // Required for the widget and vertex arrays.
+
+#include <glm/glm.hpp> // Includes GLM for glm::mat4 projections.
+
+#include "TextRenderer.h" // Includes the TextRenderer that draws counter text.
+
+/**
+ * @brief A rectangle in HUD pixels, origin at the bottom left, y up.
+ */
+struct HudRect
+{
+	float x, y, width, height;
+
+	bool overlaps( const HudRect& other ) const {
+		return x < other.x + other.width && other.x < x + width && y < other.y + other.height && other.y < y + height;
+	}
+};
+
+/**
+ * @brief One corner of a HUD quad, as uploaded to the GPU.
+ */
+struct HudVertex
+{
+	float x, y; // Position in HUD pixels.
+	float u, v; // Texture coordinates, used by textured passes.
+	uint32_t color; // RGBA8, red in the lowest byte, straight alpha.
+};
+
+/**
+ * @brief Builds the quads of a canvas widget while it is redrawn.
+ */
+class HudPainter
+{
+public:
+	/**
+	 * @brief Constructor for the HudPainter class.
+	 * @param vertices The array quads are appended to.
+	 */
+	explicit HudPainter( std::vector<HudVertex>& vertices ) : vertices( vertices ) {}
+
+	/**
+	 * @brief Adds a solid rectangle; keep it inside the widget's rectangle.
+	 * @param rect The rectangle.
+	 * @param color RGBA8, red in the lowest byte.
+	 */
+	void fill( const HudRect& rect, uint32_t color );
+
+private:
+	std::vector<HudVertex>& vertices;
+};
+
+/**
+ * @brief Paints a canvas widget, e.g. the minimap.
+ */
+using HudPaint = std::function<void( HudPainter& painter, const HudRect& rect )>;
+
+/**
+ * @brief Kinds of HUD widget.
+ */
+enum class HudWidgetType : uint8_t
+{
+	Panel, // A static background, drawn into the cached static layer.
+	Bar, // A fill bar such as health or stamina.
+	Counter, // A label and a number, such as a currency.
+	Canvas // Custom quads from a HudPaint callback.
+};
+
+/**
+ * @brief Counters of the last frame (or since creation, for the cumulative ones).
+ */
+struct HudStats
+{
+	double cpuMs = 0.0; // CPU time of the last render(), including GL submission.
+	double gpuMs = 0.0; // GPU time of a recent frame's HUD passes, read back a few frames late; 0 without GL.
+	uint32_t widgetsRedrawn = 0; // Widgets rebuilt this frame.
+	uint32_t quads = 0; // Quads rebuilt this frame, text included.
+	uint32_t drawCalls = 0; // Draw calls issued by the last render().
+	uint64_t staticRedraws = 0; // Times the static layer was rebuilt.
+};
+
+/**
+ * @brief Retained-mode HUD: widgets are redrawn into cached textures only when they change.
+ *
+ * Widgets form a tree through their parent index and are positioned relative
+ * to their parent. Panels are drawn once into a static layer texture. Every
+ * other widget is drawn into the HUD texture on top of a copy of the static
+ * layer, and only when it was invalidated: setBar() and setCounter() do so
+ * only if the change is visible (a bar's fill moves by a whole pixel, a
+ * counter's value differs), canvases through invalidate(). A redrawn widget
+ * also redraws the clean widgets it overlaps, so its rectangle can be
+ * restored from the static layer and drawn again from scratch. Each frame
+ * the HUD texture is composited over the scene with one draw; frames where
+ * nothing changed issue nothing else.
+ *
+ * Without initGL() render() still does all CPU work, so the cost of the
+ * widget updates can be measured headless.
+ */
+class Hud
+{
+public:
+	static const uint16_t NO_PARENT = 0xFFFF; // Parent index of top-level widgets.
+	static const uint32_t MAX_QUADS = 16384; // Quads per pass; more are dropped.
+	static const int GPU_QUERIES = 4; // Timer queries in flight; GPU time is read this many frames late.
+
+	Hud() = default;
+	Hud( const Hud& ) = delete;
+	Hud& operator=( const Hud& ) = delete;
+
+	/**
+	 * @brief Loads the font counters are drawn with.
+	 * @param path The .ttf file.
+	 * @return False if the font cannot be loaded.
+	 */
+	bool loadFont( const std::string& path );
+	/**
+	 * @brief Creates the shader, buffers and cached render targets. Requires a current OpenGL 3.3 context.
+	 * @param width The HUD's width in pixels.
+	 * @param height The HUD's height in pixels.
+	 * @return False if the shader or a render target cannot be created.
+	 */
+	bool initGL( int width, int height );
+	/**
+	 * @brief Deletes the GL objects. Requires the context that initGL() ran with.
+	 */
+	void shutdownGL();
+	/**
+	 * @brief Resizes the HUD and its render targets; everything is redrawn.
+	 * @param width The new width in pixels.
+	 * @param height The new height in pixels.
+	 */
+	void resize( int width, int height );
+
+	/**
+	 * @brief Adds a panel.
+	 * @param parent The parent widget, or NO_PARENT.
+	 * @param rect Position relative to the parent and size.
+	 * @param color Fill color, RGBA8.
+	 * @param borderColor One pixel border color, RGBA8; 0 for none.
+	 * @return The widget index.
+	 */
+	uint16_t addPanel( uint16_t parent, const HudRect& rect, uint32_t color, uint32_t borderColor = 0 );
+	/**
+	 * @brief Adds a fill bar, initially full.
+	 * @param parent The parent widget, or NO_PARENT.
+	 * @param rect Position relative to the parent and size.
+	 * @param fillColor Color of the filled part.
+	 * @param backColor Color of the empty part.
+	 * @return The widget index.
+	 */
+	uint16_t addBar( uint16_t parent, const HudRect& rect, uint32_t fillColor, uint32_t backColor );
+	/**
+	 * @brief Adds a counter showing a label and a number.
+	 * @param parent The parent widget, or NO_PARENT.
+	 * @param rect Position relative to the parent and size; the text is sized to its height, and shrunk to its width if longer.
+	 * @param label Text before the number.
+	 * @param color Text color.
+	 * @return The widget index.
+	 */
+	uint16_t addCounter( uint16_t parent, const HudRect& rect, const std::string& label, uint32_t color );
+	/**
+	 * @brief Adds a canvas painted by a callback.
+	 * @param parent The parent widget, or NO_PARENT.
+	 * @param rect Position relative to the parent and size.
+	 * @param paint Called with the absolute rectangle whenever the canvas is redrawn.
+	 * @return The widget index.
+	 */
+	uint16_t addCanvas( uint16_t parent, const HudRect& rect, HudPaint paint );
+
+	/**
+	 * @brief Sets a bar's value; redraws it only if its fill changes by a pixel or more.
+	 * @param widget The bar.
+	 * @param value The current value.
+	 * @param maximum The value of a full bar.
+	 */
+	void setBar( uint16_t widget, float value, float maximum );
+	/**
+	 * @brief Sets a counter's number; redraws it only if the number changes.
+	 * @param widget The counter.
+	 * @param value The number.
+	 */
+	void setCounter( uint16_t widget, int64_t value );
+	/**
+	 * @brief Marks a widget for redrawing; invalidating a panel rebuilds the static layer.
+	 * @param widget The widget.
+	 */
+	void invalidate( uint16_t widget );
+
+	/**
+	 * @brief Redraws what changed into the cached textures and composites the HUD over the bound framebuffer.
+	 */
+	void render();
+
+	/**
+	 * @brief Redraws every widget every frame, as an immediate-mode HUD would, e.g. to measure the difference.
+	 * @param enabled True to disable the caching.
+	 */
+	void setImmediateMode( bool enabled ) { immediateMode = enabled; }
+	/**
+	 * @brief Gets the counters.
+	 * @return The statistics.
+	 */
+	const HudStats& getStats() const { return stats; }
+	/**
+	 * @brief Gets a widget's absolute rectangle.
+	 * @param widget The widget.
+	 * @return The rectangle in HUD pixels.
+	 */
+	const HudRect& getRect( uint16_t widget ) const { return widgets[ widget ].rect; }
+
+private:
+	/**
+	 * @brief A widget of the tree.
+	 */
+	struct Widget
+	{
+		HudWidgetType type;
+		uint16_t parent;
+		HudRect rect; // Absolute.
+		uint32_t color; // Panel fill, bar fill or text color.
+		uint32_t secondColor; // Panel border or bar background.
+		int fillPixels; // Bars: filled width in whole pixels.
+		int64_t value; // Counters: the number shown.
+		std::string label; // Counters: the label.
+		std::string text; // Counters: label and number, rebuilt when the number changes.
+		HudPaint paint; // Canvases: the painter.
+		bool dirty;
+	};
+
+	std::vector<Widget> widgets;
+	int width = 0, height = 0;
+	bool staticDirty = true; // The static layer needs rebuilding, which redraws everything.
+	bool immediateMode = false;
+	TextRenderer text; // Counter text; drawn into the HUD texture.
+
+	std::vector<HudVertex> staticVertices; // Panels.
+	std::vector<HudVertex> restoreVertices; // Static layer copies under redrawn widgets.
+	std::vector<HudVertex> widgetVertices; // Redrawn widgets.
+	std::vector<uint16_t> redraw; // Widgets redrawn this frame.
+	HudStats stats;
+
+	unsigned int program = 0, vao = 0, vbo = 0, ebo = 0; // GL objects.
+	unsigned int staticFbo = 0, staticTexture = 0; // Cached panels.
+	unsigned int hudFbo = 0, hudTexture = 0; // Cached HUD, composited each frame.
+	unsigned int queries[ GPU_QUERIES ] = {}; // GL_TIME_ELAPSED queries, used round robin.
+	bool queryPending[ GPU_QUERIES ] = {};
+	int queryIndex = 0;
+	int projectionLocation = -1, texturedLocation = -1;
+	bool glReady = false;
+
+	/**
+	 * @brief Adds a widget, converting its rectangle to absolute coordinates.
+	 * @param type The widget type.
+	 * @param parent The parent widget, or NO_PARENT.
+	 * @param rect Position relative to the parent and size.
+	 * @return The widget.
+	 */
+	Widget& addWidget( HudWidgetType type, uint16_t parent, const HudRect& rect );
+	/**
+	 * @brief Appends a widget's quads and text.
+	 * @param widget The widget.
+	 */
+	void buildWidget( Widget& widget );
+	/**
+	 * @brief Creates or recreates the two render targets at the current size.
+	 * @return False if a framebuffer is incomplete.
+	 */
+	bool createTargets();
+	/**
+	 * @brief Draws vertices with the HUD shader.
+	 * @param vertices Four per quad.
+	 * @param texture Texture to sample, or 0 for solid color.
+	 */
+	void draw( const std::vector<HudVertex>& vertices, unsigned int texture );
+};
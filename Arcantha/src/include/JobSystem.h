@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic> // Required for the job completion counters.
+#include <condition_variable> // Required to park idle worker threads.
+#include <cstddef> // Required for size_t.
+#include <deque> // Required for the job queue.
+#include <functional> // Required for std::function to store jobs.
+#include <mutex> // Required to guard the job queue.
+#include <thread> // Required for the worker threads.
+#include <vector> // Required for std::vector to hold the workers.
+
+/**
+ * @brief Tracks completion of a group of submitted jobs.
+ */
+struct JobCounter
+{
+	std::atomic<int> pending{ 0 }; // Number of jobs still running or queued.
+};
+
+/**
+ * @brief A fixed pool of worker threads shared by every engine subsystem.
+ *
+ * This class implements the Singleton design pattern. Callers that wait on
+ * work help instead of blocking, but only with their own work: wait() runs
+ * queued jobs tracked by the same counter and parallelFor runs chunks of its
+ * own loop. Nested parallel work cannot deadlock the pool, and a wait on the
+ * game thread never picks up an unrelated background job. With zero workers
+ * every job simply runs inline on the calling thread.
+ */
+class JobSystem
+{
+public:
+	/**
+	 * @brief Gets the singleton instance of the JobSystem.
+	 * @return A reference to the single JobSystem instance.
+	 */
+	static JobSystem& getInstance();
+
+	/**
+	 * @brief Starts the worker threads.
+	 * @param workerCount The number of workers, or -1 to use one less than the hardware thread count.
+	 */
+	void init( int workerCount = -1 );
+	/**
+	 * @brief Finishes all queued jobs and joins the worker threads.
+	 */
+	void shutdown();
+
+	/**
+	 * @brief Queues a job for a worker thread.
+	 * @param job The job to run.
+	 * @param counter Optional counter incremented now and decremented when the job finishes.
+	 */
+	void submit( std::function<void()> job, JobCounter* counter = nullptr );
+	/**
+	 * @brief Waits for every job tracked by a counter, running its queued jobs meanwhile.
+	 * @param counter The counter to wait on.
+	 */
+	void wait( JobCounter& counter );
+	/**
+	 * @brief Splits [0, count) into chunks and runs them across the pool, blocking until all finish.
+	 *
+	 * The caller runs chunks too and returns once every chunk has finished,
+	 * without waiting for helper jobs that have not started yet.
+	 *
+	 * Chunk boundaries depend only on count and grain, never on the number of
+	 * threads, so per-chunk output is reproducible across machines.
+	 * @param count The number of items.
+	 * @param grain The number of items per chunk.
+	 * @param func Called as func( begin, end ) for every chunk.
+	 */
+	void parallelFor( size_t count, size_t grain, const std::function<void( size_t, size_t )>& func );
+
+	/**
+	 * @brief Gets the number of worker threads.
+	 * @return The worker count (0 if not initialized).
+	 */
+	int getWorkerCount() const { return static_cast< int >( workers.size() ); }
+	/**
+	 * @brief Gets the index of the calling thread.
+	 * @return 0 for any non-worker thread, 1..getWorkerCount() for workers.
+	 */
+	static int getThreadIndex();
+
+private:
+	static JobSystem instance; // The single instance of the JobSystem class, implementing the Singleton pattern.
+
+	/**
+	 * @brief A queued job with its optional completion counter.
+	 */
+	struct Job
+	{
+		std::function<void()> func;
+		JobCounter* counter;
+	};
+
+	std::vector<std::thread> workers; // Worker threads.
+	std::deque<Job> queue; // Pending jobs, FIFO.
+	std::mutex queueMutex; // Guards queue and running.
+	std::condition_variable queueCondition; // Wakes idle workers.
+	bool running = false; // False once shutdown has been requested.
+
+	JobSystem() = default; // Private constructor for singleton.
+	~JobSystem();
+	JobSystem( const JobSystem& ) = delete; // Delete copy constructor to prevent copying.
+	JobSystem& operator=( const JobSystem& ) = delete; // Delete assignment operator to prevent assignment.
+
+	/**
+	 * @brief Pops one queued job and runs it on the calling thread.
+	 * @param counter Only run a job tracked by this counter, or nullptr for any job.
+	 * @return True if a job was run, false if there was none.
+	 */
+	bool runOne( const JobCounter* counter = nullptr );
+	/**
+	 * @brief Runs a job and signals its counter.
+	 * @param job The job to run.
+	 */
+	static void execute( Job& job );
+	/**
+	 * @brief Body of every worker thread.
+	 * @param index The thread index of the worker (1-based).
+	 */
+	void workerLoop( int index );
+};
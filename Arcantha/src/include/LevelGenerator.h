@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstdint> // Required for fixed-width integer types.
+#include <vector> // Required for std::vector to store rooms, decorations and spawns.
+
+#include <glm/glm.hpp> // Includes GLM for glm::ivec2 cell and tile coordinates.
+
+#include "JobSystem.h" // Includes the JobCounter that tracks background generation.
+#include "TileMap.h" // Includes the TileMap the level geometry is written to.
+
+/**
+ * @brief The role a room plays in a level's layout.
+ */
+enum class RoomKind : uint8_t
+{
+	Start, // Where the player enters; never has enemies.
+	Normal, // Ordinary room along the way.
+	Shaft, // Vertical connector, entered from above or below.
+	Arena, // Larger fight with more enemies.
+	Treasure, // Dead end of a side branch.
+	Boss // The far end of the main path.
+};
+
+/**
+ * @brief Purely visual dressing placed on a tile, stored in a layer beside the TileMap.
+ */
+enum class Decoration : uint8_t
+{
+	None = 0,
+	Grass, // On top of a floor.
+	Moss, // On a solid tile next to open space.
+	Vines, // Hanging under a ceiling.
+	Stalactite, // Hanging under a ceiling.
+	Torch, // On a floor, mostly in fight rooms.
+	Crystal // On a floor in treasure rooms.
+};
+
+/**
+ * @brief The enemy types the generator can place; they match the navigation archetypes.
+ */
+enum class EnemyKind : uint8_t
+{
+	Grunt, // Walker.
+	Leaper, // Jumps further and higher than a grunt.
+	Flyer, // Ignores the ground.
+	Brute // Boss room heavy, walks like a grunt.
+};
+
+/**
+ * @brief Door bits of a room, one per side of its cell.
+ */
+enum RoomDoor : uint8_t
+{
+	DOOR_LEFT = 1,
+	DOOR_RIGHT = 2,
+	DOOR_DOWN = 4,
+	DOOR_UP = 8
+};
+
+/**
+ * @brief Parameters of a generated level.
+ */
+struct LevelSettings
+{
+	int gridWidth = 8; // Width of the room grid in cells.
+	int gridHeight = 6; // Height of the room grid in cells.
+	int mainPathLength = 14; // Rooms from the start to the boss, if the walk does not get stuck.
+	int branchCount = 8; // Side branches grown off the main path.
+	int layoutCandidates = 8; // Layouts generated in parallel; the best scoring one is kept.
+	int difficulty = 1; // Scales enemy counts.
+};
+
+/**
+ * @brief One room of a level, occupying one cell of the room grid.
+ */
+struct LevelRoom
+{
+	glm::ivec2 cell; // Position in the room grid.
+	RoomKind kind; // Role in the layout.
+	uint8_t doors; // RoomDoor bits.
+	uint16_t depth; // Rooms between this one and the start.
+	uint16_t templateIndex; // The template stitched into this room.
+	bool mirrored; // True if the template was flipped horizontally.
+};
+
+/**
+ * @brief Where an enemy appears when its room is first entered.
+ */
+struct EnemySpawn
+{
+	glm::ivec2 tile; // Tile the enemy stands in (or hovers in, for flyers).
+	EnemyKind kind; // Enemy type.
+	uint16_t room; // Index of the room in Level::rooms.
+};
+
+/**
+ * @brief Wall time spent in each generation stage, in milliseconds.
+ */
+struct LevelTimings
+{
+	double layoutMs = 0.0;
+	double stitchMs = 0.0;
+	double decorateMs = 0.0;
+	double populateMs = 0.0;
+};
+
+/**
+ * @brief A fully generated level.
+ */
+struct Level
+{
+	static const int ROOM_WIDTH = 32; // Width of one room cell in tiles.
+	static const int ROOM_HEIGHT = 18; // Height of one room cell in tiles.
+
+	uint64_t seed = 0; // The seed the level was generated from.
+	LevelSettings settings; // The settings the level was generated with.
+	std::vector<LevelRoom> rooms; // Main path first, starting with the start room, then branch rooms.
+	std::vector<int16_t> cellToRoom; // Room index of every grid cell, or -1.
+	TileMap map{ 0, 0 }; // Level geometry; cells without a room are solid rock.
+	std::vector<Decoration> decorations; // One entry per tile of map, row-major.
+	std::vector<EnemySpawn> enemies; // Enemy spawns, grouped by room in room order.
+	glm::ivec2 playerSpawn{ 0, 0 }; // Tile the player enters at.
+
+	/**
+	 * @brief Hashes everything the generator produced.
+	 *
+	 * Two levels with the same seed and settings must hash the same no matter
+	 * how many threads generated them; the benchmark relies on this.
+	 * @return A 64-bit FNV-1a hash of the level.
+	 */
+	uint64_t hash() const;
+};
+
+/**
+ * @brief Seeded procedural level generator.
+ *
+ * Generation runs four stages: room graph layout, room template stitching,
+ * tile decoration and enemy placement. Layout runs several candidate layouts
+ * in parallel and keeps the best; the other stages run one job per room.
+ * Every work item draws from its own Random derived from the level seed and
+ * the item's index, and writes only its own room's tiles, so the result is
+ * bit-identical for a given seed regardless of the number of worker threads.
+ *
+ * generateAsync() runs the same pipeline on the JobSystem in the background,
+ * e.g. while the player is in the hub, so the transition does not stall.
+ */
+class LevelGenerator
+{
+public:
+	LevelGenerator() = default;
+	/**
+	 * @brief Destructor; waits for a background generation still in flight.
+	 */
+	~LevelGenerator();
+	LevelGenerator( const LevelGenerator& ) = delete;
+	LevelGenerator& operator=( const LevelGenerator& ) = delete;
+
+	/**
+	 * @brief Generates a level on the calling thread, spreading each stage across the JobSystem.
+	 * @param seed The level seed.
+	 * @param settings The level parameters.
+	 * @param timings Optional output for the time spent in each stage.
+	 * @return The generated level.
+	 */
+	static Level generate( uint64_t seed, const LevelSettings& settings = LevelSettings(), LevelTimings* timings = nullptr );
+
+	/**
+	 * @brief Starts generating a level in the background. Waits for any previous generation first.
+	 * @param seed The level seed.
+	 * @param settings The level parameters.
+	 */
+	void generateAsync( uint64_t seed, const LevelSettings& settings = LevelSettings() );
+	/**
+	 * @brief Checks if the background generation has finished.
+	 * @return True if a level is ready to take (or nothing was started).
+	 */
+	bool isReady() const { return counter.pending.load( std::memory_order_acquire ) == 0; }
+	/**
+	 * @brief Takes the background generated level, waiting for it if it is not ready yet.
+	 * @return The generated level.
+	 */
+	Level take();
+
+private:
+	Level result; // Written by the background job, read after it finishes.
+	JobCounter counter; // Tracks the background job.
+};
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <cstdint> // Required for fixed-width integer types.
+#include <vector> // Required for the chunk, light and polygon arrays.
+
+#include <glm/glm.hpp> // Includes GLM for glm::vec2 positions and glm::mat4 projections.
+
+#include "TileMap.h" // Includes the TileMap whose solid tiles cast shadows.
+
+/**
+ * @brief A shadow-casting boundary between a solid and an open tile.
+ *
+ * Oriented so the open side is on the left: a light can only see the edge
+ * when cross( b - a, light - a ) is positive.
+ */
+struct LightEdge
+{
+	glm::vec2 a, b; // Endpoints in meters.
+};
+
+/**
+ * @brief The settings of one point light.
+ */
+struct Light2DSettings
+{
+	glm::vec2 position = glm::vec2( 0.0f ); // Meters.
+	float radius = 8.0f; // Meters; the light falls off to nothing here.
+	uint32_t color = 0xFF60B0FFu; // ABGR, as uploaded.
+	float intensity = 1.0f;
+	bool dynamic = false; // Dynamic lights are recomputed every update(); static ones only when tiles near them change.
+};
+
+/**
+ * @brief One vertex of a light's visibility fan, as the renderer reads it.
+ */
+struct LightVertex
+{
+	float x, y; // Meters.
+	float centerX, centerY; // The light's position.
+	float radius;
+	uint32_t color; // ABGR.
+	float intensity;
+};
+
+/**
+ * @brief Counters of the last Lighting2D::update() and writeVertices().
+ */
+struct Lighting2DStats
+{
+	uint32_t lights = 0; // Enabled lights.
+	uint32_t computed = 0; // Visibility polygons computed this update.
+	uint32_t cached = 0; // Static lights whose cached polygon was reused.
+	uint32_t invalidated = 0; // Static lights invalidated by tile changes since the previous update.
+	uint32_t chunks = 0; // Chunks re-extracted since the previous update.
+	uint32_t edges = 0; // Occluder edges over every chunk.
+	uint64_t edgesGathered = 0; // Edges the computed lights cast rays against.
+	uint32_t vertices = 0; // Vertices of the last writeVertices().
+	double updateMs = 0.0;
+	double writeMs = 0.0;
+};
+
+/**
+ * @brief Point lights with tile shadows, drawn into a reduced-resolution light buffer.
+ *
+ * The solid tiles' boundaries are extracted once per chunk of CHUNK_TILES x
+ * CHUNK_TILES tiles, with runs along a row or column merged into one edge,
+ * and only re-extracted for the chunks a tile change touches. A light's
+ * visibility polygon is cast against the front-facing edges of the chunks
+ * within its radius, so its cost does not grow with the size of the room.
+ *
+ * Static lights keep their polygon until invalidateTiles() changes tiles in
+ * their radius or they move; dynamic lights are recomputed every update().
+ * Both are computed in parallel batches on the JobSystem.
+ *
+ * render() draws every polygon as a fan with radial falloff into a light
+ * buffer at 1 / divisor of the viewport, cleared to the ambient color, and
+ * multiplies the scene by it.
+ *
+ * Call everything from the game thread.
+ */
+class Lighting2D
+{
+public:
+	static const int CHUNK_TILES = 16; // Chunk side in tiles.
+	static const size_t BATCH_SIZE = 4; // Lights per job.
+
+	Lighting2D() = default;
+	Lighting2D( const Lighting2D& ) = delete;
+	Lighting2D& operator=( const Lighting2D& ) = delete;
+
+	/**
+	 * @brief Creates the shaders, buffers and light buffer. Requires a current OpenGL 3.3 context.
+	 * @param width Viewport width in pixels.
+	 * @param height Viewport height in pixels.
+	 * @return False if a shader fails to compile or the light buffer is incomplete.
+	 */
+	bool initGL( int width, int height );
+	/**
+	 * @brief Deletes the GL objects. Requires the context that initGL() ran with.
+	 */
+	void shutdownGL();
+	/**
+	 * @brief Resizes the light buffer to a new viewport.
+	 * @param width Viewport width in pixels.
+	 * @param height Viewport height in pixels.
+	 */
+	void resize( int width, int height );
+	/**
+	 * @brief Sets how much smaller than the viewport the light buffer is.
+	 * @param divisor 1 for full resolution, 2 for half, and so on.
+	 */
+	void setResolutionDivisor( int divisor );
+	/**
+	 * @brief Sets the light of unlit areas.
+	 * @param color ABGR.
+	 */
+	void setAmbient( uint32_t color ) { ambient = color; }
+
+	/**
+	 * @brief Extracts the occluder edges of every chunk and invalidates every static light.
+	 * @param map The room; must outlive this system or be replaced. nullptr removes every occluder.
+	 */
+	void setTileMap( const TileMap* map );
+	/**
+	 * @brief Re-extracts the chunks around changed tiles and invalidates the static lights that reach them.
+	 * @param rect The tiles that changed, already written to the map.
+	 */
+	void invalidateTiles( const TileRect& rect );
+
+	/**
+	 * @brief Adds a light.
+	 * @param settings The light.
+	 * @return The light index.
+	 */
+	uint32_t addLight( const Light2DSettings& settings );
+	/**
+	 * @brief Moves a light; a static light is recomputed by the next update().
+	 * @param light The light.
+	 * @param position Meters.
+	 */
+	void setLightPosition( uint32_t light, const glm::vec2& position );
+	/**
+	 * @brief Turns a light on or off.
+	 * @param light The light.
+	 * @param enabled False to skip it in update() and render().
+	 */
+	void setLightEnabled( uint32_t light, bool enabled );
+
+	/**
+	 * @brief Computes the visibility polygons of the dynamic lights and the invalidated static lights.
+	 */
+	void update();
+	/**
+	 * @brief Writes every enabled light's visibility fan as triangles.
+	 * @param out Room for getVertexCount() vertices.
+	 * @return The number written.
+	 */
+	uint32_t writeVertices( LightVertex* out );
+	/**
+	 * @brief Draws the lights into the light buffer and multiplies the bound framebuffer by it; requires initGL().
+	 * @param projection Transforms meters to clip space.
+	 */
+	void render( const glm::mat4& projection );
+
+	/**
+	 * @brief Gets the number of vertices writeVertices() writes.
+	 * @return Three per polygon point of every enabled light.
+	 */
+	uint32_t getVertexCount() const;
+	/**
+	 * @brief Gets a light's visibility polygon from its last computation.
+	 * @param light The light.
+	 * @return Points around the light in counterclockwise order.
+	 */
+	const std::vector<glm::vec2>& getVisibility( uint32_t light ) const { return lights[ light ].polygon; }
+	/**
+	 * @brief Gets the number of lights.
+	 * @return The count, enabled or not.
+	 */
+	uint32_t getLightCount() const { return static_cast< uint32_t >( lights.size() ); }
+	/**
+	 * @brief Gets the counters.
+	 * @return The statistics.
+	 */
+	const Lighting2DStats& getStats() const { return stats; }
+
+	/**
+	 * @brief Extracts the boundaries between solid and open tiles in an area.
+	 * @param map The room; tiles outside it count as solid.
+	 * @param area The tiles whose solid faces are extracted.
+	 * @param merge True to join runs along a row or column into one edge.
+	 * @param out Receives the edges; appended to.
+	 */
+	static void extractEdges( const TileMap& map, const TileRect& area, bool merge, std::vector<LightEdge>& out );
+	/**
+	 * @brief Computes a visibility polygon by casting rays at the edge endpoints.
+	 *
+	 * The light's bounding square closes the polygon where nothing blocks it.
+	 * @param center The light's position.
+	 * @param radius The light's radius.
+	 * @param edges Front-facing edges near the light.
+	 * @param count The number of edges.
+	 * @param out Receives the polygon; cleared first.
+	 */
+	static void computeVisibility( const glm::vec2& center, float radius, const LightEdge* edges, size_t count, std::vector<glm::vec2>& out );
+
+private:
+	/**
+	 * @brief The occluder edges of a chunk of tiles.
+	 */
+	struct Chunk
+	{
+		std::vector<LightEdge> edges;
+	};
+
+	/**
+	 * @brief A light and its cached polygon.
+	 */
+	struct Light
+	{
+		Light2DSettings settings;
+		std::vector<glm::vec2> polygon;
+		bool enabled = true;
+		bool dirty = true; // The polygon is stale.
+	};
+
+	const TileMap* map = nullptr;
+	float tileSize = 1.0f;
+	int chunksWide = 0, chunksHigh = 0;
+	std::vector<Chunk> chunks; // Row-major.
+	std::vector<Light> lights;
+	std::vector<uint32_t> work; // Lights update() computes.
+	std::vector<uint64_t> batchEdges; // Edges gathered per batch of this update.
+	std::vector<uint32_t> vertexOffsets; // Per light, from the prefix sum of writeVertices().
+	uint32_t edgeCount = 0; // Over every chunk.
+	uint32_t invalidatedSince = 0, chunksSince = 0; // Since the previous update().
+	uint32_t ambient = 0xFF301818u;
+	int divisor = 2;
+	int viewWidth = 1, viewHeight = 1;
+	Lighting2DStats stats;
+	unsigned int lightProgram = 0, compositeProgram = 0, vao = 0, vbo = 0, emptyVao = 0; // GL objects.
+	unsigned int fbo = 0, texture = 0; // The light buffer.
+	uint32_t vertexCapacity = 0; // Vertices the buffer holds.
+	int projectionLocation = -1, lightTextureLocation = -1;
+	bool glReady = false;
+
+	/**
+	 * @brief Extracts one chunk's edges from the map.
+	 * @param cx The chunk column.
+	 * @param cy The chunk row.
+	 */
+	void extractChunk( int cx, int cy );
+	/**
+	 * @brief Collects the front-facing edges within a light's radius.
+	 * @param light The light.
+	 * @param out Receives the edges; cleared first.
+	 */
+	void gatherEdges( const Light2DSettings& light, std::vector<LightEdge>& out ) const;
+	/**
+	 * @brief (Re)creates the light buffer at the current size and divisor.
+	 * @return False if the framebuffer is incomplete.
+	 */
+	bool createTarget();
+};
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <cstdint> // Required for fixed-width integer types.
+#include <unordered_map> // Required for the shape cache.
+#include <vector> // Required for the bolt, shape and segment arrays.
+
+#include <glm/glm.hpp> // Includes GLM for glm::vec2 positions and glm::mat4 projections.
+
+/**
+ * @brief One segment of a cached bolt shape, laid out as two RGBA32F texels for the shader.
+ *
+ * Shapes run from (0, 0) to (1, 0): x is along the bolt and y across it, in
+ * units of the bolt's displacement. Point ids let the shader jitter both
+ * segments that share a point by the same amount.
+ */
+struct LightningSegment
+{
+	float ax, ay, aWidth, aId; // Start point, width scale and id.
+	float bx, by, bWidth, bId; // End point, width scale and id.
+};
+
+/**
+ * @brief One bolt as the renderer reads it: one instance of its shape's segment quads.
+ */
+struct LightningInstance
+{
+	float startX, startY, endX, endY; // Endpoints in meters.
+	float width; // Core width in meters.
+	float displacement; // Meters across the bolt per unit of shape y.
+	float seed; // Varies the shader jitter between bolts sharing a shape.
+	float fade; // 1 when struck, 0 when expired.
+	uint32_t color; // RGBA8, red in the lowest byte.
+	int32_t firstSegment; // Shape start in the segment buffer.
+	int32_t segmentCount; // Shape length.
+	int32_t padding;
+};
+
+/**
+ * @brief How a bolt looks and how long it lasts.
+ */
+struct LightningBoltSettings
+{
+	glm::vec2 start = glm::vec2( 0.0f ); // Endpoints in meters.
+	glm::vec2 end = glm::vec2( 0.0f, -5.0f );
+	float width = 0.12f; // Core width in meters; branches are thinner.
+	float displacement = 0.18f; // How far the bolt strays from the line, as a fraction of its length.
+	float roughness = 0.5f; // 0 to 1; how much of the displacement each subdivision keeps.
+	float branching = 0.3f; // 0 to 1; chance of forking at a subdivision.
+	float duration = 0.25f; // Seconds until it fades out.
+	uint32_t color = 0xFFFFD0A0u; // RGBA8.
+	uint32_t seed = 0; // Picks the shape variant and the jitter pattern.
+};
+
+/**
+ * @brief Counters of the last update() and writeInstances().
+ */
+struct LightningStats
+{
+	uint32_t bolts = 0; // Bolts alive.
+	uint32_t shapes = 0; // Shapes in the cache.
+	uint32_t segments = 0; // Segments in the cache.
+	uint32_t cacheHits = 0; // Strikes since the last update that reused a shape.
+	uint32_t cacheMisses = 0; // Strikes since the last update that needed a new shape.
+	uint32_t drawCalls = 0; // Instanced draws of the last render(); one per detail level in use.
+	double generateMs = 0.0; // Shape generation in the last update().
+	double writeMs = 0.0; // Instance output of the last writeInstances().
+};
+
+/**
+ * @brief Lightning bolts drawn from cached procedural shapes.
+ *
+ * A bolt's shape is made by seeded midpoint displacement with random forks,
+ * in a space normalized to the bolt's endpoints, so the same shape fits any
+ * bolt with the same detail level, roughness and branching. Shapes are
+ * cached by those parameters, quantized into buckets, plus a variant picked
+ * from the bolt's seed; a strike costs a hash lookup, and the shapes that
+ * are missing are generated in parallel jobs by the next update().
+ *
+ * Bolts are not regenerated to animate them: the vertex shader moves every
+ * shape point by a hash of its id, the bolt's seed and the time, re-rolled
+ * thirty times a second. render() draws one instanced batch per detail level
+ * from a segment buffer holding every cached shape.
+ */
+class LightningSystem
+{
+public:
+	static const int MIN_DETAIL = 3; // Subdivisions of the shortest bolts.
+	static const int MAX_DETAIL = 7; // Subdivisions of the longest bolts.
+	static const uint32_t VARIANTS = 8; // Shapes per bucket.
+
+	LightningSystem() = default;
+	LightningSystem( const LightningSystem& ) = delete;
+	LightningSystem& operator=( const LightningSystem& ) = delete;
+
+	/**
+	 * @brief Creates the shader and buffers. Requires a current OpenGL 3.3 context.
+	 * @return False if the shader fails to compile.
+	 */
+	bool initGL();
+	/**
+	 * @brief Deletes the GL objects. Requires the context that initGL() ran with.
+	 */
+	void shutdownGL();
+
+	/**
+	 * @brief Sets the length one segment of a bolt should have, which picks its detail level.
+	 * @param meters Segment length in meters.
+	 */
+	void setSegmentLength( float meters ) { segmentLength = meters; }
+	/**
+	 * @brief Sets how far the shader jitters shape points.
+	 * @param amount Fraction of the bolt's displacement.
+	 */
+	void setJitter( float amount ) { jitter = amount; }
+
+	/**
+	 * @brief Strikes a bolt; it is drawn from the next update() until its duration passes.
+	 * @param settings The bolt.
+	 */
+	void strike( const LightningBoltSettings& settings );
+	/**
+	 * @brief Ages and expires bolts and generates the shapes new strikes need.
+	 * @param dt Time step in seconds.
+	 */
+	void update( float dt );
+	/**
+	 * @brief Writes every bolt as an instance, grouped by detail level.
+	 * @param out Room for getBoltCount() instances.
+	 * @return The number written.
+	 */
+	uint32_t writeInstances( LightningInstance* out );
+	/**
+	 * @brief Draws every bolt with one instanced draw per detail level; requires initGL().
+	 * @param projection Transforms meters to clip space.
+	 * @param time Seconds, for the jitter animation.
+	 */
+	void render( const glm::mat4& projection, float time );
+
+	/**
+	 * @brief Gets the number of live bolts.
+	 * @return The count.
+	 */
+	uint32_t getBoltCount() const { return static_cast< uint32_t >( bolts.size() ); }
+	/**
+	 * @brief Gets the counters.
+	 * @return The statistics.
+	 */
+	const LightningStats& getStats() const { return stats; }
+	/**
+	 * @brief Gets the cached segments, as they are uploaded.
+	 * @return Every cached shape's segments.
+	 */
+	const std::vector<LightningSegment>& getSegments() const { return segments; }
+	/**
+	 * @brief Empties the shape cache and removes the live bolts that use it.
+	 */
+	void clearCache();
+
+	/**
+	 * @brief Generates a bolt shape by seeded midpoint displacement.
+	 * @param detail Subdivisions; the main channel gets 2^detail segments.
+	 * @param roughness 0 to 1; how much of the displacement each subdivision keeps.
+	 * @param branching 0 to 1; chance of forking at a subdivision.
+	 * @param seed The shape's seed.
+	 * @param out Receives the segments; cleared first.
+	 */
+	static void generateShape( int detail, float roughness, float branching, uint64_t seed, std::vector<LightningSegment>& out );
+	/**
+	 * @brief Picks the detail level for a bolt.
+	 * @param length Bolt length in meters.
+	 * @param segmentLength Desired segment length in meters.
+	 * @return MIN_DETAIL to MAX_DETAIL.
+	 */
+	static int detailFor( float length, float segmentLength );
+
+private:
+	static const int DETAIL_LEVELS = MAX_DETAIL - MIN_DETAIL + 1;
+
+	/**
+	 * @brief A cached shape.
+	 */
+	struct Shape
+	{
+		uint32_t key; // Bucket and variant.
+		int32_t firstSegment = -1; // -1 until generated.
+		int32_t segmentCount = 0;
+	};
+
+	/**
+	 * @brief A live bolt.
+	 */
+	struct Bolt
+	{
+		LightningInstance instance;
+		uint32_t shape;
+		uint8_t level; // Detail level minus MIN_DETAIL.
+		float age;
+		float duration;
+	};
+
+	std::vector<Bolt> bolts;
+	std::vector<Bolt> struck; // Strikes since the last update(), joining bolts there.
+	std::vector<Shape> shapes;
+	std::unordered_map<uint32_t, uint32_t> shapeIndex; // Key to index in shapes.
+	std::vector<uint32_t> pending; // Shapes strikes need that are not generated yet.
+	std::vector<LightningSegment> segments; // Every generated shape, back to back.
+	int32_t levelSegments[ DETAIL_LEVELS ] = {}; // Most segments of any shape per level; the vertices drawn per instance.
+	uint32_t levelFirst[ DETAIL_LEVELS ] = {}, levelCount[ DETAIL_LEVELS ] = {}; // Instance ranges of the last writeInstances().
+	float segmentLength = 0.5f;
+	float jitter = 0.25f;
+	uint32_t strikeHits = 0, strikeMisses = 0; // Since the last update().
+	LightningStats stats;
+
+	unsigned int program = 0, vao = 0, instanceVbo = 0, segmentBuffer = 0, segmentTexture = 0; // GL objects.
+	uint32_t instanceCapacity = 0; // Instances the buffer holds.
+	size_t uploadedSegments = 0; // Segments in the GL buffer; it is re-uploaded when the cache grows.
+	int projectionLocation = -1, timeLocation = -1, jitterLocation = -1;
+	bool glReady = false;
+
+	/**
+	 * @brief Builds a cache key.
+	 * @param level Detail level minus MIN_DETAIL.
+	 * @param roughness 0 to 1.
+	 * @param branching 0 to 1.
+	 * @param variant 0 to VARIANTS - 1.
+	 * @return The key.
+	 */
+	static uint32_t makeKey( int level, float roughness, float branching, uint32_t variant );
+};
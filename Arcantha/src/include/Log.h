@@ -0,0 +1,491 @@
+#pragma once
+
+#include <algorithm> // Required for std::min.
+#include <atomic> // Required for the ring indices and counters.
+#include <chrono> // Required for timestamps and the flush interval.
+#include <condition_variable> // Required to wake the writer thread.
+#include <csignal> // Required for siginfo_t in the fatal signal handler.
+#include <cstdint> // Required for fixed-width integer types.
+#include <cstdio> // Required for std::FILE.
+#include <cstring> // Required for std::memcpy and std::strlen.
+#include <memory> // Required for std::unique_ptr ring storage.
+#include <mutex> // Required to guard ring registration and draining.
+#include <string> // Required for std::string arguments and the file path.
+#include <thread> // Required for the writer thread.
+#include <type_traits> // Required to pick how each argument is stored.
+#include <vector> // Required for the list of rings.
+
+// Messages below this level are compiled out, arguments included: 0 trace, 1 debug, 2 info, 3 warn, 4 error, 5 fatal.
+// Debug builds keep debug messages, release builds start at info; define ARCANTHA_LOG_LEVEL to override.
+#ifndef ARCANTHA_LOG_LEVEL
+#ifdef NDEBUG
+#define ARCANTHA_LOG_LEVEL 2
+#else
+#define ARCANTHA_LOG_LEVEL 1
+#endif
+#endif
+
+// Timestamps come from the CPU's time stamp counter where there is one: reading it costs a fraction of a
+// steady_clock call, which would otherwise be most of the cost of a log statement.
+#if defined( __x86_64__ ) || defined( _M_X64 )
+#define ARCANTHA_LOG_TSC 1
+#ifdef _MSC_VER
+#include <intrin.h> // __rdtsc.
+#else
+#include <x86intrin.h> // __rdtsc.
+#endif
+#else
+#define ARCANTHA_LOG_TSC 0
+#endif
+
+/**
+ * @brief Severity of a log message.
+ */
+enum class LogLevel : uint8_t
+{
+	Trace,
+	Debug,
+	Info,
+	Warn,
+	Error,
+	Fatal // Also flushes on the calling thread before returning.
+};
+
+/**
+ * @brief Options for Logger::init().
+ */
+struct LogSettings
+{
+	bool console = true; // Write to stderr.
+	std::string filePath; // Also write to this file, truncated at init; empty for none.
+	size_t ringBytes = 1 << 18; // Ring size of each logging thread, rounded up to a power of two.
+	uint32_t rateLimit = 20; // Messages per second each call site may log; 0 for no limit.
+	int flushIntervalMs = 5; // How often the writer thread wakes up on its own.
+	bool crashHandlers = true; // Flush on fatal signals and std::terminate.
+};
+
+/**
+ * @brief Totals since startup.
+ */
+struct LogStats
+{
+	uint64_t written = 0; // Messages formatted and written.
+	uint64_t dropped = 0; // Messages lost because their thread's ring was full.
+	uint64_t suppressed = 0; // Messages held back by rate limiting.
+	uint32_t threads = 0; // Threads that have logged.
+};
+
+/**
+ * @brief One logging statement in the source; holds its rate limit state.
+ *
+ * The LOG_ macros create one as a function-local static per call site.
+ */
+struct LogSite
+{
+	LogLevel level;
+	const char* file;
+	int line;
+	std::atomic<uint64_t> window{ 0 }; // Current second since startup.
+	std::atomic<uint32_t> count{ 0 }; // Messages in the current second.
+	std::atomic<uint32_t> held{ 0 }; // Messages suppressed since the last one logged.
+
+	LogSite( LogLevel level, const char* file, int line ) : level( level ), file( file ), line( line ) {}
+};
+
+/**
+ * @brief Asynchronous logger; the calling thread only copies the arguments.
+ *
+ * This class implements the Singleton design pattern. Every thread logs into
+ * its own lock-free ring, registered on its first message: a fixed header
+ * with the call site, format string and timestamp, followed by the
+ * arguments in binary form (numbers as 8 bytes, strings copied up to
+ * MAX_STRING). Format strings must be string literals; they are stored as
+ * pointers and only read by the writer thread, which formats the messages,
+ * replacing each "{}" with the next argument, and writes them to stderr and
+ * the log file. No call on the logging thread blocks, allocates after the
+ * first message or touches a stream; when a ring is full the message is
+ * counted as dropped.
+ *
+ * Each call site logs at most LogSettings::rateLimit messages per second;
+ * the next message it logs afterwards says how many were held back. Fatal
+ * signals and std::terminate flush every ring before the process dies,
+ * formatting into a fixed buffer and writing it with write(2), without
+ * locks; a ring the writer thread is draining at that moment is skipped.
+ * Before init() and after shutdown() messages are formatted and written
+ * synchronously, so nothing logged during startup is lost.
+ */
+class Logger
+{
+public:
+	static const size_t MAX_STRING = 1024; // Longer string arguments are truncated.
+
+	/**
+	 * @brief Gets the singleton instance of the Logger.
+	 * @return A reference to the single Logger instance.
+	 */
+	static Logger& getInstance();
+
+	/**
+	 * @brief Opens the outputs and starts the writer thread.
+	 * @param settings The options.
+	 * @return False if the log file cannot be opened; the console is still used.
+	 */
+	bool init( const LogSettings& settings = LogSettings() );
+	/**
+	 * @brief Writes every queued message, stops the writer thread, closes the file and puts back the handlers init() replaced.
+	 */
+	void shutdown();
+	/**
+	 * @brief Writes every queued message on the calling thread.
+	 */
+	void flush();
+
+	/**
+	 * @brief Queues a message. Use the LOG_ macros, which also create the call site.
+	 * @param site The call site.
+	 * @param format String literal; each "{}" is replaced by the next argument.
+	 * @param args Integers, floating point numbers, bools, chars, strings and pointers.
+	 */
+	template <typename... Args>
+	void log( LogSite& site, const char* format, const Args&... args );
+
+	/**
+	 * @brief Gets the totals since startup.
+	 * @return The statistics.
+	 */
+	LogStats getStats() const;
+
+private:
+	static Logger instance; // The single instance of the Logger class, implementing the Singleton pattern.
+
+	/**
+	 * @brief Argument tags, one byte before each argument.
+	 */
+	enum class ArgType : uint8_t
+	{
+		Int,
+		UInt,
+		Double,
+		Bool,
+		Char,
+		String,
+		Pointer
+	};
+
+	/**
+	 * @brief The fixed part of every message in a ring.
+	 */
+	struct Record
+	{
+		uint32_t size; // Bytes including the arguments, a multiple of 8; PADDING marks unused space at the ring's end.
+		uint32_t held; // Messages of this call site suppressed since its last message.
+		const LogSite* site;
+		const char* format;
+		uint64_t time; // Clock ticks, see now().
+		uint32_t argCount;
+		uint32_t reserved;
+	};
+
+	static const uint32_t PADDING = 0x80000000u;
+
+	/**
+	 * @brief The messages of one thread; single producer, and the writer thread as single consumer.
+	 */
+	struct Ring
+	{
+		alignas( 64 ) std::atomic<size_t> head{ 0 }; // Next byte to read, written by the consumer.
+		alignas( 64 ) std::atomic<size_t> tail{ 0 }; // Next byte to write, written by the producer.
+		std::atomic<uint64_t> dropped{ 0 };
+		std::atomic<bool> consuming{ false }; // Held by the thread reading the ring; a crash handler never releases it.
+		std::unique_ptr<char[]> data;
+		size_t capacity = 0; // A power of two.
+		Ring* next = nullptr; // The ring registered before this one.
+
+		/**
+		 * @brief Finds room for a message, skipping the end of the ring if it does not fit there.
+		 * @param size The message size, a multiple of 8.
+		 * @param used Receives the bytes to commit, including skipped ones.
+		 * @return Where to write the message, or nullptr if the ring is full.
+		 */
+		char* reserve( size_t size, size_t& used ) {
+			const size_t position = tail.load( std::memory_order_relaxed );
+			const size_t offset = position & ( capacity - 1 );
+			const size_t padding = size > capacity - offset ? capacity - offset : 0;
+			if ( position - head.load( std::memory_order_acquire ) + padding + size > capacity ) return nullptr;
+			if ( padding ) {
+				const uint32_t marker = static_cast< uint32_t >( padding ) | PADDING;
+				std::memcpy( data.get() + offset, &marker, sizeof( marker ) );
+			}
+			used = padding + size;
+			return data.get() + ( ( position + padding ) & ( capacity - 1 ) );
+		}
+		/**
+		 * @brief Publishes the reserved message to the consumer.
+		 * @param used The bytes reserve() reported.
+		 */
+		void commit( size_t used ) { tail.store( tail.load( std::memory_order_relaxed ) + used, std::memory_order_release ); }
+	};
+
+	static thread_local Ring* threadRing; // The calling thread's ring, once registered.
+
+	LogSettings settings;
+	std::vector<std::unique_ptr<Ring>> rings; // One per thread that has logged; kept for the process lifetime.
+	std::atomic<Ring*> lastRing{ nullptr }; // The newest ring, linked to the older ones so they can be walked without locks.
+	mutable std::mutex ringsMutex; // Guards registration.
+	std::mutex drainMutex; // Only one thread consumes the rings at a time.
+	std::mutex outputMutex; // Guards the outputs when writing synchronously.
+	std::mutex wakeMutex;
+	std::condition_variable wake; // Wakes the writer thread early.
+	std::thread writer;
+	std::atomic<bool> running{ false };
+	std::atomic<bool> crashed{ false };
+	std::atomic<uint64_t> written{ 0 };
+	std::atomic<uint64_t> suppressed{ 0 };
+	std::FILE* file = nullptr;
+	int fileDescriptor = -1; // The file's descriptor, for writes from a crash handler.
+	uint64_t startTime; // Clock ticks at construction.
+	double secondsPerTick; // Measured at construction.
+	std::string text; // Formatted messages waiting to be written; drain side only.
+
+	Logger(); // Private constructor for singleton.
+	~Logger();
+	Logger( const Logger& ) = delete;
+	Logger& operator=( const Logger& ) = delete;
+
+	/**
+	 * @brief Gets the time for timestamps and rate limiting.
+	 * @return Time stamp counter ticks, or steady clock nanoseconds without one.
+	 */
+	static uint64_t now() {
+#if ARCANTHA_LOG_TSC
+		return __rdtsc();
+#else
+		return static_cast< uint64_t >( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+#endif
+	}
+	/**
+	 * @brief Applies the call site's rate limit.
+	 * @param site The call site.
+	 * @param time The message's timestamp.
+	 * @param held Receives how many messages were suppressed since the site's last message.
+	 * @return False if the message must be suppressed.
+	 */
+	bool admit( LogSite& site, uint64_t time, uint32_t& held );
+	/**
+	 * @brief Gets the calling thread's ring, registering it on first use.
+	 * @return The ring.
+	 */
+	Ring& getRing() { return threadRing ? *threadRing : registerThread(); }
+	/**
+	 * @brief Creates and registers the calling thread's ring.
+	 * @return The ring.
+	 */
+	Ring& registerThread();
+	/**
+	 * @brief Formats a message and writes it at once; used while the writer thread is not running.
+	 * @param record The encoded message.
+	 */
+	void writeNow( const Record& record );
+	/**
+	 * @brief Appends a formatted message, with its newline, to a sink.
+	 * @param record The encoded message.
+	 * @param out A string on the writer thread, or a fixed buffer in a crash handler.
+	 */
+	template <typename Sink>
+	void format( const Record& record, Sink& out ) const;
+	/**
+	 * @brief Formats every message in a ring and marks them read. Requires the ring's consuming flag.
+	 * @param ring The ring.
+	 * @param out Receives the messages.
+	 * @return The number of messages.
+	 */
+	template <typename Sink>
+	uint64_t consume( Ring& ring, Sink& out );
+	/**
+	 * @brief Consumes every ring and writes the messages. Requires drainMutex.
+	 */
+	void drainLocked();
+	/**
+	 * @brief Writes formatted text to every output.
+	 * @param data The text.
+	 * @param size Its length.
+	 */
+	void output( const char* data, size_t size );
+	/**
+	 * @brief Body of the writer thread.
+	 */
+	void run();
+	/**
+	 * @brief Flushes from a crashing thread; async-signal-safe, so it takes no locks and does not allocate.
+	 */
+	void crashFlush();
+#ifdef _WIN32
+	/**
+	 * @brief Handler for fatal signals: flushes, then passes the signal to the handler installed before.
+	 * @param signal The signal number.
+	 */
+	static void onSignal( int signal );
+#else
+	/**
+	 * @brief Handler for fatal signals: flushes, then passes the signal to the handler installed before.
+	 * @param signal The signal number.
+	 * @param info Details of the signal.
+	 * @param context The interrupted context.
+	 */
+	static void onSignal( int signal, siginfo_t* info, void* context );
+#endif
+	/**
+	 * @brief Handler for std::terminate: flushes, then aborts.
+	 */
+	static void onTerminate();
+
+	/**
+	 * @brief Gets the encoded size of an argument, tag included.
+	 * @param value The argument.
+	 * @return The size in bytes.
+	 */
+	template <typename T>
+	static size_t argSize( const T& value );
+	/**
+	 * @brief Encodes an argument with its tag.
+	 * @param out Where to write.
+	 * @param value The argument.
+	 * @return Past the written bytes.
+	 */
+	template <typename T>
+	static char* encode( char* out, const T& value );
+	/**
+	 * @brief Encodes a tag and a fixed-size value.
+	 */
+	template <typename V>
+	static char* encodeValue( char* out, ArgType type, const V& value ) {
+		*out++ = static_cast< char >( type );
+		std::memcpy( out, &value, sizeof( V ) );
+		return out + sizeof( V );
+	}
+	/**
+	 * @brief Encodes a tag, a length and the characters of a string.
+	 */
+	static char* encodeString( char* out, const char* value, size_t length ) {
+		const uint16_t stored = static_cast< uint16_t >( length );
+		*out++ = static_cast< char >( ArgType::String );
+		std::memcpy( out, &stored, sizeof( stored ) );
+		std::memcpy( out + sizeof( stored ), value, length );
+		return out + sizeof( stored ) + length;
+	}
+};
+
+template <typename T>
+size_t Logger::argSize( const T& value ) {
+	using D = typename std::decay<T>::type;
+	if constexpr ( std::is_same<D, bool>::value || std::is_same<D, char>::value ) return 2;
+	else if constexpr ( std::is_arithmetic<D>::value || std::is_enum<D>::value ) return 9;
+	else if constexpr ( std::is_array<T>::value ) return 3 + std::min( std::strlen( value ), MAX_STRING );
+	else if constexpr ( std::is_same<D, const char*>::value || std::is_same<D, char*>::value ) {
+		return 3 + ( value ? std::min( std::strlen( value ), MAX_STRING ) : 6 );
+	}
+	else if constexpr ( std::is_same<D, std::string>::value ) return 3 + std::min( value.size(), MAX_STRING );
+	else if constexpr ( std::is_pointer<D>::value ) return 9;
+	else static_assert( sizeof( D ) == 0, "Unsupported log argument type." );
+}
+
+template <typename T>
+char* Logger::encode( char* out, const T& value ) {
+	using D = typename std::decay<T>::type;
+	if constexpr ( std::is_same<D, bool>::value ) {
+		*out++ = static_cast< char >( ArgType::Bool );
+		*out++ = value ? 1 : 0;
+		return out;
+	}
+	else if constexpr ( std::is_same<D, char>::value ) {
+		*out++ = static_cast< char >( ArgType::Char );
+		*out++ = value;
+		return out;
+	}
+	else if constexpr ( std::is_floating_point<D>::value ) return encodeValue( out, ArgType::Double, static_cast< double >( value ) );
+	else if constexpr ( std::is_enum<D>::value ) return encodeValue( out, ArgType::Int, static_cast< int64_t >( value ) );
+	else if constexpr ( std::is_integral<D>::value && std::is_signed<D>::value ) return encodeValue( out, ArgType::Int, static_cast< int64_t >( value ) );
+	else if constexpr ( std::is_integral<D>::value ) return encodeValue( out, ArgType::UInt, static_cast< uint64_t >( value ) );
+	else if constexpr ( std::is_array<T>::value ) return encodeString( out, value, std::min( std::strlen( value ), MAX_STRING ) );
+	else if constexpr ( std::is_same<D, const char*>::value || std::is_same<D, char*>::value ) {
+		return value ? encodeString( out, value, std::min( std::strlen( value ), MAX_STRING ) ) : encodeString( out, "(null)", 6 );
+	}
+	else if constexpr ( std::is_same<D, std::string>::value ) return encodeString( out, value.data(), std::min( value.size(), MAX_STRING ) );
+	else return encodeValue( out, ArgType::Pointer, reinterpret_cast< uint64_t >( value ) );
+}
+
+template <typename... Args>
+void Logger::log( LogSite& site, const char* format, const Args&... args ) {
+	const uint64_t time = now();
+	uint32_t held = 0;
+	if ( !admit( site, time, held ) ) return;
+
+	const size_t size = ( sizeof( Record ) + ( size_t( 0 ) + ... + argSize( args ) ) + 7 ) & ~size_t( 7 );
+	Record header;
+	header.size = static_cast< uint32_t >( size );
+	header.held = held;
+	header.site = &site;
+	header.format = format;
+	header.time = time;
+	header.argCount = static_cast< uint32_t >( sizeof...( Args ) );
+	header.reserved = 0;
+
+	if ( !running.load( std::memory_order_acquire ) ) {
+		std::unique_ptr<char[]> buffer( new char[ size ] );
+		std::memcpy( buffer.get(), &header, sizeof( Record ) );
+		char* out = buffer.get() + sizeof( Record );
+		( ( out = encode( out, args ) ), ... );
+		( void )out;
+		writeNow( *reinterpret_cast< const Record* >( buffer.get() ) );
+		return;
+	}
+
+	Ring& ring = getRing();
+	size_t used = 0;
+	char* slot = ring.reserve( size, used );
+	if ( !slot ) {
+		ring.dropped.fetch_add( 1, std::memory_order_relaxed );
+		return;
+	}
+	std::memcpy( slot, &header, sizeof( Record ) );
+	char* out = slot + sizeof( Record );
+	( ( out = encode( out, args ) ), ... );
+	( void )out;
+	ring.commit( used );
+
+	if ( site.level >= LogLevel::Error ) wake.notify_one();
+	if ( site.level == LogLevel::Fatal ) flush();
+}
+
+#define ARCANTHA_LOG( level, ... ) \
+	do { \
+		static LogSite arcanthaLogSite( level, __FILE__, __LINE__ ); \
+		Logger::getInstance().log( arcanthaLogSite, __VA_ARGS__ ); \
+	} while ( 0 )
+
+#if ARCANTHA_LOG_LEVEL <= 0
+#define LOG_TRACE( ... ) ARCANTHA_LOG( LogLevel::Trace, __VA_ARGS__ )
+#else
+#define LOG_TRACE( ... ) ( ( void )0 )
+#endif
+#if ARCANTHA_LOG_LEVEL <= 1
+#define LOG_DEBUG( ... ) ARCANTHA_LOG( LogLevel::Debug, __VA_ARGS__ )
+#else
+#define LOG_DEBUG( ... ) ( ( void )0 )
+#endif
+#if ARCANTHA_LOG_LEVEL <= 2
+#define LOG_INFO( ... ) ARCANTHA_LOG( LogLevel::Info, __VA_ARGS__ )
+#else
+#define LOG_INFO( ... ) ( ( void )0 )
+#endif
+#if ARCANTHA_LOG_LEVEL <= 3
+#define LOG_WARN( ... ) ARCANTHA_LOG( LogLevel::Warn, __VA_ARGS__ )
+#else
+#define LOG_WARN( ... ) ( ( void )0 )
+#endif
+#if ARCANTHA_LOG_LEVEL <= 4
+#define LOG_ERROR( ... ) ARCANTHA_LOG( LogLevel::Error, __VA_ARGS__ )
+#else
+#define LOG_ERROR( ... ) ( ( void )0 )
+#endif
+#define LOG_FATAL( ... ) ARCANTHA_LOG( LogLevel::Fatal, __VA_ARGS__ )
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef> // Required for size_t.
+#include <cstdint> // Required for uint8_t.
+#include <string> // Required for std::string paths.
+
+/**
+ * @brief A read-only memory mapping of a whole file.
+ *
+ * Pages are loaded by the OS on first access, so mapping a large file costs
+ * nothing up front. Streaming readers call release() on ranges they have
+ * consumed so the resident size stays bounded to a window around the cursor.
+ */
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	/**
+	 * @brief Destructor. Unmaps the file if it is open.
+	 */
+	~MappedFile();
+	MappedFile( const MappedFile& ) = delete; // A mapping has a single owner.
+	MappedFile& operator=( const MappedFile& ) = delete;
+
+	/**
+	 * @brief Maps a file, closing any file mapped before.
+	 * @param path The file to map.
+	 * @return False if the file cannot be opened or is empty.
+	 */
+	bool open( const std::string& path );
+	/**
+	 * @brief Unmaps the file.
+	 */
+	void close();
+
+	/**
+	 * @brief Hints that the file will be read front to back, enabling aggressive read-ahead.
+	 */
+	void adviseSequential() const;
+	/**
+	 * @brief Drops the resident pages of a consumed range. The data stays readable and is reloaded on access.
+	 *
+	 * The page holding the first byte is dropped as well, so consecutive calls
+	 * with adjoining ranges never leave a page behind; the page holding the
+	 * last byte is kept since data after the range may still be in use.
+	 * @param offset The first byte of the range.
+	 * @param length The length of the range in bytes.
+	 */
+	void release( size_t offset, size_t length ) const;
+
+	/**
+	 * @brief Gets the mapped bytes.
+	 * @return A pointer to the first byte, or nullptr if nothing is mapped.
+	 */
+	const uint8_t* data() const { return bytes; }
+	/**
+	 * @brief Gets the file size.
+	 * @return The size of the mapping in bytes.
+	 */
+	size_t size() const { return length; }
+	/**
+	 * @brief Checks if a file is mapped.
+	 * @return True if open() succeeded and close() was not called since.
+	 */
+	bool isOpen() const { return bytes != nullptr; }
+
+private:
+	const uint8_t* bytes = nullptr; // Start of the mapping.
+	size_t length = 0; // Size of the mapping in bytes.
+#ifdef _WIN32
+	void* fileHandle = nullptr; // Win32 file handle.
+	void* mappingHandle = nullptr; // Win32 file mapping handle.
+#endif
+};
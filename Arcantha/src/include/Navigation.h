@@ -0,0 +1,365 @@
+#pragma once
+
+#include <cstddef> // Required for size_t.
+#include <cstdint> // Required for fixed-width integer types.
+#include <deque> // Required for the pending request queue.
+#include <unordered_map> // Required for the path cache.
+#include <vector> // Required for std::vector node, edge and path storage.
+
+#include <glm/glm.hpp> // Includes GLM for tile and world coordinates.
+
+#include "TileMap.h" // Includes the TileMap the navigation graph is built from.
+
+/**
+ * @brief How an agent moves along a navigation edge.
+ */
+enum class NavLinkType : uint8_t
+{
+	Walk, // Step to the neighbouring tile on the same surface.
+	Fall, // Walk off a ledge or drop through a platform and land below.
+	Jump, // Jump along an arc to another surface.
+	Fly // Move freely to a neighbouring open tile (flying agents only).
+};
+
+/**
+ * @brief The movement abilities of an enemy archetype, in tiles.
+ */
+struct NavArchetype
+{
+	int clearance = 2; // Height of the agent; every tile it occupies must be open.
+	int jumpHeight = 3; // Highest apex of a jump above the take-off tile.
+	int jumpDistance = 4; // Longest horizontal distance covered by a jump.
+	int maxDrop = 8; // Longest fall the agent is willing to take.
+	bool flying = false; // Ignores gravity and moves through any open tile.
+};
+
+/**
+ * @brief A directed edge of the navigation graph.
+ */
+struct NavEdge
+{
+	uint32_t to; // Target node.
+	float cost; // Traversal cost, never below the tile distance so the A* heuristic stays admissible.
+	NavLinkType type; // Movement used along the edge.
+};
+
+/**
+ * @brief The places an archetype can stand and the moves between them, for one room.
+ *
+ * Ground archetypes get a node per standable tile (open with the agent's
+ * clearance and resting on Solid or a Platform) and walk, fall and jump
+ * edges; jump edges are only created when a parabolic arc within the
+ * archetype's jump height clears every tile. Flying archetypes get a node per
+ * open tile and 8-way fly edges. Edges are stored in CSR form.
+ */
+class NavGraph
+{
+public:
+	/**
+	 * @brief Builds the graph of a room for one archetype. Call on room load.
+	 * @param map The room geometry.
+	 * @param archetype The movement abilities to build for.
+	 */
+	void build( const TileMap& map, const NavArchetype& archetype );
+
+	/**
+	 * @brief Finds the node an agent occupying a tile belongs to.
+	 *
+	 * Airborne ground agents map to the surface below them; agents slightly
+	 * off the graph map to a nearby node.
+	 * @param tile The tile the agent occupies.
+	 * @return The node index, or -1 if there is no node nearby.
+	 */
+	int findNode( glm::ivec2 tile ) const;
+
+	/**
+	 * @brief Gets the tile of a node.
+	 * @param node The node index.
+	 * @return The tile coordinates.
+	 */
+	glm::ivec2 getNodeTile( uint32_t node ) const { return nodes[ node ]; }
+	/**
+	 * @brief Gets the first outgoing edge of a node; edges of node n are [getEdgeBegin( n ), getEdgeBegin( n + 1 )).
+	 * @param node The node index (up to getNodeCount()).
+	 * @return The index of the first edge.
+	 */
+	uint32_t getEdgeBegin( uint32_t node ) const { return firstEdge[ node ]; }
+	/**
+	 * @brief Gets an edge.
+	 * @param index The edge index.
+	 * @return The edge.
+	 */
+	const NavEdge& getEdge( uint32_t index ) const { return edges[ index ]; }
+	/**
+	 * @brief Gets the number of nodes.
+	 * @return The node count.
+	 */
+	size_t getNodeCount() const { return nodes.size(); }
+	/**
+	 * @brief Gets the number of edges.
+	 * @return The edge count.
+	 */
+	size_t getEdgeCount() const { return edges.size(); }
+	/**
+	 * @brief Gets the archetype the graph was built for.
+	 * @return The archetype.
+	 */
+	const NavArchetype& getArchetype() const { return archetype; }
+
+private:
+	NavArchetype archetype; // Abilities the graph was built for.
+	int width = 0, height = 0; // Size of the room in tiles.
+	std::vector<glm::ivec2> nodes; // Tile of every node.
+	std::vector<uint32_t> firstEdge; // CSR offsets, one past the node count.
+	std::vector<NavEdge> edges; // All edges, grouped by source node.
+	std::vector<int32_t> cellToNode; // Node of every tile, or -1.
+	std::vector<uint8_t> solid; // 1 for every Solid tile, so findNode does not need the map.
+
+	/**
+	 * @brief Checks if the agent fits with its feet in a tile.
+	 * @param map The room geometry.
+	 * @param x The column.
+	 * @param y The row of the agent's feet.
+	 * @return True if no tile the agent covers is Solid.
+	 */
+	bool isOpen( const TileMap& map, int x, int y ) const;
+	/**
+	 * @brief Checks if the agent can stand in a tile.
+	 * @param map The room geometry.
+	 * @param x The column.
+	 * @param y The row of the agent's feet.
+	 * @return True if the tile is open and rests on Solid or a Platform.
+	 */
+	bool canStand( const TileMap& map, int x, int y ) const;
+	/**
+	 * @brief Checks that a jump arc between two standable tiles is clear.
+	 * @param map The room geometry.
+	 * @param from The take-off tile.
+	 * @param to The landing tile.
+	 * @return True if the arc stays within the jump height and never enters a Solid tile.
+	 */
+	bool isArcClear( const TileMap& map, glm::ivec2 from, glm::ivec2 to ) const;
+};
+
+/**
+ * @brief A point along a path.
+ */
+struct NavWaypoint
+{
+	glm::vec2 position; // World position of the tile center.
+	NavLinkType link; // Movement used to reach this waypoint from the previous one.
+};
+
+/**
+ * @brief The state of an agent's path request.
+ */
+enum class PathStatus : uint8_t
+{
+	None, // Never requested.
+	Pending, // Queued or being searched.
+	Ready, // A path is available.
+	Failed // No path exists or the agent is off the graph.
+};
+
+/**
+ * @brief Counters accumulated by a PathService.
+ */
+struct PathStats
+{
+	uint64_t requests = 0; // Calls to requestPath.
+	uint64_t cacheHits = 0; // Requests answered from the cache or the agent's current path.
+	uint64_t partialRepaths = 0; // Requests that kept the start of the current path.
+	uint64_t completed = 0; // Searches that found a path.
+	uint64_t failed = 0; // Searches that found no path.
+	uint64_t expansions = 0; // Nodes expanded by A*.
+};
+
+/**
+ * @brief Answers path requests for many agents within a per-frame time budget.
+ *
+ * Requests are answered from a cache of recent (start, goal) paths when
+ * possible. Otherwise an A* search is queued; update() advances up to
+ * MAX_ACTIVE_SEARCHES searches in parallel on the JobSystem and suspends them
+ * when the frame's budget runs out, resuming them next frame. When the goal
+ * moves a little (the player ran a few tiles), the current path is kept up to
+ * a splice point near its end and only the remainder is searched again.
+ *
+ * Call everything from the game thread; only the searches run on workers.
+ */
+class PathService
+{
+public:
+	static const int MAX_ACTIVE_SEARCHES = 64; // Searches advanced concurrently.
+	static const size_t CACHE_CAPACITY = 1024; // Cached paths before the least recently used is evicted.
+	static const int REPATH_RADIUS = 6; // Goal movement (tiles) still handled by a partial repath.
+	static const int SPLICE_BACK = 4; // Nodes before the old goal at which a partial repath splices.
+
+	/**
+	 * @brief Constructor for the PathService class.
+	 * @param map The room geometry; must outlive the service.
+	 */
+	explicit PathService( const TileMap& map );
+
+	/**
+	 * @brief Builds the navigation graph for an archetype.
+	 * @param archetype The movement abilities.
+	 * @return The archetype index used in requests.
+	 */
+	int addArchetype( const NavArchetype& archetype );
+	/**
+	 * @brief Rebuilds every graph after the map changed and drops all paths and cached results.
+	 */
+	void rebuild();
+
+	/**
+	 * @brief Requests a path for an agent, replacing any previous request of that agent.
+	 * @param agent The agent id, any small integer unique per agent.
+	 * @param archetype The agent's archetype index.
+	 * @param from The agent's world position.
+	 * @param to The target world position.
+	 */
+	void requestPath( uint32_t agent, int archetype, glm::vec2 from, glm::vec2 to );
+	/**
+	 * @brief Advances queued searches until they are all done or the budget is spent.
+	 * @param budgetMs The wall time this frame may spend on searches.
+	 */
+	void update( double budgetMs );
+
+	/**
+	 * @brief Gets the state of an agent's last request.
+	 * @param agent The agent id.
+	 * @return The path status.
+	 */
+	PathStatus getStatus( uint32_t agent ) const;
+	/**
+	 * @brief Gets an agent's most recent path, starting at its position when requested.
+	 *
+	 * While a new request is Pending the previous path is still returned, so
+	 * agents keep moving during a repath.
+	 * @param agent The agent id.
+	 * @return The waypoints; empty if no path was ever found or the last request failed.
+	 */
+	const std::vector<NavWaypoint>& getPath( uint32_t agent ) const;
+	/**
+	 * @brief Gets the graph of an archetype.
+	 * @param archetype The archetype index.
+	 * @return The navigation graph.
+	 */
+	const NavGraph& getGraph( int archetype ) const { return graphs[ archetype ]; }
+	/**
+	 * @brief Gets the number of queued and running searches.
+	 * @return The pending search count.
+	 */
+	size_t getPendingCount() const { return pending.size() + activeCount; }
+	/**
+	 * @brief Gets the accumulated counters.
+	 * @return The statistics.
+	 */
+	const PathStats& getStats() const { return stats; }
+
+private:
+	/**
+	 * @brief The path state of one agent.
+	 */
+	struct Agent
+	{
+		PathStatus status = PathStatus::None;
+		int archetype = 0;
+		int32_t start = -1, goal = -1; // Nodes of the latest request.
+		uint32_t serial = 0; // Incremented per request so stale search results are dropped.
+		int search = -1; // Active search slot, or -1.
+		bool queued = false; // In the pending queue.
+		std::vector<uint32_t> prefix; // Nodes kept from the previous path by a partial repath.
+		std::vector<uint32_t> nodes; // The current path.
+		std::vector<NavWaypoint> path; // The current path as waypoints.
+	};
+
+	/**
+	 * @brief A heap entry of the A* open list.
+	 */
+	struct OpenEntry
+	{
+		float f; // g + heuristic.
+		uint32_t node;
+	};
+
+	/**
+	 * @brief A resumable A* search. Node arrays are stamped so they never need clearing.
+	 */
+	struct Search
+	{
+		bool active = false;
+		bool done = false;
+		bool found = false;
+		uint32_t agent = 0, serial = 0;
+		int archetype = 0;
+		uint32_t start = 0, goal = 0;
+		uint32_t stamp = 0; // Current search generation.
+		uint64_t expansions = 0; // Expansions since the last update.
+		std::vector<OpenEntry> open; // Binary min-heap on f.
+		std::vector<float> g; // Best known cost per node.
+		std::vector<uint32_t> parent; // Predecessor per node.
+		std::vector<uint32_t> visited; // Stamp of the search that last touched a node.
+		std::vector<uint8_t> closed; // 1 once a node is expanded (valid when visited matches).
+	};
+
+	/**
+	 * @brief A cached path.
+	 */
+	struct CacheEntry
+	{
+		std::vector<uint32_t> nodes;
+		uint64_t lastUse;
+	};
+
+	const TileMap& map; // Room geometry.
+	std::vector<NavArchetype> archetypes; // Registered archetypes.
+	std::vector<NavGraph> graphs; // One graph per archetype.
+	std::vector<Agent> agents; // Indexed by agent id.
+	std::deque<uint32_t> pending; // Agents waiting for a search slot.
+	std::vector<Search> searches; // Search slots.
+	size_t activeCount = 0; // Searches in use.
+	std::unordered_map<uint64_t, CacheEntry> cache; // (archetype, start, goal) to path.
+	uint64_t useCounter = 0; // Clock for cache recency.
+	PathStats stats;
+
+	/**
+	 * @brief Starts the search of a queued agent in a free slot.
+	 * @param slot The search slot.
+	 * @param agent The agent id.
+	 */
+	void begin( int slot, uint32_t agent );
+	/**
+	 * @brief Expands nodes until the search ends or the deadline passes.
+	 * @param search The search to advance.
+	 * @param deadline The steady clock time (ns since epoch) to stop at.
+	 */
+	void advance( Search& search, int64_t deadline ) const;
+	/**
+	 * @brief Stores the result of a finished search and frees its slot.
+	 * @param slot The search slot.
+	 */
+	void finish( int slot );
+	/**
+	 * @brief Sets an agent's path from a list of nodes.
+	 * @param agent The agent.
+	 * @param nodes The path nodes.
+	 */
+	void assign( Agent& agent, std::vector<uint32_t> nodes );
+	/**
+	 * @brief Computes the cache key of a request.
+	 * @param archetype The archetype index.
+	 * @param start The start node.
+	 * @param goal The goal node.
+	 * @return The key.
+	 */
+	static uint64_t cacheKey( int archetype, uint32_t start, uint32_t goal ) {
+		return ( static_cast< uint64_t >( archetype ) << 48 ) | ( static_cast< uint64_t >( start ) << 24 ) | goal;
+	}
+	/**
+	 * @brief Inserts a path into the cache, evicting the least recently used entry if full.
+	 * @param key The cache key.
+	 * @param nodes The path.
+	 */
+	void store( uint64_t key, const std::vector<uint32_t>& nodes );
+};
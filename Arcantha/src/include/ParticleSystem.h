@@ -0,0 +1,226 @@
+#pragma once
+
+#include <cstdint> // Required for fixed-width integer types.
+#include <vector> // Required for the SoA columns and emitter list.
+
+#include <glm/glm.hpp> // Includes GLM for glm::vec2 positions and glm::mat4 projections.
+
+#include "Random.h" // Includes the deterministic generator emitters spawn with.
+#include "TileMap.h" // Includes the TileMap particles collide with.
+
+/**
+ * @brief One particle as the renderer reads it: one instance of a camera-facing quad.
+ */
+struct ParticleInstance
+{
+	float x, y; // Center in meters.
+	float size; // Diameter in meters.
+	uint32_t color; // RGBA8, red in the lowest byte.
+};
+
+/**
+ * @brief How an emitter spawns its particles and how they behave.
+ *
+ * Everything here is shared by the emitter's particles, so the update kernels
+ * read it once per emitter and never branch per particle.
+ */
+struct ParticleEmitterSettings
+{
+	uint32_t capacity = 4096; // Live particles at most; spawns beyond are dropped.
+	float rate = 0.0f; // Particles spawned per second while active.
+	glm::vec2 position = glm::vec2( 0.0f ); // Spawn point in meters.
+	float spawnRadius = 0.0f; // Particles spawn uniformly in this square half-extent around the position.
+	float direction = 1.5707963f; // Launch angle in radians, 0 along +X.
+	float spread = 3.1415927f; // Launch angles vary by up to this much either way.
+	float speedMin = 1.0f, speedMax = 2.0f; // Launch speed range in m/s.
+	float lifeMin = 0.5f, lifeMax = 1.0f; // Lifetime range in seconds.
+	glm::vec2 gravity = glm::vec2( 0.0f ); // Acceleration in m/s^2.
+	float drag = 0.0f; // Fraction of velocity lost per second.
+	float sizeStart = 0.1f, sizeEnd = 0.0f; // Diameter over the lifetime.
+	uint32_t colorStart = 0xFFFFFFFFu, colorEnd = 0x00FFFFFFu; // RGBA8 over the lifetime.
+	bool collide = false; // Bounce off solid tiles.
+	float bounce = 0.4f; // Vertical speed kept after hitting a tile.
+	float friction = 0.7f; // Horizontal speed kept after hitting a tile.
+	uint64_t seed = 1; // Spawn randomness; the same seed replays the same effect.
+};
+
+/**
+ * @brief Update kernel implementations, for comparing them.
+ */
+enum class ParticleKernel : uint8_t
+{
+	Scalar,
+	Sse, // Four particles per step; needs ARCANTHA_SIMD_SSE.
+	Avx // Eight particles per step; needs ARCANTHA_SIMD_AVX.
+};
+
+/**
+ * @brief Counters of the last update().
+ */
+struct ParticleStats
+{
+	uint32_t alive = 0; // Particles alive after the update.
+	uint32_t spawned = 0; // Particles spawned this update.
+	uint32_t expired = 0; // Particles removed this update.
+	uint32_t collisions = 0; // Particles that hit a tile this update.
+	double updateMs = 0.0; // Spawning, integration and compaction.
+	double writeMs = 0.0; // Color and size curves and instance output of the last writeInstances().
+};
+
+/**
+ * @brief Structure-of-arrays particle engine with SIMD kernels.
+ *
+ * Each emitter owns a pool of SoA columns (position, velocity, age and
+ * inverse lifetime) padded to a multiple of eight, so the kernels run over
+ * whole SSE or AVX registers with no scalar tail and no per-particle branch:
+ * integration, tile collision and the expiry test are masks and blends. Dead
+ * particles are removed by swapping the last live one into their slot.
+ *
+ * update() processes emitters in parallel on the JobSystem. The color and
+ * size curves are evaluated by writeInstances(), which writes interleaved
+ * instances straight to the destination (a mapped instance buffer in
+ * render()), again one job per emitter at offsets from a prefix sum.
+ */
+class ParticleSystem
+{
+public:
+	static const uint32_t LANES = 8; // Pool columns are padded to a multiple of this.
+
+	ParticleSystem();
+	ParticleSystem( const ParticleSystem& ) = delete;
+	ParticleSystem& operator=( const ParticleSystem& ) = delete;
+
+	/**
+	 * @brief Creates the shader and buffers. Requires a current OpenGL 3.3 context.
+	 * @return False if the shader fails to compile.
+	 */
+	bool initGL();
+	/**
+	 * @brief Deletes the GL objects. Requires the context that initGL() ran with.
+	 */
+	void shutdownGL();
+
+	/**
+	 * @brief Sets the tiles colliding emitters bounce off.
+	 * @param map The room, or nullptr for no collision.
+	 */
+	void setTileMap( const TileMap* map );
+	/**
+	 * @brief Selects the update kernel; unavailable ones fall back to the widest available.
+	 * @param kernel The kernel.
+	 */
+	void setKernel( ParticleKernel kernel );
+	/**
+	 * @brief Gets the kernel in use.
+	 * @return The kernel.
+	 */
+	ParticleKernel getKernel() const { return kernel; }
+
+	/**
+	 * @brief Adds an emitter.
+	 * @param settings Its settings.
+	 * @return The emitter index.
+	 */
+	uint32_t addEmitter( const ParticleEmitterSettings& settings );
+	/**
+	 * @brief Moves an emitter.
+	 * @param emitter The emitter.
+	 * @param position The new spawn point.
+	 */
+	void setEmitterPosition( uint32_t emitter, const glm::vec2& position );
+	/**
+	 * @brief Starts or stops continuous spawning; live particles are unaffected.
+	 * @param emitter The emitter.
+	 * @param active False to stop spawning.
+	 */
+	void setEmitterActive( uint32_t emitter, bool active );
+	/**
+	 * @brief Spawns particles at the next update, e.g. for a lightning strike.
+	 * @param emitter The emitter.
+	 * @param count Particles to spawn.
+	 */
+	void burst( uint32_t emitter, uint32_t count );
+
+	/**
+	 * @brief Spawns, moves and expires particles.
+	 * @param dt Time step in seconds.
+	 */
+	void update( float dt );
+	/**
+	 * @brief Writes every live particle as an instance.
+	 * @param out Room for getAliveCount() instances.
+	 * @return The number written.
+	 */
+	uint32_t writeInstances( ParticleInstance* out );
+	/**
+	 * @brief Draws every live particle with one instanced draw; requires initGL().
+	 * @param projection Transforms meters to clip space.
+	 */
+	void render( const glm::mat4& projection );
+
+	/**
+	 * @brief Gets the number of live particles.
+	 * @return The count.
+	 */
+	uint32_t getAliveCount() const;
+	/**
+	 * @brief Gets the counters.
+	 * @return The statistics.
+	 */
+	const ParticleStats& getStats() const { return stats; }
+
+private:
+	/**
+	 * @brief An emitter and its particle pool.
+	 */
+	struct Emitter
+	{
+		ParticleEmitterSettings settings;
+		Random random;
+		bool active = true;
+		float spawnDebt = 0.0f; // Fractional particles owed by the rate.
+		uint32_t pendingBurst = 0;
+		uint32_t count = 0; // Live particles, always at the front of the columns.
+		uint32_t offset = 0; // First instance in the output, from the prefix sum.
+		uint32_t spawned = 0, expired = 0, collisions = 0; // This update.
+		std::vector<float> x, y, vx, vy, age, invLife; // SoA columns, capacity rounded up to LANES.
+		std::vector<uint32_t> dead; // Indices that expired this update, ascending.
+	};
+
+	std::vector<Emitter> emitters;
+	ParticleKernel kernel;
+	ParticleStats stats;
+
+	std::vector<uint8_t> solid; // 1 for Solid tiles of the collision map.
+	int tilesWide = 0, tilesHigh = 0;
+	float inverseTileSize = 1.0f;
+
+	unsigned int program = 0, vao = 0, quadVbo = 0, instanceVbo = 0; // GL objects.
+	uint32_t instanceCapacity = 0; // Instances the buffer holds.
+	int projectionLocation = -1;
+	bool glReady = false;
+
+	/**
+	 * @brief Spawns the particles an emitter owes this update.
+	 * @param emitter The emitter.
+	 * @param dt Time step in seconds.
+	 */
+	void spawn( Emitter& emitter, float dt );
+	/**
+	 * @brief Integrates, collides and ages an emitter's particles and collects the expired ones.
+	 * @param emitter The emitter.
+	 * @param dt Time step in seconds.
+	 */
+	void integrate( Emitter& emitter, float dt );
+	/**
+	 * @brief Removes the expired particles by swapping live ones from the end into their slots.
+	 * @param emitter The emitter.
+	 */
+	void compact( Emitter& emitter );
+	/**
+	 * @brief Writes an emitter's particles as instances with the color and size curves applied.
+	 * @param emitter The emitter.
+	 * @param out Destination of the emitter's first instance.
+	 */
+	void writeEmitter( const Emitter& emitter, ParticleInstance* out ) const;
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <vector> // Required for std::vector to track created bodies.
+#include <cstdint> // Required for fixed-width integer types.
+
+#include <box2d/box2d.h> // Includes Box2D for the world, bodies and shapes.
+
+#include "TileMap.h" // Includes the TileMap class used to build static room geometry.
+
+/**
+ * @brief Collision category bits shared by every fixture created through PhysicsWorld.
+ */
+enum CollisionCategory : uint16_t
+{
+	CATEGORY_TILES = 0x0001, // Static room geometry.
+	CATEGORY_PLAYER = 0x0002, // The player character.
+	CATEGORY_ENEMY = 0x0004, // Enemies of any archetype.
+	CATEGORY_PROJECTILE = 0x0008, // Arrows, bolts and other fast movers.
+	CATEGORY_PICKUP = 0x0010, // Essence, Gold and other collectables.
+	CATEGORY_ALL = 0xFFFF
+};
+
+/**
+ * @brief Tunables for the fixed-step simulation.
+ */
+struct PhysicsSettings
+{
+	b2Vec2 gravity = b2Vec2( 0.0f, -20.0f ); // World gravity in m/s^2.
+	float timeStep = 1.0f / 60.0f; // Fixed simulation step in seconds.
+	int velocityIterations = 8; // Box2D velocity solver iterations.
+	int positionIterations = 3; // Box2D position solver iterations.
+	int maxSubSteps = 4; // Maximum fixed steps taken per call to step() to avoid a spiral of death.
+};
+
+/**
+ * @brief Parameters for creating a single-fixture body.
+ */
+struct BodyParams
+{
+	b2BodyType type = b2_dynamicBody; // Static, kinematic or dynamic.
+	b2Vec2 position = b2Vec2( 0.0f, 0.0f ); // Initial position of the body origin.
+	float density = 1.0f; // Fixture density in kg/m^2.
+	float friction = 0.3f; // Fixture friction coefficient.
+	uint16_t category = CATEGORY_ENEMY; // Collision category bits of the fixture.
+	uint16_t mask = CATEGORY_ALL; // Categories this fixture collides with.
+	bool fixedRotation = false; // Prevents the body from rotating (characters).
+	bool bullet = false; // Enables continuous collision against dynamic bodies.
+	float gravityScale = 1.0f; // Multiplier applied to world gravity.
+};
+
+/**
+ * @brief The PhysicsWorld class wraps a b2World with the game's fixed-step loop.
+ *
+ * It builds merged static geometry from a TileMap, creates bodies with the
+ * game's collision categories and keeps a creation-ordered list of bodies so
+ * other systems can address bodies by a stable index.
+ */
+class PhysicsWorld
+{
+public:
+	/**
+	 * @brief Constructor for the PhysicsWorld class.
+	 * @param settings The simulation settings to use.
+	 */
+	PhysicsWorld( const PhysicsSettings& settings = PhysicsSettings() );
+	/**
+	 * @brief Default destructor. The b2World destroys all bodies it owns.
+	 */
+	~PhysicsWorld() = default;
+	PhysicsWorld( const PhysicsWorld& ) = delete; // b2World cannot be copied.
+	PhysicsWorld& operator=( const PhysicsWorld& ) = delete;
+
+	/**
+	 * @brief Creates a static body holding the solid tiles of a map.
+	 *
+	 * Solid tiles are greedily merged into as few rectangles as possible before
+	 * fixtures are created, so a room costs tens of broadphase proxies rather
+	 * than one per tile. One-way platforms become edge fixtures on their top side
+	 * that only hold bodies coming down onto them: a body below the edge or
+	 * moving upward passes through, as does one marked with setDroppingThrough().
+	 * @param map The tile map to build geometry from.
+	 * @return The static body holding the room geometry.
+	 */
+	b2Body* createStaticTiles( const TileMap& map );
+	/**
+	 * @brief Creates a body with a single box fixture.
+	 * @param params The body and fixture parameters.
+	 * @param halfWidth Half of the box width in meters.
+	 * @param halfHeight Half of the box height in meters.
+	 * @return The created body.
+	 */
+	b2Body* createBox( const BodyParams& params, float halfWidth, float halfHeight );
+	/**
+	 * @brief Creates a body with a single circle fixture.
+	 * @param params The body and fixture parameters.
+	 * @param radius The circle radius in meters.
+	 * @return The created body.
+	 */
+	b2Body* createCircle( const BodyParams& params, float radius );
+	/**
+	 * @brief Destroys a body created by this world.
+	 * @param body The body to destroy.
+	 */
+	void destroyBody( b2Body* body );
+	/**
+	 * @brief Lets a body fall through one-way platforms, e.g. while it follows a drop-through link.
+	 * @param body The body.
+	 * @param dropping True to pass through platforms, false to land on them again.
+	 */
+	void setDroppingThrough( const b2Body* body, bool dropping );
+
+	/**
+	 * @brief Rebuilds another world as an exact structural copy of this one.
+	 *
+	 * Every body and fixture is recreated in the same creation order with the
+	 * same state, so a PhysicsSnapshot taken from this world can be restored
+	 * into the copy. Used to give background lookahead its own simulation.
+	 * @param other The world to overwrite.
+	 */
+	void mirrorInto( PhysicsWorld& other ) const;
+
+	/**
+	 * @brief Advances the simulation by a variable frame time using fixed steps.
+	 * @param dt The frame time in seconds.
+	 * @return The number of fixed steps taken.
+	 */
+	int step( double dt );
+	/**
+	 * @brief Advances the simulation by exactly one fixed step.
+	 */
+	void stepFixed();
+
+	/**
+	 * @brief Gets the underlying Box2D world.
+	 * @return A reference to the b2World.
+	 */
+	b2World& getWorld() { return world; }
+	/**
+	 * @brief Gets the underlying Box2D world.
+	 * @return A const reference to the b2World.
+	 */
+	const b2World& getWorld() const { return world; }
+	/**
+	 * @brief Gets all live bodies in creation order.
+	 * @return The list of bodies.
+	 */
+	const std::vector<b2Body*>& getBodies() const { return bodies; }
+	/**
+	 * @brief Gets the Box2D timing breakdown of the last fixed step.
+	 * @return The b2Profile of the last step.
+	 */
+	const b2Profile& getProfile() const { return world.GetProfile(); }
+	/**
+	 * @brief Gets a counter that changes whenever a body is created or destroyed.
+	 * @return The structure version.
+	 */
+	uint64_t getStructureVersion() const { return structureVersion; }
+	/**
+	 * @brief Gets the simulation settings.
+	 * @return The settings this world was created with.
+	 */
+	const PhysicsSettings& getSettings() const { return settings; }
+
+private:
+	/**
+	 * @brief Disables one-way platform contacts for bodies that are not landing on them.
+	 */
+	class PlatformFilter : public b2ContactListener
+	{
+	public:
+		/**
+		 * @brief Constructor for the PlatformFilter class.
+		 * @param owner The world whose dropping bodies are honored.
+		 */
+		explicit PlatformFilter( const PhysicsWorld& owner ) : owner( owner ) {}
+		/**
+		 * @brief Called by Box2D before solving each touching contact.
+		 * @param contact The contact, disabled for this step if it should pass through.
+		 * @param oldManifold The manifold of the previous step.
+		 */
+		void PreSolve( b2Contact* contact, const b2Manifold* oldManifold ) override;
+
+	private:
+		const PhysicsWorld& owner;
+	};
+
+	static const uintptr_t PLATFORM_FIXTURE = 1; // Fixture user data marking one-way platform edges.
+
+	PhysicsSettings settings; // Fixed-step settings.
+	b2World world; // The Box2D world that owns every body.
+	PlatformFilter platformFilter; // Installed as the world's contact listener.
+	std::vector<b2Body*> bodies; // Live bodies in creation order.
+	std::vector<const b2Body*> droppingBodies; // Bodies currently passing through one-way platforms.
+	double accumulator; // Unsimulated time carried over between frames.
+	uint64_t structureVersion; // Bumped on every body creation or destruction.
+
+	/**
+	 * @brief Creates a body and records it in the creation-ordered list.
+	 * @param params The body parameters.
+	 * @return The created body.
+	 */
+	b2Body* createBody( const BodyParams& params );
+	/**
+	 * @brief Attaches a fixture built from the given shape and parameters.
+	 * @param body The body to attach the fixture to.
+	 * @param shape The fixture shape.
+	 * @param params The fixture parameters.
+	 * @param userData The fixture's user data, PLATFORM_FIXTURE for one-way platforms.
+	 */
+	void createFixture( b2Body* body, const b2Shape& shape, const BodyParams& params, uintptr_t userData = 0 );
+};
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstdint> // Required for fixed-width integer types.
+#include <mutex> // Required to guard batch submission from worker threads.
+#include <vector> // Required for the flat query and result arrays.
+
+#include <box2d/box2d.h> // Includes Box2D for b2Vec2, b2AABB and b2Fixture.
+
+#include "Physics.h" // Includes PhysicsWorld and the collision categories.
+#include "TileMap.h" // Includes the TileMap the static slab test runs against.
+
+/**
+ * @brief A ray cast request.
+ */
+struct RayQuery
+{
+	b2Vec2 from; // Start point of the ray.
+	b2Vec2 to; // End point of the ray.
+	uint16_t mask = CATEGORY_ALL; // Categories the ray can hit.
+};
+
+/**
+ * @brief The closest hit of a ray, one per RayQuery in submission order.
+ *
+ * Rays starting inside solid tiles hit at fraction 0, so line of sight from
+ * within a wall is always blocked.
+ */
+struct RayHit
+{
+	b2Fixture* fixture = nullptr; // The fixture hit, or nullptr for tiles or no hit.
+	b2Vec2 point = b2Vec2( 0.0f, 0.0f ); // The hit point (the ray end when nothing was hit).
+	b2Vec2 normal = b2Vec2( 0.0f, 0.0f ); // The surface normal at the hit point.
+	float fraction = 1.0f; // Hit distance along the ray in [0, 1].
+	bool hit = false; // True if anything was hit.
+	bool hitTiles = false; // True if the closest hit was static tile geometry.
+};
+
+/**
+ * @brief An AABB overlap request.
+ */
+struct AabbQuery
+{
+	b2AABB box; // The box to test.
+	uint16_t mask = CATEGORY_ALL; // Categories to report.
+};
+
+/**
+ * @brief The overlaps of one AabbQuery, as a range into the flat overlap array.
+ */
+struct AabbResult
+{
+	uint32_t first = 0; // Index of the first overlapping fixture.
+	uint32_t count = 0; // Number of overlapping fixtures.
+	bool touchesTiles = false; // True if the box overlaps solid tiles.
+};
+
+/**
+ * @brief Throughput figures of the last execute() call.
+ */
+struct QueryStats
+{
+	size_t rays = 0; // Rays executed.
+	size_t aabbs = 0; // AABB queries executed.
+	double executeMs = 0.0; // Wall time of execute().
+	double queriesPerMs = 0.0; // (rays + aabbs) / executeMs.
+};
+
+/**
+ * @brief Batched ray and overlap queries for AI and combat.
+ *
+ * Gameplay code submits queries during the tick; execute() then runs every
+ * pending query across the JobSystem in one go. Dynamic bodies are found by
+ * walking the Box2D broadphase tree directly, which is only read, so the world
+ * must not be stepped or modified while execute() runs. Static tiles are
+ * removed from that walk and tested instead with 4-wide SIMD slab and overlap
+ * tests against the map's merged solid rectangles; the slab test also clips
+ * the tree walk to the nearest wall. Results live in flat arrays indexed by query ID until
+ * the next clear().
+ */
+class QueryService
+{
+public:
+	/**
+	 * @brief Constructor for the QueryService class.
+	 * @param world The physics world to query.
+	 */
+	explicit QueryService( const PhysicsWorld& world );
+
+	/**
+	 * @brief Sets the static tile geometry for the SIMD slab test.
+	 *
+	 * Tile fixtures in the broadphase are skipped from then on. Pass nullptr
+	 * to go back to querying tiles through Box2D.
+	 * @param map The room's tile map.
+	 */
+	void setTileMap( const TileMap* map );
+
+	/**
+	 * @brief Submits a single ray. Thread-safe.
+	 * @param query The ray to cast.
+	 * @return The ray's index into getRayHits().
+	 */
+	uint32_t submitRay( const RayQuery& query );
+	/**
+	 * @brief Submits a batch of rays under a single lock. Thread-safe.
+	 * @param queries The rays to cast.
+	 * @param count The number of rays.
+	 * @return The index of the first ray; the rest follow consecutively.
+	 */
+	uint32_t submitRays( const RayQuery* queries, size_t count );
+	/**
+	 * @brief Submits a single AABB query. Thread-safe.
+	 * @param query The box to test.
+	 * @return The query's index into getAabbResults().
+	 */
+	uint32_t submitAabb( const AabbQuery& query );
+	/**
+	 * @brief Submits a batch of AABB queries under a single lock. Thread-safe.
+	 * @param queries The boxes to test.
+	 * @param count The number of boxes.
+	 * @return The index of the first query; the rest follow consecutively.
+	 */
+	uint32_t submitAabbs( const AabbQuery* queries, size_t count );
+
+	/**
+	 * @brief Executes every submitted query in parallel.
+	 *
+	 * Must be called from the game thread while the physics world is idle.
+	 */
+	void execute();
+	/**
+	 * @brief Discards all queries and results, ready for the next tick.
+	 */
+	void clear();
+
+	/**
+	 * @brief Gets the ray results, indexed by the IDs returned from submitRay.
+	 * @return The flat array of hits.
+	 */
+	const std::vector<RayHit>& getRayHits() const { return rayHits; }
+	/**
+	 * @brief Gets the AABB results, indexed by the IDs returned from submitAabb.
+	 * @return The flat array of result ranges into getOverlaps().
+	 */
+	const std::vector<AabbResult>& getAabbResults() const { return aabbResults; }
+	/**
+	 * @brief Gets the fixtures found by all AABB queries, grouped per query.
+	 * @return The flat array of fixtures.
+	 */
+	const std::vector<b2Fixture*>& getOverlaps() const { return overlaps; }
+	/**
+	 * @brief Gets the throughput figures of the last execute().
+	 * @return The query statistics.
+	 */
+	const QueryStats& getStats() const { return stats; }
+
+private:
+	const PhysicsWorld& world; // The world whose broadphase is queried.
+	const TileMap* tileMap; // The static geometry, or nullptr.
+
+	// Merged solid tile rectangles in world space, SoA and padded to a multiple of 4.
+	std::vector<float> solidMinX, solidMinY, solidMaxX, solidMaxY;
+	// Top edges of one-way platforms; only rays travelling downwards test these.
+	std::vector<float> platformMinX, platformMinY, platformMaxX, platformMaxY;
+
+	std::mutex submitMutex; // Guards rays and aabbs during submission.
+	std::vector<RayQuery> rays; // Submitted rays.
+	std::vector<AabbQuery> aabbs; // Submitted AABB queries.
+
+	std::vector<RayHit> rayHits; // One result per ray.
+	std::vector<AabbResult> aabbResults; // One result range per AABB query.
+	std::vector<b2Fixture*> overlaps; // Fixtures of all AABB queries, grouped per query.
+	std::vector<std::vector<b2Fixture*>> chunkOverlaps; // Per-chunk scratch merged into overlaps.
+	QueryStats stats; // Figures of the last execute().
+
+	/**
+	 * @brief Casts one ray against the tiles and the broadphase.
+	 * @param query The ray.
+	 * @param hit Receives the closest hit.
+	 */
+	void castRay( const RayQuery& query, RayHit& hit ) const;
+	/**
+	 * @brief Runs one AABB query against the tiles and the broadphase.
+	 * @param query The box.
+	 * @param result Receives the tile flag and the count of appended fixtures.
+	 * @param out The list the overlapping fixtures are appended to.
+	 */
+	void queryAabb( const AabbQuery& query, AabbResult& result, std::vector<b2Fixture*>& out ) const;
+};
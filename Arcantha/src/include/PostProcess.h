@@ -0,0 +1,380 @@
+#pragma once
+
+#include <cstdint> // Required for fixed-width integer types.
+#include <vector> // Required for the target, pass and timing arrays.
+
+#include <glm/glm.hpp> // Includes GLM for glm::vec3 grading colors.
+
+/**
+ * @brief Pixel formats of pooled render targets.
+ */
+enum class TargetFormat : uint8_t
+{
+	Rgba8, // 4 bytes; LDR.
+	R11G11B10F, // 4 bytes; HDR without alpha, half the bandwidth of Rgba16F.
+	Rgba16F // 8 bytes; HDR.
+};
+
+/**
+ * @brief The size and format of a render target; targets with equal descriptions are interchangeable.
+ */
+struct RenderTargetDesc
+{
+	int width = 0, height = 0;
+	TargetFormat format = TargetFormat::Rgba8;
+
+	bool operator==( const RenderTargetDesc& other ) const { return width == other.width && height == other.height && format == other.format; }
+};
+
+/**
+ * @brief Counters of a RenderTargetPool.
+ */
+struct RenderTargetPoolStats
+{
+	uint32_t targets = 0; // Targets the pool owns.
+	uint32_t inUse = 0; // Targets acquired and not released.
+	uint64_t created = 0; // Over the pool's lifetime.
+	uint64_t reused = 0; // Acquires served by an existing target.
+	uint64_t evicted = 0; // Targets deleted after going unused.
+	uint64_t bytes = 0; // Memory of the owned targets.
+};
+
+/**
+ * @brief Render targets shared by every pass that needs a temporary image.
+ *
+ * acquire() hands out a free target of the same size and format if there is
+ * one and only creates a new one otherwise, so a chain that runs every frame
+ * allocates nothing after its first frame. Targets left unused for
+ * EVICT_FRAMES frames, e.g. the old sizes after a resize, are deleted by
+ * endFrame().
+ *
+ * Without setGLEnabled( true ) the pool only does the bookkeeping, so its
+ * behavior can be measured headless.
+ */
+class RenderTargetPool
+{
+public:
+	static const uint64_t EVICT_FRAMES = 120; // Frames a free target survives.
+
+	RenderTargetPool() = default;
+	RenderTargetPool( const RenderTargetPool& ) = delete;
+	RenderTargetPool& operator=( const RenderTargetPool& ) = delete;
+
+	/**
+	 * @brief Turns creating GL objects on or off; turning it off deletes every target.
+	 * @param enabled True once a GL 3.3 context is current.
+	 */
+	void setGLEnabled( bool enabled );
+	/**
+	 * @brief Gets a target for the caller's exclusive use.
+	 * @param desc The size and format.
+	 * @return The handle, valid until release(); -1 if the framebuffer is incomplete.
+	 */
+	int acquire( const RenderTargetDesc& desc );
+	/**
+	 * @brief Returns a target to the pool.
+	 * @param handle A handle from acquire().
+	 */
+	void release( int handle );
+	/**
+	 * @brief Ages the free targets and deletes the ones unused for EVICT_FRAMES frames.
+	 */
+	void endFrame();
+	/**
+	 * @brief Deletes every target; handles must not be used afterwards.
+	 */
+	void clear();
+
+	/**
+	 * @brief Gets a target's framebuffer.
+	 * @param handle A handle from acquire().
+	 * @return The GL framebuffer, 0 without GL.
+	 */
+	unsigned int getFramebuffer( int handle ) const { return entries[ handle ].fbo; }
+	/**
+	 * @brief Gets a target's color texture.
+	 * @param handle A handle from acquire().
+	 * @return The GL texture, 0 without GL.
+	 */
+	unsigned int getTexture( int handle ) const { return entries[ handle ].texture; }
+	/**
+	 * @brief Gets a target's description.
+	 * @param handle A handle from acquire().
+	 * @return The size and format.
+	 */
+	const RenderTargetDesc& getDesc( int handle ) const { return entries[ handle ].desc; }
+	/**
+	 * @brief Gets the counters.
+	 * @return The statistics.
+	 */
+	const RenderTargetPoolStats& getStats() const { return stats; }
+
+	/**
+	 * @brief Gets the bytes per pixel of a format.
+	 * @param format The format.
+	 * @return 4 or 8.
+	 */
+	static uint32_t bytesPerPixel( TargetFormat format ) { return format == TargetFormat::Rgba16F ? 8u : 4u; }
+
+private:
+	/**
+	 * @brief A pooled target; a width of 0 marks an empty slot.
+	 */
+	struct Entry
+	{
+		RenderTargetDesc desc;
+		unsigned int fbo = 0, texture = 0;
+		bool inUse = false;
+		uint64_t lastUsed = 0; // Frame of the last acquire.
+	};
+
+	std::vector<Entry> entries; // Slots are reused, so handles stay small and stable.
+	uint64_t frame = 0;
+	bool glEnabled = false;
+	RenderTargetPoolStats stats;
+
+	/**
+	 * @brief Creates a slot's GL objects.
+	 * @param entry The slot, with its description set.
+	 * @return False if the framebuffer is incomplete.
+	 */
+	bool createGL( Entry& entry );
+	/**
+	 * @brief Deletes a slot's GL objects and empties it.
+	 * @param entry The slot.
+	 */
+	void destroy( Entry& entry );
+};
+
+/**
+ * @brief How much the post-processing chain may cost.
+ */
+enum class PostQuality : uint8_t
+{
+	Off, // Tone mapping only.
+	Low, // Short bloom chain from quarter resolution, grading; for integrated GPUs.
+	Medium, // Bloom from half resolution, grading and vignette.
+	High // Longer bloom chain and a 16-bit float scene.
+};
+
+/**
+ * @brief What a quality preset enables.
+ */
+struct PostQualitySettings
+{
+	int bloomLevels = 0; // Mips of the bloom chain; 0 disables bloom.
+	int bloomDivisor = 2; // The first bloom mip's size relative to the screen.
+	TargetFormat sceneFormat = TargetFormat::R11G11B10F;
+	bool grading = false;
+	bool vignette = false;
+};
+
+/**
+ * @brief Artistic parameters of the chain, independent of the quality preset.
+ */
+struct PostSettings
+{
+	float bloomThreshold = 1.0f; // Scene brightness where bloom starts.
+	float bloomKnee = 0.5f; // Width of the soft transition around the threshold.
+	float bloomIntensity = 0.6f;
+	float bloomRadius = 1.0f; // Scale of the upsampling tent filter, in source texels.
+	float exposure = 1.0f;
+	glm::vec3 lift = glm::vec3( 0.0f ), gamma = glm::vec3( 1.0f ), gain = glm::vec3( 1.0f );
+	float saturation = 1.0f;
+	float vignette = 0.35f; // Darkening at the corners.
+};
+
+/**
+ * @brief What a post-processing pass does.
+ */
+enum class PostPassKind : uint8_t
+{
+	Prefilter, // Bloom threshold merged into the first downsample.
+	Downsample, // 13-tap filter into the next smaller mip.
+	Upsample, // Tent filter added onto the next larger mip.
+	Composite // Bloom, tone mapping, grading and vignette in one shader, onto the output.
+};
+
+/**
+ * @brief One pass of a compiled chain.
+ */
+struct PostPass
+{
+	PostPassKind kind;
+	int source; // Plan target read, 0 being the scene.
+	int target; // Plan target written, -1 for the output framebuffer.
+	int width, height; // Of the written image.
+	uint64_t fragments; // Pixels shaded.
+	uint64_t bytes; // Estimated memory traffic: source read once, target written (and read when blending).
+};
+
+/**
+ * @brief A compiled chain: the targets it needs and its passes in order.
+ */
+struct PostPlan
+{
+	int width = 0, height = 0;
+	std::vector<RenderTargetDesc> targets; // 0 is the scene, then the bloom mips from largest to smallest.
+	std::vector<PostPass> passes;
+	uint32_t compositeFeatures = 0; // PostProcess::FEATURE_* bits of the merged composite shader.
+	uint64_t fragments = 0, bytes = 0; // Sums over the passes.
+};
+
+/**
+ * @brief Counters of the last PostProcess::endScene().
+ */
+struct PostStats
+{
+	uint32_t passes = 0;
+	uint32_t drawCalls = 0;
+	std::vector<double> passGpuMs; // Per pass of the plan, read GPU_QUERIES frames late.
+	double gpuMs = 0.0; // Sum of passGpuMs.
+	double cpuMs = 0.0;
+};
+
+/**
+ * @brief The post-processing chain between the scene and the default framebuffer.
+ *
+ * beginScene() binds a pooled HDR target the scene is drawn into;
+ * endScene() runs the chain compiled for the current quality preset and
+ * size and writes the result to the framebuffer that was bound before.
+ *
+ * Bloom is a progressive chain: the scene is downsampled mip by mip with the
+ * threshold merged into the first step, then upsampled back with each mip
+ * added onto the next larger one, so the blur is wide while every pass works
+ * at a fraction of the screen. Everything that works per pixel on the final
+ * image (bloom add, tone mapping, grading, vignette) is one composite shader,
+ * built from #defines per feature set, so a preset pays one full-resolution
+ * pass however many of those effects it enables. buildPlan() gives the
+ * passes and their pixel and bandwidth cost for any size and preset without
+ * a GL context.
+ *
+ * Every pass is timed with a GL_TIME_ELAPSED query, read back GPU_QUERIES
+ * frames later so the CPU never waits on the GPU.
+ */
+class PostProcess
+{
+public:
+	static const int MAX_BLOOM_LEVELS = 8;
+	static const int MAX_PASSES = 2 * MAX_BLOOM_LEVELS + 1;
+	static const int GPU_QUERIES = 4; // Frames of timer queries in flight.
+	static const uint32_t FEATURE_BLOOM = 1, FEATURE_GRADING = 2, FEATURE_VIGNETTE = 4;
+
+	PostProcess() = default;
+	PostProcess( const PostProcess& ) = delete;
+	PostProcess& operator=( const PostProcess& ) = delete;
+
+	/**
+	 * @brief Creates the shaders and queries. Requires a current OpenGL 3.3 context.
+	 * @param width The screen's width in pixels.
+	 * @param height The screen's height in pixels.
+	 * @return False if a shader fails to compile.
+	 */
+	bool initGL( int width, int height );
+	/**
+	 * @brief Deletes the GL objects and pooled targets. Requires the context that initGL() ran with.
+	 */
+	void shutdownGL();
+	/**
+	 * @brief Resizes the chain; the old targets are evicted once unused.
+	 * @param width The new width in pixels.
+	 * @param height The new height in pixels.
+	 */
+	void resize( int width, int height );
+	/**
+	 * @brief Picks a quality preset.
+	 * @param quality The preset.
+	 */
+	void setQuality( PostQuality quality );
+	/**
+	 * @brief Sets the artistic parameters.
+	 * @param settings The parameters.
+	 */
+	void setSettings( const PostSettings& settings ) { this->settings = settings; }
+
+	/**
+	 * @brief Binds the scene target; draw the scene after this.
+	 * @return False if post-processing is unavailable and the scene should be drawn straight to the screen.
+	 */
+	bool beginScene();
+	/**
+	 * @brief Runs the chain onto the framebuffer that was bound at beginScene().
+	 */
+	void endScene();
+
+	/**
+	 * @brief Gets the current quality preset.
+	 * @return The preset.
+	 */
+	PostQuality getQuality() const { return quality; }
+	/**
+	 * @brief Gets the compiled chain.
+	 * @return The plan for the current size and preset.
+	 */
+	const PostPlan& getPlan() const { return plan; }
+	/**
+	 * @brief Gets the counters.
+	 * @return The statistics.
+	 */
+	const PostStats& getStats() const { return stats; }
+	/**
+	 * @brief Gets the render target pool.
+	 * @return The pool, shared with other passes that need temporary targets.
+	 */
+	RenderTargetPool& getPool() { return pool; }
+
+	/**
+	 * @brief Gets what a quality preset enables.
+	 * @param quality The preset.
+	 * @return Its settings.
+	 */
+	static PostQualitySettings settingsFor( PostQuality quality );
+	/**
+	 * @brief Compiles the chain for a size and preset.
+	 * @param width The screen's width in pixels.
+	 * @param height The screen's height in pixels.
+	 * @param quality What the preset enables.
+	 * @return The targets and passes.
+	 */
+	static PostPlan buildPlan( int width, int height, const PostQualitySettings& quality );
+
+private:
+	RenderTargetPool pool;
+	PostQuality quality = PostQuality::Medium;
+	PostSettings settings;
+	PostPlan plan;
+	PostStats stats;
+	int width = 1, height = 1;
+	std::vector<int> handles; // Pool handles of the plan's targets this frame.
+	int sceneHandle = -1;
+	int outputFbo = 0, outputViewport[ 4 ] = {}; // Bound when beginScene() ran.
+
+	unsigned int downsampleProgram = 0, upsampleProgram = 0, emptyVao = 0; // GL objects.
+	/**
+	 * @brief A composite shader variant and its uniform locations, looked up once after linking.
+	 */
+	struct CompositeProgram
+	{
+		unsigned int program = 0;
+		int bloomIntensityLocation = -1, exposureLocation = -1, liftLocation = -1, gammaLocation = -1, gainLocation = -1;
+		int saturationLocation = -1, vignetteLocation = -1;
+	};
+
+	CompositeProgram compositePrograms[ 8 ]; // Per feature set, built on first use.
+	int downsampleTexelLocation = -1, thresholdLocation = -1, kneeLocation = -1, upsampleTexelLocation = -1, radiusLocation = -1;
+	unsigned int queries[ GPU_QUERIES ][ MAX_PASSES ] = {}; // GL_TIME_ELAPSED queries, one frame per row, used round robin.
+	int queryPasses[ GPU_QUERIES ] = {}; // Passes timed in each row; 0 when nothing is pending.
+	int queryIndex = 0;
+	bool glReady = false;
+
+	/**
+	 * @brief Recompiles the plan after a size or preset change.
+	 */
+	void rebuildPlan();
+	/**
+	 * @brief Gets the composite shader of a feature set, building it on first use.
+	 * @param features FEATURE_* bits.
+	 * @return The program with its uniform locations; the program is 0 if it fails to build.
+	 */
+	const CompositeProgram& compositeProgram( uint32_t features );
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint> // Required for fixed-width integer types.
+
+/**
+ * @brief The complete state of a Random generator, plain data so it can be snapshotted by copy.
+ */
+struct RandomState
+{
+	uint64_t s[ 4 ]; // xoshiro256** state words.
+};
+
+/**
+ * @brief Deterministic xoshiro256** random number generator.
+ *
+ * Every gameplay system that needs randomness must draw from a Random it owns
+ * (or one derived from a seed with Random::derive), never from std::rand, so a
+ * seed fully determines a run and the state can be captured and restored.
+ */
+class Random
+{
+public:
+	/**
+	 * @brief Constructor for the Random class.
+	 * @param seed The seed; expanded to the full state with splitmix64.
+	 */
+	explicit Random( uint64_t seed = 0x5EEDu ) { reseed( seed ); }
+
+	/**
+	 * @brief Resets the generator from a seed.
+	 * @param seed The seed.
+	 */
+	void reseed( uint64_t seed ) {
+		for ( uint64_t& word : state.s ) word = splitMix( seed );
+	}
+
+	/**
+	 * @brief Creates an independent stream for a sub-task from a parent seed and a stream index.
+	 *
+	 * Used to give every parallel work item its own generator so results do
+	 * not depend on which thread runs which item.
+	 * @param seed The parent seed.
+	 * @param stream The index of the work item.
+	 * @return A generator unique to (seed, stream).
+	 */
+	static Random derive( uint64_t seed, uint64_t stream ) {
+		uint64_t mixed = seed ^ ( stream * 0x9E3779B97F4A7C15ull );
+		return Random( splitMix( mixed ) );
+	}
+
+	/**
+	 * @brief Gets the next 64 random bits.
+	 * @return A uniformly distributed 64-bit value.
+	 */
+	uint64_t nextU64() {
+		uint64_t* s = state.s;
+		const uint64_t result = rotl( s[ 1 ] * 5, 7 ) * 9;
+		const uint64_t t = s[ 1 ] << 17;
+		s[ 2 ] ^= s[ 0 ];
+		s[ 3 ] ^= s[ 1 ];
+		s[ 1 ] ^= s[ 2 ];
+		s[ 0 ] ^= s[ 3 ];
+		s[ 2 ] ^= t;
+		s[ 3 ] = rotl( s[ 3 ], 45 );
+		return result;
+	}
+	/**
+	 * @brief Gets the next 32 random bits.
+	 * @return A uniformly distributed 32-bit value.
+	 */
+	uint32_t nextU32() { return static_cast< uint32_t >( nextU64() >> 32 ); }
+	/**
+	 * @brief Gets a float in [0, 1).
+	 * @return A uniformly distributed float.
+	 */
+	float nextFloat() { return ( nextU64() >> 40 ) * ( 1.0f / 16777216.0f ); }
+	/**
+	 * @brief Gets a float in [min, max).
+	 * @param min The inclusive lower bound.
+	 * @param max The exclusive upper bound.
+	 * @return A uniformly distributed float.
+	 */
+	float range( float min, float max ) { return min + ( max - min ) * nextFloat(); }
+	/**
+	 * @brief Gets an integer in [min, max].
+	 * @param min The inclusive lower bound.
+	 * @param max The inclusive upper bound.
+	 * @return A uniformly distributed integer (modulo bias is negligible for game ranges).
+	 */
+	int range( int min, int max ) {
+		return min + static_cast< int >( nextU64() % static_cast< uint64_t >( max - min + 1 ) );
+	}
+
+	/**
+	 * @brief Gets the generator state.
+	 * @return A copy of the state.
+	 */
+	const RandomState& getState() const { return state; }
+	/**
+	 * @brief Restores a previously captured state.
+	 * @param newState The state to restore.
+	 */
+	void setState( const RandomState& newState ) { state = newState; }
+
+private:
+	RandomState state; // The generator state.
+
+	static uint64_t rotl( uint64_t x, int k ) { return ( x << k ) | ( x >> ( 64 - k ) ); }
+	static uint64_t splitMix( uint64_t& x ) {
+		uint64_t z = ( x += 0x9E3779B97F4A7C15ull );
+		z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+		z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+		return z ^ ( z >> 31 );
+	}
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <atomic> // Required for the committed generation read by the game thread.
+#include <condition_variable> // Required to wake the writer thread.
+#include <cstdint> // Required for fixed-width integer types.
+#include <functional> // Required for std::function migrations.
+#include <memory> // Required for std::unique_ptr save jobs.
+#include <mutex> // Required to guard the hand-off to the writer thread.
+#include <string> // Required for std::string paths.
+#include <thread> // Required for the writer thread.
+#include <vector> // Required for the section arrays.
+
+#include "Snapshot.h" // Includes the copy-on-write PagedBuffer that sections are stored in.
+
+/**
+ * @brief Converts a section saved with an older version into the current layout.
+ *
+ * Receives the saved version and payload and fills the registered buffer.
+ * Returns false if the data cannot be converted.
+ */
+using SaveMigration = std::function<bool( uint16_t savedVersion, const uint8_t* data, size_t size, PagedBuffer& buffer )>;
+
+/**
+ * @brief Counters of a SaveSystem.
+ */
+struct SaveStats
+{
+	uint64_t saves = 0; // Calls to save() that took a snapshot.
+	uint64_t coalesced = 0; // Snapshots replaced by a newer one before they were written.
+	uint64_t commits = 0; // Manifests committed.
+	uint64_t failures = 0; // Writes that failed; the previous save stays current.
+	uint64_t sectionsWritten = 0; // Chunk files written.
+	uint64_t sectionsSkipped = 0; // Sections unchanged since the last commit and not rewritten.
+	uint64_t bytesWritten = 0; // Chunk and manifest bytes written.
+	double lastSnapshotUs = 0.0; // Game thread cost of the last save() call.
+	double lastWriteMs = 0.0; // Writer thread time of the last commit, including fsync.
+};
+
+/**
+ * @brief Crash-safe binary saves written in the background.
+ *
+ * Saved state lives in PagedBuffers (for example PagedArray columns of
+ * progression records), each registered as a section with an id and a
+ * schema version. save() runs on the game thread and only copies page
+ * pointers, which takes microseconds; the writer thread then serializes,
+ * checksums and fsyncs the data.
+ *
+ * A save directory holds one chunk file per section and a manifest that
+ * lists the current chunk of every section. Only sections with a page written
+ * since the last commit get a new chunk file; the others keep pointing at
+ * their old chunk. The manifest is written to a temporary file, fsynced and
+ * renamed over the old one, which is the commit point: a crash at any moment
+ * leaves either the old or the new manifest, and every chunk either one
+ * refers to is complete on disk. Superseded chunks are deleted only after
+ * the commit.
+ *
+ * load() maps the manifest and chunks and verifies every checksum before
+ * copying anything into the sections.
+ *
+ * Call everything from the game thread.
+ */
+class SaveSystem
+{
+public:
+	static const uint32_t FORMAT_VERSION = 1; // Version of the file layout itself.
+
+	SaveSystem() = default;
+	/**
+	 * @brief Destructor; waits for queued saves to be written.
+	 */
+	~SaveSystem();
+	SaveSystem( const SaveSystem& ) = delete;
+	SaveSystem& operator=( const SaveSystem& ) = delete;
+
+	/**
+	 * @brief Registers a section. Register every section before open().
+	 * @param id A unique section id, e.g. a four character code.
+	 * @param version The schema version of the section's element layout.
+	 * @param buffer The section data; must outlive the SaveSystem.
+	 * @param migration Optional conversion of older versions.
+	 */
+	void registerSection( uint32_t id, uint16_t version, PagedBuffer* buffer, SaveMigration migration = nullptr );
+
+	/**
+	 * @brief Opens a save directory, creating it if needed, and starts the writer thread.
+	 *
+	 * Chunk files left behind by a save that was interrupted before its
+	 * commit are deleted.
+	 * @param directory The save slot's directory.
+	 * @return False if the directory cannot be created.
+	 */
+	bool open( const std::string& directory );
+	/**
+	 * @brief Writes any queued save and stops the writer thread.
+	 */
+	void close();
+
+	/**
+	 * @brief Snapshots every section and queues it for writing.
+	 *
+	 * If the writer is still busy with an earlier save, the snapshot waits in
+	 * the queue, replacing any older one waiting there, so only the newest is
+	 * written.
+	 * @return False if the system is not open.
+	 */
+	bool save();
+	/**
+	 * @brief Blocks until every queued save has been committed or has failed.
+	 */
+	void flush();
+	/**
+	 * @brief Loads the last committed save into the registered sections.
+	 *
+	 * Waits for queued saves first. Nothing is modified unless every chunk
+	 * is present, intact and of a version that is current or can be migrated.
+	 * Sections missing from the save are left as they are.
+	 * @return False if there is no save or it cannot be read.
+	 */
+	bool load();
+
+	/**
+	 * @brief Gets the generation of the last committed save.
+	 * @return The generation, 0 if nothing has been saved in this directory.
+	 */
+	uint64_t getCommittedGeneration() const { return committed.load( std::memory_order_acquire ); }
+	/**
+	 * @brief Gets the counters.
+	 * @return A copy of the statistics.
+	 */
+	SaveStats getStats() const;
+
+private:
+	/**
+	 * @brief A registered section.
+	 */
+	struct Section
+	{
+		uint32_t id;
+		uint16_t version;
+		PagedBuffer* buffer;
+		SaveMigration migration;
+	};
+
+	/**
+	 * @brief One manifest entry: where the current data of a section is.
+	 */
+	struct Entry
+	{
+		uint32_t id;
+		uint16_t version;
+		uint16_t elementSize;
+		uint64_t generation; // Generation of the chunk file that holds the data.
+		uint64_t size; // Payload bytes.
+		uint32_t crc; // CRC-32 of the payload.
+	};
+
+	/**
+	 * @brief A snapshot waiting to be written.
+	 */
+	struct Job
+	{
+		std::vector<PagedBuffer> buffers; // Copy-on-write copies of the sections, in registration order.
+	};
+
+	std::vector<Section> sections; // Registered sections.
+	std::string directory; // Open save directory, empty when closed.
+
+	std::thread thread; // The writer thread.
+	mutable std::mutex mutex; // Guards everything below that the writer thread touches.
+	std::condition_variable wake; // Signals the writer that a job is queued or it should stop.
+	std::condition_variable idle; // Signals flush() that the writer has nothing left.
+	std::unique_ptr<Job> queued; // Newest snapshot not yet picked up.
+	bool writing = false; // The writer is working on a job.
+	bool running = false; // The writer thread is alive.
+	SaveStats stats;
+	std::atomic<uint64_t> committed{ 0 }; // Generation of the current manifest.
+
+	// Writer thread state: the last committed snapshot and manifest.
+	std::vector<PagedBuffer> previous; // Sections as of the last commit; pages they share with a new snapshot are unchanged.
+	std::vector<Entry> entries; // Manifest of the last commit.
+	uint64_t nextGeneration = 1; // Generation of the next write; never reused, so a failed write cannot overwrite a committed chunk.
+
+	/**
+	 * @brief The writer thread: writes queued jobs until stopped.
+	 */
+	void threadLoop();
+	/**
+	 * @brief Writes changed sections and commits a new manifest.
+	 * @param job The snapshot to write.
+	 * @return False if any file operation failed.
+	 */
+	bool write( Job& job );
+	/**
+	 * @brief Reads and verifies the manifest of the open directory.
+	 * @param result Receives the entries.
+	 * @param generation Receives the manifest's generation.
+	 * @return False if there is no manifest or it is damaged.
+	 */
+	bool readManifest( std::vector<Entry>& result, uint64_t& generation ) const;
+	/**
+	 * @brief Gets the path of a chunk file.
+	 * @param id The section id.
+	 * @param generation The generation the chunk was written in.
+	 * @return The path.
+	 */
+	std::string chunkPath( uint32_t id, uint64_t generation ) const;
+	/**
+	 * @brief Deletes chunk files the current manifest does not refer to.
+	 */
+	void removeStrayChunks() const;
+};
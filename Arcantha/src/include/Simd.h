@@ -0,0 +1,21 @@
+#pragma once
+
+// Compile-time SIMD capability detection shared by the engine's vectorized kernels.
+//
+// ARCANTHA_SIMD_SSE is 1 when SSE2 intrinsics are available (always on x86-64),
+// ARCANTHA_SIMD_AVX is 1 when the compiler targets AVX (e.g. -mavx or /arch:AVX).
+// Kernels must keep a scalar path for builds where neither is set.
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define ARCANTHA_SIMD_SSE 1
+#include <emmintrin.h> // SSE2 intrinsics.
+#else
+#define ARCANTHA_SIMD_SSE 0
+#endif
+
+#if defined( __AVX__ )
+#define ARCANTHA_SIMD_AVX 1
+#include <immintrin.h> // AVX intrinsics.
+#else
+#define ARCANTHA_SIMD_AVX 0
+#endif
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <atomic> // Required for the acquire fence before writing an unshared page.
+#include <cstddef> // Required for size_t.
+#include <cstdint> // Required for fixed-width integer types.
+#include <functional> // Required for std::function lookahead callbacks.
+#include <memory> // Required for std::shared_ptr copy-on-write pages.
+#include <type_traits> // Required for std::is_trivially_copyable.
+#include <vector> // Required for std::vector page and state arrays.
+
+#include "JobSystem.h" // Includes JobCounter to track the background lookahead.
+#include "Physics.h" // Includes the PhysicsWorld captured in snapshots.
+#include "Random.h" // Includes the RandomState captured in snapshots.
+
+/**
+ * @brief A growable array of fixed-size elements stored in copy-on-write pages.
+ *
+ * Copying a PagedBuffer only copies page pointers, so it is the snapshot
+ * operation: O(pages), no element data is touched. The first write to a page
+ * that is still shared with a snapshot copies that page alone. Elements must
+ * be trivially copyable since pages are duplicated with memcpy.
+ */
+class PagedBuffer
+{
+public:
+	static const size_t PAGE_BYTES = 16384; // Size of one page; a few pages cover a room's worth of a component.
+
+	/**
+	 * @brief Constructor for the PagedBuffer class.
+	 * @param elementSize The size of one element in bytes, from 1 to PAGE_BYTES.
+	 */
+	explicit PagedBuffer( size_t elementSize = 1 );
+
+	/**
+	 * @brief Resizes the buffer; new elements are zeroed.
+	 * @param count The new element count.
+	 */
+	void resize( size_t count );
+	/**
+	 * @brief Gets read-only access to an element. Never copies.
+	 * @param index The element index.
+	 * @return A pointer to the element.
+	 */
+	const void* read( size_t index ) const {
+		return pages[ index / perPage ]->bytes + ( index % perPage ) * elementSize;
+	}
+	/**
+	 * @brief Gets writable access to an element, copying its page first if it is shared.
+	 *
+	 * use_count() is a relaxed load, so seeing 1 does not order this write
+	 * after the reads of a snapshot released on another thread (a background
+	 * lookahead); the acquire fence pairs with that release.
+	 * @param index The element index.
+	 * @return A pointer to the element.
+	 */
+	void* write( size_t index ) {
+		std::shared_ptr<Page>& page = pages[ index / perPage ];
+		if ( page.use_count() > 1 ) detach( page );
+		else std::atomic_thread_fence( std::memory_order_acquire );
+		return page->bytes + ( index % perPage ) * elementSize;
+	}
+
+	/**
+	 * @brief Gets the number of elements.
+	 * @return The element count.
+	 */
+	size_t size() const { return count; }
+	/**
+	 * @brief Gets the number of pages.
+	 * @return The page count.
+	 */
+	size_t getPageCount() const { return pages.size(); }
+	/**
+	 * @brief Gets the bytes of one page. Two buffers share a page if they return the same pointer.
+	 * @param page The page index.
+	 * @return A pointer to the page's first element.
+	 */
+	const void* getPageData( size_t page ) const { return pages[ page ]->bytes; }
+	/**
+	 * @brief Gets the size of one element.
+	 * @return The element size in bytes.
+	 */
+	size_t getElementSize() const { return elementSize; }
+	/**
+	 * @brief Gets the number of elements stored per page.
+	 * @return The elements per page.
+	 */
+	size_t getElementsPerPage() const { return perPage; }
+	/**
+	 * @brief Gets the number of pages shared with at least one other buffer.
+	 * @return The shared page count.
+	 */
+	size_t getSharedPageCount() const;
+
+private:
+	/**
+	 * @brief One page of element storage.
+	 */
+	struct Page
+	{
+		alignas( 64 ) unsigned char bytes[ PAGE_BYTES ];
+	};
+
+	std::vector<std::shared_ptr<Page>> pages; // Element storage, possibly shared with snapshots.
+	size_t elementSize; // Bytes per element.
+	size_t perPage; // Elements per page.
+	size_t count; // Number of elements.
+
+	/**
+	 * @brief Replaces a shared page by a private copy.
+	 * @param page The page slot to detach.
+	 */
+	static void detach( std::shared_ptr<Page>& page );
+};
+
+/**
+ * @brief Typed view over a PagedBuffer, used for SoA gameplay component columns.
+ *
+ * Store one PagedArray per component field (e.g. health, stamina, state
+ * timers) and register its buffer with a SnapshotRegistry.
+ */
+template <typename T>
+class PagedArray
+{
+	static_assert( std::is_trivially_copyable<T>::value, "PagedArray elements are copied with memcpy" );
+	static_assert( sizeof( T ) <= PagedBuffer::PAGE_BYTES, "PagedArray elements must fit in one page" );
+
+public:
+	PagedArray() : buffer( sizeof( T ) ) {}
+
+	const T& operator[]( size_t index ) const { return *static_cast< const T* >( buffer.read( index ) ); }
+	T& write( size_t index ) { return *static_cast< T* >( buffer.write( index ) ); }
+	void resize( size_t count ) { buffer.resize( count ); }
+	void push_back( const T& value ) {
+		buffer.resize( buffer.size() + 1 );
+		write( buffer.size() - 1 ) = value;
+	}
+	size_t size() const { return buffer.size(); }
+
+	PagedBuffer& getBuffer() { return buffer; }
+	const PagedBuffer& getBuffer() const { return buffer; }
+
+private:
+	PagedBuffer buffer; // Copy-on-write storage.
+};
+
+/**
+ * @brief The dynamic state of one body, plain data so a whole world is one memcpy-able array.
+ */
+struct BodyState
+{
+	b2Vec2 position;
+	float angle;
+	b2Vec2 linearVelocity;
+	float angularVelocity;
+	uint8_t awake;
+	uint8_t enabled;
+	uint8_t padding[ 2 ]; // Always zero, so snapshots can be compared with memcmp.
+};
+
+/**
+ * @brief The dynamic state of every body of a PhysicsWorld, in creation order.
+ *
+ * Only valid for worlds with the same structure version (same bodies in the
+ * same order). Contact caches are not captured, so a restored world loses
+ * warm starting for its first step; lookahead accepts that approximation.
+ */
+struct PhysicsSnapshot
+{
+	uint64_t structureVersion = 0; // Structure version of the captured world.
+	std::vector<BodyState> bodies; // Per-body state in creation order.
+
+	/**
+	 * @brief Reads every body's state from a world.
+	 * @param world The world to capture.
+	 */
+	void capture( const PhysicsWorld& world );
+	/**
+	 * @brief Writes every body's state into a world.
+	 * @param world A world with the same body layout as the captured one.
+	 * @return False if the world's body count does not match.
+	 */
+	bool restore( PhysicsWorld& world ) const;
+};
+
+/**
+ * @brief A complete copy of the gameplay state at one instant.
+ */
+struct WorldSnapshot
+{
+	PhysicsSnapshot physics; // Body states.
+	std::vector<RandomState> randoms; // Registered generators, in registration order.
+	std::vector<PagedBuffer> buffers; // Registered component columns, sharing pages with the live ones.
+};
+
+/**
+ * @brief Knows every piece of gameplay state that makes up a snapshot.
+ *
+ * Systems register their component columns and random generators once; the
+ * registry then captures and restores all of them together with the physics.
+ */
+class SnapshotRegistry
+{
+public:
+	/**
+	 * @brief Registers a component column.
+	 * @param buffer The column's buffer; must outlive the registration.
+	 */
+	void registerBuffer( PagedBuffer* buffer );
+	/**
+	 * @brief Registers a random generator.
+	 * @param random The generator; must outlive the registration.
+	 */
+	void registerRandom( Random* random );
+
+	/**
+	 * @brief Captures the registered state and the physics world.
+	 *
+	 * Cost is one BodyState per body plus one pointer copy per page.
+	 * @param world The physics world to capture.
+	 * @param snapshot Receives the state; reusing a snapshot avoids reallocating.
+	 */
+	void capture( const PhysicsWorld& world, WorldSnapshot& snapshot ) const;
+	/**
+	 * @brief Restores the registered state and the physics world.
+	 * @param snapshot The state to restore.
+	 * @param world The physics world to restore into.
+	 * @return False if the snapshot does not match the registered layout or the world.
+	 */
+	bool restore( const WorldSnapshot& snapshot, PhysicsWorld& world ) const;
+
+private:
+	std::vector<PagedBuffer*> buffers; // Registered columns.
+	std::vector<Random*> randoms; // Registered generators.
+};
+
+/**
+ * @brief The state a lookahead simulation steps, private to the background thread.
+ */
+struct LookaheadState
+{
+	PhysicsWorld& world; // The shadow physics world.
+	std::vector<PagedBuffer>& buffers; // Copy-on-write copies of the registered columns.
+	std::vector<Random>& randoms; // Copies of the registered generators.
+};
+
+/**
+ * @brief Runs the simulation ahead of time on a worker thread ("Acute Perception").
+ *
+ * The game thread captures a WorldSnapshot and hands it to start(); the
+ * lookahead restores it into a shadow PhysicsWorld and steps it on the
+ * JobSystem while the main loop continues. Component columns are shared
+ * copy-on-write, so neither side pays for pages the other does not modify.
+ */
+class Lookahead
+{
+public:
+	/**
+	 * @brief Called once per simulated step, before the shadow world steps.
+	 */
+	using StepFunction = std::function<void( LookaheadState& state, int step )>;
+
+	Lookahead() = default;
+	~Lookahead();
+	Lookahead( const Lookahead& ) = delete;
+	Lookahead& operator=( const Lookahead& ) = delete;
+
+	/**
+	 * @brief Starts simulating ahead from a snapshot. Call from the game thread.
+	 *
+	 * Waits for any previous run, re-mirrors the shadow world if bodies were
+	 * created or destroyed since the last run, then queues the simulation.
+	 * @param source The live world the snapshot was taken from.
+	 * @param snapshot The state to start from.
+	 * @param steps The number of fixed steps to simulate.
+	 * @param onStep Gameplay logic to run every step.
+	 */
+	void start( const PhysicsWorld& source, const WorldSnapshot& snapshot, int steps, StepFunction onStep );
+	/**
+	 * @brief Checks if a lookahead run has finished.
+	 * @return True if no run is in progress.
+	 */
+	bool isDone() const { return counter.pending.load( std::memory_order_acquire ) == 0; }
+	/**
+	 * @brief Blocks until the current run finishes.
+	 */
+	void wait();
+	/**
+	 * @brief Gets the shadow world. Only valid to read while isDone().
+	 * @return The shadow world, in the state of the last simulated step.
+	 */
+	const PhysicsWorld& getWorld() const { return shadow; }
+
+private:
+	PhysicsWorld shadow; // Structural mirror of the live world.
+	uint64_t mirroredVersion = ~0ull; // Structure version the shadow was mirrored from.
+	PhysicsSnapshot origin; // The body states the current run starts from.
+	std::vector<PagedBuffer> buffers; // The run's copy of the component columns.
+	std::vector<Random> randoms; // The run's copy of the generators.
+	JobCounter counter; // Tracks the background run.
+};
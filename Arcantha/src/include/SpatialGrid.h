@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstdint> // Required for fixed-width integer types.
+#include <vector> // Required for the cell, entity and result arrays.
+
+#include <glm/glm.hpp> // Includes GLM for glm::vec2 positions.
+
+/**
+ * @brief Entities within a distance of a point.
+ */
+struct RadiusQuery
+{
+	glm::vec2 center = glm::vec2( 0.0f );
+	float radius = 1.0f;
+	uint32_t mask = 0xFFFFFFFFu; // Categories to report.
+};
+
+/**
+ * @brief Entities inside an axis-aligned box.
+ */
+struct BoxQuery
+{
+	glm::vec2 min = glm::vec2( 0.0f ), max = glm::vec2( 0.0f );
+	uint32_t mask = 0xFFFFFFFFu; // Categories to report.
+};
+
+/**
+ * @brief The k entities closest to a point.
+ */
+struct NearestQuery
+{
+	glm::vec2 center = glm::vec2( 0.0f );
+	uint32_t k = 1;
+	float maxRadius = 1e30f; // Entities farther than this are never reported.
+	uint32_t mask = 0xFFFFFFFFu; // Categories to report.
+};
+
+/**
+ * @brief The entities found by one query, as a range into the flat ID array.
+ */
+struct SpatialResult
+{
+	uint32_t first = 0; // Index of the first entity ID.
+	uint32_t count = 0; // Number of entities found.
+};
+
+/**
+ * @brief Figures of the last rebuild and query batch.
+ */
+struct SpatialStats
+{
+	uint32_t entities = 0;
+	uint32_t cells = 0;
+	uint32_t occupiedCells = 0;
+	double rebuildMs = 0.0;
+	size_t queries = 0; // Queries in the last batch.
+	uint64_t tested = 0; // Entities whose position the last batch tested.
+	uint64_t found = 0; // Entities the last batch reported.
+	double queryMs = 0.0;
+};
+
+/**
+ * @brief A uniform grid of entity positions for proximity queries.
+ *
+ * rebuild() counting-sorts the entities by cell every tick: positions,
+ * categories and IDs are stored in cell order, so the entities of a row of
+ * cells are one contiguous run and a query reads a few short, sequential
+ * spans instead of chasing per-cell lists. The sort is split into one chunk
+ * of at least REBUILD_GRAIN entities per thread; each chunk counts its cells,
+ * the counts are turned into per-chunk write offsets, and every chunk then
+ * scatters its entities, so the order within a cell is the entity order
+ * whatever the number of threads.
+ *
+ * Queries run in batches across the JobSystem. Like QueryService, each
+ * batch leaves one result range per query into a flat ID array, valid until
+ * the next batch. Positions outside the grid's bounds fall into the border
+ * cells, so every entity is found; the bounds only decide the resolution.
+ */
+class SpatialGrid
+{
+public:
+	static const size_t REBUILD_GRAIN = 8192; // Minimum entities per rebuild job.
+	static const size_t QUERY_GRAIN = 64; // Queries per job.
+
+	/**
+	 * @brief Constructor for the SpatialGrid class.
+	 * @param origin The minimum corner of the gridded area, in meters.
+	 * @param size The extent of the gridded area, in meters.
+	 * @param cellSize The side of a cell; about the most common query radius works well.
+	 */
+	SpatialGrid( const glm::vec2& origin, const glm::vec2& size, float cellSize );
+
+	/**
+	 * @brief Sorts the entities into the grid, replacing the previous ones.
+	 * @param positions Position of every entity; its index is its ID.
+	 * @param categories Category bits of every entity, or nullptr for all bits set.
+	 * @param count The number of entities.
+	 */
+	void rebuild( const glm::vec2* positions, const uint32_t* categories, size_t count );
+
+	/**
+	 * @brief Finds the entities within each query's radius, in cell order.
+	 * @param queries The queries.
+	 * @param count The number of queries.
+	 */
+	void queryRadius( const RadiusQuery* queries, size_t count );
+	/**
+	 * @brief Finds the entities inside each query's box, in cell order.
+	 * @param queries The queries.
+	 * @param count The number of queries.
+	 */
+	void queryBox( const BoxQuery* queries, size_t count );
+	/**
+	 * @brief Finds the k nearest entities of each query, nearest first; ties go to the lower ID.
+	 * @param queries The queries.
+	 * @param count The number of queries.
+	 */
+	void queryNearest( const NearestQuery* queries, size_t count );
+
+	/**
+	 * @brief Gets the results of the last batch, one per query in submission order.
+	 * @return The result ranges into getIds().
+	 */
+	const std::vector<SpatialResult>& getResults() const { return results; }
+	/**
+	 * @brief Gets the entity IDs found by the last batch, grouped per query.
+	 * @return The flat array of IDs.
+	 */
+	const std::vector<uint32_t>& getIds() const { return ids; }
+	/**
+	 * @brief Gets the figures of the last rebuild and batch.
+	 * @return The statistics.
+	 */
+	const SpatialStats& getStats() const { return stats; }
+	/**
+	 * @brief Gets the cell an entity position falls into.
+	 * @param position The position.
+	 * @return The cell coordinates, clamped to the grid.
+	 */
+	glm::ivec2 cellOf( const glm::vec2& position ) const;
+
+private:
+	glm::vec2 origin;
+	float cellSize, inverseCellSize;
+	int cellsWide, cellsHigh;
+
+	std::vector<uint32_t> cellStart; // Per cell, plus one past the end: first sorted entity.
+	std::vector<float> sortedX, sortedY; // Entity positions in cell order.
+	std::vector<uint32_t> sortedCategories, sortedIds; // Entity categories and IDs in cell order.
+	std::vector<uint32_t> entityCells; // Cell of every entity, by ID.
+	std::vector<uint32_t> chunkCounts; // Per rebuild chunk and cell: counts, then write offsets.
+	std::vector<uint32_t> cellCursor; // Per cell: next write offset while the offsets are assigned.
+
+	std::vector<SpatialResult> results; // One per query of the last batch.
+	std::vector<uint32_t> ids; // IDs of the last batch, grouped per query.
+	std::vector<std::vector<uint32_t>> chunkIds; // Per query chunk, concatenated into ids.
+	std::vector<uint64_t> chunkTested; // Per query chunk.
+	SpatialStats stats;
+
+	/**
+	 * @brief Appends the entities inside a box of cells, and optionally a circle, to a list.
+	 * @param min The box's minimum corner.
+	 * @param max The box's maximum corner.
+	 * @param circle True to also require the distance to center to be at most radius.
+	 * @param center The circle's center.
+	 * @param radius The circle's radius.
+	 * @param mask Categories to report.
+	 * @param out The list.
+	 * @return The number of entities tested.
+	 */
+	uint64_t collect( const glm::vec2& min, const glm::vec2& max, bool circle, const glm::vec2& center, float radius, uint32_t mask,
+		std::vector<uint32_t>& out ) const;
+	/**
+	 * @brief Appends the nearest entities of a query to a list, nearest first.
+	 * @param query The query.
+	 * @param out The list.
+	 * @return The number of entities tested.
+	 */
+	uint64_t nearest( const NearestQuery& query, std::vector<uint32_t>& out ) const;
+	/**
+	 * @brief Runs a batch: each query appends its IDs to its chunk's list, then the lists are concatenated.
+	 * @param count The number of queries.
+	 * @param run Called as run( query, out ); returns the entities tested.
+	 */
+	template <typename Run>
+	void runBatch( size_t count, const Run& run );
+};
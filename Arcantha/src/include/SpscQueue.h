@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic> // Required for the lock-free head and tail indices.
+#include <cstddef> // Required for size_t.
+
+/**
+ * @brief A bounded lock-free queue for exactly one producer thread and one consumer thread.
+ *
+ * push() and pop() never block or allocate, which makes the queue safe to use
+ * from the game thread towards real-time threads such as the audio thread.
+ * The producer only writes tail and the consumer only writes head, each on
+ * its own cache line.
+ * @tparam T The element type; copied in and out.
+ * @tparam Capacity The maximum number of queued elements; must be a power of two.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert( Capacity >= 2 && ( Capacity & ( Capacity - 1 ) ) == 0, "SpscQueue capacity must be a power of two" );
+
+public:
+	/**
+	 * @brief Appends an element. Producer thread only.
+	 * @param item The element to copy into the queue.
+	 * @return False if the queue is full; the element is dropped.
+	 */
+	bool push( const T& item ) {
+		const size_t currentTail = tail.load( std::memory_order_relaxed );
+		if ( currentTail - head.load( std::memory_order_acquire ) >= Capacity ) return false;
+
+		items[ currentTail & ( Capacity - 1 ) ] = item;
+		tail.store( currentTail + 1, std::memory_order_release );
+		return true;
+	}
+	/**
+	 * @brief Removes the oldest element. Consumer thread only.
+	 * @param item Receives the element.
+	 * @return False if the queue is empty.
+	 */
+	bool pop( T& item ) {
+		const size_t currentHead = head.load( std::memory_order_relaxed );
+		if ( currentHead == tail.load( std::memory_order_acquire ) ) return false;
+
+		item = items[ currentHead & ( Capacity - 1 ) ];
+		head.store( currentHead + 1, std::memory_order_release );
+		return true;
+	}
+	/**
+	 * @brief Checks if the queue is empty. Only a hint when called from the producer.
+	 * @return True if no element is queued.
+	 */
+	bool empty() const {
+		return head.load( std::memory_order_acquire ) == tail.load( std::memory_order_acquire );
+	}
+
+private:
+	alignas( 64 ) std::atomic<size_t> head{ 0 }; // Next element to pop, written by the consumer.
+	alignas( 64 ) std::atomic<size_t> tail{ 0 }; // Next free slot, written by the producer.
+	alignas( 64 ) T items[ Capacity ]; // Ring storage.
+};
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <chrono> // Required for std::chrono::steady_clock trace timestamps.
+#include <condition_variable> // Required to wake the main thread when a task finishes.
+#include <cstddef> // Required for size_t.
+#include <functional> // Required for std::function task bodies.
+#include <mutex> // Required to guard the task states.
+#include <string> // Required for std::string task names.
+#include <vector> // Required for std::vector task and trace storage.
+
+/**
+ * @brief Where a startup task may run.
+ */
+enum class StartupThread
+{
+	Main, // On the thread that calls run(); window, GL and anything else tied to it.
+	Worker // On a JobSystem worker, concurrently with other tasks.
+};
+
+/**
+ * @brief The outcome of a startup task.
+ */
+enum class StartupStatus
+{
+	Pending, // Not finished yet.
+	Succeeded, // Ran and returned true.
+	Failed, // Ran and returned false.
+	Skipped // Never ran because a dependency failed or was skipped.
+};
+
+/**
+ * @brief When and where one startup task ran.
+ *
+ * Times are milliseconds since the StartupGraph was created.
+ */
+struct StartupTaskTrace
+{
+	std::string name; // The task name.
+	StartupThread thread = StartupThread::Worker; // Where it was allowed to run.
+	StartupStatus status = StartupStatus::Pending; // Its outcome.
+	int threadIndex = 0; // The JobSystem thread index it ran on, 0 being the main thread.
+	double readyMs = 0.0; // When its last dependency finished.
+	double beginMs = 0.0; // When it started.
+	double endMs = 0.0; // When it finished.
+	std::string waitedOn; // The dependency that finished last, empty for roots.
+};
+
+/**
+ * @brief Runs subsystem initializers in dependency order, concurrently where possible.
+ *
+ * Every task names the tasks it depends on. Worker tasks are submitted to
+ * the JobSystem as soon as their dependencies are done, while the calling
+ * thread runs the main thread tasks, so device opening and file loading
+ * overlap window creation. A task that fails skips everything that depends
+ * on it and nothing else. The trace records each task's timing and, once
+ * markFirstFrame() is called, the time to the first frame.
+ *
+ * Add every task before run(); a graph runs once.
+ */
+class StartupGraph
+{
+public:
+	static const double FIRST_FRAME_BUDGET_MS; // The first frame should be shown within this long.
+
+	/**
+	 * @brief Constructor for the StartupGraph class. Starts the trace clock.
+	 */
+	StartupGraph();
+	StartupGraph( const StartupGraph& ) = delete;
+	StartupGraph& operator=( const StartupGraph& ) = delete;
+
+	/**
+	 * @brief Declares a task.
+	 * @param name A unique name, used by dependents and in the trace.
+	 * @param thread Where the task may run.
+	 * @param func The initializer; returns false on failure.
+	 * @param dependencies Names of the tasks that must succeed first; they may be added later.
+	 * @return False if the name is taken or the graph has already run.
+	 */
+	bool add( const std::string& name, StartupThread thread, std::function<bool()> func,
+		const std::vector<std::string>& dependencies = {} );
+
+	/**
+	 * @brief Runs every task and waits for all of them.
+	 *
+	 * Call from the main thread after JobSystem::init(). Unknown dependencies
+	 * and cycles are reported and nothing runs.
+	 * @return True if every task succeeded.
+	 */
+	bool run();
+	/**
+	 * @brief Records the first presented frame.
+	 * @return True on the first call only.
+	 */
+	bool markFirstFrame();
+
+	/**
+	 * @brief Checks the outcome of a task.
+	 * @param name The task name.
+	 * @return True if the task ran and succeeded.
+	 */
+	bool succeeded( const std::string& name ) const;
+	/**
+	 * @brief Gets the trace of every task, in the order they were added.
+	 * @return The task traces.
+	 */
+	const std::vector<StartupTaskTrace>& getTrace() const { return trace; }
+	/**
+	 * @brief Gets the chain of tasks that determined when the last one finished.
+	 * @return Task names from the first to the last.
+	 */
+	std::vector<std::string> getCriticalPath() const;
+	/**
+	 * @brief Gets when run() returned.
+	 * @return Milliseconds since creation, 0 before run() has finished.
+	 */
+	double getRunMs() const { return runMs; }
+	/**
+	 * @brief Gets when the first frame was shown.
+	 * @return Milliseconds since creation, 0 before markFirstFrame().
+	 */
+	double getFirstFrameMs() const { return firstFrameMs; }
+	/**
+	 * @brief Logs the trace, the critical path and the time to the first frame.
+	 */
+	void logTrace() const;
+
+private:
+	/**
+	 * @brief A declared task and its scheduling state.
+	 */
+	struct Task
+	{
+		std::function<bool()> func; // The initializer.
+		std::vector<std::string> dependencyNames; // As declared.
+		std::vector<size_t> dependents; // Tasks waiting on this one.
+		size_t remaining = 0; // Dependencies not finished yet.
+		bool blocked = false; // Whether a dependency failed or was skipped.
+	};
+
+	std::chrono::steady_clock::time_point origin; // Creation time; trace times are relative to it.
+	std::vector<Task> tasks; // Declared tasks.
+	std::vector<StartupTaskTrace> trace; // One per task, same order.
+	std::vector<size_t> readyMain; // Main thread tasks whose dependencies are done.
+	size_t unfinished = 0; // Tasks not yet finished.
+	mutable std::mutex mutex; // Guards the scheduling state and statuses.
+	std::condition_variable finished; // Signalled whenever a task finishes.
+	bool started = false; // Whether run() has been called.
+	double runMs = 0.0; // When run() returned.
+	double firstFrameMs = 0.0; // When the first frame was shown.
+
+	/**
+	 * @brief Gets the time on the trace clock.
+	 * @return Milliseconds since creation.
+	 */
+	double now() const;
+	/**
+	 * @brief Resolves dependency names and checks for cycles.
+	 * @return False if a dependency is unknown or the graph has a cycle.
+	 */
+	bool resolve();
+	/**
+	 * @brief Runs a task, then hands its newly ready worker dependents to the JobSystem.
+	 * @param task The task index.
+	 */
+	void execute( size_t task );
+	/**
+	 * @brief Submits a worker task to the JobSystem.
+	 * @param task The task index.
+	 */
+	void submit( size_t task );
+	/**
+	 * @brief Finishes a task and readies or skips its dependents. Call with the mutex held.
+	 * @param task The task index.
+	 * @param status The outcome.
+	 * @param readyWorkers Receives the worker tasks that became ready.
+	 */
+	void complete( size_t task, StartupStatus status, std::vector<size_t>& readyWorkers );
+};
@@ -0,0 +1,334 @@
+#pragma once
+
+#include <atomic> // Required for the allocation counters.
+#include <chrono> // Required for std::chrono::steady_clock frame timing.
+#include <condition_variable> // Required to wake the capture writer thread.
+#include <cstddef> // Required for size_t.
+#include <cstdint> // Required for fixed-width integer types.
+#include <memory> // Required for std::unique_ptr capture jobs.
+#include <mutex> // Required to guard the hand-off to the writer thread.
+#include <string> // Required for std::string names and paths.
+#include <thread> // Required for the capture writer thread.
+#include <vector> // Required for std::vector ring and bucket storage.
+
+/**
+ * @brief The parts of a frame that get their own histogram.
+ */
+enum class TelemetryPhase
+{
+	Frame, // The whole frame, from one endFrame() to the next.
+	Simulation, // Input, gameplay and everything else before drawing.
+	Render // Drawing and presenting.
+};
+static const int TELEMETRY_PHASE_COUNT = 3;
+
+/**
+ * @brief Log-linear histogram of durations with bounded relative error.
+ *
+ * Values are kept in microseconds in buckets of 128 per power of two, so
+ * any percentile is within 1% of the true value from a tenth of a
+ * millisecond up to about four minutes, and recording is a few instructions.
+ */
+class FrameHistogram
+{
+public:
+	FrameHistogram();
+
+	/**
+	 * @brief Records a duration.
+	 * @param ms The duration in milliseconds; longer than the range counts as the longest bucket.
+	 */
+	void record( double ms );
+	/**
+	 * @brief Forgets every recorded duration.
+	 */
+	void reset();
+
+	/**
+	 * @brief Gets a percentile.
+	 * @param q The quantile, e.g. 0.99.
+	 * @return The duration in milliseconds at or below which q of the recorded ones fall, 0 if empty.
+	 */
+	double percentile( double q ) const;
+	uint64_t getCount() const { return count; } // Number of recorded durations.
+	double getMinMs() const { return count ? minUs * 1e-3 : 0.0; } // Shortest recorded duration.
+	double getMaxMs() const { return maxUs * 1e-3; } // Longest recorded duration.
+	double getMeanMs() const { return count ? sumUs * 1e-3 / count : 0.0; } // Mean recorded duration.
+
+private:
+	static const int SUB_BITS = 7; // log2 of the buckets per power of two.
+	static const uint64_t SUB_COUNT = 1ull << SUB_BITS; // Buckets per power of two.
+	static const int MAX_SHIFT = 20; // Values up to SUB_COUNT << ( MAX_SHIFT + 1 ) microseconds.
+
+	std::vector<uint64_t> buckets; // Counts per bucket.
+	uint64_t count; // Number of recorded durations.
+	uint64_t minUs; // Shortest recorded duration.
+	uint64_t maxUs; // Longest recorded duration.
+	double sumUs; // Sum of recorded durations.
+
+	/**
+	 * @brief Gets the bucket of a value.
+	 * @param us The value in microseconds.
+	 * @return The bucket index.
+	 */
+	static size_t bucketOf( uint64_t us );
+	/**
+	 * @brief Gets the value a bucket stands for.
+	 * @param bucket The bucket index.
+	 * @return The middle of the bucket's range in microseconds.
+	 */
+	static double valueOf( size_t bucket );
+};
+
+/**
+ * @brief Percentiles of one phase.
+ */
+struct TelemetrySummary
+{
+	uint64_t frames = 0; // Frames recorded.
+	double minMs = 0.0, meanMs = 0.0, p50Ms = 0.0, p95Ms = 0.0, p99Ms = 0.0, maxMs = 0.0;
+};
+
+/**
+ * @brief Tunables for the telemetry recorder.
+ */
+struct TelemetrySettings
+{
+	double hitchMs = 50.0; // A frame longer than this is a hitch.
+	double historySeconds = 10.0; // How far back a capture reaches.
+	uint32_t ringFrames = 2400; // Frames kept; enough for the history at 240 frames per second.
+	uint32_t framesAfterHitch = 60; // Frames recorded after a hitch before it is captured, to show the aftermath.
+	double captureCooldownSeconds = 10.0; // Hitches within this long of the last capture are not captured again.
+	std::string captureDirectory = "telemetry"; // Where captures are written; created when needed.
+};
+
+/**
+ * @brief Everything recorded about one frame.
+ */
+struct TelemetryFrame
+{
+	static const int MAX_SUBSYSTEMS = 16; // Subsystem timing slots.
+	static const int MAX_COUNTERS = 8; // Counter slots.
+
+	uint64_t index = 0; // Frame number since init.
+	double seconds = 0.0; // When the frame ended, in seconds since init.
+	float phaseMs[ TELEMETRY_PHASE_COUNT ] = {}; // Frame, simulation and render time.
+	float subsystemMs[ MAX_SUBSYSTEMS ] = {}; // Time of each registered subsystem.
+	uint64_t counters[ MAX_COUNTERS ] = {}; // Value of each registered counter.
+	uint32_t allocations = 0; // Heap allocations made during the frame, on any thread; 0 unless TelemetryAllocations.cpp is linked.
+	uint64_t allocatedBytes = 0; // Heap bytes requested during the frame.
+	bool hitch = false; // Whether the frame exceeded the hitch threshold.
+};
+
+/**
+ * @brief Counters of the recorder itself.
+ */
+struct TelemetryStats
+{
+	uint64_t frames = 0; // Frames recorded.
+	uint64_t hitches = 0; // Frames over the hitch threshold.
+	uint64_t captures = 0; // Captures written.
+	uint64_t coalesced = 0; // Hitches that fell into a capture already pending or cooling down.
+	uint64_t failed = 0; // Captures that could not be written.
+};
+
+/**
+ * @brief Records per-frame timings, counters and allocations and captures the context of hitches.
+ *
+ * This class implements the Singleton design pattern. Subsystems register
+ * once and then time themselves with TelemetryScope; endFrame() files the
+ * frame into the phase histograms and a ring of the last frames. When a
+ * frame exceeds the hitch threshold, the recorder waits framesAfterHitch
+ * more frames and then hands the ring's last historySeconds to a writer
+ * thread, which saves it as CSV, so the game thread only pays for a copy.
+ *
+ * Call everything except countAllocation() from the game thread.
+ */
+class Telemetry
+{
+public:
+	/**
+	 * @brief Gets the singleton instance of the Telemetry.
+	 * @return A reference to the single Telemetry instance.
+	 */
+	static Telemetry& getInstance();
+
+	/**
+	 * @brief Starts recording and the capture writer thread. Clears any earlier recording.
+	 * @param settings The recorder settings.
+	 */
+	void init( const TelemetrySettings& settings = TelemetrySettings() );
+	/**
+	 * @brief Captures a pending hitch, if any, and stops the writer thread once it is done.
+	 */
+	void shutdown();
+
+	/**
+	 * @brief Registers a subsystem to time. Registering a name twice returns the same id.
+	 * @param name The name used in captures.
+	 * @param phase The phase its time counts towards, Simulation or Render.
+	 * @return Its id, or MAX_SUBSYSTEMS if every slot is taken.
+	 */
+	uint32_t registerSubsystem( const std::string& name, TelemetryPhase phase );
+	/**
+	 * @brief Registers a per-frame counter. Registering a name twice returns the same id.
+	 * @param name The name used in captures.
+	 * @return Its id, or MAX_COUNTERS if every slot is taken.
+	 */
+	uint32_t registerCounter( const std::string& name );
+
+	/**
+	 * @brief Adds time to a subsystem in the current frame.
+	 * @param subsystem The subsystem id.
+	 * @param ms The time in milliseconds.
+	 */
+	void addTime( uint32_t subsystem, double ms ) {
+		if ( subsystem < TelemetryFrame::MAX_SUBSYSTEMS ) current.subsystemMs[ subsystem ] += static_cast< float >( ms );
+	}
+	/**
+	 * @brief Sets a counter for the current frame; the value is kept until set again.
+	 * @param counter The counter id.
+	 * @param value The value.
+	 */
+	void setCounter( uint32_t counter, uint64_t value ) {
+		if ( counter < TelemetryFrame::MAX_COUNTERS ) current.counters[ counter ] = value;
+	}
+	/**
+	 * @brief Restarts the current frame, dropping the time and allocations since init() or the last endFrame().
+	 *
+	 * Call it right before the main loop, so the first frame does not include
+	 * startup and is not taken for a hitch.
+	 */
+	void beginFrame();
+	/**
+	 * @brief Ends the frame: times it, records it and checks for a hitch.
+	 */
+	void endFrame();
+
+	/**
+	 * @brief Counts a heap allocation. Safe from any thread; called by the operator new in TelemetryAllocations.cpp.
+	 * @param bytes The size of the allocation.
+	 */
+	static void countAllocation( size_t bytes ) {
+		allocationCount.fetch_add( 1, std::memory_order_relaxed );
+		allocationBytes.fetch_add( bytes, std::memory_order_relaxed );
+	}
+
+	/**
+	 * @brief Gets a phase's histogram since init.
+	 * @param phase The phase.
+	 * @return The histogram.
+	 */
+	const FrameHistogram& getHistogram( TelemetryPhase phase ) const { return histograms[ static_cast< int >( phase ) ]; }
+	/**
+	 * @brief Gets a phase's percentiles since init.
+	 * @param phase The phase.
+	 * @return The summary.
+	 */
+	TelemetrySummary getSummary( TelemetryPhase phase ) const;
+	/**
+	 * @brief Gets the most recent frame.
+	 * @return The last recorded frame, default values before the first.
+	 */
+	const TelemetryFrame& getLastFrame() const;
+	/**
+	 * @brief Gets the counters.
+	 * @return A copy of the statistics.
+	 */
+	TelemetryStats getStats() const;
+
+private:
+	static Telemetry instance; // The single instance of the Telemetry class, implementing the Singleton pattern.
+	static std::atomic<uint64_t> allocationCount; // Allocations on any thread since start.
+	static std::atomic<uint64_t> allocationBytes; // Bytes requested on any thread since start.
+
+	/**
+	 * @brief A registered subsystem.
+	 */
+	struct Subsystem
+	{
+		std::string name;
+		TelemetryPhase phase;
+	};
+
+	/**
+	 * @brief Frames to write as one capture.
+	 */
+	struct Capture
+	{
+		uint64_t hitchFrame; // The frame that triggered it.
+		std::string header; // The CSV column names, fixed when queued.
+		size_t subsystemCount; // Subsystems registered when queued.
+		size_t counterCount; // Counters registered when queued.
+		std::vector<TelemetryFrame> frames; // Oldest first.
+	};
+
+	TelemetrySettings settings; // Recorder settings.
+	std::vector<Subsystem> subsystems; // Registered subsystems, by id.
+	std::vector<std::string> counterNames; // Registered counters, by id.
+	FrameHistogram histograms[ TELEMETRY_PHASE_COUNT ]; // Per phase since init.
+	std::vector<TelemetryFrame> ring; // The last frames; frame i is at i % size.
+	TelemetryFrame current; // The frame being recorded.
+	uint64_t frames = 0; // Frames recorded.
+	std::chrono::steady_clock::time_point start; // When init() was called.
+	std::chrono::steady_clock::time_point frameBegin; // When the current frame began.
+	uint64_t lastAllocations = 0; // Allocation count at the end of the previous frame.
+	uint64_t lastAllocatedBytes = 0; // Allocated bytes at the end of the previous frame.
+
+	bool pending = false; // Whether a hitch waits for its aftermath to be recorded.
+	uint64_t pendingFrame = 0; // The hitch frame of the pending capture.
+	uint32_t framesUntilCapture = 0; // Frames left before the pending capture is taken.
+	double lastCaptureSeconds = -1e30; // When the last capture was taken.
+
+	std::thread thread; // The capture writer thread.
+	mutable std::mutex mutex; // Guards stats, queued and running.
+	std::condition_variable wake; // Signals the writer that a capture is queued or it should stop.
+	std::unique_ptr<Capture> queued; // The capture waiting for the writer, if any.
+	TelemetryStats stats; // Recorder counters.
+	bool running = false; // Whether the writer thread should keep going.
+
+	Telemetry() = default; // Private constructor for singleton.
+	~Telemetry();
+	Telemetry( const Telemetry& ) = delete; // Delete copy constructor to prevent copying.
+	Telemetry& operator=( const Telemetry& ) = delete; // Delete assignment operator to prevent assignment.
+
+	/**
+	 * @brief Copies the last historySeconds of the ring and queues them for the writer.
+	 */
+	void queueCapture();
+	/**
+	 * @brief Writes a capture as CSV.
+	 * @param capture The capture.
+	 * @return False if the file could not be written.
+	 */
+	bool writeCapture( const Capture& capture ) const;
+	/**
+	 * @brief Body of the writer thread.
+	 */
+	void threadLoop();
+};
+
+/**
+ * @brief Times a scope and adds it to a subsystem's time in the current frame.
+ */
+class TelemetryScope
+{
+public:
+	/**
+	 * @brief Constructor for the TelemetryScope class. Starts timing.
+	 * @param subsystem The subsystem id from Telemetry::registerSubsystem.
+	 */
+	explicit TelemetryScope( uint32_t subsystem ) : subsystem( subsystem ), begin( std::chrono::steady_clock::now() ) {}
+	/**
+	 * @brief Destructor; adds the elapsed time to the subsystem.
+	 */
+	~TelemetryScope() {
+		Telemetry::getInstance().addTime( subsystem, std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - begin ).count() );
+	}
+	TelemetryScope( const TelemetryScope& ) = delete;
+	TelemetryScope& operator=( const TelemetryScope& ) = delete;
+
+private:
+	uint32_t subsystem; // The subsystem timed.
+	std::chrono::steady_clock::time_point begin; // When the scope began.
+};
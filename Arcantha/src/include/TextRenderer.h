@@ -0,0 +1,244 @@
+#pragma once
+
+#include <cstdint> // Required for fixed-width integer types.
+#include <memory> // Required for std::unique_ptr to the font info.
+#include <string> // Required for std::string text and paths.
+#include <unordered_map> // Required for the glyph and shaping caches.
+#include <vector> // Required for the atlas pixels and vertex arrays.
+
+#include <glm/glm.hpp> // Includes GLM for glm::vec2 positions and glm::mat4 projections.
+
+struct stbtt_fontinfo; // imstb_truetype's font handle, only used in TextRenderer.cpp.
+
+/**
+ * @brief Horizontal placement of a string relative to its position.
+ */
+enum class TextAlign : uint8_t
+{
+	Left,
+	Center,
+	Right
+};
+
+/**
+ * @brief One corner of a glyph quad, as uploaded to the GPU.
+ */
+struct TextVertex
+{
+	float x, y; // Position.
+	float u, v; // Atlas coordinates.
+	uint32_t color; // RGBA8, red in the lowest byte.
+};
+
+/**
+ * @brief Counters of the last frame (or since creation, for the cumulative ones).
+ */
+struct TextStats
+{
+	uint32_t strings = 0; // drawText() calls this frame.
+	uint32_t quads = 0; // Glyph quads this frame.
+	uint32_t drawCalls = 0; // Draw calls issued by the last render().
+	uint32_t shapeHits = 0; // Strings found in the shaping cache this frame.
+	uint32_t shapeMisses = 0; // Strings shaped this frame.
+	uint64_t glyphsRasterized = 0; // SDF glyphs rasterized since creation.
+	uint64_t atlasResets = 0; // Times the atlas filled up and was cleared.
+	uint32_t atlasShelfTop = 0; // Rows of the atlas in use.
+};
+
+/**
+ * @brief Game text: SDF glyphs rasterized on demand, cached shaping and one draw per frame.
+ *
+ * Glyphs are rasterized with imstb_truetype as signed distance fields at a
+ * single base size the first time they are drawn and packed into one
+ * single-channel atlas with a shelf packer, so any size renders crisply from
+ * the same texture. When the atlas is full it is cleared and glyphs are
+ * rasterized again as they are used. Quads queued earlier in the frame still
+ * refer to the old atlas, so then the clear waits until render() has drawn
+ * them and the string that did not fit misses those glyphs for one frame.
+ *
+ * drawText() looks the string up in a shaping cache holding its glyph quads
+ * (kerning applied) at the base size, then scales and appends them to the
+ * frame's vertex array. render() uploads the atlas rows that changed and the
+ * vertices and draws all text of the frame with one glDrawElements.
+ *
+ * Everything except initGL(), render() and shutdownGL() works without an
+ * OpenGL context, so text layout can be measured headless.
+ */
+class TextRenderer
+{
+public:
+	static const int ATLAS_SIZE = 1024; // Width and height of the atlas in texels.
+	static const int BASE_SIZE = 32; // Pixel height glyphs are rasterized at.
+	static const int SDF_PADDING = 4; // Texels of distance field around each glyph.
+	static const size_t SHAPE_CACHE_CAPACITY = 4096; // Strings per cache generation.
+	static const uint32_t MAX_QUADS = 65536; // Glyph quads per frame; more are dropped.
+
+	TextRenderer();
+	~TextRenderer();
+	TextRenderer( const TextRenderer& ) = delete;
+	TextRenderer& operator=( const TextRenderer& ) = delete;
+
+	/**
+	 * @brief Loads a TrueType font.
+	 * @param path The .ttf file.
+	 * @return False if the file cannot be read or is not a font.
+	 */
+	bool loadFont( const std::string& path );
+	/**
+	 * @brief Creates the shader, buffers and atlas texture. Requires a current OpenGL 3.3 context.
+	 * @return False if the shader fails to compile.
+	 */
+	bool initGL();
+	/**
+	 * @brief Deletes the GL objects. Requires the context that initGL() ran with.
+	 */
+	void shutdownGL();
+
+	/**
+	 * @brief Queues a string for this frame.
+	 * @param text UTF-8 text; no line breaks.
+	 * @param position Baseline start (for Left) in the projection's units.
+	 * @param size Height of the text in the projection's units.
+	 * @param color RGBA8, red in the lowest byte.
+	 * @param align Horizontal alignment relative to position.
+	 */
+	void drawText( const std::string& text, glm::vec2 position, float size, uint32_t color, TextAlign align = TextAlign::Left );
+	/**
+	 * @brief Measures a string.
+	 * @param text UTF-8 text.
+	 * @param size Height of the text.
+	 * @return The advance width.
+	 */
+	float measure( const std::string& text, float size );
+	/**
+	 * @brief Draws everything queued this frame in one draw call and starts the next frame.
+	 *
+	 * Without initGL() the queued text is discarded, which still measures the CPU side.
+	 * @param projection Transforms text positions to clip space (y up).
+	 */
+	void render( const glm::mat4& projection );
+
+	/**
+	 * @brief Enables or disables the shaping cache, e.g. to measure its effect.
+	 * @param enabled False to shape every string on every call.
+	 */
+	void setShapeCacheEnabled( bool enabled ) { shapeCacheEnabled = enabled; }
+	/**
+	 * @brief Gets the vertices queued this frame.
+	 * @return Four vertices per quad.
+	 */
+	const std::vector<TextVertex>& getVertices() const { return vertices; }
+	/**
+	 * @brief Gets the atlas texels.
+	 * @return ATLAS_SIZE * ATLAS_SIZE distance values, 128 on the glyph edge.
+	 */
+	const std::vector<uint8_t>& getAtlas() const { return atlas; }
+	/**
+	 * @brief Gets the counters.
+	 * @return The statistics.
+	 */
+	const TextStats& getStats() const { return stats; }
+
+private:
+	/**
+	 * @brief A rasterized glyph in the atlas, metrics at BASE_SIZE.
+	 */
+	struct Glyph
+	{
+		float x0, y0, x1, y1; // Quad relative to the pen position, y up.
+		float u0, v0, u1, v1; // Atlas rectangle.
+		float advance; // Pen advance.
+		bool visible; // False for blanks such as spaces.
+	};
+
+	/**
+	 * @brief A shelf of the atlas packer.
+	 */
+	struct Shelf
+	{
+		int y; // Top row.
+		int height; // Rows.
+		int x; // First free column.
+	};
+
+	/**
+	 * @brief A shaped string: its quads at BASE_SIZE with the pen starting at 0.
+	 */
+	struct ShapedText
+	{
+		std::vector<Glyph> quads; // Visible glyphs, positioned.
+		float width = 0.0f; // Total advance.
+		uint64_t atlasEpoch = 0; // The atlas generation the UVs refer to.
+	};
+
+	std::vector<uint8_t> fontData; // The TTF file; stbtt reads it in place.
+	std::unique_ptr<stbtt_fontinfo> font; // Parsed font tables.
+	float fontScale = 0.0f; // Font units to BASE_SIZE pixels.
+
+	std::vector<uint8_t> atlas; // ATLAS_SIZE * ATLAS_SIZE texels.
+	std::vector<Shelf> shelves; // Packer state.
+	int shelfTop = 0; // First row below the last shelf.
+	int dirtyMin = ATLAS_SIZE, dirtyMax = 0; // Rows changed since the last upload.
+	uint64_t atlasEpoch = 1; // Incremented when the atlas is cleared.
+	bool atlasResetPending = false; // The atlas filled up while quads were queued; cleared after render().
+	Glyph asciiGlyphs[ 128 ]; // Fast path for ASCII.
+	bool asciiCached[ 128 ] = {};
+	std::unordered_map<uint32_t, Glyph> glyphs; // Other codepoints.
+
+	bool shapeCacheEnabled = true;
+	std::unordered_map<std::string, ShapedText> shapes; // Current cache generation.
+	std::unordered_map<std::string, ShapedText> oldShapes; // Previous generation; entries used again move back.
+	ShapedText scratch; // Shaping target when the cache is disabled.
+
+	std::vector<TextVertex> vertices; // This frame's quads.
+	TextStats stats;
+	bool frameStarted = false; // Per-frame counters were reset for the frame being queued.
+
+	unsigned int program = 0, vao = 0, vbo = 0, ebo = 0, texture = 0; // GL objects.
+	int projectionLocation = -1;
+	bool glReady = false;
+
+	/**
+	 * @brief Resets the per-frame counters on the first call of a frame.
+	 */
+	void beginFrame();
+	/**
+	 * @brief Gets a glyph, rasterizing it into the atlas on first use.
+	 * @param codepoint The Unicode codepoint.
+	 * @param glyph Receives the glyph.
+	 * @return False if the atlas is full; glyph still receives the advance.
+	 */
+	bool getGlyph( uint32_t codepoint, Glyph& glyph );
+	/**
+	 * @brief Rasterizes a glyph's SDF and packs it.
+	 * @param codepoint The Unicode codepoint.
+	 * @param glyph Receives the glyph.
+	 * @return False if it does not fit.
+	 */
+	bool rasterize( uint32_t codepoint, Glyph& glyph );
+	/**
+	 * @brief Finds room for a rectangle on a shelf.
+	 * @param width Texels.
+	 * @param height Texels.
+	 * @param x Receives the left column.
+	 * @param y Receives the top row.
+	 * @return False if the atlas is full.
+	 */
+	bool pack( int width, int height, int& x, int& y );
+	/**
+	 * @brief Empties the atlas and the glyph cache. Cached shapes become stale and are shaped again on use.
+	 */
+	void resetAtlas();
+	/**
+	 * @brief Shapes a string at BASE_SIZE.
+	 * @param text UTF-8 text.
+	 * @param shaped Receives the quads.
+	 */
+	void shape( const std::string& text, ShapedText& shaped );
+	/**
+	 * @brief Gets a string's shape from the cache, shaping it on a miss.
+	 * @param text UTF-8 text.
+	 * @return The shape; valid until the next call.
+	 */
+	const ShapedText& getShape( const std::string& text );
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <vector> // Required for std::vector to store the tile grid.
+#include <cstdint> // Required for fixed-width integer types.
+
+#include <glm/glm.hpp> // Includes GLM for glm::vec2 and glm::ivec2 coordinates.
+
+/**
+ * @brief The kinds of tile a room can be built from.
+ *
+ * Values are stored as single bytes so a full room fits in a few cache lines per row.
+ */
+enum class Tile : uint8_t
+{
+	Empty = 0, // Open space.
+	Solid = 1, // Fully blocking terrain.
+	Platform = 2 // One-way platform, blocking only from above.
+};
+
+/**
+ * @brief An axis-aligned rectangle of tiles, in tile coordinates.
+ */
+struct TileRect
+{
+	int x, y; // Bottom-left tile of the rectangle.
+	int w, h; // Size of the rectangle in tiles.
+};
+
+/**
+ * @brief A dense 2D grid of tiles describing the static geometry of a room.
+ *
+ * Tile (0, 0) is the bottom-left corner and Y grows upwards, matching the
+ * Box2D world space used by PhysicsWorld. Coordinates outside the grid are
+ * treated as Solid so rooms are always closed.
+ */
+class TileMap
+{
+public:
+	/**
+	 * @brief Constructor for the TileMap class.
+	 * @param width The width of the map in tiles.
+	 * @param height The height of the map in tiles.
+	 * @param tileSize The size of one tile in world units (meters).
+	 */
+	TileMap( int width, int height, float tileSize = 1.0f );
+
+	/**
+	 * @brief Gets the tile at the given tile coordinates.
+	 * @param x The column of the tile.
+	 * @param y The row of the tile.
+	 * @return The tile, or Tile::Solid if the coordinates are out of bounds.
+	 */
+	Tile get( int x, int y ) const {
+		if ( x < 0 || y < 0 || x >= width || y >= height ) return Tile::Solid;
+		return tiles[ static_cast< size_t >( y ) * width + x ];
+	}
+	/**
+	 * @brief Sets the tile at the given tile coordinates. Out of bounds writes are ignored.
+	 * @param x The column of the tile.
+	 * @param y The row of the tile.
+	 * @param tile The new tile value.
+	 */
+	void set( int x, int y, Tile tile );
+	/**
+	 * @brief Fills a rectangle of tiles, clipped to the map bounds.
+	 * @param x The first column of the rectangle.
+	 * @param y The first row of the rectangle.
+	 * @param w The width of the rectangle in tiles.
+	 * @param h The height of the rectangle in tiles.
+	 * @param tile The tile value to fill with.
+	 */
+	void fill( int x, int y, int w, int h, Tile tile );
+	/**
+	 * @brief Checks if the tile at the given coordinates blocks movement from every side.
+	 * @param x The column of the tile.
+	 * @param y The row of the tile.
+	 * @return True if the tile is Solid (or out of bounds), false otherwise.
+	 */
+	bool isSolid( int x, int y ) const { return get( x, y ) == Tile::Solid; }
+
+	/**
+	 * @brief Greedily merges the solid tiles into as few rectangles as possible.
+	 *
+	 * Runs are grown to the right first and then upwards while the next row is
+	 * also solid, so a typical room collapses to a few dozen rectangles.
+	 * @return The merged rectangles, covering every solid tile exactly once.
+	 */
+	std::vector<TileRect> mergeSolidRects() const;
+
+	/**
+	 * @brief Converts a world position to the tile containing it.
+	 * @param position The world position.
+	 * @return The tile coordinates (may lie outside the map).
+	 */
+	glm::ivec2 worldToTile( const glm::vec2& position ) const;
+	/**
+	 * @brief Gets the world position of the center of a tile.
+	 * @param x The column of the tile.
+	 * @param y The row of the tile.
+	 * @return The world position of the tile center.
+	 */
+	glm::vec2 tileCenter( int x, int y ) const;
+
+	/**
+	 * @brief Gets the width of the map.
+	 * @return The width in tiles.
+	 */
+	int getWidth() const { return width; }
+	/**
+	 * @brief Gets the height of the map.
+	 * @return The height in tiles.
+	 */
+	int getHeight() const { return height; }
+	/**
+	 * @brief Gets the size of a single tile.
+	 * @return The tile size in world units.
+	 */
+	float getTileSize() const { return tileSize; }
+	/**
+	 * @brief Gets the raw row-major tile storage.
+	 * @return A pointer to width * height tiles.
+	 */
+	const Tile* data() const { return tiles.data(); }
+
+private:
+	int width, height; // Dimensions of the map in tiles.
+	float tileSize; // Size of one tile in world units.
+	std::vector<Tile> tiles; // Row-major tile storage, row 0 at the bottom.
+};
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <cstdint> // Required for fixed-width integer types.
+#include <string> // Required for std::string paths.
+#include <vector> // Required for std::vector voice and source pools.
+
+#include <AL/al.h> // Includes the OpenAL source and buffer API.
+#include <glm/glm.hpp> // Includes glm::vec2 for voice and listener positions.
+
+/**
+ * @brief Groups of sounds that share a concurrency limit.
+ */
+enum class SoundCategory : uint8_t
+{
+	Ui, // Menus and HUD feedback, never positional.
+	Player, // The player's own attacks, spells and hits.
+	Combat, // Impacts, parries and blocks.
+	Magic, // Lightning bolts and other spell effects.
+	Enemy, // Enemy barks and attacks.
+	Footstep, // Footsteps of any character.
+	Ambient, // Short positional ambience (torches, drips).
+	COUNT
+};
+
+/**
+ * @brief Identifies a voice; stays invalid once the voice has finished or been stolen. 0 is never valid.
+ */
+using VoiceHandle = uint32_t;
+
+/**
+ * @brief Parameters of a sound started through VoiceManager.
+ */
+struct VoiceParams
+{
+	SoundCategory category = SoundCategory::Combat; // Category for concurrency limits.
+	int priority = 0; // 0 or more; higher priorities always win a real source over lower ones.
+	glm::vec2 position = glm::vec2( 0.0f ); // World position; ignored if not positional.
+	float gain = 1.0f; // Volume before distance attenuation.
+	float pitch = 1.0f; // Playback rate.
+	bool loop = false; // Repeat until stopped.
+	bool positional = true; // Attenuate and pan by distance to the listener.
+};
+
+/**
+ * @brief Counters describing the last VoiceManager update.
+ */
+struct VoiceStats
+{
+	int live = 0; // Voices playing, real or virtual.
+	int real = 0; // Voices that own an OpenAL source.
+	uint64_t started = 0; // Voices started since init.
+	uint64_t stolen = 0; // Voices stopped early to make room for a more important one.
+	uint64_t rejected = 0; // Requests refused because a limit was hit and nothing could be stolen.
+	uint64_t promotions = 0; // Virtual voices that were given a source.
+	uint64_t demotions = 0; // Real voices that lost their source.
+};
+
+/**
+ * @brief Plays sound effects through a fixed pool of OpenAL sources with virtual voices.
+ *
+ * Any number of voices (up to the virtual limit) can play logically; each
+ * update only the most important ones own one of the preallocated sources.
+ * A voice that is inaudible or outranked keeps its playhead running without a
+ * source and resumes at the right offset when it becomes important again.
+ * Importance is the voice priority plus its audibility (gain attenuated by
+ * distance to the listener). Since only pooled sources are ever mixed, mixer
+ * cost is bounded by the pool size no matter how many sounds gameplay requests.
+ *
+ * Call from the game thread only, after AudioEngine::init made a context current.
+ */
+class VoiceManager
+{
+public:
+	static const int DEFAULT_REAL_VOICES = 32; // Sources preallocated by default.
+	static const int DEFAULT_VIRTUAL_VOICES = 512; // Voices tracked by default.
+
+	VoiceManager() = default;
+	/**
+	 * @brief Destructor. Releases the sources and loaded buffers.
+	 */
+	~VoiceManager();
+	VoiceManager( const VoiceManager& ) = delete; // Owns OpenAL objects.
+	VoiceManager& operator=( const VoiceManager& ) = delete;
+
+	/**
+	 * @brief Preallocates the source pool and the virtual voice slots.
+	 * @param realVoices The number of sources to create; fewer are used if OpenAL runs out.
+	 * @param virtualVoices The maximum number of voices playing at once (at most 65535).
+	 * @return False if not a single source could be created.
+	 */
+	bool init( int realVoices = DEFAULT_REAL_VOICES, int virtualVoices = DEFAULT_VIRTUAL_VOICES );
+	/**
+	 * @brief Stops every voice and deletes the sources and loaded buffers.
+	 */
+	void shutdown();
+
+	/**
+	 * @brief Loads a short WAV file fully into an OpenAL buffer owned by the manager.
+	 * @param path The file to load.
+	 * @return The buffer, or 0 if the file cannot be loaded.
+	 */
+	ALuint loadSound( const std::string& path );
+
+	/**
+	 * @brief Starts a voice, stealing a less important one if a limit is reached.
+	 * @param buffer The sound to play.
+	 * @param params The voice parameters.
+	 * @return The voice handle, or 0 if the request was rejected.
+	 */
+	VoiceHandle play( ALuint buffer, const VoiceParams& params );
+	/**
+	 * @brief Stops a voice. Does nothing if it already finished.
+	 * @param handle The voice to stop.
+	 */
+	void stop( VoiceHandle handle );
+	/**
+	 * @brief Moves a positional voice.
+	 * @param handle The voice to move.
+	 * @param position The new world position.
+	 */
+	void setPosition( VoiceHandle handle, glm::vec2 position );
+	/**
+	 * @brief Changes the gain of a voice.
+	 * @param handle The voice to change.
+	 * @param gain The new gain.
+	 */
+	void setGain( VoiceHandle handle, float gain );
+	/**
+	 * @brief Checks if a voice is still playing, really or virtually.
+	 * @param handle The voice to check.
+	 * @return True if the voice has not finished, been stopped or been stolen.
+	 */
+	bool isPlaying( VoiceHandle handle ) const;
+	/**
+	 * @brief Checks if a voice currently owns a source.
+	 * @param handle The voice to check.
+	 * @return True if the voice is audible through OpenAL.
+	 */
+	bool isReal( VoiceHandle handle ) const;
+
+	/**
+	 * @brief Sets how many voices of a category may play at once.
+	 * @param category The category to limit.
+	 * @param limit The maximum number of voices, or 0 for no limit.
+	 */
+	void setCategoryLimit( SoundCategory category, int limit );
+	/**
+	 * @brief Sets the distances over which positional voices fade out (linear, clamped).
+	 * @param referenceDistance Distance at which a voice is at full gain.
+	 * @param maxDistance Distance at which a voice becomes silent.
+	 */
+	void setAttenuation( float referenceDistance, float maxDistance );
+	/**
+	 * @brief Routes the first auxiliary send of every pooled source to an effect slot, e.g. the room's reverb.
+	 * @param effectSlot The auxiliary effect slot, or 0 to disconnect.
+	 */
+	void setAuxiliarySend( ALuint effectSlot );
+	/**
+	 * @brief Moves the listener, usually to the camera or the player.
+	 * @param position The listener's world position.
+	 */
+	void setListener( glm::vec2 position );
+
+	/**
+	 * @brief Advances playheads, re-ranks voices and hands sources to the most important ones.
+	 * @param dt The frame time in seconds.
+	 */
+	void update( float dt );
+
+	/**
+	 * @brief Gets the counters of the last update.
+	 * @return The voice statistics.
+	 */
+	const VoiceStats& getStats() const { return stats; }
+	/**
+	 * @brief Gets the number of pooled sources.
+	 * @return The real voice count.
+	 */
+	int getRealVoiceCount() const { return static_cast< int >( sources.size() ); }
+
+private:
+	/**
+	 * @brief One virtual voice slot.
+	 */
+	struct Voice
+	{
+		ALuint buffer = 0; // The sound being played.
+		ALuint source = 0; // The pooled source, or 0 while virtual.
+		uint16_t generation = 1; // Incremented whenever the slot is freed, invalidating old handles.
+		bool active = false; // True while the slot holds a playing voice.
+		bool dirty = false; // Parameters changed since they were last sent to the source.
+		SoundCategory category = SoundCategory::Combat;
+		int priority = 0;
+		glm::vec2 position = glm::vec2( 0.0f );
+		float gain = 1.0f;
+		float pitch = 1.0f;
+		bool loop = false;
+		bool positional = true;
+		float time = 0.0f; // Logical playhead in seconds.
+		float duration = 0.0f; // Length of the sound in seconds.
+		float score = 0.0f; // Importance from the last ranking.
+	};
+
+	static constexpr float REAL_VOICE_BONUS = 0.05f; // Added to voices that already own a source so near-ties do not swap every frame.
+	static constexpr float INAUDIBLE = 0.001f; // Voices quieter than this never get a source.
+
+	std::vector<Voice> voices; // Virtual voice slots.
+	std::vector<uint16_t> freeSlots; // Unused slot indices.
+	std::vector<ALuint> sources; // Every pooled source.
+	std::vector<ALuint> freeSources; // Pooled sources not owned by a voice.
+	std::vector<ALuint> loadedBuffers; // Buffers created by loadSound.
+	std::vector<uint16_t> ranked; // Scratch list of live slots for ranking.
+	int categoryLimits[ static_cast< int >( SoundCategory::COUNT ) ] = {}; // 0 means unlimited.
+	int categoryCounts[ static_cast< int >( SoundCategory::COUNT ) ] = {}; // Live voices per category.
+	glm::vec2 listener = glm::vec2( 0.0f );
+	float referenceDistance = 2.0f;
+	float maxDistance = 40.0f;
+	VoiceStats stats;
+
+	/**
+	 * @brief Resolves a handle to its slot.
+	 * @param handle The voice handle.
+	 * @return The voice, or nullptr if the handle is stale.
+	 */
+	Voice* resolve( VoiceHandle handle );
+	const Voice* resolve( VoiceHandle handle ) const;
+	/**
+	 * @brief Computes the importance of a voice.
+	 * @param voice The voice.
+	 * @return The priority plus the audibility in [0, 1], or a negative value if inaudible.
+	 */
+	float score( const Voice& voice ) const;
+	/**
+	 * @brief Finds the least important live voice, optionally within one category.
+	 * @param category The category to search, or COUNT for any.
+	 * @return The slot index, or -1 if there is no live voice.
+	 */
+	int findWeakest( SoundCategory category ) const;
+	/**
+	 * @brief Gives a voice a pooled source and starts it at its playhead.
+	 * @param voice The voice to promote.
+	 * @param source The source to hand over.
+	 */
+	void promote( Voice& voice, ALuint source );
+	/**
+	 * @brief Takes a voice's source back to the pool; the voice keeps playing virtually.
+	 * @param voice The voice to demote.
+	 */
+	void demote( Voice& voice );
+	/**
+	 * @brief Sends a voice's parameters to its source and clears its dirty flag.
+	 * @param voice The real voice.
+	 */
+	static void apply( Voice& voice );
+	/**
+	 * @brief Stops a voice and frees its slot.
+	 * @param index The slot index.
+	 */
+	void release( int index );
+};
@@ -0,0 +1,252 @@
+// Behavior tree AI benchmark.
+//
+// Runs 2,000 agents of three kinds (grunts, archers and flyers, one tree and
+// blackboard each) spread along a long level while the player walks across
+// it. The same run is repeated with LOD scheduling on and the pool in use,
+// with LOD off (every agent every frame), and with LOD on but no workers.
+// Reports frame cost, trees evaluated and nodes visited per frame, and the
+// LOD mix. The two LOD runs must leave every blackboard identical, since
+// agents only write their own rows. Reports JSON.
+//
+// Usage: arcantha_ai_bench [--agents N] [--frames N] [--threads N]
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BehaviorTree.h"
+#include "JobSystem.h"
+#include "Random.h"
+#include "bench_common.h"
+
+static const float LEVEL_WIDTH = 600.0f; // Agents are spread over this many meters.
+static const float LEVEL_HEIGHT = 60.0f;
+
+// Blackboard keys, added in this order to every group's blackboard.
+enum Key : uint16_t
+{
+	POS_X,
+	POS_Y,
+	HOME_X, // Patrol center.
+	DIRECTION, // Patrol direction, -1 or 1.
+	HEALTH,
+	COOLDOWN, // Seconds until the next attack.
+	DISTANCE, // Distance to the player, written by the sense action.
+	KEY_COUNT
+};
+
+static BtStatus sense( Blackboard& board, uint32_t agent, const AiTickContext& context ) {
+	const float dx = context.focus.x - board.at( POS_X, agent ), dy = context.focus.y - board.at( POS_Y, agent );
+	board.at( DISTANCE, agent ) = std::sqrt( dx * dx + dy * dy );
+	board.at( COOLDOWN, agent ) = std::fmax( 0.0f, board.at( COOLDOWN, agent ) - context.dt );
+	return BtStatus::Success;
+}
+
+static BtStatus moveToward( Blackboard& board, uint32_t agent, const AiTickContext& context, float speed ) {
+	const float dx = context.focus.x - board.at( POS_X, agent ), dy = context.focus.y - board.at( POS_Y, agent );
+	const float distance = std::fmax( board.at( DISTANCE, agent ), 0.001f );
+	board.at( POS_X, agent ) += dx / distance * speed * context.dt;
+	board.at( POS_Y, agent ) += dy / distance * speed * context.dt;
+	return BtStatus::Running;
+}
+
+static BtStatus chase( Blackboard& board, uint32_t agent, const AiTickContext& context ) { return moveToward( board, agent, context, 4.0f ); }
+static BtStatus flee( Blackboard& board, uint32_t agent, const AiTickContext& context ) {
+	board.at( HEALTH, agent ) += 5.0f * context.dt; // Regenerates while running away.
+	return moveToward( board, agent, context, -5.0f );
+}
+static BtStatus dive( Blackboard& board, uint32_t agent, const AiTickContext& context ) { return moveToward( board, agent, context, 7.0f ); }
+
+static BtStatus attack( Blackboard& board, uint32_t agent, const AiTickContext& ) {
+	board.at( COOLDOWN, agent ) = 1.0f;
+	board.at( HEALTH, agent ) -= 12.0f; // The player hits back.
+	return BtStatus::Success;
+}
+
+static BtStatus shoot( Blackboard& board, uint32_t agent, const AiTickContext& ) {
+	board.at( COOLDOWN, agent ) = 2.0f;
+	return BtStatus::Success;
+}
+
+static BtStatus patrol( Blackboard& board, uint32_t agent, const AiTickContext& context ) {
+	float& x = board.at( POS_X, agent );
+	float& direction = board.at( DIRECTION, agent );
+	x += direction * 1.5f * context.dt;
+	if ( std::fabs( x - board.at( HOME_X, agent ) ) > 6.0f ) direction = x > board.at( HOME_X, agent ) ? -1.0f : 1.0f;
+	return BtStatus::Running;
+}
+
+static Blackboard createBlackboard() {
+	Blackboard board;
+	for ( int key = 0; key < KEY_COUNT; key++ ) board.addKey();
+	return board;
+}
+
+static uint64_t hashBoards( AiSystem& ai, int groups ) {
+	uint64_t hash = 1469598103934665603ull;
+	for ( int group = 0; group < groups; group++ ) {
+		const Blackboard& board = ai.getBlackboard( group );
+		for ( uint16_t key = 0; key < KEY_COUNT; key++ ) {
+			for ( float value : board.column( key ) ) {
+				uint32_t bits;
+				std::memcpy( &bits, &value, sizeof( bits ) );
+				hash = ( hash ^ bits ) * 1099511628211ull;
+			}
+		}
+	}
+	return hash;
+}
+
+struct RunResult
+{
+	std::vector<double> frameMs;
+	double evaluated = 0.0, nodeVisits = 0.0;
+	double lod[ 3 ] = {};
+	uint64_t hash = 0;
+};
+
+static RunResult run( int agents, int frames, bool lod ) {
+	AiSystem ai;
+	const uint16_t SENSE = ai.addAction( sense ), CHASE = ai.addAction( chase ), FLEE = ai.addAction( flee );
+	const uint16_t DIVE = ai.addAction( dive ), ATTACK = ai.addAction( attack ), SHOOT = ai.addAction( shoot );
+	const uint16_t PATROL = ai.addAction( patrol );
+
+	// Grunt: flee when hurt, hit when adjacent, chase when close, otherwise patrol.
+	BehaviorTree grunt;
+	grunt.sequence();
+		grunt.action( SENSE );
+		grunt.selector();
+			grunt.sequence(); grunt.condition( HEALTH, BtCompare::Less, 20.0f ); grunt.action( FLEE ); grunt.end();
+			grunt.sequence(); grunt.condition( DISTANCE, BtCompare::Less, 1.5f ); grunt.condition( COOLDOWN, BtCompare::Less, 0.01f ); grunt.action( ATTACK ); grunt.end();
+			grunt.sequence(); grunt.condition( DISTANCE, BtCompare::Less, 20.0f ); grunt.action( CHASE ); grunt.end();
+			grunt.action( PATROL );
+		grunt.end();
+	grunt.end();
+
+	// Archer: back off when the player is close, shoot in range when not cooling down, otherwise approach or patrol.
+	BehaviorTree archer;
+	archer.sequence();
+		archer.action( SENSE );
+		archer.selector();
+			archer.sequence(); archer.condition( DISTANCE, BtCompare::Less, 4.0f ); archer.action( FLEE ); archer.end();
+			archer.sequence();
+				archer.condition( DISTANCE, BtCompare::Less, 14.0f );
+				archer.inverter(); archer.condition( COOLDOWN, BtCompare::Greater, 0.0f ); archer.end();
+				archer.action( SHOOT );
+			archer.end();
+			archer.sequence(); archer.condition( DISTANCE, BtCompare::Less, 25.0f ); archer.action( CHASE ); archer.end();
+			archer.action( PATROL );
+		archer.end();
+	archer.end();
+
+	// Flyer: dive at the player when near, otherwise drift along its patrol.
+	BehaviorTree flyer;
+	flyer.sequence();
+		flyer.action( SENSE );
+		flyer.selector();
+			flyer.sequence(); flyer.condition( DISTANCE, BtCompare::Less, 1.0f ); flyer.action( ATTACK ); flyer.end();
+			flyer.sequence(); flyer.condition( DISTANCE, BtCompare::Less, 30.0f ); flyer.action( DIVE ); flyer.end();
+			flyer.action( PATROL );
+		flyer.end();
+	flyer.end();
+
+	const int groups[ 3 ] = {
+		ai.addGroup( grunt, createBlackboard(), POS_X, POS_Y ),
+		ai.addGroup( archer, createBlackboard(), POS_X, POS_Y ),
+		ai.addGroup( flyer, createBlackboard(), POS_X, POS_Y )
+	};
+	Random random( 7 );
+	for ( int i = 0; i < agents; i++ ) {
+		const int group = groups[ i % 5 < 3 ? 0 : i % 5 == 3 ? 1 : 2 ]; // 60% grunts, 20% archers, 20% flyers.
+		const uint32_t agent = ai.addAgent( group );
+		Blackboard& board = ai.getBlackboard( group );
+		board.at( POS_X, agent ) = board.at( HOME_X, agent ) = random.range( 0.0f, LEVEL_WIDTH );
+		board.at( POS_Y, agent ) = random.range( 0.0f, LEVEL_HEIGHT );
+		board.at( DIRECTION, agent ) = random.range( 0, 1 ) ? 1.0f : -1.0f;
+		board.at( HEALTH, agent ) = 100.0f;
+	}
+
+	AiLodSettings settings;
+	settings.enabled = lod;
+	ai.setLodSettings( settings );
+
+	RunResult result;
+	const float dt = 1.0f / 60.0f;
+	for ( int frame = 0; frame < frames; frame++ ) {
+		// The player walks the length of the level and back, bobbing between floors.
+		const float t = static_cast< float >( frame ) / frames;
+		const glm::vec2 player( LEVEL_WIDTH * ( 0.5f - 0.45f * std::cos( t * 6.2831853f ) ), LEVEL_HEIGHT * 0.5f + 20.0f * std::sin( t * 25.0f ) );
+
+		BenchTimer timer;
+		ai.update( dt, player );
+		result.frameMs.push_back( timer.elapsedMs() );
+
+		const AiStats& stats = ai.getStats();
+		result.evaluated += stats.evaluated;
+		result.nodeVisits += stats.nodeVisits;
+		for ( int i = 0; i < 3; i++ ) result.lod[ i ] += stats.lodCounts[ i ];
+	}
+	result.evaluated /= frames;
+	result.nodeVisits /= frames;
+	for ( double& count : result.lod ) count /= frames;
+	result.hash = hashBoards( ai, 3 );
+	return result;
+}
+
+static void writeRun( JsonWriter& json, const char* key, const RunResult& result ) {
+	char hashText[ 17 ];
+	std::snprintf( hashText, sizeof( hashText ), "%016llx", static_cast< unsigned long long >( result.hash ) );
+	json.beginObject( key );
+	json.value( "frame_ms", computePercentiles( result.frameMs ) );
+	json.value( "trees_per_frame", result.evaluated );
+	json.value( "nodes_per_frame", result.nodeVisits );
+	json.value( "near_agents", result.lod[ 0 ] );
+	json.value( "far_agents", result.lod[ 1 ] );
+	json.value( "dormant_agents", result.lod[ 2 ] );
+	json.value( "blackboard_hash", std::string( hashText ) );
+	json.endObject();
+}
+
+int main( int argc, char** argv ) {
+	int agents = 2000;
+	int frames = 1200;
+	int threads = -1;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--agents" ) ) agents = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--frames" ) ) frames = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--threads" ) ) threads = std::atoi( argv[ i + 1 ] );
+	}
+	if ( agents <= 0 ) agents = 1;
+	if ( frames <= 0 ) frames = 1;
+
+	JobSystem& jobs = JobSystem::getInstance();
+	jobs.init( threads );
+	const int workers = jobs.getWorkerCount();
+	const RunResult lod = run( agents, frames, true );
+	const RunResult everyFrame = run( agents, frames, false );
+	jobs.shutdown();
+	jobs.init( 0 );
+	const RunResult inline0 = run( agents, frames, true );
+	jobs.shutdown();
+
+	const bool deterministic = lod.hash == inline0.hash;
+	if ( !deterministic ) std::cerr << "Err: Blackboards differ between the pooled and inline LOD runs." << std::endl;
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_ai_bench" ) );
+	json.value( "agents", static_cast< uint64_t >( agents ) );
+	json.value( "frames", static_cast< uint64_t >( frames ) );
+	json.value( "workers", static_cast< uint64_t >( workers ) );
+	writeRun( json, "lod", lod );
+	writeRun( json, "every_frame", everyFrame );
+	writeRun( json, "lod_inline", inline0 );
+	json.value( "deterministic", deterministic );
+	json.endObject();
+
+	return deterministic ? 0 : 1;
+}
@@ -0,0 +1,378 @@
+// Animation benchmark.
+//
+// Animates 1,000 characters with a 16-bone skeleton and a 64-vertex skinned
+// mesh spread over a 300 x 100 meter level while the camera pans across it.
+// Every character runs the same five-state machine (idle, run, sword, spear,
+// shield block) driven by gameplay parameters that change every few seconds.
+// Three runs: AnimationSystem with LOD, AnimationSystem posing and skinning
+// everything, and a per-entity baseline of virtual update() calls over float
+// keyframes found by binary search, as the game did before. Reports the time
+// per frame, poses and skins per frame and LOD counts, and the largest
+// distance between the batched and the baseline skinned vertices, which
+// must stay under a millimeter (track quantization). Reports JSON.
+//
+// Usage: arcantha_animation_bench [--characters N] [--frames N] [--threads N]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Animation.h"
+#include "JobSystem.h"
+#include "Random.h"
+#include "bench_common.h"
+
+static const float DT = 1.0f / 60.0f;
+static const float LEVEL_WIDTH = 300.0f;
+static const float LEVEL_HEIGHT = 100.0f;
+
+/**
+ * @brief Everything both implementations are built from.
+ */
+struct Content
+{
+	std::vector<int16_t> parents;
+	std::vector<BonePose> bind;
+	std::vector<AnimVertex> vertices;
+	std::vector<AnimClipDesc> clips;
+	std::vector<AnimStateDesc> states;
+	std::vector<AnimTransitionDesc> transitions;
+};
+
+static Content buildContent() {
+	Content content;
+	const struct { int16_t parent; float x, y; } bones[ 16 ] = {
+		{ -1, 0.0f, 0.0f }, { 0, 0.0f, 1.0f }, { 1, 0.0f, 0.3f }, { 2, 0.0f, 0.3f }, { 3, 0.0f, 0.25f }, { 4, 0.0f, 0.15f },
+		{ 3, -0.2f, 0.2f }, { 6, 0.0f, -0.3f }, { 7, 0.0f, -0.3f }, { 3, 0.2f, 0.2f }, { 9, 0.0f, -0.3f }, { 10, 0.0f, -0.3f },
+		{ 1, -0.1f, 0.0f }, { 12, 0.0f, -0.45f }, { 1, 0.1f, 0.0f }, { 14, 0.0f, -0.45f } };
+	std::vector<glm::vec2> world;
+	for ( int bone = 0; bone < 16; bone++ ) {
+		content.parents.push_back( bones[ bone ].parent );
+		BonePose pose;
+		pose.x = bones[ bone ].x;
+		pose.y = bones[ bone ].y;
+		content.bind.push_back( pose );
+		world.push_back( glm::vec2( pose.x, pose.y ) + ( bones[ bone ].parent < 0 ? glm::vec2( 0.0f ) : world[ bones[ bone ].parent ] ) );
+	}
+	// One sprite quad per bone: the corners at the joint blend with the parent.
+	for ( uint8_t bone = 0; bone < 16; bone++ ) {
+		const uint8_t parent = static_cast< uint8_t >( std::max< int16_t >( bones[ bone ].parent, 0 ) );
+		const glm::vec2 p = world[ bone ];
+		content.vertices.push_back( { p.x - 0.08f, p.y, bone, parent, 0.6f } );
+		content.vertices.push_back( { p.x + 0.08f, p.y, bone, parent, 0.6f } );
+		content.vertices.push_back( { p.x + 0.08f, p.y + 0.2f, bone, parent, 1.0f } );
+		content.vertices.push_back( { p.x - 0.08f, p.y + 0.2f, bone, parent, 1.0f } );
+	}
+
+	// Key times fall on the 30 Hz samples, so the compiled tracks differ from the keys only by quantization.
+	Random random( 5 );
+	const struct { const char* name; float duration; bool loop; float amplitude; } clips[ 5 ] = {
+		{ "idle", 2.0f, true, 0.1f }, { "run", 0.8f, true, 0.8f }, { "sword", 0.4f, false, 1.5f }, { "spear", 0.8f, false, 1.0f }, { "block", 1.2f, true, 0.2f } };
+	for ( const auto& clip : clips ) {
+		AnimClipDesc desc;
+		desc.name = clip.name;
+		desc.duration = clip.duration;
+		desc.loop = clip.loop;
+		for ( uint16_t bone = 1; bone < 16; bone++ ) {
+			const float phase = random.range( 0.0f, 6.2831853f ), amplitude = clip.amplitude * random.range( 0.3f, 1.0f );
+			for ( int key = 0; key <= 4; key++ ) {
+				const float value = amplitude * std::sin( phase + key * 1.5707963f );
+				desc.keys.push_back( { bone, AnimChannel::Rotation, clip.duration * key / 4.0f, clip.loop && key == 4 ? amplitude * std::sin( phase ) : value } );
+			}
+		}
+		desc.keys.push_back( { 1, AnimChannel::Y, 0.0f, 1.0f } );
+		desc.keys.push_back( { 1, AnimChannel::Y, clip.duration * 0.5f, 0.9f } );
+		desc.keys.push_back( { 1, AnimChannel::Y, clip.duration, 1.0f } );
+		for ( uint16_t frame = 0; frame < 8; frame++ ) desc.flipbook.push_back( frame );
+		content.clips.push_back( desc );
+	}
+
+	content.states = { { 0, 1.0f }, { 1, 1.0f }, { 2, 1.0f }, { 3, 1.0f }, { 4, 1.0f } };
+	// Parameters: 0 speed, 1 sword, 2 spear, 3 block.
+	for ( uint16_t from : { 0, 1 } ) {
+		content.transitions.push_back( { from, 2, AnimCondition::Greater, 1, 0.5f, 0.05f } );
+		content.transitions.push_back( { from, 3, AnimCondition::Greater, 2, 0.5f, 0.05f } );
+		content.transitions.push_back( { from, 4, AnimCondition::Greater, 3, 0.5f, 0.1f } );
+	}
+	content.transitions.push_back( { 0, 1, AnimCondition::Greater, 0, 0.1f, 0.15f } );
+	content.transitions.push_back( { 1, 0, AnimCondition::Less, 0, 0.1f, 0.15f } );
+	content.transitions.push_back( { 2, 0, AnimCondition::Finished, 0, 0.0f, 0.1f } );
+	content.transitions.push_back( { 3, 0, AnimCondition::Finished, 0, 0.0f, 0.1f } );
+	content.transitions.push_back( { 4, 0, AnimCondition::Less, 3, 0.5f, 0.1f } );
+	return content;
+}
+
+/**
+ * @brief The gameplay input of one character this frame.
+ */
+static void drive( uint32_t character, int frame, float parameters[ 4 ] ) {
+	const int local = frame + static_cast< int >( character * 37 );
+	parameters[ 0 ] = local % 240 < 150 ? 1.0f : 0.0f;
+	parameters[ 1 ] = local % 180 == 0 ? 1.0f : 0.0f;
+	parameters[ 2 ] = local % 300 == 90 ? 1.0f : 0.0f;
+	parameters[ 3 ] = local % 420 > 360 ? 1.0f : 0.0f;
+}
+
+/**
+ * @brief The camera's center at a frame.
+ */
+static glm::vec2 focusAt( int frame, int frames ) {
+	return glm::vec2( 20.0f + ( LEVEL_WIDTH - 40.0f ) * frame / frames, LEVEL_HEIGHT * 0.5f );
+}
+
+/**
+ * @brief The baseline's per-entity interface.
+ */
+class Animated
+{
+public:
+	virtual ~Animated() = default;
+	virtual void setParameter( int parameter, float value ) = 0;
+	virtual void update( float dt ) = 0;
+	virtual const std::vector<glm::vec2>& getSkinned() const = 0;
+};
+
+/**
+ * @brief A character animated on its own from float keyframes.
+ */
+class KeyframedCharacter : public Animated
+{
+public:
+	explicit KeyframedCharacter( const Content& content ) : content( content ), world( 16 ), skinned( content.vertices.size() ) {
+		for ( size_t bone = 0; bone < 16; bone++ ) {
+			world[ bone ] = local( content.bind[ bone ] );
+			if ( content.parents[ bone ] >= 0 ) world[ bone ] = world[ content.parents[ bone ] ] * world[ bone ];
+			inverseBind.push_back( glm::inverse( world[ bone ] ) );
+		}
+	}
+
+	void setParameter( int parameter, float value ) override { parameters[ parameter ] = value; }
+	const std::vector<glm::vec2>& getSkinned() const override { return skinned; }
+
+	void update( float dt ) override {
+		const bool finished = step( state, time, dt );
+		if ( blend < 1.0f ) {
+			step( fromState, fromTime, dt );
+			blend = std::min( blend + dt / blendDuration, 1.0f );
+		}
+		for ( const AnimTransitionDesc& transition : content.transitions ) {
+			if ( transition.from != state ) continue;
+			const float value = parameters[ transition.parameter ];
+			const bool taken = transition.condition == AnimCondition::Finished ? finished :
+				transition.condition == AnimCondition::Greater ? value > transition.threshold : value < transition.threshold;
+			if ( !taken ) continue;
+			fromState = state;
+			fromTime = time;
+			state = transition.to;
+			time = 0.0f;
+			blendDuration = transition.blend;
+			blend = transition.blend > 0.0f ? 0.0f : 1.0f;
+			break;
+		}
+
+		std::vector<BonePose> pose = evaluate( state, time );
+		if ( blend < 1.0f ) {
+			const std::vector<BonePose> old = evaluate( fromState, fromTime );
+			for ( size_t bone = 0; bone < 16; bone++ ) {
+				float turn = std::fmod( pose[ bone ].rotation - old[ bone ].rotation + 3.14159265f, 6.2831853f );
+				if ( turn < 0.0f ) turn += 6.2831853f;
+				pose[ bone ].rotation = old[ bone ].rotation + ( turn - 3.14159265f ) * blend;
+				pose[ bone ].x = old[ bone ].x + ( pose[ bone ].x - old[ bone ].x ) * blend;
+				pose[ bone ].y = old[ bone ].y + ( pose[ bone ].y - old[ bone ].y ) * blend;
+				pose[ bone ].scale = old[ bone ].scale + ( pose[ bone ].scale - old[ bone ].scale ) * blend;
+			}
+		}
+		for ( size_t bone = 0; bone < 16; bone++ ) {
+			world[ bone ] = local( pose[ bone ] );
+			if ( content.parents[ bone ] >= 0 ) world[ bone ] = world[ content.parents[ bone ] ] * world[ bone ];
+		}
+		for ( size_t i = 0; i < content.vertices.size(); i++ ) {
+			const AnimVertex& vertex = content.vertices[ i ];
+			const glm::vec3 point( vertex.x, vertex.y, 1.0f );
+			const glm::vec3 a = world[ vertex.bone0 ] * inverseBind[ vertex.bone0 ] * point;
+			const glm::vec3 b = world[ vertex.bone1 ] * inverseBind[ vertex.bone1 ] * point;
+			skinned[ i ] = glm::vec2( a ) * vertex.weight + glm::vec2( b ) * ( 1.0f - vertex.weight );
+		}
+	}
+
+private:
+	const Content& content;
+	std::vector<glm::mat3> world, inverseBind;
+	std::vector<glm::vec2> skinned;
+	float parameters[ 4 ] = {};
+	uint16_t state = 0, fromState = 0;
+	float time = 0.0f, fromTime = 0.0f, blend = 1.0f, blendDuration = 0.0f;
+
+	static glm::mat3 local( const BonePose& pose ) {
+		const float c = std::cos( pose.rotation ) * pose.scale, s = std::sin( pose.rotation ) * pose.scale;
+		return glm::mat3( c, s, 0.0f, -s, c, 0.0f, pose.x, pose.y, 1.0f );
+	}
+
+	bool step( uint16_t which, float& clipTime, float dt ) const {
+		const AnimClipDesc& clip = content.clips[ content.states[ which ].clip ];
+		clipTime += dt * content.states[ which ].speed;
+		if ( clip.loop ) clipTime = std::fmod( clipTime, clip.duration );
+		else if ( clipTime >= clip.duration ) {
+			clipTime = clip.duration;
+			return true;
+		}
+		return false;
+	}
+
+	std::vector<BonePose> evaluate( uint16_t which, float clipTime ) const {
+		std::vector<BonePose> pose = content.bind;
+		const AnimClipDesc& clip = content.clips[ content.states[ which ].clip ];
+		for ( size_t first = 0; first < clip.keys.size(); ) {
+			size_t last = first;
+			while ( last < clip.keys.size() && clip.keys[ last ].bone == clip.keys[ first ].bone && clip.keys[ last ].channel == clip.keys[ first ].channel ) last++;
+			auto next = std::upper_bound( clip.keys.begin() + first, clip.keys.begin() + last, clipTime,
+				[]( float t, const AnimKey& key ) { return t < key.time; } );
+			float value;
+			if ( next == clip.keys.begin() + first ) value = next->value;
+			else if ( next == clip.keys.begin() + last ) value = ( next - 1 )->value;
+			else value = ( next - 1 )->value + ( next->value - ( next - 1 )->value ) * ( clipTime - ( next - 1 )->time ) / ( next->time - ( next - 1 )->time );
+			BonePose& bone = pose[ clip.keys[ first ].bone ];
+			if ( clip.keys[ first ].channel == AnimChannel::Rotation ) bone.rotation = value;
+			else bone.y = value;
+			first = last;
+		}
+		return pose;
+	}
+};
+
+struct RunResult
+{
+	std::vector<double> frameMs;
+	double posed = 0.0, skinned = 0.0;
+	uint32_t lodCounts[ 3 ] = {};
+	uint32_t trackBytes = 0;
+	std::vector<std::vector<glm::vec2>> finalSkins; // Of the first characters, for the comparison.
+};
+
+static const uint32_t COMPARED = 16;
+
+static RunResult runSystem( const Content& content, const std::vector<glm::vec2>& positions, int frames, bool lod ) {
+	AnimationSystem animation;
+	const int skeleton = animation.addSkeleton( content.parents, content.bind );
+	const int mesh = animation.addMesh( skeleton, content.vertices );
+	for ( const AnimClipDesc& clip : content.clips ) animation.addClip( skeleton, clip );
+	const int machine = animation.addStateMachine( content.states, content.transitions );
+	AnimLodSettings settings;
+	settings.enabled = lod;
+	animation.setLodSettings( settings );
+	for ( const glm::vec2& position : positions ) animation.addCharacter( machine, mesh, position );
+
+	RunResult result;
+	for ( int frame = 0; frame < frames; frame++ ) {
+		BenchTimer timer;
+		for ( uint32_t character = 0; character < positions.size(); character++ ) {
+			float parameters[ 4 ];
+			drive( character, frame, parameters );
+			for ( int p = 0; p < 4; p++ ) animation.setParameter( character, p, parameters[ p ] );
+		}
+		animation.update( DT, focusAt( frame, frames ) );
+		result.frameMs.push_back( timer.elapsedMs() );
+		result.posed += animation.getStats().posed;
+		result.skinned += animation.getStats().skinned;
+	}
+	result.posed /= frames;
+	result.skinned /= frames;
+	for ( int i = 0; i < 3; i++ ) result.lodCounts[ i ] = animation.getStats().lodCounts[ i ];
+	result.trackBytes = animation.getStats().trackBytes;
+	for ( uint32_t character = 0; character < COMPARED && character < positions.size(); character++ ) {
+		result.finalSkins.push_back( animation.getSkinnedVertices( character ) );
+	}
+	return result;
+}
+
+static RunResult runBaseline( const Content& content, const std::vector<glm::vec2>& positions, int frames ) {
+	std::vector<std::unique_ptr<Animated>> entities;
+	for ( size_t i = 0; i < positions.size(); i++ ) entities.push_back( std::unique_ptr<Animated>( new KeyframedCharacter( content ) ) );
+
+	RunResult result;
+	for ( int frame = 0; frame < frames; frame++ ) {
+		BenchTimer timer;
+		for ( uint32_t character = 0; character < entities.size(); character++ ) {
+			float parameters[ 4 ];
+			drive( character, frame, parameters );
+			for ( int p = 0; p < 4; p++ ) entities[ character ]->setParameter( p, parameters[ p ] );
+			entities[ character ]->update( DT );
+		}
+		result.frameMs.push_back( timer.elapsedMs() );
+	}
+	result.posed = result.skinned = static_cast< double >( entities.size() );
+	for ( uint32_t character = 0; character < COMPARED && character < entities.size(); character++ ) {
+		result.finalSkins.push_back( entities[ character ]->getSkinned() );
+	}
+	return result;
+}
+
+static void writeRun( JsonWriter& json, const char* key, const RunResult& result ) {
+	json.beginObject( key );
+	json.value( "frame_ms", computePercentiles( result.frameMs ) );
+	json.value( "posed_per_frame", result.posed );
+	json.value( "skinned_per_frame", result.skinned );
+	json.value( "near", static_cast< uint64_t >( result.lodCounts[ 0 ] ) );
+	json.value( "far", static_cast< uint64_t >( result.lodCounts[ 1 ] ) );
+	json.value( "dormant", static_cast< uint64_t >( result.lodCounts[ 2 ] ) );
+	json.endObject();
+}
+
+int main( int argc, char** argv ) {
+	int characters = 1000;
+	int frames = 600;
+	int threads = -1;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--characters" ) ) characters = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--frames" ) ) frames = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--threads" ) ) threads = std::atoi( argv[ i + 1 ] );
+	}
+	if ( characters <= 0 ) characters = 1;
+	if ( frames <= 0 ) frames = 1;
+
+	JobSystem& jobs = JobSystem::getInstance();
+	jobs.init( threads );
+	const Content content = buildContent();
+	Random random( 8 );
+	std::vector<glm::vec2> positions;
+	for ( int i = 0; i < characters; i++ ) positions.push_back( glm::vec2( random.range( 0.0f, LEVEL_WIDTH ), random.range( 0.0f, LEVEL_HEIGHT ) ) );
+
+	const RunResult lod = runSystem( content, positions, frames, true );
+	const RunResult full = runSystem( content, positions, frames, false );
+	const RunResult baseline = runBaseline( content, positions, frames );
+	const int workers = jobs.getWorkerCount();
+	jobs.shutdown();
+
+	float maxError = 0.0f;
+	for ( size_t character = 0; character < full.finalSkins.size(); character++ ) {
+		for ( size_t v = 0; v < content.vertices.size(); v++ ) {
+			maxError = std::max( maxError, glm::length( full.finalSkins[ character ][ v ] - baseline.finalSkins[ character ][ v ] ) );
+		}
+	}
+	size_t keyBytes = 0;
+	for ( const AnimClipDesc& clip : content.clips ) keyBytes += clip.keys.size() * sizeof( AnimKey );
+	const bool accurate = maxError < 1e-3f;
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_animation_bench" ) );
+	json.value( "characters", static_cast< uint64_t >( characters ) );
+	json.value( "frames", static_cast< uint64_t >( frames ) );
+	json.value( "workers", static_cast< uint64_t >( workers ) );
+	json.value( "track_bytes", static_cast< uint64_t >( lod.trackBytes ) );
+	json.value( "key_bytes", static_cast< uint64_t >( keyBytes ) );
+	writeRun( json, "batched_lod", lod );
+	writeRun( json, "batched_full", full );
+	writeRun( json, "virtual_baseline", baseline );
+	json.value( "max_error_m", static_cast< double >( maxError ) );
+	json.value( "accurate", accurate );
+	json.endObject();
+
+	if ( !accurate ) std::cerr << "Err: Batched skinning differs from the keyframe baseline by more than a millimeter." << std::endl;
+	return accurate ? 0 : 1;
+}
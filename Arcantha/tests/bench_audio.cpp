@@ -0,0 +1,322 @@
+// Offline audio benchmark.
+//
+// Opens an ALC_SOFT_loopback device, which mixes on demand instead of
+// following a sound card clock, and renders scripted combat scenarios through
+// VoiceManager faster than real time: 256 real voices with HRTF on and off,
+// with and without a reverb send, plus a 1024-voice scenario that exercises
+// virtualization. Reports mixer time per rendered second and a hash of the
+// rendered output as JSON. Everything is seeded, so the hash only changes when
+// the mix itself does.
+//
+// Usage: arcantha_audio_bench [--seconds N] [--scenario NAME] [--write-hashes FILE] [--check-hashes FILE]
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <AL/al.h>
+#include <AL/alc.h>
+#include <AL/alext.h>
+#include <AL/efx.h>
+
+#include "Random.h"
+#include "VoiceManager.h"
+#include "bench_common.h"
+
+static const int SAMPLE_RATE = 48000;
+static const int BLOCK_FRAMES = 1024; // Frames rendered per scripted update (~21 ms).
+
+struct AudioScenario
+{
+	const char* name;
+	int requestedVoices; // Voices the script keeps playing.
+	int realVoices; // Sources in the VoiceManager pool.
+	bool hrtf; // Request HRTF rendering.
+	bool reverb; // Send every voice to a reverb slot.
+};
+
+struct AudioResult
+{
+	std::string name;
+	AudioScenario scenario;
+	bool hrtfActive = false;
+	double renderedSeconds = 0.0;
+	double mixMsPerSecond = 0.0;
+	Percentiles mixBlockMs;
+	Percentiles voiceUpdateMs;
+	VoiceStats voices;
+	uint64_t hash = 0;
+};
+
+// Loopback and EFX entry points are extensions and have to be fetched at run time.
+static LPALCLOOPBACKOPENDEVICESOFT alcLoopbackOpenDevice;
+static LPALCRENDERSAMPLESSOFT alcRenderSamples;
+static LPALGENEFFECTS alGenEffectsPtr;
+static LPALDELETEEFFECTS alDeleteEffectsPtr;
+static LPALEFFECTI alEffectiPtr;
+static LPALGENAUXILIARYEFFECTSLOTS alGenAuxiliaryEffectSlotsPtr;
+static LPALDELETEAUXILIARYEFFECTSLOTS alDeleteAuxiliaryEffectSlotsPtr;
+static LPALAUXILIARYEFFECTSLOTI alAuxiliaryEffectSlotiPtr;
+
+static uint64_t fnv1a( uint64_t hash, const void* data, size_t bytes ) {
+	const unsigned char* p = static_cast< const unsigned char* >( data );
+	for ( size_t i = 0; i < bytes; i++ ) hash = ( hash ^ p[ i ] ) * 0x100000001B3ull;
+	return hash;
+}
+
+// Synthetic mono sounds, so the benchmark needs no asset files.
+static ALuint makeSound( int kind, Random& random ) {
+	const float seconds[] = { 1.0f, 0.3f, 0.8f, 0.5f };
+	std::vector<int16_t> samples( static_cast< size_t >( seconds[ kind ] * SAMPLE_RATE ) );
+	for ( size_t i = 0; i < samples.size(); i++ ) {
+		const float t = static_cast< float >( i ) / SAMPLE_RATE;
+		const float envelope = 1.0f - static_cast< float >( i ) / samples.size();
+		float v = 0.0f;
+		switch ( kind ) {
+		case 0: v = std::sin( 6.2831853f * 440.0f * t ); break; // Tone.
+		case 1: v = random.range( -1.0f, 1.0f ) * envelope; break; // Impact noise.
+		case 2: v = std::sin( 6.2831853f * ( 200.0f + 1200.0f * t ) * t ) * envelope; break; // Spell chirp.
+		default: v = std::sin( 6.2831853f * 110.0f * t ) > 0.0f ? 0.5f : -0.5f; break; // Looping hum.
+		}
+		samples[ i ] = static_cast< int16_t >( v * 12000.0f );
+	}
+
+	ALuint buffer = 0;
+	alGenBuffers( 1, &buffer );
+	alBufferData( buffer, AL_FORMAT_MONO16, samples.data(), static_cast< ALsizei >( samples.size() * sizeof( int16_t ) ), SAMPLE_RATE );
+	return buffer;
+}
+
+static bool runScenario( const AudioScenario& scenario, double seconds, AudioResult& result ) {
+	result.name = scenario.name;
+	result.scenario = scenario;
+
+	ALCdevice* device = alcLoopbackOpenDevice( nullptr );
+	if ( !device ) {
+		std::cerr << "Err: Failure to open loopback device." << std::endl;
+		return false;
+	}
+	const ALCint attributes[] = {
+		ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+		ALC_FORMAT_TYPE_SOFT, ALC_SHORT_SOFT,
+		ALC_FREQUENCY, SAMPLE_RATE,
+		ALC_HRTF_SOFT, scenario.hrtf ? ALC_TRUE : ALC_FALSE,
+		ALC_MONO_SOURCES, scenario.realVoices + 16,
+		ALC_MAX_AUXILIARY_SENDS, 1,
+		0
+	};
+	ALCcontext* context = alcCreateContext( device, attributes );
+	if ( !context || !alcMakeContextCurrent( context ) ) {
+		std::cerr << "Err: Failure to create loopback context." << std::endl;
+		if ( context ) alcDestroyContext( context );
+		alcCloseDevice( device );
+		return false;
+	}
+	ALCint hrtfStatus = ALC_FALSE;
+	alcGetIntegerv( device, ALC_HRTF_SOFT, 1, &hrtfStatus );
+	result.hrtfActive = hrtfStatus == ALC_TRUE;
+
+	Random random( 0xA0D10 );
+	ALuint sounds[ 4 ];
+	for ( int i = 0; i < 4; i++ ) sounds[ i ] = makeSound( i, random );
+
+	VoiceManager voices;
+	if ( !voices.init( scenario.realVoices, scenario.requestedVoices ) ) {
+		std::cerr << "Err: Failure to create voices for " << scenario.name << "." << std::endl;
+		alDeleteBuffers( 4, sounds );
+		alcMakeContextCurrent( nullptr );
+		alcDestroyContext( context );
+		alcCloseDevice( device );
+		return false;
+	}
+	voices.setAttenuation( 2.0f, 60.0f );
+	voices.setCategoryLimit( SoundCategory::Footstep, 0 ); // The script controls the voice count.
+
+	ALuint effect = 0, slot = 0;
+	if ( scenario.reverb ) {
+		alGenEffectsPtr( 1, &effect );
+		alEffectiPtr( effect, AL_EFFECT_TYPE, AL_EFFECT_REVERB );
+		alGenAuxiliaryEffectSlotsPtr( 1, &slot );
+		alAuxiliaryEffectSlotiPtr( slot, AL_EFFECTSLOT_EFFECT, static_cast< ALint >( effect ) );
+		voices.setAuxiliarySend( slot );
+	}
+
+	std::vector<VoiceHandle> handles( static_cast< size_t >( scenario.requestedVoices ), 0 );
+	std::vector<glm::vec2> velocities( handles.size() );
+	std::vector<int16_t> output( BLOCK_FRAMES * 2 );
+	std::vector<double> mixMs, updateMs;
+	uint64_t hash = 0xCBF29CE484222325ull;
+	double totalMixMs = 0.0;
+
+	const int blocks = static_cast< int >( seconds * SAMPLE_RATE / BLOCK_FRAMES );
+	const float blockSeconds = static_cast< float >( BLOCK_FRAMES ) / SAMPLE_RATE;
+	for ( int block = 0; block < blocks; block++ ) {
+		BenchTimer update;
+
+		// Keep every slot busy: finished voices are replaced by a new random sound.
+		for ( size_t i = 0; i < handles.size(); i++ ) {
+			if ( voices.isPlaying( handles[ i ] ) ) continue;
+
+			VoiceParams params;
+			const int kind = random.range( 0, 3 );
+			params.category = static_cast< SoundCategory >( random.range( 1, 6 ) );
+			params.priority = random.range( 0, 2 );
+			params.position = glm::vec2( random.range( -50.0f, 50.0f ), random.range( -20.0f, 20.0f ) );
+			params.gain = random.range( 0.3f, 1.0f );
+			params.pitch = random.range( 0.8f, 1.25f );
+			params.loop = kind == 3;
+			velocities[ i ] = glm::vec2( random.range( -8.0f, 8.0f ), 0.0f );
+			handles[ i ] = voices.play( sounds[ kind ], params );
+		}
+		// Enemies walk around and the listener follows the player in a slow circle.
+		for ( size_t i = block % 8; i < handles.size(); i += 8 ) {
+			float t = static_cast< float >( block ) * blockSeconds;
+			voices.setPosition( handles[ i ], glm::vec2( std::fmod( velocities[ i ].x * t + i, 100.0f ) - 50.0f, static_cast< float >( i % 40 ) - 20.0f ) );
+		}
+		const float angle = static_cast< float >( block ) * blockSeconds * 0.5f;
+		voices.setListener( glm::vec2( 10.0f * std::cos( angle ), 5.0f * std::sin( angle ) ) );
+		voices.update( blockSeconds );
+		updateMs.push_back( update.elapsedMs() );
+
+		BenchTimer mix;
+		alcRenderSamples( device, output.data(), BLOCK_FRAMES );
+		const double ms = mix.elapsedMs();
+		mixMs.push_back( ms );
+		totalMixMs += ms;
+
+		hash = fnv1a( hash, output.data(), output.size() * sizeof( int16_t ) );
+	}
+
+	result.renderedSeconds = static_cast< double >( blocks ) * blockSeconds;
+	result.mixMsPerSecond = result.renderedSeconds > 0.0 ? totalMixMs / result.renderedSeconds : 0.0;
+	result.mixBlockMs = computePercentiles( mixMs );
+	result.voiceUpdateMs = computePercentiles( updateMs );
+	result.voices = voices.getStats();
+	result.hash = hash;
+
+	voices.shutdown();
+	if ( scenario.reverb ) {
+		alDeleteAuxiliaryEffectSlotsPtr( 1, &slot );
+		alDeleteEffectsPtr( 1, &effect );
+	}
+	alDeleteBuffers( 4, sounds );
+	alcMakeContextCurrent( nullptr );
+	alcDestroyContext( context );
+	alcCloseDevice( device );
+	return true;
+}
+
+static std::string toHex( uint64_t value ) {
+	char text[ 17 ];
+	std::snprintf( text, sizeof( text ), "%016llx", static_cast< unsigned long long >( value ) );
+	return text;
+}
+
+int main( int argc, char** argv ) {
+	double seconds = 10.0;
+	std::string only, writeHashes, checkHashes;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--seconds" ) ) seconds = std::atof( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--scenario" ) ) only = argv[ i + 1 ];
+		else if ( !std::strcmp( argv[ i ], "--write-hashes" ) ) writeHashes = argv[ i + 1 ];
+		else if ( !std::strcmp( argv[ i ], "--check-hashes" ) ) checkHashes = argv[ i + 1 ];
+	}
+	if ( seconds <= 0.0 ) seconds = 1.0;
+
+	if ( !alcIsExtensionPresent( nullptr, "ALC_SOFT_loopback" ) ) {
+		std::cerr << "Err: ALC_SOFT_loopback is not available." << std::endl;
+		return 1;
+	}
+	alcLoopbackOpenDevice = reinterpret_cast< LPALCLOOPBACKOPENDEVICESOFT >( alcGetProcAddress( nullptr, "alcLoopbackOpenDeviceSOFT" ) );
+	alcRenderSamples = reinterpret_cast< LPALCRENDERSAMPLESSOFT >( alcGetProcAddress( nullptr, "alcRenderSamplesSOFT" ) );
+	alGenEffectsPtr = reinterpret_cast< LPALGENEFFECTS >( alGetProcAddress( "alGenEffects" ) );
+	alDeleteEffectsPtr = reinterpret_cast< LPALDELETEEFFECTS >( alGetProcAddress( "alDeleteEffects" ) );
+	alEffectiPtr = reinterpret_cast< LPALEFFECTI >( alGetProcAddress( "alEffecti" ) );
+	alGenAuxiliaryEffectSlotsPtr = reinterpret_cast< LPALGENAUXILIARYEFFECTSLOTS >( alGetProcAddress( "alGenAuxiliaryEffectSlots" ) );
+	alDeleteAuxiliaryEffectSlotsPtr = reinterpret_cast< LPALDELETEAUXILIARYEFFECTSLOTS >( alGetProcAddress( "alDeleteAuxiliaryEffectSlots" ) );
+	alAuxiliaryEffectSlotiPtr = reinterpret_cast< LPALAUXILIARYEFFECTSLOTI >( alGetProcAddress( "alAuxiliaryEffectSloti" ) );
+	if ( !alcLoopbackOpenDevice || !alcRenderSamples ) {
+		std::cerr << "Err: ALC_SOFT_loopback functions are missing." << std::endl;
+		return 1;
+	}
+	if ( !alGenEffectsPtr || !alDeleteEffectsPtr || !alEffectiPtr || !alGenAuxiliaryEffectSlotsPtr || !alDeleteAuxiliaryEffectSlotsPtr ||
+		!alAuxiliaryEffectSlotiPtr ) {
+		std::cerr << "Err: EFX functions are missing." << std::endl;
+		return 1;
+	}
+
+	const AudioScenario scenarios[] = {
+		{ "voices_256", 256, 256, false, false },
+		{ "voices_256_hrtf", 256, 256, true, false },
+		{ "voices_256_reverb", 256, 256, false, true },
+		{ "voices_256_hrtf_reverb", 256, 256, true, true },
+		{ "combat_1024_virtual", 1024, VoiceManager::DEFAULT_REAL_VOICES, false, true },
+	};
+
+	std::vector<AudioResult> results;
+	for ( const AudioScenario& scenario : scenarios ) {
+		if ( !only.empty() && only != scenario.name ) continue;
+		AudioResult result;
+		if ( !runScenario( scenario, seconds, result ) ) return 1;
+		results.push_back( result );
+	}
+
+	// Hashes are compared per scenario; a baseline only has to list the scenarios it cares about.
+	bool hashesMatch = true;
+	if ( !checkHashes.empty() ) {
+		std::map<std::string, std::string> expected;
+		std::ifstream in( checkHashes );
+		std::string name, hex;
+		while ( in >> name >> hex ) expected[ name ] = hex;
+		for ( const AudioResult& result : results ) {
+			auto it = expected.find( result.name );
+			if ( it != expected.end() && it->second != toHex( result.hash ) ) {
+				std::cerr << "Err: Output hash of " << result.name << " changed: " << it->second << " -> " << toHex( result.hash ) << std::endl;
+				hashesMatch = false;
+			}
+		}
+	}
+	if ( !writeHashes.empty() ) {
+		std::ofstream out( writeHashes );
+		for ( const AudioResult& result : results ) out << result.name << " " << toHex( result.hash ) << "\n";
+	}
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_audio_bench" ) );
+	json.value( "sample_rate", static_cast< uint64_t >( SAMPLE_RATE ) );
+	json.value( "block_frames", static_cast< uint64_t >( BLOCK_FRAMES ) );
+	json.beginArray( "scenarios" );
+	for ( const AudioResult& result : results ) {
+		json.beginObject();
+		json.value( "name", result.name );
+		json.value( "requested_voices", static_cast< uint64_t >( result.scenario.requestedVoices ) );
+		json.value( "real_voices", static_cast< uint64_t >( result.scenario.realVoices ) );
+		json.value( "hrtf_requested", result.scenario.hrtf );
+		json.value( "hrtf_active", result.hrtfActive );
+		json.value( "reverb_send", result.scenario.reverb );
+		json.value( "rendered_seconds", result.renderedSeconds );
+		json.value( "mix_ms_per_rendered_second", result.mixMsPerSecond );
+		json.value( "realtime_factor", result.mixMsPerSecond > 0.0 ? 1000.0 / result.mixMsPerSecond : 0.0 );
+		json.value( "mix_block_ms", result.mixBlockMs );
+		json.value( "voice_update_ms", result.voiceUpdateMs );
+		json.value( "voices_started", result.voices.started );
+		json.value( "voices_stolen", result.voices.stolen );
+		json.value( "voices_rejected", result.voices.rejected );
+		json.value( "promotions", result.voices.promotions );
+		json.value( "demotions", result.voices.demotions );
+		json.value( "output_hash", toHex( result.hash ) );
+		json.endObject();
+	}
+	json.endArray();
+	json.value( "hashes_match", hashesMatch );
+	json.endObject();
+
+	return hashesMatch ? 0 : 1;
+}
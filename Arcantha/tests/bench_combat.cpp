@@ -0,0 +1,144 @@
+// Combat collision benchmark.
+//
+// Runs 300 combatants in two teams, packed into a narrow arena and moving
+// deterministically, each starting a random light, heavy, spear, shield or
+// parry move whenever it is idle. Reports the cost of CombatCollision::tick()
+// and what the sweep saw (active boxes, overlapping pairs, contacts, events by
+// type). Every tick the sweep's pair count is checked against a brute-force
+// O(n^2) overlap test of the same boxes, which is also timed for comparison.
+// Reports JSON and fails if the two disagree.
+//
+// Usage: arcantha_combat_bench [--combatants N] [--ticks N] [--seed N]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "CombatCollision.h"
+#include "Random.h"
+#include "Simd.h"
+#include "bench_common.h"
+
+static const float ARENA_WIDTH = 60.0f; // Width of the band combatants move in, in meters.
+static const float ARENA_HEIGHT = 6.0f; // Height of the band.
+
+// Overlapping pairs between different owners, tested pair by pair.
+static uint64_t bruteForcePairs( const CombatBoxes& hits, const CombatBoxes& targets ) {
+	uint64_t pairs = 0;
+	for ( size_t h = 0; h < hits.size(); h++ ) {
+		for ( size_t t = 0; t < targets.size(); t++ ) {
+			if ( hits.owner[ h ] == targets.owner[ t ] ) continue;
+			if ( hits.minX[ h ] <= targets.maxX[ t ] && targets.minX[ t ] <= hits.maxX[ h ] &&
+				hits.minY[ h ] <= targets.maxY[ t ] && targets.minY[ t ] <= hits.maxY[ h ] ) pairs++;
+		}
+	}
+	return pairs;
+}
+
+int main( int argc, char** argv ) {
+	int combatants = 300;
+	int ticks = 3600;
+	uint64_t seed = 1;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--combatants" ) ) combatants = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--ticks" ) ) ticks = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--seed" ) ) seed = std::strtoull( argv[ i + 1 ], nullptr, 10 );
+	}
+	if ( combatants < 2 ) combatants = 2;
+	if ( ticks <= 0 ) ticks = 1;
+
+	const FrameDataTable table = FrameDataTable::createDefault();
+	CombatCollision combat( table );
+	Random random( seed );
+
+	// Health is high enough that nobody dies, so the load stays constant for the whole run.
+	std::vector<glm::vec2> position( combatants ), velocity( combatants );
+	for ( int i = 0; i < combatants; i++ ) {
+		position[ i ] = glm::vec2( random.range( 0.0f, ARENA_WIDTH ), random.range( 0.0f, ARENA_HEIGHT ) );
+		velocity[ i ] = glm::vec2( random.range( -2.0f, 2.0f ), random.range( -0.5f, 0.5f ) );
+		combat.addCombatant( position[ i ], glm::vec2( 0.4f, 0.9f ), static_cast< uint8_t >( i & 1 ), 1.0e9f );
+	}
+
+	std::vector<double> tickMs, bruteMs;
+	uint64_t hitBoxes = 0, targetBoxes = 0, candidatePairs = 0, contacts = 0, started = 0;
+	uint64_t eventCounts[ 5 ] = {};
+	uint64_t eventHash = 1469598103934665603ull;
+	bool pairsMatch = true;
+	const float dt = 1.0f / 60.0f;
+
+	for ( int t = 0; t < ticks; t++ ) {
+		for ( int i = 0; i < combatants; i++ ) {
+			if ( random.nextU32() % 90 == 0 ) velocity[ i ] = glm::vec2( random.range( -2.0f, 2.0f ), random.range( -0.5f, 0.5f ) );
+			if ( combat.getHitStop( i ) == 0 ) position[ i ] += velocity[ i ] * dt;
+			if ( position[ i ].x < 0.0f || position[ i ].x > ARENA_WIDTH ) velocity[ i ].x = -velocity[ i ].x;
+			if ( position[ i ].y < 0.0f || position[ i ].y > ARENA_HEIGHT ) velocity[ i ].y = -velocity[ i ].y;
+			combat.setPosition( i, position[ i ], velocity[ i ].x < 0.0f );
+
+			if ( combat.isIdle( i ) && random.nextU32() % 4 == 0 ) {
+				const uint16_t attack = static_cast< uint16_t >( random.range( 0, static_cast< int >( table.size() ) - 1 ) );
+				if ( combat.startAttack( i, attack ) ) started++;
+			}
+		}
+
+		BenchTimer timer;
+		combat.tick();
+		tickMs.push_back( timer.elapsedMs() );
+
+		const CombatStats& stats = combat.getStats();
+		hitBoxes += stats.hitBoxes;
+		targetBoxes += stats.targetBoxes;
+		candidatePairs += stats.candidatePairs;
+		contacts += stats.contacts;
+		for ( const CombatEvent& event : combat.getEvents() ) {
+			eventCounts[ static_cast< int >( event.type ) ]++;
+			for ( uint64_t word : { static_cast< uint64_t >( event.type ), static_cast< uint64_t >( event.attacker ),
+				static_cast< uint64_t >( event.defender ), static_cast< uint64_t >( event.attack ) } ) {
+				eventHash = ( eventHash ^ word ) * 1099511628211ull;
+			}
+		}
+
+		BenchTimer brute;
+		const uint64_t expected = bruteForcePairs( combat.getHitBoxes(), combat.getTargetBoxes() );
+		bruteMs.push_back( brute.elapsedMs() );
+		if ( expected != stats.candidatePairs && pairsMatch ) {
+			std::cerr << "Err: Tick " << t << " swept " << stats.candidatePairs << " pairs, brute force found " << expected << "." << std::endl;
+			pairsMatch = false;
+		}
+	}
+
+	char hashText[ 17 ];
+	std::snprintf( hashText, sizeof( hashText ), "%016llx", static_cast< unsigned long long >( eventHash ) );
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_combat_bench" ) );
+	json.value( "combatants", static_cast< uint64_t >( combatants ) );
+	json.value( "ticks", static_cast< uint64_t >( ticks ) );
+#if ARCANTHA_SIMD_SSE
+	json.value( "simd", true );
+#else
+	json.value( "simd", false );
+#endif
+	json.value( "tick_ms", computePercentiles( tickMs ) );
+	json.value( "brute_force_ms", computePercentiles( bruteMs ) );
+	json.value( "mean_hit_boxes", static_cast< double >( hitBoxes ) / ticks );
+	json.value( "mean_target_boxes", static_cast< double >( targetBoxes ) / ticks );
+	json.value( "mean_candidate_pairs", static_cast< double >( candidatePairs ) / ticks );
+	json.value( "mean_contacts", static_cast< double >( contacts ) / ticks );
+	json.value( "attacks_started", started );
+	json.beginObject( "events" );
+	json.value( "hit", eventCounts[ static_cast< int >( CombatEventType::Hit ) ] );
+	json.value( "blocked", eventCounts[ static_cast< int >( CombatEventType::Blocked ) ] );
+	json.value( "guard_break", eventCounts[ static_cast< int >( CombatEventType::GuardBreak ) ] );
+	json.value( "parried", eventCounts[ static_cast< int >( CombatEventType::Parried ) ] );
+	json.value( "clash", eventCounts[ static_cast< int >( CombatEventType::Clash ) ] );
+	json.endObject();
+	json.value( "event_hash", std::string( hashText ) );
+	json.value( "pairs_match", pairsMatch );
+	json.endObject();
+
+	return pairsMatch ? 0 : 1;
+}
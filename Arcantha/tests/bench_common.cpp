@@ -0,0 +1,405 @@
+#include <algorithm> // Required for std::sort.
+#include <atomic> // Required for the lock-free allocation counters.
+#include <cerrno> // Required for the posix_memalign error codes.
+#include <cmath> // Required for std::isfinite.
+#include <cstdlib> // Required for std::malloc, std::free and std::strtod.
+#include <cstring> // Required for std::strlen, std::strncmp and std::strchr.
+#include <fstream> // Required for reading baseline reports.
+#include <iterator> // Required for std::istreambuf_iterator.
+#include <new> // Required for std::bad_alloc and the replaceable operator new.
+#include <numeric> // Required for std::accumulate.
+
+#include "bench_common.h"
+
+static std::atomic<uint64_t> allocationCount{ 0 };
+static std::atomic<uint64_t> allocationBytes{ 0 };
+
+static void countAllocation( size_t size ) {
+	allocationCount.fetch_add( 1, std::memory_order_relaxed );
+	allocationBytes.fetch_add( size, std::memory_order_relaxed );
+}
+
+#if defined( __GLIBC__ )
+// Interpose malloc itself so C allocations inside the vendored libraries are counted too.
+// operator new forwards to malloc on glibc, so it must not be counted a second time.
+// Over-aligned operator new reaches aligned_alloc or posix_memalign, so those are counted as well.
+extern "C" void* __libc_malloc( size_t size );
+extern "C" void* __libc_calloc( size_t count, size_t size );
+extern "C" void* __libc_realloc( void* p, size_t size );
+extern "C" void* __libc_memalign( size_t alignment, size_t size );
+
+extern "C" void* malloc( size_t size ) {
+	countAllocation( size );
+	return __libc_malloc( size );
+}
+
+extern "C" void* calloc( size_t count, size_t size ) {
+	countAllocation( count * size );
+	return __libc_calloc( count, size );
+}
+
+extern "C" void* realloc( void* p, size_t size ) {
+	countAllocation( size );
+	return __libc_realloc( p, size );
+}
+
+extern "C" void* aligned_alloc( size_t alignment, size_t size ) {
+	countAllocation( size );
+	return __libc_memalign( alignment, size );
+}
+
+extern "C" int posix_memalign( void** p, size_t alignment, size_t size ) {
+	if ( alignment < sizeof( void* ) || ( alignment & ( alignment - 1 ) ) ) return EINVAL;
+	countAllocation( size );
+	*p = __libc_memalign( alignment, size );
+	return *p ? 0 : ENOMEM;
+}
+#else
+void* operator new( size_t size ) {
+	countAllocation( size );
+	void* p = std::malloc( size ? size : 1 );
+	if ( !p ) throw std::bad_alloc();
+	return p;
+}
+void* operator new[]( size_t size ) {
+	return operator new( size );
+}
+void operator delete( void* p ) noexcept {
+	std::free( p );
+}
+void operator delete[]( void* p ) noexcept {
+	std::free( p );
+}
+void operator delete( void* p, size_t ) noexcept {
+	std::free( p );
+}
+void operator delete[]( void* p, size_t ) noexcept {
+	std::free( p );
+}
+#endif
+
+AllocationStats getAllocationStats() {
+	AllocationStats stats;
+	stats.count = allocationCount.load( std::memory_order_relaxed );
+	stats.bytes = allocationBytes.load( std::memory_order_relaxed );
+	return stats;
+}
+
+Percentiles computePercentiles( std::vector<double> samples ) {
+	Percentiles p;
+	if ( samples.empty() ) return p;
+
+	std::sort( samples.begin(), samples.end() );
+
+	// Nearest-rank percentile: the smallest sample with at least q of the samples at or below it.
+	auto rank = [ & ]( double q ) {
+		size_t index = static_cast< size_t >( q * samples.size() + 0.999999 );
+		return samples[ std::min( samples.size(), std::max< size_t >( index, 1 ) ) - 1 ];
+	};
+
+	p.min = samples.front();
+	p.max = samples.back();
+	p.mean = std::accumulate( samples.begin(), samples.end(), 0.0 ) / samples.size();
+	p.p50 = rank( 0.50 );
+	p.p95 = rank( 0.95 );
+	p.p99 = rank( 0.99 );
+	return p;
+}
+
+static void writeEscaped( std::ostream& out, const char* s ) {
+	out << '"';
+	for ( ; *s; s++ ) {
+		if ( *s == '"' || *s == '\\' ) out << '\\';
+		out << *s;
+	}
+	out << '"';
+}
+
+void JsonWriter::prefix( const char* key ) {
+	if ( !first.back() ) out << ',';
+	first.back() = false;
+
+	if ( first.size() > 1 ) out << '\n' << std::string( ( first.size() - 1 ) * 2, ' ' );
+	if ( key ) {
+		writeEscaped( out, key );
+		out << ": ";
+	}
+}
+
+void JsonWriter::beginObject( const char* key ) {
+	prefix( key );
+	out << '{';
+	first.push_back( true );
+}
+
+void JsonWriter::endObject() {
+	first.pop_back();
+	out << '\n' << std::string( ( first.size() - 1 ) * 2, ' ' ) << '}';
+	if ( first.size() == 1 ) out << '\n';
+}
+
+void JsonWriter::beginArray( const char* key ) {
+	prefix( key );
+	out << '[';
+	first.push_back( true );
+}
+
+void JsonWriter::endArray() {
+	first.pop_back();
+	out << '\n' << std::string( ( first.size() - 1 ) * 2, ' ' ) << ']';
+}
+
+void JsonWriter::value( const char* key, double v ) {
+	prefix( key );
+	// JSON has no NaN or infinity; null keeps the report parseable and readBaseline skips it.
+	if ( std::isfinite( v ) ) out << v;
+	else out << "null";
+}
+
+void JsonWriter::value( const char* key, uint64_t v ) {
+	prefix( key );
+	out << v;
+}
+
+void JsonWriter::value( const char* key, const std::string& v ) {
+	prefix( key );
+	writeEscaped( out, v.c_str() );
+}
+
+void JsonWriter::value( const char* key, bool v ) {
+	prefix( key );
+	out << ( v ? "true" : "false" );
+}
+
+void JsonWriter::value( const char* key, const Percentiles& p ) {
+	beginObject( key );
+	value( "min", p.min );
+	value( "mean", p.mean );
+	value( "p50", p.p50 );
+	value( "p95", p.p95 );
+	value( "p99", p.p99 );
+	value( "max", p.max );
+	endObject();
+}
+
+std::vector<BenchComparison> BenchRunner::compare( const std::map<std::string, double>& baseline, double threshold ) const {
+	std::vector<BenchComparison> comparisons;
+	for ( const BenchResult& result : results ) {
+		const auto found = baseline.find( result.name );
+		if ( found == baseline.end() || found->second <= 0.0 ) continue;
+		BenchComparison comparison;
+		comparison.name = result.name;
+		comparison.baselineNs = found->second;
+		comparison.currentNs = result.nsPerOp.min;
+		comparison.change = comparison.currentNs / comparison.baselineNs - 1.0;
+		comparison.regressed = comparison.change > threshold;
+		comparisons.push_back( comparison );
+	}
+	return comparisons;
+}
+
+void BenchRunner::write( JsonWriter& json ) const {
+	json.beginArray( "results" );
+	for ( const BenchResult& result : results ) {
+		json.beginObject();
+		json.value( "name", result.name );
+		json.value( "operations", result.operations );
+		json.value( "ns_per_op", result.nsPerOp );
+		json.value( "allocations_per_op", result.allocationsPerOp );
+		json.value( "bytes_per_op", result.bytesPerOp );
+		json.endObject();
+	}
+	json.endArray();
+}
+
+void BenchRunner::record( const std::string& name, uint64_t operations, const std::vector<double>& nsPerOp, const AllocationStats& before ) {
+	const AllocationStats after = getAllocationStats();
+	const double total = static_cast< double >( operations ) * nsPerOp.size();
+	BenchResult result;
+	result.name = name;
+	result.operations = operations;
+	result.nsPerOp = computePercentiles( nsPerOp );
+	result.allocationsPerOp = total > 0.0 ? ( after.count - before.count ) / total : 0.0;
+	result.bytesPerOp = total > 0.0 ? ( after.bytes - before.bytes ) / total : 0.0;
+	results.push_back( result );
+}
+
+/**
+ * @brief A parsed JSON value; enough of JSON to read reports back, whatever their layout.
+ */
+struct JsonValue
+{
+	enum class Type
+	{
+		Null,
+		Bool,
+		Number,
+		String,
+		Array,
+		Object
+	};
+
+	Type type = Type::Null;
+	double number = 0.0; // Numbers, and 1 or 0 for booleans.
+	std::string text; // Strings.
+	std::vector<JsonValue> items; // Arrays.
+	std::vector<std::pair<std::string, JsonValue>> members; // Objects, in file order.
+
+	/**
+	 * @brief Finds an object member.
+	 * @param key The member name.
+	 * @return The member, or nullptr if this is not an object or has no such member.
+	 */
+	const JsonValue* find( const char* key ) const {
+		for ( const auto& member : members ) {
+			if ( member.first == key ) return &member.second;
+		}
+		return nullptr;
+	}
+};
+
+/**
+ * @brief A recursive descent JSON parser; whitespace and member order do not matter.
+ */
+class JsonParser
+{
+public:
+	/**
+	 * @brief Constructor for the JsonParser class.
+	 * @param text The document.
+	 */
+	explicit JsonParser( const std::string& text ) : at( text.data() ), end( text.data() + text.size() ) {}
+
+	/**
+	 * @brief Parses the whole document.
+	 * @param value Receives the root value.
+	 * @return False if the document is not valid JSON.
+	 */
+	bool parse( JsonValue& value ) {
+		if ( !parseValue( value, 0 ) ) return false;
+		skipSpace();
+		return at == end;
+	}
+
+private:
+	static const int MAX_DEPTH = 64; // Deeper documents are rejected rather than overflowing the stack.
+
+	const char* at; // Next character to read.
+	const char* end; // One past the last character.
+
+	void skipSpace() {
+		while ( at < end && ( *at == ' ' || *at == '\t' || *at == '\n' || *at == '\r' ) ) at++;
+	}
+	bool consume( char c ) {
+		skipSpace();
+		if ( at == end || *at != c ) return false;
+		at++;
+		return true;
+	}
+	bool consumeWord( const char* word ) {
+		const size_t length = std::strlen( word );
+		if ( static_cast< size_t >( end - at ) < length || std::strncmp( at, word, length ) ) return false;
+		at += length;
+		return true;
+	}
+	bool parseString( std::string& out ) {
+		if ( !consume( '"' ) ) return false;
+		while ( at < end && *at != '"' ) {
+			if ( *at != '\\' ) {
+				out += *at++;
+				continue;
+			}
+			if ( ++at == end ) return false;
+			switch ( *at++ ) {
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'n': out += '\n'; break;
+			case 'r': out += '\r'; break;
+			case 't': out += '\t'; break;
+			case 'u': {
+				// Benchmark names are ASCII; other code points only need to be skipped correctly.
+				if ( end - at < 4 ) return false;
+				const unsigned long code = std::strtoul( std::string( at, 4 ).c_str(), nullptr, 16 );
+				out += code < 0x80 ? static_cast< char >( code ) : '?';
+				at += 4;
+				break;
+			}
+			default: out += at[ -1 ]; break; // '"', '\\' and '/'.
+			}
+		}
+		return consume( '"' );
+	}
+	bool parseValue( JsonValue& value, int depth ) {
+		skipSpace();
+		if ( at == end || depth > MAX_DEPTH ) return false;
+		if ( *at == '{' ) {
+			at++;
+			value.type = JsonValue::Type::Object;
+			if ( consume( '}' ) ) return true;
+			do {
+				std::pair<std::string, JsonValue> member;
+				if ( !parseString( member.first ) || !consume( ':' ) || !parseValue( member.second, depth + 1 ) ) return false;
+				value.members.push_back( std::move( member ) );
+			} while ( consume( ',' ) );
+			return consume( '}' );
+		}
+		if ( *at == '[' ) {
+			at++;
+			value.type = JsonValue::Type::Array;
+			if ( consume( ']' ) ) return true;
+			do {
+				value.items.emplace_back();
+				if ( !parseValue( value.items.back(), depth + 1 ) ) return false;
+			} while ( consume( ',' ) );
+			return consume( ']' );
+		}
+		if ( *at == '"' ) {
+			value.type = JsonValue::Type::String;
+			return parseString( value.text );
+		}
+		if ( consumeWord( "true" ) ) {
+			value.type = JsonValue::Type::Bool;
+			value.number = 1.0;
+			return true;
+		}
+		if ( consumeWord( "false" ) ) {
+			value.type = JsonValue::Type::Bool;
+			return true;
+		}
+		if ( consumeWord( "null" ) ) return true;
+		// strtod needs a terminator, and a number is never longer than a few dozen characters.
+		char number[ 64 ];
+		size_t length = 0;
+		while ( at + length < end && length + 1 < sizeof( number ) && at[ length ] && std::strchr( "+-.0123456789eE", at[ length ] ) ) {
+			number[ length ] = at[ length ];
+			length++;
+		}
+		number[ length ] = '\0';
+		char* parsed = nullptr;
+		value.type = JsonValue::Type::Number;
+		value.number = std::strtod( number, &parsed );
+		if ( length == 0 || parsed != number + length ) return false;
+		at += length;
+		return true;
+	}
+};
+
+bool readBaseline( const std::string& path, std::map<std::string, double>& minimums ) {
+	std::ifstream in( path, std::ios::binary );
+	if ( !in ) return false;
+	const std::string text( ( std::istreambuf_iterator<char>( in ) ), std::istreambuf_iterator<char>() );
+
+	JsonValue root;
+	if ( !JsonParser( text ).parse( root ) ) return false;
+	const JsonValue* results = root.find( "results" );
+	if ( !results ) return false;
+	for ( const JsonValue& result : results->items ) {
+		const JsonValue* name = result.find( "name" );
+		const JsonValue* nsPerOp = result.find( "ns_per_op" );
+		const JsonValue* minimum = nsPerOp ? nsPerOp->find( "min" ) : nullptr;
+		if ( name && name->type == JsonValue::Type::String && minimum && minimum->type == JsonValue::Type::Number ) {
+			minimums[ name->text ] = minimum->number;
+		}
+	}
+	return !minimums.empty();
+}
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <chrono> // Required for std::chrono::steady_clock timing.
+#include <cstdint> // Required for fixed-width integer types.
+#include <map> // Required for std::map baseline medians.
+#include <ostream> // Required for std::ostream used by JsonWriter.
+#include <string> // Required for std::string keys and values.
+#include <vector> // Required for std::vector sample storage.
+
+/**
+ * @brief Monotonic stopwatch used by every benchmark executable.
+ */
+class BenchTimer
+{
+public:
+	BenchTimer() : begin( std::chrono::steady_clock::now() ) {}
+
+	/**
+	 * @brief Restarts the stopwatch.
+	 */
+	void reset() { begin = std::chrono::steady_clock::now(); }
+	/**
+	 * @brief Gets the time since construction or the last reset.
+	 * @return The elapsed time in milliseconds.
+	 */
+	double elapsedMs() const {
+		return std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - begin ).count();
+	}
+
+private:
+	std::chrono::steady_clock::time_point begin; // Start of the measured interval.
+};
+
+/**
+ * @brief Summary statistics of a set of samples.
+ */
+struct Percentiles
+{
+	double min = 0.0, mean = 0.0, p50 = 0.0, p95 = 0.0, p99 = 0.0, max = 0.0;
+};
+
+/**
+ * @brief Computes nearest-rank percentiles of a set of samples.
+ * @param samples The samples (taken by value and sorted).
+ * @return The summary statistics, all zero for an empty set.
+ */
+Percentiles computePercentiles( std::vector<double> samples );
+
+/**
+ * @brief Process-wide heap allocation counters.
+ *
+ * On glibc every malloc, calloc, realloc and aligned allocation is counted,
+ * which includes Box2D's b2Alloc and OpenAL Soft's allocations. Elsewhere only C++ operator new is counted.
+ */
+struct AllocationStats
+{
+	uint64_t count = 0; // Number of allocations.
+	uint64_t bytes = 0; // Total bytes requested.
+};
+
+/**
+ * @brief Reads the allocation counters.
+ * @return The allocations made since process start.
+ */
+AllocationStats getAllocationStats();
+
+/**
+ * @brief Minimal streaming JSON writer for benchmark reports.
+ *
+ * Handles separators and nesting; keys and strings are escaped for quotes
+ * and backslashes only, which is all benchmark names need.
+ */
+class JsonWriter
+{
+public:
+	/**
+	 * @brief Constructor for the JsonWriter class.
+	 * @param out The stream to write to.
+	 */
+	explicit JsonWriter( std::ostream& out ) : out( out ) {}
+
+	void beginObject( const char* key = nullptr ); // Opens an object, keyed if inside an object.
+	void endObject(); // Closes the current object.
+	void beginArray( const char* key = nullptr ); // Opens an array, keyed if inside an object.
+	void endArray(); // Closes the current array.
+
+	void value( const char* key, double v ); // Writes a number, or null if it is NaN or infinite.
+	void value( const char* key, uint64_t v ); // Writes an integer.
+	void value( const char* key, const std::string& v ); // Writes a string.
+	void value( const char* key, bool v ); // Writes a boolean.
+	/**
+	 * @brief Writes a Percentiles object.
+	 * @param key The key of the object.
+	 * @param p The statistics to write.
+	 */
+	void value( const char* key, const Percentiles& p );
+
+private:
+	std::ostream& out; // Destination stream.
+	std::vector<bool> first = { true }; // Whether the next element at each depth is the first one.
+
+	/**
+	 * @brief Writes the separator, indentation and optional key for the next element.
+	 * @param key The key, or nullptr inside arrays.
+	 */
+	void prefix( const char* key );
+};
+
+/**
+ * @brief Keeps a value alive so the optimizer cannot remove the work that produced it.
+ * @param value The result of the measured work.
+ */
+template <typename T>
+inline void keepAlive( const T& value ) {
+#if defined( __GNUC__ ) || defined( __clang__ )
+	__asm__ __volatile__( "" : : "r,m"( value ) : "memory" );
+#else
+	static const void* volatile sink;
+	sink = &value;
+#endif
+}
+
+/**
+ * @brief How BenchRunner repeats each benchmark.
+ */
+struct BenchSettings
+{
+	int warmup = 2; // Untimed repetitions before the timed ones.
+	int repetitions = 20; // Timed repetitions; each one is a sample.
+	double minRepetitionMs = 5.0; // Batched benchmarks double their calls per repetition until one takes this long.
+	std::string filter; // Only benchmarks whose name contains this run; empty runs all.
+};
+
+/**
+ * @brief The measurements of one benchmark.
+ */
+struct BenchResult
+{
+	std::string name; // Group and case, e.g. "input/is_key_pressed".
+	uint64_t operations = 0; // Operations timed per repetition.
+	Percentiles nsPerOp; // Nanoseconds per operation across repetitions.
+	double allocationsPerOp = 0.0; // Heap allocations per operation.
+	double bytesPerOp = 0.0; // Heap bytes requested per operation.
+};
+
+/**
+ * @brief A benchmark's fastest repetition against the baseline's.
+ *
+ * Medians of short repetitions move by tens of percent between runs on a
+ * busy machine, while noise only ever makes a repetition slower, so the
+ * fastest repetitions of the two runs are compared.
+ */
+struct BenchComparison
+{
+	std::string name; // The benchmark.
+	double baselineNs = 0.0; // Baseline fastest repetition, in nanoseconds per operation.
+	double currentNs = 0.0; // Current fastest repetition, in nanoseconds per operation.
+	double change = 0.0; // Relative change, 0.1 being 10% slower.
+	bool regressed = false; // Whether the change exceeds the threshold.
+};
+
+/**
+ * @brief Runs benchmarks with warmup and repetitions and collects their results.
+ *
+ * Micro benchmarks go through run(): each call of the function performs a
+ * fixed number of operations and calls are batched until a repetition is
+ * long enough to time reliably. Whole frames go through runEach(), where
+ * every call is its own sample so hitches show in the percentiles.
+ * Allocations are counted over the timed repetitions only.
+ */
+class BenchRunner
+{
+public:
+	/**
+	 * @brief Constructor for the BenchRunner class.
+	 * @param settings The repetition settings.
+	 */
+	explicit BenchRunner( const BenchSettings& settings ) : settings( settings ) {}
+
+	/**
+	 * @brief Runs a batched benchmark, unless the filter excludes it.
+	 * @param name The benchmark name.
+	 * @param operationsPerCall The number of operations one call performs.
+	 * @param func The work, called with no arguments.
+	 */
+	template <typename Func>
+	void run( const std::string& name, uint64_t operationsPerCall, const Func& func );
+	/**
+	 * @brief Runs a benchmark that times every call on its own, unless the filter excludes it.
+	 * @param name The benchmark name.
+	 * @param samples The number of timed calls.
+	 * @param func The work of one operation, called with no arguments.
+	 */
+	template <typename Func>
+	void runEach( const std::string& name, int samples, const Func& func );
+
+	/**
+	 * @brief Checks a name against the filter.
+	 * @param name The benchmark name.
+	 * @return True if the benchmark should run.
+	 */
+	bool selected( const std::string& name ) const {
+		return settings.filter.empty() || name.find( settings.filter ) != std::string::npos;
+	}
+	/**
+	 * @brief Gets the results in the order the benchmarks ran.
+	 * @return The results.
+	 */
+	const std::vector<BenchResult>& getResults() const { return results; }
+	/**
+	 * @brief Compares the results' fastest repetitions against the baseline's.
+	 * @param baseline Fastest repetition in nanoseconds per operation by benchmark name.
+	 * @param threshold The relative slowdown counted as a regression.
+	 * @return One comparison per result that the baseline also has.
+	 */
+	std::vector<BenchComparison> compare( const std::map<std::string, double>& baseline, double threshold ) const;
+	/**
+	 * @brief Writes the results as a "results" array.
+	 * @param json The writer, inside an object.
+	 */
+	void write( JsonWriter& json ) const;
+
+private:
+	BenchSettings settings; // Repetition settings.
+	std::vector<BenchResult> results; // Results so far.
+
+	/**
+	 * @brief Stores the result of a finished benchmark.
+	 * @param name The benchmark name.
+	 * @param operations Operations timed per repetition.
+	 * @param nsPerOp Nanoseconds per operation of every repetition.
+	 * @param before The allocation counters before the timed repetitions.
+	 */
+	void record( const std::string& name, uint64_t operations, const std::vector<double>& nsPerOp, const AllocationStats& before );
+};
+
+template <typename Func>
+void BenchRunner::run( const std::string& name, uint64_t operationsPerCall, const Func& func ) {
+	if ( !selected( name ) ) return;
+
+	// Calibration doubles as the first warmup.
+	uint64_t calls = 1;
+	for ( ;; ) {
+		BenchTimer timer;
+		for ( uint64_t i = 0; i < calls; i++ ) func();
+		if ( timer.elapsedMs() >= settings.minRepetitionMs || calls >= ( 1ull << 30 ) ) break;
+		calls *= 2;
+	}
+	for ( int warmup = 1; warmup < settings.warmup; warmup++ ) {
+		for ( uint64_t i = 0; i < calls; i++ ) func();
+	}
+
+	const uint64_t operations = calls * operationsPerCall;
+	std::vector<double> nsPerOp;
+	nsPerOp.reserve( settings.repetitions );
+	const AllocationStats before = getAllocationStats();
+	for ( int repetition = 0; repetition < settings.repetitions; repetition++ ) {
+		BenchTimer timer;
+		for ( uint64_t i = 0; i < calls; i++ ) func();
+		nsPerOp.push_back( timer.elapsedMs() * 1e6 / static_cast< double >( operations ) );
+	}
+	record( name, operations, nsPerOp, before );
+}
+
+template <typename Func>
+void BenchRunner::runEach( const std::string& name, int samples, const Func& func ) {
+	if ( !selected( name ) ) return;
+
+	for ( int warmup = 0; warmup < settings.warmup; warmup++ ) func();
+	std::vector<double> nsPerOp;
+	nsPerOp.reserve( samples );
+	const AllocationStats before = getAllocationStats();
+	for ( int sample = 0; sample < samples; sample++ ) {
+		BenchTimer timer;
+		func();
+		nsPerOp.push_back( timer.elapsedMs() * 1e6 );
+	}
+	record( name, 1, nsPerOp, before );
+}
+
+/**
+ * @brief Reads the fastest repetition of every result in a report written by BenchRunner::write.
+ *
+ * The report is parsed as JSON, so a baseline that was reformatted, compacted
+ * or had its members reordered still reads: every object in the top-level
+ * "results" array with a "name" and a "ns_per_op" object holding "min"
+ * contributes one time.
+ * @param path The report file.
+ * @param minimums Receives the fastest repetition in nanoseconds per operation by benchmark name.
+ * @return False if the file cannot be read, is not valid JSON or holds no results.
+ */
+bool readBaseline( const std::string& path, std::map<std::string, double>& minimums );
@@ -0,0 +1,154 @@
+// Debug draw benchmark.
+//
+// Fills a 600 x 120 meter room with 10,000 boxes and circles and pans a
+// 48 x 27 meter camera across it while job workers draw gameplay overlays
+// (velocity lines, sensor circles and a few labels for 2,000 agents) into
+// their own buffers. The frame is drawn three ways: through b2World's own
+// DebugDraw() into our b2Draw (every body visited, each primitive culled),
+// through drawWorld() with broadphase culling, and through drawWorld()
+// with culling off. Reports submission plus flush time per frame and the
+// primitives, culled primitives, threads and batches of the last frame.
+// Headless, so the batches are what would be drawn; there must be at most
+// three. Reports JSON.
+//
+// Usage: arcantha_debugdraw_bench [--bodies N] [--frames N] [--threads N] [--font PATH]
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DebugDraw.h"
+#include "JobSystem.h"
+#include "Physics.h"
+#include "Random.h"
+#include "bench_common.h"
+
+static const float ROOM_WIDTH = 600.0f;
+static const float ROOM_HEIGHT = 120.0f;
+static const float VIEW_WIDTH = 48.0f;
+static const float VIEW_HEIGHT = 27.0f;
+static const int AGENTS = 2000;
+
+enum class Mode
+{
+	Box2D, // b2World::DebugDraw() through the b2Draw interface.
+	Culled, // drawWorld() with broadphase culling.
+	Unculled // drawWorld() visiting every body.
+};
+
+struct RunResult
+{
+	std::vector<double> frameMs;
+	DebugDrawStats last;
+};
+
+static RunResult run( PhysicsWorld& physics, const std::vector<b2Vec2>& agents, int frames, Mode mode ) {
+	DebugDraw& debug = DebugDraw::getInstance();
+	debug.setCulling( mode != Mode::Unculled );
+	physics.getWorld().SetDebugDraw( &debug );
+
+	RunResult result;
+	for ( int frame = 0; frame < frames; frame++ ) {
+		const float t = static_cast< float >( frame ) / frames;
+		const b2Vec2 center( VIEW_WIDTH * 0.5f + ( ROOM_WIDTH - VIEW_WIDTH ) * t, ROOM_HEIGHT * 0.5f + 30.0f * std::sin( t * 12.0f ) );
+		const b2Vec2 half( VIEW_WIDTH * 0.5f, VIEW_HEIGHT * 0.5f );
+
+		BenchTimer timer;
+		debug.setCamera( center - half, center + half, 1920.0f / VIEW_WIDTH );
+		if ( mode == Mode::Box2D ) physics.getWorld().DebugDraw();
+		else debug.drawWorld( physics.getWorld() );
+
+		// Gameplay overlays come from the jobs that own the agents.
+		JobSystem::getInstance().parallelFor( agents.size(), 128, [ &agents, frame ]( size_t begin, size_t end ) {
+			DebugDraw& overlay = DebugDraw::getInstance();
+			for ( size_t i = begin; i < end; i++ ) {
+				const b2Vec2& position = agents[ i ];
+				const float angle = 0.05f * frame + static_cast< float >( i );
+				overlay.line( position, position + b2Vec2( std::cos( angle ), std::sin( angle ) ), 0xFF00FFFFu );
+				overlay.circle( position, 3.0f, 0x8000A0FFu );
+				if ( i % 10 == 0 ) overlay.text( "agent " + std::to_string( i ), position + b2Vec2( 0.0f, 1.0f ), 14.0f, 0xFFFFFFFFu );
+			}
+		} );
+
+		debug.flush();
+		result.frameMs.push_back( timer.elapsedMs() );
+	}
+	result.last = debug.getStats();
+	physics.getWorld().SetDebugDraw( nullptr );
+	return result;
+}
+
+static void writeRun( JsonWriter& json, const char* key, const RunResult& result ) {
+	json.beginObject( key );
+	json.value( "frame_ms", computePercentiles( result.frameMs ) );
+	json.value( "lines", static_cast< uint64_t >( result.last.lines ) );
+	json.value( "triangles", static_cast< uint64_t >( result.last.triangles ) );
+	json.value( "labels", static_cast< uint64_t >( result.last.texts ) );
+	json.value( "culled", static_cast< uint64_t >( result.last.culled ) );
+	json.value( "threads", static_cast< uint64_t >( result.last.threads ) );
+	json.value( "batches", static_cast< uint64_t >( result.last.batches ) );
+	json.endObject();
+}
+
+int main( int argc, char** argv ) {
+	int bodies = 10000;
+	int frames = 300;
+	int threads = -1;
+	std::string font = ARCANTHA_BENCH_FONT;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--bodies" ) ) bodies = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--frames" ) ) frames = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--threads" ) ) threads = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--font" ) ) font = argv[ i + 1 ];
+	}
+	if ( bodies <= 0 ) bodies = 1;
+	if ( frames <= 0 ) frames = 1;
+
+	JobSystem& jobs = JobSystem::getInstance();
+	jobs.init( threads );
+	if ( !DebugDraw::getInstance().loadFont( font ) ) return 1;
+
+	PhysicsWorld physics;
+	Random random( 3 );
+	BodyParams ground;
+	ground.type = b2_staticBody;
+	ground.position = b2Vec2( ROOM_WIDTH * 0.5f, -1.0f );
+	physics.createBox( ground, ROOM_WIDTH * 0.5f, 1.0f );
+	for ( int i = 0; i < bodies; i++ ) {
+		BodyParams params;
+		params.position = b2Vec2( random.range( 0.0f, ROOM_WIDTH ), random.range( 0.0f, ROOM_HEIGHT ) );
+		if ( i % 3 == 0 ) physics.createCircle( params, random.range( 0.2f, 0.6f ) );
+		else physics.createBox( params, random.range( 0.2f, 0.7f ), random.range( 0.2f, 0.7f ) );
+	}
+	std::vector<b2Vec2> agents;
+	for ( int i = 0; i < AGENTS; i++ ) agents.push_back( b2Vec2( random.range( 0.0f, ROOM_WIDTH ), random.range( 0.0f, ROOM_HEIGHT ) ) );
+
+	const RunResult box2d = run( physics, agents, frames, Mode::Box2D );
+	const RunResult culled = run( physics, agents, frames, Mode::Culled );
+	const RunResult unculled = run( physics, agents, frames, Mode::Unculled );
+	const int workers = jobs.getWorkerCount();
+	jobs.shutdown();
+
+	bool batched = true;
+	for ( const RunResult* result : { &box2d, &culled, &unculled } ) batched = batched && result->last.batches <= 3;
+	if ( !batched ) std::cerr << "Err: A frame needed more than three batches." << std::endl;
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_debugdraw_bench" ) );
+	json.value( "bodies", static_cast< uint64_t >( bodies ) );
+	json.value( "agents", static_cast< uint64_t >( AGENTS ) );
+	json.value( "frames", static_cast< uint64_t >( frames ) );
+	json.value( "workers", static_cast< uint64_t >( workers ) );
+	json.value( "compiled_in", static_cast< bool >( ARCANTHA_DEBUG_DRAW ) );
+	writeRun( json, "box2d_debug_draw", box2d );
+	writeRun( json, "draw_world_culled", culled );
+	writeRun( json, "draw_world_unculled", unculled );
+	json.value( "batched", batched );
+	json.endObject();
+
+	return batched ? 0 : 1;
+}
@@ -0,0 +1,480 @@
+// Engine benchmark suite.
+//
+// Micro benchmarks of the engine's hot paths plus a headless whole frame,
+// all through BenchRunner, so every case gets warmup, repetitions,
+// percentiles and allocation counts:
+//   input/      InputManager queries, its per-frame update and the GLFW key
+//               callback, driven through a window on GLFW's null platform
+//   dispatch/   EventDispatcher with 1, 8 and 32 key listeners, listener
+//               registration, and posting and delivering through EventBus
+//   alloc/      operator new against PagedArray growth and copy-on-write
+//               page detaching after a snapshot
+//   math/       Random, glm vector normalization and matrix products
+//   serialize/  PhysicsSnapshot capture and restore of a 600 body room and
+//               SnapshotRegistry capture of component columns
+//   frame/      a headless frame: input, physics, a SpatialGrid rebuild with
+//               attack queries, hit events, particles and the event phases
+// Saving is left to arcantha_save_bench, as disk writes are too noisy to
+// compare between runs. Every dispatch case must reach each listener once
+// per event and the frame must deliver every hit it posts.
+//
+// Reports JSON. With --baseline, the results are compared against a report
+// from an earlier run, fastest repetition against fastest repetition: medians
+// wander by 10-50% between identical runs, while noise only makes a
+// repetition slower. A benchmark slower by more than --threshold (default
+// 0.1, i.e. 10%) is flagged and fails the run. That default suits a quiet,
+// dedicated machine; on a shared one, raise --threshold to its run-to-run
+// spread, measured by comparing two runs of the same tree.
+//
+// Usage: arcantha_bench [--repetitions N] [--warmup N] [--min-ms N] [--filter S]
+//                       [--frames N] [--threads N] [--baseline FILE] [--threshold X]
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "EventBus.h"
+#include "Input.h"
+#include "JobSystem.h"
+#include "ParticleSystem.h"
+#include "Physics.h"
+#include "Random.h"
+#include "Snapshot.h"
+#include "SpatialGrid.h"
+#include "TileMap.h"
+#include "bench_common.h"
+
+static const int BATCH = 1024;
+static const int ROOM_WIDTH = 128;
+static const int ROOM_HEIGHT = 64;
+static const int FRAME_BODIES = 600;
+static const int FRAME_ATTACKS = 64;
+static const float DT = 1.0f / 60.0f;
+
+static const int GAME_KEYS[] = { GLFW_KEY_W, GLFW_KEY_A, GLFW_KEY_S, GLFW_KEY_D, GLFW_KEY_SPACE, GLFW_KEY_LEFT_SHIFT,
+	GLFW_KEY_E, GLFW_KEY_Q, GLFW_KEY_R, GLFW_KEY_F, GLFW_KEY_TAB, GLFW_KEY_ESCAPE, GLFW_KEY_1, GLFW_KEY_2, GLFW_KEY_3, GLFW_KEY_4 };
+static const int GAME_KEY_COUNT = sizeof( GAME_KEYS ) / sizeof( GAME_KEYS[ 0 ] );
+
+/**
+ * @brief A hit found by the frame's attack queries.
+ */
+struct HitEvent
+{
+	uint32_t attacker;
+	uint32_t target;
+};
+
+/**
+ * @brief An event posted by the dispatch benchmark.
+ */
+struct TickEvent
+{
+	uint32_t value;
+};
+
+static TileMap buildRoom() {
+	TileMap map( ROOM_WIDTH, ROOM_HEIGHT, 1.0f );
+	map.fill( 0, 0, ROOM_WIDTH, 2, Tile::Solid );
+	map.fill( 0, 0, 2, ROOM_HEIGHT, Tile::Solid );
+	map.fill( ROOM_WIDTH - 2, 0, 2, ROOM_HEIGHT, Tile::Solid );
+	for ( int i = 0; i < 8; i++ ) map.fill( 10 + i * 14, 10 + ( i % 3 ) * 12, 8, 1, Tile::Solid );
+	return map;
+}
+
+static void populate( PhysicsWorld& world, const TileMap& map ) {
+	world.createStaticTiles( map );
+	for ( int i = 0; i < FRAME_BODIES; i++ ) {
+		BodyParams params;
+		params.position = b2Vec2( 4.0f + ( i % 50 ) * 2.4f, 4.0f + ( i / 50 ) * 4.5f );
+		params.fixedRotation = true;
+		if ( i % 6 == 0 ) {
+			params.category = CATEGORY_PICKUP;
+			world.createBox( params, 0.45f, 0.45f );
+		}
+		else world.createCircle( params, 0.4f );
+	}
+}
+
+static void runInput( BenchRunner& runner, GLFWwindow* window, bool& ok ) {
+	InputManager& input = InputManager::getInstance();
+	input.init( window );
+	// The callbacks are private; GLFW hands them back when they are replaced.
+	const GLFWkeyfun keyCallback = glfwSetKeyCallback( window, nullptr );
+	glfwSetKeyCallback( window, keyCallback );
+	const GLFWcursorposfun cursorCallback = glfwSetCursorPosCallback( window, nullptr );
+	glfwSetCursorPosCallback( window, cursorCallback );
+	if ( !keyCallback || !cursorCallback ) {
+		std::cerr << "Err: InputManager did not install its GLFW callbacks." << std::endl;
+		ok = false;
+		return;
+	}
+	for ( int i = 0; i < GAME_KEY_COUNT; i += 3 ) keyCallback( window, GAME_KEYS[ i ], 0, GLFW_PRESS, 0 );
+	input.update();
+	for ( int i = 1; i < GAME_KEY_COUNT; i += 3 ) keyCallback( window, GAME_KEYS[ i ], 0, GLFW_PRESS, 0 );
+	cursorCallback( window, 400.0, 300.0 );
+
+	runner.run( "input/is_key_pressed", BATCH, [ & ]() {
+		int pressed = 0;
+		for ( int i = 0; i < BATCH; i++ ) pressed += input.isKeyPressed( GAME_KEYS[ i % GAME_KEY_COUNT ] );
+		keepAlive( pressed );
+	} );
+	runner.run( "input/is_key_just_pressed", BATCH, [ & ]() {
+		int pressed = 0;
+		for ( int i = 0; i < BATCH; i++ ) pressed += input.isKeyJustPressed( GAME_KEYS[ i % GAME_KEY_COUNT ] );
+		keepAlive( pressed );
+	} );
+	runner.run( "input/is_mouse_button_pressed", BATCH, [ & ]() {
+		int pressed = 0;
+		for ( int i = 0; i < BATCH; i++ ) pressed += input.isMouseButtonPressed( i & 7 );
+		keepAlive( pressed );
+	} );
+	runner.run( "input/mouse_delta", BATCH, [ & ]() {
+		glm::vec2 sum( 0.0f );
+		for ( int i = 0; i < BATCH; i++ ) sum += input.getMouseDelta();
+		keepAlive( sum );
+	} );
+	runner.run( "input/update", 1, [ & ]() {
+		input.update();
+	} );
+	// A press and a release per key, through the callback GLFW would call, to four listeners.
+	EventDispatcher& dispatcher = input.getEventDispatcher();
+	std::vector<ListenerID> listeners;
+	uint64_t heard = 0;
+	for ( int i = 0; i < 4; i++ ) listeners.push_back( dispatcher.addKeyListener( [ &heard ]( KeyEvent& event ) { heard += event.key; } ) );
+	runner.run( "input/key_callback", 2 * GAME_KEY_COUNT, [ & ]() {
+		for ( int key : GAME_KEYS ) {
+			keyCallback( window, key, 0, GLFW_PRESS, 0 );
+			keyCallback( window, key, 0, GLFW_RELEASE, 0 );
+		}
+	} );
+	for ( ListenerID id : listeners ) dispatcher.removeKeyListener( id );
+	keepAlive( heard );
+}
+
+static void runDispatch( BenchRunner& runner, bool& ok ) {
+	for ( int listenerCount : { 1, 8, 32 } ) {
+		const std::string name = "dispatch/key_" + std::to_string( listenerCount ) + "_listeners";
+		if ( !runner.selected( name ) ) continue;
+		EventDispatcher dispatcher;
+		uint64_t calls = 0, dispatched = 0;
+		for ( int i = 0; i < listenerCount; i++ ) dispatcher.addKeyListener( [ &calls ]( KeyEvent& ) { calls++; } );
+		runner.run( name, BATCH, [ & ]() {
+			for ( int i = 0; i < BATCH; i++ ) {
+				KeyEvent event{ {}, GAME_KEYS[ i % GAME_KEY_COUNT ], 0, GLFW_PRESS, 0 };
+				dispatcher.dispatch( event );
+			}
+			dispatched += BATCH;
+		} );
+		if ( calls != dispatched * listenerCount ) {
+			std::cerr << "Err: " << name << " reached " << calls << " listeners for " << dispatched << " events." << std::endl;
+			ok = false;
+		}
+	}
+	runner.run( "dispatch/add_remove_listener", 1, []() {
+		static EventDispatcher dispatcher;
+		dispatcher.removeKeyListener( dispatcher.addKeyListener( []( KeyEvent& ) {} ) );
+	} );
+
+	if ( !runner.selected( "dispatch/eventbus_post_deliver" ) ) return;
+	EventBus& bus = EventBus::getInstance();
+	bus.registerType<TickEvent>( "TickEvent" );
+	uint64_t delivered = 0, posted = 0;
+	const SubscriberID id = bus.subscribe<TickEvent>( EventPhase::Simulation, [ &delivered ]( const EventBatch<TickEvent>& batch ) {
+		delivered += batch.size();
+	} );
+	runner.run( "dispatch/eventbus_post_deliver", BATCH, [ & ]() {
+		for ( int i = 0; i < BATCH; i++ ) bus.post( TickEvent{ static_cast< uint32_t >( i ) } );
+		bus.deliver( EventPhase::Simulation );
+		bus.endFrame();
+		posted += BATCH;
+	} );
+	bus.unsubscribe( id );
+	if ( delivered != posted ) {
+		std::cerr << "Err: EventBus delivered " << delivered << " of " << posted << " events." << std::endl;
+		ok = false;
+	}
+}
+
+static void runAlloc( BenchRunner& runner ) {
+	runner.run( "alloc/new_delete_64", BATCH, []() {
+		for ( int i = 0; i < BATCH; i++ ) {
+			char* block = new char[ 64 ];
+			keepAlive( block );
+			delete[] block;
+		}
+	} );
+	runner.run( "alloc/paged_array_push_back", BATCH, []() {
+		PagedArray<BodyState> states;
+		for ( int i = 0; i < BATCH; i++ ) states.push_back( BodyState() );
+		keepAlive( states.size() );
+	} );
+
+	// One write per page after a snapshot shares them, so every write copies a page.
+	PagedArray<float> column;
+	column.resize( 64 * PagedBuffer::PAGE_BYTES / sizeof( float ) );
+	const size_t perPage = column.getBuffer().getElementsPerPage();
+	const size_t pages = column.getBuffer().getPageCount();
+	runner.run( "alloc/paged_copy_on_write", pages, [ & ]() {
+		PagedBuffer snapshot = column.getBuffer();
+		for ( size_t page = 0; page < pages; page++ ) column.write( page * perPage ) += 1.0f;
+		keepAlive( snapshot.getSharedPageCount() );
+	} );
+}
+
+static void runMath( BenchRunner& runner ) {
+	Random random( 7 );
+	runner.run( "math/random_range", BATCH, [ & ]() {
+		float sum = 0.0f;
+		for ( int i = 0; i < BATCH; i++ ) sum += random.range( -1.0f, 1.0f );
+		keepAlive( sum );
+	} );
+
+	std::vector<glm::vec2> vectors( BATCH );
+	for ( glm::vec2& v : vectors ) v = glm::vec2( random.range( -10.0f, 10.0f ), random.range( -10.0f, 10.0f ) ) + glm::vec2( 0.01f );
+	std::vector<glm::vec2> normals( BATCH );
+	runner.run( "math/vec2_normalize", BATCH, [ & ]() {
+		for ( int i = 0; i < BATCH; i++ ) normals[ i ] = glm::normalize( vectors[ i ] );
+		keepAlive( normals[ BATCH - 1 ] );
+	} );
+
+	std::vector<glm::mat4> models( 256 );
+	for ( size_t i = 0; i < models.size(); i++ ) {
+		models[ i ] = glm::rotate( glm::translate( glm::mat4( 1.0f ), glm::vec3( vectors[ i ], 0.0f ) ), vectors[ i ].x, glm::vec3( 0.0f, 0.0f, 1.0f ) );
+	}
+	const glm::mat4 viewProjection = glm::ortho( 0.0f, 64.0f, 0.0f, 36.0f, -1.0f, 1.0f );
+	std::vector<glm::mat4> transforms( models.size() );
+	runner.run( "math/mat4_multiply", models.size(), [ & ]() {
+		for ( size_t i = 0; i < models.size(); i++ ) transforms[ i ] = viewProjection * models[ i ];
+		keepAlive( transforms.back() );
+	} );
+}
+
+static void runSerialize( BenchRunner& runner, const TileMap& map ) {
+	if ( !runner.selected( "serialize/physics_capture" ) && !runner.selected( "serialize/physics_restore" ) &&
+		!runner.selected( "serialize/registry_capture" ) ) return;
+	PhysicsWorld world;
+	populate( world, map );
+	for ( int i = 0; i < 60; i++ ) world.step( DT );
+
+	PhysicsSnapshot snapshot;
+	runner.run( "serialize/physics_capture", 1, [ & ]() {
+		snapshot.capture( world );
+	} );
+	runner.run( "serialize/physics_restore", 1, [ & ]() {
+		snapshot.restore( world );
+	} );
+
+	SnapshotRegistry registry;
+	std::vector<PagedArray<float>> columns( 8 );
+	for ( PagedArray<float>& column : columns ) {
+		column.resize( 4096 );
+		registry.registerBuffer( &column.getBuffer() );
+	}
+	Random combatRng( 1 ), lootRng( 2 );
+	registry.registerRandom( &combatRng );
+	registry.registerRandom( &lootRng );
+	WorldSnapshot worldSnapshot;
+	runner.run( "serialize/registry_capture", 1, [ & ]() {
+		registry.capture( world, worldSnapshot );
+	} );
+}
+
+/**
+ * @brief Runs the headless frame benchmark.
+ * @return False if a hit was posted but never delivered.
+ */
+static bool runFrame( BenchRunner& runner, const TileMap& map, GLFWwindow* window, int frames ) {
+	if ( !runner.selected( "frame/headless" ) ) return true;
+	PhysicsWorld world;
+	populate( world, map );
+	const std::vector<b2Body*>& bodies = world.getBodies();
+
+	SpatialGrid grid( glm::vec2( 0.0f ), glm::vec2( ROOM_WIDTH, ROOM_HEIGHT ), 2.0f );
+	std::vector<glm::vec2> positions;
+	std::vector<uint32_t> categories;
+	std::vector<RadiusQuery> attacks( FRAME_ATTACKS );
+
+	ParticleSystem particles;
+	particles.setTileMap( &map );
+	for ( int i = 0; i < 8; i++ ) {
+		ParticleEmitterSettings fountain;
+		fountain.capacity = 2048;
+		fountain.rate = 800.0f;
+		fountain.position = glm::vec2( 12.0f + i * 14.0f, 30.0f );
+		fountain.speedMin = 4.0f;
+		fountain.speedMax = 10.0f;
+		fountain.lifeMin = 0.8f;
+		fountain.lifeMax = 1.6f;
+		fountain.gravity = glm::vec2( 0.0f, -9.8f );
+		fountain.collide = true;
+		fountain.seed = 300 + i;
+		particles.addEmitter( fountain );
+	}
+	std::vector<ParticleInstance> staging;
+
+	EventBus& bus = EventBus::getInstance();
+	bus.registerType<HitEvent>( "HitEvent" );
+	uint64_t posted = 0, delivered = 0;
+	const SubscriberID id = bus.subscribe<HitEvent>( EventPhase::PostPhysics, [ &delivered ]( const EventBatch<HitEvent>& batch ) {
+		delivered += batch.size();
+	} );
+	const GLFWkeyfun keyCallback = window ? glfwSetKeyCallback( window, nullptr ) : nullptr;
+	if ( window ) glfwSetKeyCallback( window, keyCallback );
+	InputManager& input = InputManager::getInstance();
+
+	Random random( 21 );
+	int frame = 0;
+	runner.runEach( "frame/headless", frames, [ & ]() {
+		if ( keyCallback ) keyCallback( window, GAME_KEYS[ frame % GAME_KEY_COUNT ], 0, frame % 2 ? GLFW_RELEASE : GLFW_PRESS, 0 );
+		bus.deliver( EventPhase::Input );
+
+		world.step( DT );
+		positions.resize( bodies.size() );
+		categories.resize( bodies.size() );
+		for ( size_t i = 0; i < bodies.size(); i++ ) {
+			const b2Vec2& position = bodies[ i ]->GetPosition();
+			positions[ i ] = glm::vec2( position.x, position.y );
+			categories[ i ] = bodies[ i ]->GetFixtureList() ? bodies[ i ]->GetFixtureList()->GetFilterData().categoryBits : 0;
+		}
+		grid.rebuild( positions.data(), categories.data(), positions.size() );
+
+		// Every attack hits whatever enemy is in reach of a random body.
+		for ( RadiusQuery& attack : attacks ) {
+			attack.center = positions[ 1 + random.range( 0, FRAME_BODIES - 1 ) ];
+			attack.radius = 2.5f;
+			attack.mask = CATEGORY_ENEMY;
+		}
+		grid.queryRadius( attacks.data(), attacks.size() );
+		const std::vector<SpatialResult>& results = grid.getResults();
+		const std::vector<uint32_t>& ids = grid.getIds();
+		for ( size_t attack = 0; attack < results.size(); attack++ ) {
+			for ( uint32_t i = 0; i < results[ attack ].count; i++ ) {
+				bus.post( HitEvent{ static_cast< uint32_t >( attack ), ids[ results[ attack ].first + i ] } );
+				posted++;
+			}
+		}
+		bus.deliver( EventPhase::Simulation );
+		bus.deliver( EventPhase::PostPhysics );
+
+		particles.update( DT );
+		staging.resize( particles.getAliveCount() );
+		particles.writeInstances( staging.data() );
+		bus.deliver( EventPhase::Presentation );
+
+		input.update();
+		bus.endFrame();
+		frame++;
+	} );
+	bus.unsubscribe( id );
+
+	if ( delivered != posted ) {
+		std::cerr << "Err: The frame delivered " << delivered << " of " << posted << " hits." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int main( int argc, char** argv ) {
+	BenchSettings settings;
+	int frames = 300;
+	int threads = -1;
+	double threshold = 0.1;
+	std::string baselinePath;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--repetitions" ) ) settings.repetitions = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--warmup" ) ) settings.warmup = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--min-ms" ) ) settings.minRepetitionMs = std::atof( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--filter" ) ) settings.filter = argv[ i + 1 ];
+		else if ( !std::strcmp( argv[ i ], "--frames" ) ) frames = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--threads" ) ) threads = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--baseline" ) ) baselinePath = argv[ i + 1 ];
+		else if ( !std::strcmp( argv[ i ], "--threshold" ) ) threshold = std::atof( argv[ i + 1 ] );
+	}
+	if ( settings.repetitions <= 0 ) settings.repetitions = 1;
+	if ( settings.warmup < 0 ) settings.warmup = 0;
+	if ( frames <= 0 ) frames = 1;
+
+	std::map<std::string, double> baseline;
+	if ( !baselinePath.empty() && !readBaseline( baselinePath, baseline ) ) {
+		std::cerr << "Err: Failure to read baseline " << baselinePath << "." << std::endl;
+		return 1;
+	}
+
+	JobSystem& jobs = JobSystem::getInstance();
+	jobs.init( threads );
+
+	// The null platform gives InputManager a real GLFW window without a display.
+	glfwInitHint( GLFW_PLATFORM, GLFW_PLATFORM_NULL );
+	GLFWwindow* window = nullptr;
+	if ( glfwInit() ) {
+		glfwWindowHint( GLFW_CLIENT_API, GLFW_NO_API );
+		glfwWindowHint( GLFW_VISIBLE, GLFW_FALSE );
+		window = glfwCreateWindow( 800, 600, "arcantha_bench", nullptr, nullptr );
+	}
+	bool ok = true;
+	if ( !window ) {
+		std::cerr << "Err: Failure to create a headless GLFW window; input benchmarks are skipped." << std::endl;
+		ok = false;
+	}
+
+	const TileMap map = buildRoom();
+	BenchRunner runner( settings );
+	if ( window ) runInput( runner, window, ok );
+	runDispatch( runner, ok );
+	runAlloc( runner );
+	runMath( runner );
+	runSerialize( runner, map );
+	ok = runFrame( runner, map, window, frames ) && ok;
+
+	if ( window ) glfwDestroyWindow( window );
+	glfwTerminate();
+	const int workers = jobs.getWorkerCount();
+	jobs.shutdown();
+
+	const std::vector<BenchComparison> comparisons = runner.compare( baseline, threshold );
+	uint64_t regressions = 0;
+	for ( const BenchComparison& comparison : comparisons ) regressions += comparison.regressed;
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_bench" ) );
+	json.value( "repetitions", static_cast< uint64_t >( settings.repetitions ) );
+	json.value( "warmup", static_cast< uint64_t >( settings.warmup ) );
+	json.value( "min_repetition_ms", settings.minRepetitionMs );
+	json.value( "workers", static_cast< uint64_t >( workers ) );
+	runner.write( json );
+	if ( !baselinePath.empty() ) {
+		json.beginObject( "comparison" );
+		json.value( "baseline", baselinePath );
+		json.value( "threshold", threshold );
+		json.beginArray( "changes" );
+		for ( const BenchComparison& comparison : comparisons ) {
+			json.beginObject();
+			json.value( "benchmark", comparison.name );
+			json.value( "baseline_ns", comparison.baselineNs );
+			json.value( "current_ns", comparison.currentNs );
+			json.value( "change", comparison.change );
+			json.value( "regressed", comparison.regressed );
+			json.endObject();
+		}
+		json.endArray();
+		json.value( "regressions", regressions );
+		json.endObject();
+	}
+	json.value( "checks_passed", ok );
+	json.endObject();
+
+	for ( const BenchComparison& comparison : comparisons ) {
+		if ( comparison.regressed ) {
+			std::cerr << "Err: " << comparison.name << " regressed by " << comparison.change * 100.0 << "% (fastest repetition "
+				<< comparison.baselineNs << " ns to " << comparison.currentNs << " ns per operation)." << std::endl;
+		}
+	}
+	return ok && regressions == 0 ? 0 : 1;
+}
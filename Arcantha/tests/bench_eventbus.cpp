@@ -0,0 +1,311 @@
+// Event bus benchmark.
+//
+// Plays a fight with 2,000 enemies. Every frame 8,000 projectile checks run
+// as jobs and post a CombatEvent for every hit or parry; once the physics
+// phase is reached, the combat subscriber applies the damage and posts an
+// EnemyKilled event for every death, which the loot subscriber turns into
+// Essence and Soul drops in the presentation phase and the quest tracker
+// counts in the next frame's input phase. Every 50 frames a door opens. The
+// same frames run twice. Batched: through the EventBus, with per-thread
+// queues and phase-ordered batch delivery. Immediate: through std::function
+// listeners called as each event is posted, the way EventDispatcher works,
+// guarded by a mutex so workers may post. Both must end with the same
+// damage, kills, drops, parries and doors. Reports CPU time per frame for
+// posting and delivery, time per event and the bus's per-type statistics of
+// the last frame. Reports JSON.
+//
+// Usage: arcantha_eventbus_bench [--frames N] [--threads N]
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "CombatCollision.h"
+#include "EventBus.h"
+#include "JobSystem.h"
+#include "bench_common.h"
+
+static const uint32_t ENEMIES = 2000;
+static const uint32_t PROJECTILES = 8000;
+static const size_t PROJECTILE_GRAIN = 256;
+static const int MAX_HEALTH = 100;
+
+/**
+ * @brief An enemy died; its drops are rolled from its id.
+ */
+struct EnemyKilled
+{
+	uint32_t enemy;
+	uint32_t killer;
+	uint16_t essence; // Essence dropped.
+	uint8_t souls; // Souls dropped.
+};
+
+/**
+ * @brief A door finished opening.
+ */
+struct DoorOpened
+{
+	uint32_t door;
+};
+
+/**
+ * @brief What the subscribers saw; must be the same for both runs.
+ */
+struct Totals
+{
+	uint64_t damage = 0;
+	uint64_t hits = 0;
+	uint64_t parries = 0;
+	uint64_t kills = 0;
+	uint64_t essence = 0;
+	uint64_t souls = 0;
+	uint64_t doors = 0;
+	uint64_t questKills = 0;
+
+	bool operator==( const Totals& o ) const {
+		return damage == o.damage && hits == o.hits && parries == o.parries && kills == o.kills && essence == o.essence && souls == o.souls &&
+			doors == o.doors && questKills == o.questKills;
+	}
+};
+
+struct RunResult
+{
+	Totals totals;
+	std::vector<double> postMs, deliverMs, frameMs;
+	uint64_t events = 0;
+	std::vector<EventTypeStats> types; // The bus's figures of the last frame.
+};
+
+/**
+ * @brief Whether a projectile hits this frame, and what; the same in both runs.
+ * @return False for a miss.
+ */
+static bool projectile( uint32_t frame, uint32_t index, CombatEvent& event ) {
+	uint32_t h = ( frame * 0x9E3779B1u ) ^ ( index * 0x85EBCA77u );
+	h ^= h >> 15;
+	h *= 0x2C1B3C6Du;
+	h ^= h >> 12;
+	if ( ( h & 3u ) != 0 ) return false; // A quarter of the projectiles connect.
+	event.attacker = index % 16; // The player and companions.
+	event.defender = ( h >> 4 ) % ENEMIES;
+	event.attack = static_cast< uint16_t >( ( h >> 20 ) & 7u );
+	event.type = ( h >> 24 ) % 64 == 0 ? CombatEventType::Parried : CombatEventType::Hit;
+	event.damage = event.type == CombatEventType::Hit ? static_cast< float >( 5 + ( h >> 26 ) % 20 ) : 0.0f;
+	return true;
+}
+
+/**
+ * @brief Applies a hit; deaths carry the overkill into the respawn so kills only depend on the total damage.
+ * @return True if the enemy died.
+ */
+static bool applyDamage( std::vector<int>& health, const CombatEvent& event, Totals& totals, EnemyKilled& killed ) {
+	if ( event.type == CombatEventType::Parried ) {
+		totals.parries++;
+		return false;
+	}
+	const int damage = static_cast< int >( event.damage );
+	totals.damage += damage;
+	totals.hits++;
+	int& hp = health[ event.defender ];
+	hp -= damage;
+	if ( hp > 0 ) return false;
+	hp += MAX_HEALTH;
+	killed.enemy = event.defender;
+	killed.killer = event.attacker;
+	killed.essence = static_cast< uint16_t >( 10 + event.defender % 7 );
+	killed.souls = static_cast< uint8_t >( event.defender % 13 == 0 ? 1 : 0 );
+	return true;
+}
+
+static void loot( const EnemyKilled& killed, Totals& totals ) {
+	totals.kills++;
+	totals.essence += killed.essence;
+	totals.souls += killed.souls;
+}
+
+static RunResult runBatched( int frames ) {
+	EventBus& bus = EventBus::getInstance();
+	JobSystem& jobs = JobSystem::getInstance();
+	RunResult result;
+	std::vector<int> health( ENEMIES, MAX_HEALTH );
+	Totals& totals = result.totals;
+
+	std::vector<SubscriberID> ids;
+	ids.push_back( bus.subscribe<CombatEvent>( EventPhase::PostPhysics, [ & ]( const EventBatch<CombatEvent>& batch ) {
+		EnemyKilled killed;
+		for ( const CombatEvent& event : batch ) {
+			if ( applyDamage( health, event, totals, killed ) ) bus.post( killed );
+		}
+	} ) );
+	ids.push_back( bus.subscribe<EnemyKilled>( EventPhase::Presentation, [ & ]( const EventBatch<EnemyKilled>& batch ) {
+		for ( const EnemyKilled& killed : batch ) loot( killed, totals );
+	} ) );
+	ids.push_back( bus.subscribe<EnemyKilled>( EventPhase::Input, [ & ]( const EventBatch<EnemyKilled>& batch ) {
+		totals.questKills += batch.size(); // Next frame's input phase; flushed after the last frame.
+	} ) );
+	ids.push_back( bus.subscribe<DoorOpened>( EventPhase::Presentation, [ & ]( const EventBatch<DoorOpened>& batch ) {
+		totals.doors += batch.size();
+	} ) );
+
+	for ( int frame = 0; frame < frames; frame++ ) {
+		BenchTimer frameTimer;
+		bus.deliver( EventPhase::Input );
+
+		// Hits are posted from the workers without locking.
+		BenchTimer postTimer;
+		jobs.parallelFor( PROJECTILES, PROJECTILE_GRAIN, [ &bus, frame ]( size_t first, size_t last ) {
+			CombatEvent event;
+			for ( size_t i = first; i < last; i++ ) {
+				if ( projectile( frame, static_cast< uint32_t >( i ), event ) ) bus.post( event );
+			}
+		} );
+		if ( frame % 50 == 49 ) bus.post( DoorOpened{ static_cast< uint32_t >( frame / 50 ) } );
+		result.postMs.push_back( postTimer.elapsedMs() );
+
+		BenchTimer deliverTimer;
+		bus.deliver( EventPhase::Simulation );
+		bus.deliver( EventPhase::PostPhysics );
+		bus.deliver( EventPhase::Presentation );
+		bus.endFrame();
+		result.deliverMs.push_back( deliverTimer.elapsedMs() );
+		result.frameMs.push_back( frameTimer.elapsedMs() );
+		result.events += bus.getStats().posted;
+	}
+	result.types = bus.getTypeStats();
+	bus.deliver( EventPhase::Input ); // The quest tracker's last kills.
+	bus.endFrame();
+	for ( SubscriberID id : ids ) bus.unsubscribe( id );
+	return result;
+}
+
+/**
+ * @brief Immediate listeners, one map per event type, like EventDispatcher.
+ */
+struct ImmediateDispatcher
+{
+	std::map<unsigned long long, std::function<void( CombatEvent& )>> combatListeners;
+	std::map<unsigned long long, std::function<void( EnemyKilled& )>> killListeners;
+	std::map<unsigned long long, std::function<void( DoorOpened& )>> doorListeners;
+	std::recursive_mutex mutex; // Listeners post from inside listeners.
+	uint64_t events = 0;
+
+	template <typename T>
+	void dispatch( const std::map<unsigned long long, std::function<void( T& )>>& listeners, T& event ) {
+		std::lock_guard<std::recursive_mutex> lock( mutex );
+		events++;
+		for ( const auto& listener : listeners ) listener.second( event );
+	}
+};
+
+static RunResult runImmediate( int frames ) {
+	JobSystem& jobs = JobSystem::getInstance();
+	RunResult result;
+	std::vector<int> health( ENEMIES, MAX_HEALTH );
+	Totals& totals = result.totals;
+	ImmediateDispatcher dispatcher;
+
+	dispatcher.combatListeners.emplace( 0, [ & ]( CombatEvent& event ) {
+		EnemyKilled killed;
+		if ( applyDamage( health, event, totals, killed ) ) dispatcher.dispatch( dispatcher.killListeners, killed );
+	} );
+	dispatcher.killListeners.emplace( 1, [ & ]( EnemyKilled& killed ) { loot( killed, totals ); } );
+	dispatcher.killListeners.emplace( 2, [ & ]( EnemyKilled& ) { totals.questKills++; } );
+	dispatcher.doorListeners.emplace( 3, [ & ]( DoorOpened& ) { totals.doors++; } );
+
+	for ( int frame = 0; frame < frames; frame++ ) {
+		BenchTimer frameTimer;
+		const uint64_t eventsBefore = dispatcher.events;
+		jobs.parallelFor( PROJECTILES, PROJECTILE_GRAIN, [ &dispatcher, frame ]( size_t first, size_t last ) {
+			CombatEvent event;
+			for ( size_t i = first; i < last; i++ ) {
+				if ( projectile( frame, static_cast< uint32_t >( i ), event ) ) dispatcher.dispatch( dispatcher.combatListeners, event );
+			}
+		} );
+		if ( frame % 50 == 49 ) {
+			DoorOpened door{ static_cast< uint32_t >( frame / 50 ) };
+			dispatcher.dispatch( dispatcher.doorListeners, door );
+		}
+		result.postMs.push_back( frameTimer.elapsedMs() ); // Posting is delivery.
+		result.deliverMs.push_back( 0.0 );
+		result.frameMs.push_back( frameTimer.elapsedMs() );
+		result.events += dispatcher.events - eventsBefore;
+	}
+	return result;
+}
+
+static void writeRun( JsonWriter& json, const char* key, const RunResult& run, int frames ) {
+	double total = 0.0;
+	for ( double ms : run.frameMs ) total += ms;
+	json.beginObject( key );
+	json.value( "frame_ms", computePercentiles( run.frameMs ) );
+	json.value( "post_ms", computePercentiles( run.postMs ) );
+	json.value( "deliver_ms", computePercentiles( run.deliverMs ) );
+	json.value( "events_per_frame", static_cast< double >( run.events ) / frames );
+	json.value( "ns_per_event", run.events ? total * 1e6 / run.events : 0.0 );
+	json.endObject();
+}
+
+int main( int argc, char** argv ) {
+	int frames = 600;
+	int threads = -1;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--frames" ) ) frames = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--threads" ) ) threads = std::atoi( argv[ i + 1 ] );
+	}
+	if ( frames <= 0 ) frames = 1;
+
+	JobSystem& jobs = JobSystem::getInstance();
+	jobs.init( threads );
+	EventBus& bus = EventBus::getInstance();
+	bus.registerType<CombatEvent>( "CombatEvent" );
+	bus.registerType<EnemyKilled>( "EnemyKilled" );
+	bus.registerType<DoorOpened>( "DoorOpened" );
+
+	const RunResult batched = runBatched( frames );
+	const RunResult immediate = runImmediate( frames );
+	const int workers = jobs.getWorkerCount();
+	const uint32_t postingThreads = bus.getStats().threads;
+	jobs.shutdown();
+	const bool same = batched.totals == immediate.totals;
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_eventbus_bench" ) );
+	json.value( "frames", static_cast< uint64_t >( frames ) );
+	json.value( "workers", static_cast< uint64_t >( workers ) );
+	json.value( "posting_threads", static_cast< uint64_t >( postingThreads ) );
+	writeRun( json, "batched", batched, frames );
+	writeRun( json, "immediate", immediate, frames );
+	json.beginObject( "totals" );
+	json.value( "damage", batched.totals.damage );
+	json.value( "hits", batched.totals.hits );
+	json.value( "parries", batched.totals.parries );
+	json.value( "kills", batched.totals.kills );
+	json.value( "essence", batched.totals.essence );
+	json.value( "souls", batched.totals.souls );
+	json.value( "doors", batched.totals.doors );
+	json.endObject();
+	json.beginArray( "types" );
+	for ( const EventTypeStats& type : batched.types ) {
+		json.beginObject();
+		json.value( "name", type.name );
+		json.value( "subscribers", static_cast< uint64_t >( type.subscribers ) );
+		json.value( "posted", type.posted );
+		json.value( "delivered", type.delivered );
+		json.value( "calls", static_cast< uint64_t >( type.calls ) );
+		json.value( "deliver_ms", type.deliverMs );
+		json.value( "total_posted", type.totalPosted );
+		json.endObject();
+	}
+	json.endArray();
+	json.value( "same_totals", same );
+	json.endObject();
+
+	if ( !same ) std::cerr << "Err: The batched and immediate runs disagree." << std::endl;
+	return same ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+// Retained HUD benchmark.
+//
+// Builds the game HUD (a vitals panel with health and stamina bars, a
+// currency panel with Essence, Souls, Runes and Gold counters, and a
+// 24x24 cell minimap) and plays a minute of gameplay at 60 frames per
+// second: fights every ten seconds drain stamina every frame and cost health
+// and award souls now and then, gold and runes change rarely and the player
+// crosses a minimap cell every 40 frames. The same run is repeated in
+// retained mode (redraw only what changed) and immediate mode (rebuild
+// everything every frame). Reports the HUD's CPU cost per frame, widgets
+// and quads rebuilt per frame and the share of frames that only composite.
+// Runs headless, so GPU time is not measured here. Reports JSON.
+//
+// Usage: arcantha_hud_bench [--frames N] [--font PATH]
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Hud.h"
+#include "bench_common.h"
+
+static const int MAP_CELLS = 24; // Minimap cells per side.
+static const float CELL_PIXELS = 10.0f;
+
+struct RunResult
+{
+	std::vector<double> frameMs;
+	double widgets = 0.0, quads = 0.0, idleFrames = 0.0;
+	uint64_t staticRedraws = 0;
+};
+
+static RunResult run( const std::string& fontPath, int frames, bool immediate ) {
+	Hud hud;
+	if ( !hud.loadFont( fontPath ) ) std::exit( 1 );
+	hud.resize( 1920, 1080 );
+	hud.setImmediateMode( immediate );
+
+	const uint16_t vitals = hud.addPanel( Hud::NO_PARENT, { 20.0f, 980.0f, 440.0f, 80.0f }, 0xC0201818u, 0xFF6080A0u );
+	const uint16_t health = hud.addBar( vitals, { 20.0f, 44.0f, 400.0f, 18.0f }, 0xFF2020D0u, 0xFF101040u );
+	const uint16_t stamina = hud.addBar( vitals, { 20.0f, 18.0f, 400.0f, 12.0f }, 0xFF20C040u, 0xFF103010u );
+
+	const uint16_t wallet = hud.addPanel( Hud::NO_PARENT, { 1640.0f, 900.0f, 260.0f, 160.0f }, 0xC0201818u, 0xFF6080A0u );
+	const char* labels[ 4 ] = { "Essence ", "Souls ", "Runes ", "Gold " };
+	uint16_t counters[ 4 ];
+	for ( int i = 0; i < 4; i++ ) {
+		counters[ i ] = hud.addCounter( wallet, { 14.0f, 120.0f - 36.0f * i, 232.0f, 28.0f }, labels[ i ], 0xFFE0F0FFu );
+	}
+
+	// Explored cells and the player's cell; the canvas is invalidated when either changes.
+	std::vector<uint8_t> explored( MAP_CELLS * MAP_CELLS, 0 );
+	int playerCell = 0;
+	const uint16_t mapPanel = hud.addPanel( Hud::NO_PARENT, { 1640.0f, 20.0f, 260.0f, 260.0f }, 0xE0100C0Cu, 0xFF6080A0u );
+	const uint16_t minimap = hud.addCanvas( mapPanel, { 10.0f, 10.0f, MAP_CELLS * CELL_PIXELS, MAP_CELLS * CELL_PIXELS },
+		[ &explored, &playerCell ]( HudPainter& painter, const HudRect& rect ) {
+			for ( int cell = 0; cell < MAP_CELLS * MAP_CELLS; cell++ ) {
+				if ( !explored[ cell ] ) continue;
+				const HudRect room = { rect.x + ( cell % MAP_CELLS ) * CELL_PIXELS + 1.0f, rect.y + ( cell / MAP_CELLS ) * CELL_PIXELS + 1.0f,
+					CELL_PIXELS - 2.0f, CELL_PIXELS - 2.0f };
+				painter.fill( room, cell == playerCell ? 0xFF40E0FFu : 0xFF806050u );
+			}
+		} );
+
+	RunResult result;
+	float healthValue = 100.0f, staminaValue = 100.0f;
+	int64_t essence = 1200, souls = 0, runes = 3, gold = 250;
+	for ( int frame = 0; frame < frames; frame++ ) {
+		const bool fighting = frame % 600 < 240;
+		if ( fighting ) {
+			staminaValue += frame % 30 < 12 ? -2.5f : 1.0f; // Attack strings drain, pauses recover.
+			if ( frame % 20 == 0 ) healthValue -= 3.0f;
+			if ( frame % 45 == 0 ) souls += 37;
+			if ( frame % 90 == 0 ) essence += 5;
+		}
+		else {
+			staminaValue += 1.5f;
+			healthValue += 0.05f;
+		}
+		staminaValue = staminaValue < 0.0f ? 0.0f : staminaValue > 100.0f ? 100.0f : staminaValue;
+		healthValue = healthValue < 1.0f ? 100.0f : healthValue > 100.0f ? 100.0f : healthValue;
+		if ( frame % 300 == 299 ) gold += 12;
+		if ( frame % 1800 == 1799 ) runes++;
+		if ( frame % 40 == 0 ) {
+			const int step = frame / 40;
+			playerCell = ( step * 7 + step / MAP_CELLS ) % ( MAP_CELLS * MAP_CELLS );
+			explored[ playerCell ] = 1;
+			hud.invalidate( minimap );
+		}
+
+		hud.setBar( health, healthValue, 100.0f );
+		hud.setBar( stamina, staminaValue, 100.0f );
+		hud.setCounter( counters[ 0 ], essence );
+		hud.setCounter( counters[ 1 ], souls );
+		hud.setCounter( counters[ 2 ], runes );
+		hud.setCounter( counters[ 3 ], gold );
+		hud.render();
+
+		const HudStats& stats = hud.getStats();
+		result.frameMs.push_back( stats.cpuMs );
+		result.widgets += stats.widgetsRedrawn;
+		result.quads += stats.quads;
+		if ( stats.widgetsRedrawn == 0 ) result.idleFrames++;
+	}
+	result.widgets /= frames;
+	result.quads /= frames;
+	result.idleFrames /= frames;
+	result.staticRedraws = hud.getStats().staticRedraws;
+	return result;
+}
+
+static void writeRun( JsonWriter& json, const char* key, const RunResult& result ) {
+	json.beginObject( key );
+	json.value( "cpu_ms", computePercentiles( result.frameMs ) );
+	json.value( "widgets_per_frame", result.widgets );
+	json.value( "quads_per_frame", result.quads );
+	json.value( "composite_only_frames", result.idleFrames );
+	json.value( "static_redraws", result.staticRedraws );
+	json.endObject();
+}
+
+int main( int argc, char** argv ) {
+	int frames = 3600;
+	std::string font = ARCANTHA_BENCH_FONT;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--frames" ) ) frames = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--font" ) ) font = argv[ i + 1 ];
+	}
+	if ( frames <= 0 ) frames = 1;
+
+	const RunResult retained = run( font, frames, false );
+	const RunResult immediate = run( font, frames, true );
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_hud_bench" ) );
+	json.value( "frames", static_cast< uint64_t >( frames ) );
+	writeRun( json, "retained", retained );
+	writeRun( json, "immediate", immediate );
+	json.endObject();
+	return 0;
+}
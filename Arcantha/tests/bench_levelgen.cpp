@@ -0,0 +1,184 @@
+// Level generation benchmark.
+//
+// Generates a batch of seeded levels and reports levels per second and the
+// time spent in each stage (layout, stitching, decoration, enemy placement).
+// Determinism is checked twice: the first levels are regenerated with no
+// worker threads and with an oversubscribed pool and must hash identically,
+// and hashes can be written to or checked against a baseline file to catch
+// changes across builds. Also reports how long the game thread is blocked by
+// a background generation and how well connected the levels are for a
+// walking enemy. Reports JSON.
+//
+// Usage: arcantha_levelgen_bench [--levels N] [--threads N] [--write-hashes FILE] [--check-hashes FILE]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "JobSystem.h"
+#include "LevelGenerator.h"
+#include "Navigation.h"
+#include "bench_common.h"
+
+static const int DETERMINISM_LEVELS = 16; // Levels regenerated under other thread counts.
+
+static std::string toHex( uint64_t value ) {
+	char text[ 17 ];
+	std::snprintf( text, sizeof( text ), "%016llx", static_cast< unsigned long long >( value ) );
+	return text;
+}
+
+// Fraction of rooms a walker starting at the player spawn can reach.
+static double walkerReachableRooms( const Level& level ) {
+	NavGraph graph;
+	graph.build( level.map, NavArchetype() );
+	const int start = graph.findNode( level.playerSpawn );
+	if ( start < 0 ) return 0.0;
+
+	std::vector<bool> seen( graph.getNodeCount(), false ), roomSeen( level.rooms.size(), false );
+	std::vector<uint32_t> queue( 1, static_cast< uint32_t >( start ) );
+	seen[ start ] = true;
+	for ( size_t head = 0; head < queue.size(); head++ ) {
+		const uint32_t node = queue[ head ];
+		const glm::ivec2 tile = graph.getNodeTile( node );
+		const int cell = ( tile.y / Level::ROOM_HEIGHT ) * level.settings.gridWidth + tile.x / Level::ROOM_WIDTH;
+		if ( level.cellToRoom[ cell ] >= 0 ) roomSeen[ level.cellToRoom[ cell ] ] = true;
+		for ( uint32_t e = graph.getEdgeBegin( node ); e < graph.getEdgeBegin( node + 1 ); e++ ) {
+			const uint32_t to = graph.getEdge( e ).to;
+			if ( seen[ to ] ) continue;
+			seen[ to ] = true;
+			queue.push_back( to );
+		}
+	}
+
+	size_t reached = 0;
+	for ( bool room : roomSeen ) reached += room ? 1 : 0;
+	return level.rooms.empty() ? 0.0 : static_cast< double >( reached ) / level.rooms.size();
+}
+
+int main( int argc, char** argv ) {
+	int levels = 200;
+	int threads = -1;
+	std::string writeHashes, checkHashes;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--levels" ) ) levels = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--threads" ) ) threads = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--write-hashes" ) ) writeHashes = argv[ i + 1 ];
+		else if ( !std::strcmp( argv[ i ], "--check-hashes" ) ) checkHashes = argv[ i + 1 ];
+	}
+	if ( levels <= 0 ) levels = 1;
+
+	JobSystem& jobs = JobSystem::getInstance();
+	jobs.init( threads );
+	const int workers = jobs.getWorkerCount();
+
+	// Throughput: one level at a time, each stage spread across the pool.
+	std::vector<uint64_t> hashes;
+	std::vector<double> totalMs, layoutMs, stitchMs, decorateMs, populateMs, reachable;
+	uint64_t rooms = 0, enemies = 0;
+	BenchTimer batch;
+	for ( int i = 0; i < levels; i++ ) {
+		LevelTimings timings;
+		BenchTimer timer;
+		Level level = LevelGenerator::generate( static_cast< uint64_t >( i + 1 ), LevelSettings(), &timings );
+		totalMs.push_back( timer.elapsedMs() );
+		layoutMs.push_back( timings.layoutMs );
+		stitchMs.push_back( timings.stitchMs );
+		decorateMs.push_back( timings.decorateMs );
+		populateMs.push_back( timings.populateMs );
+		hashes.push_back( level.hash() );
+		rooms += level.rooms.size();
+		enemies += level.enemies.size();
+		if ( i < DETERMINISM_LEVELS ) reachable.push_back( walkerReachableRooms( level ) );
+	}
+	const double batchMs = batch.elapsedMs();
+
+	// Background generation: how long the game thread is blocked while a "hub" keeps running frames.
+	std::vector<double> submitMs;
+	std::vector<double> hubFrames;
+	{
+		LevelGenerator generator;
+		for ( int i = 0; i < 8; i++ ) {
+			BenchTimer submit;
+			generator.generateAsync( static_cast< uint64_t >( i + 1 ) );
+			submitMs.push_back( submit.elapsedMs() );
+			int frames = 0;
+			while ( !generator.isReady() ) {
+				BenchTimer frame;
+				while ( frame.elapsedMs() < 1.0 ) {} // Stand-in for a hub frame's work.
+				frames++;
+			}
+			hubFrames.push_back( frames );
+			const uint64_t hash = generator.take().hash();
+			if ( i < levels && hash != hashes[ i ] ) {
+				std::cerr << "Err: Background generation of seed " << i + 1 << " differs from the foreground one." << std::endl;
+				return 1;
+			}
+		}
+	}
+
+	// Determinism across thread counts: inline only, then more workers than cores.
+	bool deterministic = true;
+	const int checked = std::min( levels, DETERMINISM_LEVELS );
+	for ( int poolSize : { 0, 4 } ) {
+		jobs.shutdown();
+		jobs.init( poolSize );
+		for ( int i = 0; i < checked; i++ ) {
+			const uint64_t hash = LevelGenerator::generate( static_cast< uint64_t >( i + 1 ) ).hash();
+			if ( hash != hashes[ i ] ) {
+				std::cerr << "Err: Seed " << i + 1 << " hashes differently with " << poolSize << " workers." << std::endl;
+				deterministic = false;
+			}
+		}
+	}
+	jobs.shutdown();
+
+	// Hashes against a baseline from another build, keyed by seed.
+	bool hashesMatch = true;
+	if ( !checkHashes.empty() ) {
+		std::map<std::string, std::string> expected;
+		std::ifstream in( checkHashes );
+		std::string seed, hex;
+		while ( in >> seed >> hex ) expected[ seed ] = hex;
+		for ( int i = 0; i < levels; i++ ) {
+			auto it = expected.find( std::to_string( i + 1 ) );
+			if ( it != expected.end() && it->second != toHex( hashes[ i ] ) ) {
+				std::cerr << "Err: Level hash of seed " << i + 1 << " changed: " << it->second << " -> " << toHex( hashes[ i ] ) << std::endl;
+				hashesMatch = false;
+			}
+		}
+	}
+	if ( !writeHashes.empty() ) {
+		std::ofstream out( writeHashes );
+		for ( int i = 0; i < levels; i++ ) out << i + 1 << " " << toHex( hashes[ i ] ) << "\n";
+	}
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_levelgen_bench" ) );
+	json.value( "levels", static_cast< uint64_t >( levels ) );
+	json.value( "workers", static_cast< uint64_t >( workers ) );
+	json.value( "levels_per_second", batchMs > 0.0 ? levels * 1000.0 / batchMs : 0.0 );
+	json.value( "mean_rooms", static_cast< double >( rooms ) / levels );
+	json.value( "mean_enemies", static_cast< double >( enemies ) / levels );
+	json.value( "level_ms", computePercentiles( totalMs ) );
+	json.value( "layout_ms", computePercentiles( layoutMs ) );
+	json.value( "stitch_ms", computePercentiles( stitchMs ) );
+	json.value( "decorate_ms", computePercentiles( decorateMs ) );
+	json.value( "populate_ms", computePercentiles( populateMs ) );
+	json.value( "async_submit_ms", computePercentiles( submitMs ) );
+	json.value( "async_hub_frames", computePercentiles( hubFrames ) );
+	json.value( "walker_reachable_rooms", computePercentiles( reachable ) );
+	json.value( "first_hash", toHex( hashes.front() ) );
+	json.value( "deterministic", deterministic );
+	json.value( "hashes_match", hashesMatch );
+	json.endObject();
+
+	return deterministic && hashesMatch ? 0 : 1;
+}
@@ -0,0 +1,270 @@
+// 2D lighting benchmark.
+//
+// Lights a 256 x 96 tile hall full of pillars, ledges and rubble with 128
+// point lights: 96 static torches along the pillars and 32 dynamic spell
+// lights flying around. Every 20 frames a breakable block is smashed or
+// rebuilt, which changes the tiles near a few torches. Two runs over the same
+// frames. Cached: Lighting2D with chunked, merged occluder edges, cached
+// static polygons and parallel jobs. Naive: every light recomputed every
+// frame against every tile face of the room, as the first prototype did.
+// Both cast rays the same way; at the end every light's polygon area must
+// match between the runs. Reports CPU time per frame, polygons and edges per
+// frame and the vertices sent to the light buffer. Headless, so nothing is
+// drawn. Reports JSON.
+//
+// Usage: arcantha_lighting_bench [--lights N] [--frames N] [--threads N]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Lighting2D.h"
+#include "Random.h"
+#include "bench_common.h"
+
+static const int ROOM_WIDTH = 256;
+static const int ROOM_HEIGHT = 96;
+static const int BREAK_INTERVAL = 20; // Frames between block changes.
+static const float DT = 1.0f / 60.0f;
+
+/**
+ * @brief A spell light bouncing around the hall.
+ */
+struct Spell
+{
+	glm::vec2 position, velocity;
+};
+
+struct RunResult
+{
+	std::vector<double> frameMs;
+	double computedPerFrame = 0.0;
+	double edgesPerFrame = 0.0; // Edges rays were cast against.
+	double scannedPerFrame = 0.0; // Tile faces filtered to find them, naive run only.
+	double verticesPerFrame = 0.0;
+	uint32_t occluders = 0;
+	std::vector<float> areas; // Of every light's polygon after the last frame.
+};
+
+static TileMap buildRoom() {
+	TileMap map( ROOM_WIDTH, ROOM_HEIGHT );
+	Random random( 43 );
+	map.fill( 0, 0, ROOM_WIDTH, 2, Tile::Solid );
+	map.fill( 0, ROOM_HEIGHT - 2, ROOM_WIDTH, 2, Tile::Solid );
+	for ( int x = 8; x < ROOM_WIDTH - 4; x += 12 ) {
+		map.fill( x, 2, 2, random.range( 10, 40 ), Tile::Solid ); // Pillars.
+		map.fill( x - 3, random.range( 20, 70 ), random.range( 4, 9 ), 1, Tile::Solid ); // Ledges.
+		map.fill( x + 4, ROOM_HEIGHT - 2 - random.range( 4, 16 ), 1, 16, Tile::Solid ); // Stalactites.
+	}
+	for ( int i = 0; i < 200; i++ ) map.set( random.range( 1, ROOM_WIDTH - 2 ), random.range( 2, ROOM_HEIGHT - 3 ), Tile::Solid ); // Rubble.
+	return map;
+}
+
+/**
+ * @brief Places the torches: on both sides of the pillars, above the floor.
+ */
+static std::vector<Light2DSettings> placeLights( int count, Random& random ) {
+	std::vector<Light2DSettings> lights;
+	const int torches = count * 3 / 4;
+	for ( int i = 0; i < count; i++ ) {
+		Light2DSettings light;
+		if ( i < torches ) {
+			const int pillar = i / 2 % ( ( ROOM_WIDTH - 12 ) / 12 + 1 );
+			light.position = glm::vec2( 8.0f + pillar * 12.0f + ( i % 2 ? 2.5f : -0.5f ), 4.5f + ( i / 42 ) * 5.0f );
+			light.radius = random.range( 7.0f, 11.0f );
+			light.color = 0xFF3070FFu;
+		}
+		else {
+			light.position = glm::vec2( random.range( 4.0f, ROOM_WIDTH - 4.0f ), random.range( 4.0f, ROOM_HEIGHT - 4.0f ) );
+			light.radius = random.range( 6.0f, 9.0f );
+			light.color = 0xFFFF9060u;
+			light.dynamic = true;
+		}
+		lights.push_back( light );
+	}
+	return lights;
+}
+
+/**
+ * @brief Moves the spell lights, bouncing off the hall's bounds.
+ */
+static void moveSpells( std::vector<Spell>& spells ) {
+	for ( Spell& spell : spells ) {
+		spell.position += spell.velocity * DT;
+		if ( spell.position.x < 3.0f || spell.position.x > ROOM_WIDTH - 3.0f ) spell.velocity.x = -spell.velocity.x;
+		if ( spell.position.y < 3.0f || spell.position.y > ROOM_HEIGHT - 3.0f ) spell.velocity.y = -spell.velocity.y;
+	}
+}
+
+/**
+ * @brief Smashes or rebuilds the breakable block next to a pillar.
+ * @return The tiles that changed.
+ */
+static TileRect toggleBlock( TileMap& map, int frame ) {
+	const int index = frame / BREAK_INTERVAL;
+	const TileRect rect = { 10 + ( index * 7 % 20 ) * 12, 2, 2, 3 };
+	map.fill( rect.x, rect.y, rect.w, rect.h, map.isSolid( rect.x, rect.y ) ? Tile::Empty : Tile::Solid );
+	return rect;
+}
+
+static float polygonArea( const std::vector<glm::vec2>& polygon ) {
+	float area = 0.0f;
+	for ( size_t i = 0; i < polygon.size(); i++ ) {
+		const glm::vec2& a = polygon[ i ];
+		const glm::vec2& b = polygon[ ( i + 1 ) % polygon.size() ];
+		area += a.x * b.y - a.y * b.x;
+	}
+	return area * 0.5f;
+}
+
+static std::vector<Spell> makeSpells( const std::vector<Light2DSettings>& lights, Random& random ) {
+	std::vector<Spell> spells;
+	for ( const Light2DSettings& light : lights ) {
+		if ( light.dynamic ) spells.push_back( { light.position, glm::vec2( random.range( -12.0f, 12.0f ), random.range( -8.0f, 8.0f ) ) } );
+	}
+	return spells;
+}
+
+static RunResult runCached( const std::vector<Light2DSettings>& settings, int frames ) {
+	TileMap map = buildRoom();
+	Random random( 7 );
+	std::vector<Spell> spells = makeSpells( settings, random );
+	Lighting2D lighting;
+	lighting.setTileMap( &map );
+	std::vector<uint32_t> dynamicLights;
+	for ( const Light2DSettings& light : settings ) {
+		const uint32_t index = lighting.addLight( light );
+		if ( light.dynamic ) dynamicLights.push_back( index );
+	}
+	std::vector<LightVertex> vertices;
+
+	RunResult result;
+	for ( int frame = 0; frame < frames; frame++ ) {
+		BenchTimer timer;
+		if ( frame > 0 && frame % BREAK_INTERVAL == 0 ) lighting.invalidateTiles( toggleBlock( map, frame ) );
+		moveSpells( spells );
+		for ( size_t i = 0; i < spells.size(); i++ ) lighting.setLightPosition( dynamicLights[ i ], spells[ i ].position );
+		lighting.update();
+		vertices.resize( lighting.getVertexCount() );
+		lighting.writeVertices( vertices.data() );
+		result.frameMs.push_back( timer.elapsedMs() );
+		result.computedPerFrame += lighting.getStats().computed;
+		result.edgesPerFrame += static_cast< double >( lighting.getStats().edgesGathered );
+		result.verticesPerFrame += static_cast< double >( vertices.size() );
+	}
+	result.computedPerFrame /= frames;
+	result.edgesPerFrame /= frames;
+	result.verticesPerFrame /= frames;
+	result.occluders = lighting.getStats().edges;
+	for ( uint32_t i = 0; i < lighting.getLightCount(); i++ ) result.areas.push_back( polygonArea( lighting.getVisibility( i ) ) );
+	return result;
+}
+
+static RunResult runNaive( std::vector<Light2DSettings> settings, int frames ) {
+	TileMap map = buildRoom();
+	Random random( 7 );
+	std::vector<Spell> spells = makeSpells( settings, random );
+	const TileRect room = { 0, 0, ROOM_WIDTH, ROOM_HEIGHT };
+	std::vector<LightEdge> faces, nearby;
+	Lighting2D::extractEdges( map, room, false, faces );
+	std::vector<std::vector<glm::vec2>> polygons( settings.size() );
+
+	RunResult result;
+	for ( int frame = 0; frame < frames; frame++ ) {
+		BenchTimer timer;
+		if ( frame > 0 && frame % BREAK_INTERVAL == 0 ) {
+			toggleBlock( map, frame );
+			faces.clear();
+			Lighting2D::extractEdges( map, room, false, faces );
+		}
+		moveSpells( spells );
+		size_t spell = 0;
+		size_t vertexCount = 0;
+		for ( size_t i = 0; i < settings.size(); i++ ) {
+			Light2DSettings& light = settings[ i ];
+			if ( light.dynamic ) light.position = spells[ spell++ ].position;
+			nearby.clear();
+			for ( const LightEdge& edge : faces ) {
+				const glm::vec2 along = edge.b - edge.a, toLight = light.position - edge.a;
+				if ( along.x * toLight.y - along.y * toLight.x <= 0.0f ) continue;
+				if ( std::max( edge.a.x, edge.b.x ) < light.position.x - light.radius || std::min( edge.a.x, edge.b.x ) > light.position.x + light.radius ) continue;
+				if ( std::max( edge.a.y, edge.b.y ) < light.position.y - light.radius || std::min( edge.a.y, edge.b.y ) > light.position.y + light.radius ) continue;
+				nearby.push_back( edge );
+			}
+			Lighting2D::computeVisibility( light.position, light.radius, nearby.data(), nearby.size(), polygons[ i ] );
+			result.edgesPerFrame += static_cast< double >( nearby.size() );
+			vertexCount += polygons[ i ].size() * 3;
+		}
+		result.frameMs.push_back( timer.elapsedMs() );
+		result.computedPerFrame += static_cast< double >( settings.size() );
+		result.scannedPerFrame += static_cast< double >( faces.size() * settings.size() );
+		result.verticesPerFrame += static_cast< double >( vertexCount );
+	}
+	result.computedPerFrame /= frames;
+	result.edgesPerFrame /= frames;
+	result.scannedPerFrame /= frames;
+	result.verticesPerFrame /= frames;
+	result.occluders = static_cast< uint32_t >( faces.size() );
+	for ( const std::vector<glm::vec2>& polygon : polygons ) result.areas.push_back( polygonArea( polygon ) );
+	return result;
+}
+
+static void writeRun( JsonWriter& json, const char* key, const RunResult& result ) {
+	json.beginObject( key );
+	json.value( "frame_ms", computePercentiles( result.frameMs ) );
+	json.value( "polygons_per_frame", result.computedPerFrame );
+	json.value( "edges_per_frame", result.edgesPerFrame );
+	if ( result.scannedPerFrame > 0.0 ) json.value( "faces_scanned_per_frame", result.scannedPerFrame );
+	json.value( "vertices_per_frame", result.verticesPerFrame );
+	json.value( "occluder_edges", static_cast< uint64_t >( result.occluders ) );
+	json.endObject();
+}
+
+int main( int argc, char** argv ) {
+	int lightCount = 128;
+	int frames = 600;
+	int threads = -1;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--lights" ) ) lightCount = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--frames" ) ) frames = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--threads" ) ) threads = std::atoi( argv[ i + 1 ] );
+	}
+	if ( lightCount <= 0 ) lightCount = 1;
+	if ( frames <= 0 ) frames = 1;
+
+	JobSystem& jobs = JobSystem::getInstance();
+	jobs.init( threads );
+	Random random( 11 );
+	const std::vector<Light2DSettings> lights = placeLights( lightCount, random );
+	const RunResult cached = runCached( lights, frames );
+	const RunResult naive = runNaive( lights, frames );
+	const int workers = jobs.getWorkerCount();
+	jobs.shutdown();
+
+	// Merged edges give the rays fewer endpoints, so tiny slivers may differ; the lit area must not.
+	float maxAreaError = 0.0f;
+	for ( size_t i = 0; i < lights.size(); i++ ) {
+		maxAreaError = std::max( maxAreaError, std::fabs( cached.areas[ i ] - naive.areas[ i ] ) / std::max( naive.areas[ i ], 1.0f ) );
+	}
+	const bool matches = maxAreaError < 1e-3f;
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_lighting_bench" ) );
+	json.value( "lights", static_cast< uint64_t >( lightCount ) );
+	json.value( "frames", static_cast< uint64_t >( frames ) );
+	json.value( "workers", static_cast< uint64_t >( workers ) );
+	writeRun( json, "cached", cached );
+	writeRun( json, "naive", naive );
+	json.value( "max_area_error", static_cast< double >( maxAreaError ) );
+	json.value( "matches", matches );
+	json.endObject();
+
+	if ( !matches ) std::cerr << "Err: Cached visibility polygons differ from the naive ones." << std::endl;
+	return matches ? 0 : 1;
+}
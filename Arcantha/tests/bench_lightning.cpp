@@ -0,0 +1,183 @@
+// Lightning benchmark.
+//
+// Keeps 500 bolts alive at once, as a busy fight with chain lightning would:
+// every bolt lasts 0.15 to 0.4 seconds, is 2 to 30 meters long and uses one
+// of four spell styles, and each expired bolt is replaced by a new strike
+// the same frame. The same sequence of strikes runs twice. Cached: strikes
+// look up shared shapes, missing ones are generated in jobs, and a frame
+// writes one small instance per bolt while the shader animates the jitter.
+// Regenerated: every bolt is rebuilt by midpoint displacement every frame and
+// expanded into triangles, as an effect without a cache has to. Reports CPU
+// time per frame, bytes produced per frame, the cache hit rate and the cache
+// size. Headless, so nothing is drawn. Reports JSON.
+//
+// Usage: arcantha_lightning_bench [--bolts N] [--frames N] [--threads N]
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "JobSystem.h"
+#include "LightningSystem.h"
+#include "Random.h"
+#include "bench_common.h"
+
+static const float DT = 1.0f / 60.0f;
+
+/**
+ * @brief A world-space vertex of a regenerated bolt.
+ */
+struct BoltVertex
+{
+	float x, y;
+	uint32_t color;
+	float across;
+};
+
+struct LiveBolt
+{
+	LightningBoltSettings settings;
+	float age;
+};
+
+struct RunResult
+{
+	std::vector<double> frameMs;
+	double bytesPerFrame = 0.0;
+	uint64_t hits = 0, misses = 0;
+	LightningStats last;
+};
+
+/**
+ * @brief Strikes a random bolt in one of the spell styles.
+ */
+static LightningBoltSettings randomBolt( Random& random ) {
+	static const float ROUGHNESS[ 4 ] = { 0.5f, 0.7f, 0.3f, 0.55f };
+	static const float BRANCHING[ 4 ] = { 0.3f, 0.8f, 0.0f, 0.5f };
+	static const uint32_t COLORS[ 4 ] = { 0xFFFFD0A0u, 0xFFFF80C0u, 0xFFFFFFFFu, 0xFF80FFFFu };
+	const int style = random.range( 0, 3 );
+	LightningBoltSettings bolt;
+	bolt.start = glm::vec2( random.range( 0.0f, 200.0f ), random.range( 0.0f, 100.0f ) );
+	const float angle = random.range( 0.0f, 6.2831853f ), length = random.range( 2.0f, 30.0f );
+	bolt.end = bolt.start + glm::vec2( std::cos( angle ), std::sin( angle ) ) * length;
+	bolt.roughness = ROUGHNESS[ style ] + random.range( -0.02f, 0.02f );
+	bolt.branching = BRANCHING[ style ];
+	bolt.color = COLORS[ style ];
+	bolt.duration = random.range( 0.15f, 0.4f );
+	bolt.seed = random.nextU32();
+	return bolt;
+}
+
+/**
+ * @brief Expands a shape into world-space triangles, six vertices per segment.
+ */
+static void expand( const LightningBoltSettings& bolt, const std::vector<LightningSegment>& shape, std::vector<BoltVertex>& out ) {
+	const glm::vec2 axis = bolt.end - bolt.start;
+	const float length = glm::length( axis );
+	const glm::vec2 across = glm::vec2( -axis.y, axis.x ) / length * ( bolt.displacement * length );
+	for ( const LightningSegment& segment : shape ) {
+		const glm::vec2 a = bolt.start + axis * segment.ax + across * segment.ay;
+		const glm::vec2 b = bolt.start + axis * segment.bx + across * segment.by;
+		glm::vec2 normal = glm::vec2( a.y - b.y, b.x - a.x );
+		normal /= glm::length( normal ) + 1e-6f;
+		const glm::vec2 wa = normal * ( bolt.width * 0.5f * segment.aWidth ), wb = normal * ( bolt.width * 0.5f * segment.bWidth );
+		const BoltVertex quad[ 6 ] = { { a.x - wa.x, a.y - wa.y, bolt.color, -1.0f }, { b.x - wb.x, b.y - wb.y, bolt.color, -1.0f },
+			{ b.x + wb.x, b.y + wb.y, bolt.color, 1.0f }, { a.x - wa.x, a.y - wa.y, bolt.color, -1.0f },
+			{ b.x + wb.x, b.y + wb.y, bolt.color, 1.0f }, { a.x + wa.x, a.y + wa.y, bolt.color, 1.0f } };
+		out.insert( out.end(), quad, quad + 6 );
+	}
+}
+
+static RunResult run( int boltCount, int frames, bool cached ) {
+	Random random( 21 );
+	std::vector<LiveBolt> live;
+	LightningSystem lightning;
+	std::vector<LightningInstance> instances;
+	std::vector<LightningSegment> shape;
+	std::vector<BoltVertex> vertices;
+
+	RunResult result;
+	for ( int frame = 0; frame < frames; frame++ ) {
+		BenchTimer timer;
+		for ( LiveBolt& bolt : live ) bolt.age += DT;
+		for ( size_t i = 0; i < live.size(); ) {
+			if ( live[ i ].age >= live[ i ].settings.duration ) {
+				live[ i ] = live.back();
+				live.pop_back();
+			}
+			else i++;
+		}
+		while ( live.size() < static_cast< size_t >( boltCount ) ) {
+			live.push_back( { randomBolt( random ), 0.0f } );
+			if ( cached ) lightning.strike( live.back().settings );
+		}
+
+		if ( cached ) {
+			lightning.update( DT );
+			instances.resize( lightning.getBoltCount() );
+			lightning.writeInstances( instances.data() );
+			result.bytesPerFrame += static_cast< double >( instances.size() * sizeof( LightningInstance ) );
+			result.hits += lightning.getStats().cacheHits;
+			result.misses += lightning.getStats().cacheMisses;
+		}
+		else {
+			// The bolt flickers by regenerating, so the seed changes every frame.
+			vertices.clear();
+			for ( const LiveBolt& bolt : live ) {
+				const LightningBoltSettings& settings = bolt.settings;
+				const int detail = LightningSystem::detailFor( glm::length( settings.end - settings.start ), 0.5f );
+				LightningSystem::generateShape( detail, settings.roughness, settings.branching, settings.seed * 7919ull + frame, shape );
+				expand( settings, shape, vertices );
+			}
+			result.bytesPerFrame += static_cast< double >( vertices.size() * sizeof( BoltVertex ) );
+		}
+		result.frameMs.push_back( timer.elapsedMs() );
+	}
+	result.bytesPerFrame /= frames;
+	result.last = lightning.getStats();
+	return result;
+}
+
+int main( int argc, char** argv ) {
+	int bolts = 500;
+	int frames = 600;
+	int threads = -1;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--bolts" ) ) bolts = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--frames" ) ) frames = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--threads" ) ) threads = std::atoi( argv[ i + 1 ] );
+	}
+	if ( bolts <= 0 ) bolts = 1;
+	if ( frames <= 0 ) frames = 1;
+
+	JobSystem& jobs = JobSystem::getInstance();
+	jobs.init( threads );
+	const RunResult cached = run( bolts, frames, true );
+	const RunResult regenerated = run( bolts, frames, false );
+	const int workers = jobs.getWorkerCount();
+	jobs.shutdown();
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_lightning_bench" ) );
+	json.value( "bolts", static_cast< uint64_t >( bolts ) );
+	json.value( "frames", static_cast< uint64_t >( frames ) );
+	json.value( "workers", static_cast< uint64_t >( workers ) );
+	json.beginObject( "cached" );
+	json.value( "frame_ms", computePercentiles( cached.frameMs ) );
+	json.value( "bytes_per_frame", cached.bytesPerFrame );
+	json.value( "hit_rate", static_cast< double >( cached.hits ) / static_cast< double >( cached.hits + cached.misses ) );
+	json.value( "shapes", static_cast< uint64_t >( cached.last.shapes ) );
+	json.value( "segments", static_cast< uint64_t >( cached.last.segments ) );
+	json.value( "cache_bytes", static_cast< uint64_t >( cached.last.segments * sizeof( LightningSegment ) ) );
+	json.endObject();
+	json.beginObject( "regenerated" );
+	json.value( "frame_ms", computePercentiles( regenerated.frameMs ) );
+	json.value( "bytes_per_frame", regenerated.bytesPerFrame );
+	json.endObject();
+	json.endObject();
+	return 0;
+}
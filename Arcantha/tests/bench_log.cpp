@@ -0,0 +1,173 @@
+// Logging benchmark.
+//
+// Measures what a log statement costs the thread that logs it. Messages are
+// logged in bursts of 256, the way a busy frame logs; between bursts the
+// queues are flushed outside the timing, as the writer thread would. Cases:
+// an info message with an integer and a float, one with a string argument,
+// a trace message compiled out by ARCANTHA_LOG_LEVEL, a message suppressed
+// by the rate limit, and the same info message from several threads at
+// once. For comparison the message is written with std::ofstream and
+// std::endl, as Window did with std::cerr, and with fprintf and fflush.
+// Afterwards every message must be accounted for: written, dropped or
+// suppressed, and the log file must have one line per written message.
+// Reports nanoseconds per call and JSON.
+//
+// Usage: arcantha_log_bench [--bursts N] [--threads N]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Log.h"
+#include "bench_common.h"
+
+static const int BURST = 256;
+static const char* LOG_PATH = "arcantha_log_bench.log";
+static const char* BASELINE_PATH = "arcantha_log_bench_baseline.log";
+
+/**
+ * @brief Times bursts of calls and flushes the logger between them.
+ * @return Nanoseconds per call of every burst.
+ */
+template <typename Call>
+static std::vector<double> timeBursts( int bursts, const Call& call ) {
+	std::vector<double> nanoseconds;
+	for ( int burst = 0; burst < bursts; burst++ ) {
+		BenchTimer timer;
+		for ( int i = 0; i < BURST; i++ ) call( burst * BURST + i );
+		nanoseconds.push_back( timer.elapsedMs() * 1e6 / BURST );
+		Logger::getInstance().flush();
+	}
+	return nanoseconds;
+}
+
+int main( int argc, char** argv ) {
+	int bursts = 200;
+	int threads = 4;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--bursts" ) ) bursts = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--threads" ) ) threads = std::atoi( argv[ i + 1 ] );
+	}
+	if ( bursts <= 0 ) bursts = 1;
+	if ( threads <= 0 ) threads = 1;
+
+	Logger& logger = Logger::getInstance();
+	LogSettings settings;
+	settings.console = false;
+	settings.filePath = LOG_PATH;
+	settings.rateLimit = 0; // Unlimited, so the per-call cost is measured; the rate-limited case uses its own settings below.
+	settings.crashHandlers = false;
+	logger.init( settings );
+	const std::string weapon = "Serrated Moonblade of Ash";
+	uint64_t calls = 0;
+
+	const std::vector<double> infoNs = timeBursts( bursts, []( int i ) {
+		LOG_INFO( "Enemy {} took {} damage", i, i * 0.5f );
+	} );
+	const std::vector<double> stringNs = timeBursts( bursts, [ &weapon ]( int i ) {
+		LOG_INFO( "Player equipped {} in slot {}", weapon, i & 3 );
+	} );
+	const std::vector<double> filteredNs = timeBursts( bursts, []( int i ) {
+		LOG_TRACE( "Tile {} visited", i );
+		( void )i;
+	} );
+	calls += 2ull * bursts * BURST;
+
+	// Several threads at once, each into its own ring.
+	std::vector<std::vector<double>> threadNs( threads );
+	std::vector<std::thread> workers;
+	for ( int t = 0; t < threads; t++ ) {
+		workers.emplace_back( [ &threadNs, t, bursts ]() {
+			for ( int burst = 0; burst < bursts; burst++ ) {
+				BenchTimer timer;
+				for ( int i = 0; i < BURST; i++ ) LOG_INFO( "Worker {} finished job {}", t, burst * BURST + i );
+				threadNs[ t ].push_back( timer.elapsedMs() * 1e6 / BURST );
+				std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+			}
+		} );
+	}
+	for ( std::thread& worker : workers ) worker.join();
+	std::vector<double> concurrentNs;
+	for ( const std::vector<double>& samples : threadNs ) concurrentNs.insert( concurrentNs.end(), samples.begin(), samples.end() );
+	calls += static_cast< uint64_t >( threads ) * bursts * BURST;
+	logger.shutdown();
+	const LogStats unlimited = logger.getStats();
+
+	// Count what reached the file before it is reopened.
+	uint64_t lines = 0;
+	{
+		std::ifstream in( LOG_PATH );
+		std::string line;
+		while ( std::getline( in, line ) ) lines++;
+	}
+
+	settings.rateLimit = 20;
+	settings.filePath.clear();
+	logger.init( settings );
+	const std::vector<double> limitedNs = timeBursts( bursts, []( int i ) {
+		LOG_WARN( "Missing sprite {}", i );
+	} );
+	calls += static_cast< uint64_t >( bursts ) * BURST;
+	logger.shutdown();
+	const LogStats stats = logger.getStats();
+
+	// What logging cost before: a synchronous stream flushed at every line.
+	std::vector<double> endlNs, fprintfNs;
+	{
+		std::ofstream out( BASELINE_PATH );
+		for ( int burst = 0; burst < bursts; burst++ ) {
+			BenchTimer timer;
+			for ( int i = 0; i < BURST; i++ ) out << "Info: Enemy " << burst * BURST + i << " took " << ( burst * BURST + i ) * 0.5f << " damage" << std::endl;
+			endlNs.push_back( timer.elapsedMs() * 1e6 / BURST );
+		}
+	}
+	{
+		std::FILE* out = std::fopen( BASELINE_PATH, "w" );
+		for ( int burst = 0; out && burst < bursts; burst++ ) {
+			BenchTimer timer;
+			for ( int i = 0; i < BURST; i++ ) {
+				std::fprintf( out, "Info: Enemy %d took %g damage\n", burst * BURST + i, ( burst * BURST + i ) * 0.5f );
+				std::fflush( out );
+			}
+			fprintfNs.push_back( timer.elapsedMs() * 1e6 / BURST );
+		}
+		if ( out ) std::fclose( out );
+	}
+	std::remove( LOG_PATH );
+	std::remove( BASELINE_PATH );
+
+	const bool accounted = stats.written + stats.dropped + stats.suppressed == calls && lines == unlimited.written;
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_log_bench" ) );
+	json.value( "bursts", static_cast< uint64_t >( bursts ) );
+	json.value( "burst_size", static_cast< uint64_t >( BURST ) );
+	json.value( "threads", static_cast< uint64_t >( threads ) );
+	json.value( "log_level", static_cast< uint64_t >( ARCANTHA_LOG_LEVEL ) );
+	json.beginObject( "ns_per_call" );
+	json.value( "info_int_float", computePercentiles( infoNs ) );
+	json.value( "info_string", computePercentiles( stringNs ) );
+	json.value( "trace_compiled_out", computePercentiles( filteredNs ) );
+	json.value( "rate_limited", computePercentiles( limitedNs ) );
+	json.value( "info_concurrent", computePercentiles( concurrentNs ) );
+	json.value( "ofstream_endl", computePercentiles( endlNs ) );
+	json.value( "fprintf_fflush", computePercentiles( fprintfNs ) );
+	json.endObject();
+	json.value( "calls", calls );
+	json.value( "written", stats.written );
+	json.value( "dropped", stats.dropped );
+	json.value( "suppressed", stats.suppressed );
+	json.value( "file_lines", lines );
+	json.value( "logging_threads", static_cast< uint64_t >( stats.threads ) );
+	json.value( "all_accounted", accounted );
+	json.endObject();
+
+	if ( !accounted ) std::cerr << "Err: Messages were lost without being counted as dropped or suppressed." << std::endl;
+	return accounted ? 0 : 1;
+}
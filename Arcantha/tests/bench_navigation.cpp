@@ -0,0 +1,215 @@
+// Navigation benchmark.
+//
+// Builds navigation graphs for three enemy archetypes (walker, leaper, flyer)
+// in a large generated room, then has 200 agents chase a moving player while
+// PathService answers their requests within a fixed per-frame budget. Reports
+// graph build cost, main thread frame cost, request latency in frames, cache
+// and partial repath rates, and, for comparison, the cost of a naive frame
+// where every agent runs a full A* synchronously. Reports JSON.
+//
+// Usage: arcantha_navigation_bench [--frames N] [--budget MS] [--threads N]
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Navigation.h"
+#include "Random.h"
+#include "TileMap.h"
+#include "bench_common.h"
+
+static const int AGENT_COUNT = 200;
+static const int REPATH_INTERVAL = 30; // Frames between routine repaths of one agent.
+static const int FLOOR_SPACING = 12; // Rows between the tops of stacked floors.
+static const int FLOOR_ATTEMPTS = 100000; // Random nodes tried before a graph is declared to have no floor node.
+
+// A tall room with stacked floors, gaps, staircases, one-way platforms and pillars.
+static TileMap buildRoom( Random& random ) {
+	TileMap map( 160, 90, 1.0f );
+	map.fill( 0, 0, 160, 2, Tile::Solid );
+	map.fill( 0, 0, 2, 90, Tile::Solid );
+	map.fill( 158, 0, 2, 90, Tile::Solid );
+	map.fill( 0, 88, 160, 2, Tile::Solid );
+
+	for ( int floor = 1; floor <= 6; floor++ ) {
+		const int y = floor * FLOOR_SPACING + 1;
+		for ( int x = 2; x < 158; ) {
+			const int run = random.range( 8, 24 );
+			map.fill( x, y, run, 1, random.range( 0, 3 ) == 0 ? Tile::Platform : Tile::Solid );
+			x += run + random.range( 2, 5 ); // Gaps the leaper can clear and the walker may have to drop through.
+		}
+	}
+	for ( int i = 0; i < 20; i++ ) {
+		const int x = random.range( 4, 150 ), y = random.range( 2, 80 );
+		map.fill( x, y, 2, random.range( 2, 5 ), Tile::Solid );
+	}
+	for ( int i = 0; i < 30; i++ ) {
+		map.fill( random.range( 4, 150 ), random.range( 4, 84 ), random.range( 3, 6 ), 1, Tile::Platform );
+	}
+
+	// Staircases of one-way platforms three tiles apart let walkers climb between floors.
+	// They go in last so the clutter above never blocks them.
+	for ( int floor = 0; floor < 6; floor++ ) {
+		for ( int stair = 0; stair < 4; stair++ ) {
+			int x = random.range( 22, 134 );
+			for ( int step = 1; step <= 3; step++ ) {
+				const int y = floor * FLOOR_SPACING + 1 + step * 3;
+				map.fill( x, y, 4, 1, Tile::Platform );
+				map.fill( x, y + 1, 4, 2, Tile::Empty ); // Headroom through the clutter.
+				x += ( stair & 1 ) ? 5 : -5;
+			}
+			// A hatch in the floor above, wide enough to jump up through from the last step.
+			map.fill( ( stair & 1 ) ? x - 5 : x, ( floor + 1 ) * FLOOR_SPACING + 1, 9, 1, Tile::Platform );
+		}
+	}
+	return map;
+}
+
+// A random node standing on one of the main floors, so spawns and targets avoid sealed pockets.
+static glm::vec2 randomFloorPosition( const TileMap& map, const NavGraph& graph, Random& random ) {
+	for ( int attempt = 0; attempt < FLOOR_ATTEMPTS && graph.getNodeCount() > 0; attempt++ ) {
+		const glm::ivec2 tile = graph.getNodeTile( static_cast< uint32_t >( random.range( 0, static_cast< int >( graph.getNodeCount() ) - 1 ) ) );
+		if ( tile.y % FLOOR_SPACING == 2 ) return map.tileCenter( tile.x, tile.y );
+	}
+	std::cerr << "Err: The navigation graph has no node on a floor." << std::endl;
+	std::exit( 1 );
+}
+
+int main( int argc, char** argv ) {
+	int frames = 600;
+	double budgetMs = 2.0;
+	int threads = -1;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--frames" ) ) frames = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--budget" ) ) budgetMs = std::atof( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--threads" ) ) threads = std::atoi( argv[ i + 1 ] );
+	}
+	if ( frames <= 0 ) frames = 1;
+
+	JobSystem::getInstance().init( threads );
+
+	Random random( 0x9A7 );
+	TileMap map = buildRoom( random );
+
+	NavArchetype walker;
+	NavArchetype leaper;
+	leaper.jumpHeight = 5;
+	leaper.jumpDistance = 7;
+	leaper.maxDrop = 12;
+	NavArchetype flyer;
+	flyer.clearance = 1;
+	flyer.flying = true;
+
+	PathService service( map );
+	std::vector<double> buildMs;
+	for ( const NavArchetype& archetype : { walker, leaper, flyer } ) {
+		BenchTimer build;
+		service.addArchetype( archetype );
+		buildMs.push_back( build.elapsedMs() );
+	}
+
+	// Agents start on random nodes of their archetype: 90 walkers, 60 leapers, 50 flyers.
+	std::vector<int> archetypeOf( AGENT_COUNT );
+	std::vector<glm::vec2> positions( AGENT_COUNT );
+	std::vector<size_t> nextWaypoint( AGENT_COUNT, 1 );
+	std::vector<int> requestFrame( AGENT_COUNT, -1 );
+	std::vector<glm::vec2> requestedGoal( AGENT_COUNT, glm::vec2( -1000.0f ) );
+	for ( int i = 0; i < AGENT_COUNT; i++ ) {
+		archetypeOf[ i ] = i < 90 ? 0 : i < 150 ? 1 : 2;
+		positions[ i ] = randomFloorPosition( map, service.getGraph( archetypeOf[ i ] ), random );
+	}
+
+	// The player runs between random floor positions at 8 tiles per second.
+	auto randomPlayerTarget = [ & ]() { return randomFloorPosition( map, service.getGraph( 0 ), random ); };
+	glm::vec2 player = randomPlayerTarget(), playerTarget = randomPlayerTarget();
+	const float dt = 1.0f / 60.0f;
+
+	std::vector<double> frameMs, latencyFrames;
+	for ( int frame = 0; frame < frames; frame++ ) {
+		glm::vec2 toTarget = playerTarget - player;
+		if ( glm::length( toTarget ) < 0.5f ) playerTarget = randomPlayerTarget();
+		else player += toTarget / glm::length( toTarget ) * std::min( 8.0f * dt, glm::length( toTarget ) );
+
+		BenchTimer timer;
+		for ( int i = 0; i < AGENT_COUNT; i++ ) {
+			const bool routine = ( frame + i ) % REPATH_INTERVAL == 0;
+			const bool playerMoved = glm::length( player - requestedGoal[ i ] ) > 2.0f;
+			if ( service.getStatus( i ) != PathStatus::Pending && ( routine || playerMoved ) ) {
+				service.requestPath( i, archetypeOf[ i ], positions[ i ], player );
+				requestedGoal[ i ] = player;
+				requestFrame[ i ] = frame;
+				nextWaypoint[ i ] = 1;
+			}
+		}
+		service.update( budgetMs );
+		frameMs.push_back( timer.elapsedMs() );
+
+		// Agents follow their paths at 5 tiles per second; latency counts frames until a request is answered.
+		for ( int i = 0; i < AGENT_COUNT; i++ ) {
+			PathStatus status = service.getStatus( i );
+			if ( requestFrame[ i ] >= 0 && status != PathStatus::Pending ) {
+				latencyFrames.push_back( frame - requestFrame[ i ] );
+				requestFrame[ i ] = -1;
+			}
+
+			const std::vector<NavWaypoint>& path = service.getPath( i );
+			if ( nextWaypoint[ i ] >= path.size() ) continue;
+			glm::vec2 toNext = path[ nextWaypoint[ i ] ].position - positions[ i ];
+			const float step = 5.0f * dt;
+			if ( glm::length( toNext ) <= step ) positions[ i ] = path[ nextWaypoint[ i ]++ ].position;
+			else positions[ i ] += toNext / glm::length( toNext ) * step;
+		}
+	}
+	PathStats stats = service.getStats();
+
+	// Naive comparison: a fresh service, every agent does a full synchronous search every frame.
+	PathService naive( map );
+	naive.addArchetype( walker );
+	naive.addArchetype( leaper );
+	naive.addArchetype( flyer );
+	std::vector<double> naiveMs;
+	for ( int frame = 0; frame < 10; frame++ ) {
+		const glm::vec2 goal = randomPlayerTarget();
+		BenchTimer timer;
+		for ( int i = 0; i < AGENT_COUNT; i++ ) naive.requestPath( frame * AGENT_COUNT + i, archetypeOf[ i ], positions[ i ], goal );
+		naive.update( 1e9 );
+		naiveMs.push_back( timer.elapsedMs() );
+	}
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_navigation_bench" ) );
+	json.value( "agents", static_cast< uint64_t >( AGENT_COUNT ) );
+	json.value( "frames", static_cast< uint64_t >( frames ) );
+	json.value( "budget_ms", budgetMs );
+	json.value( "workers", static_cast< uint64_t >( JobSystem::getInstance().getWorkerCount() ) );
+	json.beginArray( "graphs" );
+	const char* names[] = { "walker", "leaper", "flyer" };
+	for ( int a = 0; a < 3; a++ ) {
+		json.beginObject();
+		json.value( "archetype", std::string( names[ a ] ) );
+		json.value( "nodes", static_cast< uint64_t >( service.getGraph( a ).getNodeCount() ) );
+		json.value( "edges", static_cast< uint64_t >( service.getGraph( a ).getEdgeCount() ) );
+		json.value( "build_ms", buildMs[ a ] );
+		json.endObject();
+	}
+	json.endArray();
+	json.value( "frame_ms", computePercentiles( frameMs ) );
+	json.value( "latency_frames", computePercentiles( latencyFrames ) );
+	json.value( "requests", stats.requests );
+	json.value( "cache_hits", stats.cacheHits );
+	json.value( "cache_hit_rate", stats.requests ? static_cast< double >( stats.cacheHits ) / stats.requests : 0.0 );
+	json.value( "partial_repaths", stats.partialRepaths );
+	json.value( "searches_completed", stats.completed );
+	json.value( "searches_failed", stats.failed );
+	json.value( "expansions", stats.expansions );
+	json.value( "naive_full_astar_frame_ms", computePercentiles( naiveMs ) );
+	json.endObject();
+
+	JobSystem::getInstance().shutdown();
+	return stats.completed > 0 ? 0 : 1;
+}
@@ -0,0 +1,273 @@
+// Headless physics benchmark.
+//
+// Runs representative game scenes through PhysicsWorld and reports per-step
+// b2Profile breakdowns, wall time and heap allocations as JSON, so changes to
+// Box2D or to our wrapper can be compared run against run. Also checks that
+// one-way platforms let a body rise through from below and hold one landing
+// on them, and that a dropping body falls through.
+//
+// Usage: arcantha_physics_bench [--steps N] [--warmup N] [--scene NAME] [--out FILE]
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Physics.h"
+#include "TileMap.h"
+#include "bench_common.h"
+
+struct Scene
+{
+	const char* name;
+	std::function<void( PhysicsWorld& )> setup; // Builds the scene.
+	std::function<void( PhysicsWorld&, int )> tick; // Game logic run before every step.
+};
+
+// A room with outer walls, a few ledges and a pit, roughly what a combat room looks like.
+static TileMap buildRoom( int width, int height ) {
+	TileMap map( width, height, 1.0f );
+	map.fill( 0, 0, width, 2, Tile::Solid );
+	map.fill( 0, 0, 2, height, Tile::Solid );
+	map.fill( width - 2, 0, 2, height, Tile::Solid );
+	map.fill( 0, height - 2, width, 2, Tile::Solid );
+
+	for ( int i = 0; i < 6; i++ ) {
+		int x = 6 + i * ( width - 12 ) / 6;
+		int y = 6 + ( i % 3 ) * ( height - 10 ) / 4;
+		map.fill( x, y, 8, 1, ( i % 2 ) ? Tile::Platform : Tile::Solid );
+	}
+	map.fill( width / 2 - 3, 2, 6, 3, Tile::Solid );
+	return map;
+}
+
+static BodyParams enemyParams( float x, float y ) {
+	BodyParams params;
+	params.position = b2Vec2( x, y );
+	params.category = CATEGORY_ENEMY;
+	params.fixedRotation = true;
+	return params;
+}
+
+static std::vector<Scene> makeScenes() {
+	std::vector<Scene> scenes;
+
+	scenes.push_back( { "tile_room",
+		[]( PhysicsWorld& world ) {
+			TileMap map = buildRoom( 96, 54 );
+			world.createStaticTiles( map );
+
+			for ( int i = 0; i < 150; i++ ) {
+				BodyParams crate;
+				crate.position = b2Vec2( 4.0f + ( i % 30 ) * 2.9f, 20.0f + ( i / 30 ) * 3.0f );
+				world.createBox( crate, 0.45f, 0.45f );
+			}
+			for ( int i = 0; i < 20; i++ ) world.createBox( enemyParams( 5.0f + i * 4.3f, 40.0f ), 0.4f, 0.9f );
+		},
+		[]( PhysicsWorld& world, int step ) {
+			// Walking enemies pace back and forth.
+			float dir = ( step / 120 ) % 2 ? -1.0f : 1.0f;
+			for ( b2Body* body : world.getBodies() ) {
+				if ( !body->IsFixedRotation() ) continue;
+				b2Vec2 v = body->GetLinearVelocity();
+				body->SetLinearVelocity( b2Vec2( 4.0f * dir, v.y ) );
+			}
+		} } );
+
+	scenes.push_back( { "enemy_swarm",
+		[]( PhysicsWorld& world ) {
+			TileMap map = buildRoom( 128, 64 );
+			world.createStaticTiles( map );
+
+			for ( int i = 0; i < 500; i++ ) {
+				world.createCircle( enemyParams( 4.0f + ( i % 50 ) * 2.4f, 10.0f + ( i / 50 ) * 4.5f ), 0.4f );
+			}
+		},
+		[]( PhysicsWorld& world, int ) {
+			// Everyone chases a player standing in the middle of the room.
+			const b2Vec2 player( 64.0f, 8.0f );
+			for ( b2Body* body : world.getBodies() ) {
+				if ( body->GetType() != b2_dynamicBody ) continue;
+				b2Vec2 toPlayer = player - body->GetPosition();
+				toPlayer.Normalize();
+				body->ApplyForceToCenter( 25.0f * body->GetMass() * toPlayer, true );
+			}
+		} } );
+
+	// Projectiles are tracked outside the world so they can be expired in spawn order.
+	static std::deque<std::pair<int, b2Body*>> projectiles;
+	scenes.push_back( { "projectile_storm",
+		[]( PhysicsWorld& world ) {
+			projectiles.clear();
+			TileMap map = buildRoom( 96, 54 );
+			world.createStaticTiles( map );
+
+			for ( int i = 0; i < 60; i++ ) world.createBox( enemyParams( 6.0f + ( i % 20 ) * 4.2f, 12.0f + ( i / 20 ) * 12.0f ), 0.4f, 0.9f );
+		},
+		[]( PhysicsWorld& world, int step ) {
+			while ( !projectiles.empty() && step - projectiles.front().first > 45 ) {
+				world.destroyBody( projectiles.front().second );
+				projectiles.pop_front();
+			}
+
+			for ( int i = 0; i < 40; i++ ) {
+				float angle = ( step * 40 + i ) * 0.1617f;
+				BodyParams bolt;
+				bolt.position = b2Vec2( 48.0f, 27.0f );
+				bolt.category = CATEGORY_PROJECTILE;
+				bolt.mask = CATEGORY_TILES | CATEGORY_ENEMY;
+				bolt.bullet = true;
+				bolt.gravityScale = 0.0f;
+				bolt.density = 0.2f;
+				b2Body* body = world.createCircle( bolt, 0.1f );
+				body->SetLinearVelocity( b2Vec2( 40.0f * std::cos( angle ), 40.0f * std::sin( angle ) ) );
+				projectiles.emplace_back( step, body );
+			}
+		} } );
+
+	return scenes;
+}
+
+static void runScene( const Scene& scene, int warmup, int steps, JsonWriter& json ) {
+	PhysicsWorld world;
+	scene.setup( world );
+
+	for ( int i = 0; i < warmup; i++ ) {
+		scene.tick( world, i );
+		world.stepFixed();
+	}
+
+	std::vector<double> wall, stepMs, collide, solve, solveInit, solveVelocity, solvePosition, broadphase, solveTOI, allocs;
+	uint64_t contactTotal = 0;
+	const AllocationStats allocBefore = getAllocationStats();
+
+	for ( int i = warmup; i < warmup + steps; i++ ) {
+		scene.tick( world, i );
+
+		const uint64_t allocsBefore = getAllocationStats().count;
+		BenchTimer timer;
+		world.stepFixed();
+		wall.push_back( timer.elapsedMs() );
+		allocs.push_back( static_cast< double >( getAllocationStats().count - allocsBefore ) );
+
+		const b2Profile& profile = world.getProfile();
+		stepMs.push_back( profile.step );
+		collide.push_back( profile.collide );
+		solve.push_back( profile.solve );
+		solveInit.push_back( profile.solveInit );
+		solveVelocity.push_back( profile.solveVelocity );
+		solvePosition.push_back( profile.solvePosition );
+		broadphase.push_back( profile.broadphase );
+		solveTOI.push_back( profile.solveTOI );
+		contactTotal += world.getWorld().GetContactCount();
+	}
+
+	const AllocationStats allocAfter = getAllocationStats();
+
+	json.beginObject();
+	json.value( "scene", std::string( scene.name ) );
+	json.value( "steps", static_cast< uint64_t >( steps ) );
+	json.value( "bodies", static_cast< uint64_t >( world.getWorld().GetBodyCount() ) );
+	json.value( "proxies", static_cast< uint64_t >( world.getWorld().GetProxyCount() ) );
+	json.value( "avg_contacts", static_cast< double >( contactTotal ) / steps );
+	json.value( "wall_ms", computePercentiles( wall ) );
+	json.beginObject( "profile_ms" );
+	json.value( "step", computePercentiles( stepMs ) );
+	json.value( "collide", computePercentiles( collide ) );
+	json.value( "broadphase", computePercentiles( broadphase ) );
+	json.value( "solve", computePercentiles( solve ) );
+	json.value( "solve_init", computePercentiles( solveInit ) );
+	json.value( "solve_velocity", computePercentiles( solveVelocity ) );
+	json.value( "solve_position", computePercentiles( solvePosition ) );
+	json.value( "solve_toi", computePercentiles( solveTOI ) );
+	json.endObject();
+	json.value( "allocs_per_step", computePercentiles( allocs ) );
+	json.value( "total_allocs", allocAfter.count - allocBefore.count );
+	json.value( "total_alloc_bytes", allocAfter.bytes - allocBefore.bytes );
+	json.endObject();
+}
+
+/**
+ * @brief Steps a body onto a one-way platform at y = 5 and reports where it ends up.
+ * @param startY Where the body's center starts.
+ * @param velocityY Its initial vertical velocity.
+ * @param dropping Whether it is marked as dropping through platforms.
+ * @return The body's center after two seconds.
+ */
+static float settleOnPlatform( float startY, float velocityY, bool dropping ) {
+	TileMap map( 12, 12, 1.0f );
+	map.fill( 0, 0, 12, 1, Tile::Solid );
+	map.fill( 2, 4, 8, 1, Tile::Platform );
+	PhysicsWorld world;
+	world.createStaticTiles( map );
+	BodyParams params = enemyParams( 6.0f, startY );
+	b2Body* body = world.createBox( params, 0.4f, 0.4f );
+	body->SetLinearVelocity( b2Vec2( 0.0f, velocityY ) );
+	world.setDroppingThrough( body, dropping );
+	for ( int i = 0; i < 120; i++ ) world.stepFixed();
+	return body->GetPosition().y;
+}
+
+int main( int argc, char** argv ) {
+	int steps = 600;
+	int warmup = 60;
+	std::string only, outPath;
+
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--steps" ) ) steps = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--warmup" ) ) warmup = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--scene" ) ) only = argv[ i + 1 ];
+		else if ( !std::strcmp( argv[ i ], "--out" ) ) outPath = argv[ i + 1 ];
+	}
+	if ( steps <= 0 ) {
+		std::cerr << "Err: --steps must be positive." << std::endl;
+		return 1;
+	}
+
+	std::ofstream file;
+	if ( !outPath.empty() ) {
+		file.open( outPath );
+		if ( !file ) {
+			std::cerr << "Err: Failure to open " << outPath << std::endl;
+			return 1;
+		}
+	}
+	JsonWriter json( outPath.empty() ? std::cout : file );
+
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_physics_bench" ) );
+	json.value( "box2d_version", std::to_string( b2_version.major ) + "." + std::to_string( b2_version.minor ) + "." + std::to_string( b2_version.revision ) );
+	// Rising from the floor at 15 m/s clears the platform top at y = 5 and lands on it; resting leaves the center at 5.4.
+	const float risen = settleOnPlatform( 1.5f, 15.0f, false );
+	const float landed = settleOnPlatform( 8.0f, 0.0f, false );
+	const float dropped = settleOnPlatform( 8.0f, 0.0f, true );
+	const bool passesFromBelow = std::fabs( risen - 5.4f ) < 0.05f;
+	const bool holdsFromAbove = std::fabs( landed - 5.4f ) < 0.05f;
+	const bool dropsThrough = dropped < 2.0f;
+	json.beginObject( "one_way_platforms" );
+	json.value( "rising_body_y", static_cast< double >( risen ) );
+	json.value( "landing_body_y", static_cast< double >( landed ) );
+	json.value( "dropping_body_y", static_cast< double >( dropped ) );
+	json.value( "passes_from_below", passesFromBelow );
+	json.value( "holds_from_above", holdsFromAbove );
+	json.value( "drops_through", dropsThrough );
+	json.endObject();
+	json.beginArray( "scenes" );
+	for ( const Scene& scene : makeScenes() ) {
+		if ( !only.empty() && only != scene.name ) continue;
+		runScene( scene, warmup, steps, json );
+	}
+	json.endArray();
+	json.endObject();
+
+	if ( !passesFromBelow || !holdsFromAbove || !dropsThrough ) {
+		std::cerr << "Err: One-way platforms did not let a body through from below, hold it from above or let it drop." << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,164 @@
+// Post-processing benchmark.
+//
+// Compiles the post-processing chain for every quality preset at 720p, 1080p
+// and 1440p and reports its passes (one draw each), shaded pixels, estimated
+// memory traffic and target memory, next to a naive chain: bright pass,
+// separable Gaussian blurs and the bloom add, grading and vignette as
+// separate full-resolution passes over a 16-bit float scene. Memory traffic
+// is what bounds post-processing on integrated GPUs, so it is the cost each
+// preset is held to. Then replays 600 frames of render target requests
+// through the RenderTargetPool, with a resize at frame 200 and a preset
+// change at frame 400, and reports how many targets were created, reused
+// and evicted against allocating every target every frame. Headless, so no
+// GPU time is measured; PostProcess reports that per pass in the game.
+// Reports JSON.
+//
+// Usage: arcantha_postprocess_bench [--frames N]
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "PostProcess.h"
+#include "bench_common.h"
+
+static const char* QUALITY_NAMES[ 4 ] = { "off", "low", "medium", "high" };
+
+/**
+ * @brief Cost of a chain at one size.
+ */
+struct ChainCost
+{
+	uint32_t passes = 0;
+	uint64_t fragments = 0;
+	uint64_t bytes = 0;
+	uint64_t targetBytes = 0; // Intermediate targets, including the scene.
+};
+
+/**
+ * @brief Costs the naive chain with as many blur iterations as the preset has bloom mips to get a comparable radius.
+ */
+static ChainCost naiveCost( int width, int height, PostQuality quality ) {
+	const uint64_t pixels = static_cast< uint64_t >( width ) * height;
+	const uint64_t hdr = 8; // Rgba16F.
+	const int blurs = quality == PostQuality::Off ? 0 : quality == PostQuality::Low ? 2 : quality == PostQuality::Medium ? 3 : 4;
+	ChainCost cost;
+	const auto pass = [ & ]( uint64_t readBytes, uint64_t writeBytes ) {
+		cost.passes++;
+		cost.fragments += pixels;
+		cost.bytes += pixels * ( readBytes + writeBytes );
+	};
+	cost.targetBytes = pixels * hdr;
+	if ( blurs > 0 ) {
+		pass( hdr, hdr ); // Bright pass.
+		for ( int i = 0; i < blurs; i++ ) {
+			pass( hdr, hdr ); // Horizontal.
+			pass( hdr, hdr ); // Vertical.
+		}
+		pass( 2 * hdr, hdr ); // Bloom add.
+		cost.targetBytes += 3 * pixels * hdr; // Bright, ping and pong.
+	}
+	if ( quality != PostQuality::Off ) {
+		pass( hdr, hdr ); // Grading.
+		cost.targetBytes += pixels * hdr;
+	}
+	if ( quality == PostQuality::Medium || quality == PostQuality::High ) pass( hdr, hdr ); // Vignette.
+	pass( hdr, 4 ); // Tone map to the screen.
+	return cost;
+}
+
+static ChainCost planCost( const PostPlan& plan ) {
+	ChainCost cost;
+	cost.passes = static_cast< uint32_t >( plan.passes.size() );
+	cost.fragments = plan.fragments;
+	cost.bytes = plan.bytes;
+	for ( const RenderTargetDesc& target : plan.targets ) {
+		cost.targetBytes += static_cast< uint64_t >( target.width ) * target.height * RenderTargetPool::bytesPerPixel( target.format );
+	}
+	return cost;
+}
+
+static void writeCost( JsonWriter& json, const char* key, const ChainCost& cost ) {
+	json.beginObject( key );
+	json.value( "passes", static_cast< uint64_t >( cost.passes ) );
+	json.value( "megapixels", static_cast< double >( cost.fragments ) / 1e6 );
+	json.value( "traffic_mb", static_cast< double >( cost.bytes ) / ( 1024.0 * 1024.0 ) );
+	json.value( "target_mb", static_cast< double >( cost.targetBytes ) / ( 1024.0 * 1024.0 ) );
+	json.endObject();
+}
+
+int main( int argc, char** argv ) {
+	int frames = 600;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--frames" ) ) frames = std::atoi( argv[ i + 1 ] );
+	}
+	if ( frames <= 0 ) frames = 1;
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_postprocess_bench" ) );
+	json.value( "frames", static_cast< uint64_t >( frames ) );
+
+	const int sizes[ 3 ][ 2 ] = { { 1280, 720 }, { 1920, 1080 }, { 2560, 1440 } };
+	bool cheaper = true;
+	json.beginArray( "presets" );
+	for ( const auto& size : sizes ) {
+		for ( int q = 0; q < 4; q++ ) {
+			const PostQuality quality = static_cast< PostQuality >( q );
+			const PostPlan plan = PostProcess::buildPlan( size[ 0 ], size[ 1 ], PostProcess::settingsFor( quality ) );
+			const ChainCost chain = planCost( plan ), naive = naiveCost( size[ 0 ], size[ 1 ], quality );
+			cheaper = cheaper && chain.bytes <= naive.bytes;
+			json.beginObject();
+			json.value( "width", static_cast< uint64_t >( size[ 0 ] ) );
+			json.value( "height", static_cast< uint64_t >( size[ 1 ] ) );
+			json.value( "quality", std::string( QUALITY_NAMES[ q ] ) );
+			writeCost( json, "chain", chain );
+			writeCost( json, "naive", naive );
+			json.endObject();
+		}
+	}
+	json.endArray();
+
+	// Replay the chain's target requests: the scene and every bloom mip, acquired and released each frame.
+	RenderTargetPool pool;
+	PostQuality quality = PostQuality::Medium;
+	PostPlan plan = PostProcess::buildPlan( 1920, 1080, PostProcess::settingsFor( quality ) );
+	std::vector<int> handles;
+	std::vector<double> frameMs;
+	uint64_t unpooled = 0, peakBytes = 0;
+	for ( int frame = 0; frame < frames; frame++ ) {
+		BenchTimer timer;
+		if ( frame == frames / 3 ) plan = PostProcess::buildPlan( 1280, 720, PostProcess::settingsFor( quality ) );
+		if ( frame == frames * 2 / 3 ) {
+			quality = PostQuality::High;
+			plan = PostProcess::buildPlan( 1280, 720, PostProcess::settingsFor( quality ) );
+		}
+		handles.clear();
+		for ( const RenderTargetDesc& target : plan.targets ) handles.push_back( pool.acquire( target ) );
+		for ( int handle : handles ) pool.release( handle );
+		pool.endFrame();
+		frameMs.push_back( timer.elapsedMs() );
+		unpooled += plan.targets.size();
+		peakBytes = std::max( peakBytes, pool.getStats().bytes );
+	}
+	const RenderTargetPoolStats& poolStats = pool.getStats();
+
+	json.beginObject( "pool" );
+	json.value( "frame_ms", computePercentiles( frameMs ) );
+	json.value( "created", poolStats.created );
+	json.value( "reused", poolStats.reused );
+	json.value( "evicted", poolStats.evicted );
+	json.value( "targets", static_cast< uint64_t >( poolStats.targets ) );
+	json.value( "peak_mb", static_cast< double >( peakBytes ) / ( 1024.0 * 1024.0 ) );
+	json.value( "final_mb", static_cast< double >( poolStats.bytes ) / ( 1024.0 * 1024.0 ) );
+	json.value( "unpooled_allocations", unpooled );
+	json.endObject();
+	json.value( "chain_cheaper", cheaper );
+	json.endObject();
+
+	if ( !cheaper ) std::cerr << "Err: A preset's chain moves more memory than the naive chain." << std::endl;
+	return cheaper ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+// Query throughput benchmark.
+//
+// Issues one tick's worth of AI and combat queries (line of sight, ledge
+// probes, hitscan rays and area overlaps) against a 500-enemy room, first
+// through b2World::RayCast/QueryAABB one call at a time and then through the
+// batched QueryService, and reports queries per millisecond as JSON. Also
+// checks the service's tile overlap flags against the tiles themselves.
+//
+// Usage: arcantha_query_bench [--frames N] [--threads N]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Physics.h"
+#include "PhysicsQuery.h"
+#include "TileMap.h"
+#include "bench_common.h"
+
+// Closest-hit callback equivalent to QueryService's ray semantics.
+class ClosestRayCallback : public b2RayCastCallback
+{
+public:
+	uint16_t mask = CATEGORY_ALL;
+	float fraction = 1.0f;
+
+	float ReportFixture( b2Fixture* fixture, const b2Vec2&, const b2Vec2&, float f ) override {
+		if ( !( fixture->GetFilterData().categoryBits & mask ) || fixture->IsSensor() ) return -1.0f;
+		fraction = f;
+		return f;
+	}
+};
+
+class CountAabbCallback : public b2QueryCallback
+{
+public:
+	uint16_t mask = CATEGORY_ALL;
+	size_t count = 0;
+
+	bool ReportFixture( b2Fixture* fixture ) override {
+		if ( fixture->GetFilterData().categoryBits & mask ) count++;
+		return true;
+	}
+};
+
+/**
+ * @brief Reference tile overlap: does the box overlap the interior of any solid tile?
+ */
+static bool touchesSolidTile( const TileMap& map, const b2AABB& box ) {
+	const float size = map.getTileSize();
+	for ( int y = 0; y < map.getHeight(); y++ ) {
+		for ( int x = 0; x < map.getWidth(); x++ ) {
+			if ( map.isSolid( x, y ) && box.lowerBound.x < ( x + 1 ) * size && box.upperBound.x > x * size &&
+				box.lowerBound.y < ( y + 1 ) * size && box.upperBound.y > y * size ) return true;
+		}
+	}
+	return false;
+}
+
+static TileMap buildRoom( int width, int height ) {
+	TileMap map( width, height, 1.0f );
+	map.fill( 0, 0, width, 2, Tile::Solid );
+	map.fill( 0, 0, 2, height, Tile::Solid );
+	map.fill( width - 2, 0, 2, height, Tile::Solid );
+	map.fill( 0, height - 2, width, 2, Tile::Solid );
+	for ( int i = 0; i < 10; i++ ) map.fill( 8 + i * 11, 8 + ( i % 4 ) * 10, 7, 2, Tile::Solid );
+	return map;
+}
+
+int main( int argc, char** argv ) {
+	int frames = 30;
+	int threads = -1;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--frames" ) ) frames = std::max( 1, std::atoi( argv[ i + 1 ] ) );
+		else if ( !std::strcmp( argv[ i ], "--threads" ) ) threads = std::atoi( argv[ i + 1 ] );
+	}
+
+	TileMap map = buildRoom( 128, 56 );
+	PhysicsWorld world;
+	world.createStaticTiles( map );
+
+	std::vector<b2Body*> enemies;
+	for ( int i = 0; i < 500; i++ ) {
+		BodyParams params;
+		params.position = b2Vec2( 4.0f + ( i % 50 ) * 2.4f, 4.0f + ( i / 50 ) * 5.0f );
+		params.fixedRotation = true;
+		enemies.push_back( world.createBox( params, 0.4f, 0.9f ) );
+	}
+	BodyParams playerParams;
+	playerParams.position = b2Vec2( 64.0f, 30.0f );
+	playerParams.category = CATEGORY_PLAYER;
+	world.createBox( playerParams, 0.4f, 0.9f );
+	for ( int i = 0; i < 120; i++ ) world.stepFixed();
+
+	// One tick of queries.
+	const b2Vec2 player( 64.0f, 30.0f );
+	std::vector<RayQuery> rays;
+	std::vector<AabbQuery> boxes;
+	for ( size_t i = 0; i < enemies.size(); i++ ) {
+		b2Vec2 p = enemies[ i ]->GetPosition();
+		for ( int k = 0; k < 4; k++ ) rays.push_back( { p, player + b2Vec2( 0.0f, k * 0.4f - 0.6f ), CATEGORY_TILES | CATEGORY_PLAYER } );
+		rays.push_back( { p + b2Vec2( 0.6f, 0.0f ), p + b2Vec2( 0.6f, -2.0f ), CATEGORY_TILES } );
+		rays.push_back( { p + b2Vec2( -0.6f, 0.0f ), p + b2Vec2( -0.6f, -2.0f ), CATEGORY_TILES } );
+	}
+	for ( int i = 0; i < 1000; i++ ) {
+		float angle = i * 0.0628f;
+		rays.push_back( { player, player + b2Vec2( 60.0f * std::cos( angle ), 60.0f * std::sin( angle ) ), CATEGORY_TILES | CATEGORY_ENEMY } );
+	}
+	for ( int i = 0; i < 1000; i++ ) {
+		b2Vec2 c( 6.0f + ( i * 37 ) % 116, 4.0f + ( i * 53 ) % 48 );
+		AabbQuery query;
+		query.box.lowerBound = c - b2Vec2( 3.0f, 3.0f );
+		query.box.upperBound = c + b2Vec2( 3.0f, 3.0f );
+		query.mask = CATEGORY_ENEMY;
+		boxes.push_back( query );
+	}
+	const double queryCount = static_cast< double >( rays.size() + boxes.size() );
+
+	// Baseline: one virtual-callback world query per request.
+	std::vector<float> baselineFractions( rays.size() );
+	std::vector<double> baselineMs;
+	for ( int f = 0; f < frames; f++ ) {
+		BenchTimer timer;
+		for ( size_t i = 0; i < rays.size(); i++ ) {
+			ClosestRayCallback callback;
+			callback.mask = rays[ i ].mask;
+			world.getWorld().RayCast( &callback, rays[ i ].from, rays[ i ].to );
+			baselineFractions[ i ] = callback.fraction;
+		}
+		for ( const AabbQuery& query : boxes ) {
+			CountAabbCallback callback;
+			callback.mask = query.mask;
+			world.getWorld().QueryAABB( &callback, query.box );
+		}
+		baselineMs.push_back( timer.elapsedMs() );
+	}
+
+	// Batched service, first inline on one thread, then across the pool.
+	QueryService service( world );
+	service.setTileMap( &map );
+
+	auto runService = [ & ]( std::vector<double>& samples ) {
+		for ( int f = 0; f < frames; f++ ) {
+			service.clear();
+			BenchTimer timer;
+			service.submitRays( rays.data(), rays.size() );
+			service.submitAabbs( boxes.data(), boxes.size() );
+			service.execute();
+			samples.push_back( timer.elapsedMs() );
+		}
+	};
+
+	std::vector<double> serialMs, parallelMs;
+	runService( serialMs );
+
+	JobSystem::getInstance().init( threads );
+	runService( parallelMs );
+	const int workers = JobSystem::getInstance().getWorkerCount();
+	JobSystem::getInstance().shutdown();
+
+	std::vector<AabbQuery> tileBoxes = boxes;
+	for ( AabbQuery& query : tileBoxes ) query.mask = CATEGORY_TILES;
+	service.clear();
+	service.submitAabbs( tileBoxes.data(), tileBoxes.size() );
+	service.execute();
+	size_t tileMismatches = 0;
+	for ( size_t i = 0; i < tileBoxes.size(); i++ ) {
+		if ( service.getAabbResults()[ i ].touchesTiles != touchesSolidTile( map, tileBoxes[ i ].box ) ) tileMismatches++;
+	}
+	if ( tileMismatches ) std::cerr << "Err: " << tileMismatches << " AABB queries disagree with the tiles they cover." << std::endl;
+
+	// Tile hits come from the slab test instead of Box2D polygons; fractions should agree except for
+	// rays grazing an exact tile boundary or starting inside a tile, which the slab test reports as blocked.
+	size_t mismatches = 0;
+	for ( size_t i = 0; i < rays.size(); i++ ) {
+		float length = ( rays[ i ].to - rays[ i ].from ).Length();
+		if ( std::fabs( service.getRayHits()[ i ].fraction - baselineFractions[ i ] ) * length > 0.05f ) mismatches++;
+	}
+
+	Percentiles baseline = computePercentiles( baselineMs );
+	Percentiles serial = computePercentiles( serialMs );
+	Percentiles parallel = computePercentiles( parallelMs );
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_query_bench" ) );
+	json.value( "rays", static_cast< uint64_t >( rays.size() ) );
+	json.value( "aabbs", static_cast< uint64_t >( boxes.size() ) );
+	json.value( "workers", static_cast< uint64_t >( workers ) );
+	json.value( "b2world_ms", baseline );
+	json.value( "service_serial_ms", serial );
+	json.value( "service_parallel_ms", parallel );
+	json.value( "b2world_queries_per_ms", queryCount / baseline.p50 );
+	json.value( "service_serial_queries_per_ms", queryCount / serial.p50 );
+	json.value( "service_parallel_queries_per_ms", queryCount / parallel.p50 );
+	json.value( "service_reported_queries_per_ms", service.getStats().queriesPerMs );
+	json.value( "ray_mismatches", static_cast< uint64_t >( mismatches ) );
+	json.value( "tile_overlap_mismatches", static_cast< uint64_t >( tileMismatches ) );
+	json.endObject();
+
+	return mismatches * 200 <= rays.size() && !tileMismatches ? 0 : 1;
+}
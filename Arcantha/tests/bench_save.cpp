@@ -0,0 +1,278 @@
+// Save system benchmark and crash test.
+//
+// Saves a progression record plus three larger sections (world flags,
+// bestiary, map exploration) that change at different rates, as a game's
+// autosave would. Reports the game thread cost of save(), the writer thread
+// cost of each commit, bytes written per save against a full rewrite, load
+// time through mmap, and for comparison the cost of writing the same data
+// as text on the calling thread.
+//
+// The crash test forks a child that saves in a tight loop and reports every
+// committed generation through a pipe, SIGKILLs it at a random moment, then
+// loads the directory and checks that the save is intact, internally
+// consistent and no older than the last generation the child saw committed.
+// Reports JSON and fails if any check fails.
+//
+// Usage: arcantha_save_bench [--saves N] [--kills N] [--dir PATH]
+
+#ifndef _WIN32
+#include <signal.h> // Required for kill.
+#include <sys/wait.h> // Required for waitpid.
+#include <unistd.h> // Required for fork, pipe and usleep.
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Random.h"
+#include "SaveSystem.h"
+#include "bench_common.h"
+
+static const uint64_t STRIDE = 0x9E3779B97F4A7C15ull; // Element i of a section stamped s holds s + i * STRIDE.
+
+/**
+ * @brief The player's persistent progression.
+ */
+struct ProgressionRecord
+{
+	uint64_t souls;
+	uint32_t ancientRunes;
+	uint32_t gold;
+	uint64_t unlocks[ 4 ]; // Unlock bits.
+	uint64_t stamp; // Save counter when written.
+	uint64_t check; // Hash of the fields above.
+};
+
+static uint64_t progressionCheck( const ProgressionRecord& record ) {
+	uint64_t hash = 1469598103934665603ull;
+	for ( uint64_t word : { record.souls, static_cast< uint64_t >( record.ancientRunes ), static_cast< uint64_t >( record.gold ),
+		record.unlocks[ 0 ], record.unlocks[ 1 ], record.unlocks[ 2 ], record.unlocks[ 3 ], record.stamp } ) {
+		hash = ( hash ^ word ) * 1099511628211ull;
+	}
+	return hash;
+}
+
+/**
+ * @brief Everything that gets saved.
+ */
+struct SaveData
+{
+	PagedArray<ProgressionRecord> progression;
+	PagedArray<uint64_t> world; // Switches, doors and chests opened.
+	PagedArray<uint64_t> bestiary; // Kill counts and lore entries.
+	PagedArray<uint64_t> map; // Explored map cells.
+
+	SaveData() {
+		progression.resize( 1 );
+		world.resize( 32768 );
+		bestiary.resize( 8192 );
+		map.resize( 131072 );
+		for ( PagedArray<uint64_t>* section : { &world, &bestiary, &map } ) stampSection( *section, 0 );
+	}
+
+	void registerWith( SaveSystem& saves ) {
+		saves.registerSection( 0x474F5250, 1, &progression.getBuffer() ); // "PROG"
+		saves.registerSection( 0x444C5257, 1, &world.getBuffer() ); // "WRLD"
+		saves.registerSection( 0x54534542, 1, &bestiary.getBuffer() ); // "BEST"
+		saves.registerSection( 0x5850414D, 1, &map.getBuffer() ); // "MAPX"
+	}
+
+	// The progression changes every save, the other sections every 8, 32 and 64 saves.
+	void update( uint64_t stamp ) {
+		ProgressionRecord& record = progression.write( 0 );
+		record.souls = stamp * 37;
+		record.ancientRunes = static_cast< uint32_t >( stamp / 3 );
+		record.gold = static_cast< uint32_t >( stamp * 11 );
+		for ( int i = 0; i < 4; i++ ) record.unlocks[ i ] = stamp * STRIDE >> ( i * 8 );
+		record.stamp = stamp;
+		record.check = progressionCheck( record );
+		if ( stamp % 8 == 0 ) stampSection( world, stamp );
+		if ( stamp % 32 == 0 ) stampSection( bestiary, stamp );
+		if ( stamp % 64 == 0 ) stampSection( map, stamp );
+	}
+
+	static void stampSection( PagedArray<uint64_t>& section, uint64_t stamp ) {
+		for ( size_t i = 0; i < section.size(); i++ ) section.write( i ) = stamp + i * STRIDE;
+	}
+
+	// Every section must hold the data of one single stamp; a torn or mixed save fails.
+	bool isConsistent() const {
+		const ProgressionRecord& record = progression[ 0 ];
+		if ( record.check != progressionCheck( record ) ) return false;
+		for ( const PagedArray<uint64_t>* section : { &world, &bestiary, &map } ) {
+			const uint64_t stamp = ( *section )[ 0 ];
+			if ( stamp > record.stamp ) return false; // Newer than the progression saved with it.
+			for ( size_t i = 0; i < section->size(); i++ ) {
+				if ( ( *section )[ i ] != stamp + i * STRIDE ) return false;
+			}
+		}
+		return true;
+	}
+
+	size_t totalBytes() const {
+		return sizeof( ProgressionRecord ) + ( world.size() + bestiary.size() + map.size() ) * sizeof( uint64_t );
+	}
+};
+
+#ifndef _WIN32
+
+// Forks a saving child, kills it at a random moment and checks what is left on disk.
+static bool crashTest( const std::string& directory, int kills, uint64_t& maxGeneration ) {
+	Random random( 99 );
+	uint64_t stamp = 1;
+	for ( int kill = 0; kill < kills; kill++ ) {
+		int fds[ 2 ];
+		if ( pipe( fds ) != 0 ) return false;
+
+		const pid_t child = fork();
+		if ( child == 0 ) {
+			::close( fds[ 0 ] );
+			SaveData data;
+			SaveSystem saves;
+			data.registerWith( saves );
+			saves.open( directory );
+			saves.load();
+			uint64_t reported = saves.getCommittedGeneration();
+			for ( uint64_t s = stamp;; s++ ) {
+				data.update( s );
+				saves.save();
+				const uint64_t generation = saves.getCommittedGeneration();
+				if ( generation != reported ) {
+					reported = generation;
+					if ( ::write( fds[ 1 ], &reported, sizeof( reported ) ) != sizeof( reported ) ) _exit( 1 );
+				}
+				usleep( 200 ); // A frame's worth of gameplay between autosaves.
+			}
+		}
+		::close( fds[ 1 ] );
+
+		usleep( static_cast< useconds_t >( random.range( 1000, 60000 ) ) );
+		::kill( child, SIGKILL );
+		waitpid( child, nullptr, 0 );
+
+		uint64_t lastReported = 0, value = 0;
+		while ( read( fds[ 0 ], &value, sizeof( value ) ) == sizeof( value ) ) lastReported = value;
+		::close( fds[ 0 ] );
+
+		SaveData data;
+		SaveSystem saves;
+		data.registerWith( saves );
+		saves.open( directory );
+		const bool loaded = saves.load();
+		if ( lastReported > 0 && !loaded ) {
+			std::cerr << "Err: Kill " << kill << ": the save no longer loads." << std::endl;
+			return false;
+		}
+		if ( saves.getCommittedGeneration() < lastReported ) {
+			std::cerr << "Err: Kill " << kill << ": generation " << lastReported << " was committed but " << saves.getCommittedGeneration() << " loaded." << std::endl;
+			return false;
+		}
+		if ( loaded && !data.isConsistent() ) {
+			std::cerr << "Err: Kill " << kill << ": the loaded save is inconsistent." << std::endl;
+			return false;
+		}
+		maxGeneration = std::max( maxGeneration, saves.getCommittedGeneration() );
+		stamp = data.progression[ 0 ].stamp + 1; // The next child continues from the loaded progress.
+	}
+	return true;
+}
+
+#endif
+
+int main( int argc, char** argv ) {
+	int saveCount = 256;
+	int kills = 20;
+	std::string directory = ( std::filesystem::temp_directory_path() / "arcantha_save_bench" ).string();
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--saves" ) ) saveCount = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--kills" ) ) kills = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--dir" ) ) directory = argv[ i + 1 ];
+	}
+	if ( saveCount <= 0 ) saveCount = 1;
+	std::filesystem::remove_all( directory );
+
+	// Autosaves: game thread cost of save() and writer cost of each commit.
+	SaveData data;
+	std::vector<double> snapshotUs, writeMs;
+	SaveStats stats;
+	{
+		SaveSystem saves;
+		data.registerWith( saves );
+		if ( !saves.open( directory ) ) return 1;
+		for ( int i = 1; i <= saveCount; i++ ) {
+			data.update( static_cast< uint64_t >( i ) );
+			saves.save();
+			snapshotUs.push_back( saves.getStats().lastSnapshotUs );
+			saves.flush(); // One commit per save, so each write is measured on its own.
+			writeMs.push_back( saves.getStats().lastWriteMs );
+		}
+		stats = saves.getStats();
+	}
+
+	// Load into fresh sections through mmap.
+	SaveData loaded;
+	double loadMs = 0.0;
+	bool loadMatches = false;
+	{
+		SaveSystem saves;
+		loaded.registerWith( saves );
+		saves.open( directory );
+		BenchTimer timer;
+		const bool ok = saves.load();
+		loadMs = timer.elapsedMs();
+		loadMatches = ok && loaded.isConsistent() && loaded.progression[ 0 ].stamp == static_cast< uint64_t >( saveCount ) &&
+			loaded.map[ 1 ] == data.map[ 1 ] && loaded.world[ 5 ] == data.world[ 5 ];
+		if ( !loadMatches ) std::cerr << "Err: The loaded save does not match the saved data." << std::endl;
+	}
+
+	// Baseline: the same data written as text on the calling thread.
+	BenchTimer textTimer;
+	{
+		std::ofstream text( ( std::filesystem::path( directory ) / "baseline.txt" ).string() );
+		const ProgressionRecord& record = data.progression[ 0 ];
+		text << record.souls << " " << record.ancientRunes << " " << record.gold << "\n";
+		for ( const PagedArray<uint64_t>* section : { &data.world, &data.bestiary, &data.map } ) {
+			for ( size_t i = 0; i < section->size(); i++ ) text << ( *section )[ i ] << "\n";
+		}
+	}
+	const double textMs = textTimer.elapsedMs();
+	std::filesystem::remove( std::filesystem::path( directory ) / "baseline.txt" );
+
+	bool crashSafe = true;
+	uint64_t crashGenerations = 0;
+#ifndef _WIN32
+	if ( kills > 0 ) {
+		std::filesystem::remove_all( directory );
+		crashSafe = crashTest( directory, kills, crashGenerations );
+	}
+#else
+	kills = 0;
+#endif
+	std::filesystem::remove_all( directory );
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_save_bench" ) );
+	json.value( "saves", static_cast< uint64_t >( saveCount ) );
+	json.value( "save_bytes_full", static_cast< uint64_t >( data.totalBytes() ) );
+	json.value( "save_bytes_mean", static_cast< double >( stats.bytesWritten ) / saveCount );
+	json.value( "sections_written", stats.sectionsWritten );
+	json.value( "sections_skipped", stats.sectionsSkipped );
+	json.value( "snapshot_us", computePercentiles( snapshotUs ) );
+	json.value( "write_ms", computePercentiles( writeMs ) );
+	json.value( "load_ms", loadMs );
+	json.value( "load_matches", loadMatches );
+	json.value( "sync_text_ms", textMs );
+	json.value( "kills", static_cast< uint64_t >( kills ) );
+	json.value( "kill_generations", crashGenerations );
+	json.value( "crash_safe", crashSafe );
+	json.endObject();
+
+	return loadMatches && crashSafe ? 0 : 1;
+}
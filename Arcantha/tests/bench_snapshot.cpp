@@ -0,0 +1,142 @@
+// Snapshot benchmark for Acute Perception lookahead.
+//
+// Builds a full room (tiles, 500 enemies, crates, SoA component columns and a
+// few RNG streams), then measures capture and restore cost on the game thread
+// and runs a 2.5 second lookahead on a worker every frame while the "main
+// loop" keeps writing components. Verifies that restore reproduces the
+// captured state exactly. Reports JSON.
+//
+// Usage: arcantha_snapshot_bench [--frames N]
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Physics.h"
+#include "Random.h"
+#include "Snapshot.h"
+#include "TileMap.h"
+#include "bench_common.h"
+
+static const int ENTITY_COUNT = 4096; // Gameplay entities with SoA component columns.
+static const int COLUMN_COUNT = 16; // Component fields per entity.
+
+int main( int argc, char** argv ) {
+	int frames = 120;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--frames" ) ) frames = std::atoi( argv[ i + 1 ] );
+	}
+	if ( frames <= 0 ) frames = 1;
+
+	// Lookahead needs at least one worker to run beside the main loop.
+	JobSystem::getInstance().init( std::max( 1, static_cast< int >( std::thread::hardware_concurrency() ) - 1 ) );
+
+	TileMap map( 128, 64, 1.0f );
+	map.fill( 0, 0, 128, 2, Tile::Solid );
+	map.fill( 0, 0, 2, 64, Tile::Solid );
+	map.fill( 126, 0, 2, 64, Tile::Solid );
+	for ( int i = 0; i < 8; i++ ) map.fill( 10 + i * 14, 10 + ( i % 3 ) * 12, 8, 1, Tile::Solid );
+
+	PhysicsWorld world;
+	world.createStaticTiles( map );
+	for ( int i = 0; i < 500; i++ ) {
+		BodyParams params;
+		params.position = b2Vec2( 4.0f + ( i % 50 ) * 2.4f, 4.0f + ( i / 50 ) * 5.0f );
+		params.fixedRotation = true;
+		world.createCircle( params, 0.4f );
+	}
+	for ( int i = 0; i < 100; i++ ) {
+		BodyParams crate;
+		crate.position = b2Vec2( 5.0f + ( i % 25 ) * 4.7f, 50.0f + ( i / 25 ) * 2.0f );
+		crate.category = CATEGORY_PICKUP;
+		world.createBox( crate, 0.45f, 0.45f );
+	}
+
+	SnapshotRegistry registry;
+	std::vector<PagedArray<float>> columns( COLUMN_COUNT );
+	for ( PagedArray<float>& column : columns ) {
+		column.resize( ENTITY_COUNT );
+		registry.registerBuffer( &column.getBuffer() );
+	}
+	Random combatRng( 1 ), lootRng( 2 ), aiRng( 3 );
+	registry.registerRandom( &combatRng );
+	registry.registerRandom( &lootRng );
+	registry.registerRandom( &aiRng );
+
+	for ( int i = 0; i < 60; i++ ) world.stepFixed();
+
+	std::vector<double> captureMs, restoreMs, frameStallMs, lookaheadMs;
+	WorldSnapshot snapshot;
+	Lookahead lookahead;
+	bool restoredExactly = true;
+	BenchTimer ahead;
+	bool aheadRunning = false;
+
+	for ( int frame = 0; frame < frames; frame++ ) {
+		// The main loop dirties a small fraction of the components every frame.
+		for ( int i = 0; i < 64; i++ ) {
+			int entity = static_cast< int >( combatRng.nextU32() % ENTITY_COUNT );
+			columns[ i % COLUMN_COUNT ].write( entity ) += 1.0f;
+		}
+		world.stepFixed();
+
+		BenchTimer stall;
+		BenchTimer capture;
+		registry.capture( world, snapshot );
+		captureMs.push_back( capture.elapsedMs() );
+
+		// 150 steps at 60 Hz = 2.5 seconds ahead. A new run only starts once the
+		// previous one is done, so the main loop never blocks on it.
+		if ( lookahead.isDone() ) {
+			if ( aheadRunning ) lookaheadMs.push_back( ahead.elapsedMs() );
+			ahead.reset();
+			aheadRunning = true;
+			lookahead.start( world, snapshot, 150, []( LookaheadState& state, int ) {
+				state.buffers[ 0 ].write( state.randoms[ 0 ].nextU32() % ENTITY_COUNT );
+			} );
+		}
+		frameStallMs.push_back( stall.elapsedMs() );
+
+		if ( frame % 10 == 9 ) {
+
+			// Restore check: mutate, then restore and compare against the snapshot.
+			world.stepFixed();
+			columns[ 3 ].write( 7 ) = -1.0f;
+			combatRng.nextU64();
+
+			BenchTimer restore;
+			bool ok = registry.restore( snapshot, world );
+			restoreMs.push_back( restore.elapsedMs() );
+
+			PhysicsSnapshot check;
+			check.capture( world );
+			ok = ok && std::memcmp( check.bodies.data(), snapshot.physics.bodies.data(), check.bodies.size() * sizeof( BodyState ) ) == 0;
+			ok = ok && std::memcmp( &combatRng.getState(), &snapshot.randoms[ 0 ], sizeof( RandomState ) ) == 0;
+			ok = ok && columns[ 3 ][ 7 ] == *static_cast< const float* >( snapshot.buffers[ 3 ].read( 7 ) );
+			restoredExactly = restoredExactly && ok;
+		}
+	}
+	lookahead.wait();
+	lookaheadMs.push_back( ahead.elapsedMs() );
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_snapshot_bench" ) );
+	json.value( "bodies", static_cast< uint64_t >( world.getBodies().size() ) );
+	json.value( "component_bytes", static_cast< uint64_t >( ENTITY_COUNT ) * COLUMN_COUNT * sizeof( float ) );
+	json.value( "workers", static_cast< uint64_t >( JobSystem::getInstance().getWorkerCount() ) );
+	json.value( "capture_ms", computePercentiles( captureMs ) );
+	json.value( "restore_ms", computePercentiles( restoreMs ) );
+	json.value( "main_thread_stall_ms", computePercentiles( frameStallMs ) );
+	json.value( "lookahead_2_5s_ms", computePercentiles( lookaheadMs ) );
+	json.value( "restored_exactly", restoredExactly );
+	json.endObject();
+
+	JobSystem::getInstance().shutdown();
+	return restoredExactly ? 0 : 1;
+}
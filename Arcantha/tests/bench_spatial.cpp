@@ -0,0 +1,276 @@
+// Spatial grid benchmark.
+//
+// Scatters 50,000 entities over a 2 km by 500 m level: essence pickups in
+// clumps where enemies died, packs of enemies, and the player. Every tick the
+// entities move, the SpatialGrid is rebuilt, and three batches are run: area
+// spells (radius queries on enemies plus box queries for beams), the pickup
+// magnet around the player, and enemies looking for their nearest allies
+// (k-nearest queries). The same queries are answered by brute force over
+// every entity, and the answers must match exactly: the same sets for radius
+// and box queries, the same order for nearest queries. Reports rebuild and
+// query times for both, entities tested per query and the grid's occupancy.
+// Reports JSON.
+//
+// Usage: arcantha_spatial_bench [--entities N] [--frames N] [--threads N]
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Random.h"
+#include "SpatialGrid.h"
+#include "bench_common.h"
+
+static const float LEVEL_WIDTH = 2000.0f;
+static const float LEVEL_HEIGHT = 500.0f;
+static const float CELL_SIZE = 4.0f;
+static const uint32_t PICKUP = 1u;
+static const uint32_t ENEMY = 2u;
+static const uint32_t PLAYER = 4u;
+static const size_t SPELLS = 256; // Radius and box queries per tick.
+static const size_t ALLY_SEARCHES = 1024; // Nearest queries per tick.
+static const uint32_t ALLIES = 4;
+
+/**
+ * @brief A position near a center, roughly normally distributed.
+ */
+static glm::vec2 around( Random& random, const glm::vec2& center, float spread ) {
+	glm::vec2 offset( 0.0f );
+	for ( int i = 0; i < 3; i++ ) offset += glm::vec2( random.range( -spread, spread ), random.range( -spread, spread ) );
+	return center + offset / 3.0f;
+}
+
+/**
+ * @brief Brute-force answers in the grid's result layout.
+ */
+struct Reference
+{
+	std::vector<SpatialResult> results;
+	std::vector<uint32_t> ids;
+};
+
+static void bruteRadius( const std::vector<glm::vec2>& positions, const std::vector<uint32_t>& categories, const std::vector<RadiusQuery>& queries, Reference& out ) {
+	out.results.clear();
+	out.ids.clear();
+	for ( const RadiusQuery& query : queries ) {
+		SpatialResult result;
+		result.first = static_cast< uint32_t >( out.ids.size() );
+		for ( size_t i = 0; i < positions.size(); i++ ) {
+			const float dx = positions[ i ].x - query.center.x, dy = positions[ i ].y - query.center.y;
+			if ( ( categories[ i ] & query.mask ) && dx * dx + dy * dy <= query.radius * query.radius ) out.ids.push_back( static_cast< uint32_t >( i ) );
+		}
+		result.count = static_cast< uint32_t >( out.ids.size() ) - result.first;
+		out.results.push_back( result );
+	}
+}
+
+static void bruteBox( const std::vector<glm::vec2>& positions, const std::vector<uint32_t>& categories, const std::vector<BoxQuery>& queries, Reference& out ) {
+	out.results.clear();
+	out.ids.clear();
+	for ( const BoxQuery& query : queries ) {
+		SpatialResult result;
+		result.first = static_cast< uint32_t >( out.ids.size() );
+		for ( size_t i = 0; i < positions.size(); i++ ) {
+			const glm::vec2& p = positions[ i ];
+			if ( ( categories[ i ] & query.mask ) && p.x >= query.min.x && p.x <= query.max.x && p.y >= query.min.y && p.y <= query.max.y ) {
+				out.ids.push_back( static_cast< uint32_t >( i ) );
+			}
+		}
+		result.count = static_cast< uint32_t >( out.ids.size() ) - result.first;
+		out.results.push_back( result );
+	}
+}
+
+static void bruteNearest( const std::vector<glm::vec2>& positions, const std::vector<uint32_t>& categories, const std::vector<NearestQuery>& queries, Reference& out ) {
+	out.results.clear();
+	out.ids.clear();
+	std::vector<std::pair<float, uint32_t>> candidates;
+	for ( const NearestQuery& query : queries ) {
+		candidates.clear();
+		for ( size_t i = 0; i < positions.size(); i++ ) {
+			const float dx = positions[ i ].x - query.center.x, dy = positions[ i ].y - query.center.y;
+			const float distance = dx * dx + dy * dy;
+			if ( ( categories[ i ] & query.mask ) && distance <= query.maxRadius * query.maxRadius ) candidates.emplace_back( distance, static_cast< uint32_t >( i ) );
+		}
+		const size_t k = std::min( candidates.size(), static_cast< size_t >( query.k ) );
+		std::partial_sort( candidates.begin(), candidates.begin() + k, candidates.end() );
+		SpatialResult result;
+		result.first = static_cast< uint32_t >( out.ids.size() );
+		for ( size_t i = 0; i < k; i++ ) out.ids.push_back( candidates[ i ].second );
+		result.count = static_cast< uint32_t >( k );
+		out.results.push_back( result );
+	}
+}
+
+/**
+ * @brief Compares the grid's last batch with a reference, as sets or in order.
+ */
+static bool matches( const SpatialGrid& grid, const Reference& reference, bool ordered ) {
+	const std::vector<SpatialResult>& results = grid.getResults();
+	if ( results.size() != reference.results.size() ) return false;
+	std::vector<uint32_t> a, b;
+	for ( size_t i = 0; i < results.size(); i++ ) {
+		a.assign( grid.getIds().begin() + results[ i ].first, grid.getIds().begin() + results[ i ].first + results[ i ].count );
+		b.assign( reference.ids.begin() + reference.results[ i ].first, reference.ids.begin() + reference.results[ i ].first + reference.results[ i ].count );
+		if ( !ordered ) std::sort( a.begin(), a.end() );
+		if ( a != b ) return false;
+	}
+	return true;
+}
+
+int main( int argc, char** argv ) {
+	int entities = 50000;
+	int frames = 30;
+	int threads = -1;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--entities" ) ) entities = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--frames" ) ) frames = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--threads" ) ) threads = std::atoi( argv[ i + 1 ] );
+	}
+	if ( entities < 2 ) entities = 2;
+	if ( frames <= 0 ) frames = 1;
+
+	JobSystem& jobs = JobSystem::getInstance();
+	jobs.init( threads );
+	Random random( 45 );
+
+	// Entity 0 is the player; the rest are 20% enemies in packs and 80% pickups in clumps.
+	std::vector<glm::vec2> positions( entities ), velocities( entities, glm::vec2( 0.0f ) );
+	std::vector<uint32_t> categories( entities, PICKUP );
+	std::vector<uint32_t> enemies;
+	positions[ 0 ] = glm::vec2( LEVEL_WIDTH * 0.5f, LEVEL_HEIGHT * 0.5f );
+	categories[ 0 ] = PLAYER;
+	glm::vec2 pack( 0.0f ), clump( 0.0f );
+	for ( int i = 1; i < entities; i++ ) {
+		if ( i % 5 == 0 ) {
+			if ( enemies.size() % 12 == 0 ) pack = glm::vec2( random.range( 0.0f, LEVEL_WIDTH ), random.range( 0.0f, LEVEL_HEIGHT ) );
+			positions[ i ] = around( random, pack, 10.0f );
+			velocities[ i ] = glm::vec2( random.range( -3.0f, 3.0f ), random.range( -1.0f, 1.0f ) );
+			categories[ i ] = ENEMY;
+			enemies.push_back( static_cast< uint32_t >( i ) );
+		}
+		else {
+			if ( i == 1 ) clump = positions[ 0 ]; // Loot to magnetize right away.
+			else if ( i % 40 == 1 ) clump = glm::vec2( random.range( 0.0f, LEVEL_WIDTH ), random.range( 0.0f, LEVEL_HEIGHT ) );
+			positions[ i ] = around( random, clump, 2.0f );
+		}
+	}
+
+	SpatialGrid grid( glm::vec2( 0.0f ), glm::vec2( LEVEL_WIDTH, LEVEL_HEIGHT ), CELL_SIZE );
+	std::vector<RadiusQuery> radiusQueries;
+	std::vector<BoxQuery> boxQueries;
+	std::vector<NearestQuery> nearestQueries;
+	Reference reference;
+	std::vector<double> rebuildMs, gridMs, bruteMs;
+	uint64_t radiusTested = 0, boxTested = 0, nearestTested = 0, found = 0, occupied = 0, queries = 0;
+	bool correct = true;
+	const float dt = 1.0f / 60.0f;
+
+	for ( int frame = 0; frame < frames; frame++ ) {
+		positions[ 0 ] += glm::vec2( 6.0f * dt, 0.0f );
+		for ( uint32_t enemy : enemies ) positions[ enemy ] += velocities[ enemy ] * dt;
+
+		grid.rebuild( positions.data(), categories.data(), positions.size() );
+		rebuildMs.push_back( grid.getStats().rebuildMs );
+		occupied += grid.getStats().occupiedCells;
+
+		// Area spells land on random enemies; the last radius query is the pickup magnet.
+		radiusQueries.clear();
+		boxQueries.clear();
+		nearestQueries.clear();
+		for ( size_t i = 0; i < SPELLS; i++ ) {
+			const glm::vec2 target = positions[ enemies[ random.range( 0, static_cast< int >( enemies.size() ) - 1 ) ] ];
+			RadiusQuery blast;
+			blast.center = target;
+			blast.radius = random.range( 2.0f, 8.0f );
+			blast.mask = ENEMY;
+			radiusQueries.push_back( blast );
+			BoxQuery beam;
+			beam.min = target - glm::vec2( 12.0f, 0.75f );
+			beam.max = target + glm::vec2( 12.0f, 0.75f );
+			beam.mask = ENEMY;
+			boxQueries.push_back( beam );
+		}
+		RadiusQuery magnet;
+		magnet.center = positions[ 0 ];
+		magnet.radius = 6.0f;
+		magnet.mask = PICKUP;
+		radiusQueries.push_back( magnet );
+		for ( size_t i = 0; i < ALLY_SEARCHES; i++ ) {
+			NearestQuery allies;
+			allies.center = positions[ enemies[ ( frame * ALLY_SEARCHES + i ) % enemies.size() ] ];
+			allies.k = ALLIES + 1; // Includes the enemy itself.
+			allies.maxRadius = 40.0f;
+			allies.mask = ENEMY;
+			nearestQueries.push_back( allies );
+		}
+		queries += radiusQueries.size() + boxQueries.size() + nearestQueries.size();
+
+		double gridFrameMs = 0.0, bruteFrameMs = 0.0;
+		grid.queryRadius( radiusQueries.data(), radiusQueries.size() );
+		gridFrameMs += grid.getStats().queryMs;
+		radiusTested += grid.getStats().tested;
+		found += grid.getStats().found;
+		BenchTimer bruteTimer;
+		bruteRadius( positions, categories, radiusQueries, reference );
+		bruteFrameMs += bruteTimer.elapsedMs();
+		correct = correct && matches( grid, reference, false );
+
+		grid.queryBox( boxQueries.data(), boxQueries.size() );
+		gridFrameMs += grid.getStats().queryMs;
+		boxTested += grid.getStats().tested;
+		found += grid.getStats().found;
+		bruteTimer.reset();
+		bruteBox( positions, categories, boxQueries, reference );
+		bruteFrameMs += bruteTimer.elapsedMs();
+		correct = correct && matches( grid, reference, false );
+
+		grid.queryNearest( nearestQueries.data(), nearestQueries.size() );
+		gridFrameMs += grid.getStats().queryMs;
+		nearestTested += grid.getStats().tested;
+		found += grid.getStats().found;
+		bruteTimer.reset();
+		bruteNearest( positions, categories, nearestQueries, reference );
+		bruteFrameMs += bruteTimer.elapsedMs();
+		correct = correct && matches( grid, reference, true );
+
+		gridMs.push_back( gridFrameMs );
+		bruteMs.push_back( bruteFrameMs );
+	}
+	const int workers = jobs.getWorkerCount();
+	jobs.shutdown();
+
+	const double perFrame = 1.0 / frames;
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_spatial_bench" ) );
+	json.value( "entities", static_cast< uint64_t >( entities ) );
+	json.value( "enemies", static_cast< uint64_t >( enemies.size() ) );
+	json.value( "frames", static_cast< uint64_t >( frames ) );
+	json.value( "workers", static_cast< uint64_t >( workers ) );
+	json.value( "cells", static_cast< uint64_t >( grid.getStats().cells ) );
+	json.value( "occupied_cells", static_cast< double >( occupied ) * perFrame );
+	json.value( "queries_per_frame", static_cast< double >( queries ) * perFrame );
+	json.value( "found_per_frame", static_cast< double >( found ) * perFrame );
+	json.beginObject( "grid" );
+	json.value( "rebuild_ms", computePercentiles( rebuildMs ) );
+	json.value( "query_ms", computePercentiles( gridMs ) );
+	json.value( "tested_per_radius_query", static_cast< double >( radiusTested ) / ( frames * static_cast< double >( SPELLS + 1 ) ) );
+	json.value( "tested_per_box_query", static_cast< double >( boxTested ) / ( frames * static_cast< double >( SPELLS ) ) );
+	json.value( "tested_per_nearest_query", static_cast< double >( nearestTested ) / ( frames * static_cast< double >( ALLY_SEARCHES ) ) );
+	json.endObject();
+	json.beginObject( "brute_force" );
+	json.value( "query_ms", computePercentiles( bruteMs ) );
+	json.value( "tested_per_query", static_cast< double >( entities ) );
+	json.endObject();
+	json.value( "matches_brute_force", correct );
+	json.endObject();
+
+	if ( !correct ) std::cerr << "Err: The grid's results differ from the brute-force reference." << std::endl;
+	return correct ? 0 : 1;
+}
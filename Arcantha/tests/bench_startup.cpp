@@ -0,0 +1,174 @@
+// Startup benchmark.
+//
+// Models the game's startup as a StartupGraph of timed stand-ins for the
+// subsystem initializers: window and GL context creation, GL function
+// loading, texture and shader upload and input on the main thread; OpenAL
+// device opening, voice pool creation, archive mapping and indexing, save
+// file reading, shader cache loading and level loading on workers. Durations
+// are typical cold-start figures, scaled by --scale. The same tasks run once
+// one after another, the way Application::init used to, and once through
+// the graph; then the graph runs again with the audio device failing, where
+// only the voices may be skipped, and with a dependency cycle, where nothing
+// may run. Checks that every task started after its dependencies finished
+// and that main thread tasks ran on the main thread. Reports the time to the
+// first frame, the critical path and the per-task trace as JSON.
+//
+// Usage: arcantha_startup_bench [--threads N] [--scale X]
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Log.h"
+#include "StartupGraph.h"
+#include "bench_common.h"
+
+/**
+ * @brief A stand-in for one subsystem initializer.
+ */
+struct StartupStep
+{
+	const char* name;
+	StartupThread thread;
+	double ms; // Cold-start duration before scaling.
+	std::vector<std::string> dependencies;
+};
+
+static const std::vector<StartupStep> STEPS = {
+	{ "window", StartupThread::Main, 120.0, {} },
+	{ "gl_loader", StartupThread::Main, 20.0, { "window" } },
+	{ "input", StartupThread::Main, 1.0, { "window" } },
+	{ "audio_device", StartupThread::Worker, 180.0, {} },
+	{ "voices", StartupThread::Worker, 10.0, { "audio_device" } },
+	{ "archive_index", StartupThread::Worker, 90.0, {} },
+	{ "save_read", StartupThread::Worker, 60.0, {} },
+	{ "shader_cache", StartupThread::Worker, 70.0, {} },
+	{ "shaders", StartupThread::Main, 40.0, { "gl_loader", "shader_cache" } },
+	{ "textures", StartupThread::Main, 50.0, { "gl_loader", "archive_index" } },
+	{ "level", StartupThread::Worker, 80.0, { "archive_index", "save_read" } },
+};
+
+static void work( double ms ) {
+	std::this_thread::sleep_for( std::chrono::duration<double, std::milli>( ms ) );
+}
+
+/**
+ * @brief Adds the startup steps to a graph.
+ * @param failing A step that fails instead of sleeping, or nullptr.
+ */
+static void addSteps( StartupGraph& graph, double scale, const char* failing ) {
+	for ( const StartupStep& step : STEPS ) {
+		const double ms = step.ms * scale;
+		const bool fails = failing && !std::strcmp( failing, step.name );
+		graph.add( step.name, step.thread, [ ms, fails ]() {
+			if ( fails ) return false;
+			work( ms );
+			return true;
+		}, step.dependencies );
+	}
+}
+
+/**
+ * @brief Checks that every task started after its dependencies and main tasks ran on the main thread.
+ */
+static bool checkOrder( const StartupGraph& graph ) {
+	const std::vector<StartupTaskTrace>& trace = graph.getTrace();
+	for ( size_t i = 0; i < STEPS.size(); i++ ) {
+		if ( trace[ i ].status == StartupStatus::Succeeded && STEPS[ i ].thread == StartupThread::Main && trace[ i ].threadIndex != 0 ) return false;
+		for ( const std::string& dependency : STEPS[ i ].dependencies ) {
+			for ( const StartupTaskTrace& other : trace ) {
+				if ( other.name == dependency && trace[ i ].beginMs < other.endMs ) return false;
+			}
+		}
+	}
+	return true;
+}
+
+int main( int argc, char** argv ) {
+	int threads = 4;
+	double scale = 1.0;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--threads" ) ) threads = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--scale" ) ) scale = std::atof( argv[ i + 1 ] );
+	}
+	if ( threads < 0 ) threads = 0;
+	if ( scale <= 0.0 ) scale = 1.0;
+
+	LogSettings settings;
+	settings.console = false;
+	settings.crashHandlers = false;
+	Logger::getInstance().init( settings );
+	JobSystem& jobs = JobSystem::getInstance();
+	jobs.init( threads );
+
+	// One after another, in declaration order, then the first frame.
+	BenchTimer sequentialTimer;
+	for ( const StartupStep& step : STEPS ) work( step.ms * scale );
+	const double sequentialMs = sequentialTimer.elapsedMs();
+
+	StartupGraph graph;
+	addSteps( graph, scale, nullptr );
+	const bool allSucceeded = graph.run();
+	graph.markFirstFrame();
+	const bool ordered = checkOrder( graph );
+
+	StartupGraph failing;
+	addSteps( failing, scale, "audio_device" );
+	failing.run();
+	bool failureContained = checkOrder( failing );
+	for ( const StartupTaskTrace& entry : failing.getTrace() ) {
+		const StartupStatus expected = entry.name == "audio_device" ? StartupStatus::Failed :
+			entry.name == "voices" ? StartupStatus::Skipped : StartupStatus::Succeeded;
+		failureContained = failureContained && entry.status == expected;
+	}
+
+	StartupGraph cyclic;
+	bool ranInCycle = false;
+	cyclic.add( "a", StartupThread::Worker, [ &ranInCycle ]() { return ranInCycle = true; }, { "c" } );
+	cyclic.add( "b", StartupThread::Main, [ &ranInCycle ]() { return ranInCycle = true; }, { "a" } );
+	cyclic.add( "c", StartupThread::Worker, [ &ranInCycle ]() { return ranInCycle = true; }, { "b" } );
+	const bool cycleRejected = !cyclic.run() && !ranInCycle;
+
+	jobs.shutdown();
+	Logger::getInstance().shutdown();
+
+	const bool ok = allSucceeded && ordered && failureContained && cycleRejected;
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_startup_bench" ) );
+	json.value( "workers", static_cast< uint64_t >( threads ) );
+	json.value( "scale", scale );
+	json.value( "sequential_ms", sequentialMs );
+	json.value( "graph_ms", graph.getRunMs() );
+	json.value( "first_frame_ms", graph.getFirstFrameMs() );
+	json.value( "first_frame_budget_ms", StartupGraph::FIRST_FRAME_BUDGET_MS );
+	json.value( "within_budget", graph.getFirstFrameMs() <= StartupGraph::FIRST_FRAME_BUDGET_MS );
+	json.beginArray( "critical_path" );
+	for ( const std::string& name : graph.getCriticalPath() ) json.value( nullptr, name );
+	json.endArray();
+	json.beginArray( "tasks" );
+	for ( const StartupTaskTrace& entry : graph.getTrace() ) {
+		json.beginObject();
+		json.value( "name", entry.name );
+		json.value( "main_thread", entry.thread == StartupThread::Main );
+		json.value( "thread_index", static_cast< uint64_t >( entry.threadIndex ) );
+		json.value( "ready_ms", entry.readyMs );
+		json.value( "begin_ms", entry.beginMs );
+		json.value( "end_ms", entry.endMs );
+		json.endObject();
+	}
+	json.endArray();
+	json.value( "all_succeeded", allSucceeded );
+	json.value( "dependency_order", ordered );
+	json.value( "failure_contained", failureContained );
+	json.value( "cycle_rejected", cycleRejected );
+	json.endObject();
+
+	if ( !ok ) std::cerr << "Err: The startup graph ran tasks out of order or mishandled a failure." << std::endl;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+// Telemetry benchmark.
+//
+// Measures what the frame telemetry costs the game thread: a frame with the
+// same scopes and counters Application records, timed over many empty frames
+// and compared with a 60 Hz frame budget, and the worst frame in which a
+// capture was queued. Checks that steady frames do not allocate, that the
+// histogram percentiles of a long-tailed set of frame times are within 1% of
+// the exact ones, and that hitches are captured: a run of short frames with
+// three spikes, two of them close together, must write two captures, each
+// holding the recent history, the hitch and the frames after it, while a
+// slow startup before beginFrame() must not count as one. Reports the
+// results as JSON.
+//
+// Usage: arcantha_telemetry_bench [--frames N] [--samples N] [--dir PATH]
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Log.h"
+#include "Telemetry.h"
+#include "bench_common.h"
+
+static const double FRAME_BUDGET_MS = 1000.0 / 60.0;
+
+static void spin( double ms ) {
+	BenchTimer timer;
+	while ( timer.elapsedMs() < ms ) {}
+}
+
+/**
+ * @brief Reads a capture and checks its rows.
+ * @param path The capture file.
+ * @param hitchFrame The frame that should have triggered it.
+ * @param settings The settings it was recorded with.
+ * @param rows Receives the number of frames in it.
+ * @return True if it holds the hitch, at least framesAfterHitch frames after it and nothing older than the history.
+ */
+static bool checkCapture( const std::string& path, uint64_t hitchFrame, const TelemetrySettings& settings, int& rows ) {
+	std::ifstream file( path );
+	std::string line;
+	rows = 0;
+	if ( !std::getline( file, line ) || line[ 0 ] != '#' || !std::getline( file, line ) || line.compare( 0, 19, "frame,seconds,hitch" ) ) return false;
+
+	std::vector<uint64_t> indices;
+	std::vector<double> seconds;
+	double hitchSeconds = -1.0;
+	while ( std::getline( file, line ) ) {
+		std::istringstream row( line );
+		std::string frame, time, hitch;
+		std::getline( row, frame, ',' );
+		std::getline( row, time, ',' );
+		std::getline( row, hitch, ',' );
+		indices.push_back( std::strtoull( frame.c_str(), nullptr, 10 ) );
+		seconds.push_back( std::atof( time.c_str() ) );
+		if ( indices.back() == hitchFrame && hitch == "1" ) hitchSeconds = seconds.back();
+	}
+	rows = static_cast< int >( indices.size() );
+	if ( hitchSeconds < 0.0 || indices.back() < hitchFrame + settings.framesAfterHitch ) return false;
+	for ( size_t i = 1; i < indices.size(); i++ ) {
+		if ( indices[ i ] != indices[ i - 1 ] + 1 ) return false;
+	}
+	return seconds.front() >= hitchSeconds - settings.historySeconds - 1e-3;
+}
+
+int main( int argc, char** argv ) {
+	int frameCount = 200000;
+	int samples = 200000;
+	std::string directory = ( std::filesystem::temp_directory_path() / "arcantha_telemetry_bench" ).string();
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--frames" ) ) frameCount = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--samples" ) ) samples = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--dir" ) ) directory = argv[ i + 1 ];
+	}
+	if ( frameCount < 1000 ) frameCount = 1000;
+	if ( samples < 1000 ) samples = 1000;
+
+	LogSettings logSettings;
+	logSettings.console = false;
+	logSettings.crashHandlers = false;
+	Logger::getInstance().init( logSettings );
+
+	Telemetry& telemetry = Telemetry::getInstance();
+	const uint32_t input = telemetry.registerSubsystem( "input", TelemetryPhase::Simulation );
+	const uint32_t simulation = telemetry.registerSubsystem( "simulation", TelemetryPhase::Simulation );
+	const uint32_t audio = telemetry.registerSubsystem( "audio", TelemetryPhase::Simulation );
+	const uint32_t render = telemetry.registerSubsystem( "render", TelemetryPhase::Render );
+	const uint32_t events = telemetry.registerCounter( "events" );
+	const uint32_t voices = telemetry.registerCounter( "voices" );
+
+	// Recording cost: empty frames with Application's scopes and counters. No hitch can be captured.
+	TelemetrySettings quiet;
+	quiet.hitchMs = 1e9;
+	quiet.captureDirectory = directory;
+	telemetry.init( quiet );
+	const AllocationStats allocationsBefore = getAllocationStats();
+	BenchTimer recordTimer;
+	for ( int frame = 0; frame < frameCount; frame++ ) {
+		{ TelemetryScope scope( input ); }
+		{ TelemetryScope scope( simulation ); }
+		{ TelemetryScope scope( audio ); }
+		{ TelemetryScope scope( render ); }
+		telemetry.setCounter( events, static_cast< uint64_t >( frame ) );
+		telemetry.setCounter( voices, 12 );
+		telemetry.endFrame();
+	}
+	const double recordNs = recordTimer.elapsedMs() * 1e6 / frameCount;
+	const AllocationStats allocationsAfter = getAllocationStats();
+	const double allocationsPerFrame = static_cast< double >( allocationsAfter.count - allocationsBefore.count ) / frameCount;
+	const double overheadPercent = recordNs * 1e-6 / FRAME_BUDGET_MS * 100.0;
+
+	// Histogram accuracy: log-normal frame times around 8 ms with a long tail.
+	std::mt19937 rng( 42 );
+	std::lognormal_distribution<double> distribution( std::log( 8.0 ), 0.6 );
+	std::vector<double> times( static_cast< size_t >( samples ) );
+	FrameHistogram histogram;
+	for ( double& time : times ) {
+		time = distribution( rng ) + 0.1;
+		histogram.record( time );
+	}
+	const Percentiles exact = computePercentiles( times );
+	const double errors[] = {
+		std::fabs( histogram.percentile( 0.50 ) - exact.p50 ) / exact.p50,
+		std::fabs( histogram.percentile( 0.95 ) - exact.p95 ) / exact.p95,
+		std::fabs( histogram.percentile( 0.99 ) - exact.p99 ) / exact.p99 };
+	double worstError = 0.0;
+	for ( double error : errors ) worstError = std::max( worstError, error );
+
+	// Hitch captures: 2 ms frames, spikes at 100 and 103 (one capture) and at 200 (another). A busy machine
+	// may add a hitch of its own, so only the spikes are checked exactly.
+	std::error_code error;
+	std::filesystem::remove_all( directory, error );
+	TelemetrySettings capturing;
+	capturing.hitchMs = 20.0;
+	capturing.historySeconds = 0.1;
+	capturing.framesAfterHitch = 10;
+	capturing.captureCooldownSeconds = 0.0;
+	capturing.captureDirectory = directory;
+	telemetry.init( capturing );
+	std::this_thread::sleep_for( std::chrono::milliseconds( 30 ) ); // Startup, as Application's, before the main loop.
+	telemetry.beginFrame();
+	double worstCaptureFrameMs = 0.0;
+	for ( int frame = 0; frame < 260; frame++ ) {
+		{
+			TelemetryScope scope( simulation );
+			if ( frame == 100 || frame == 103 || frame == 200 ) std::this_thread::sleep_for( std::chrono::milliseconds( 30 ) );
+			else spin( 2.0 );
+		}
+		BenchTimer endTimer;
+		telemetry.endFrame();
+		if ( frame == 100 + static_cast< int >( capturing.framesAfterHitch ) || frame == 200 + static_cast< int >( capturing.framesAfterHitch ) ) {
+			worstCaptureFrameMs = std::max( worstCaptureFrameMs, endTimer.elapsedMs() );
+		}
+	}
+	const TelemetrySummary summary = telemetry.getSummary( TelemetryPhase::Frame );
+	telemetry.shutdown();
+	const TelemetryStats stats = telemetry.getStats();
+
+	int firstRows = 0, secondRows = 0;
+	const bool firstCaptured = checkCapture( directory + "/hitch_100.csv", 100, capturing, firstRows );
+	const bool secondCaptured = checkCapture( directory + "/hitch_200.csv", 200, capturing, secondRows );
+	const bool coalesced = !std::filesystem::exists( directory + "/hitch_103.csv" );
+	const bool startupIgnored = !std::filesystem::exists( directory + "/hitch_0.csv" );
+	std::filesystem::remove_all( directory, error );
+	Logger::getInstance().shutdown();
+
+	const bool ok = overheadPercent < 1.0 && allocationsPerFrame == 0.0 && worstError <= 0.01 &&
+		stats.hitches >= 3 && stats.captures >= 2 && stats.coalesced >= 1 && stats.failed == 0 &&
+		firstCaptured && secondCaptured && coalesced && startupIgnored;
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_telemetry_bench" ) );
+	json.value( "frames", static_cast< uint64_t >( frameCount ) );
+	json.value( "record_ns_per_frame", recordNs );
+	json.value( "overhead_percent_of_60hz", overheadPercent );
+	json.value( "allocations_per_frame", allocationsPerFrame );
+	json.value( "capture_frame_ms", worstCaptureFrameMs );
+	json.beginObject( "histogram" );
+	json.value( "samples", static_cast< uint64_t >( samples ) );
+	json.value( "exact_p50_ms", exact.p50 );
+	json.value( "exact_p95_ms", exact.p95 );
+	json.value( "exact_p99_ms", exact.p99 );
+	json.value( "p50_ms", histogram.percentile( 0.50 ) );
+	json.value( "p95_ms", histogram.percentile( 0.95 ) );
+	json.value( "p99_ms", histogram.percentile( 0.99 ) );
+	json.value( "worst_relative_error", worstError );
+	json.endObject();
+	json.beginObject( "captures" );
+	json.value( "frame_p50_ms", summary.p50Ms );
+	json.value( "frame_p99_ms", summary.p99Ms );
+	json.value( "frame_max_ms", summary.maxMs );
+	json.value( "hitches", stats.hitches );
+	json.value( "written", stats.captures );
+	json.value( "coalesced", stats.coalesced );
+	json.value( "failed", stats.failed );
+	json.value( "first_rows", static_cast< uint64_t >( firstRows ) );
+	json.value( "second_rows", static_cast< uint64_t >( secondRows ) );
+	json.endObject();
+	json.value( "overhead_under_1_percent", overheadPercent < 1.0 );
+	json.value( "no_steady_allocations", allocationsPerFrame == 0.0 );
+	json.value( "percentiles_within_1_percent", worstError <= 0.01 );
+	json.value( "hitches_captured", firstCaptured && secondCaptured && coalesced );
+	json.value( "startup_not_a_hitch", startupIgnored );
+	json.endObject();
+
+	if ( !ok ) std::cerr << "Err: Telemetry was too slow, inaccurate or missed a hitch capture." << std::endl;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,205 @@
+// Text rendering benchmark.
+//
+// Keeps 5,000 floating damage numbers alive, as a large fight would: every
+// frame some expire and new ones spawn with random values (some of them
+// crits with a suffix), and every live number is drawn rising and centered
+// at its own size. The same run is repeated with the shaping cache on and
+// off. Reports the CPU cost per frame of queuing the text, quads and
+// shaping cache hit rate, glyphs rasterized, atlas rows in use and the draw
+// calls a frame would issue. Both runs must queue identical vertices, and
+// overflowing the atlas must neither clear it under queued quads nor hang
+// on a string that does not fit at all. Runs headless, so render() only discards the batch. Reports JSON.
+//
+// Usage: arcantha_text_bench [--numbers N] [--frames N] [--font PATH]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Random.h"
+#include "TextRenderer.h"
+#include "bench_common.h"
+
+static const int LIFETIME = 60; // Frames a number stays on screen.
+
+/**
+ * @brief One floating damage number.
+ */
+struct DamageNumber
+{
+	std::string text;
+	glm::vec2 position;
+	float size;
+	uint32_t color;
+	int age;
+};
+
+static DamageNumber spawn( Random& random ) {
+	DamageNumber number;
+	const bool crit = random.range( 0, 9 ) == 0;
+	number.text = std::to_string( random.range( 1, crit ? 9999 : 999 ) );
+	if ( crit ) number.text += "!";
+	number.position = glm::vec2( random.range( 0.0f, 1920.0f ), random.range( 0.0f, 1080.0f ) );
+	number.size = crit ? 40.0f : random.range( 18.0f, 26.0f );
+	number.color = crit ? 0xFF2090FFu : 0xFFFFFFFFu;
+	number.age = random.range( 0, LIFETIME - 1 );
+	return number;
+}
+
+struct RunResult
+{
+	std::vector<double> frameMs;
+	double quads = 0.0, hitRate = 0.0;
+	uint32_t drawCalls = 0;
+	TextStats stats;
+	uint64_t hash = 0;
+};
+
+static RunResult run( const std::string& fontPath, int count, int frames, bool cache ) {
+	TextRenderer text;
+	if ( !text.loadFont( fontPath ) ) std::exit( 1 );
+	text.setShapeCacheEnabled( cache );
+	const glm::mat4 projection = glm::ortho( 0.0f, 1920.0f, 0.0f, 1080.0f );
+
+	Random random( 17 );
+	std::vector<DamageNumber> numbers;
+	for ( int i = 0; i < count; i++ ) numbers.push_back( spawn( random ) );
+	text.drawText( "HP 100/100  Souls: 0  Runes: 0", glm::vec2( 20.0f, 1040.0f ), 24.0f, 0xFFFFFFFFu ); // Warm the glyph cache.
+	text.render( projection );
+
+	RunResult result;
+	double hits = 0.0, lookups = 0.0;
+	for ( int frame = 0; frame < frames; frame++ ) {
+		for ( DamageNumber& number : numbers ) {
+			if ( ++number.age >= LIFETIME ) {
+				number = spawn( random );
+				number.age = 0;
+			}
+		}
+
+		BenchTimer timer;
+		for ( const DamageNumber& number : numbers ) {
+			const float t = static_cast< float >( number.age ) / LIFETIME;
+			const uint32_t alpha = static_cast< uint32_t >( 255.0f * ( 1.0f - t * t ) );
+			text.drawText( number.text, number.position + glm::vec2( 0.0f, 60.0f * t ), number.size, ( number.color & 0x00FFFFFFu ) | ( alpha << 24 ),
+				TextAlign::Center );
+		}
+		const double ms = timer.elapsedMs();
+
+		if ( frame == frames - 1 ) {
+			uint64_t hash = 1469598103934665603ull;
+			const std::vector<TextVertex>& vertices = text.getVertices();
+			const uint8_t* bytes = reinterpret_cast< const uint8_t* >( vertices.data() );
+			for ( size_t i = 0; i < vertices.size() * sizeof( TextVertex ); i++ ) hash = ( hash ^ bytes[ i ] ) * 1099511628211ull;
+			result.hash = hash;
+		}
+		// Headless, render() discards the batch; with a context this is where the one draw call goes.
+		result.drawCalls = text.getVertices().empty() ? 0 : 1;
+		timer.reset();
+		text.render( projection );
+		result.frameMs.push_back( ms + timer.elapsedMs() );
+
+		const TextStats& stats = text.getStats();
+		result.quads += stats.quads;
+		hits += stats.shapeHits;
+		lookups += stats.shapeHits + stats.shapeMisses;
+	}
+	result.quads /= frames;
+	result.hitRate = lookups > 0.0 ? hits / lookups : 0.0;
+	result.stats = text.getStats();
+	return result;
+}
+
+/**
+ * @brief Appends a codepoint as UTF-8.
+ */
+static void appendUtf8( std::string& text, uint32_t codepoint ) {
+	if ( codepoint < 0x80 ) text += static_cast< char >( codepoint );
+	else if ( codepoint < 0x800 ) {
+		text += static_cast< char >( 0xC0 | ( codepoint >> 6 ) );
+		text += static_cast< char >( 0x80 | ( codepoint & 0x3F ) );
+	}
+	else {
+		text += static_cast< char >( 0xE0 | ( codepoint >> 12 ) );
+		text += static_cast< char >( 0x80 | ( ( codepoint >> 6 ) & 0x3F ) );
+		text += static_cast< char >( 0x80 | ( codepoint & 0x3F ) );
+	}
+}
+
+/**
+ * @brief Overflows the atlas while quads are queued, with a string too large for an empty atlas.
+ * @return True if the atlas was only cleared after render() and the string was drawn in part.
+ */
+static bool checkAtlasOverflow( const std::string& fontPath ) {
+	TextRenderer text;
+	if ( !text.loadFont( fontPath ) ) std::exit( 1 );
+	const glm::mat4 projection = glm::ortho( 0.0f, 1920.0f, 0.0f, 1080.0f );
+
+	// Every distinct codepoint takes its own atlas cell, missing ones included.
+	std::string huge;
+	for ( uint32_t codepoint = 0x100; codepoint < 0x100 + 4000; codepoint++ ) appendUtf8( huge, codepoint );
+
+	text.drawText( "Queued first", glm::vec2( 20.0f, 1040.0f ), 24.0f, 0xFFFFFFFFu );
+	const std::vector<uint8_t> before = text.getAtlas();
+	text.drawText( huge, glm::vec2( 20.0f, 500.0f ), 24.0f, 0xFFFFFFFFu );
+	bool ok = text.getStats().atlasResets == 0;
+	for ( size_t i = 0; ok && i < before.size(); i++ ) ok = !before[ i ] || text.getAtlas()[ i ] == before[ i ];
+	text.render( projection );
+	ok = ok && text.getStats().atlasResets == 1;
+
+	// Now nothing is queued, so the string gets one reset and draws what fits in the empty atlas.
+	text.drawText( huge, glm::vec2( 20.0f, 500.0f ), 24.0f, 0xFFFFFFFFu );
+	ok = ok && !text.getVertices().empty();
+	text.render( projection );
+	return ok;
+}
+
+static void writeRun( JsonWriter& json, const char* key, const RunResult& result ) {
+	json.beginObject( key );
+	json.value( "frame_ms", computePercentiles( result.frameMs ) );
+	json.value( "quads_per_frame", result.quads );
+	json.value( "shape_hit_rate", result.hitRate );
+	json.value( "glyphs_rasterized", result.stats.glyphsRasterized );
+	json.value( "atlas_resets", result.stats.atlasResets );
+	json.value( "atlas_rows_used", static_cast< uint64_t >( result.stats.atlasShelfTop ) );
+	json.value( "draw_calls", static_cast< uint64_t >( result.drawCalls ) );
+	json.endObject();
+}
+
+int main( int argc, char** argv ) {
+	int count = 5000;
+	int frames = 600;
+	std::string font = ARCANTHA_BENCH_FONT;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( !std::strcmp( argv[ i ], "--numbers" ) ) count = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--frames" ) ) frames = std::atoi( argv[ i + 1 ] );
+		else if ( !std::strcmp( argv[ i ], "--font" ) ) font = argv[ i + 1 ];
+	}
+	if ( count <= 0 ) count = 1;
+	if ( frames <= 0 ) frames = 1;
+
+	const RunResult cached = run( font, count, frames, true );
+	const RunResult uncached = run( font, count, frames, false );
+	const bool identical = cached.hash == uncached.hash;
+	if ( !identical ) std::cerr << "Err: The shaping cache changed the queued vertices." << std::endl;
+	const bool overflow = checkAtlasOverflow( font );
+	if ( !overflow ) std::cerr << "Err: Overflowing the atlas cleared it under queued quads." << std::endl;
+
+	JsonWriter json( std::cout );
+	json.beginObject();
+	json.value( "benchmark", std::string( "arcantha_text_bench" ) );
+	json.value( "numbers", static_cast< uint64_t >( count ) );
+	json.value( "frames", static_cast< uint64_t >( frames ) );
+	writeRun( json, "shape_cache", cached );
+	writeRun( json, "no_shape_cache", uncached );
+	json.value( "identical", identical );
+	json.value( "atlas_overflow_deferred", overflow );
+	json.endObject();
+
+	return identical && overflow ? 0 : 1;
+}